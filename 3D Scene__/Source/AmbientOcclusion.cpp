@@ -0,0 +1,334 @@
+///////////////////////////////////////////////////////////////////////////////
+// ambientocclusion.cpp
+// ============
+// darken the ambient lighting where the scene depth hides the surroundings
+///////////////////////////////////////////////////////////////////////////////
+
+#include "AmbientOcclusion.h"
+
+#include <iostream>
+#include <string>
+
+// declare the global variables
+namespace
+{
+	// hemisphere samples per pixel and blur radius in half
+	// resolution texels of each quality level
+	const int QUALITY_SAMPLES[AmbientOcclusion::QUALITY_COUNT] = { 0, 8, 16, 32 };
+	const int QUALITY_BLUR_RADIUS[AmbientOcclusion::QUALITY_COUNT] = { 0, 2, 3, 4 };
+	// samples in the kernel uploaded to the shader - the lower
+	// levels use its first samples, which cover the hemisphere
+	// evenly on their own
+	const int MAX_KERNEL_SAMPLES = 32;
+	// world space radius of the sampled hemisphere
+	const float OCCLUSION_RADIUS = 0.5f;
+	// names of the quality levels
+	const char* const QUALITY_NAMES[AmbientOcclusion::QUALITY_COUNT] = { "off", "low", "medium", "high" };
+}
+
+/***********************************************************
+ *  AmbientOcclusion()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+AmbientOcclusion::AmbientOcclusion()
+{
+	m_pOcclusionShaderManager = NULL;
+	m_pBlurShaderManager = NULL;
+	m_pUpsampleShaderManager = NULL;
+	m_emptyVertexArray = 0;
+	m_depthFramebuffer = 0;
+	m_depthTexture = 0;
+	for (int i = 0; i < 2; i++)
+	{
+		m_halfFramebuffers[i] = 0;
+		m_halfTextures[i] = 0;
+	}
+	m_occlusionFramebuffer = 0;
+	m_occlusionTexture = 0;
+	m_width = 0;
+	m_height = 0;
+	m_halfWidth = 0;
+	m_halfHeight = 0;
+}
+
+/***********************************************************
+ *  ~AmbientOcclusion()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+AmbientOcclusion::~AmbientOcclusion()
+{
+	DestroyTargets();
+	if (m_emptyVertexArray != 0)
+	{
+		glDeleteVertexArrays(1, &m_emptyVertexArray);
+		m_emptyVertexArray = 0;
+	}
+	ShaderManager** shaderManagers[] = { &m_pOcclusionShaderManager, &m_pBlurShaderManager, &m_pUpsampleShaderManager };
+	for (int i = 0; i < 3; i++)
+	{
+		if (NULL != *shaderManagers[i])
+		{
+			delete *shaderManagers[i];
+			*shaderManagers[i] = NULL;
+		}
+	}
+}
+
+/***********************************************************
+ *  GetQualityName()
+ *
+ *  This method is used for getting the display name of a
+ *  quality level.
+ ***********************************************************/
+const char* AmbientOcclusion::GetQualityName(int quality)
+{
+	if ((quality < 0) || (quality >= QUALITY_COUNT))
+	{
+		return("unknown");
+	}
+	return(QUALITY_NAMES[quality]);
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for loading the shaders of the three
+ *  passes and uploading the hemisphere kernel.  The kernel
+ *  samples come from a fixed sequence so every run shades
+ *  the same, and are pulled towards the centre so the
+ *  nearby geometry contributes most of the occlusion.
+ ***********************************************************/
+void AmbientOcclusion::Initialize()
+{
+	// the passes share the full screen triangle of the deferred
+	// lighting pass
+	m_pOcclusionShaderManager = new ShaderManager();
+	m_pOcclusionShaderManager->LoadShaders(
+		"../shaders/deferredVertexShader.glsl",
+		"../shaders/ssaoFragmentShader.glsl");
+	m_pOcclusionShaderManager->use();
+	m_pOcclusionShaderManager->setIntValue("sceneDepth", DEPTH_TEXTURE_UNIT);
+	m_pOcclusionShaderManager->setIntValue("sceneNormal", NORMAL_TEXTURE_UNIT);
+	m_pOcclusionShaderManager->setFloatValue("radius", OCCLUSION_RADIUS);
+
+	unsigned int state = 0x9E3779B9u;
+	for (int i = 0; i < MAX_KERNEL_SAMPLES; i++)
+	{
+		float random[3];
+		for (int j = 0; j < 3; j++)
+		{
+			state = state * 1664525u + 1013904223u;
+			random[j] = (float)(state >> 8) / 16777216.0f;
+		}
+		glm::vec3 sample = glm::normalize(glm::vec3(random[0] * 2.0f - 1.0f, random[1] * 2.0f - 1.0f, random[2] + 0.05f));
+		float scale = (float)(i % 8 + 1) / 8.0f;
+		sample *= glm::mix(0.1f, 1.0f, scale * scale) * glm::mix(0.5f, 1.0f, random[2]);
+		m_pOcclusionShaderManager->setVec3Value("kernel[" + std::to_string(i) + "]", sample);
+	}
+
+	m_pBlurShaderManager = new ShaderManager();
+	m_pBlurShaderManager->LoadShaders(
+		"../shaders/deferredVertexShader.glsl",
+		"../shaders/ssaoBlurFragmentShader.glsl");
+	m_pBlurShaderManager->use();
+	m_pBlurShaderManager->setIntValue("halfOcclusion", OCCLUSION_TEXTURE_UNIT);
+
+	m_pUpsampleShaderManager = new ShaderManager();
+	m_pUpsampleShaderManager->LoadShaders(
+		"../shaders/deferredVertexShader.glsl",
+		"../shaders/ssaoUpsampleFragmentShader.glsl");
+	m_pUpsampleShaderManager->use();
+	m_pUpsampleShaderManager->setIntValue("halfOcclusion", OCCLUSION_TEXTURE_UNIT);
+	m_pUpsampleShaderManager->setIntValue("sceneDepth", DEPTH_TEXTURE_UNIT);
+
+	// core profile draws need a vertex array even without attributes
+	glGenVertexArrays(1, &m_emptyVertexArray);
+}
+
+/***********************************************************
+ *  CreateTargets()
+ *
+ *  This method is used for creating the targets for the
+ *  passed in scene size.  The depth copy uses the packed
+ *  format of the scene targets so that it can be blitted
+ *  across, resolving any MSAA samples.  The half resolution
+ *  targets keep the view depth next to the visibility, so
+ *  the blur and upsample do not read the depth again.
+ ***********************************************************/
+void AmbientOcclusion::CreateTargets(int width, int height)
+{
+	m_width = width;
+	m_height = height;
+	m_halfWidth = (width + 1) / 2;
+	m_halfHeight = (height + 1) / 2;
+
+	glGenTextures(1, &m_depthTexture);
+	glBindTexture(GL_TEXTURE_2D, m_depthTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, width, height, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+	glGenFramebuffers(1, &m_depthFramebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_depthFramebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, m_depthTexture, 0);
+	glDrawBuffer(GL_NONE);
+	glReadBuffer(GL_NONE);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "Ambient occlusion depth framebuffer is not complete" << std::endl;
+	}
+
+	for (int i = 0; i < 2; i++)
+	{
+		glGenTextures(1, &m_halfTextures[i]);
+		glBindTexture(GL_TEXTURE_2D, m_halfTextures[i]);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RG16F, m_halfWidth, m_halfHeight, 0, GL_RG, GL_FLOAT, NULL);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+		glGenFramebuffers(1, &m_halfFramebuffers[i]);
+		glBindFramebuffer(GL_FRAMEBUFFER, m_halfFramebuffers[i]);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_halfTextures[i], 0);
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		{
+			std::cout << "Ambient occlusion half resolution framebuffer is not complete" << std::endl;
+		}
+	}
+
+	glGenTextures(1, &m_occlusionTexture);
+	glBindTexture(GL_TEXTURE_2D, m_occlusionTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, width, height, 0, GL_RED, GL_UNSIGNED_BYTE, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+	glGenFramebuffers(1, &m_occlusionFramebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_occlusionFramebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_occlusionTexture, 0);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "Ambient occlusion framebuffer is not complete" << std::endl;
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+/***********************************************************
+ *  DestroyTargets()
+ *
+ *  This method is used for freeing the targets.
+ ***********************************************************/
+void AmbientOcclusion::DestroyTargets()
+{
+	GLuint textures[] = { m_depthTexture, m_halfTextures[0], m_halfTextures[1], m_occlusionTexture };
+	glDeleteTextures(4, textures);
+	GLuint framebuffers[] = { m_depthFramebuffer, m_halfFramebuffers[0], m_halfFramebuffers[1], m_occlusionFramebuffer };
+	glDeleteFramebuffers(4, framebuffers);
+
+	m_depthTexture = 0;
+	m_depthFramebuffer = 0;
+	for (int i = 0; i < 2; i++)
+	{
+		m_halfTextures[i] = 0;
+		m_halfFramebuffers[i] = 0;
+	}
+	m_occlusionTexture = 0;
+	m_occlusionFramebuffer = 0;
+	m_width = 0;
+	m_height = 0;
+	m_halfWidth = 0;
+	m_halfHeight = 0;
+}
+
+/***********************************************************
+ *  Render()
+ *
+ *  This method is used for running the occlusion, the two
+ *  blur passes and the upsample.  Afterwards the visibility
+ *  is bound to its texture unit, and the framebuffer and
+ *  viewport bound before are restored - the caller has to
+ *  activate its own shader again.
+ ***********************************************************/
+void AmbientOcclusion::Render(
+	const glm::mat4& view,
+	const glm::mat4& projection,
+	int quality,
+	GLuint depthTexture,
+	GLuint normalTexture)
+{
+	if ((NULL == m_pOcclusionShaderManager) || (quality <= QUALITY_OFF) || (quality >= QUALITY_COUNT))
+	{
+		return;
+	}
+
+	GLint sceneFramebuffer = 0;
+	GLint viewport[4];
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &sceneFramebuffer);
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	if ((viewport[2] != m_width) || (viewport[3] != m_height))
+	{
+		DestroyTargets();
+		CreateTargets(viewport[2], viewport[3]);
+	}
+
+	// the forward path has no depth texture of its own
+	if (depthTexture == 0)
+	{
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, sceneFramebuffer);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_depthFramebuffer);
+		glBlitFramebuffer(0, 0, m_width, m_height, 0, 0, m_width, m_height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+		depthTexture = m_depthTexture;
+	}
+	glActiveTexture(GL_TEXTURE0 + DEPTH_TEXTURE_UNIT);
+	glBindTexture(GL_TEXTURE_2D, depthTexture);
+	glActiveTexture(GL_TEXTURE0 + NORMAL_TEXTURE_UNIT);
+	glBindTexture(GL_TEXTURE_2D, normalTexture);
+
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_BLEND);
+	glBindVertexArray(m_emptyVertexArray);
+	glm::mat4 inverseProjection = glm::inverse(projection);
+
+	// sample the hemisphere at half resolution
+	glBindFramebuffer(GL_FRAMEBUFFER, m_halfFramebuffers[0]);
+	glViewport(0, 0, m_halfWidth, m_halfHeight);
+	m_pOcclusionShaderManager->use();
+	m_pOcclusionShaderManager->setMat4Value("projection", projection);
+	m_pOcclusionShaderManager->setMat4Value("inverseProjection", inverseProjection);
+	m_pOcclusionShaderManager->setMat4Value("view", view);
+	m_pOcclusionShaderManager->setBoolValue("bUseSceneNormal", normalTexture != 0);
+	m_pOcclusionShaderManager->setIntValue("kernelSize", QUALITY_SAMPLES[quality]);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+
+	// blur horizontally into the second target and vertically back
+	m_pBlurShaderManager->use();
+	m_pBlurShaderManager->setIntValue("blurRadius", QUALITY_BLUR_RADIUS[quality]);
+	for (int pass = 0; pass < 2; pass++)
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, m_halfFramebuffers[1 - pass]);
+		glActiveTexture(GL_TEXTURE0 + OCCLUSION_TEXTURE_UNIT);
+		glBindTexture(GL_TEXTURE_2D, m_halfTextures[pass]);
+		m_pBlurShaderManager->setVec2Value("direction", (pass == 0) ? glm::vec2(1.0f, 0.0f) : glm::vec2(0.0f, 1.0f));
+		glDrawArrays(GL_TRIANGLES, 0, 3);
+	}
+
+	// bring the visibility back to the full resolution
+	glBindFramebuffer(GL_FRAMEBUFFER, m_occlusionFramebuffer);
+	glViewport(0, 0, m_width, m_height);
+	glActiveTexture(GL_TEXTURE0 + OCCLUSION_TEXTURE_UNIT);
+	glBindTexture(GL_TEXTURE_2D, m_halfTextures[0]);
+	m_pUpsampleShaderManager->use();
+	m_pUpsampleShaderManager->setMat4Value("inverseProjection", inverseProjection);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+
+	glBindVertexArray(0);
+	glEnable(GL_BLEND);
+	glEnable(GL_DEPTH_TEST);
+
+	glActiveTexture(GL_TEXTURE0 + OCCLUSION_TEXTURE_UNIT);
+	glBindTexture(GL_TEXTURE_2D, m_occlusionTexture);
+	glBindFramebuffer(GL_FRAMEBUFFER, sceneFramebuffer);
+	glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+}
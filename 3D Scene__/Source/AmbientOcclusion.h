@@ -0,0 +1,102 @@
+///////////////////////////////////////////////////////////////////////////////
+// ambientocclusion.h
+// ============
+// darken the ambient lighting where the scene depth hides the surroundings
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderManager.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+/***********************************************************
+ *  AmbientOcclusion
+ *
+ *  This class computes screen space ambient occlusion from
+ *  the depth of the opaque scene.  The occlusion is sampled
+ *  over a hemisphere around the normal at half resolution,
+ *  with the normals of the G-buffer when there is one and
+ *  rebuilt from the depth otherwise.  It is then blurred
+ *  horizontally and vertically with weights that fall off
+ *  across depth edges, and brought back to full resolution
+ *  by weighting the four nearest half resolution texels by
+ *  how close their depth is to the pixel's.  The result is
+ *  a single channel of ambient visibility per pixel, which
+ *  the lighting shaders multiply their ambient terms with.
+ ***********************************************************/
+class AmbientOcclusion
+{
+public:
+	// constructor
+	AmbientOcclusion();
+	// destructor
+	~AmbientOcclusion();
+
+	// quality levels, trading the samples per pixel and the
+	// blur radius for the cost of the pass
+	enum QUALITY
+	{
+		QUALITY_OFF,
+		QUALITY_LOW,
+		QUALITY_MEDIUM,
+		QUALITY_HIGH,
+		QUALITY_COUNT
+	};
+
+	// texture unit the lighting shaders read the visibility from
+	static const int OCCLUSION_TEXTURE_UNIT = 29;
+	// texture units of the scene depth and normals read by the passes
+	static const int DEPTH_TEXTURE_UNIT = 30;
+	static const int NORMAL_TEXTURE_UNIT = 31;
+
+	// get the display name of a quality level
+	static const char* GetQualityName(int quality);
+
+	// load the shaders and create the sample kernel - needs a
+	// current GL context
+	void Initialize();
+
+	// compute the visibility for the current viewport of the bound
+	// framebuffer, rendered with the passed in camera.  Without a
+	// depth texture the depth of the bound framebuffer is copied,
+	// and without a normal texture the normals come from the depth
+	void Render(
+		const glm::mat4& view,
+		const glm::mat4& projection,
+		int quality,
+		GLuint depthTexture,
+		GLuint normalTexture);
+
+	// get the full resolution visibility of the last render
+	GLuint GetOcclusionTexture() const { return m_occlusionTexture; }
+
+private:
+	// create the depth copy, half and full resolution targets
+	void CreateTargets(int width, int height);
+	// free the targets
+	void DestroyTargets();
+
+	// shaders of the occlusion, blur and upsample passes
+	ShaderManager* m_pOcclusionShaderManager;
+	ShaderManager* m_pBlurShaderManager;
+	ShaderManager* m_pUpsampleShaderManager;
+	// empty vertex array bound for the full screen triangle
+	GLuint m_emptyVertexArray;
+	// single sampled copy of the scene depth, for the forward path
+	GLuint m_depthFramebuffer;
+	GLuint m_depthTexture;
+	// half resolution visibility and view depth, ping-ponged by
+	// the two blur directions
+	GLuint m_halfFramebuffers[2];
+	GLuint m_halfTextures[2];
+	// full resolution visibility read by the lighting
+	GLuint m_occlusionFramebuffer;
+	GLuint m_occlusionTexture;
+	// size of the full and half resolution targets
+	int m_width;
+	int m_height;
+	int m_halfWidth;
+	int m_halfHeight;
+};
@@ -0,0 +1,298 @@
+///////////////////////////////////////////////////////////////////////////////
+// animationsystem.cpp
+// ============
+// evaluate keyframed object transforms in bulk
+///////////////////////////////////////////////////////////////////////////////
+
+#include "AnimationSystem.h"
+
+#include <cmath>
+#include <future>
+#include <thread>
+
+// declare the global variables
+namespace
+{
+	// smallest number of tracks worth handing to another thread
+	const int PARALLEL_MIN_TRACKS = 4096;
+
+	/***********************************************************
+	 *  MultiplyQuaternions()
+	 *
+	 *  This function is used to get the quaternion rotating by
+	 *  b first and then by a.
+	 ***********************************************************/
+	glm::vec4 MultiplyQuaternions(glm::vec4 a, glm::vec4 b)
+	{
+		return glm::vec4(
+			a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+			a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+			a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+			a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z);
+	}
+}
+
+/***********************************************************
+ *  AnimationSystem()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+AnimationSystem::AnimationSystem()
+{
+}
+
+/***********************************************************
+ *  EulerToQuaternion()
+ *
+ *  This method is used for converting rotations in degrees
+ *  about the x, y and z axes, applied in that order, into a
+ *  unit quaternion.
+ ***********************************************************/
+glm::vec4 AnimationSystem::EulerToQuaternion(glm::vec3 degrees)
+{
+	glm::vec3 halfAngles = glm::radians(degrees) * 0.5f;
+	glm::vec4 rotationX = glm::vec4(std::sin(halfAngles.x), 0.0f, 0.0f, std::cos(halfAngles.x));
+	glm::vec4 rotationY = glm::vec4(0.0f, std::sin(halfAngles.y), 0.0f, std::cos(halfAngles.y));
+	glm::vec4 rotationZ = glm::vec4(0.0f, 0.0f, std::sin(halfAngles.z), std::cos(halfAngles.z));
+	return MultiplyQuaternions(rotationZ, MultiplyQuaternions(rotationY, rotationX));
+}
+
+/***********************************************************
+ *  MakeKey()
+ *
+ *  This method is used for making a keyframe from a
+ *  position, rotations in degrees and a scale.
+ ***********************************************************/
+AnimationSystem::ANIMATION_KEY AnimationSystem::MakeKey(float time, glm::vec3 position, glm::vec3 degrees, glm::vec3 scale)
+{
+	ANIMATION_KEY key;
+	key.time = time;
+	key.position = position;
+	key.rotation = EulerToQuaternion(degrees);
+	key.scale = scale;
+	return(key);
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for removing all of the tracks.
+ ***********************************************************/
+void AnimationSystem::Clear()
+{
+	m_targets.clear();
+	m_pivotX.clear();
+	m_pivotY.clear();
+	m_pivotZ.clear();
+	m_firstKeys.clear();
+	m_keyCounts.clear();
+	m_durations.clear();
+	m_bLoops.clear();
+	m_baseModelMatrices.clear();
+	m_baseNormalMatrices.clear();
+	m_cursors.clear();
+
+	m_keyTimes.clear();
+	m_positionX.clear();
+	m_positionY.clear();
+	m_positionZ.clear();
+	m_rotationX.clear();
+	m_rotationY.clear();
+	m_rotationZ.clear();
+	m_rotationW.clear();
+	m_scaleX.clear();
+	m_scaleY.clear();
+	m_scaleZ.clear();
+
+	m_segmentKeys.clear();
+	m_blendFactors.clear();
+	m_modelMatrices.clear();
+	m_normalMatrices.clear();
+}
+
+/***********************************************************
+ *  AddTrack()
+ *
+ *  This method is used for adding a track that moves a
+ *  target object about a pivot.  The keys are appended to
+ *  the shared key arrays, so the keys of each track stay
+ *  next to each other.  Returns the index of the track, or
+ *  -1 when there are no keys.
+ ***********************************************************/
+int AnimationSystem::AddTrack(
+	int target,
+	const glm::mat4& baseModelMatrix,
+	const glm::mat3& baseNormalMatrix,
+	glm::vec3 pivot,
+	const std::vector<ANIMATION_KEY>& keys,
+	bool bLoop)
+{
+	if (keys.empty())
+	{
+		return(-1);
+	}
+
+	m_targets.push_back(target);
+	m_pivotX.push_back(pivot.x);
+	m_pivotY.push_back(pivot.y);
+	m_pivotZ.push_back(pivot.z);
+	m_firstKeys.push_back((int)m_keyTimes.size());
+	m_keyCounts.push_back((int)keys.size());
+	m_durations.push_back(keys.back().time);
+	m_bLoops.push_back(bLoop ? 1 : 0);
+	m_baseModelMatrices.push_back(baseModelMatrix);
+	m_baseNormalMatrices.push_back(baseNormalMatrix);
+	m_cursors.push_back((int)m_keyTimes.size());
+
+	for (int i = 0; i < (int)keys.size(); i++)
+	{
+		// neighboring keys on the shorter arc blend without a flip
+		glm::vec4 rotation = keys[i].rotation;
+		if ((i > 0) && (glm::dot(rotation, keys[i - 1].rotation) < 0.0f))
+		{
+			rotation = -rotation;
+		}
+
+		m_keyTimes.push_back(keys[i].time);
+		m_positionX.push_back(keys[i].position.x);
+		m_positionY.push_back(keys[i].position.y);
+		m_positionZ.push_back(keys[i].position.z);
+		m_rotationX.push_back(rotation.x);
+		m_rotationY.push_back(rotation.y);
+		m_rotationZ.push_back(rotation.z);
+		m_rotationW.push_back(rotation.w);
+		m_scaleX.push_back(keys[i].scale.x);
+		m_scaleY.push_back(keys[i].scale.y);
+		m_scaleZ.push_back(keys[i].scale.z);
+	}
+
+	m_segmentKeys.push_back(0);
+	m_blendFactors.push_back(0.0f);
+	m_modelMatrices.push_back(baseModelMatrix);
+	m_normalMatrices.push_back(baseNormalMatrix);
+
+	return((int)m_targets.size() - 1);
+}
+
+/***********************************************************
+ *  Evaluate()
+ *
+ *  This method is used for evaluating all the tracks at the
+ *  passed in time.  Large track sets are split into one
+ *  contiguous range per hardware thread.
+ ***********************************************************/
+void AnimationSystem::Evaluate(float time, bool bParallel)
+{
+	int trackCount = GetTrackCount();
+	int threads = bParallel ? (int)std::thread::hardware_concurrency() : 1;
+	threads = glm::clamp(glm::min(threads, trackCount / PARALLEL_MIN_TRACKS), 1, 64);
+
+	if (threads == 1)
+	{
+		EvaluateRange(time, 0, trackCount);
+		return;
+	}
+
+	std::vector<std::future<void>> tasks;
+	int rangeSize = (trackCount + threads - 1) / threads;
+	for (int first = rangeSize; first < trackCount; first += rangeSize)
+	{
+		int last = glm::min(first + rangeSize, trackCount);
+		tasks.push_back(std::async(std::launch::async,
+			[this, time, first, last]() { EvaluateRange(time, first, last); }));
+	}
+	EvaluateRange(time, 0, glm::min(rangeSize, trackCount));
+	for (int i = 0; i < (int)tasks.size(); i++)
+	{
+		tasks[i].wait();
+	}
+}
+
+/***********************************************************
+ *  EvaluateRange()
+ *
+ *  This method is used for evaluating a range of tracks.
+ *  The keys around the time are searched from where the
+ *  last evaluation stopped, which is a step or two for a
+ *  clock running forward.  The values are then blended
+ *  linearly, with normalized linear blending for the
+ *  rotations, and the pivot, rotation, scale and recorded
+ *  transform are combined into the cached matrices.
+ ***********************************************************/
+void AnimationSystem::EvaluateRange(float time, int first, int last)
+{
+	// find the key before the time and the blend factor
+	for (int track = first; track < last; track++)
+	{
+		int firstKey = m_firstKeys[track];
+		int lastKey = firstKey + m_keyCounts[track] - 1;
+		float duration = m_durations[track];
+
+		float trackTime = glm::clamp(time, 0.0f, duration);
+		if (m_bLoops[track] && (duration > 0.0f))
+		{
+			trackTime = time - std::floor(time / duration) * duration;
+		}
+
+		int key = m_cursors[track];
+		if (m_keyTimes[key] > trackTime)
+		{
+			key = firstKey;
+		}
+		while ((key < lastKey) && (m_keyTimes[key + 1] <= trackTime))
+		{
+			key++;
+		}
+		m_cursors[track] = key;
+
+		int nextKey = glm::min(key + 1, lastKey);
+		float span = m_keyTimes[nextKey] - m_keyTimes[key];
+		m_segmentKeys[track] = key;
+		m_blendFactors[track] = (span > 0.0f) ? glm::clamp((trackTime - m_keyTimes[key]) / span, 0.0f, 1.0f) : 0.0f;
+	}
+
+	// blend the keys and build the matrices
+	for (int track = first; track < last; track++)
+	{
+		int key = m_segmentKeys[track];
+		int lastKey = m_firstKeys[track] + m_keyCounts[track] - 1;
+		int nextKey = (key < lastKey) ? key + 1 : key;
+		float blend = m_blendFactors[track];
+		float keep = 1.0f - blend;
+
+		float positionX = m_positionX[key] * keep + m_positionX[nextKey] * blend;
+		float positionY = m_positionY[key] * keep + m_positionY[nextKey] * blend;
+		float positionZ = m_positionZ[key] * keep + m_positionZ[nextKey] * blend;
+		float scaleX = m_scaleX[key] * keep + m_scaleX[nextKey] * blend;
+		float scaleY = m_scaleY[key] * keep + m_scaleY[nextKey] * blend;
+		float scaleZ = m_scaleZ[key] * keep + m_scaleZ[nextKey] * blend;
+		float x = m_rotationX[key] * keep + m_rotationX[nextKey] * blend;
+		float y = m_rotationY[key] * keep + m_rotationY[nextKey] * blend;
+		float z = m_rotationZ[key] * keep + m_rotationZ[nextKey] * blend;
+		float w = m_rotationW[key] * keep + m_rotationW[nextKey] * blend;
+		float inverseLength = 1.0f / std::sqrt(x * x + y * y + z * z + w * w);
+		x *= inverseLength;
+		y *= inverseLength;
+		z *= inverseLength;
+		w *= inverseLength;
+
+		// columns of the rotation matrix of the quaternion
+		glm::vec3 rotationColumn0 = glm::vec3(1.0f - 2.0f * (y * y + z * z), 2.0f * (x * y + z * w), 2.0f * (x * z - y * w));
+		glm::vec3 rotationColumn1 = glm::vec3(2.0f * (x * y - z * w), 1.0f - 2.0f * (x * x + z * z), 2.0f * (y * z + x * w));
+		glm::vec3 rotationColumn2 = glm::vec3(2.0f * (x * z + y * w), 2.0f * (y * z - x * w), 1.0f - 2.0f * (x * x + y * y));
+
+		// rotate and scale about the pivot, then move by the position
+		glm::mat3 rotationScale = glm::mat3(rotationColumn0 * scaleX, rotationColumn1 * scaleY, rotationColumn2 * scaleZ);
+		glm::vec3 pivot = glm::vec3(m_pivotX[track], m_pivotY[track], m_pivotZ[track]);
+		glm::vec3 translation = pivot + glm::vec3(positionX, positionY, positionZ) - rotationScale * pivot;
+
+		glm::mat4 local = glm::mat4(rotationScale);
+		local[3] = glm::vec4(translation, 1.0f);
+		m_modelMatrices[track] = local * m_baseModelMatrices[track];
+
+		// the inverse transpose of a rotation and scale divides
+		// the rotation columns by the scale instead
+		glm::mat3 normalRotationScale = glm::mat3(rotationColumn0 / scaleX, rotationColumn1 / scaleY, rotationColumn2 / scaleZ);
+		m_normalMatrices[track] = normalRotationScale * m_baseNormalMatrices[track];
+	}
+}
@@ -0,0 +1,109 @@
+///////////////////////////////////////////////////////////////////////////////
+// animationsystem.h
+// ============
+// evaluate keyframed object transforms in bulk
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  AnimationSystem
+ *
+ *  This class holds keyframe tracks of position, rotation
+ *  and scale, each moving one target object about a pivot
+ *  on top of its recorded transform.  Tracks and keys are
+ *  kept in structure of arrays form, one array per scalar,
+ *  and all tracks are evaluated together: a short scalar
+ *  pass finds the keys around the current time, then flat
+ *  loops without branches interpolate the values and build
+ *  the matrices, which the compiler can vectorize.  Large
+ *  track sets are split over several threads.  The results
+ *  land in the transform cache, one model and normal matrix
+ *  per track.
+ ***********************************************************/
+class AnimationSystem
+{
+public:
+	// constructor
+	AnimationSystem();
+
+	// one keyframe of a track - the rotation is a unit quaternion
+	// stored as x, y, z, w
+	struct ANIMATION_KEY
+	{
+		float time;
+		glm::vec3 position;
+		glm::vec4 rotation;
+		glm::vec3 scale;
+	};
+
+	// convert rotations in degrees about x, then y, then z into
+	// a quaternion, in the order SetTransformations applies them
+	static glm::vec4 EulerToQuaternion(glm::vec3 degrees);
+	// make a key from a position, rotation in degrees and scale
+	static ANIMATION_KEY MakeKey(float time, glm::vec3 position, glm::vec3 degrees, glm::vec3 scale = glm::vec3(1.0f));
+
+	// remove all of the tracks
+	void Clear();
+	// add a track moving a target about a pivot, on top of its
+	// recorded transforms - the keys must be sorted by time, and
+	// looping tracks repeat after their last key
+	int AddTrack(
+		int target,
+		const glm::mat4& baseModelMatrix,
+		const glm::mat3& baseNormalMatrix,
+		glm::vec3 pivot,
+		const std::vector<ANIMATION_KEY>& keys,
+		bool bLoop = true);
+
+	// evaluate all the tracks at the passed in time into the
+	// transform cache, optionally on several threads
+	void Evaluate(float time, bool bParallel = true);
+
+	// get the number of tracks
+	int GetTrackCount() const { return (int)m_targets.size(); }
+	// get the target object of a track
+	int GetTarget(int track) const { return m_targets[track]; }
+	// get the evaluated matrices of a track
+	const glm::mat4& GetModelMatrix(int track) const { return m_modelMatrices[track]; }
+	const glm::mat3& GetNormalMatrix(int track) const { return m_normalMatrices[track]; }
+	// get the recorded matrices a track moves its target from
+	const glm::mat4& GetBaseModelMatrix(int track) const { return m_baseModelMatrices[track]; }
+	const glm::mat3& GetBaseNormalMatrix(int track) const { return m_baseNormalMatrices[track]; }
+
+private:
+	// evaluate the tracks from first up to, not including, last
+	void EvaluateRange(float time, int first, int last);
+
+	// per track - target, pivot, keys and recorded transforms
+	std::vector<int> m_targets;
+	std::vector<float> m_pivotX, m_pivotY, m_pivotZ;
+	std::vector<int> m_firstKeys;
+	std::vector<int> m_keyCounts;
+	std::vector<float> m_durations;
+	std::vector<unsigned char> m_bLoops;
+	std::vector<glm::mat4> m_baseModelMatrices;
+	std::vector<glm::mat3> m_baseNormalMatrices;
+	// per track - key found by the last evaluation, where the
+	// search starts the next time
+	std::vector<int> m_cursors;
+
+	// per key - time, position, rotation quaternion and scale
+	std::vector<float> m_keyTimes;
+	std::vector<float> m_positionX, m_positionY, m_positionZ;
+	std::vector<float> m_rotationX, m_rotationY, m_rotationZ, m_rotationW;
+	std::vector<float> m_scaleX, m_scaleY, m_scaleZ;
+
+	// per track - scratch space of the evaluation: the key before
+	// the evaluated time and the blend factor towards the next one
+	std::vector<int> m_segmentKeys;
+	std::vector<float> m_blendFactors;
+
+	// transform cache written by the evaluation
+	std::vector<glm::mat4> m_modelMatrices;
+	std::vector<glm::mat3> m_normalMatrices;
+};
@@ -0,0 +1,704 @@
+///////////////////////////////////////////////////////////////////////////////
+// boundingvolumehierarchy.cpp
+// ============
+// spatial hierarchy over the world bounds of the scene objects
+///////////////////////////////////////////////////////////////////////////////
+
+#include "BoundingVolumeHierarchy.h"
+
+#include <algorithm>
+#include <future>
+#include <thread>
+
+// declare the global variables
+namespace
+{
+	// number of centroid bins evaluated per axis by the SAH
+	const int SAH_BIN_COUNT = 16;
+	// largest number of objects kept in one leaf
+	const int MAX_LEAF_SIZE = 4;
+	// smallest range worth handing to another thread
+	const int PARALLEL_MIN_OBJECTS = 4096;
+	// depth below which ranges are halved instead of SAH split,
+	// which keeps degenerate inputs from growing deep trees
+	const int MAX_SAH_DEPTH = 48;
+	// deepest traversal stack - enough for the depth limit above
+	// plus the halving of a billion objects
+	const int MAX_STACK_DEPTH = 128;
+
+	/***********************************************************
+	 *  SurfaceArea()
+	 *
+	 *  This function is used to get the surface area of a box,
+	 *  which is proportional to the chance a ray hits it.
+	 ***********************************************************/
+	float SurfaceArea(glm::vec3 boundsMin, glm::vec3 boundsMax)
+	{
+		glm::vec3 extent = glm::max(boundsMax - boundsMin, glm::vec3(0.0f));
+		return(2.0f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x));
+	}
+
+	/***********************************************************
+	 *  IntersectRay()
+	 *
+	 *  This function is used to intersect a ray with a box by
+	 *  clipping it against the three slabs.  Returns the entry
+	 *  distance, or a negative value on a miss.
+	 ***********************************************************/
+	float IntersectRay(glm::vec3 origin, glm::vec3 inverseDirection, glm::vec3 boundsMin, glm::vec3 boundsMax, float maxDistance)
+	{
+		glm::vec3 t0 = (boundsMin - origin) * inverseDirection;
+		glm::vec3 t1 = (boundsMax - origin) * inverseDirection;
+		glm::vec3 tNear = glm::min(t0, t1);
+		glm::vec3 tFar = glm::max(t0, t1);
+		float entry = glm::max(glm::max(tNear.x, tNear.y), glm::max(tNear.z, 0.0f));
+		float exit = glm::min(glm::min(tFar.x, tFar.y), glm::min(tFar.z, maxDistance));
+		return((entry <= exit) ? entry : -1.0f);
+	}
+
+	// result of testing a box against the frustum planes
+	enum FRUSTUM_TEST
+	{
+		FRUSTUM_OUTSIDE,
+		FRUSTUM_INTERSECTING,
+		FRUSTUM_INSIDE
+	};
+
+	/***********************************************************
+	 *  TestFrustum()
+	 *
+	 *  This function is used to test a box against the six
+	 *  frustum planes, using the box corner furthest along and
+	 *  furthest against each plane normal.
+	 ***********************************************************/
+	FRUSTUM_TEST TestFrustum(const glm::vec4* planes, glm::vec3 boundsMin, glm::vec3 boundsMax)
+	{
+		FRUSTUM_TEST result = FRUSTUM_INSIDE;
+		for (int i = 0; i < 6; i++)
+		{
+			glm::vec3 normal = glm::vec3(planes[i]);
+			glm::vec3 positive = glm::vec3(
+				(normal.x >= 0.0f) ? boundsMax.x : boundsMin.x,
+				(normal.y >= 0.0f) ? boundsMax.y : boundsMin.y,
+				(normal.z >= 0.0f) ? boundsMax.z : boundsMin.z);
+			if (glm::dot(normal, positive) + planes[i].w < 0.0f)
+			{
+				return(FRUSTUM_OUTSIDE);
+			}
+			glm::vec3 negative = boundsMin + boundsMax - positive;
+			if (glm::dot(normal, negative) + planes[i].w < 0.0f)
+			{
+				result = FRUSTUM_INTERSECTING;
+			}
+		}
+		return(result);
+	}
+}
+
+/***********************************************************
+ *  BoundingVolumeHierarchy()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+BoundingVolumeHierarchy::BoundingVolumeHierarchy()
+{
+	m_parallelDepth = 0;
+}
+
+/***********************************************************
+ *  Build()
+ *
+ *  This method is used for building the tree over the
+ *  passed in object bounds.  With parallel building enabled
+ *  the two halves of the upper splits are built on separate
+ *  threads, enough levels deep to keep every core busy.
+ ***********************************************************/
+void BoundingVolumeHierarchy::Build(const std::vector<BVH_BOUNDS>& objectBounds, bool bParallel)
+{
+	int objectCount = (int)objectBounds.size();
+
+	// the build partitions copies of the bounds, so every pass
+	// over a range reads memory in order
+	m_buildReferences.resize(objectCount);
+	for (int i = 0; i < objectCount; i++)
+	{
+		m_buildReferences[i].bounds = objectBounds[i];
+		m_buildReferences[i].centroid = (objectBounds[i].boundsMin + objectBounds[i].boundsMax) * 0.5f;
+		m_buildReferences[i].object = i;
+	}
+
+	m_parallelDepth = 0;
+	if (bParallel)
+	{
+		int threads = (int)std::thread::hardware_concurrency();
+		while ((1 << m_parallelDepth) < threads)
+		{
+			m_parallelDepth++;
+		}
+	}
+
+	m_nodes.clear();
+	if (objectCount > 0)
+	{
+		// a binary tree with small leaves has at most 2n - 1 nodes
+		m_nodes.reserve(2 * objectCount);
+		m_nodes.push_back(BVH_NODE());
+		BuildNode(m_nodes, 0, 0, objectCount, 0);
+	}
+
+	// keep the objects and their bounds in leaf order
+	m_objectIndices.resize(objectCount);
+	m_leafBounds.resize(objectCount);
+	for (int i = 0; i < objectCount; i++)
+	{
+		m_objectIndices[i] = m_buildReferences[i].object;
+		m_leafBounds[i] = m_buildReferences[i].bounds;
+	}
+	m_buildReferences.clear();
+	m_buildReferences.shrink_to_fit();
+}
+
+/***********************************************************
+ *  BuildSubtree()
+ *
+ *  This method is used for building the subtree over a range
+ *  of the objects into an empty node array.
+ ***********************************************************/
+void BoundingVolumeHierarchy::BuildSubtree(std::vector<BVH_NODE>& nodes, int first, int count, int depth)
+{
+	nodes.reserve(2 * count);
+	nodes.push_back(BVH_NODE());
+	BuildNode(nodes, 0, first, count, depth);
+}
+
+/***********************************************************
+ *  AppendSubtree()
+ *
+ *  This method is used for copying a subtree that was built
+ *  into its own node array.  Its root goes into the reserved
+ *  slot and the remaining nodes are appended, with their
+ *  child indices moved to the new positions.
+ ***********************************************************/
+void BoundingVolumeHierarchy::AppendSubtree(std::vector<BVH_NODE>& nodes, int slot, const std::vector<BVH_NODE>& subtree)
+{
+	// subtree node k > 0 is stored at base + k - 1
+	int base = (int)nodes.size() - 1;
+	for (int k = 0; k < (int)subtree.size(); k++)
+	{
+		BVH_NODE node = subtree[k];
+		if (node.count == 0)
+		{
+			node.first += base;
+		}
+		if (k == 0)
+		{
+			nodes[slot] = node;
+		}
+		else
+		{
+			nodes.push_back(node);
+		}
+	}
+}
+
+/***********************************************************
+ *  BuildNode()
+ *
+ *  This method is used for building the subtree of a node
+ *  over a range of the objects.  The range is turned into a
+ *  leaf when it is small enough and splitting does not pay
+ *  off, otherwise its objects are partitioned in place and
+ *  both halves are built recursively.
+ ***********************************************************/
+void BoundingVolumeHierarchy::BuildNode(std::vector<BVH_NODE>& nodes, int nodeIndex, int first, int count, int depth)
+{
+	glm::vec3 boundsMin = glm::vec3(1.0e30f);
+	glm::vec3 boundsMax = glm::vec3(-1.0e30f);
+	glm::vec3 centroidMin = glm::vec3(1.0e30f);
+	glm::vec3 centroidMax = glm::vec3(-1.0e30f);
+	for (int i = first; i < first + count; i++)
+	{
+		const BUILD_REFERENCE& reference = m_buildReferences[i];
+		boundsMin = glm::min(boundsMin, reference.bounds.boundsMin);
+		boundsMax = glm::max(boundsMax, reference.bounds.boundsMax);
+		centroidMin = glm::min(centroidMin, reference.centroid);
+		centroidMax = glm::max(centroidMax, reference.centroid);
+	}
+
+	nodes[nodeIndex].boundsMin = boundsMin;
+	nodes[nodeIndex].boundsMax = boundsMax;
+	nodes[nodeIndex].first = first;
+	nodes[nodeIndex].count = count;
+
+	if (count <= 2)
+	{
+		return;
+	}
+
+	// a leaf costs one test per object
+	float leafCost = count * SurfaceArea(boundsMin, boundsMax);
+	int split = -1;
+	if (depth < MAX_SAH_DEPTH)
+	{
+		split = PartitionObjects(first, count, centroidMin, centroidMax, leafCost);
+	}
+	if (split < 0)
+	{
+		if (count <= MAX_LEAF_SIZE)
+		{
+			return;
+		}
+		// no split beats a leaf, but the leaf would be too big -
+		// halve the range in its current order instead
+		split = first + count / 2;
+	}
+
+	int leftCount = split - first;
+	int rightCount = count - leftCount;
+
+	if ((depth < m_parallelDepth) && (count >= PARALLEL_MIN_OBJECTS))
+	{
+		// build the halves into their own arrays on two threads
+		std::vector<BVH_NODE> leftNodes;
+		std::vector<BVH_NODE> rightNodes;
+		std::future<void> rightTask = std::async(std::launch::async,
+			[this, &rightNodes, split, rightCount, depth]() { BuildSubtree(rightNodes, split, rightCount, depth + 1); });
+		BuildSubtree(leftNodes, first, leftCount, depth + 1);
+		rightTask.wait();
+
+		int childIndex = (int)nodes.size();
+		nodes.resize(nodes.size() + 2);
+		nodes[nodeIndex].first = childIndex;
+		nodes[nodeIndex].count = 0;
+		AppendSubtree(nodes, childIndex, leftNodes);
+		AppendSubtree(nodes, childIndex + 1, rightNodes);
+		return;
+	}
+
+	int childIndex = (int)nodes.size();
+	nodes.resize(nodes.size() + 2);
+	nodes[nodeIndex].first = childIndex;
+	nodes[nodeIndex].count = 0;
+	BuildNode(nodes, childIndex, first, leftCount, depth + 1);
+	BuildNode(nodes, childIndex + 1, split, rightCount, depth + 1);
+}
+
+/***********************************************************
+ *  PartitionObjects()
+ *
+ *  This method is used for finding the cheapest split of a
+ *  range of objects.  The centroids are sorted into bins
+ *  along each axis, and every bin boundary is scored by the
+ *  surface area heuristic.  When the best split beats the
+ *  passed in leaf cost, the objects are partitioned and the
+ *  index of the first object of the right half is returned,
+ *  otherwise -1.
+ ***********************************************************/
+int BoundingVolumeHierarchy::PartitionObjects(int first, int count, glm::vec3 centroidMin, glm::vec3 centroidMax, float leafCost)
+{
+	struct SAH_BIN
+	{
+		glm::vec3 boundsMin;
+		glm::vec3 boundsMax;
+		int count;
+	};
+
+	// small ranges do not need the full resolution
+	int binCount = glm::min(SAH_BIN_COUNT, count);
+
+	glm::vec3 extent = centroidMax - centroidMin;
+	glm::vec3 scale = glm::vec3(0.0f);
+	for (int axis = 0; axis < 3; axis++)
+	{
+		scale[axis] = (extent[axis] > 0.0f) ? binCount / extent[axis] : 0.0f;
+	}
+
+	// bin the objects along all three axes in one pass
+	SAH_BIN bins[3][SAH_BIN_COUNT];
+	for (int axis = 0; axis < 3; axis++)
+	{
+		for (int b = 0; b < binCount; b++)
+		{
+			bins[axis][b].boundsMin = glm::vec3(1.0e30f);
+			bins[axis][b].boundsMax = glm::vec3(-1.0e30f);
+			bins[axis][b].count = 0;
+		}
+	}
+	for (int i = first; i < first + count; i++)
+	{
+		const BUILD_REFERENCE& reference = m_buildReferences[i];
+		const BVH_BOUNDS& bounds = reference.bounds;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			int b = glm::min(binCount - 1, (int)((reference.centroid[axis] - centroidMin[axis]) * scale[axis]));
+			SAH_BIN& bin = bins[axis][b];
+			bin.boundsMin = glm::min(bin.boundsMin, bounds.boundsMin);
+			bin.boundsMax = glm::max(bin.boundsMax, bounds.boundsMax);
+			bin.count++;
+		}
+	}
+
+	float bestCost = leafCost;
+	int bestAxis = -1;
+	int bestBin = 0;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		if (extent[axis] <= 0.0f)
+		{
+			continue;
+		}
+
+		// sweep from the right to get the cost of every right half
+		float rightArea[SAH_BIN_COUNT];
+		int rightCount[SAH_BIN_COUNT];
+		glm::vec3 sweepMin = glm::vec3(1.0e30f);
+		glm::vec3 sweepMax = glm::vec3(-1.0e30f);
+		int sweepCount = 0;
+		for (int b = binCount - 1; b > 0; b--)
+		{
+			sweepMin = glm::min(sweepMin, bins[axis][b].boundsMin);
+			sweepMax = glm::max(sweepMax, bins[axis][b].boundsMax);
+			sweepCount += bins[axis][b].count;
+			rightArea[b] = SurfaceArea(sweepMin, sweepMax);
+			rightCount[b] = sweepCount;
+		}
+
+		// then from the left, splitting in front of bin b
+		sweepMin = glm::vec3(1.0e30f);
+		sweepMax = glm::vec3(-1.0e30f);
+		sweepCount = 0;
+		for (int b = 1; b < binCount; b++)
+		{
+			sweepMin = glm::min(sweepMin, bins[axis][b - 1].boundsMin);
+			sweepMax = glm::max(sweepMax, bins[axis][b - 1].boundsMax);
+			sweepCount += bins[axis][b - 1].count;
+			if ((sweepCount == 0) || (rightCount[b] == 0))
+			{
+				continue;
+			}
+			float cost = sweepCount * SurfaceArea(sweepMin, sweepMax) + rightCount[b] * rightArea[b];
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestAxis = axis;
+				bestBin = b;
+			}
+		}
+	}
+
+	if (bestAxis < 0)
+	{
+		return(-1);
+	}
+
+	float axisMin = centroidMin[bestAxis];
+	float axisScale = scale[bestAxis];
+	auto middle = std::partition(m_buildReferences.begin() + first, m_buildReferences.begin() + first + count,
+		[binCount, bestAxis, bestBin, axisMin, axisScale](const BUILD_REFERENCE& reference) {
+			return glm::min(binCount - 1, (int)((reference.centroid[bestAxis] - axisMin) * axisScale)) < bestBin;
+		});
+	return((int)(middle - m_buildReferences.begin()));
+}
+
+/***********************************************************
+ *  Assign()
+ *
+ *  This method is used for replacing the tree with a stored
+ *  one instead of building it.  Every child has to follow
+ *  its parent and every leaf has to reference objects that
+ *  exist, or the tree is left unchanged.
+ ***********************************************************/
+bool BoundingVolumeHierarchy::Assign(const BVH_NODE* pNodes, int nodeCount, const int* pObjectIndices, const BVH_BOUNDS* pLeafBounds, int objectCount)
+{
+	for (int i = 0; i < nodeCount; i++)
+	{
+		const BVH_NODE& node = pNodes[i];
+		bool bValid = (node.count > 0) ?
+			((node.first >= 0) && (node.first <= objectCount - node.count)) :
+			((node.count == 0) && (node.first > i) && (node.first < nodeCount - 1));
+		if (!bValid)
+		{
+			return(false);
+		}
+	}
+	for (int i = 0; i < objectCount; i++)
+	{
+		if ((pObjectIndices[i] < 0) || (pObjectIndices[i] >= objectCount))
+		{
+			return(false);
+		}
+	}
+
+	m_nodes.assign(pNodes, pNodes + nodeCount);
+	m_objectIndices.assign(pObjectIndices, pObjectIndices + objectCount);
+	m_leafBounds.assign(pLeafBounds, pLeafBounds + objectCount);
+	return(true);
+}
+
+/***********************************************************
+ *  Refit()
+ *
+ *  This method is used for updating the node bounds after
+ *  objects moved, keeping the tree structure.  Children are
+ *  always stored after their parent, so walking the nodes
+ *  backwards visits every child before its parent.  The tree
+ *  quality drops as objects move far, so rebuild from time
+ *  to time.
+ ***********************************************************/
+void BoundingVolumeHierarchy::Refit(const std::vector<BVH_BOUNDS>& objectBounds)
+{
+	if (objectBounds.size() != m_objectIndices.size())
+	{
+		Build(objectBounds);
+		return;
+	}
+
+	for (int i = 0; i < (int)m_objectIndices.size(); i++)
+	{
+		m_leafBounds[i] = objectBounds[m_objectIndices[i]];
+	}
+	for (int i = (int)m_nodes.size() - 1; i >= 0; i--)
+	{
+		BVH_NODE& node = m_nodes[i];
+		if (node.count > 0)
+		{
+			node.boundsMin = glm::vec3(1.0e30f);
+			node.boundsMax = glm::vec3(-1.0e30f);
+			for (int j = node.first; j < node.first + node.count; j++)
+			{
+				const BVH_BOUNDS& bounds = m_leafBounds[j];
+				node.boundsMin = glm::min(node.boundsMin, bounds.boundsMin);
+				node.boundsMax = glm::max(node.boundsMax, bounds.boundsMax);
+			}
+		}
+		else
+		{
+			node.boundsMin = glm::min(m_nodes[node.first].boundsMin, m_nodes[node.first + 1].boundsMin);
+			node.boundsMax = glm::max(m_nodes[node.first].boundsMax, m_nodes[node.first + 1].boundsMax);
+		}
+	}
+}
+
+/***********************************************************
+ *  CollectSubtree()
+ *
+ *  This method is used for adding every object below a node
+ *  to the results without any further tests.
+ ***********************************************************/
+void BoundingVolumeHierarchy::CollectSubtree(int nodeIndex, std::vector<int>& objects) const
+{
+	int stack[MAX_STACK_DEPTH];
+	int stackSize = 0;
+	stack[stackSize++] = nodeIndex;
+	while (stackSize > 0)
+	{
+		const BVH_NODE& node = m_nodes[stack[--stackSize]];
+		if (node.count > 0)
+		{
+			objects.insert(objects.end(), m_objectIndices.begin() + node.first, m_objectIndices.begin() + node.first + node.count);
+		}
+		else
+		{
+			stack[stackSize++] = node.first;
+			stack[stackSize++] = node.first + 1;
+		}
+	}
+}
+
+/***********************************************************
+ *  QueryFrustum()
+ *
+ *  This method is used for collecting the objects whose
+ *  bounds intersect the frustum of the passed in view
+ *  projection matrix.  Subtrees entirely inside the frustum
+ *  are collected without testing their nodes.
+ ***********************************************************/
+void BoundingVolumeHierarchy::QueryFrustum(const glm::mat4& viewProjection, std::vector<int>& objects) const
+{
+	objects.clear();
+	if (m_nodes.empty())
+	{
+		return;
+	}
+
+	// the planes are sums and differences of the matrix rows
+	glm::vec4 rows[4];
+	for (int i = 0; i < 4; i++)
+	{
+		rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+	}
+	glm::vec4 planes[6] = {
+		rows[3] + rows[0], rows[3] - rows[0],
+		rows[3] + rows[1], rows[3] - rows[1],
+		rows[3] + rows[2], rows[3] - rows[2] };
+
+	int stack[MAX_STACK_DEPTH];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+	while (stackSize > 0)
+	{
+		int nodeIndex = stack[--stackSize];
+		const BVH_NODE& node = m_nodes[nodeIndex];
+
+		FRUSTUM_TEST test = TestFrustum(planes, node.boundsMin, node.boundsMax);
+		if (test == FRUSTUM_OUTSIDE)
+		{
+			continue;
+		}
+		if (test == FRUSTUM_INSIDE)
+		{
+			CollectSubtree(nodeIndex, objects);
+			continue;
+		}
+
+		if (node.count > 0)
+		{
+			for (int i = node.first; i < node.first + node.count; i++)
+			{
+				const BVH_BOUNDS& bounds = m_leafBounds[i];
+				if (TestFrustum(planes, bounds.boundsMin, bounds.boundsMax) != FRUSTUM_OUTSIDE)
+				{
+					objects.push_back(m_objectIndices[i]);
+				}
+			}
+		}
+		else
+		{
+			stack[stackSize++] = node.first;
+			stack[stackSize++] = node.first + 1;
+		}
+	}
+}
+
+/***********************************************************
+ *  QueryRay()
+ *
+ *  This method is used for finding the object whose bounds
+ *  the ray enters first.  The nearer child is visited first
+ *  and subtrees behind the closest hit so far are skipped.
+ *  Returns the object index and its entry distance, or -1
+ *  when nothing is hit.
+ ***********************************************************/
+int BoundingVolumeHierarchy::QueryRay(glm::vec3 origin, glm::vec3 direction, float& distance) const
+{
+	int hitObject = -1;
+	distance = 1.0e30f;
+	if (m_nodes.empty())
+	{
+		return(hitObject);
+	}
+
+	// a zero direction component becomes an infinite slab distance
+	glm::vec3 inverseDirection = 1.0f / direction;
+
+	// nodes waiting to be visited, with their entry distance
+	struct RAY_ENTRY
+	{
+		int node;
+		float t;
+	};
+	RAY_ENTRY stack[MAX_STACK_DEPTH];
+	int stackSize = 0;
+	float tRoot = IntersectRay(origin, inverseDirection, m_nodes[0].boundsMin, m_nodes[0].boundsMax, distance);
+	if (tRoot >= 0.0f)
+	{
+		stack[stackSize++] = { 0, tRoot };
+	}
+
+	while (stackSize > 0)
+	{
+		RAY_ENTRY entry = stack[--stackSize];
+		// a closer hit was found since the node was pushed
+		if (entry.t > distance)
+		{
+			continue;
+		}
+		const BVH_NODE& node = m_nodes[entry.node];
+
+		if (node.count > 0)
+		{
+			for (int i = node.first; i < node.first + node.count; i++)
+			{
+				const BVH_BOUNDS& bounds = m_leafBounds[i];
+				float t = IntersectRay(origin, inverseDirection, bounds.boundsMin, bounds.boundsMax, distance);
+				if ((t >= 0.0f) && (t < distance))
+				{
+					distance = t;
+					hitObject = m_objectIndices[i];
+				}
+			}
+			continue;
+		}
+
+		int nearChild = node.first;
+		int farChild = node.first + 1;
+		float tNear = IntersectRay(origin, inverseDirection, m_nodes[nearChild].boundsMin, m_nodes[nearChild].boundsMax, distance);
+		float tFar = IntersectRay(origin, inverseDirection, m_nodes[farChild].boundsMin, m_nodes[farChild].boundsMax, distance);
+		if ((tFar >= 0.0f) && ((tNear < 0.0f) || (tFar < tNear)))
+		{
+			std::swap(nearChild, farChild);
+			std::swap(tNear, tFar);
+		}
+		// push the far child first so the near one is popped first
+		if (tFar >= 0.0f)
+		{
+			stack[stackSize++] = { farChild, tFar };
+		}
+		if (tNear >= 0.0f)
+		{
+			stack[stackSize++] = { nearChild, tNear };
+		}
+	}
+
+	return(hitObject);
+}
+
+/***********************************************************
+ *  QuerySegment()
+ *
+ *  This method is used for collecting the objects whose
+ *  bounds the passed in ray passes through before the
+ *  passed in distance, in no particular order.  The caller
+ *  tests the surfaces of the collected objects, so a shadow
+ *  ray can stop at the first one that blocks it.
+ ***********************************************************/
+void BoundingVolumeHierarchy::QuerySegment(glm::vec3 origin, glm::vec3 direction, float maxDistance, std::vector<int>& objects) const
+{
+	objects.clear();
+	if (m_nodes.empty())
+	{
+		return;
+	}
+
+	// a zero direction component becomes an infinite slab distance
+	glm::vec3 inverseDirection = 1.0f / direction;
+
+	int stack[MAX_STACK_DEPTH];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+	while (stackSize > 0)
+	{
+		const BVH_NODE& node = m_nodes[stack[--stackSize]];
+		if (IntersectRay(origin, inverseDirection, node.boundsMin, node.boundsMax, maxDistance) < 0.0f)
+		{
+			continue;
+		}
+
+		if (node.count > 0)
+		{
+			for (int i = node.first; i < node.first + node.count; i++)
+			{
+				const BVH_BOUNDS& bounds = m_leafBounds[i];
+				if (IntersectRay(origin, inverseDirection, bounds.boundsMin, bounds.boundsMax, maxDistance) >= 0.0f)
+				{
+					objects.push_back(m_objectIndices[i]);
+				}
+			}
+		}
+		else
+		{
+			stack[stackSize++] = node.first;
+			stack[stackSize++] = node.first + 1;
+		}
+	}
+}
@@ -0,0 +1,109 @@
+///////////////////////////////////////////////////////////////////////////////
+// boundingvolumehierarchy.h
+// ============
+// spatial hierarchy over the world bounds of the scene objects
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  BoundingVolumeHierarchy
+ *
+ *  This class builds a binary tree of axis aligned boxes
+ *  over the world bounds of a set of objects.  Splits are
+ *  chosen with the binned surface area heuristic, and the
+ *  upper levels of large trees are built on several threads.
+ *  When objects move, the node bounds can be refit in place
+ *  without rebuilding the tree.  The tree answers frustum
+ *  queries for culling, nearest-hit ray queries for picking
+ *  and segment queries for shadow rays, returning the
+ *  indices of the objects passed in.
+ ***********************************************************/
+class BoundingVolumeHierarchy
+{
+public:
+	// constructor
+	BoundingVolumeHierarchy();
+
+	// world space bounds of one object
+	struct BVH_BOUNDS
+	{
+		glm::vec3 boundsMin;
+		glm::vec3 boundsMax;
+	};
+
+	// one node of the tree - leaves reference count objects
+	// starting at first, inner nodes have a count of zero and
+	// their two children at first and first + 1
+	struct BVH_NODE
+	{
+		glm::vec3 boundsMin;
+		int first;
+		glm::vec3 boundsMax;
+		int count;
+	};
+
+	// build the tree over the passed in object bounds
+	void Build(const std::vector<BVH_BOUNDS>& objectBounds, bool bParallel = true);
+	// update the node bounds for moved objects - the number of
+	// objects must match the last build
+	void Refit(const std::vector<BVH_BOUNDS>& objectBounds);
+
+	// collect the objects whose bounds intersect the frustum
+	void QueryFrustum(const glm::mat4& viewProjection, std::vector<int>& objects) const;
+	// find the nearest object whose bounds the ray hits, or -1
+	int QueryRay(glm::vec3 origin, glm::vec3 direction, float& distance) const;
+	// collect every object whose bounds the ray passes through
+	// before the passed in distance along it
+	void QuerySegment(glm::vec3 origin, glm::vec3 direction, float maxDistance, std::vector<int>& objects) const;
+
+	// get the number of nodes of the tree
+	int GetNodeCount() const { return (int)m_nodes.size(); }
+	// get the number of objects the tree was built over
+	int GetObjectCount() const { return (int)m_objectIndices.size(); }
+
+	// get the nodes, the object indices in leaf order and their
+	// bounds, for storing a built tree
+	const std::vector<BVH_NODE>& GetNodes() const { return m_nodes; }
+	const std::vector<int>& GetObjectIndices() const { return m_objectIndices; }
+	const std::vector<BVH_BOUNDS>& GetLeafBounds() const { return m_leafBounds; }
+	// replace the tree with one stored from GetNodes(),
+	// GetObjectIndices() and GetLeafBounds() - fails when the
+	// nodes reference objects outside of the passed in ones
+	bool Assign(const BVH_NODE* pNodes, int nodeCount, const int* pObjectIndices, const BVH_BOUNDS* pLeafBounds, int objectCount);
+
+private:
+	// build the subtree of a node over a range of the objects
+	void BuildNode(std::vector<BVH_NODE>& nodes, int nodeIndex, int first, int count, int depth);
+	// build a subtree into its own node array, rooted at index 0
+	void BuildSubtree(std::vector<BVH_NODE>& nodes, int first, int count, int depth);
+	// copy a separately built subtree into a node array
+	static void AppendSubtree(std::vector<BVH_NODE>& nodes, int slot, const std::vector<BVH_NODE>& subtree);
+	// find the split position of a range with the binned SAH
+	int PartitionObjects(int first, int count, glm::vec3 centroidMin, glm::vec3 centroidMax, float leafCost);
+	// collect every object below a node
+	void CollectSubtree(int nodeIndex, std::vector<int>& objects) const;
+
+	// object bounds partitioned during the build
+	struct BUILD_REFERENCE
+	{
+		BVH_BOUNDS bounds;
+		glm::vec3 centroid;
+		int object;
+	};
+
+	// nodes of the tree, parents before their children
+	std::vector<BVH_NODE> m_nodes;
+	// object indices, grouped by the leaves referencing them
+	std::vector<int> m_objectIndices;
+	// object bounds in the same order as the object indices
+	std::vector<BVH_BOUNDS> m_leafBounds;
+	// objects being sorted into the tree by the current build
+	std::vector<BUILD_REFERENCE> m_buildReferences;
+	// depth up to which subtrees are built on separate threads
+	int m_parallelDepth;
+};
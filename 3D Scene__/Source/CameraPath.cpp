@@ -0,0 +1,451 @@
+///////////////////////////////////////////////////////////////////////////////
+// camerapath.cpp
+// ============
+// record, store and replay the camera input of the 3D scene
+///////////////////////////////////////////////////////////////////////////////
+
+#include "CameraPath.h"
+
+// GLFW library
+#include "GLFW/glfw3.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+// declare the global variables
+namespace
+{
+	// first line of the camera path file format
+	const char* g_FileHeader = "CAMERAPATH";
+	const int FILE_VERSION = 1;
+
+	// keys that move the camera or select a view preset
+	struct RECORDED_KEY
+	{
+		int key;
+		const char* name;
+	};
+	const RECORDED_KEY g_RecordedKeys[] = {
+		{ GLFW_KEY_W, "W" }, { GLFW_KEY_S, "S" }, { GLFW_KEY_A, "A" },
+		{ GLFW_KEY_D, "D" }, { GLFW_KEY_Q, "Q" }, { GLFW_KEY_E, "E" },
+		{ GLFW_KEY_P, "P" }, { GLFW_KEY_O, "O" },
+		{ GLFW_KEY_1, "1" }, { GLFW_KEY_2, "2" }, { GLFW_KEY_3, "3" }, { GLFW_KEY_4, "4" } };
+	const int RECORDED_KEY_COUNT = sizeof(g_RecordedKeys) / sizeof(g_RecordedKeys[0]);
+
+	const char* g_BenchmarkPathNames[] = { "flythrough", "closeup_monitor", "top_ortho", "rapid_presets" };
+	const int BENCHMARK_PATH_COUNT = sizeof(g_BenchmarkPathNames) / sizeof(g_BenchmarkPathNames[0]);
+
+	/***********************************************************
+	 *  DefaultPose()
+	 *
+	 *  This function is used to get the camera pose the view
+	 *  manager starts with.
+	 ***********************************************************/
+	CameraPath::CAMERA_POSE DefaultPose()
+	{
+		CameraPath::CAMERA_POSE pose;
+		pose.position = glm::vec3(0.5f, 5.5f, 10.0f);
+		pose.front = glm::vec3(0.0f, -0.5f, -2.0f);
+		pose.up = glm::vec3(0.0f, 1.0f, 0.0f);
+		pose.yaw = -90.0f;
+		pose.pitch = 0.0f;
+		pose.zoom = 80.0f;
+		pose.movementSpeed = 10.0f;
+		pose.bOrthographic = false;
+		return(pose);
+	}
+
+	/***********************************************************
+	 *  HoldKey()
+	 *
+	 *  This function is used to add a key that is held down
+	 *  from the first frame until the last frame.
+	 ***********************************************************/
+	void HoldKey(CameraPath& path, int key, int firstFrame, int lastFrame)
+	{
+		path.AddKeyEvent(firstFrame, key, true);
+		path.AddKeyEvent(lastFrame, key, false);
+	}
+
+	/***********************************************************
+	 *  MoveMouse()
+	 *
+	 *  This function is used to add the same mouse offset on
+	 *  every frame from the first frame until the last frame.
+	 ***********************************************************/
+	void MoveMouse(CameraPath& path, float xOffset, float yOffset, int firstFrame, int lastFrame)
+	{
+		for (int frame = firstFrame; frame < lastFrame; frame++)
+		{
+			path.AddMouseEvent(frame, xOffset, yOffset);
+		}
+	}
+}
+
+/***********************************************************
+ *  CameraPath()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+CameraPath::CameraPath()
+{
+	m_frameCount = 0;
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for removing all of the events.
+ ***********************************************************/
+void CameraPath::Clear()
+{
+	m_events.clear();
+	m_frameCount = 0;
+}
+
+/***********************************************************
+ *  AddEvent()
+ *
+ *  This method is used for inserting an event after all of
+ *  the events of the same or earlier frames.  Recorded input
+ *  arrives in order, so this is normally an append.
+ ***********************************************************/
+void CameraPath::AddEvent(const CAMERA_EVENT& event)
+{
+	auto position = std::upper_bound(m_events.begin(), m_events.end(), event,
+		[](const CAMERA_EVENT& a, const CAMERA_EVENT& b) { return a.frame < b.frame; });
+	m_events.insert(position, event);
+
+	m_frameCount = std::max(m_frameCount, event.frame + 1);
+}
+
+/***********************************************************
+ *  AddKeyEvent()
+ *
+ *  This method is used for adding a key press or release.
+ ***********************************************************/
+void CameraPath::AddKeyEvent(int frame, int key, bool bDown)
+{
+	CAMERA_EVENT event = {};
+	event.frame = frame;
+	event.type = bDown ? EVENT_KEY_DOWN : EVENT_KEY_UP;
+	event.key = key;
+	AddEvent(event);
+}
+
+/***********************************************************
+ *  AddMouseEvent()
+ *
+ *  This method is used for adding a mouse movement, already
+ *  scaled by the mouse sensitivity.
+ ***********************************************************/
+void CameraPath::AddMouseEvent(int frame, float xOffset, float yOffset)
+{
+	CAMERA_EVENT event = {};
+	event.frame = frame;
+	event.type = EVENT_MOUSE_MOVE;
+	event.x = xOffset;
+	event.y = yOffset;
+	AddEvent(event);
+}
+
+/***********************************************************
+ *  AddScrollEvent()
+ *
+ *  This method is used for adding a mouse wheel scroll.
+ ***********************************************************/
+void CameraPath::AddScrollEvent(int frame, float yOffset)
+{
+	CAMERA_EVENT event = {};
+	event.frame = frame;
+	event.type = EVENT_SCROLL;
+	event.y = yOffset;
+	AddEvent(event);
+}
+
+/***********************************************************
+ *  AddPoseEvent()
+ *
+ *  This method is used for adding an absolute camera pose.
+ ***********************************************************/
+void CameraPath::AddPoseEvent(int frame, const CAMERA_POSE& pose)
+{
+	CAMERA_EVENT event = {};
+	event.frame = frame;
+	event.type = EVENT_POSE;
+	event.pose = pose;
+	AddEvent(event);
+}
+
+/***********************************************************
+ *  GetKeyName()
+ *
+ *  This method is used for getting the name a key is saved
+ *  with in the path file.
+ ***********************************************************/
+std::string CameraPath::GetKeyName(int key)
+{
+	for (int i = 0; i < RECORDED_KEY_COUNT; i++)
+	{
+		if (g_RecordedKeys[i].key == key)
+		{
+			return(g_RecordedKeys[i].name);
+		}
+	}
+	return(std::to_string(key));
+}
+
+/***********************************************************
+ *  FindKey()
+ *
+ *  This method is used for getting the key code of a key
+ *  name read from the path file.
+ ***********************************************************/
+int CameraPath::FindKey(const std::string& name)
+{
+	for (int i = 0; i < RECORDED_KEY_COUNT; i++)
+	{
+		if (name.compare(g_RecordedKeys[i].name) == 0)
+		{
+			return(g_RecordedKeys[i].key);
+		}
+	}
+	return(std::stoi(name));
+}
+
+/***********************************************************
+ *  GetRecordedKeyCount()
+ *
+ *  This method is used for getting the number of keys whose
+ *  state is recorded.
+ ***********************************************************/
+int CameraPath::GetRecordedKeyCount()
+{
+	return(RECORDED_KEY_COUNT);
+}
+
+/***********************************************************
+ *  GetRecordedKey()
+ *
+ *  This method is used for getting the GLFW key code of a
+ *  recorded key.
+ ***********************************************************/
+int CameraPath::GetRecordedKey(int index)
+{
+	return(g_RecordedKeys[index].key);
+}
+
+/***********************************************************
+ *  Save()
+ *
+ *  This method is used for writing the path to a text file.
+ *  After the header and frame count there is one event per
+ *  line, starting with its frame number:
+ *
+ *    <frame> down|up <key>
+ *    <frame> mouse <x offset> <y offset>
+ *    <frame> scroll <y offset>
+ *    <frame> pose <position> <front> <up> <yaw> <pitch>
+ *                 <zoom> <movement speed> <orthographic>
+ ***********************************************************/
+bool CameraPath::Save(const std::string& filename) const
+{
+	std::ofstream file(filename);
+	if (!file.is_open())
+	{
+		std::cout << "Could not write camera path:" << filename << std::endl;
+		return(false);
+	}
+
+	file << g_FileHeader << " " << FILE_VERSION << "\n";
+	file << "frames " << m_frameCount << "\n";
+	for (int i = 0; i < (int)m_events.size(); i++)
+	{
+		const CAMERA_EVENT& event = m_events[i];
+		file << event.frame << " ";
+		switch (event.type)
+		{
+		case EVENT_KEY_DOWN:
+			file << "down " << GetKeyName(event.key);
+			break;
+		case EVENT_KEY_UP:
+			file << "up " << GetKeyName(event.key);
+			break;
+		case EVENT_MOUSE_MOVE:
+			file << "mouse " << event.x << " " << event.y;
+			break;
+		case EVENT_SCROLL:
+			file << "scroll " << event.y;
+			break;
+		case EVENT_POSE:
+			file << "pose "
+				<< event.pose.position.x << " " << event.pose.position.y << " " << event.pose.position.z << " "
+				<< event.pose.front.x << " " << event.pose.front.y << " " << event.pose.front.z << " "
+				<< event.pose.up.x << " " << event.pose.up.y << " " << event.pose.up.z << " "
+				<< event.pose.yaw << " " << event.pose.pitch << " " << event.pose.zoom << " "
+				<< event.pose.movementSpeed << " " << (event.pose.bOrthographic ? 1 : 0);
+			break;
+		}
+		file << "\n";
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  Load()
+ *
+ *  This method is used for reading a path written by Save().
+ ***********************************************************/
+bool CameraPath::Load(const std::string& filename)
+{
+	Clear();
+
+	std::ifstream file(filename);
+	std::string header;
+	int version = 0;
+	file >> header >> version;
+	if (!file.is_open() || (header.compare(g_FileHeader) != 0) || (version != FILE_VERSION))
+	{
+		std::cout << "Could not read camera path:" << filename << std::endl;
+		return(false);
+	}
+
+	std::string label;
+	int frameCount = 0;
+	file >> label >> frameCount;
+
+	int frame = 0;
+	std::string type;
+	while (file >> frame >> type)
+	{
+		if ((type.compare("down") == 0) || (type.compare("up") == 0))
+		{
+			std::string key;
+			file >> key;
+			AddKeyEvent(frame, FindKey(key), type.compare("down") == 0);
+		}
+		else if (type.compare("mouse") == 0)
+		{
+			float xOffset = 0.0f;
+			float yOffset = 0.0f;
+			file >> xOffset >> yOffset;
+			AddMouseEvent(frame, xOffset, yOffset);
+		}
+		else if (type.compare("scroll") == 0)
+		{
+			float yOffset = 0.0f;
+			file >> yOffset;
+			AddScrollEvent(frame, yOffset);
+		}
+		else if (type.compare("pose") == 0)
+		{
+			CAMERA_POSE pose;
+			int orthographic = 0;
+			file >> pose.position.x >> pose.position.y >> pose.position.z
+				>> pose.front.x >> pose.front.y >> pose.front.z
+				>> pose.up.x >> pose.up.y >> pose.up.z
+				>> pose.yaw >> pose.pitch >> pose.zoom
+				>> pose.movementSpeed >> orthographic;
+			pose.bOrthographic = (orthographic != 0);
+			AddPoseEvent(frame, pose);
+		}
+		else
+		{
+			std::cout << "Unknown camera path event:" << type << std::endl;
+			return(false);
+		}
+	}
+
+	m_frameCount = frameCount;
+	return(true);
+}
+
+/***********************************************************
+ *  GetBenchmarkPathCount()
+ *
+ *  This method is used for getting the number of canonical
+ *  benchmark paths.
+ ***********************************************************/
+int CameraPath::GetBenchmarkPathCount()
+{
+	return(BENCHMARK_PATH_COUNT);
+}
+
+/***********************************************************
+ *  GetBenchmarkPathName()
+ *
+ *  This method is used for getting the name of a canonical
+ *  benchmark path.
+ ***********************************************************/
+const char* CameraPath::GetBenchmarkPathName(int index)
+{
+	return(g_BenchmarkPathNames[index]);
+}
+
+/***********************************************************
+ *  CreateBenchmarkPath()
+ *
+ *  This method is used for generating a canonical benchmark
+ *  path.  Every path starts from an absolute pose, so its
+ *  frames do not depend on where the camera was before.
+ *
+ *  flythrough      - move around and over the desk while
+ *                    turning the camera, 600 frames
+ *  closeup_monitor - strafe slowly in front of the monitor
+ *                    screen, 300 frames
+ *  top_ortho       - pan the overhead orthographic view,
+ *                    300 frames
+ *  rapid_presets   - switch between all of the view presets
+ *                    every 10 frames, 240 frames
+ ***********************************************************/
+void CameraPath::CreateBenchmarkPath(int index, CameraPath& path)
+{
+	path.Clear();
+
+	CAMERA_POSE pose = DefaultPose();
+
+	switch (index)
+	{
+	case 0:
+		path.AddPoseEvent(0, pose);
+		HoldKey(path, GLFW_KEY_W, 0, 180);
+		MoveMouse(path, 3.0f, 0.0f, 60, 240);
+		HoldKey(path, GLFW_KEY_A, 240, 360);
+		HoldKey(path, GLFW_KEY_Q, 300, 360);
+		HoldKey(path, GLFW_KEY_S, 360, 480);
+		HoldKey(path, GLFW_KEY_E, 420, 480);
+		MoveMouse(path, -3.0f, -0.5f, 480, 600);
+		path.SetFrameCount(600);
+		break;
+	case 1:
+		pose.position = glm::vec3(0.0f, 3.0f, 3.5f);
+		pose.front = glm::vec3(0.0f, 0.0f, -1.0f);
+		pose.movementSpeed = 4.0f;
+		path.AddPoseEvent(0, pose);
+		HoldKey(path, GLFW_KEY_A, 0, 75);
+		HoldKey(path, GLFW_KEY_D, 75, 225);
+		HoldKey(path, GLFW_KEY_A, 225, 300);
+		path.SetFrameCount(300);
+		break;
+	case 2:
+		path.AddPoseEvent(0, pose);
+		HoldKey(path, GLFW_KEY_3, 0, 1);
+		HoldKey(path, GLFW_KEY_D, 30, 150);
+		HoldKey(path, GLFW_KEY_A, 150, 270);
+		path.SetFrameCount(300);
+		break;
+	case 3:
+	{
+		const int PRESET_KEYS[] = { GLFW_KEY_1, GLFW_KEY_2, GLFW_KEY_3, GLFW_KEY_4, GLFW_KEY_P, GLFW_KEY_O };
+		path.AddPoseEvent(0, pose);
+		for (int frame = 0; frame < 240; frame += 10)
+		{
+			HoldKey(path, PRESET_KEYS[(frame / 10) % 6], frame, frame + 1);
+		}
+		path.SetFrameCount(240);
+		break;
+	}
+	}
+}
@@ -0,0 +1,108 @@
+///////////////////////////////////////////////////////////////////////////////
+// camerapath.h
+// ============
+// record, store and replay the camera input of the 3D scene
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  CameraPath
+ *
+ *  This class holds a timeline of camera input events -
+ *  key presses and releases, mouse movement, scrolling and
+ *  absolute camera poses - stamped with the frame they
+ *  happened in.  Paths are recorded from live input, saved
+ *  to and loaded from a text file, or generated for the
+ *  canonical benchmark paths.  Replaying a path with a fixed
+ *  frame time moves the camera the same way on every run.
+ ***********************************************************/
+class CameraPath
+{
+public:
+	// types of recorded camera input
+	enum EVENT_TYPE
+	{
+		EVENT_KEY_DOWN,
+		EVENT_KEY_UP,
+		EVENT_MOUSE_MOVE,
+		EVENT_SCROLL,
+		EVENT_POSE
+	};
+
+	// complete camera state, used to start a path from a known view
+	struct CAMERA_POSE
+	{
+		glm::vec3 position;
+		glm::vec3 front;
+		glm::vec3 up;
+		float yaw;
+		float pitch;
+		float zoom;
+		float movementSpeed;
+		bool bOrthographic;
+	};
+
+	// properties for one recorded input event
+	struct CAMERA_EVENT
+	{
+		int frame;
+		EVENT_TYPE type;
+		// GLFW key code for key events
+		int key;
+		// mouse offsets, or the scroll distance in y
+		float x;
+		float y;
+		// camera state for pose events
+		CAMERA_POSE pose;
+	};
+
+	// constructor
+	CameraPath();
+
+	// remove all events
+	void Clear();
+	// add an event - events are kept in frame order, and events
+	// of the same frame in the order they were added
+	void AddKeyEvent(int frame, int key, bool bDown);
+	void AddMouseEvent(int frame, float xOffset, float yOffset);
+	void AddScrollEvent(int frame, float yOffset);
+	void AddPoseEvent(int frame, const CAMERA_POSE& pose);
+
+	// set and get the number of frames the path runs for
+	void SetFrameCount(int frames) { m_frameCount = frames; }
+	int GetFrameCount() const { return m_frameCount; }
+	// get the recorded events in frame order
+	const std::vector<CAMERA_EVENT>& GetEvents() const { return m_events; }
+
+	// read and write the text file format
+	bool Load(const std::string& filename);
+	bool Save(const std::string& filename) const;
+
+	// get the keys whose state is recorded
+	static int GetRecordedKeyCount();
+	static int GetRecordedKey(int index);
+
+	// canonical paths of the benchmark suite
+	static int GetBenchmarkPathCount();
+	static const char* GetBenchmarkPathName(int index);
+	static void CreateBenchmarkPath(int index, CameraPath& path);
+
+private:
+	// insert an event after the events of the same frame
+	void AddEvent(const CAMERA_EVENT& event);
+	// get the file name of a key, or its code for unknown keys
+	static std::string GetKeyName(int key);
+	// get the key code for a file name
+	static int FindKey(const std::string& name);
+
+	// recorded events in frame order
+	std::vector<CAMERA_EVENT> m_events;
+	// number of frames the path runs for
+	int m_frameCount;
+};
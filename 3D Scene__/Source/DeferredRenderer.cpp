@@ -0,0 +1,257 @@
+///////////////////////////////////////////////////////////////////////////////
+// deferredrenderer.cpp
+// ============
+// manage the G-buffer and the lighting pass of the deferred shading path
+///////////////////////////////////////////////////////////////////////////////
+
+#include "DeferredRenderer.h"
+
+#include <iostream>
+
+/***********************************************************
+ *  DeferredRenderer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+DeferredRenderer::DeferredRenderer()
+{
+	m_pGeometryShaderManager = NULL;
+	m_pLightingShaderManager = NULL;
+	m_framebuffer = 0;
+	m_albedoTexture = 0;
+	m_normalTexture = 0;
+	m_diffuseTexture = 0;
+	m_specularTexture = 0;
+	m_depthTexture = 0;
+	m_width = 0;
+	m_height = 0;
+	m_emptyVertexArray = 0;
+	m_targetFramebuffer = 0;
+	m_bDepthCopyChecked = false;
+}
+
+/***********************************************************
+ *  ~DeferredRenderer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+DeferredRenderer::~DeferredRenderer()
+{
+	DestroyGBuffer();
+	if (m_emptyVertexArray != 0)
+	{
+		glDeleteVertexArrays(1, &m_emptyVertexArray);
+		m_emptyVertexArray = 0;
+	}
+	if (NULL != m_pGeometryShaderManager)
+	{
+		delete m_pGeometryShaderManager;
+		m_pGeometryShaderManager = NULL;
+	}
+	if (NULL != m_pLightingShaderManager)
+	{
+		delete m_pLightingShaderManager;
+		m_pLightingShaderManager = NULL;
+	}
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for loading the geometry and lighting
+ *  pass shaders and setting their fixed sampler units.
+ ***********************************************************/
+void DeferredRenderer::Initialize()
+{
+	// the geometry pass shares the vertex shader of the forward path
+	m_pGeometryShaderManager = new ShaderManager();
+	m_pGeometryShaderManager->LoadShaders(
+		"../shaders/vertexShader.glsl",
+		"../shaders/gbufferFragmentShader.glsl");
+
+	m_pLightingShaderManager = new ShaderManager();
+	m_pLightingShaderManager->LoadShaders(
+		"../shaders/deferredVertexShader.glsl",
+		"../shaders/deferredFragmentShader.glsl");
+	m_pLightingShaderManager->use();
+	m_pLightingShaderManager->setIntValue("gbufferAlbedo", GBUFFER_TEXTURE_UNIT);
+	m_pLightingShaderManager->setIntValue("gbufferNormal", GBUFFER_TEXTURE_UNIT + 1);
+	m_pLightingShaderManager->setIntValue("gbufferDiffuse", GBUFFER_TEXTURE_UNIT + 2);
+	m_pLightingShaderManager->setIntValue("gbufferSpecular", GBUFFER_TEXTURE_UNIT + 3);
+	m_pLightingShaderManager->setIntValue("gbufferDepth", GBUFFER_TEXTURE_UNIT + 4);
+
+	// core profile draws need a vertex array even without attributes
+	glGenVertexArrays(1, &m_emptyVertexArray);
+}
+
+/***********************************************************
+ *  CreateGBuffer()
+ *
+ *  This method is used for creating the G-buffer attachments.
+ *  The depth uses the packed depth/stencil format of the
+ *  default framebuffer so that it can be blitted across.
+ ***********************************************************/
+void DeferredRenderer::CreateGBuffer(int width, int height)
+{
+	m_width = width;
+	m_height = height;
+	m_bDepthCopyChecked = false;
+
+	GLuint* colorTextures[] = { &m_albedoTexture, &m_normalTexture, &m_diffuseTexture, &m_specularTexture };
+	// normals and shininess need more range and precision than 8 bits
+	GLenum colorFormats[] = { GL_RGBA8, GL_RGBA16F, GL_RGBA8, GL_RGBA16F };
+
+	glGenFramebuffers(1, &m_framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+
+	GLenum drawBuffers[4];
+	for (int i = 0; i < 4; i++)
+	{
+		glGenTextures(1, colorTextures[i]);
+		glBindTexture(GL_TEXTURE_2D, *colorTextures[i]);
+		glTexImage2D(GL_TEXTURE_2D, 0, colorFormats[i], width, height, 0, GL_RGBA, GL_FLOAT, NULL);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, *colorTextures[i], 0);
+		drawBuffers[i] = GL_COLOR_ATTACHMENT0 + i;
+	}
+	glDrawBuffers(4, drawBuffers);
+
+	glGenTextures(1, &m_depthTexture);
+	glBindTexture(GL_TEXTURE_2D, m_depthTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, width, height, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, m_depthTexture, 0);
+
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "G-buffer framebuffer is not complete" << std::endl;
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+/***********************************************************
+ *  DestroyGBuffer()
+ *
+ *  This method is used for freeing the G-buffer attachments
+ *  and framebuffer.
+ ***********************************************************/
+void DeferredRenderer::DestroyGBuffer()
+{
+	GLuint textures[] = { m_albedoTexture, m_normalTexture, m_diffuseTexture, m_specularTexture, m_depthTexture };
+	glDeleteTextures(5, textures);
+	m_albedoTexture = 0;
+	m_normalTexture = 0;
+	m_diffuseTexture = 0;
+	m_specularTexture = 0;
+	m_depthTexture = 0;
+
+	if (m_framebuffer != 0)
+	{
+		glDeleteFramebuffers(1, &m_framebuffer);
+		m_framebuffer = 0;
+	}
+	m_width = 0;
+	m_height = 0;
+}
+
+/***********************************************************
+ *  BeginGeometryPass()
+ *
+ *  This method is used for binding the G-buffer as the
+ *  render target, recreating it whenever the viewport size
+ *  changes, and activating the geometry pass shader.  The
+ *  framebuffer bound before is the target of the lighting.
+ ***********************************************************/
+void DeferredRenderer::BeginGeometryPass()
+{
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &m_targetFramebuffer);
+
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	if ((viewport[2] != m_width) || (viewport[3] != m_height))
+	{
+		DestroyGBuffer();
+		CreateGBuffer(viewport[2], viewport[3]);
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+
+	// every attachment is cleared to zero without changing the
+	// clear color of the scene framebuffer
+	const GLfloat gBufferClear[] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	for (int i = 0; i < 4; i++)
+	{
+		glClearBufferfv(GL_COLOR, i, gBufferClear);
+	}
+	glClear(GL_DEPTH_BUFFER_BIT);
+
+	// G-buffer values are written as-is, never blended
+	glDisable(GL_BLEND);
+
+	m_pGeometryShaderManager->use();
+}
+
+/***********************************************************
+ *  EndGeometryPass()
+ *
+ *  This method is used for returning to the target
+ *  framebuffer after the geometry pass.
+ ***********************************************************/
+void DeferredRenderer::EndGeometryPass()
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, m_targetFramebuffer);
+	glEnable(GL_BLEND);
+}
+
+/***********************************************************
+ *  RenderLightingPass()
+ *
+ *  This method is used for drawing the full screen lighting
+ *  pass.  The light and shadow uniforms are expected to be
+ *  set on the lighting shader already.  Afterwards the depth
+ *  is copied into the target framebuffer so that any later
+ *  forward rendering is still depth tested correctly.  The
+ *  target has to be single sampled for the depth copy.
+ ***********************************************************/
+void DeferredRenderer::RenderLightingPass(
+	const glm::mat4& view,
+	const glm::mat4& projection,
+	glm::vec3 viewPosition)
+{
+	m_pLightingShaderManager->use();
+	m_pLightingShaderManager->setMat4Value("view", view);
+	m_pLightingShaderManager->setMat4Value("inverseViewProjection", glm::inverse(projection * view));
+	m_pLightingShaderManager->setVec3Value("viewPosition", viewPosition);
+
+	GLuint textures[] = { m_albedoTexture, m_normalTexture, m_diffuseTexture, m_specularTexture, m_depthTexture };
+	for (int i = 0; i < 5; i++)
+	{
+		glActiveTexture(GL_TEXTURE0 + GBUFFER_TEXTURE_UNIT + i);
+		glBindTexture(GL_TEXTURE_2D, textures[i]);
+	}
+
+	// every pixel is lit exactly once, with no depth testing
+	glDisable(GL_DEPTH_TEST);
+	glBindVertexArray(m_emptyVertexArray);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	glBindVertexArray(0);
+	glEnable(GL_DEPTH_TEST);
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, m_framebuffer);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_targetFramebuffer);
+	glBlitFramebuffer(0, 0, m_width, m_height, 0, 0, m_width, m_height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+	// the first copy into a new G-buffer's target is checked, as a
+	// multisampled target rejects it and leaves the depth unset
+	if (!m_bDepthCopyChecked)
+	{
+		GLenum error = glGetError();
+		if (error != GL_NO_ERROR)
+		{
+			std::cout << "Deferred depth copy failed with GL error 0x" << std::hex << error << std::dec << std::endl;
+		}
+		m_bDepthCopyChecked = true;
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, m_targetFramebuffer);
+}
@@ -0,0 +1,88 @@
+///////////////////////////////////////////////////////////////////////////////
+// deferredrenderer.h
+// ============
+// manage the G-buffer and the lighting pass of the deferred shading path
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderManager.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+/***********************************************************
+ *  DeferredRenderer
+ *
+ *  This class owns the G-buffer framebuffer and the shaders
+ *  of the deferred shading path.  The geometry pass writes
+ *  albedo, normal, material diffuse, specular and shininess,
+ *  and depth for every pixel.  The lighting pass then runs
+ *  once per pixel with a full screen triangle, so the cost
+ *  of the lights no longer multiplies with the overdraw.
+ ***********************************************************/
+class DeferredRenderer
+{
+public:
+	// constructor
+	DeferredRenderer();
+	// destructor
+	~DeferredRenderer();
+
+	// first texture unit used for binding the G-buffer - above
+	// the units used by the scene textures and the shadow map
+	static const int GBUFFER_TEXTURE_UNIT = 16;
+
+	// load the shaders - needs a current GL context
+	void Initialize();
+
+	// get the shader used by the geometry pass
+	ShaderManager* GetGeometryShader() { return m_pGeometryShaderManager; }
+	// get the shader used by the lighting pass
+	ShaderManager* GetLightingShader() { return m_pLightingShaderManager; }
+	// get the G-buffer depth and world space normals, read by the
+	// passes between the geometry and the lighting pass
+	GLuint GetDepthTexture() const { return m_depthTexture; }
+	GLuint GetNormalTexture() const { return m_normalTexture; }
+
+	// bind and clear the G-buffer, resized to the current viewport -
+	// the camera comes from the bound camera uniform block
+	void BeginGeometryPass();
+	// return to the framebuffer bound before the geometry pass
+	void EndGeometryPass();
+
+	// accumulate the lights for every pixel of the G-buffer and
+	// copy the G-buffer depth into the default framebuffer
+	void RenderLightingPass(
+		const glm::mat4& view,
+		const glm::mat4& projection,
+		glm::vec3 viewPosition);
+
+private:
+	// create the G-buffer textures for the passed in size
+	void CreateGBuffer(int width, int height);
+	// free the G-buffer textures and framebuffer
+	void DestroyGBuffer();
+
+	// shader writing the surface properties into the G-buffer
+	ShaderManager* m_pGeometryShaderManager;
+	// shader accumulating the lights from the G-buffer
+	ShaderManager* m_pLightingShaderManager;
+	// G-buffer framebuffer and its attachments
+	GLuint m_framebuffer;
+	GLuint m_albedoTexture;
+	GLuint m_normalTexture;
+	GLuint m_diffuseTexture;
+	GLuint m_specularTexture;
+	GLuint m_depthTexture;
+	// size of the G-buffer attachments
+	int m_width;
+	int m_height;
+	// empty vertex array bound for the full screen triangle
+	GLuint m_emptyVertexArray;
+	// framebuffer the lighting pass renders into
+	GLint m_targetFramebuffer;
+	// the depth copy into the target was checked for errors since
+	// the G-buffer was created
+	bool m_bDepthCopyChecked;
+};
@@ -0,0 +1,256 @@
+///////////////////////////////////////////////////////////////////////////////
+// framepacer.cpp
+// ============
+// pace the presented frames and report the distribution of their times
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FramePacer.h"
+
+// GLFW library
+#include "GLFW/glfw3.h"
+
+#include <algorithm>
+#include <thread>
+#include <iostream>
+#include <iomanip>
+
+// declare the global variables
+namespace
+{
+	const char* g_PresentModeNames[] = { "vsync", "uncapped", "limited" };
+
+	// frames collected between the console reports
+	const int REPORT_FRAMES = 300;
+	// width of the histogram buckets in milliseconds, and the
+	// bucket that holds every longer frame
+	const double BUCKET_MS = 1.0;
+	const int BUCKET_COUNT = 50;
+	// range the spin margin of the limiter is kept within - the
+	// upper end keeps the spinning short with a coarse system
+	// timer, at the cost of an occasional late frame
+	const double MIN_SPIN_MARGIN_MS = 0.5;
+	const double MAX_SPIN_MARGIN_MS = 4.0;
+	// a frame started later than this after its deadline is late
+	const double LATE_FRAME_MS = 0.5;
+
+	// convert a steady clock duration into milliseconds
+	double ElapsedMs(
+		std::chrono::steady_clock::time_point start,
+		std::chrono::steady_clock::time_point end)
+	{
+		return std::chrono::duration<double, std::milli>(end - start).count();
+	}
+}
+
+/***********************************************************
+ *  FramePacer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+FramePacer::FramePacer()
+{
+	// no mode has been applied, so the first one sets the swap interval
+	m_mode = -1;
+	m_frameRateLimit = 60;
+	m_nextFrame = std::chrono::steady_clock::now();
+	m_spinMarginMs = 2.0;
+	m_bHaveLastPresent = false;
+	m_lateFrames = 0;
+	m_frameTimes.reserve(REPORT_FRAMES);
+}
+
+/***********************************************************
+ *  GetModeName()
+ *
+ *  This method is used for getting the display name of the
+ *  passed in present mode.
+ ***********************************************************/
+const char* FramePacer::GetModeName(int mode)
+{
+	if ((mode < 0) || (mode >= PRESENT_MODE_COUNT))
+	{
+		return("unknown");
+	}
+	return(g_PresentModeNames[mode]);
+}
+
+/***********************************************************
+ *  SetMode()
+ *
+ *  This method is used for selecting the present mode and
+ *  the frame rate of the limiter.  Only vsync waits in the
+ *  swap, so the swap interval is changed with the mode and
+ *  the frames collected in the previous mode are dropped.
+ ***********************************************************/
+void FramePacer::SetMode(int mode, int frameRateLimit)
+{
+	frameRateLimit = std::max(frameRateLimit, 1);
+	if ((mode == m_mode) && (frameRateLimit == m_frameRateLimit))
+	{
+		return;
+	}
+
+	if (mode != m_mode)
+	{
+		glfwSwapInterval((mode == PRESENT_VSYNC) ? 1 : 0);
+	}
+	m_mode = mode;
+	m_frameRateLimit = frameRateLimit;
+
+	std::cout << "INFO: Present mode " << GetModeName(m_mode);
+	if (m_mode == PRESENT_LIMITED)
+	{
+		std::cout << " at " << m_frameRateLimit << " fps";
+	}
+	std::cout << std::endl;
+
+	m_frameTimes.clear();
+	m_lateFrames = 0;
+	Reset();
+}
+
+/***********************************************************
+ *  WaitForNextFrame()
+ *
+ *  This method is used for waiting until the limiter should
+ *  start the next frame.  The thread sleeps until the spin
+ *  margin before the deadline and spins through the rest.
+ *  A sleep that wakes up later than the margin widens it for
+ *  the next frames, and it slowly narrows again while the
+ *  sleeps are on time.  A frame that missed its deadline
+ *  starts the schedule again from now rather than running
+ *  the following frames back to back to catch up.
+ ***********************************************************/
+void FramePacer::WaitForNextFrame()
+{
+	if (m_mode != PRESENT_LIMITED)
+	{
+		return;
+	}
+
+	auto now = std::chrono::steady_clock::now();
+	double remainingMs = ElapsedMs(now, m_nextFrame);
+	if (remainingMs > m_spinMarginMs)
+	{
+		double sleepMs = remainingMs - m_spinMarginMs;
+		std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(sleepMs));
+
+		double oversleepMs = ElapsedMs(now, std::chrono::steady_clock::now()) - sleepMs;
+		if (oversleepMs > m_spinMarginMs)
+		{
+			m_spinMarginMs = oversleepMs * 1.25;
+		}
+		else
+		{
+			m_spinMarginMs = 0.95 * m_spinMarginMs + 0.05 * oversleepMs * 1.25;
+		}
+		m_spinMarginMs = std::min(std::max(m_spinMarginMs, MIN_SPIN_MARGIN_MS), MAX_SPIN_MARGIN_MS);
+	}
+
+	while (std::chrono::steady_clock::now() < m_nextFrame)
+	{
+		std::this_thread::yield();
+	}
+
+	auto frameStart = std::chrono::steady_clock::now();
+	auto framePeriod = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+		std::chrono::duration<double>(1.0 / m_frameRateLimit));
+	if (ElapsedMs(m_nextFrame, frameStart) > LATE_FRAME_MS)
+	{
+		m_lateFrames++;
+		m_nextFrame = frameStart + framePeriod;
+	}
+	else
+	{
+		m_nextFrame += framePeriod;
+	}
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used for collecting the time since the
+ *  previous frame was presented.
+ ***********************************************************/
+void FramePacer::EndFrame()
+{
+	auto now = std::chrono::steady_clock::now();
+	if (m_bHaveLastPresent)
+	{
+		m_frameTimes.push_back(ElapsedMs(m_lastPresent, now));
+	}
+	m_lastPresent = now;
+	m_bHaveLastPresent = true;
+
+	if (m_frameTimes.size() >= REPORT_FRAMES)
+	{
+		Report();
+	}
+}
+
+/***********************************************************
+ *  Reset()
+ *
+ *  This method is used for forgetting the previous frame
+ *  after the main loop has been idle.
+ ***********************************************************/
+void FramePacer::Reset()
+{
+	m_bHaveLastPresent = false;
+	m_nextFrame = std::chrono::steady_clock::now();
+}
+
+/***********************************************************
+ *  Report()
+ *
+ *  This method is used for printing the percentiles of the
+ *  collected frame times and a histogram of the non-empty
+ *  millisecond buckets, then starting a new collection.
+ ***********************************************************/
+void FramePacer::Report()
+{
+	std::vector<double> sorted = m_frameTimes;
+	std::sort(sorted.begin(), sorted.end());
+
+	double totalMs = 0.0;
+	std::vector<int> buckets(BUCKET_COUNT, 0);
+	for (int i = 0; i < (int)sorted.size(); i++)
+	{
+		totalMs += sorted[i];
+		buckets[std::min((int)(sorted[i] / BUCKET_MS), BUCKET_COUNT - 1)]++;
+	}
+
+	std::cout << std::fixed << std::setprecision(2);
+	std::cout << "INFO: Frame pacing " << GetModeName(m_mode);
+	if (m_mode == PRESENT_LIMITED)
+	{
+		std::cout << " " << m_frameRateLimit << " fps";
+	}
+	std::cout << " - " << sorted.size() << " frames, average " << totalMs / sorted.size()
+		<< " ms, p50 " << sorted[sorted.size() / 2] << " ms, p99 " << sorted[(sorted.size() * 99) / 100]
+		<< " ms, max " << sorted.back() << " ms, " << m_lateFrames << " late" << std::endl;
+
+	std::cout << std::setprecision(0) << "INFO: Frame time histogram -";
+	const char* separator = " ";
+	for (int i = 0; i < BUCKET_COUNT; i++)
+	{
+		if (buckets[i] == 0)
+		{
+			continue;
+		}
+		std::cout << separator << i * BUCKET_MS;
+		if (i == BUCKET_COUNT - 1)
+		{
+			std::cout << "+ ms: " << buckets[i];
+		}
+		else
+		{
+			std::cout << "-" << (i + 1) * BUCKET_MS << " ms: " << buckets[i];
+		}
+		separator = ", ";
+	}
+	std::cout << std::endl << std::defaultfloat << std::setprecision(6);
+
+	m_frameTimes.clear();
+	m_lateFrames = 0;
+}
@@ -0,0 +1,77 @@
+///////////////////////////////////////////////////////////////////////////////
+// framepacer.h
+// ============
+// pace the presented frames and report the distribution of their times
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <chrono>
+#include <vector>
+
+/***********************************************************
+ *  FramePacer
+ *
+ *  This class decides when the main loop starts its next
+ *  frame.  With vsync the swap waits for the display, while
+ *  the uncapped mode presents as fast as frames are rendered.
+ *  The limiter sleeps until shortly before the deadline of
+ *  the next frame and spins through the rest, since a sleep
+ *  can wake up late by a scheduler tick but a spin cannot.
+ *  The time between presented frames is collected into a
+ *  histogram that is printed at a fixed frame interval.
+ ***********************************************************/
+class FramePacer
+{
+public:
+	// constructor
+	FramePacer();
+
+	// ways the frames can be paced
+	enum PRESENT_MODE
+	{
+		// the swap waits for the vertical blank of the display
+		PRESENT_VSYNC,
+		// frames are presented as fast as they are rendered
+		PRESENT_UNCAPPED,
+		// frames are started at a fixed rate without vsync
+		PRESENT_LIMITED,
+		PRESENT_MODE_COUNT
+	};
+
+	// get the display name of a present mode
+	static const char* GetModeName(int mode);
+
+	// select the present mode and the rate of the limiter,
+	// setting the swap interval when the mode changes - needs
+	// a current GL context
+	void SetMode(int mode, int frameRateLimit);
+	// wait until the next frame should be started
+	void WaitForNextFrame();
+	// mark that a frame has been presented
+	void EndFrame();
+	// forget the previous frame after the loop has been idle,
+	// so the wait is not counted and the limiter does not try
+	// to catch up on the frames it skipped
+	void Reset();
+
+private:
+	// print the histogram of the collected frame times
+	void Report();
+
+	// selected present mode and limiter rate
+	int m_mode;
+	int m_frameRateLimit;
+	// time the limiter starts the next frame at
+	std::chrono::steady_clock::time_point m_nextFrame;
+	// how long before the deadline the limiter stops sleeping,
+	// adapted to how late the sleeps wake up
+	double m_spinMarginMs;
+	// time the previous frame was presented at
+	std::chrono::steady_clock::time_point m_lastPresent;
+	bool m_bHaveLastPresent;
+	// times between the frames presented since the last report
+	std::vector<double> m_frameTimes;
+	// frames the limiter started after their deadline
+	int m_lateFrames;
+};
@@ -0,0 +1,345 @@
+///////////////////////////////////////////////////////////////////////////////
+// hdrrendertarget.cpp
+// ============
+// manage the floating point render target and its tone mapping resolve
+///////////////////////////////////////////////////////////////////////////////
+
+#include "HDRRenderTarget.h"
+
+#include <glm/glm.hpp>
+
+#include <iostream>
+#include <iomanip>
+
+// declare the global variables
+namespace
+{
+	// texture unit the resolve pass reads the samples from,
+	// after the units used by the scene and the G-buffer
+	const int HDR_COLOR_TEXTURE_UNIT = 21;
+	// texture unit the resolve pass reads a single sampled target
+	// from, after the units of the ambient occlusion - a program
+	// may not point two sampler types at the same unit, and GL 3.3
+	// provides at least 48
+	const int HDR_SINGLE_COLOR_TEXTURE_UNIT = 32;
+	// texture unit the upscale reads the resolved target from,
+	// after the units of the transparency targets
+	const int UPSCALE_TEXTURE_UNIT = 27;
+
+	const char* g_ToneMapOperatorNames[] = { "none", "reinhard", "aces" };
+}
+
+/***********************************************************
+ *  HDRRenderTarget()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+HDRRenderTarget::HDRRenderTarget()
+{
+	m_pResolveShaderManager = NULL;
+	m_pUpscaleShaderManager = NULL;
+	m_framebuffer = 0;
+	m_colorTexture = 0;
+	m_depthRenderbuffer = 0;
+	m_upscaleFramebuffer = 0;
+	m_upscaleTexture = 0;
+	m_width = 0;
+	m_height = 0;
+	m_samples = 0;
+	m_supportedSamples = 0;
+	m_emptyVertexArray = 0;
+}
+
+/***********************************************************
+ *  ~HDRRenderTarget()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+HDRRenderTarget::~HDRRenderTarget()
+{
+	DestroyTarget();
+	if (m_emptyVertexArray != 0)
+	{
+		glDeleteVertexArrays(1, &m_emptyVertexArray);
+		m_emptyVertexArray = 0;
+	}
+	if (NULL != m_pResolveShaderManager)
+	{
+		delete m_pResolveShaderManager;
+		m_pResolveShaderManager = NULL;
+	}
+	if (NULL != m_pUpscaleShaderManager)
+	{
+		delete m_pUpscaleShaderManager;
+		m_pUpscaleShaderManager = NULL;
+	}
+}
+
+/***********************************************************
+ *  GetToneMapOperatorName()
+ *
+ *  This method is used for getting the display name of the
+ *  passed in tone mapping operator.
+ ***********************************************************/
+const char* HDRRenderTarget::GetToneMapOperatorName(int toneMapOperator)
+{
+	if ((toneMapOperator < 0) || (toneMapOperator >= TONE_MAP_OPERATOR_COUNT))
+	{
+		return("unknown");
+	}
+	return(g_ToneMapOperatorNames[toneMapOperator]);
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for loading the resolve shader.
+ ***********************************************************/
+void HDRRenderTarget::Initialize()
+{
+	// the resolve shares the full screen triangle of the
+	// deferred lighting pass
+	m_pResolveShaderManager = new ShaderManager();
+	m_pResolveShaderManager->LoadShaders(
+		"../shaders/deferredVertexShader.glsl",
+		"../shaders/toneMapFragmentShader.glsl");
+	m_pResolveShaderManager->use();
+	m_pResolveShaderManager->setIntValue("hdrColorSamples", HDR_COLOR_TEXTURE_UNIT);
+	m_pResolveShaderManager->setIntValue("hdrColor", HDR_SINGLE_COLOR_TEXTURE_UNIT);
+
+	m_pUpscaleShaderManager = new ShaderManager();
+	m_pUpscaleShaderManager->LoadShaders(
+		"../shaders/deferredVertexShader.glsl",
+		"../shaders/upscaleFragmentShader.glsl");
+	m_pUpscaleShaderManager->use();
+	m_pUpscaleShaderManager->setIntValue("sceneColor", UPSCALE_TEXTURE_UNIT);
+
+	// core profile draws need a vertex array even without attributes
+	glGenVertexArrays(1, &m_emptyVertexArray);
+}
+
+/***********************************************************
+ *  CreateTarget()
+ *
+ *  This method is used for creating the color and depth
+ *  attachments, multisampled unless a single sample is
+ *  requested.  A single sampled target is made of plain
+ *  textures and renderbuffers, so the deferred path can
+ *  copy its depth into it.
+ ***********************************************************/
+void HDRRenderTarget::CreateTarget(int width, int height, int samples)
+{
+	// clamp the requested samples to what the driver supports
+	GLint maxColorSamples = 1;
+	GLint maxSamples = 1;
+	glGetIntegerv(GL_MAX_COLOR_TEXTURE_SAMPLES, &maxColorSamples);
+	glGetIntegerv(GL_MAX_SAMPLES, &maxSamples);
+	int supportedSamples = glm::max(1, glm::min(samples, glm::min(maxColorSamples, maxSamples)));
+
+	m_width = width;
+	m_height = height;
+	m_samples = samples;
+	m_supportedSamples = supportedSamples;
+
+	GLenum colorTarget = (supportedSamples > 1) ? GL_TEXTURE_2D_MULTISAMPLE : GL_TEXTURE_2D;
+	glGenTextures(1, &m_colorTexture);
+	glBindTexture(colorTarget, m_colorTexture);
+	if (supportedSamples > 1)
+	{
+		glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, supportedSamples, GL_RGBA16F, width, height, GL_TRUE);
+	}
+	else
+	{
+		// the resolve fetches the texels, so there are no mip levels
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_FLOAT, NULL);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	}
+	glBindTexture(colorTarget, 0);
+
+	// the depth is never sampled, so a renderbuffer is enough - the
+	// packed format matches the G-buffer depth copied into it
+	glGenRenderbuffers(1, &m_depthRenderbuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_depthRenderbuffer);
+	if (supportedSamples > 1)
+	{
+		glRenderbufferStorageMultisample(GL_RENDERBUFFER, supportedSamples, GL_DEPTH24_STENCIL8, width, height);
+	}
+	else
+	{
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+	}
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &m_framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, colorTarget, m_colorTexture, 0);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_depthRenderbuffer);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "HDR framebuffer is not complete" << std::endl;
+	}
+
+	// every sample is read once at 8 bytes and every pixel is
+	// written once at 4 bytes by the resolve
+	double readMB = (double)width * height * supportedSamples * 8.0 / (1024.0 * 1024.0);
+	double writeMB = (double)width * height * 4.0 / (1024.0 * 1024.0);
+	std::cout << std::fixed << std::setprecision(1);
+	std::cout << "INFO: HDR target " << width << "x" << height << ", " << supportedSamples
+		<< "x MSAA - resolve reads " << readMB << " MB and writes " << writeMB
+		<< " MB per frame, " << (readMB + writeMB) * 60.0 / 1024.0 << " GB/s at 60 fps" << std::endl;
+	std::cout << std::defaultfloat << std::setprecision(6);
+}
+
+/***********************************************************
+ *  DestroyTarget()
+ *
+ *  This method is used for freeing the attachments and
+ *  framebuffer.
+ ***********************************************************/
+void HDRRenderTarget::DestroyTarget()
+{
+	if (m_colorTexture != 0)
+	{
+		glDeleteTextures(1, &m_colorTexture);
+		m_colorTexture = 0;
+	}
+	if (m_depthRenderbuffer != 0)
+	{
+		glDeleteRenderbuffers(1, &m_depthRenderbuffer);
+		m_depthRenderbuffer = 0;
+	}
+	if (m_framebuffer != 0)
+	{
+		glDeleteFramebuffers(1, &m_framebuffer);
+		m_framebuffer = 0;
+	}
+	if (m_upscaleTexture != 0)
+	{
+		glDeleteTextures(1, &m_upscaleTexture);
+		m_upscaleTexture = 0;
+	}
+	if (m_upscaleFramebuffer != 0)
+	{
+		glDeleteFramebuffers(1, &m_upscaleFramebuffer);
+		m_upscaleFramebuffer = 0;
+	}
+	m_width = 0;
+	m_height = 0;
+	m_samples = 0;
+	m_supportedSamples = 0;
+}
+
+/***********************************************************
+ *  CreateUpscaleTarget()
+ *
+ *  This method is used for creating the texture the target
+ *  is resolved into before it is upscaled.  It holds display
+ *  range colors, so 8 bits per channel are enough, and it is
+ *  filtered so the upscale can read between its texels.
+ ***********************************************************/
+void HDRRenderTarget::CreateUpscaleTarget()
+{
+	glGenTextures(1, &m_upscaleTexture);
+	glBindTexture(GL_TEXTURE_2D, m_upscaleTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_width, m_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	glGenFramebuffers(1, &m_upscaleFramebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_upscaleFramebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_upscaleTexture, 0);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "Upscale framebuffer is not complete" << std::endl;
+	}
+}
+
+/***********************************************************
+ *  Bind()
+ *
+ *  This method is used for binding the offscreen target for
+ *  rendering the scene, recreating it first whenever the
+ *  passed in size or number of samples changes.
+ ***********************************************************/
+void HDRRenderTarget::Bind(int width, int height, int samples)
+{
+	if ((width != m_width) || (height != m_height) || (samples != m_samples))
+	{
+		DestroyTarget();
+		CreateTarget(width, height, samples);
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+}
+
+/***********************************************************
+ *  Resolve()
+ *
+ *  This method is used for drawing the resolve pass into the
+ *  default framebuffer.  Each sample is scaled by the
+ *  exposure and tone mapped before the samples are averaged,
+ *  so bright edges are antialiased like dark ones.  A target
+ *  smaller than the passed in output size is resolved at its
+ *  own size first and then upscaled, so the tone mapping and
+ *  the sample loop only run once per rendered pixel.
+ ***********************************************************/
+void HDRRenderTarget::Resolve(float exposure, int toneMapOperator, int outputWidth, int outputHeight, float sharpness)
+{
+	bool bUpscale = (outputWidth != m_width) || (outputHeight != m_height);
+	if (bUpscale)
+	{
+		if (m_upscaleFramebuffer == 0)
+		{
+			CreateUpscaleTarget();
+		}
+		glBindFramebuffer(GL_FRAMEBUFFER, m_upscaleFramebuffer);
+		glViewport(0, 0, m_width, m_height);
+	}
+	else
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glViewport(0, 0, outputWidth, outputHeight);
+	}
+
+	m_pResolveShaderManager->use();
+	m_pResolveShaderManager->setFloatValue("exposure", exposure);
+	m_pResolveShaderManager->setIntValue("toneMapOperator", toneMapOperator);
+	m_pResolveShaderManager->setIntValue("sampleCount", m_supportedSamples);
+
+	if (m_supportedSamples > 1)
+	{
+		glActiveTexture(GL_TEXTURE0 + HDR_COLOR_TEXTURE_UNIT);
+		glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, m_colorTexture);
+	}
+	else
+	{
+		glActiveTexture(GL_TEXTURE0 + HDR_SINGLE_COLOR_TEXTURE_UNIT);
+		glBindTexture(GL_TEXTURE_2D, m_colorTexture);
+	}
+
+	// every pixel is written exactly once, nothing to test or blend
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_BLEND);
+	glBindVertexArray(m_emptyVertexArray);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+
+	if (bUpscale)
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glViewport(0, 0, outputWidth, outputHeight);
+
+		m_pUpscaleShaderManager->use();
+		m_pUpscaleShaderManager->setFloatValue("sharpness", sharpness);
+		glActiveTexture(GL_TEXTURE0 + UPSCALE_TEXTURE_UNIT);
+		glBindTexture(GL_TEXTURE_2D, m_upscaleTexture);
+		glDrawArrays(GL_TRIANGLES, 0, 3);
+	}
+
+	glBindVertexArray(0);
+	glEnable(GL_BLEND);
+	glEnable(GL_DEPTH_TEST);
+}
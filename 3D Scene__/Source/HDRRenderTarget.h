@@ -0,0 +1,88 @@
+///////////////////////////////////////////////////////////////////////////////
+// hdrrendertarget.h
+// ============
+// manage the floating point render target and its tone mapping resolve
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderManager.h"
+
+#include <GL/glew.h>
+
+/***********************************************************
+ *  HDRRenderTarget
+ *
+ *  This class owns the offscreen framebuffer the scene is
+ *  rendered into.  The color is stored as RGBA16F so that
+ *  the summed lights are not clamped, optionally with MSAA.
+ *  The resolve pass reads every sample once, tone maps it
+ *  with the selected operator and averages the samples into
+ *  the default framebuffer in a single full screen draw.
+ *  When the target is smaller than the window, the resolve
+ *  writes into a display range texture of the target size
+ *  instead, which a second pass upscales into the window
+ *  with contrast adaptive sharpening.
+ ***********************************************************/
+class HDRRenderTarget
+{
+public:
+	// constructor
+	HDRRenderTarget();
+	// destructor
+	~HDRRenderTarget();
+
+	// tone mapping operators of the resolve pass
+	enum TONE_MAP_OPERATOR
+	{
+		TONE_MAP_NONE,
+		TONE_MAP_REINHARD,
+		TONE_MAP_ACES,
+		TONE_MAP_OPERATOR_COUNT
+	};
+
+	// get the display name of a tone mapping operator
+	static const char* GetToneMapOperatorName(int toneMapOperator);
+
+	// load the resolve shader - needs a current GL context
+	void Initialize();
+
+	// bind the target, recreated when the size or the number
+	// of samples changes
+	void Bind(int width, int height, int samples);
+	// tone map and resolve the target into the default framebuffer
+	// of the passed in size, upscaling and sharpening it when the
+	// target is smaller
+	void Resolve(float exposure, int toneMapOperator, int outputWidth, int outputHeight, float sharpness);
+
+	// get the number of samples the target was created with
+	int GetSampleCount() const { return m_supportedSamples; }
+
+private:
+	// create the color and depth attachments
+	void CreateTarget(int width, int height, int samples);
+	// free the attachments and framebuffer
+	void DestroyTarget();
+	// create the display range texture read by the upscale
+	void CreateUpscaleTarget();
+
+	// shader tone mapping and averaging the samples
+	ShaderManager* m_pResolveShaderManager;
+	// shader upscaling and sharpening the resolved target
+	ShaderManager* m_pUpscaleShaderManager;
+	// offscreen framebuffer and its attachments
+	GLuint m_framebuffer;
+	GLuint m_colorTexture;
+	GLuint m_depthRenderbuffer;
+	// resolved target read by the upscale, created on first use
+	GLuint m_upscaleFramebuffer;
+	GLuint m_upscaleTexture;
+	// size and requested sample count of the attachments
+	int m_width;
+	int m_height;
+	int m_samples;
+	// sample count after clamping to the driver limits
+	int m_supportedSamples;
+	// empty vertex array bound for the full screen triangle
+	GLuint m_emptyVertexArray;
+};
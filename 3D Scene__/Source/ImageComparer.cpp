@@ -0,0 +1,303 @@
+///////////////////////////////////////////////////////////////////////////////
+// imagecomparer.cpp
+// ============
+// compare rendered frames with stored reference images
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ImageComparer.h"
+
+#include "stb_image.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+// declare the global variables
+namespace
+{
+	// edge length of the SSIM windows and the step between them,
+	// so neighbouring windows overlap by half
+	const int SSIM_WINDOW = 8;
+	const int SSIM_STEP = 4;
+	// stabilizing constants of the SSIM for 8 bit values
+	const double SSIM_C1 = (0.01 * 255.0) * (0.01 * 255.0);
+	const double SSIM_C2 = (0.03 * 255.0) * (0.03 * 255.0);
+	// channel difference up to which a pixel counts as unchanged
+	const int CHANGED_PIXEL_THRESHOLD = 8;
+	// scale of the channel difference shown in the difference image
+	const int DIFFERENCE_SCALE = 8;
+	// largest data length of a stored deflate block
+	const size_t STORED_BLOCK_BYTES = 65535;
+
+	/***********************************************************
+	 *  UpdateCRC()
+	 *
+	 *  This function is used to continue the CRC-32 of a PNG
+	 *  chunk over the passed in bytes.
+	 ***********************************************************/
+	unsigned int UpdateCRC(unsigned int crc, const unsigned char* pBytes, size_t size)
+	{
+		static unsigned int table[256];
+		static bool bTableReady = false;
+		if (!bTableReady)
+		{
+			for (unsigned int i = 0; i < 256; i++)
+			{
+				unsigned int value = i;
+				for (int bit = 0; bit < 8; bit++)
+				{
+					value = (value & 1) ? (0xEDB88320u ^ (value >> 1)) : (value >> 1);
+				}
+				table[i] = value;
+			}
+			bTableReady = true;
+		}
+
+		crc = ~crc;
+		for (size_t i = 0; i < size; i++)
+		{
+			crc = table[(crc ^ pBytes[i]) & 0xFF] ^ (crc >> 8);
+		}
+		return(~crc);
+	}
+
+	/***********************************************************
+	 *  AppendBigEndian()
+	 *
+	 *  This function is used to append a 32 bit value with its
+	 *  most significant byte first, as PNG stores them.
+	 ***********************************************************/
+	void AppendBigEndian(std::vector<unsigned char>& bytes, unsigned int value)
+	{
+		bytes.push_back((unsigned char)(value >> 24));
+		bytes.push_back((unsigned char)(value >> 16));
+		bytes.push_back((unsigned char)(value >> 8));
+		bytes.push_back((unsigned char)value);
+	}
+
+	/***********************************************************
+	 *  WriteChunk()
+	 *
+	 *  This function is used to write one PNG chunk - its
+	 *  length, type, data and the CRC of the type and data.
+	 ***********************************************************/
+	void WriteChunk(std::ofstream& file, const char* type, const std::vector<unsigned char>& data)
+	{
+		std::vector<unsigned char> chunk;
+		AppendBigEndian(chunk, (unsigned int)data.size());
+		chunk.insert(chunk.end(), type, type + 4);
+		chunk.insert(chunk.end(), data.begin(), data.end());
+		AppendBigEndian(chunk, UpdateCRC(0, &chunk[4], data.size() + 4));
+		file.write((const char*)&chunk[0], chunk.size());
+	}
+
+	/***********************************************************
+	 *  GetLuma()
+	 *
+	 *  This function is used to get the brightness of an RGB
+	 *  pixel as it is perceived.
+	 ***********************************************************/
+	double GetLuma(const unsigned char* pPixel)
+	{
+		return(0.299 * pPixel[0] + 0.587 * pPixel[1] + 0.114 * pPixel[2]);
+	}
+}
+
+/***********************************************************
+ *  LoadPNG()
+ *
+ *  This method is used for loading a PNG file as 8 bit RGB
+ *  with the rows bottom first.
+ ***********************************************************/
+bool ImageComparer::LoadPNG(const std::string& filename, std::vector<unsigned char>& pixels, int& width, int& height)
+{
+	int colorChannels = 0;
+	stbi_set_flip_vertically_on_load(true);
+	unsigned char* image = stbi_load(filename.c_str(), &width, &height, &colorChannels, 3);
+	if (NULL == image)
+	{
+		return(false);
+	}
+
+	pixels.assign(image, image + (size_t)width * height * 3);
+	stbi_image_free(image);
+	return(true);
+}
+
+/***********************************************************
+ *  SavePNG()
+ *
+ *  This method is used for storing an image as a PNG file.
+ *  The rows are written top first with no filter, in
+ *  stored deflate blocks, which any PNG reader accepts
+ *  without a compression library being linked in.  The
+ *  files are as large as the pixels, which suits the few
+ *  reference images they are used for.
+ ***********************************************************/
+bool ImageComparer::SavePNG(const std::string& filename, const std::vector<unsigned char>& pixels, int width, int height)
+{
+	std::ofstream file(filename, std::ios::binary);
+	if (!file.is_open())
+	{
+		std::cout << "Could not write image file:" << filename << std::endl;
+		return(false);
+	}
+
+	const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	file.write((const char*)signature, sizeof(signature));
+
+	// 8 bits per channel, RGB, no interlacing
+	std::vector<unsigned char> header;
+	AppendBigEndian(header, (unsigned int)width);
+	AppendBigEndian(header, (unsigned int)height);
+	const unsigned char format[5] = { 8, 2, 0, 0, 0 };
+	header.insert(header.end(), format, format + 5);
+	WriteChunk(file, "IHDR", header);
+
+	// each row starts with its filter type
+	size_t rowBytes = (size_t)width * 3;
+	std::vector<unsigned char> rows;
+	rows.reserve((rowBytes + 1) * height);
+	for (int y = height - 1; y >= 0; y--)
+	{
+		rows.push_back(0);
+		rows.insert(rows.end(), pixels.begin() + y * rowBytes, pixels.begin() + (y + 1) * rowBytes);
+	}
+
+	// zlib stream of stored blocks, followed by the Adler-32 of the rows
+	std::vector<unsigned char> stream;
+	stream.reserve(rows.size() + rows.size() / STORED_BLOCK_BYTES * 5 + 16);
+	stream.push_back(0x78);
+	stream.push_back(0x01);
+	size_t offset = 0;
+	do
+	{
+		size_t blockBytes = std::min(rows.size() - offset, STORED_BLOCK_BYTES);
+		bool bLast = (offset + blockBytes == rows.size());
+		stream.push_back(bLast ? 1 : 0);
+		stream.push_back((unsigned char)blockBytes);
+		stream.push_back((unsigned char)(blockBytes >> 8));
+		stream.push_back((unsigned char)~blockBytes);
+		stream.push_back((unsigned char)(~blockBytes >> 8));
+		stream.insert(stream.end(), rows.begin() + offset, rows.begin() + offset + blockBytes);
+		offset += blockBytes;
+	} while (offset < rows.size());
+
+	unsigned int adlerLow = 1;
+	unsigned int adlerHigh = 0;
+	for (size_t i = 0; i < rows.size(); i++)
+	{
+		adlerLow = (adlerLow + rows[i]) % 65521;
+		adlerHigh = (adlerHigh + adlerLow) % 65521;
+	}
+	AppendBigEndian(stream, (adlerHigh << 16) | adlerLow);
+	WriteChunk(file, "IDAT", stream);
+	WriteChunk(file, "IEND", std::vector<unsigned char>());
+
+	if (!file.good())
+	{
+		std::cout << "Could not write image file:" << filename << std::endl;
+		return(false);
+	}
+	return(true);
+}
+
+/***********************************************************
+ *  Compare()
+ *
+ *  This method is used for comparing an image with a
+ *  reference of the same size.  The SSIM compares the mean,
+ *  the contrast and the structure of the luma in each
+ *  window, and is averaged over all the windows.  The
+ *  difference image shows the reference dimmed, with the
+ *  largest channel difference of each pixel in red.
+ ***********************************************************/
+ImageComparer::COMPARISON ImageComparer::Compare(
+	const std::vector<unsigned char>& pixels,
+	const std::vector<unsigned char>& reference,
+	int width,
+	int height,
+	std::vector<unsigned char>* pDifference)
+{
+	COMPARISON comparison;
+	comparison.ssim = 1.0;
+	comparison.maxDifference = 0;
+	comparison.changedPixels = 0;
+
+	size_t pixelCount = (size_t)width * height;
+	std::vector<double> luma(pixelCount);
+	std::vector<double> referenceLuma(pixelCount);
+	if (NULL != pDifference)
+	{
+		pDifference->resize(pixelCount * 3);
+	}
+
+	for (size_t i = 0; i < pixelCount; i++)
+	{
+		const unsigned char* pPixel = &pixels[i * 3];
+		const unsigned char* pReference = &reference[i * 3];
+		int difference = 0;
+		for (int channel = 0; channel < 3; channel++)
+		{
+			difference = std::max(difference, std::abs((int)pPixel[channel] - (int)pReference[channel]));
+		}
+		comparison.maxDifference = std::max(comparison.maxDifference, difference);
+		if (difference > CHANGED_PIXEL_THRESHOLD)
+		{
+			comparison.changedPixels++;
+		}
+
+		luma[i] = GetLuma(pPixel);
+		referenceLuma[i] = GetLuma(pReference);
+		if (NULL != pDifference)
+		{
+			unsigned char dimmed = (unsigned char)(referenceLuma[i] * 0.3);
+			(*pDifference)[i * 3] = (unsigned char)std::min(255, dimmed + difference * DIFFERENCE_SCALE);
+			(*pDifference)[i * 3 + 1] = dimmed;
+			(*pDifference)[i * 3 + 2] = dimmed;
+		}
+	}
+
+	double ssimSum = 0.0;
+	int windowCount = 0;
+	const double windowPixels = SSIM_WINDOW * SSIM_WINDOW;
+	for (int top = 0; top + SSIM_WINDOW <= height; top += SSIM_STEP)
+	{
+		for (int left = 0; left + SSIM_WINDOW <= width; left += SSIM_STEP)
+		{
+			double sum = 0.0;
+			double referenceSum = 0.0;
+			double squareSum = 0.0;
+			double referenceSquareSum = 0.0;
+			double productSum = 0.0;
+			for (int y = top; y < top + SSIM_WINDOW; y++)
+			{
+				for (int x = left; x < left + SSIM_WINDOW; x++)
+				{
+					double value = luma[(size_t)y * width + x];
+					double referenceValue = referenceLuma[(size_t)y * width + x];
+					sum += value;
+					referenceSum += referenceValue;
+					squareSum += value * value;
+					referenceSquareSum += referenceValue * referenceValue;
+					productSum += value * referenceValue;
+				}
+			}
+
+			double mean = sum / windowPixels;
+			double referenceMean = referenceSum / windowPixels;
+			double variance = squareSum / windowPixels - mean * mean;
+			double referenceVariance = referenceSquareSum / windowPixels - referenceMean * referenceMean;
+			double covariance = productSum / windowPixels - mean * referenceMean;
+			ssimSum += ((2.0 * mean * referenceMean + SSIM_C1) * (2.0 * covariance + SSIM_C2)) /
+				((mean * mean + referenceMean * referenceMean + SSIM_C1) * (variance + referenceVariance + SSIM_C2));
+			windowCount++;
+		}
+	}
+	if (windowCount > 0)
+	{
+		comparison.ssim = ssimSum / windowCount;
+	}
+	return(comparison);
+}
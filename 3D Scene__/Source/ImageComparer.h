@@ -0,0 +1,53 @@
+///////////////////////////////////////////////////////////////////////////////
+// imagecomparer.h
+// ============
+// compare rendered frames with stored reference images
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  ImageComparer
+ *
+ *  This class compares a rendered frame with a reference
+ *  image the way a viewer would notice a change, rather
+ *  than by exact pixel values.  The structural similarity
+ *  (SSIM) of the luma is averaged over small overlapping
+ *  windows, so the dithering and rounding that differ
+ *  between drivers barely lower it, while a moved edge or a
+ *  changed shading falls clearly below 1.  A difference
+ *  image marks where the two differ.  The images are 8 bit
+ *  RGB with the rows bottom first, as read from OpenGL, and
+ *  are stored as PNG files.
+ ***********************************************************/
+class ImageComparer
+{
+public:
+	// result of comparing two images
+	struct COMPARISON
+	{
+		// mean structural similarity of the luma (1 = identical)
+		double ssim;
+		// largest difference of any colour channel
+		int maxDifference;
+		// pixels with a channel differing by more than the dithering
+		int changedPixels;
+	};
+
+	// load an image stored as PNG
+	static bool LoadPNG(const std::string& filename, std::vector<unsigned char>& pixels, int& width, int& height);
+	// store an image as PNG
+	static bool SavePNG(const std::string& filename, const std::vector<unsigned char>& pixels, int width, int height);
+
+	// compare an image with a reference image of the same size,
+	// optionally filling a difference image
+	static COMPARISON Compare(
+		const std::vector<unsigned char>& pixels,
+		const std::vector<unsigned char>& reference,
+		int width,
+		int height,
+		std::vector<unsigned char>* pDifference);
+};
@@ -0,0 +1,65 @@
+///////////////////////////////////////////////////////////////////////////////
+// inputqueue.cpp
+// ============
+// pass the window input events to the frame without locking
+///////////////////////////////////////////////////////////////////////////////
+
+#include "InputQueue.h"
+
+/***********************************************************
+ *  InputQueue()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+InputQueue::InputQueue()
+{
+	m_head.store(0, std::memory_order_relaxed);
+	m_tail.store(0, std::memory_order_relaxed);
+	m_droppedCount.store(0, std::memory_order_relaxed);
+}
+
+/***********************************************************
+ *  Push()
+ *
+ *  This method is used for adding an event at the tail of
+ *  the queue.  The head is read with acquire ordering, so a
+ *  slot freed by the consumer is not written before the
+ *  consumer has finished reading it, and the new tail is
+ *  published with release ordering after the event.
+ ***********************************************************/
+bool InputQueue::Push(const INPUT_EVENT& event)
+{
+	unsigned int tail = m_tail.load(std::memory_order_relaxed);
+	unsigned int head = m_head.load(std::memory_order_acquire);
+	if (tail - head >= CAPACITY)
+	{
+		m_droppedCount.fetch_add(1, std::memory_order_relaxed);
+		return(false);
+	}
+
+	m_events[tail & (CAPACITY - 1)] = event;
+	m_tail.store(tail + 1, std::memory_order_release);
+	return(true);
+}
+
+/***********************************************************
+ *  Pop()
+ *
+ *  This method is used for taking the event at the head of
+ *  the queue.  The tail is read with acquire ordering, so the
+ *  event it covers is fully written, and the slot is handed
+ *  back to the producer with release ordering.
+ ***********************************************************/
+bool InputQueue::Pop(INPUT_EVENT& event)
+{
+	unsigned int head = m_head.load(std::memory_order_relaxed);
+	unsigned int tail = m_tail.load(std::memory_order_acquire);
+	if (head == tail)
+	{
+		return(false);
+	}
+
+	event = m_events[head & (CAPACITY - 1)];
+	m_head.store(head + 1, std::memory_order_release);
+	return(true);
+}
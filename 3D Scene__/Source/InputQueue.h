@@ -0,0 +1,73 @@
+///////////////////////////////////////////////////////////////////////////////
+// inputqueue.h
+// ============
+// pass the window input events to the frame without locking
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+
+/***********************************************************
+ *  InputQueue
+ *
+ *  This class is a fixed size ring buffer of input events
+ *  with one producer and one consumer.  The GLFW callbacks
+ *  push the events as they arrive and the view manager pops
+ *  them once per frame, so the two sides can run on
+ *  different threads.  Each side only writes its own index
+ *  and publishes it with release ordering after the event it
+ *  covers, so no lock is needed.  The indices sit on their
+ *  own cache lines so the two sides do not contend for one.
+ ***********************************************************/
+class InputQueue
+{
+public:
+	// constructor
+	InputQueue();
+
+	// kinds of input events
+	enum EVENT_TYPE
+	{
+		EVENT_KEY_DOWN,
+		EVENT_KEY_UP,
+		EVENT_MOUSE_MOVE,
+		EVENT_MOUSE_BUTTON_DOWN,
+		EVENT_MOUSE_BUTTON_UP,
+		EVENT_SCROLL
+	};
+
+	// properties of one input event
+	struct INPUT_EVENT
+	{
+		EVENT_TYPE type;
+		// key or mouse button
+		int key;
+		// cursor position, or the scroll offsets
+		double x;
+		double y;
+	};
+
+	// events the queue holds - a power of two, so the indices
+	// can run freely and be masked into the buffer
+	static const unsigned int CAPACITY = 256;
+
+	// add an event from the producer side, counting it as
+	// dropped when the queue is full
+	bool Push(const INPUT_EVENT& event);
+	// take the oldest event from the consumer side
+	bool Pop(INPUT_EVENT& event);
+
+	// get the number of events dropped because the queue was full
+	unsigned int GetDroppedCount() const { return m_droppedCount.load(std::memory_order_relaxed); }
+
+private:
+	// ring buffer of the events
+	INPUT_EVENT m_events[CAPACITY];
+	// next event to pop, written by the consumer only
+	alignas(64) std::atomic<unsigned int> m_head;
+	// next slot to push into, written by the producer only
+	alignas(64) std::atomic<unsigned int> m_tail;
+	// events the producer could not push
+	std::atomic<unsigned int> m_droppedCount;
+};
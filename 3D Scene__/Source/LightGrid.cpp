@@ -0,0 +1,315 @@
+///////////////////////////////////////////////////////////////////////////////
+// lightgrid.cpp
+// ============
+// hash the point lights into a uniform grid to find the lights reaching a box
+///////////////////////////////////////////////////////////////////////////////
+
+#include "LightGrid.h"
+
+#include <algorithm>
+#include <cmath>
+
+// declare the global variables
+namespace
+{
+	// fraction of the brightest channel below which the light of
+	// an 8 bit display no longer changes
+	const float INFLUENCE_THRESHOLD = 1.0f / 256.0f;
+	// most cells a light is hashed into - larger spheres are
+	// tested by every query instead
+	const long long MAX_CELLS_PER_LIGHT = 64;
+	// fewest buckets of the hash table
+	const unsigned int MIN_BUCKETS = 64;
+}
+
+/***********************************************************
+ *  LightGrid()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+LightGrid::LightGrid()
+{
+	m_cellSize = 1.0f;
+	m_bucketMask = 0;
+	m_queryStamp = 0;
+}
+
+/***********************************************************
+ *  ComputeInfluenceRadius()
+ *
+ *  This method is used for finding the distance at which
+ *  the brightest channel of a light, divided by its
+ *  attenuation, falls to the display threshold.  A light
+ *  without distance attenuation reaches everywhere, and
+ *  one already below the threshold at its center reaches
+ *  nowhere.
+ ***********************************************************/
+float LightGrid::ComputeInfluenceRadius(glm::vec3 color, float constant, float linear, float quadratic)
+{
+	float brightness = glm::max(color.r, glm::max(color.g, color.b));
+	// the attenuation at which the light reaches the threshold
+	float cutoff = brightness / INFLUENCE_THRESHOLD;
+	if (constant >= cutoff)
+	{
+		return(0.0f);
+	}
+	if (quadratic > 0.0f)
+	{
+		// solve quadratic * d^2 + linear * d + constant = cutoff
+		float discriminant = linear * linear - 4.0f * quadratic * (constant - cutoff);
+		return((-linear + std::sqrt(discriminant)) / (2.0f * quadratic));
+	}
+	if (linear > 0.0f)
+	{
+		return((cutoff - constant) / linear);
+	}
+	return(-1.0f);
+}
+
+/***********************************************************
+ *  Build()
+ *
+ *  This method is used for listing every light in the cells
+ *  its sphere overlaps.  The entries are counted per bucket
+ *  first and then written into one array, so the table is
+ *  built without an allocation per cell or per light.  The
+ *  default cell is as wide as the average sphere, which
+ *  puts most lights into eight cells or fewer.
+ ***********************************************************/
+void LightGrid::Build(const std::vector<GRID_LIGHT>& lights, float cellSize)
+{
+	m_lights = lights;
+	m_globalLights.clear();
+	m_lightStamps.assign(lights.size(), 0);
+	m_queryStamp = 0;
+
+	if (cellSize <= 0.0f)
+	{
+		float diameterSum = 0.0f;
+		int boundedCount = 0;
+		for (int i = 0; i < (int)lights.size(); i++)
+		{
+			if (lights[i].radius > 0.0f)
+			{
+				diameterSum += 2.0f * lights[i].radius;
+				boundedCount++;
+			}
+		}
+		cellSize = (boundedCount > 0) ? diameterSum / boundedCount : 1.0f;
+	}
+	m_cellSize = glm::max(cellSize, 1.0e-3f);
+
+	// split the lights into the hashed and the global ones, and
+	// count the entries the hashed ones need
+	std::vector<unsigned char> bHashed(lights.size(), 0);
+	long long entryCount = 0;
+	for (int i = 0; i < (int)lights.size(); i++)
+	{
+		if (lights[i].radius == 0.0f)
+		{
+			continue;
+		}
+
+		long long cellCount = MAX_CELLS_PER_LIGHT + 1;
+		if (lights[i].radius > 0.0f)
+		{
+			glm::ivec3 cellMin;
+			glm::ivec3 cellMax;
+			glm::vec3 extent = glm::vec3(lights[i].radius);
+			GetCellRange(lights[i].position - extent, lights[i].position + extent, cellMin, cellMax);
+			glm::ivec3 cells = cellMax - cellMin + 1;
+			cellCount = (long long)cells.x * cells.y * cells.z;
+		}
+
+		if (cellCount > MAX_CELLS_PER_LIGHT)
+		{
+			m_globalLights.push_back(i);
+		}
+		else
+		{
+			bHashed[i] = 1;
+			entryCount += cellCount;
+		}
+	}
+
+	// about two buckets per entry keeps most buckets to one cell
+	unsigned int bucketCount = MIN_BUCKETS;
+	while (bucketCount < 2 * entryCount)
+	{
+		bucketCount *= 2;
+	}
+	m_bucketMask = bucketCount - 1;
+	m_bucketStarts.assign(bucketCount + 1, 0);
+	m_entries.resize((size_t)entryCount);
+
+	// count the entries of each bucket, then write them in place,
+	// using the starts of the next buckets as write positions
+	for (int pass = 0; pass < 2; pass++)
+	{
+		for (int i = 0; i < (int)lights.size(); i++)
+		{
+			if (!bHashed[i])
+			{
+				continue;
+			}
+
+			glm::ivec3 cellMin;
+			glm::ivec3 cellMax;
+			glm::vec3 extent = glm::vec3(lights[i].radius);
+			GetCellRange(lights[i].position - extent, lights[i].position + extent, cellMin, cellMax);
+			for (int z = cellMin.z; z <= cellMax.z; z++)
+			{
+				for (int y = cellMin.y; y <= cellMax.y; y++)
+				{
+					for (int x = cellMin.x; x <= cellMax.x; x++)
+					{
+						unsigned int bucket = HashCell(x, y, z);
+						if (pass == 0)
+						{
+							m_bucketStarts[bucket + 1]++;
+						}
+						else
+						{
+							m_entries[m_bucketStarts[bucket + 1]++] = i;
+						}
+					}
+				}
+			}
+		}
+
+		if (pass == 0)
+		{
+			// shift the starts by one bucket, so the write positions
+			// end up as the starts of the following buckets
+			for (unsigned int bucket = 1; bucket <= bucketCount; bucket++)
+			{
+				m_bucketStarts[bucket] += m_bucketStarts[bucket - 1];
+			}
+			for (unsigned int bucket = bucketCount; bucket > 0; bucket--)
+			{
+				m_bucketStarts[bucket] = m_bucketStarts[bucket - 1];
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  Query()
+ *
+ *  This method is used for collecting the lights whose
+ *  sphere overlaps a box.  The lights listed in the cells
+ *  the box covers are tested once each against the box,
+ *  which also drops the lights of other cells sharing a
+ *  bucket.  A box over more cells than there are lights
+ *  tests every light instead.
+ ***********************************************************/
+void LightGrid::Query(glm::vec3 boundsMin, glm::vec3 boundsMax, std::vector<int>& lights)
+{
+	lights.clear();
+
+	m_queryStamp++;
+	if (m_queryStamp == 0)
+	{
+		std::fill(m_lightStamps.begin(), m_lightStamps.end(), 0);
+		m_queryStamp = 1;
+	}
+
+	for (int i = 0; i < (int)m_globalLights.size(); i++)
+	{
+		if (Overlaps(m_globalLights[i], boundsMin, boundsMax))
+		{
+			lights.push_back(m_globalLights[i]);
+		}
+	}
+
+	glm::ivec3 cellMin;
+	glm::ivec3 cellMax;
+	GetCellRange(boundsMin, boundsMax, cellMin, cellMax);
+	glm::ivec3 cells = cellMax - cellMin + 1;
+	long long cellCount = (long long)cells.x * cells.y * cells.z;
+
+	if (cellCount > (long long)m_lights.size())
+	{
+		for (int i = 0; i < (int)m_lights.size(); i++)
+		{
+			if ((m_lights[i].radius > 0.0f) && Overlaps(i, boundsMin, boundsMax) &&
+				!std::binary_search(m_globalLights.begin(), m_globalLights.end(), i))
+			{
+				lights.push_back(i);
+			}
+		}
+	}
+	else
+	{
+		for (int z = cellMin.z; z <= cellMax.z; z++)
+		{
+			for (int y = cellMin.y; y <= cellMax.y; y++)
+			{
+				for (int x = cellMin.x; x <= cellMax.x; x++)
+				{
+					unsigned int bucket = HashCell(x, y, z);
+					for (int entry = m_bucketStarts[bucket]; entry < m_bucketStarts[bucket + 1]; entry++)
+					{
+						int light = m_entries[entry];
+						if (m_lightStamps[light] != m_queryStamp)
+						{
+							m_lightStamps[light] = m_queryStamp;
+							if (Overlaps(light, boundsMin, boundsMax))
+							{
+								lights.push_back(light);
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+
+	std::sort(lights.begin(), lights.end());
+}
+
+/***********************************************************
+ *  HashCell()
+ *
+ *  This method is used for mixing the coordinates of a cell
+ *  into a bucket of the table.
+ ***********************************************************/
+unsigned int LightGrid::HashCell(int x, int y, int z) const
+{
+	unsigned int hash = ((unsigned int)x * 73856093u) ^ ((unsigned int)y * 19349663u) ^ ((unsigned int)z * 83492791u);
+	return(hash & m_bucketMask);
+}
+
+/***********************************************************
+ *  GetCellRange()
+ *
+ *  This method is used for finding the first and the last
+ *  cell a box overlaps on each axis.
+ ***********************************************************/
+void LightGrid::GetCellRange(glm::vec3 boundsMin, glm::vec3 boundsMax, glm::ivec3& cellMin, glm::ivec3& cellMax) const
+{
+	for (int axis = 0; axis < 3; axis++)
+	{
+		cellMin[axis] = (int)std::floor(boundsMin[axis] / m_cellSize);
+		cellMax[axis] = glm::max((int)std::floor(boundsMax[axis] / m_cellSize), cellMin[axis]);
+	}
+}
+
+/***********************************************************
+ *  Overlaps()
+ *
+ *  This method is used for checking whether a light's
+ *  sphere reaches the closest point of a box.
+ ***********************************************************/
+bool LightGrid::Overlaps(int light, glm::vec3 boundsMin, glm::vec3 boundsMax) const
+{
+	const GRID_LIGHT& gridLight = m_lights[light];
+	if (gridLight.radius < 0.0f)
+	{
+		return(true);
+	}
+
+	glm::vec3 closest = glm::clamp(gridLight.position, boundsMin, boundsMax);
+	glm::vec3 offset = gridLight.position - closest;
+	return(glm::dot(offset, offset) <= gridLight.radius * gridLight.radius);
+}
@@ -0,0 +1,84 @@
+///////////////////////////////////////////////////////////////////////////////
+// lightgrid.h
+// ============
+// hash the point lights into a uniform grid to find the lights reaching a box
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  LightGrid
+ *
+ *  This class finds the point lights whose influence
+ *  reaches a box, such as the world bounds of a draw.  Each
+ *  light reaches a sphere around it, sized from its color
+ *  and attenuation.  The space is divided into cubic cells
+ *  of one size, and every light is listed in the cells its
+ *  sphere overlaps.  Only the occupied cells are stored, in
+ *  a table indexed by a hash of the cell coordinates, so the
+ *  grid covers any extent without allocating empty cells.
+ *  Lights without a finite sphere, or with a sphere over
+ *  too many cells, are kept apart and tested by every query.
+ ***********************************************************/
+class LightGrid
+{
+public:
+	// constructor
+	LightGrid();
+
+	// sphere of influence of one light
+	struct GRID_LIGHT
+	{
+		glm::vec3 position;
+		// distance beyond which the light adds nothing
+		// (negative = everywhere, 0 = nowhere)
+		float radius;
+	};
+
+	// get the distance at which a light of the passed in color
+	// and attenuation falls below what a display can show
+	static float ComputeInfluenceRadius(glm::vec3 color, float constant, float linear, float quadratic);
+
+	// hash the passed in lights into cells of the passed in
+	// size (0 = sized from the light radii)
+	void Build(const std::vector<GRID_LIGHT>& lights, float cellSize = 0.0f);
+	// collect the lights whose sphere overlaps a box, in
+	// ascending order
+	void Query(glm::vec3 boundsMin, glm::vec3 boundsMax, std::vector<int>& lights);
+
+	// get the number of lights the grid was built over
+	int GetLightCount() const { return (int)m_lights.size(); }
+	// get the edge length of a cell
+	float GetCellSize() const { return m_cellSize; }
+	// get the number of light entries over all the cells
+	int GetEntryCount() const { return (int)m_entries.size(); }
+
+private:
+	// get the bucket of a cell
+	unsigned int HashCell(int x, int y, int z) const;
+	// get the range of cells a box overlaps
+	void GetCellRange(glm::vec3 boundsMin, glm::vec3 boundsMax, glm::ivec3& cellMin, glm::ivec3& cellMax) const;
+	// check whether a light's sphere overlaps a box
+	bool Overlaps(int light, glm::vec3 boundsMin, glm::vec3 boundsMax) const;
+
+	// lights the grid was built over
+	std::vector<GRID_LIGHT> m_lights;
+	// lights tested by every query instead of hashed
+	std::vector<int> m_globalLights;
+	// edge length of a cell
+	float m_cellSize;
+	// light entries of each bucket - bucket b holds the entries
+	// from m_bucketStarts[b] up to m_bucketStarts[b + 1]
+	std::vector<int> m_bucketStarts;
+	std::vector<int> m_entries;
+	// buckets - 1, the bucket count being a power of two
+	unsigned int m_bucketMask;
+	// query each light was last collected by, so a light listed
+	// in several of the cells is collected once
+	std::vector<unsigned int> m_lightStamps;
+	unsigned int m_queryStamp;
+};
@@ -0,0 +1,712 @@
+///////////////////////////////////////////////////////////////////////////////
+// lightmapbaker.cpp
+// ============
+// bake the diffuse lighting of the static scene into a lightmap atlas
+///////////////////////////////////////////////////////////////////////////////
+
+#include "LightmapBaker.h"
+
+#include <glm/gtc/packing.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+// declare the global variables
+namespace
+{
+	// smallest tile, divisible into the 3x2 cells of the box and
+	// the 2x2 cells of the cylinder, and the largest one
+	const int BASE_TILE_SIZE = 48;
+	const int MAX_TILE_SIZE = 384;
+	// lightmap texels per world unit the tiles are sized for
+	const float TEXELS_PER_UNIT = 8.0f;
+	// widest atlas, in texels
+	const int MAX_ATLAS_WIDTH = 3072;
+	// distance shadow rays start off the surface, against acne
+	const float RAY_OFFSET = 0.01f;
+	// steps a shadow ray marches through the torus
+	const int TORUS_MARCH_STEPS = 48;
+	// radii of the torus of the basic meshes, around its z axis
+	const float TORUS_MAIN_RADIUS = 1.0f;
+	const float TORUS_TUBE_RADIUS = 0.2f;
+	const float PI = 3.14159265f;
+
+	// header of a saved atlas, followed by the surface tiles and
+	// the texels
+	const unsigned int LIGHTMAP_MAGIC = 0x50414D4C; // "LMAP"
+	const unsigned int LIGHTMAP_VERSION = 1;
+	struct LIGHTMAP_HEADER
+	{
+		unsigned int magic;
+		unsigned int version;
+		unsigned int signature;
+		int width;
+		int height;
+		int surfaceCount;
+	};
+
+	/***********************************************************
+	 *  GetCellGrid()
+	 *
+	 *  This function is used to get the columns and rows of
+	 *  cells the tile of a shape is divided into.
+	 ***********************************************************/
+	void GetCellGrid(int shape, int& columns, int& rows)
+	{
+		switch (shape)
+		{
+		case LightmapBaker::SHAPE_BOX:
+			columns = 3;
+			rows = 2;
+			break;
+		case LightmapBaker::SHAPE_CYLINDER:
+			columns = 2;
+			rows = 2;
+			break;
+		default:
+			columns = 1;
+			rows = 1;
+			break;
+		}
+	}
+
+	/***********************************************************
+	 *  GetCellCount()
+	 *
+	 *  This function is used to get the number of cells used
+	 *  by the unwrap of a shape.
+	 ***********************************************************/
+	int GetCellCount(int shape)
+	{
+		switch (shape)
+		{
+		case LightmapBaker::SHAPE_BOX:
+			return(6);
+		case LightmapBaker::SHAPE_CYLINDER:
+			return(3);
+		default:
+			return(1);
+		}
+	}
+
+	/***********************************************************
+	 *  UnwrapPoint()
+	 *
+	 *  This function is used to get the object space position
+	 *  and normal at a coordinate of a cell of the unwrap.  It
+	 *  is the inverse of LightmapCoordinate() in the fragment
+	 *  shader, and both have to be changed together.
+	 ***********************************************************/
+	void UnwrapPoint(int shape, int cell, glm::vec2 local, glm::vec3& position, glm::vec3& normal)
+	{
+		switch (shape)
+		{
+		case LightmapBaker::SHAPE_PLANE:
+			position = glm::vec3(local.x * 2.0f - 1.0f, 0.0f, local.y * 2.0f - 1.0f);
+			normal = glm::vec3(0.0f, 1.0f, 0.0f);
+			break;
+		case LightmapBaker::SHAPE_BOX:
+		{
+			// two cells per axis, the positive face first
+			int axis = cell / 2;
+			float side = (cell % 2 == 0) ? 1.0f : -1.0f;
+			position[axis] = 0.5f * side;
+			position[(axis + 1) % 3] = local.x - 0.5f;
+			position[(axis + 2) % 3] = local.y - 0.5f;
+			normal = glm::vec3(0.0f);
+			normal[axis] = side;
+			break;
+		}
+		case LightmapBaker::SHAPE_CYLINDER:
+			if (cell == 0)
+			{
+				float angle = (local.x - 0.5f) * 2.0f * PI;
+				normal = glm::vec3(cos(angle), 0.0f, sin(angle));
+				position = glm::vec3(normal.x, local.y, normal.z);
+			}
+			else
+			{
+				// the top cap, then the bottom one
+				position = glm::vec3(local.x * 2.0f - 1.0f, (cell == 1) ? 1.0f : 0.0f, local.y * 2.0f - 1.0f);
+				normal = glm::vec3(0.0f, (cell == 1) ? 1.0f : -1.0f, 0.0f);
+			}
+			break;
+		case LightmapBaker::SHAPE_TORUS:
+		{
+			float mainAngle = (local.x - 0.5f) * 2.0f * PI;
+			float tubeAngle = (local.y - 0.5f) * 2.0f * PI;
+			glm::vec3 radial = glm::vec3(cos(mainAngle), sin(mainAngle), 0.0f);
+			normal = radial * cos(tubeAngle) + glm::vec3(0.0f, 0.0f, sin(tubeAngle));
+			position = radial * TORUS_MAIN_RADIUS + normal * TORUS_TUBE_RADIUS;
+			break;
+		}
+		case LightmapBaker::SHAPE_SPHERE:
+		default:
+		{
+			float azimuth = (local.x - 0.5f) * 2.0f * PI;
+			float polar = local.y * PI;
+			normal = glm::vec3(sin(polar) * cos(azimuth), cos(polar), sin(polar) * sin(azimuth));
+			position = normal;
+			break;
+		}
+		}
+	}
+
+	/***********************************************************
+	 *  IntersectSlabs()
+	 *
+	 *  This function is used to clip a ray against a box,
+	 *  narrowing the passed in distance range to the part
+	 *  inside.  Returns false when the ray misses the box.
+	 ***********************************************************/
+	bool IntersectSlabs(glm::vec3 origin, glm::vec3 direction, glm::vec3 boundsMin, glm::vec3 boundsMax, float& tMin, float& tMax)
+	{
+		for (int axis = 0; axis < 3; axis++)
+		{
+			if (fabs(direction[axis]) < 1.0e-12f)
+			{
+				if ((origin[axis] < boundsMin[axis]) || (origin[axis] > boundsMax[axis]))
+				{
+					return(false);
+				}
+				continue;
+			}
+			float t0 = (boundsMin[axis] - origin[axis]) / direction[axis];
+			float t1 = (boundsMax[axis] - origin[axis]) / direction[axis];
+			tMin = std::max(tMin, std::min(t0, t1));
+			tMax = std::min(tMax, std::max(t0, t1));
+		}
+		return(tMin <= tMax);
+	}
+
+	/***********************************************************
+	 *  HitsQuadratic()
+	 *
+	 *  This function is used to check whether a root of
+	 *  a t^2 + b t + c lies within a distance range, returning
+	 *  the nearest such root.
+	 ***********************************************************/
+	bool HitsQuadratic(float a, float b, float c, float tMin, float tMax, float& t)
+	{
+		float discriminant = b * b - 4.0f * a * c;
+		if ((a <= 0.0f) || (discriminant < 0.0f))
+		{
+			return(false);
+		}
+		float root = sqrt(discriminant);
+		float t0 = (-b - root) / (2.0f * a);
+		float t1 = (-b + root) / (2.0f * a);
+		t = (t0 >= tMin) ? t0 : t1;
+		return((t >= tMin) && (t <= tMax));
+	}
+
+	/***********************************************************
+	 *  IntersectShape()
+	 *
+	 *  This function is used to check whether an object space
+	 *  ray hits a basic mesh shape within a distance range.
+	 *  The distances are in units of the passed in direction,
+	 *  so they match the world ray it was transformed from.
+	 ***********************************************************/
+	bool IntersectShape(int shape, glm::vec3 origin, glm::vec3 direction, float tMin, float tMax)
+	{
+		float t = 0.0f;
+		switch (shape)
+		{
+		case LightmapBaker::SHAPE_PLANE:
+		{
+			if (fabs(direction.y) < 1.0e-12f)
+			{
+				return(false);
+			}
+			t = -origin.y / direction.y;
+			glm::vec3 hit = origin + direction * t;
+			return((t >= tMin) && (t <= tMax) && (fabs(hit.x) <= 1.0f) && (fabs(hit.z) <= 1.0f));
+		}
+		case LightmapBaker::SHAPE_BOX:
+			return(IntersectSlabs(origin, direction, glm::vec3(-0.5f), glm::vec3(0.5f), tMin, tMax));
+		case LightmapBaker::SHAPE_CYLINDER:
+		{
+			// the side within the height, then the two caps
+			float a = direction.x * direction.x + direction.z * direction.z;
+			float b = 2.0f * (origin.x * direction.x + origin.z * direction.z);
+			float c = origin.x * origin.x + origin.z * origin.z - 1.0f;
+			float discriminant = b * b - 4.0f * a * c;
+			if ((a > 0.0f) && (discriminant >= 0.0f))
+			{
+				float root = sqrt(discriminant);
+				for (int i = 0; i < 2; i++)
+				{
+					t = (-b + ((i == 0) ? -root : root)) / (2.0f * a);
+					float y = origin.y + direction.y * t;
+					if ((t >= tMin) && (t <= tMax) && (y >= 0.0f) && (y <= 1.0f))
+					{
+						return(true);
+					}
+				}
+			}
+			if (fabs(direction.y) >= 1.0e-12f)
+			{
+				for (int i = 0; i < 2; i++)
+				{
+					t = ((float)i - origin.y) / direction.y;
+					glm::vec3 hit = origin + direction * t;
+					if ((t >= tMin) && (t <= tMax) && (hit.x * hit.x + hit.z * hit.z <= 1.0f))
+					{
+						return(true);
+					}
+				}
+			}
+			return(false);
+		}
+		case LightmapBaker::SHAPE_TORUS:
+		{
+			// march by the distance to the surface inside the bounds,
+			// in unit steps of an object space direction
+			float extent = TORUS_MAIN_RADIUS + TORUS_TUBE_RADIUS;
+			if (!IntersectSlabs(origin, direction,
+				glm::vec3(-extent, -extent, -TORUS_TUBE_RADIUS), glm::vec3(extent, extent, TORUS_TUBE_RADIUS), tMin, tMax))
+			{
+				return(false);
+			}
+			float length = glm::length(direction);
+			glm::vec3 unitDirection = direction / length;
+			float distance = tMin * length;
+			float endDistance = tMax * length;
+			for (int i = 0; (i < TORUS_MARCH_STEPS) && (distance <= endDistance); i++)
+			{
+				glm::vec3 p = origin + unitDirection * distance;
+				glm::vec2 tube = glm::vec2(glm::length(glm::vec2(p.x, p.y)) - TORUS_MAIN_RADIUS, p.z);
+				float surfaceDistance = glm::length(tube) - TORUS_TUBE_RADIUS;
+				if (surfaceDistance < 1.0e-3f)
+				{
+					return(true);
+				}
+				distance += surfaceDistance;
+			}
+			return(false);
+		}
+		case LightmapBaker::SHAPE_SPHERE:
+		default:
+			return(HitsQuadratic(glm::dot(direction, direction), 2.0f * glm::dot(origin, direction),
+				glm::dot(origin, origin) - 1.0f, tMin, tMax, t));
+		}
+	}
+
+	// mix the bytes of a value into a FNV-1a hash
+	void HashBytes(unsigned int& hash, const void* pData, size_t size)
+	{
+		const unsigned char* pBytes = (const unsigned char*)pData;
+		for (size_t i = 0; i < size; i++)
+		{
+			hash = (hash ^ pBytes[i]) * 16777619u;
+		}
+	}
+}
+
+/***********************************************************
+ *  LightmapBaker()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+LightmapBaker::LightmapBaker()
+{
+	m_pSurfaces = NULL;
+	m_pLights = NULL;
+	m_bOcclusion = false;
+	m_signature = 0;
+	m_width = 0;
+	m_height = 0;
+}
+
+/***********************************************************
+ *  ComputeSignature()
+ *
+ *  This method is used for hashing the shapes, placements
+ *  and occluder flags of the surfaces, the lights and the
+ *  bake options.  The hash is never 0, which marks an empty
+ *  atlas.
+ ***********************************************************/
+unsigned int LightmapBaker::ComputeSignature(
+	const std::vector<BAKE_SURFACE>& surfaces,
+	const BAKE_LIGHTS& lights,
+	bool bOcclusion)
+{
+	unsigned int hash = 2166136261u;
+	for (int i = 0; i < (int)surfaces.size(); i++)
+	{
+		HashBytes(hash, &surfaces[i].shape, sizeof(surfaces[i].shape));
+		HashBytes(hash, &surfaces[i].modelMatrix, sizeof(surfaces[i].modelMatrix));
+		HashBytes(hash, &surfaces[i].bOccluder, sizeof(surfaces[i].bOccluder));
+	}
+
+	HashBytes(hash, &lights.bDirectional, sizeof(lights.bDirectional));
+	HashBytes(hash, &lights.directionalDirection, sizeof(lights.directionalDirection));
+	HashBytes(hash, &lights.directionalDiffuse, sizeof(lights.directionalDiffuse));
+	for (int i = 0; i < (int)lights.pointPositions.size(); i++)
+	{
+		HashBytes(hash, &lights.pointPositions[i], sizeof(lights.pointPositions[i]));
+		HashBytes(hash, &lights.pointDiffuse[i], sizeof(lights.pointDiffuse[i]));
+	}
+	HashBytes(hash, &lights.bSpot, sizeof(lights.bSpot));
+	HashBytes(hash, &lights.spotPosition, sizeof(lights.spotPosition));
+	HashBytes(hash, &lights.spotDirection, sizeof(lights.spotDirection));
+	HashBytes(hash, &lights.spotCutOff, sizeof(lights.spotCutOff));
+	HashBytes(hash, &lights.spotOuterCutOff, sizeof(lights.spotOuterCutOff));
+	HashBytes(hash, &lights.spotDiffuse, sizeof(lights.spotDiffuse));
+
+	HashBytes(hash, &bOcclusion, sizeof(bOcclusion));
+	HashBytes(hash, &TEXELS_PER_UNIT, sizeof(TEXELS_PER_UNIT));
+	HashBytes(hash, &LIGHTMAP_VERSION, sizeof(LIGHTMAP_VERSION));
+	return((hash != 0) ? hash : 1);
+}
+
+/***********************************************************
+ *  Bake()
+ *
+ *  This method is used for sizing a tile for every baked
+ *  surface, packing the tiles into rows of the atlas from
+ *  the largest down, and baking them on all the cores.  The
+ *  threads take the next unbaked tile until none is left,
+ *  and each writes only the texels of its own tiles.
+ ***********************************************************/
+void LightmapBaker::Bake(const std::vector<BAKE_SURFACE>& surfaces, const BAKE_LIGHTS& lights, bool bOcclusion)
+{
+	auto bakeStart = std::chrono::steady_clock::now();
+
+	m_pSurfaces = &surfaces;
+	m_pLights = &lights;
+	m_bOcclusion = bOcclusion;
+	m_signature = ComputeSignature(surfaces, lights, bOcclusion);
+
+	// the tile grows in powers of two with the surface extent,
+	// which keeps the sizes multiples of the base tile
+	std::vector<int> bakedSurfaces;
+	std::vector<int> tileSizes(surfaces.size(), 0);
+	long long tileTexels = 0;
+	for (int i = 0; i < (int)surfaces.size(); i++)
+	{
+		if (surfaces[i].shape < 0)
+		{
+			continue;
+		}
+		glm::vec3 extent = surfaces[i].boundsMax - surfaces[i].boundsMin;
+		float area = 2.0f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+		float wantedSize = sqrt(area) * TEXELS_PER_UNIT;
+		int size = BASE_TILE_SIZE;
+		while ((size < wantedSize) && (size < MAX_TILE_SIZE))
+		{
+			size *= 2;
+		}
+		tileSizes[i] = size;
+		tileTexels += (long long)size * size;
+		bakedSurfaces.push_back(i);
+	}
+	std::stable_sort(bakedSurfaces.begin(), bakedSurfaces.end(), [&tileSizes](int a, int b) {
+		return tileSizes[a] > tileSizes[b];
+	});
+
+	// a roughly square atlas, in whole base tiles
+	m_width = MAX_TILE_SIZE;
+	while ((m_width < MAX_ATLAS_WIDTH) && ((long long)m_width * m_width < tileTexels))
+	{
+		m_width += MAX_TILE_SIZE;
+	}
+
+	// fill rows left to right, each as tall as its first tile
+	std::vector<ATLAS_TILE> tiles(surfaces.size());
+	int x = 0;
+	int y = 0;
+	int rowHeight = 0;
+	for (int i = 0; i < (int)bakedSurfaces.size(); i++)
+	{
+		int size = tileSizes[bakedSurfaces[i]];
+		if (x + size > m_width)
+		{
+			x = 0;
+			y += rowHeight;
+			rowHeight = 0;
+		}
+		tiles[bakedSurfaces[i]] = { x, y, size };
+		rowHeight = std::max(rowHeight, size);
+		x += size;
+	}
+	m_height = std::max(y + rowHeight, 1);
+
+	m_tiles.assign(surfaces.size(), glm::vec4(0.0f));
+	for (int i = 0; i < (int)bakedSurfaces.size(); i++)
+	{
+		const ATLAS_TILE& tile = tiles[bakedSurfaces[i]];
+		m_tiles[bakedSurfaces[i]] = glm::vec4(
+			(float)tile.x / m_width, (float)tile.y / m_height,
+			(float)tile.size / m_width, (float)tile.size / m_height);
+	}
+	m_texels.assign((size_t)m_width * m_height * 4, 0);
+
+	// shadow rays are tested against the occluders only
+	m_inverseModels.resize(surfaces.size());
+	m_occluderSurfaces.clear();
+	std::vector<BoundingVolumeHierarchy::BVH_BOUNDS> occluderBounds;
+	for (int i = 0; i < (int)surfaces.size(); i++)
+	{
+		m_inverseModels[i] = glm::inverse(surfaces[i].modelMatrix);
+		if (surfaces[i].bOccluder && (surfaces[i].shape >= 0))
+		{
+			BoundingVolumeHierarchy::BVH_BOUNDS bounds;
+			bounds.boundsMin = surfaces[i].boundsMin;
+			bounds.boundsMax = surfaces[i].boundsMax;
+			occluderBounds.push_back(bounds);
+			m_occluderSurfaces.push_back(i);
+		}
+	}
+	m_occluderBVH.Build(occluderBounds);
+
+	int threadCount = std::max(1, (int)std::thread::hardware_concurrency());
+	threadCount = std::min(threadCount, std::max(1, (int)bakedSurfaces.size()));
+	std::atomic<int> nextSurface(0);
+	auto worker = [&]() {
+		int next;
+		while ((next = nextSurface.fetch_add(1)) < (int)bakedSurfaces.size())
+		{
+			BakeSurface(bakedSurfaces[next], tiles[bakedSurfaces[next]]);
+		}
+	};
+	std::vector<std::thread> threads;
+	for (int i = 1; i < threadCount; i++)
+	{
+		threads.push_back(std::thread(worker));
+	}
+	worker();
+	for (int i = 0; i < (int)threads.size(); i++)
+	{
+		threads[i].join();
+	}
+
+	m_pSurfaces = NULL;
+	m_pLights = NULL;
+
+	double bakeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - bakeStart).count();
+	std::cout << "INFO: Baked lightmaps of " << bakedSurfaces.size() << " surfaces into a " << m_width << "x" << m_height
+		<< " atlas on " << threadCount << " threads in " << (int)bakeMs << " ms"
+		<< (bOcclusion ? " with" : " without") << " shadow rays" << std::endl;
+}
+
+/***********************************************************
+ *  BakeSurface()
+ *
+ *  This method is used for baking every texel of the tile of
+ *  a surface.  The texels of a cell are spread from edge to
+ *  edge of its part of the surface, so the shader samples
+ *  between the texel centers and never reads the next cell.
+ ***********************************************************/
+void LightmapBaker::BakeSurface(int surface, const ATLAS_TILE& tile)
+{
+	const BAKE_SURFACE& bakeSurface = (*m_pSurfaces)[surface];
+	int columns = 1;
+	int rows = 1;
+	GetCellGrid(bakeSurface.shape, columns, rows);
+	int cellWidth = tile.size / columns;
+	int cellHeight = tile.size / rows;
+	std::vector<int> candidates;
+
+	for (int cell = 0; cell < GetCellCount(bakeSurface.shape); cell++)
+	{
+		int cellX = tile.x + (cell % columns) * cellWidth;
+		int cellY = tile.y + (cell / columns) * cellHeight;
+		for (int j = 0; j < cellHeight; j++)
+		{
+			for (int i = 0; i < cellWidth; i++)
+			{
+				glm::vec2 local = glm::vec2((float)i / (cellWidth - 1), (float)j / (cellHeight - 1));
+				glm::vec3 position;
+				glm::vec3 normal;
+				UnwrapPoint(bakeSurface.shape, cell, local, position, normal);
+
+				glm::vec3 worldPosition = glm::vec3(bakeSurface.modelMatrix * glm::vec4(position, 1.0f));
+				glm::vec3 worldNormal = glm::normalize(bakeSurface.normalMatrix * normal);
+				glm::vec4 light = GatherLight(surface, worldPosition, worldNormal, candidates);
+
+				size_t texel = ((size_t)(cellY + j) * m_width + cellX + i) * 4;
+				for (int c = 0; c < 4; c++)
+				{
+					m_texels[texel + c] = glm::packHalf1x16(light[c]);
+				}
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  GatherLight()
+ *
+ *  This method is used for summing the diffuse light the
+ *  scene lights cast on a point, the same way the forward
+ *  shader does before multiplying by the material and the
+ *  texture - the spot light fades between its cut-offs and
+ *  no light falls off with distance.
+ ***********************************************************/
+glm::vec4 LightmapBaker::GatherLight(int surface, glm::vec3 position, glm::vec3 normal, std::vector<int>& candidates) const
+{
+	const BAKE_LIGHTS& lights = *m_pLights;
+	glm::vec3 origin = position + normal * RAY_OFFSET;
+	glm::vec3 irradiance = glm::vec3(0.0f);
+	float directionalVisibility = 1.0f;
+
+	if (lights.bDirectional)
+	{
+		glm::vec3 lightDirection = glm::normalize(-lights.directionalDirection);
+		float diffuse = std::max(glm::dot(normal, lightDirection), 0.0f);
+		if (IsOccluded(surface, origin, lightDirection, 1.0e30f, candidates))
+		{
+			directionalVisibility = 0.0f;
+		}
+		irradiance += lights.directionalDiffuse * diffuse * directionalVisibility;
+	}
+
+	for (int i = 0; i < (int)lights.pointPositions.size(); i++)
+	{
+		glm::vec3 toLight = lights.pointPositions[i] - position;
+		float diffuse = std::max(glm::dot(normal, glm::normalize(toLight)), 0.0f);
+		if ((diffuse > 0.0f) && !IsOccluded(surface, origin, toLight, 1.0f, candidates))
+		{
+			irradiance += lights.pointDiffuse[i] * diffuse;
+		}
+	}
+
+	if (lights.bSpot)
+	{
+		glm::vec3 toLight = lights.spotPosition - position;
+		glm::vec3 lightDirection = glm::normalize(toLight);
+		float theta = glm::dot(lightDirection, glm::normalize(-lights.spotDirection));
+		float intensity = glm::clamp((theta - lights.spotOuterCutOff) / (lights.spotCutOff - lights.spotOuterCutOff), 0.0f, 1.0f);
+		float diffuse = std::max(glm::dot(normal, lightDirection), 0.0f);
+		if ((theta >= lights.spotOuterCutOff) && (diffuse > 0.0f) && !IsOccluded(surface, origin, toLight, 1.0f, candidates))
+		{
+			irradiance += lights.spotDiffuse * diffuse * intensity;
+		}
+	}
+
+	return glm::vec4(irradiance, directionalVisibility);
+}
+
+/***********************************************************
+ *  IsOccluded()
+ *
+ *  This method is used for tracing a shadow ray.  The
+ *  hierarchy collects the occluders whose bounds the ray
+ *  crosses, and the ray is tested against the exact shape
+ *  of each in its object space.  The surface the ray starts
+ *  on is skipped, since the basic shapes are convex apart
+ *  from the torus and cannot shadow themselves.
+ ***********************************************************/
+bool LightmapBaker::IsOccluded(int surface, glm::vec3 origin, glm::vec3 direction, float maxDistance, std::vector<int>& candidates) const
+{
+	if (!m_bOcclusion)
+	{
+		return(false);
+	}
+
+	m_occluderBVH.QuerySegment(origin, direction, maxDistance, candidates);
+	for (int i = 0; i < (int)candidates.size(); i++)
+	{
+		int occluder = m_occluderSurfaces[candidates[i]];
+		if (occluder == surface)
+		{
+			continue;
+		}
+		const glm::mat4& inverseModel = m_inverseModels[occluder];
+		glm::vec3 objectOrigin = glm::vec3(inverseModel * glm::vec4(origin, 1.0f));
+		glm::vec3 objectDirection = glm::vec3(inverseModel * glm::vec4(direction, 0.0f));
+		if (IntersectShape((*m_pSurfaces)[occluder].shape, objectOrigin, objectDirection, 0.0f, maxDistance))
+		{
+			return(true);
+		}
+	}
+	return(false);
+}
+
+/***********************************************************
+ *  Save()
+ *
+ *  This method is used for writing the atlas into a file,
+ *  with its signature, size and the tiles of the surfaces.
+ ***********************************************************/
+bool LightmapBaker::Save(const std::string& filename) const
+{
+	if (m_signature == 0)
+	{
+		return(false);
+	}
+
+	std::ofstream file(filename, std::ios::binary);
+	if (!file.is_open())
+	{
+		std::cout << "Could not write lightmap file:" << filename << std::endl;
+		return(false);
+	}
+
+	LIGHTMAP_HEADER header;
+	memset(&header, 0, sizeof(header));
+	header.magic = LIGHTMAP_MAGIC;
+	header.version = LIGHTMAP_VERSION;
+	header.signature = m_signature;
+	header.width = m_width;
+	header.height = m_height;
+	header.surfaceCount = (int)m_tiles.size();
+	file.write((const char*)&header, sizeof(header));
+	file.write((const char*)m_tiles.data(), m_tiles.size() * sizeof(glm::vec4));
+	file.write((const char*)m_texels.data(), m_texels.size() * sizeof(unsigned short));
+
+	if (file.good())
+	{
+		std::cout << "INFO: Saved lightmaps to " << filename << ", "
+			<< (m_texels.size() * sizeof(unsigned short)) / 1024 << " KB" << std::endl;
+	}
+	return(file.good());
+}
+
+/***********************************************************
+ *  Load()
+ *
+ *  This method is used for reading an atlas saved for the
+ *  passed in signature.  The current atlas is kept when the
+ *  file is missing, damaged or was baked for another scene.
+ ***********************************************************/
+bool LightmapBaker::Load(const std::string& filename, unsigned int signature)
+{
+	std::ifstream file(filename, std::ios::binary);
+	if (!file.is_open())
+	{
+		return(false);
+	}
+
+	LIGHTMAP_HEADER header;
+	file.read((char*)&header, sizeof(header));
+	if (!file.good() || (header.magic != LIGHTMAP_MAGIC) || (header.version != LIGHTMAP_VERSION) ||
+		(header.signature != signature) || (header.width <= 0) || (header.height <= 0) || (header.surfaceCount < 0))
+	{
+		return(false);
+	}
+
+	std::vector<glm::vec4> tiles(header.surfaceCount);
+	std::vector<unsigned short> texels((size_t)header.width * header.height * 4);
+	file.read((char*)tiles.data(), tiles.size() * sizeof(glm::vec4));
+	file.read((char*)texels.data(), texels.size() * sizeof(unsigned short));
+	if (!file.good())
+	{
+		return(false);
+	}
+
+	m_signature = signature;
+	m_width = header.width;
+	m_height = header.height;
+	m_tiles.swap(tiles);
+	m_texels.swap(texels);
+	std::cout << "INFO: Loaded lightmaps from " << filename << ", " << m_width << "x" << m_height << " atlas" << std::endl;
+	return(true);
+}
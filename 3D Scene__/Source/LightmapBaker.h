@@ -0,0 +1,148 @@
+///////////////////////////////////////////////////////////////////////////////
+// lightmapbaker.h
+// ============
+// bake the diffuse lighting of the static scene into a lightmap atlas
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "BoundingVolumeHierarchy.h"
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  LightmapBaker
+ *
+ *  This class precomputes the diffuse irradiance the scene
+ *  lights cast on the static surfaces.  The basic meshes
+ *  share their texture coordinates between faces, so every
+ *  surface is unwrapped analytically instead - the box into
+ *  one cell per face, the cylinder into its side and caps,
+ *  and the sphere and torus by their two angles - and the
+ *  fragment shader finds the same cell and coordinate from
+ *  the object space position and normal.  Each surface gets
+ *  a square tile in one atlas, sized by its world extent.
+ *  The tiles are baked on all cores, optionally tracing a
+ *  shadow ray per light and texel through a hierarchy over
+ *  the surfaces.  A texel holds the irradiance in RGB and
+ *  the visibility of the directional light in alpha, which
+ *  masks its specular highlight.  The atlas is kept as half
+ *  floats and can be saved to a file and loaded back.
+ ***********************************************************/
+class LightmapBaker
+{
+public:
+	// constructor
+	LightmapBaker();
+
+	// shapes a surface can be unwrapped as, in the order of the
+	// basic meshes of the scene manager
+	enum SURFACE_SHAPE
+	{
+		SHAPE_PLANE,
+		SHAPE_BOX,
+		SHAPE_CYLINDER,
+		SHAPE_TORUS,
+		SHAPE_SPHERE
+	};
+
+	// properties for one surface of the scene
+	struct BAKE_SURFACE
+	{
+		// shape the surface is unwrapped as (-1 = not baked)
+		int shape;
+		glm::mat4 modelMatrix;
+		glm::mat3 normalMatrix;
+		// world bounds, sizing the tile and culling shadow rays
+		glm::vec3 boundsMin;
+		glm::vec3 boundsMax;
+		// whether the surface shadows the others
+		bool bOccluder;
+	};
+
+	// lights the irradiance is gathered from, matching the
+	// uniforms of the forward lighting shader
+	struct BAKE_LIGHTS
+	{
+		bool bDirectional;
+		glm::vec3 directionalDirection;
+		glm::vec3 directionalDiffuse;
+		std::vector<glm::vec3> pointPositions;
+		std::vector<glm::vec3> pointDiffuse;
+		bool bSpot;
+		glm::vec3 spotPosition;
+		glm::vec3 spotDirection;
+		float spotCutOff;
+		float spotOuterCutOff;
+		glm::vec3 spotDiffuse;
+	};
+
+	// get a hash of everything the lightmaps depend on, so a
+	// saved atlas is only used for the scene it was baked for
+	static unsigned int ComputeSignature(
+		const std::vector<BAKE_SURFACE>& surfaces,
+		const BAKE_LIGHTS& lights,
+		bool bOcclusion);
+
+	// bake the irradiance of the passed in surfaces into a new atlas
+	void Bake(const std::vector<BAKE_SURFACE>& surfaces, const BAKE_LIGHTS& lights, bool bOcclusion);
+	// write the atlas into a file
+	bool Save(const std::string& filename) const;
+	// read an atlas from a file - fails when it was baked for
+	// another signature
+	bool Load(const std::string& filename, unsigned int signature);
+
+	// get the signature of the current atlas (0 = none)
+	unsigned int GetSignature() const { return m_signature; }
+	// get the size of the atlas in texels
+	int GetWidth() const { return m_width; }
+	int GetHeight() const { return m_height; }
+	// get the RGBA half float texels of the atlas, rows bottom first
+	const std::vector<unsigned short>& GetTexels() const { return m_texels; }
+	// get the tile of a surface as the offset and size in
+	// texture coordinates - the size is zero when not baked
+	glm::vec4 GetTile(int surface) const { return m_tiles[surface]; }
+	// get the number of surfaces the atlas was baked for
+	int GetSurfaceCount() const { return (int)m_tiles.size(); }
+
+private:
+	// square area of the atlas holding one surface, in texels
+	struct ATLAS_TILE
+	{
+		int x;
+		int y;
+		int size;
+	};
+
+	// bake the tile of one surface into the atlas
+	void BakeSurface(int surface, const ATLAS_TILE& tile);
+	// get the irradiance and the directional light visibility
+	// at a world position of a surface
+	glm::vec4 GatherLight(int surface, glm::vec3 position, glm::vec3 normal, std::vector<int>& candidates) const;
+	// check whether anything but the passed in surface blocks a
+	// ray before the passed in distance along it
+	bool IsOccluded(int surface, glm::vec3 origin, glm::vec3 direction, float maxDistance, std::vector<int>& candidates) const;
+
+	// surfaces and lights of the bake in progress
+	const std::vector<BAKE_SURFACE>* m_pSurfaces;
+	const BAKE_LIGHTS* m_pLights;
+	bool m_bOcclusion;
+	// world to object transforms of the surfaces, for shadow rays
+	std::vector<glm::mat4> m_inverseModels;
+	// hierarchy over the occluding surfaces, and the surface of
+	// each of its objects
+	BoundingVolumeHierarchy m_occluderBVH;
+	std::vector<int> m_occluderSurfaces;
+	// signature the atlas was baked for
+	unsigned int m_signature;
+	// size of the atlas in texels
+	int m_width;
+	int m_height;
+	// RGBA half float texels of the atlas
+	std::vector<unsigned short> m_texels;
+	// tile of every surface in texture coordinates
+	std::vector<glm::vec4> m_tiles;
+};
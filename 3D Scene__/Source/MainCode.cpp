@@ -15,8 +15,31 @@
 #include "ViewManager.h"
 #include "ShapeMeshes.h"
 #include "ShaderManager.h"
+#include "RenderSettings.h"
+#include "RenderTimer.h"
+#include "HDRRenderTarget.h"
+#include "ResolutionScaler.h"
+#include "FramePacer.h"
+#include "CameraPath.h"
+#include "BoundingVolumeHierarchy.h"
+#include "AnimationSystem.h"
+#include "MeshImporter.h"
+#include "AmbientOcclusion.h"
+#include "ImageComparer.h"
+#include "ParticleSystem.h"
 #include "sw_version.h"
 
+#include <string>
+#include <chrono>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <map>
+
 // Namespace for declaring global variables
 namespace
 {
@@ -32,12 +55,121 @@ namespace
 	ShaderManager* g_ShaderManager = nullptr;
 	// view manager object for managing the 3D view setup and projection to 2D
 	ViewManager* g_ViewManager = nullptr;
+
+	// rendering options shared by the view and scene managers
+	RENDER_SETTINGS g_RenderSettings;
+	// frame timing collector for the rendering passes
+	RenderTimer g_RenderTimer;
+	// floating point target the scene is rendered into
+	HDRRenderTarget* g_HDRRenderTarget = nullptr;
+	// chooses the size of the floating point target from the
+	// frame timings when adaptive resolution is on
+	ResolutionScaler g_ResolutionScaler;
+	// decides when the main loop starts its next frame
+	FramePacer g_FramePacer;
+	// seconds between the frames rendered while the window is
+	// not focused, which only needs to show the scene
+	const double UNFOCUSED_FRAME_SECONDS = 0.1;
+
+	// number of frames measured per mode by the prepass benchmark,
+	// or 0 when the benchmark was not requested
+	int g_PrepassBenchmarkFrames = 0;
+	// number of frames measured per mode by the light count
+	// benchmark, or 0 when the benchmark was not requested
+	int g_LightBenchmarkFrames = 0;
+
+	// file the camera input is recorded to, if any
+	std::string g_RecordPathFile;
+	// file of a camera path replayed as a benchmark, if any
+	std::string g_ReplayPathFile;
+	// run the canonical camera path benchmarks
+	bool g_bBenchmarkPaths = false;
+	// run the bounding volume hierarchy benchmark
+	bool g_bBenchmarkBVH = false;
+	// tracks of the animation benchmark (0 = no benchmark)
+	int g_AnimationBenchmarkTracks = 0;
+	// mesh file measured by the import benchmark, if any
+	std::string g_MeshBenchmarkFile;
+	// frames per mode of the occlusion culling benchmark (0 = no benchmark)
+	int g_OcclusionBenchmarkFrames = 0;
+	// frames per mode of the multi-view benchmark (0 = no benchmark)
+	int g_ViewBenchmarkFrames = 0;
+	// frames per desk count of the office benchmark (0 = no benchmark)
+	int g_OfficeBenchmarkFrames = 0;
+	// frames per format of the vertex format benchmark (0 = no benchmark)
+	int g_VertexFormatBenchmarkFrames = 0;
+	// frames per mode of the transparency benchmark (0 = no benchmark)
+	int g_TransparencyBenchmarkFrames = 0;
+	// frames per scale of the resolution benchmark (0 = no benchmark)
+	int g_ResolutionBenchmarkFrames = 0;
+	// frames per mode of the lightmap benchmark (0 = no benchmark)
+	int g_LightmapBenchmarkFrames = 0;
+	// frames per mode of the light grid benchmark (0 = no benchmark)
+	int g_LightGridBenchmarkFrames = 0;
+	// bake the lightmaps at startup even when a saved atlas matches
+	bool g_bBakeLightmaps = false;
+	// frames per quality of the ambient occlusion benchmark (0 = no benchmark)
+	int g_AmbientOcclusionBenchmarkFrames = 0;
+	// frames per run of the particle benchmark (0 = no benchmark)
+	int g_ParticleBenchmarkFrames = 0;
+	// frames per normal transform of the normal benchmark (0 = no benchmark)
+	int g_NormalBenchmarkFrames = 0;
+	// snapshot file the prepared scene is mapped from, if any
+	std::string g_SnapshotFile;
+	// run the scene snapshot benchmark
+	bool g_bBenchmarkSnapshot = false;
+	// directory of the golden images and the timing baseline of
+	// the regression check (empty = no check)
+	std::string g_RegressionDirectory;
+	// store the rendered presets as the new golden images and
+	// timing baseline instead of comparing against them
+	bool g_bUpdateGolden = false;
+	// a preset of the regression check failed, which fails the run
+	bool g_bRegressionFailed = false;
+	// largest counts accepted for the count and frame options
+	const int MAX_COUNT_OPTION = 100000000;
+	// most point lights - 4 texels each in a texture buffer of
+	// the 65536 texels every GL 3.3 driver provides
+	const int MAX_POINT_LIGHT_OPTION = 16384;
+	// most MSAA samples requested, lowered to what the driver supports
+	const int MAX_MSAA_SAMPLES_OPTION = 32;
+
+	// render each view as a scene of its own, sharing nothing
+	// between the views - only used for the multi-view benchmark
+	bool g_bSeparateViewScenes = false;
 }
 
 // Function declarations - all functions that are called manually
 // need to be pre-declared at the beginning of the source code.
 bool InitializeGLFW();
 bool InitializeGLEW();
+void ParseCommandLine(int argc, char* argv[]);
+bool ParseOptionInt(const std::string& argument, size_t valueStart, int minValue, int maxValue, int& value);
+bool ParseOptionFloat(const std::string& argument, size_t valueStart, float minValue, float maxValue, float& value);
+bool ParseOptionSeed(const std::string& argument, size_t valueStart, unsigned int& value);
+void RenderFrame();
+void RunPrepassBenchmark(int frames);
+void RunLightBenchmark(int frames);
+void RunLightGridBenchmark(int frames);
+void RunOcclusionBenchmark(int frames);
+void RunViewBenchmark(int frames);
+void RunOfficeBenchmark(int frames);
+void RunVertexFormatBenchmark(int frames);
+void RunTransparencyBenchmark(int frames);
+void RunResolutionBenchmark(int frames);
+void RunLightmapBenchmark(int frames);
+void RunAmbientOcclusionBenchmark(int frames);
+void RunParticleBenchmark(int frames);
+void RunNormalBenchmark(int frames);
+void RunSnapshotBenchmark();
+void ReadFrontBuffer(std::vector<unsigned char>& pixels, int& width, int& height);
+double MeasureFrames(int frames, double* pAverageFragments);
+void RunPathBenchmark(const CameraPath& path, const std::string& name);
+void ReportFrameTimes(const std::string& name, std::vector<double>& frameTimes);
+void RunBVHBenchmark();
+void RunAnimationBenchmark(int trackCount);
+void RunMeshBenchmark(const std::string& filename);
+void RunRegressionCheck(const std::string& directory, bool bUpdateGolden);
 
 
 /***********************************************************
@@ -48,6 +180,28 @@ bool InitializeGLEW();
  ***********************************************************/
 int main(int argc, char* argv[])
 {
+	// read the rendering options passed on the command line
+	ParseCommandLine(argc, argv);
+
+	// the hierarchy benchmark runs on the CPU only, without a window
+	if (g_bBenchmarkBVH)
+	{
+		RunBVHBenchmark();
+		return(EXIT_SUCCESS);
+	}
+	// so does the animation benchmark
+	if (g_AnimationBenchmarkTracks > 0)
+	{
+		RunAnimationBenchmark(g_AnimationBenchmarkTracks);
+		return(EXIT_SUCCESS);
+	}
+	// and the mesh import benchmark
+	if (!g_MeshBenchmarkFile.empty())
+	{
+		RunMeshBenchmark(g_MeshBenchmarkFile);
+		return(EXIT_SUCCESS);
+	}
+
 	// if GLFW fails initialization, then terminate the application
 	if (InitializeGLFW() == false)
 	{
@@ -59,6 +213,8 @@ int main(int argc, char* argv[])
 	// try to create a new view manager object
 	g_ViewManager = new ViewManager(
 		g_ShaderManager);
+	g_ViewManager->SetRenderSettings(&g_RenderSettings);
+	g_ViewManager->SetRenderTimer(&g_RenderTimer);
 
 	// try to create the main display window
 	g_Window = g_ViewManager->CreateDisplayWindow(WINDOW_TITLE);
@@ -80,34 +236,165 @@ int main(int argc, char* argv[])
 
 	// try to create a new scene manager object and prepare the 3D scene
 	g_SceneManager = new SceneManager(g_ShaderManager);
+	g_SceneManager->SetRenderSettings(&g_RenderSettings);
+	g_SceneManager->SetRenderTimer(&g_RenderTimer);
+	g_SceneManager->SetSnapshotFile(g_SnapshotFile);
 	g_SceneManager->PrepareScene();
+	if (g_bBakeLightmaps)
+	{
+		g_SceneManager->BakeLightmaps();
+	}
+
+	// the GPU timer queries need the OpenGL context
+	g_RenderTimer.Initialize();
+
+	// create the floating point target and its resolve shader
+	g_HDRRenderTarget = new HDRRenderTarget();
+	g_HDRRenderTarget->Initialize();
+
+	// run the requested benchmark instead of the interactive loop
+	if (g_PrepassBenchmarkFrames > 0)
+	{
+		RunPrepassBenchmark(g_PrepassBenchmarkFrames);
+		glfwSetWindowShouldClose(g_Window, true);
+	}
+	if (g_LightBenchmarkFrames > 0)
+	{
+		RunLightBenchmark(g_LightBenchmarkFrames);
+		glfwSetWindowShouldClose(g_Window, true);
+	}
+	if (g_OcclusionBenchmarkFrames > 0)
+	{
+		RunOcclusionBenchmark(g_OcclusionBenchmarkFrames);
+		glfwSetWindowShouldClose(g_Window, true);
+	}
+	if (g_ViewBenchmarkFrames > 0)
+	{
+		RunViewBenchmark(g_ViewBenchmarkFrames);
+		glfwSetWindowShouldClose(g_Window, true);
+	}
+	if (g_OfficeBenchmarkFrames > 0)
+	{
+		RunOfficeBenchmark(g_OfficeBenchmarkFrames);
+		glfwSetWindowShouldClose(g_Window, true);
+	}
+	if (g_VertexFormatBenchmarkFrames > 0)
+	{
+		RunVertexFormatBenchmark(g_VertexFormatBenchmarkFrames);
+		glfwSetWindowShouldClose(g_Window, true);
+	}
+	if (g_TransparencyBenchmarkFrames > 0)
+	{
+		RunTransparencyBenchmark(g_TransparencyBenchmarkFrames);
+		glfwSetWindowShouldClose(g_Window, true);
+	}
+	if (g_ResolutionBenchmarkFrames > 0)
+	{
+		RunResolutionBenchmark(g_ResolutionBenchmarkFrames);
+		glfwSetWindowShouldClose(g_Window, true);
+	}
+	if (g_LightmapBenchmarkFrames > 0)
+	{
+		RunLightmapBenchmark(g_LightmapBenchmarkFrames);
+		glfwSetWindowShouldClose(g_Window, true);
+	}
+	if (g_LightGridBenchmarkFrames > 0)
+	{
+		RunLightGridBenchmark(g_LightGridBenchmarkFrames);
+		glfwSetWindowShouldClose(g_Window, true);
+	}
+	if (g_AmbientOcclusionBenchmarkFrames > 0)
+	{
+		RunAmbientOcclusionBenchmark(g_AmbientOcclusionBenchmarkFrames);
+		glfwSetWindowShouldClose(g_Window, true);
+	}
+	if (g_ParticleBenchmarkFrames > 0)
+	{
+		RunParticleBenchmark(g_ParticleBenchmarkFrames);
+		glfwSetWindowShouldClose(g_Window, true);
+	}
+	if (g_NormalBenchmarkFrames > 0)
+	{
+		RunNormalBenchmark(g_NormalBenchmarkFrames);
+		glfwSetWindowShouldClose(g_Window, true);
+	}
+	if (g_bBenchmarkSnapshot)
+	{
+		RunSnapshotBenchmark();
+		glfwSetWindowShouldClose(g_Window, true);
+	}
+	if (!g_ReplayPathFile.empty())
+	{
+		CameraPath path;
+		if (path.Load(g_ReplayPathFile))
+		{
+			RunPathBenchmark(path, g_ReplayPathFile);
+		}
+		glfwSetWindowShouldClose(g_Window, true);
+	}
+	if (!g_RegressionDirectory.empty())
+	{
+		RunRegressionCheck(g_RegressionDirectory, g_bUpdateGolden);
+		glfwSetWindowShouldClose(g_Window, true);
+	}
+	if (g_bBenchmarkPaths)
+	{
+		for (int i = 0; i < CameraPath::GetBenchmarkPathCount(); i++)
+		{
+			CameraPath path;
+			CameraPath::CreateBenchmarkPath(i, path);
+			RunPathBenchmark(path, CameraPath::GetBenchmarkPathName(i));
+		}
+		glfwSetWindowShouldClose(g_Window, true);
+	}
+
+	// record the live camera input when requested
+	if (!g_RecordPathFile.empty())
+	{
+		g_ViewManager->StartRecording(g_RecordPathFile);
+	}
 
 	// loop will keep running until the application is closed 
 	// or until an error has occurred
 	while (!glfwWindowShouldClose(g_Window))
 	{
-		// Enable z-depth
-		glEnable(GL_DEPTH_TEST);
+		// a minimized window sleeps until an event arrives
+		if (glfwGetWindowAttrib(g_Window, GLFW_ICONIFIED))
+		{
+			glfwWaitEvents();
+			g_FramePacer.Reset();
+			continue;
+		}
 
-		// Clear the frame and z buffers
-		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		if (glfwGetWindowAttrib(g_Window, GLFW_FOCUSED))
+		{
+			g_FramePacer.SetMode(g_RenderSettings.presentMode, g_RenderSettings.frameRateLimit);
+			g_FramePacer.WaitForNextFrame();
 
-		// convert from 3D object space to 2D view
-		g_ViewManager->PrepareSceneView();
-
-		// refresh the 3D scene
-		g_SceneManager->RenderScene();
+			// query the latest GLFW events right before rendering,
+			// so the frame uses the freshest input
+			glfwPollEvents();
+		}
+		else
+		{
+			// an unfocused window only renders a few frames a second
+			glfwWaitEventsTimeout(UNFOCUSED_FRAME_SECONDS);
+			g_FramePacer.Reset();
+		}
 
-
-		// Flips the the back buffer with the front buffer every frame.
-		glfwSwapBuffers(g_Window);
-
-		// query the latest GLFW events
-		glfwPollEvents();
+		RenderFrame();
+		g_FramePacer.EndFrame();
 	}
 
+	// save the recorded camera input
+	g_ViewManager->StopRecording();
+
 	// clear the allocated manager objects from memory
+	if (NULL != g_HDRRenderTarget)
+	{
+		delete g_HDRRenderTarget;
+		g_HDRRenderTarget = NULL;
+	}
 	if (NULL != g_SceneManager)
 	{
 		delete g_SceneManager;
@@ -124,8 +411,1883 @@ int main(int argc, char* argv[])
 		g_ShaderManager = NULL;
 	}
 
-	// Terminates the program successfully
-	exit(EXIT_SUCCESS); 
+	// Terminates the program, failed when the rendering regressed
+	exit(g_bRegressionFailed ? EXIT_FAILURE : EXIT_SUCCESS); 
+}
+
+/***********************************************************
+ *	RenderFrame()
+ *
+ *  This function is used to render and present one frame
+ *  of the 3D scene.  With HDR enabled the scene is rendered
+ *  into the floating point target, which is then tone mapped
+ *  into the window.  In multi-view mode every view renders
+ *  into its own rectangle of the same target.  The target
+ *  can be smaller than the window by the resolution scale,
+ *  which adaptive resolution chooses from the timings of the
+ *  previous frames, and is then upscaled by the resolve.
+ ***********************************************************/
+void RenderFrame()
+{
+	int width = 0;
+	int height = 0;
+	glfwGetFramebufferSize(g_Window, &width, &height);
+
+	// a minimized window has nothing to draw into
+	if ((width <= 0) || (height <= 0))
+	{
+		return;
+	}
+
+	g_RenderTimer.BeginFrame();
+
+	int renderWidth = width;
+	int renderHeight = height;
+	if (g_RenderSettings.bHDR)
+	{
+		float scale = glm::clamp(g_RenderSettings.resolutionScale, 0.05f, 1.0f);
+		renderWidth = glm::max(1, (int)(width * scale + 0.5f));
+		renderHeight = glm::max(1, (int)(height * scale + 0.5f));
+		g_RenderTimer.SetCounter("resolution scale", scale);
+
+		// the deferred path copies its depth into the target,
+		// which only works with a single sample
+		int samples = g_RenderSettings.bDeferredShading ? 1 : g_RenderSettings.msaaSamples;
+		g_HDRRenderTarget->Bind(renderWidth, renderHeight, samples);
+	}
+	// the passes size their own targets from the viewport
+	glViewport(0, 0, renderWidth, renderHeight);
+
+	// Clear the frame and z buffers - the depth test and clear
+	// color are set once with the window, and every pass that
+	// changes them restores them
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	// convert from 3D object space to 2D view
+	g_ViewManager->PrepareSceneView();
+
+	// report the object under the cursor when it is clicked
+	glm::vec3 rayOrigin;
+	glm::vec3 rayDirection;
+	if (g_ViewManager->GetPickRay(rayOrigin, rayDirection))
+	{
+		float distance = 0.0f;
+		int draw = g_SceneManager->PickDraw(rayOrigin, rayDirection, distance);
+		if (draw >= 0)
+		{
+			const SceneManager::OBJECT_DRAW& picked = g_SceneManager->GetDraw(draw);
+			std::cout << "INFO: Picked draw " << draw << " (material " << picked.materialTag
+				<< ", texture " << picked.textureTag << ") at distance " << distance << std::endl;
+		}
+		else
+		{
+			std::cout << "INFO: Picked nothing" << std::endl;
+		}
+	}
+
+	// refresh the 3D scene
+	g_SceneManager->SetAnimationTime(g_ViewManager->GetAnimationTime());
+	std::vector<SCENE_VIEW> views;
+	g_ViewManager->GetSceneViews(renderWidth, renderHeight, views);
+	if (g_bSeparateViewScenes)
+	{
+		for (int i = 0; i < (int)views.size(); i++)
+		{
+			g_SceneManager->SetViews(std::vector<SCENE_VIEW>(1, views[i]));
+			g_SceneManager->RenderScene();
+		}
+	}
+	else
+	{
+		g_SceneManager->SetViews(views);
+		g_SceneManager->RenderScene();
+	}
+
+	if (g_RenderSettings.bHDR)
+	{
+		// the overdraw counts are shown unmapped
+		int toneMapOperator = g_RenderSettings.bShowOverdraw ?
+			HDRRenderTarget::TONE_MAP_NONE : g_RenderSettings.toneMapOperator;
+
+		g_RenderTimer.BeginPass("resolve");
+		g_HDRRenderTarget->Resolve(g_RenderSettings.exposure, toneMapOperator,
+			width, height, g_RenderSettings.upscaleSharpness);
+		g_RenderTimer.EndPass();
+	}
+
+	// Flips the the back buffer with the front buffer every frame.
+	glfwSwapBuffers(g_Window);
+
+	g_RenderTimer.EndFrame();
+
+	// choose the scale of the next frames from the timings of this one
+	if (g_RenderSettings.bHDR && g_RenderSettings.bAdaptiveResolution)
+	{
+		g_ResolutionScaler.SetFrameBudget(g_RenderSettings.frameBudgetMs);
+		g_ResolutionScaler.SetScaleRange(g_RenderSettings.minResolutionScale, 1.0f);
+		g_ResolutionScaler.SetScale(g_RenderSettings.resolutionScale);
+		g_ResolutionScaler.AddFrameTiming(g_RenderTimer.GetLastCpuMs(), g_RenderTimer.GetLastGpuMs());
+		g_RenderSettings.resolutionScale = g_ResolutionScaler.GetScale();
+	}
+}
+
+/***********************************************************
+ *	MeasureFrames()
+ *
+ *  This function is used to render the default view for the
+ *  passed in number of frames after a short warmup, waiting
+ *  for the GPU at the end of every frame so the timing
+ *  includes the GPU work.  The average frame time in
+ *  milliseconds is returned, and the average number of
+ *  shaded fragments is written to the passed in pointer.
+ ***********************************************************/
+double MeasureFrames(int frames, double* pAverageFragments)
+{
+	const int WARMUP_FRAMES = 10;
+
+	for (int i = 0; i < WARMUP_FRAMES; i++)
+	{
+		RenderFrame();
+		glFinish();
+	}
+	g_RenderTimer.ResetAverages();
+
+	double totalFragments = 0.0;
+	double totalMs = 0.0;
+	for (int i = 0; i < frames; i++)
+	{
+		auto frameStart = std::chrono::steady_clock::now();
+		RenderFrame();
+		glFinish();
+		totalMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count();
+
+		// the count read back is from the previous frame, which
+		// rendered the same view in the same mode
+		totalFragments += (double)g_SceneManager->GetShadedFragmentCount();
+		glfwPollEvents();
+	}
+
+	if (NULL != pAverageFragments)
+	{
+		*pAverageFragments = totalFragments / frames;
+	}
+	return(totalMs / frames);
+}
+
+/***********************************************************
+ *	RunPrepassBenchmark()
+ *
+ *  This function is used to compare the number of shaded
+ *  fragments and the frame time with the depth prepass off
+ *  and on.  Each mode renders the default view for the
+ *  passed in number of frames, waiting for the GPU at the
+ *  end of every frame so the timing includes the GPU work.
+ *  Run it with LIBGL_ALWAYS_SOFTWARE=1 for llvmpipe.
+ ***********************************************************/
+void RunPrepassBenchmark(int frames)
+{
+	double averageFragments[2] = { 0.0, 0.0 };
+	double averageFrameMs[2] = { 0.0, 0.0 };
+
+	std::cout << "INFO: Prepass benchmark on " << glGetString(GL_RENDERER)
+		<< ", " << frames << " frames per mode" << std::endl;
+
+	// the benchmark measures the rendering cost, not the display rate
+	glfwSwapInterval(0);
+
+	for (int mode = 0; mode < 2; mode++)
+	{
+		g_RenderSettings.bDepthPrepass = (mode == 1);
+		averageFrameMs[mode] = MeasureFrames(frames, &averageFragments[mode]);
+	}
+
+	std::cout << std::fixed << std::setprecision(3);
+	std::cout << "BENCHMARK: prepass off - shaded fragments " << (long long)averageFragments[0]
+		<< ", frame " << averageFrameMs[0] << " ms" << std::endl;
+	std::cout << "BENCHMARK: prepass on  - shaded fragments " << (long long)averageFragments[1]
+		<< ", frame " << averageFrameMs[1] << " ms" << std::endl;
+	if (averageFragments[1] > 0.0)
+	{
+		std::cout << "BENCHMARK: fragment shading reduced by "
+			<< (averageFragments[0] / averageFragments[1]) << "x" << std::endl;
+	}
+	std::cout << std::defaultfloat << std::setprecision(6);
+
+	g_RenderSettings.bDepthPrepass = false;
+}
+
+/***********************************************************
+ *	RunLightBenchmark()
+ *
+ *  This function is used to compare the frame time of the
+ *  forward and the deferred shading paths as the number of
+ *  point lights grows.  Each light count and path renders
+ *  the default view for the passed in number of frames.
+ ***********************************************************/
+void RunLightBenchmark(int frames)
+{
+	const int LIGHT_COUNTS[] = { 5, 100, 1000 };
+	const int LIGHT_COUNT_TOTAL = sizeof(LIGHT_COUNTS) / sizeof(LIGHT_COUNTS[0]);
+
+	bool bDeferredShading = g_RenderSettings.bDeferredShading;
+	int pointLightCount = g_RenderSettings.pointLightCount;
+
+	std::cout << "INFO: Light benchmark on " << glGetString(GL_RENDERER)
+		<< ", " << frames << " frames per mode" << std::endl;
+
+	// the benchmark measures the rendering cost, not the display rate
+	glfwSwapInterval(0);
+
+	std::cout << std::fixed << std::setprecision(3);
+	for (int i = 0; i < LIGHT_COUNT_TOTAL; i++)
+	{
+		g_RenderSettings.pointLightCount = LIGHT_COUNTS[i];
+
+		g_RenderSettings.bDeferredShading = false;
+		double forwardMs = MeasureFrames(frames, NULL);
+		g_RenderSettings.bDeferredShading = true;
+		double deferredMs = MeasureFrames(frames, NULL);
+
+		std::cout << "BENCHMARK: " << std::setw(4) << LIGHT_COUNTS[i] << " point lights - forward "
+			<< forwardMs << " ms, deferred " << deferredMs << " ms" << std::endl;
+	}
+	std::cout << std::defaultfloat << std::setprecision(6);
+
+	g_RenderSettings.bDeferredShading = bDeferredShading;
+	g_RenderSettings.pointLightCount = pointLightCount;
+}
+
+/***********************************************************
+ *	RunLightGridBenchmark()
+ *
+ *  This function is used to compare looping over every
+ *  additional point light against the per draw light lists
+ *  of the light grid.  The lights are the lamps of a
+ *  generated office followed by lights scattered over it,
+ *  and each light count is measured with the culling off
+ *  and on, along with the lights a draw was passed.
+ ***********************************************************/
+void RunLightGridBenchmark(int frames)
+{
+	const int BENCHMARK_DESKS = 100;
+	const int LIGHT_COUNTS[] = { 10, 100, 1000 };
+	const int LIGHT_COUNT_TOTAL = sizeof(LIGHT_COUNTS) / sizeof(LIGHT_COUNTS[0]);
+
+	bool bLightCulling = g_RenderSettings.bLightCulling;
+	int pointLightCount = g_RenderSettings.pointLightCount;
+
+	std::cout << "INFO: Light grid benchmark on " << glGetString(GL_RENDERER) << ", " << frames
+		<< " frames per mode, " << BENCHMARK_DESKS << " desks" << std::endl;
+
+	// the benchmark measures the rendering cost, not the display rate
+	glfwSwapInterval(0);
+	g_SceneManager->GenerateOffice(BENCHMARK_DESKS, g_RenderSettings.officeSeed);
+
+	std::cout << std::fixed << std::setprecision(3);
+	for (int i = 0; i < LIGHT_COUNT_TOTAL; i++)
+	{
+		g_RenderSettings.pointLightCount = LIGHT_COUNTS[i];
+		for (int culling = 0; culling < 2; culling++)
+		{
+			g_RenderSettings.bLightCulling = (culling == 1);
+			double frameMs = MeasureFrames(frames, NULL);
+
+			std::cout << "BENCHMARK: " << std::setw(4) << LIGHT_COUNTS[i] << " point lights, culling "
+				<< (g_RenderSettings.bLightCulling ? "on " : "off") << " - lights per draw "
+				<< g_RenderTimer.GetCounter("lights per draw") << ", cpu " << g_RenderTimer.GetAverageCpuMs()
+				<< " ms, gpu " << g_RenderTimer.GetAverageGpuMs() << " ms, frame " << frameMs << " ms" << std::endl;
+		}
+	}
+	std::cout << std::defaultfloat << std::setprecision(6);
+
+	g_RenderSettings.bLightCulling = bLightCulling;
+	g_RenderSettings.pointLightCount = pointLightCount;
+	g_SceneManager->GenerateOffice(g_RenderSettings.officeDeskCount, g_RenderSettings.officeSeed);
+}
+
+/***********************************************************
+ *	RunOcclusionBenchmark()
+ *
+ *  This function is used to compare the frame time with the
+ *  Hi-Z occlusion culling off and on, and to report how many
+ *  of the draws in the frustum were culled as occluded.  The
+ *  warmup frames let the first depth readback land.
+ ***********************************************************/
+void RunOcclusionBenchmark(int frames)
+{
+	bool bOcclusionCulling = g_RenderSettings.bOcclusionCulling;
+
+	std::cout << "INFO: Occlusion benchmark on " << glGetString(GL_RENDERER)
+		<< ", " << frames << " frames per mode" << std::endl;
+
+	// the benchmark measures the rendering cost, not the display rate
+	glfwSwapInterval(0);
+
+	double averageFrameMs[2] = { 0.0, 0.0 };
+	int visibleDraws[2] = { 0, 0 };
+	int occludedDraws[2] = { 0, 0 };
+	for (int mode = 0; mode < 2; mode++)
+	{
+		g_RenderSettings.bOcclusionCulling = (mode == 1);
+		averageFrameMs[mode] = MeasureFrames(frames, NULL);
+		// the view is fixed, so the last frame stands for all
+		visibleDraws[mode] = g_SceneManager->GetVisibleDrawCount();
+		occludedDraws[mode] = g_SceneManager->GetOccludedDrawCount();
+	}
+
+	std::cout << std::fixed << std::setprecision(3);
+	for (int mode = 0; mode < 2; mode++)
+	{
+		std::cout << "BENCHMARK: occlusion culling " << ((mode == 1) ? "on " : "off") << " - drawn "
+			<< visibleDraws[mode] << " of " << g_SceneManager->GetDrawCount() << ", occluded "
+			<< occludedDraws[mode] << ", frame " << averageFrameMs[mode] << " ms" << std::endl;
+	}
+	std::cout << "BENCHMARK: net frame time change " << std::showpos
+		<< (averageFrameMs[1] - averageFrameMs[0]) << " ms" << std::noshowpos << std::endl;
+	std::cout << std::defaultfloat << std::setprecision(6);
+
+	g_RenderSettings.bOcclusionCulling = bOcclusionCulling;
+}
+
+/***********************************************************
+ *	RunViewBenchmark()
+ *
+ *  This function is used to compare the frame time of the
+ *  camera view alone with the four views of multi-view mode,
+ *  rendered once in a single scene pass that shares the
+ *  shadow maps and light setup, and once as four separate
+ *  scene passes.  The frame timer reports the cull and lit
+ *  passes of each view while the shared mode runs.
+ ***********************************************************/
+void RunViewBenchmark(int frames)
+{
+	bool bMultiView = g_RenderSettings.bMultiView;
+
+	std::cout << "INFO: Multi-view benchmark on " << glGetString(GL_RENDERER)
+		<< ", " << frames << " frames per mode" << std::endl;
+
+	// the benchmark measures the rendering cost, not the display rate
+	glfwSwapInterval(0);
+
+	const char* MODE_NAMES[] = { "1 view           ", "4 views shared   ", "4 views separate " };
+	double averageFrameMs[3] = { 0.0, 0.0, 0.0 };
+	int visibleDraws[3] = { 0, 0, 0 };
+	for (int mode = 0; mode < 3; mode++)
+	{
+		g_RenderSettings.bMultiView = (mode > 0);
+		g_bSeparateViewScenes = (mode == 2);
+		averageFrameMs[mode] = MeasureFrames(frames, NULL);
+		visibleDraws[mode] = g_SceneManager->GetVisibleDrawCount();
+	}
+	g_bSeparateViewScenes = false;
+
+	std::cout << std::fixed << std::setprecision(3);
+	for (int mode = 0; mode < 3; mode++)
+	{
+		std::cout << "BENCHMARK: " << MODE_NAMES[mode] << "- frame " << averageFrameMs[mode] << " ms";
+		if (mode < 2)
+		{
+			// the separate mode only keeps the draws of its last view
+			std::cout << ", drawn " << visibleDraws[mode];
+		}
+		std::cout << std::endl;
+	}
+	if (averageFrameMs[2] > 0.0)
+	{
+		std::cout << "BENCHMARK: shared views take " << (averageFrameMs[1] / averageFrameMs[2])
+			<< "x the time of separate views" << std::endl;
+	}
+	std::cout << std::defaultfloat << std::setprecision(6);
+
+	g_RenderSettings.bMultiView = bMultiView;
+}
+
+/***********************************************************
+ *	RunOfficeBenchmark()
+ *
+ *  This function is used to measure how the renderer scales
+ *  with the size of the generated office.  Every desk count
+ *  of the sweep renders the default view for the passed in
+ *  number of frames and reports the draws per frame, the
+ *  CPU frame time and the summed GPU pass time.
+ ***********************************************************/
+void RunOfficeBenchmark(int frames)
+{
+	const int DESK_COUNTS[] = { 1, 10, 100, 1000, 10000 };
+	const int DESK_COUNT_TOTAL = sizeof(DESK_COUNTS) / sizeof(DESK_COUNTS[0]);
+
+	std::cout << "INFO: Office benchmark on " << glGetString(GL_RENDERER)
+		<< ", " << frames << " frames per desk count, seed " << g_RenderSettings.officeSeed << std::endl;
+
+	// the benchmark measures the rendering cost, not the display rate
+	glfwSwapInterval(0);
+
+	for (int i = 0; i < DESK_COUNT_TOTAL; i++)
+	{
+		g_SceneManager->GenerateOffice(DESK_COUNTS[i], g_RenderSettings.officeSeed);
+		double frameMs = MeasureFrames(frames, NULL);
+
+		std::cout << std::fixed << std::setprecision(3);
+		std::cout << "BENCHMARK: " << std::setw(5) << DESK_COUNTS[i] << " desks - draws "
+			<< g_SceneManager->GetVisibleDrawCount() << " of " << g_SceneManager->GetDrawCount()
+			<< " per frame, cpu " << g_RenderTimer.GetAverageCpuMs() << " ms, gpu "
+			<< g_RenderTimer.GetAverageGpuMs() << " ms, frame " << frameMs << " ms" << std::endl;
+		std::cout << std::defaultfloat << std::setprecision(6);
+	}
+
+	g_SceneManager->GenerateOffice(g_RenderSettings.officeDeskCount, g_RenderSettings.officeSeed);
+}
+
+/***********************************************************
+ *	RunVertexFormatBenchmark()
+ *
+ *  This function is used to compare the float and the packed
+ *  vertex formats.  Every mouse of an office is replaced by
+ *  a finely tessellated sphere, so that fetching its vertices
+ *  dominates the frame, and the frame is measured with the
+ *  sphere uploaded in each format.  The precision lost by
+ *  packing the sphere is reported first.
+ ***********************************************************/
+void RunVertexFormatBenchmark(int frames)
+{
+	const int SPHERE_SEGMENTS = 512;
+	const int BENCHMARK_DESKS = 25;
+	const MeshImporter::VERTEX_FORMAT FORMATS[] = { MeshImporter::VERTEX_FORMAT_FLOAT, MeshImporter::VERTEX_FORMAT_PACKED };
+	const char* FORMAT_NAMES[] = { "float", "packed" };
+	const int FORMAT_SIZES[] = { sizeof(MeshImporter::MESH_VERTEX), sizeof(MeshImporter::PACKED_VERTEX) };
+
+	MeshImporter::IMPORTED_MESH sphere;
+	MeshImporter::GenerateSphere(SPHERE_SEGMENTS, sphere);
+	MeshImporter::PACKED_MESH packed;
+	MeshImporter::PACKING_ERROR error;
+	MeshImporter::PackVertices(sphere, packed);
+	MeshImporter::MeasurePackingError(sphere, packed, error);
+
+	std::cout << "INFO: Vertex format benchmark on " << glGetString(GL_RENDERER) << ", " << frames
+		<< " frames per format, " << BENCHMARK_DESKS << " desks of " << sphere.indices.size() / 3 << " triangle spheres" << std::endl;
+	std::cout << "BENCHMARK: packed precision - position " << error.position << " of the extent, normal "
+		<< error.normalDegrees << " degrees, texture coordinate " << error.textureCoordinate << std::endl;
+
+	// the benchmark measures the rendering cost, not the display rate
+	glfwSwapInterval(0);
+
+	int mouseMesh = g_SceneManager->GetMouseMesh();
+	g_SceneManager->GenerateOffice(BENCHMARK_DESKS, g_RenderSettings.officeSeed);
+	for (int i = 0; i < 2; i++)
+	{
+		MeshImporter::IMPORTED_MESH mesh = sphere;
+		g_SceneManager->SetMouseMesh(g_SceneManager->AddImportedMesh(mesh, SceneManager::MESH_SPHERE, FORMATS[i]));
+		double frameMs = MeasureFrames(frames, NULL);
+
+		std::cout << std::fixed << std::setprecision(3);
+		std::cout << "BENCHMARK: " << std::setw(6) << FORMAT_NAMES[i] << " vertices - " << FORMAT_SIZES[i]
+			<< " bytes per vertex, " << (sphere.vertices.size() * FORMAT_SIZES[i]) / 1048576.0
+			<< " MB per sphere, cpu " << g_RenderTimer.GetAverageCpuMs() << " ms, gpu "
+			<< g_RenderTimer.GetAverageGpuMs() << " ms, frame " << frameMs << " ms" << std::endl;
+		std::cout << std::defaultfloat << std::setprecision(6);
+	}
+
+	g_SceneManager->SetMouseMesh(mouseMesh);
+	g_SceneManager->GenerateOffice(g_RenderSettings.officeDeskCount, g_RenderSettings.officeSeed);
+}
+
+/***********************************************************
+ *	RunTransparencyBenchmark()
+ *
+ *  This function is used to compare the sorted transparency
+ *  against the weighted blended one.  The glass, plate and
+ *  fabric materials of an office are switched to blending,
+ *  so the screens and books of every desk go through the
+ *  transparent pass, and the frame is measured in each mode.
+ ***********************************************************/
+void RunTransparencyBenchmark(int frames)
+{
+	const int BENCHMARK_DESKS = 100;
+	const char* BLENDED_MATERIALS[] = { "glass", "plate", "fabric" };
+	const int BLENDED_MATERIAL_TOTAL = sizeof(BLENDED_MATERIALS) / sizeof(BLENDED_MATERIALS[0]);
+
+	std::cout << "INFO: Transparency benchmark on " << glGetString(GL_RENDERER) << ", " << frames
+		<< " frames per mode, " << BENCHMARK_DESKS << " desks" << std::endl;
+
+	// the benchmark measures the rendering cost, not the display rate
+	glfwSwapInterval(0);
+
+	SceneManager::OBJECT_MATERIAL savedMaterials[BLENDED_MATERIAL_TOTAL];
+	for (int i = 0; i < BLENDED_MATERIAL_TOTAL; i++)
+	{
+		g_SceneManager->FindMaterial(BLENDED_MATERIALS[i], savedMaterials[i]);
+		SceneManager::OBJECT_MATERIAL blended = savedMaterials[i];
+		blended.alphaMode = MaterialTable::ALPHA_BLEND;
+		g_SceneManager->UpdateMaterial(BLENDED_MATERIALS[i], blended);
+	}
+	g_SceneManager->GenerateOffice(BENCHMARK_DESKS, g_RenderSettings.officeSeed);
+
+	int savedMode = g_RenderSettings.transparencyMode;
+	for (int mode = 0; mode < TransparencyRenderer::TRANSPARENCY_MODE_COUNT; mode++)
+	{
+		g_RenderSettings.transparencyMode = mode;
+		double frameMs = MeasureFrames(frames, NULL);
+
+		std::cout << std::fixed << std::setprecision(3);
+		std::cout << "BENCHMARK: " << std::setw(16) << TransparencyRenderer::GetModeName(mode)
+			<< " - transparent draws " << g_SceneManager->GetTransparentDrawCount() << " of "
+			<< g_SceneManager->GetVisibleDrawCount() << ", cpu " << g_RenderTimer.GetAverageCpuMs()
+			<< " ms, gpu " << g_RenderTimer.GetAverageGpuMs() << " ms, frame " << frameMs << " ms" << std::endl;
+		std::cout << std::defaultfloat << std::setprecision(6);
+	}
+	g_RenderSettings.transparencyMode = savedMode;
+
+	for (int i = 0; i < BLENDED_MATERIAL_TOTAL; i++)
+	{
+		g_SceneManager->UpdateMaterial(BLENDED_MATERIALS[i], savedMaterials[i]);
+	}
+	g_SceneManager->GenerateOffice(g_RenderSettings.officeDeskCount, g_RenderSettings.officeSeed);
+}
+
+/***********************************************************
+ *	RunResolutionBenchmark()
+ *
+ *  This function is used to measure the frame time at a few
+ *  fixed resolution scales, and then to let the adaptive
+ *  resolution keep the frame within a budget of half the
+ *  full resolution GPU time, reporting the scale it settled
+ *  on and the frame time it achieved.  The first run of the
+ *  adaptive mode is not measured, so the scale can settle.
+ ***********************************************************/
+void RunResolutionBenchmark(int frames)
+{
+	const float SCALES[] = { 1.0f, 0.85f, 0.7f, 0.5f };
+	const int SCALE_COUNT = sizeof(SCALES) / sizeof(SCALES[0]);
+
+	int width = 0;
+	int height = 0;
+	glfwGetFramebufferSize(g_Window, &width, &height);
+	std::cout << "INFO: Resolution benchmark on " << glGetString(GL_RENDERER) << ", " << frames
+		<< " frames per scale, " << width << "x" << height << " window" << std::endl;
+
+	// the benchmark measures the rendering cost, not the display rate
+	glfwSwapInterval(0);
+
+	RENDER_SETTINGS savedSettings = g_RenderSettings;
+	g_RenderSettings.bAdaptiveResolution = false;
+
+	double fullResolutionMs = 0.0;
+	for (int i = 0; i < SCALE_COUNT; i++)
+	{
+		g_RenderSettings.resolutionScale = SCALES[i];
+		double frameMs = MeasureFrames(frames, NULL);
+		if (i == 0)
+		{
+			// without timer queries the whole frame is measured
+			fullResolutionMs = (g_RenderTimer.GetAverageGpuMs() > 0.0) ? g_RenderTimer.GetAverageGpuMs() : frameMs;
+		}
+
+		std::cout << std::fixed << std::setprecision(3);
+		std::cout << "BENCHMARK: scale " << std::setprecision(2) << SCALES[i] << std::setprecision(3)
+			<< " - " << (int)(width * SCALES[i] + 0.5f) << "x" << (int)(height * SCALES[i] + 0.5f)
+			<< ", cpu " << g_RenderTimer.GetAverageCpuMs() << " ms, gpu " << g_RenderTimer.GetAverageGpuMs()
+			<< " ms, frame " << frameMs << " ms" << std::endl;
+		std::cout << std::defaultfloat << std::setprecision(6);
+	}
+
+	g_RenderSettings.bAdaptiveResolution = true;
+	g_RenderSettings.resolutionScale = 1.0f;
+	g_RenderSettings.frameBudgetMs = (float)(fullResolutionMs * 0.5);
+	g_RenderSettings.minResolutionScale = 0.25f;
+	MeasureFrames(frames, NULL);
+	double frameMs = MeasureFrames(frames, NULL);
+
+	std::cout << std::fixed << std::setprecision(3);
+	std::cout << "BENCHMARK: adaptive - budget " << g_RenderSettings.frameBudgetMs << " ms, scale "
+		<< std::setprecision(2) << g_RenderSettings.resolutionScale << std::setprecision(3)
+		<< ", cpu " << g_RenderTimer.GetAverageCpuMs() << " ms, gpu " << g_RenderTimer.GetAverageGpuMs()
+		<< " ms, frame " << frameMs << " ms" << std::endl;
+	std::cout << std::defaultfloat << std::setprecision(6);
+
+	g_RenderSettings = savedSettings;
+}
+
+/***********************************************************
+ *	ReadFrontBuffer()
+ *
+ *  This function is used to read the RGB pixels of the frame
+ *  last presented in the window, rows bottom first.
+ ***********************************************************/
+void ReadFrontBuffer(std::vector<unsigned char>& pixels, int& width, int& height)
+{
+	glfwGetFramebufferSize(g_Window, &width, &height);
+	pixels.resize((size_t)width * height * 3);
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+	glReadBuffer(GL_FRONT);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+	glReadBuffer(GL_BACK);
+}
+
+/***********************************************************
+ *	RunRegressionCheck()
+ *
+ *  This function is used to check that the rendering has not
+ *  changed.  The camera presets of the view keys are rendered
+ *  one after another, each starting from the perspective
+ *  preset so the blended ones always land on the same view,
+ *  followed by a view of rotated and non-uniformly scaled
+ *  objects added to the scene only for it, which are lit
+ *  wrong unless their normals are transformed correctly.
+ *  The last frame of each is compared with its golden image,
+ *  and the frame time with the baseline.  A preset fails when
+ *  its structural similarity drops below the threshold, and
+ *  the rendered frame and the difference image are written
+ *  next to the golden one.  A time beyond the tolerance is
+ *  only reported as a warning, since a single run is too
+ *  noisy to fail on.  The goldens and baseline are only valid for
+ *  the renderer and window size they were stored with, so
+ *  they are stored once with --update-golden, and the check
+ *  fails without them - run it with LIBGL_ALWAYS_SOFTWARE=1
+ *  under a virtual display such as xvfb-run for llvmpipe.
+ ***********************************************************/
+void RunRegressionCheck(const std::string& directory, bool bUpdateGolden)
+{
+	const int REGRESSION_FRAMES = 50;
+	// lowest structural similarity to the golden image that passes
+	const double MIN_SSIM = 0.98;
+	// growth of the frame and GPU times over the baseline that
+	// is not warned about, relative and in ms for the shortest frames
+	const double TIME_TOLERANCE = 0.25;
+	const double TIME_SLACK_MS = 0.5;
+	// the preset without a key looks at the normal test objects
+	const int PRESET_KEYS[] = { GLFW_KEY_P, GLFW_KEY_O, GLFW_KEY_1, GLFW_KEY_2, GLFW_KEY_3, GLFW_KEY_4, GLFW_KEY_UNKNOWN };
+	const char* PRESET_NAMES[] = { "preset_p", "preset_o", "preset_1", "preset_2", "preset_3", "preset_4", "preset_normals" };
+	const int PRESET_COUNT = sizeof(PRESET_KEYS) / sizeof(PRESET_KEYS[0]);
+
+	std::string baselineFilename = directory + "/baseline.txt";
+	std::cout << "INFO: Regression check on " << glGetString(GL_RENDERER) << " against " << directory
+		<< (bUpdateGolden ? ", storing new golden images" : "") << std::endl;
+
+	// preset name, then the frame and GPU time in ms
+	std::map<std::string, std::pair<double, double>> baseline;
+	std::ifstream baselineFile(baselineFilename);
+	std::string name;
+	double frameMs = 0.0;
+	double gpuMs = 0.0;
+	while (baselineFile >> name >> frameMs >> gpuMs)
+	{
+		baseline[name] = std::make_pair(frameMs, gpuMs);
+	}
+
+	// the goldens are stored per renderer, so a fresh checkout has
+	// none to compare with until they are stored once
+	if (!bUpdateGolden && !baselineFile.is_open())
+	{
+		std::cout << "Could not read regression baseline file:" << baselineFilename << std::endl;
+		std::cout << "REGRESSION: no golden images - run with --update-golden first to store them" << std::endl;
+		g_bRegressionFailed = true;
+		return;
+	}
+
+	// the check measures the rendering cost, not the display rate,
+	// and renders the same frame every time
+	glfwSwapInterval(0);
+	RENDER_SETTINGS savedSettings = g_RenderSettings;
+	CameraPath::CAMERA_POSE savedPose = g_ViewManager->GetCameraPose();
+	g_RenderSettings.bAnimate = false;
+	g_RenderSettings.bAdaptiveResolution = false;
+
+	std::ofstream newBaselineFile;
+	if (bUpdateGolden)
+	{
+		newBaselineFile.open(baselineFilename);
+		if (!newBaselineFile.is_open())
+		{
+			std::cout << "Could not write regression baseline file:" << baselineFilename << std::endl;
+			g_bRegressionFailed = true;
+		}
+	}
+
+	int passedCount = 0;
+	std::cout << std::fixed << std::setprecision(3);
+	for (int i = 0; i < PRESET_COUNT; i++)
+	{
+		bool bNormalPreset = (PRESET_KEYS[i] == GLFW_KEY_UNKNOWN);
+		g_SceneManager->SetNormalTestObjects(bNormalPreset);
+		g_ViewManager->PressKey(GLFW_KEY_P);
+		if (bNormalPreset)
+		{
+			CameraPath::CAMERA_POSE pose = g_ViewManager->GetCameraPose();
+			glm::vec3 center = SceneManager::GetNormalTestCenter();
+			pose.position = center + glm::vec3(0.0f, 2.5f, 5.0f);
+			pose.front = glm::normalize(center - pose.position);
+			pose.zoom = 45.0f;
+			g_ViewManager->SetCameraPose(pose);
+		}
+		else if (PRESET_KEYS[i] != GLFW_KEY_P)
+		{
+			g_ViewManager->PressKey(PRESET_KEYS[i]);
+		}
+		frameMs = MeasureFrames(REGRESSION_FRAMES, NULL);
+		gpuMs = g_RenderTimer.GetAverageGpuMs();
+
+		std::vector<unsigned char> pixels;
+		int width = 0;
+		int height = 0;
+		ReadFrontBuffer(pixels, width, height);
+
+		std::string goldenFilename = directory + "/" + PRESET_NAMES[i] + ".png";
+		if (bUpdateGolden)
+		{
+			bool bStored = ImageComparer::SavePNG(goldenFilename, pixels, width, height);
+			newBaselineFile << PRESET_NAMES[i] << " " << frameMs << " " << gpuMs << std::endl;
+			std::cout << "REGRESSION: " << std::setw(8) << PRESET_NAMES[i] << " - " << (bStored ? "stored" : "FAILED to store")
+				<< " " << width << "x" << height << ", frame " << frameMs << " ms, gpu " << gpuMs << " ms" << std::endl;
+			if (bStored)
+			{
+				passedCount++;
+			}
+			continue;
+		}
+
+		std::string failures;
+		std::string warnings;
+		std::vector<unsigned char> golden;
+		int goldenWidth = 0;
+		int goldenHeight = 0;
+		ImageComparer::COMPARISON comparison;
+		comparison.ssim = 0.0;
+		comparison.maxDifference = 255;
+		comparison.changedPixels = width * height;
+		if (!ImageComparer::LoadPNG(goldenFilename, golden, goldenWidth, goldenHeight))
+		{
+			failures += " no golden image (run with --update-golden first)";
+		}
+		else if ((goldenWidth != width) || (goldenHeight != height))
+		{
+			failures += " golden image is " + std::to_string(goldenWidth) + "x" + std::to_string(goldenHeight);
+		}
+		else
+		{
+			std::vector<unsigned char> difference;
+			comparison = ImageComparer::Compare(pixels, golden, width, height, &difference);
+			if (comparison.ssim < MIN_SSIM)
+			{
+				failures += " image";
+			}
+			ImageComparer::SavePNG(directory + "/" + PRESET_NAMES[i] + "_diff.png", difference, width, height);
+		}
+		ImageComparer::SavePNG(directory + "/" + PRESET_NAMES[i] + "_current.png", pixels, width, height);
+
+		std::map<std::string, std::pair<double, double>>::const_iterator baselineTimes = baseline.find(PRESET_NAMES[i]);
+		double baselineFrameMs = 0.0;
+		double baselineGpuMs = 0.0;
+		if (baselineTimes != baseline.end())
+		{
+			baselineFrameMs = baselineTimes->second.first;
+			baselineGpuMs = baselineTimes->second.second;
+			if (frameMs > baselineFrameMs * (1.0 + TIME_TOLERANCE) + TIME_SLACK_MS)
+			{
+				warnings += " frame time";
+			}
+			// without timer queries only the frame is timed
+			if ((gpuMs > 0.0) && (baselineGpuMs > 0.0) && (gpuMs > baselineGpuMs * (1.0 + TIME_TOLERANCE) + TIME_SLACK_MS))
+			{
+				warnings += " gpu time";
+			}
+		}
+		else
+		{
+			warnings += " no baseline time";
+		}
+
+		std::cout << "REGRESSION: " << std::setw(8) << PRESET_NAMES[i] << " - ssim " << std::setprecision(5) << comparison.ssim
+			<< std::setprecision(3) << ", max difference " << comparison.maxDifference << ", changed pixels " << comparison.changedPixels
+			<< ", frame " << frameMs << " ms (baseline " << baselineFrameMs << "), gpu " << gpuMs << " ms (baseline " << baselineGpuMs
+			<< ") - " << (failures.empty() ? "passed" : "FAILED:" + failures)
+			<< (warnings.empty() ? "" : ", WARNING:" + warnings) << std::endl;
+		if (failures.empty())
+		{
+			passedCount++;
+		}
+	}
+	std::cout << std::defaultfloat << std::setprecision(6);
+
+	std::cout << "REGRESSION: " << passedCount << " of " << PRESET_COUNT << " presets "
+		<< (bUpdateGolden ? "stored" : "passed") << std::endl;
+	if (passedCount < PRESET_COUNT)
+	{
+		g_bRegressionFailed = true;
+	}
+
+	g_SceneManager->SetNormalTestObjects(false);
+	g_RenderSettings = savedSettings;
+	g_ViewManager->SetCameraPose(savedPose);
+}
+
+/***********************************************************
+ *	RunLightmapBenchmark()
+ *
+ *  This function is used to compare the per pixel lighting
+ *  of the static draws with the lighting baked into the
+ *  lightmaps, with and without shadow rays.  The lightmaps
+ *  are baked once per mode before it is measured, and the
+ *  last frame of every mode is compared with the one lit
+ *  per pixel, reporting the root mean square and largest
+ *  difference of the colour channels and the PSNR.
+ ***********************************************************/
+void RunLightmapBenchmark(int frames)
+{
+	const char* MODE_NAMES[] = { "per pixel", "baked, no shadows", "baked, shadows" };
+	const int MODE_COUNT = sizeof(MODE_NAMES) / sizeof(MODE_NAMES[0]);
+
+	std::cout << "INFO: Lightmap benchmark on " << glGetString(GL_RENDERER)
+		<< ", " << frames << " frames per mode" << std::endl;
+
+	// the benchmark measures the rendering cost, not the display rate
+	glfwSwapInterval(0);
+
+	RENDER_SETTINGS savedSettings = g_RenderSettings;
+	// the lightmaps only replace the lighting of the forward path
+	g_RenderSettings.bDeferredShading = false;
+	g_RenderSettings.bShowOverdraw = false;
+
+	std::vector<unsigned char> referencePixels;
+	for (int mode = 0; mode < MODE_COUNT; mode++)
+	{
+		g_RenderSettings.bLightmaps = (mode > 0);
+		g_RenderSettings.bLightmapOcclusion = (mode == 2);
+		if (mode > 0)
+		{
+			g_SceneManager->BakeLightmaps();
+		}
+
+		double averageFragments = 0.0;
+		double frameMs = MeasureFrames(frames, &averageFragments);
+		double gpuMs = g_RenderTimer.GetAverageGpuMs();
+
+		std::vector<unsigned char> pixels;
+		int width = 0;
+		int height = 0;
+		ReadFrontBuffer(pixels, width, height);
+
+		std::cout << std::fixed << std::setprecision(3);
+		std::cout << "BENCHMARK: " << std::setw(17) << MODE_NAMES[mode] << " - cpu " << g_RenderTimer.GetAverageCpuMs()
+			<< " ms, gpu " << gpuMs << " ms, frame " << frameMs << " ms, shaded fragments " << (long long)averageFragments;
+		if (averageFragments > 0.0)
+		{
+			std::cout << ", gpu " << (gpuMs * 1.0e6 / averageFragments) << " ns per fragment";
+		}
+		std::cout << std::endl;
+
+		if (mode == 0)
+		{
+			referencePixels = pixels;
+		}
+		else if (pixels.size() == referencePixels.size())
+		{
+			double squaredError = 0.0;
+			int maxError = 0;
+			for (size_t i = 0; i < pixels.size(); i++)
+			{
+				int error = std::abs((int)pixels[i] - (int)referencePixels[i]);
+				squaredError += (double)(error * error);
+				maxError = std::max(maxError, error);
+			}
+			double rmse = std::sqrt(squaredError / (double)std::max<size_t>(pixels.size(), 1));
+			std::cout << "BENCHMARK: " << std::setw(17) << MODE_NAMES[mode] << " - difference to per pixel rmse "
+				<< rmse << ", max " << maxError << ", psnr ";
+			if (rmse > 0.0)
+			{
+				std::cout << (20.0 * std::log10(255.0 / rmse)) << " dB" << std::endl;
+			}
+			else
+			{
+				std::cout << "inf" << std::endl;
+			}
+		}
+		std::cout << std::defaultfloat << std::setprecision(6);
+	}
+
+	g_RenderSettings = savedSettings;
+}
+
+/***********************************************************
+ *	RunAmbientOcclusionBenchmark()
+ *
+ *  This function is used to measure the cost of the ambient
+ *  occlusion at each quality level, in the forward and the
+ *  deferred path.  The forward path needs the depth prepass
+ *  for the occlusion, so it is measured with the prepass on
+ *  at every level, and the cost reported is the GPU time
+ *  over the level without occlusion.
+ ***********************************************************/
+void RunAmbientOcclusionBenchmark(int frames)
+{
+	std::cout << "INFO: Ambient occlusion benchmark on " << glGetString(GL_RENDERER)
+		<< ", " << frames << " frames per quality" << std::endl;
+
+	// the benchmark measures the rendering cost, not the display rate
+	glfwSwapInterval(0);
+
+	RENDER_SETTINGS savedSettings = g_RenderSettings;
+	g_RenderSettings.bMultiView = false;
+	g_RenderSettings.bShowOverdraw = false;
+	g_RenderSettings.bDepthPrepass = true;
+
+	for (int path = 0; path < 2; path++)
+	{
+		g_RenderSettings.bDeferredShading = (path == 1);
+		double baseGpuMs = 0.0;
+		for (int quality = 0; quality < AmbientOcclusion::QUALITY_COUNT; quality++)
+		{
+			g_RenderSettings.ambientOcclusionQuality = quality;
+			double frameMs = MeasureFrames(frames, NULL);
+			double gpuMs = g_RenderTimer.GetAverageGpuMs();
+			if (quality == 0)
+			{
+				baseGpuMs = gpuMs;
+			}
+
+			std::cout << std::fixed << std::setprecision(3);
+			std::cout << "BENCHMARK: " << (g_RenderSettings.bDeferredShading ? "deferred" : "forward ") << " ssao "
+				<< std::setw(6) << AmbientOcclusion::GetQualityName(quality) << " - cpu " << g_RenderTimer.GetAverageCpuMs()
+				<< " ms, gpu " << gpuMs << " ms, frame " << frameMs << " ms, cost " << (gpuMs - baseGpuMs) << " ms" << std::endl;
+			std::cout << std::defaultfloat << std::setprecision(6);
+		}
+	}
+
+	g_RenderSettings = savedSettings;
+}
+
+/***********************************************************
+ *	RunParticleBenchmark()
+ *
+ *  This function is used to measure simulating and drawing
+ *  ten thousand, a hundred thousand and a million particles,
+ *  simulated on the GPU and on the CPU.  The simulation and
+ *  the draw are reported separately, with whether the whole
+ *  frame stays within the frame budget.  Each run first
+ *  renders for longer than a particle lifetime, so every
+ *  particle is in flight when the frames are measured.
+ ***********************************************************/
+void RunParticleBenchmark(int frames)
+{
+	const int PARTICLE_COUNTS[] = { 10000, 100000, 1000000 };
+	const int PARTICLE_COUNT_TOTAL = sizeof(PARTICLE_COUNTS) / sizeof(PARTICLE_COUNTS[0]);
+	const int SIMULATION_MODES[] = { ParticleSystem::SIMULATE_GPU, ParticleSystem::SIMULATE_CPU };
+	const double PARTICLE_WARMUP_SECONDS = 3.0;
+
+	std::cout << "INFO: Particle benchmark on " << glGetString(GL_RENDERER) << ", " << frames
+		<< " frames per run, frame budget " << g_RenderSettings.frameBudgetMs << " ms" << std::endl;
+
+	// the benchmark measures the rendering cost, not the display rate
+	glfwSwapInterval(0);
+
+	RENDER_SETTINGS savedSettings = g_RenderSettings;
+	for (int mode = 0; mode < 2; mode++)
+	{
+		for (int i = 0; i < PARTICLE_COUNT_TOTAL; i++)
+		{
+			g_RenderSettings.particleSimulation = SIMULATION_MODES[mode];
+			g_RenderSettings.particleCount = PARTICLE_COUNTS[i];
+
+			double warmupStart = glfwGetTime();
+			while (glfwGetTime() - warmupStart < PARTICLE_WARMUP_SECONDS)
+			{
+				RenderFrame();
+				glFinish();
+				glfwPollEvents();
+			}
+			double frameMs = MeasureFrames(frames, NULL);
+
+			std::cout << std::fixed << std::setprecision(3);
+			std::cout << "BENCHMARK: " << ParticleSystem::GetModeName(SIMULATION_MODES[mode]) << " " << std::setw(8)
+				<< PARTICLE_COUNTS[i] << " particles - simulate cpu " << g_RenderTimer.GetAveragePassCpuMs("particle simulate")
+				<< " ms, gpu " << g_RenderTimer.GetAveragePassGpuMs("particle simulate") << " ms, draw cpu "
+				<< g_RenderTimer.GetAveragePassCpuMs("particles") << " ms, gpu " << g_RenderTimer.GetAveragePassGpuMs("particles")
+				<< " ms, frame " << frameMs << " ms, " << ((frameMs <= g_RenderSettings.frameBudgetMs) ? "within" : "over")
+				<< " budget" << std::endl;
+			std::cout << std::defaultfloat << std::setprecision(6);
+		}
+	}
+
+	g_RenderSettings = savedSettings;
+}
+
+/***********************************************************
+ *	RunNormalBenchmark()
+ *
+ *  This function is used to measure what transforming the
+ *  vertex normals costs per vertex.  Every mouse of an office
+ *  is replaced by a finely tessellated sphere, so that the
+ *  vertex shader dominates the lit pass, and the lit pass is
+ *  measured with the normals transformed by the normal matrix
+ *  computed once per object, left untransformed as they were
+ *  before it, and transformed by the inverse transpose
+ *  computed for every vertex.  The GPU time over the
+ *  untransformed normals is divided by the vertices of the
+ *  triangles the pass drew.
+ ***********************************************************/
+void RunNormalBenchmark(int frames)
+{
+	const int SPHERE_SEGMENTS = 512;
+	const int BENCHMARK_DESKS = 25;
+	const int TRANSFORMS[] = { SceneManager::NORMAL_UNTRANSFORMED, SceneManager::NORMAL_PRECOMPUTED, SceneManager::NORMAL_PER_VERTEX };
+	const char* TRANSFORM_NAMES[] = { "untransformed", "normal matrix", "per vertex inverse" };
+	const int TRANSFORM_COUNT = sizeof(TRANSFORMS) / sizeof(TRANSFORMS[0]);
+
+	MeshImporter::IMPORTED_MESH sphere;
+	MeshImporter::GenerateSphere(SPHERE_SEGMENTS, sphere);
+
+	std::cout << "INFO: Normal benchmark on " << glGetString(GL_RENDERER) << ", " << frames
+		<< " frames per transform, " << BENCHMARK_DESKS << " desks of " << sphere.indices.size() / 3 << " triangle spheres" << std::endl;
+
+	// the benchmark measures the rendering cost, not the display rate
+	glfwSwapInterval(0);
+
+	RENDER_SETTINGS savedSettings = g_RenderSettings;
+	// only the lit pass of the forward path runs the vertex shader
+	// being measured, and it runs it once for the one view
+	g_RenderSettings.bDeferredShading = false;
+	g_RenderSettings.bMultiView = false;
+	g_RenderSettings.bShowOverdraw = false;
+
+	int mouseMesh = g_SceneManager->GetMouseMesh();
+	g_SceneManager->GenerateOffice(BENCHMARK_DESKS, g_RenderSettings.officeSeed);
+	MeshImporter::IMPORTED_MESH mesh = sphere;
+	g_SceneManager->SetMouseMesh(g_SceneManager->AddImportedMesh(mesh, SceneManager::MESH_SPHERE, MeshImporter::VERTEX_FORMAT_FLOAT));
+
+	double baseGpuMs = 0.0;
+	for (int i = 0; i < TRANSFORM_COUNT; i++)
+	{
+		g_RenderSettings.normalTransform = TRANSFORMS[i];
+		double frameMs = MeasureFrames(frames, NULL);
+		double litGpuMs = g_RenderTimer.GetAveragePassGpuMs("lit");
+		double vertices = 3.0 * (double)g_SceneManager->GetLitTriangleCount();
+		if (i == 0)
+		{
+			baseGpuMs = litGpuMs;
+		}
+
+		std::cout << std::fixed << std::setprecision(3);
+		std::cout << "BENCHMARK: " << std::setw(18) << TRANSFORM_NAMES[i] << " - lit pass cpu " << g_RenderTimer.GetAveragePassCpuMs("lit")
+			<< " ms, gpu " << litGpuMs << " ms, frame " << frameMs << " ms, " << (long long)vertices << " vertices";
+		if ((i > 0) && (vertices > 0.0))
+		{
+			std::cout << ", " << ((litGpuMs - baseGpuMs) * 1.0e6 / vertices) << " ns per vertex over untransformed";
+		}
+		std::cout << std::endl;
+		std::cout << std::defaultfloat << std::setprecision(6);
+	}
+
+	g_SceneManager->SetMouseMesh(mouseMesh);
+	g_SceneManager->GenerateOffice(g_RenderSettings.officeDeskCount, g_RenderSettings.officeSeed);
+	g_RenderSettings = savedSettings;
+}
+
+/***********************************************************
+ *	RunSnapshotBenchmark()
+ *
+ *  This function is used to compare the time to the first
+ *  frame of rebuilding a generated office with mapping its
+ *  snapshot, for offices of about a thousand, a hundred
+ *  thousand and a million draws.  Each office is rebuilt
+ *  and rendered, saved, replaced by the recorded desk, and
+ *  then mapped from the snapshot and rendered.  The shaders
+ *  and textures are loaded for both, so only preparing the
+ *  draws is measured, and the snapshot is read right after
+ *  it was written, from the file cache.
+ ***********************************************************/
+void RunSnapshotBenchmark()
+{
+	const int DRAW_COUNTS[] = { 1000, 100000, 1000000 };
+	const int DRAW_COUNT_TOTAL = sizeof(DRAW_COUNTS) / sizeof(DRAW_COUNTS[0]);
+	const char* SNAPSHOT_FILE = "benchmark.snapshot";
+
+	// the offices are sized in whole desks of the recorded one
+	g_SceneManager->GenerateOffice(0, g_RenderSettings.officeSeed);
+	int drawsPerDesk = glm::max(g_SceneManager->GetDrawCount(), 1);
+
+	std::cout << "INFO: Snapshot benchmark on " << glGetString(GL_RENDERER) << ", "
+		<< drawsPerDesk << " draws per desk, seed " << g_RenderSettings.officeSeed << std::endl;
+
+	// the benchmark measures the time to the first frame, not the display rate
+	glfwSwapInterval(0);
+
+	auto elapsedMs = [](std::chrono::steady_clock::time_point start) {
+		return(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+	};
+
+	for (int i = 0; i < DRAW_COUNT_TOTAL; i++)
+	{
+		int deskCount = glm::min((DRAW_COUNTS[i] + drawsPerDesk - 1) / drawsPerDesk, (int)OfficeGenerator::MAX_DESKS);
+
+		auto rebuildStart = std::chrono::steady_clock::now();
+		g_SceneManager->GenerateOffice(deskCount, g_RenderSettings.officeSeed);
+		RenderFrame();
+		glFinish();
+		double rebuildMs = elapsedMs(rebuildStart);
+		int drawCount = g_SceneManager->GetDrawCount();
+
+		auto saveStart = std::chrono::steady_clock::now();
+		bool bSaved = g_SceneManager->SaveSnapshot(SNAPSHOT_FILE);
+		double saveMs = elapsedMs(saveStart);
+
+		g_SceneManager->GenerateOffice(0, g_RenderSettings.officeSeed);
+
+		auto loadStart = std::chrono::steady_clock::now();
+		bool bLoaded = bSaved && g_SceneManager->LoadSnapshot(SNAPSHOT_FILE, deskCount, g_RenderSettings.officeSeed);
+		RenderFrame();
+		glFinish();
+		double loadMs = elapsedMs(loadStart);
+
+		std::cout << std::fixed << std::setprecision(3);
+		if (!bLoaded)
+		{
+			std::cout << "BENCHMARK: " << std::setw(7) << drawCount << " draws - snapshot could not be saved and mapped" << std::endl;
+		}
+		else
+		{
+			std::cout << "BENCHMARK: " << std::setw(7) << drawCount << " draws (" << deskCount << " desks) - rebuild "
+				<< rebuildMs << " ms, snapshot " << loadMs << " ms, " << (rebuildMs / std::max(loadMs, 1.0e-6))
+				<< "x faster, save " << saveMs << " ms" << std::endl;
+		}
+		std::cout << std::defaultfloat << std::setprecision(6);
+	}
+	std::remove(SNAPSHOT_FILE);
+
+	g_SceneManager->GenerateOffice(g_RenderSettings.officeDeskCount, g_RenderSettings.officeSeed);
+}
+
+/***********************************************************
+ *	RunPathBenchmark()
+ *
+ *  This function is used to replay a camera path and report
+ *  the distribution of its frame times.  The path drives
+ *  the camera with a fixed frame time, so every run renders
+ *  exactly the same frames and builds can be compared.
+ ***********************************************************/
+void RunPathBenchmark(const CameraPath& path, const std::string& name)
+{
+	// the benchmark measures the rendering cost, not the display rate
+	glfwSwapInterval(0);
+
+	std::vector<double> frameTimes;
+	frameTimes.reserve(path.GetFrameCount());
+
+	g_ViewManager->StartReplay(&path);
+	while (g_ViewManager->IsReplaying() && !glfwWindowShouldClose(g_Window))
+	{
+		auto frameStart = std::chrono::steady_clock::now();
+		RenderFrame();
+		glFinish();
+		frameTimes.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count());
+		glfwPollEvents();
+	}
+
+	ReportFrameTimes(name, frameTimes);
+}
+
+/***********************************************************
+ *	ReportFrameTimes()
+ *
+ *  This function is used to print the mean and the
+ *  nearest-rank percentiles of the passed in frame times.
+ ***********************************************************/
+void ReportFrameTimes(const std::string& name, std::vector<double>& frameTimes)
+{
+	if (frameTimes.empty())
+	{
+		return;
+	}
+
+	std::sort(frameTimes.begin(), frameTimes.end());
+
+	double totalMs = 0.0;
+	for (int i = 0; i < (int)frameTimes.size(); i++)
+	{
+		totalMs += frameTimes[i];
+	}
+
+	auto percentile = [&frameTimes](double p) {
+		int rank = (int)std::ceil(p / 100.0 * frameTimes.size());
+		return frameTimes[std::max(rank, 1) - 1];
+	};
+
+	std::cout << std::fixed << std::setprecision(3);
+	std::cout << "BENCHMARK: path " << name << " - " << frameTimes.size() << " frames, mean "
+		<< totalMs / frameTimes.size() << " ms, p50 " << percentile(50.0)
+		<< " ms, p90 " << percentile(90.0) << " ms, p99 " << percentile(99.0)
+		<< " ms, max " << frameTimes.back() << " ms" << std::endl;
+	std::cout << std::defaultfloat << std::setprecision(6);
+}
+
+/***********************************************************
+ *	RunBVHBenchmark()
+ *
+ *  This function is used to measure building, refitting and
+ *  querying the bounding volume hierarchy at 1k, 100k and
+ *  1M randomly placed objects.  The objects fill a cube at
+ *  a constant density, and the same seed is used every run.
+ ***********************************************************/
+void RunBVHBenchmark()
+{
+	const int OBJECT_COUNTS[] = { 1000, 100000, 1000000 };
+	const int RAY_COUNT = 10000;
+
+	auto elapsedMs = [](std::chrono::steady_clock::time_point start) {
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	};
+
+	std::cout << std::fixed << std::setprecision(3);
+	for (int objectCount : OBJECT_COUNTS)
+	{
+		unsigned int seed = 330;
+		auto random = [&seed]() {
+			seed = seed * 1664525u + 1013904223u;
+			return (float)(seed >> 8) / 16777216.0f;
+		};
+
+		float side = 2.0f * std::cbrt((float)objectCount);
+		std::vector<BoundingVolumeHierarchy::BVH_BOUNDS> bounds(objectCount);
+		for (int i = 0; i < objectCount; i++)
+		{
+			glm::vec3 center = glm::vec3(random(), random(), random()) * side;
+			glm::vec3 halfSize = glm::vec3(random(), random(), random()) * 0.5f + 0.1f;
+			bounds[i].boundsMin = center - halfSize;
+			bounds[i].boundsMax = center + halfSize;
+		}
+
+		BoundingVolumeHierarchy bvh;
+		auto start = std::chrono::steady_clock::now();
+		bvh.Build(bounds, false);
+		double serialBuildMs = elapsedMs(start);
+
+		start = std::chrono::steady_clock::now();
+		bvh.Build(bounds, true);
+		double parallelBuildMs = elapsedMs(start);
+
+		// move every object a little, as animation would
+		for (int i = 0; i < objectCount; i++)
+		{
+			glm::vec3 offset = glm::vec3(random(), random(), random()) - 0.5f;
+			bounds[i].boundsMin += offset;
+			bounds[i].boundsMax += offset;
+		}
+		start = std::chrono::steady_clock::now();
+		bvh.Refit(bounds);
+		double refitMs = elapsedMs(start);
+
+		// a camera at one corner looking across the cube
+		glm::mat4 viewProjection =
+			glm::perspective(glm::radians(80.0f), 1000.0f / 800.0f, 0.1f, side) *
+			glm::lookAt(glm::vec3(-1.0f, side * 0.5f, -1.0f), glm::vec3(side * 0.5f), glm::vec3(0.0f, 1.0f, 0.0f));
+		std::vector<int> visible;
+		start = std::chrono::steady_clock::now();
+		bvh.QueryFrustum(viewProjection, visible);
+		double frustumMs = elapsedMs(start);
+
+		int hits = 0;
+		start = std::chrono::steady_clock::now();
+		for (int i = 0; i < RAY_COUNT; i++)
+		{
+			glm::vec3 origin = glm::vec3(-1.0f, random() * side, random() * side);
+			glm::vec3 direction = glm::normalize(glm::vec3(1.0f, random() - 0.5f, random() - 0.5f));
+			float distance = 0.0f;
+			if (bvh.QueryRay(origin, direction, distance) >= 0)
+			{
+				hits++;
+			}
+		}
+		double rayUs = elapsedMs(start) * 1000.0 / RAY_COUNT;
+
+		std::cout << "BENCHMARK: BVH " << objectCount << " objects, " << bvh.GetNodeCount() << " nodes - build "
+			<< serialBuildMs << " ms (" << parallelBuildMs << " ms parallel), refit " << refitMs
+			<< " ms, frustum " << frustumMs << " ms (" << visible.size() << " visible), ray "
+			<< rayUs << " us (" << hits << "/" << RAY_COUNT << " hit)" << std::endl;
+	}
+	std::cout << std::defaultfloat << std::setprecision(6);
+}
+
+/***********************************************************
+ *	RunAnimationBenchmark()
+ *
+ *  This function is used to measure evaluating the passed
+ *  in number of animation tracks, each with a few random
+ *  keys, on one thread and on several threads.  The times
+ *  advance by a frame step so the key cursors are reused
+ *  the way they are while rendering.
+ ***********************************************************/
+void RunAnimationBenchmark(int trackCount)
+{
+	const int KEYS_PER_TRACK = 8;
+	const int EVALUATIONS = 100;
+	const float FRAME_STEP = 1.0f / 60.0f;
+
+	unsigned int seed = 330;
+	auto random = [&seed]() {
+		seed = seed * 1664525u + 1013904223u;
+		return (float)(seed >> 8) / 16777216.0f;
+	};
+
+	AnimationSystem animation;
+	std::vector<AnimationSystem::ANIMATION_KEY> keys(KEYS_PER_TRACK);
+	for (int track = 0; track < trackCount; track++)
+	{
+		float time = 0.0f;
+		for (int k = 0; k < KEYS_PER_TRACK; k++)
+		{
+			keys[k] = AnimationSystem::MakeKey(time,
+				glm::vec3(random(), random(), random()) * 2.0f - 1.0f,
+				glm::vec3(random(), random(), random()) * 360.0f - 180.0f,
+				glm::vec3(random() * 0.5f + 0.75f));
+			time += random() + 0.25f;
+		}
+		animation.AddTrack(track, glm::mat4(1.0f), glm::mat3(1.0f), glm::vec3(0.0f), keys);
+	}
+
+	auto measure = [&](bool bParallel) {
+		animation.Evaluate(0.0f, bParallel);
+		auto start = std::chrono::steady_clock::now();
+		for (int i = 1; i <= EVALUATIONS; i++)
+		{
+			animation.Evaluate(i * FRAME_STEP, bParallel);
+		}
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / EVALUATIONS;
+	};
+	double serialMs = measure(false);
+	double parallelMs = measure(true);
+
+	std::cout << std::fixed << std::setprecision(3);
+	std::cout << "BENCHMARK: animation " << animation.GetTrackCount() << " tracks - evaluate "
+		<< serialMs << " ms (" << (serialMs * 1000000.0 / trackCount) << " ns per track), "
+		<< parallelMs << " ms parallel (" << (parallelMs * 1000000.0 / trackCount) << " ns per track)" << std::endl;
+	std::cout << std::defaultfloat << std::setprecision(6);
+}
+
+/***********************************************************
+ *	RunMeshBenchmark()
+ *
+ *  This function is used to measure importing a mesh file.
+ *  The file is loaded a few times, so that the later loads
+ *  read it from the file cache, and the fastest load is
+ *  reported along with the vertex cache miss ratios.
+ ***********************************************************/
+void RunMeshBenchmark(const std::string& filename)
+{
+	const int LOAD_COUNT = 5;
+
+	MeshImporter::IMPORTED_MESH mesh;
+	MeshImporter::IMPORT_STATS best;
+	bool bLoaded = false;
+	for (int i = 0; i < LOAD_COUNT; i++)
+	{
+		MeshImporter::IMPORT_STATS stats;
+		if (!MeshImporter::LoadMesh(filename, mesh, stats))
+		{
+			break;
+		}
+		if (!bLoaded || (stats.loadMs + stats.optimizeMs < best.loadMs + best.optimizeMs))
+		{
+			best = stats;
+		}
+		bLoaded = true;
+	}
+	if (!bLoaded)
+	{
+		std::cout << "BENCHMARK: could not import " << filename << std::endl;
+		return;
+	}
+
+	MeshImporter::PACKED_MESH packed;
+	MeshImporter::PACKING_ERROR error;
+	MeshImporter::PackVertices(mesh, packed);
+	MeshImporter::MeasurePackingError(mesh, packed, error);
+
+	double totalMs = best.loadMs + best.optimizeMs;
+	std::cout << "BENCHMARK: packed precision - position " << error.position << " of the extent, normal "
+		<< error.normalDegrees << " degrees, texture coordinate " << error.textureCoordinate << std::endl;
+	std::cout << std::fixed << std::setprecision(3);
+	std::cout << "BENCHMARK: mesh " << filename << " - " << best.vertexCount << " vertices (from "
+		<< best.sourceVertexCount << "), " << best.triangleCount << " triangles, ACMR " << best.acmrBefore
+		<< " -> " << best.acmrAfter << ", load " << best.loadMs << " ms, optimize " << best.optimizeMs
+		<< " ms, " << ((totalMs > 0.0) ? (best.fileBytes / 1048576.0) / (totalMs / 1000.0) : 0.0) << " MB/s" << std::endl;
+	std::cout << std::defaultfloat << std::setprecision(6);
+}
+
+/***********************************************************
+ *	ParseOptionInt()
+ *
+ *  This function is used to read the integer value of a
+ *  command line option, which starts at the passed in
+ *  position of the argument.  A malformed or out of range
+ *  value is reported and leaves the setting unchanged.
+ ***********************************************************/
+bool ParseOptionInt(const std::string& argument, size_t valueStart, int minValue, int maxValue, int& value)
+{
+	const char* text = argument.c_str() + valueStart;
+	char* end = NULL;
+	errno = 0;
+	long parsed = std::strtol(text, &end, 10);
+	if ((end == text) || (*end != '\0') || (errno == ERANGE))
+	{
+		std::cout << "Invalid value for command line option:" << argument << std::endl;
+		return(false);
+	}
+	if ((parsed < minValue) || (parsed > maxValue))
+	{
+		std::cout << "Value out of range (" << minValue << " - " << maxValue
+			<< ") for command line option:" << argument << std::endl;
+		return(false);
+	}
+
+	value = (int)parsed;
+	return(true);
+}
+
+/***********************************************************
+ *	ParseOptionFloat()
+ *
+ *  This function is used to read the decimal value of a
+ *  command line option, which starts at the passed in
+ *  position of the argument.  A malformed or out of range
+ *  value is reported and leaves the setting unchanged.
+ ***********************************************************/
+bool ParseOptionFloat(const std::string& argument, size_t valueStart, float minValue, float maxValue, float& value)
+{
+	const char* text = argument.c_str() + valueStart;
+	char* end = NULL;
+	errno = 0;
+	float parsed = std::strtof(text, &end);
+	if ((end == text) || (*end != '\0') || (errno == ERANGE))
+	{
+		std::cout << "Invalid value for command line option:" << argument << std::endl;
+		return(false);
+	}
+	// the negated test also rejects NaN
+	if (!((parsed >= minValue) && (parsed <= maxValue)))
+	{
+		std::cout << "Value out of range (" << minValue << " - " << maxValue
+			<< ") for command line option:" << argument << std::endl;
+		return(false);
+	}
+
+	value = parsed;
+	return(true);
+}
+
+/***********************************************************
+ *	ParseOptionSeed()
+ *
+ *  This function is used to read the unsigned 32 bit value
+ *  of a seed option, which starts at the passed in position
+ *  of the argument.  A malformed value is reported and
+ *  leaves the setting unchanged.
+ ***********************************************************/
+bool ParseOptionSeed(const std::string& argument, size_t valueStart, unsigned int& value)
+{
+	const char* text = argument.c_str() + valueStart;
+	char* end = NULL;
+	errno = 0;
+	unsigned long long parsed = std::strtoull(text, &end, 10);
+	if ((end == text) || (*end != '\0') || (*text == '-') || (errno == ERANGE) || (parsed > 0xFFFFFFFFull))
+	{
+		std::cout << "Invalid value for command line option:" << argument << std::endl;
+		return(false);
+	}
+
+	value = (unsigned int)parsed;
+	return(true);
+}
+
+/***********************************************************
+ *	ParseCommandLine()
+ *
+ *  This function is used to read the rendering options
+ *  passed on the command line into the shared settings.
+ ***********************************************************/
+void ParseCommandLine(int argc, char* argv[])
+{
+	for (int i = 1; i < argc; i++)
+	{
+		std::string argument = argv[i];
+
+		// --shadow-quality=N selects the shadow quality tier
+		if (argument.rfind("--shadow-quality=", 0) == 0)
+		{
+			ParseOptionInt(argument, 17, 0, ShadowManager::GetQualityTierCount() - 1, g_RenderSettings.shadowQuality);
+		}
+		// --depth-prepass starts with the depth prepass enabled
+		else if (argument.compare("--depth-prepass") == 0)
+		{
+			g_RenderSettings.bDepthPrepass = true;
+		}
+		// --benchmark-prepass[=frames] compares the prepass off and on
+		else if (argument.rfind("--benchmark-prepass", 0) == 0)
+		{
+			g_PrepassBenchmarkFrames = 200;
+			if (argument.rfind("--benchmark-prepass=", 0) == 0)
+			{
+				ParseOptionInt(argument, 20, 1, MAX_COUNT_OPTION, g_PrepassBenchmarkFrames);
+			}
+		}
+		// --deferred starts with the deferred shading path
+		else if (argument.compare("--deferred") == 0)
+		{
+			g_RenderSettings.bDeferredShading = true;
+		}
+		// --lights=N pads the scene to N point lights
+		else if (argument.rfind("--lights=", 0) == 0)
+		{
+			ParseOptionInt(argument, 9, 0, MAX_POINT_LIGHT_OPTION, g_RenderSettings.pointLightCount);
+		}
+		// --no-light-culling loops every draw over all of the point lights
+		else if (argument.compare("--no-light-culling") == 0)
+		{
+			g_RenderSettings.bLightCulling = false;
+		}
+		// --benchmark-light-grid[=frames] compares the per draw light
+		// lists with looping over every light
+		else if (argument.rfind("--benchmark-light-grid", 0) == 0)
+		{
+			g_LightGridBenchmarkFrames = 100;
+			if (argument.rfind("--benchmark-light-grid=", 0) == 0)
+			{
+				ParseOptionInt(argument, 23, 1, MAX_COUNT_OPTION, g_LightGridBenchmarkFrames);
+			}
+		}
+		// --regression[=directory] compares the camera presets with
+		// their golden images and timing baseline
+		else if ((argument.compare("--regression") == 0) || (argument.rfind("--regression=", 0) == 0))
+		{
+			g_RegressionDirectory = "../regression";
+			if (argument.rfind("--regression=", 0) == 0)
+			{
+				g_RegressionDirectory = argument.substr(13);
+			}
+		}
+		// --update-golden stores the presets as the new golden images
+		// and timing baseline of the regression check
+		else if (argument.compare("--update-golden") == 0)
+		{
+			g_bUpdateGolden = true;
+		}
+		// --benchmark-lights[=frames] compares forward and deferred
+		// shading at increasing point light counts
+		else if (argument.rfind("--benchmark-lights", 0) == 0)
+		{
+			g_LightBenchmarkFrames = 100;
+			if (argument.rfind("--benchmark-lights=", 0) == 0)
+			{
+				ParseOptionInt(argument, 19, 1, MAX_COUNT_OPTION, g_LightBenchmarkFrames);
+			}
+		}
+		// --no-hdr renders straight into the window
+		else if (argument.compare("--no-hdr") == 0)
+		{
+			g_RenderSettings.bHDR = false;
+		}
+		// --msaa=N selects the MSAA samples of the HDR target
+		else if (argument.rfind("--msaa=", 0) == 0)
+		{
+			ParseOptionInt(argument, 7, 1, MAX_MSAA_SAMPLES_OPTION, g_RenderSettings.msaaSamples);
+		}
+		// --exposure=X scales the scene color before tone mapping
+		else if (argument.rfind("--exposure=", 0) == 0)
+		{
+			ParseOptionFloat(argument, 11, 0.001f, 1000.0f, g_RenderSettings.exposure);
+		}
+		// --tone-map=none|reinhard|aces selects the tone mapping operator
+		else if (argument.rfind("--tone-map=", 0) == 0)
+		{
+			std::string name = argument.substr(11);
+			for (int op = 0; op < HDRRenderTarget::TONE_MAP_OPERATOR_COUNT; op++)
+			{
+				if (name.compare(HDRRenderTarget::GetToneMapOperatorName(op)) == 0)
+				{
+					g_RenderSettings.toneMapOperator = op;
+				}
+			}
+		}
+		// --record-path=file records the camera input into a path file
+		else if (argument.rfind("--record-path=", 0) == 0)
+		{
+			g_RecordPathFile = argument.substr(14);
+		}
+		// --replay-path=file replays a recorded path as a benchmark
+		else if (argument.rfind("--replay-path=", 0) == 0)
+		{
+			g_ReplayPathFile = argument.substr(14);
+		}
+		// --benchmark-paths replays the canonical camera paths
+		else if (argument.compare("--benchmark-paths") == 0)
+		{
+			g_bBenchmarkPaths = true;
+		}
+		// --benchmark-bvh measures the bounding volume hierarchy
+		else if (argument.compare("--benchmark-bvh") == 0)
+		{
+			g_bBenchmarkBVH = true;
+		}
+		// --animate starts with the monitor and pencil animations playing
+		else if (argument.compare("--animate") == 0)
+		{
+			g_RenderSettings.bAnimate = true;
+		}
+		// --benchmark-animation[=tracks] measures evaluating the animation tracks
+		else if (argument.rfind("--benchmark-animation", 0) == 0)
+		{
+			g_AnimationBenchmarkTracks = 100000;
+			if (argument.rfind("--benchmark-animation=", 0) == 0)
+			{
+				ParseOptionInt(argument, 22, 1, MAX_COUNT_OPTION, g_AnimationBenchmarkTracks);
+			}
+		}
+		// --packed-vertices uploads the imported meshes in the packed format
+		else if (argument.compare("--packed-vertices") == 0)
+		{
+			g_RenderSettings.bPackedVertices = true;
+		}
+		// --benchmark-vertex-formats[=frames] compares the float and packed vertex formats
+		else if (argument.rfind("--benchmark-vertex-formats", 0) == 0)
+		{
+			g_VertexFormatBenchmarkFrames = 100;
+			if (argument.rfind("--benchmark-vertex-formats=", 0) == 0)
+			{
+				ParseOptionInt(argument, 27, 1, MAX_COUNT_OPTION, g_VertexFormatBenchmarkFrames);
+			}
+		}
+		// --transparency=sorted|weighted selects how the blended draws are rendered
+		else if (argument.rfind("--transparency=", 0) == 0)
+		{
+			std::string name = argument.substr(15);
+			g_RenderSettings.transparencyMode = (name.compare("weighted") == 0) ?
+				TransparencyRenderer::TRANSPARENCY_WEIGHTED : TransparencyRenderer::TRANSPARENCY_SORTED;
+		}
+		// --present=vsync|uncapped|limited selects how the frames are paced
+		else if (argument.rfind("--present=", 0) == 0)
+		{
+			std::string name = argument.substr(10);
+			for (int mode = 0; mode < FramePacer::PRESENT_MODE_COUNT; mode++)
+			{
+				if (name.compare(FramePacer::GetModeName(mode)) == 0)
+				{
+					g_RenderSettings.presentMode = mode;
+				}
+			}
+		}
+		// --fps-limit=N paces the frames with the limiter at N frames per second
+		else if (argument.rfind("--fps-limit=", 0) == 0)
+		{
+			g_RenderSettings.presentMode = FramePacer::PRESENT_LIMITED;
+			ParseOptionInt(argument, 12, 1, 1000, g_RenderSettings.frameRateLimit);
+		}
+		// --resolution-scale=X renders the HDR target at a fraction of the window size
+		else if (argument.rfind("--resolution-scale=", 0) == 0)
+		{
+			ParseOptionFloat(argument, 19, 0.05f, 1.0f, g_RenderSettings.resolutionScale);
+		}
+		// --adaptive-resolution[=budgetMs] adapts the resolution scale to a frame budget
+		else if (argument.rfind("--adaptive-resolution", 0) == 0)
+		{
+			g_RenderSettings.bAdaptiveResolution = true;
+			if (argument.rfind("--adaptive-resolution=", 0) == 0)
+			{
+				ParseOptionFloat(argument, 22, 0.1f, 1000.0f, g_RenderSettings.frameBudgetMs);
+			}
+		}
+		// --min-resolution-scale=X limits how far the adaptive resolution may lower the scale
+		else if (argument.rfind("--min-resolution-scale=", 0) == 0)
+		{
+			ParseOptionFloat(argument, 23, 0.05f, 1.0f, g_RenderSettings.minResolutionScale);
+		}
+		// --sharpness=X sets the strength of the upscale sharpening (0 - 1)
+		else if (argument.rfind("--sharpness=", 0) == 0)
+		{
+			ParseOptionFloat(argument, 12, 0.0f, 1.0f, g_RenderSettings.upscaleSharpness);
+		}
+		// --benchmark-resolution[=frames] compares fixed resolution scales with the adaptive one
+		else if (argument.rfind("--benchmark-resolution", 0) == 0)
+		{
+			g_ResolutionBenchmarkFrames = 100;
+			if (argument.rfind("--benchmark-resolution=", 0) == 0)
+			{
+				ParseOptionInt(argument, 23, 1, MAX_COUNT_OPTION, g_ResolutionBenchmarkFrames);
+			}
+		}
+		// --lightmaps starts with the static draws lit from the baked lightmaps
+		else if (argument.compare("--lightmaps") == 0)
+		{
+			g_RenderSettings.bLightmaps = true;
+		}
+		// --no-lightmap-occlusion bakes the lightmaps without shadow rays
+		else if (argument.compare("--no-lightmap-occlusion") == 0)
+		{
+			g_RenderSettings.bLightmapOcclusion = false;
+		}
+		// --bake-lightmaps bakes the lightmaps again instead of loading the saved atlas
+		else if (argument.compare("--bake-lightmaps") == 0)
+		{
+			g_bBakeLightmaps = true;
+		}
+		// --benchmark-lightmaps[=frames] compares the per pixel lighting with the baked lightmaps
+		else if (argument.rfind("--benchmark-lightmaps", 0) == 0)
+		{
+			g_LightmapBenchmarkFrames = 100;
+			if (argument.rfind("--benchmark-lightmaps=", 0) == 0)
+			{
+				ParseOptionInt(argument, 22, 1, MAX_COUNT_OPTION, g_LightmapBenchmarkFrames);
+			}
+		}
+		// --ssao[=quality] starts with the ambient occlusion at a quality level
+		else if ((argument.compare("--ssao") == 0) || (argument.rfind("--ssao=", 0) == 0))
+		{
+			g_RenderSettings.ambientOcclusionQuality = AmbientOcclusion::QUALITY_MEDIUM;
+			if (argument.rfind("--ssao=", 0) == 0)
+			{
+				ParseOptionInt(argument, 7, 0, AmbientOcclusion::QUALITY_COUNT - 1, g_RenderSettings.ambientOcclusionQuality);
+			}
+		}
+		// --particles=N throws N particles over the desk
+		else if (argument.rfind("--particles=", 0) == 0)
+		{
+			ParseOptionInt(argument, 12, 0, (int)ParticleSystem::MAX_PARTICLES, g_RenderSettings.particleCount);
+		}
+		// --particle-simulation=auto|gpu|cpu selects where the particles are simulated
+		else if (argument.rfind("--particle-simulation=", 0) == 0)
+		{
+			std::string name = argument.substr(22);
+			for (int mode = 0; mode < ParticleSystem::SIMULATION_MODE_COUNT; mode++)
+			{
+				if (name.compare(ParticleSystem::GetModeName(mode)) == 0)
+				{
+					g_RenderSettings.particleSimulation = mode;
+				}
+			}
+		}
+		// --benchmark-particles[=frames] measures simulating and drawing up to a million particles
+		else if (argument.rfind("--benchmark-particles", 0) == 0)
+		{
+			g_ParticleBenchmarkFrames = 100;
+			if (argument.rfind("--benchmark-particles=", 0) == 0)
+			{
+				ParseOptionInt(argument, 22, 1, MAX_COUNT_OPTION, g_ParticleBenchmarkFrames);
+			}
+		}
+		// --benchmark-normals[=frames] measures the per vertex cost of transforming the normals
+		else if (argument.rfind("--benchmark-normals", 0) == 0)
+		{
+			g_NormalBenchmarkFrames = 100;
+			if (argument.rfind("--benchmark-normals=", 0) == 0)
+			{
+				ParseOptionInt(argument, 20, 1, MAX_COUNT_OPTION, g_NormalBenchmarkFrames);
+			}
+		}
+		// --benchmark-ssao[=frames] measures the ambient occlusion at each quality level
+		else if (argument.rfind("--benchmark-ssao", 0) == 0)
+		{
+			g_AmbientOcclusionBenchmarkFrames = 100;
+			if (argument.rfind("--benchmark-ssao=", 0) == 0)
+			{
+				ParseOptionInt(argument, 17, 1, MAX_COUNT_OPTION, g_AmbientOcclusionBenchmarkFrames);
+			}
+		}
+		// --benchmark-transparency[=frames] compares the sorted and weighted blended transparency
+		else if (argument.rfind("--benchmark-transparency", 0) == 0)
+		{
+			g_TransparencyBenchmarkFrames = 100;
+			if (argument.rfind("--benchmark-transparency=", 0) == 0)
+			{
+				ParseOptionInt(argument, 25, 1, MAX_COUNT_OPTION, g_TransparencyBenchmarkFrames);
+			}
+		}
+		// --benchmark-mesh=file measures importing a mesh file
+		else if (argument.rfind("--benchmark-mesh=", 0) == 0)
+		{
+			g_MeshBenchmarkFile = argument.substr(17);
+		}
+		// --no-culling draws the objects outside of the view as well
+		else if (argument.compare("--no-culling") == 0)
+		{
+			g_RenderSettings.bFrustumCulling = false;
+		}
+		// --occlusion-culling starts with the Hi-Z occlusion culling
+		else if (argument.compare("--occlusion-culling") == 0)
+		{
+			g_RenderSettings.bOcclusionCulling = true;
+		}
+		// --benchmark-occlusion[=frames] compares occlusion culling off and on
+		else if (argument.rfind("--benchmark-occlusion", 0) == 0)
+		{
+			g_OcclusionBenchmarkFrames = 200;
+			if (argument.rfind("--benchmark-occlusion=", 0) == 0)
+			{
+				ParseOptionInt(argument, 22, 1, MAX_COUNT_OPTION, g_OcclusionBenchmarkFrames);
+			}
+		}
+		// --multi-view starts with the front, side, top and camera views
+		else if (argument.compare("--multi-view") == 0)
+		{
+			g_RenderSettings.bMultiView = true;
+		}
+		// --benchmark-views[=frames] compares one view with four views
+		else if (argument.rfind("--benchmark-views", 0) == 0)
+		{
+			g_ViewBenchmarkFrames = 200;
+			if (argument.rfind("--benchmark-views=", 0) == 0)
+			{
+				ParseOptionInt(argument, 18, 1, MAX_COUNT_OPTION, g_ViewBenchmarkFrames);
+			}
+		}
+		// --snapshot=file maps the prepared scene from a snapshot file,
+		// writing it first when missing or saved with other options
+		else if (argument.rfind("--snapshot=", 0) == 0)
+		{
+			g_SnapshotFile = argument.substr(11);
+		}
+		// --benchmark-snapshot compares rebuilding the scene with mapping its snapshot
+		else if (argument.compare("--benchmark-snapshot") == 0)
+		{
+			g_bBenchmarkSnapshot = true;
+		}
+		// --office-desks=N replicates the desk into an office of N desks
+		else if (argument.rfind("--office-desks=", 0) == 0)
+		{
+			ParseOptionInt(argument, 15, 0, OfficeGenerator::MAX_DESKS, g_RenderSettings.officeDeskCount);
+		}
+		// --office-seed=S selects the generated office
+		else if (argument.rfind("--office-seed=", 0) == 0)
+		{
+			ParseOptionSeed(argument, 14, g_RenderSettings.officeSeed);
+		}
+		// --benchmark-office[=frames] sweeps the office from 1 to 10,000 desks
+		else if (argument.rfind("--benchmark-office", 0) == 0)
+		{
+			g_OfficeBenchmarkFrames = 50;
+			if (argument.rfind("--benchmark-office=", 0) == 0)
+			{
+				ParseOptionInt(argument, 19, 1, MAX_COUNT_OPTION, g_OfficeBenchmarkFrames);
+			}
+		}
+		// --texture-budget=MB limits the memory of the streamed texture levels
+		else if (argument.rfind("--texture-budget=", 0) == 0)
+		{
+			ParseOptionInt(argument, 17, 0, MAX_COUNT_OPTION, g_RenderSettings.textureBudgetMB);
+		}
+		// --bake-textures writes compressed textures next to the images
+		else if (argument.compare("--bake-textures") == 0)
+		{
+			g_RenderSettings.bBakeTextures = true;
+		}
+		else
+		{
+			std::cout << "Unknown command line option:" << argument << std::endl;
+		}
+	}
+
+	// storing the golden images runs the regression check
+	if (g_bUpdateGolden && g_RegressionDirectory.empty())
+	{
+		g_RegressionDirectory = "../regression";
+	}
 }
 
 /***********************************************************
@@ -0,0 +1,209 @@
+///////////////////////////////////////////////////////////////////////////////
+// materialtable.cpp
+// ============
+// keep the object materials in a GPU buffer indexed by the draws
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MaterialTable.h"
+
+#include <algorithm>
+
+// declare the global variables
+namespace
+{
+	// materials the buffer has room for when first created
+	const int INITIAL_CAPACITY = 16;
+}
+
+/***********************************************************
+ *  MaterialTable()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+MaterialTable::MaterialTable()
+{
+	m_dirtyFirst = 0;
+	m_dirtyEnd = 0;
+	m_buffer = 0;
+	m_texture = 0;
+	m_capacity = 0;
+	m_uploadedBytes = 0;
+}
+
+/***********************************************************
+ *  ~MaterialTable()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+MaterialTable::~MaterialTable()
+{
+	if (m_texture != 0)
+	{
+		glDeleteTextures(1, &m_texture);
+	}
+	if (m_buffer != 0)
+	{
+		glDeleteBuffers(1, &m_buffer);
+	}
+	m_materials.clear();
+	m_texels.clear();
+}
+
+/***********************************************************
+ *  AddMaterial()
+ *
+ *  This method is used for adding a material to the end of
+ *  the table.  It is uploaded with the next dirty range.
+ ***********************************************************/
+int MaterialTable::AddMaterial(const MATERIAL& material)
+{
+	int index = (int)m_materials.size();
+	m_materials.push_back(material);
+	m_texels.resize(m_materials.size() * TEXELS_PER_MATERIAL);
+	UpdateMaterial(index, material);
+
+	return(index);
+}
+
+/***********************************************************
+ *  UpdateMaterial()
+ *
+ *  This method is used for replacing the values of the
+ *  material at the passed in index and growing the dirty
+ *  range of the table to cover it.
+ ***********************************************************/
+void MaterialTable::UpdateMaterial(int index, const MATERIAL& material)
+{
+	if ((index < 0) || (index >= (int)m_materials.size()))
+	{
+		return;
+	}
+
+	m_materials[index] = material;
+	WriteTexels(index);
+
+	if (m_dirtyFirst >= m_dirtyEnd)
+	{
+		m_dirtyFirst = index;
+		m_dirtyEnd = index + 1;
+	}
+	else
+	{
+		m_dirtyFirst = std::min(m_dirtyFirst, index);
+		m_dirtyEnd = std::max(m_dirtyEnd, index + 1);
+	}
+}
+
+/***********************************************************
+ *  FindMaterial()
+ *
+ *  This method is used for getting the index of the material
+ *  associated with the passed in tag, or -1 when there is no
+ *  such material.
+ ***********************************************************/
+int MaterialTable::FindMaterial(const std::string& tag) const
+{
+	for (int i = 0; i < (int)m_materials.size(); i++)
+	{
+		if (m_materials[i].tag.compare(tag) == 0)
+		{
+			return(i);
+		}
+	}
+	return(-1);
+}
+
+/***********************************************************
+ *  WriteTexels()
+ *
+ *  This method is used for writing the material at the
+ *  passed in index into the texels the shaders read.  The
+ *  alpha mode is stored as a float, which holds the small
+ *  enum values exactly.
+ ***********************************************************/
+void MaterialTable::WriteTexels(int index)
+{
+	const MATERIAL& material = m_materials[index];
+	glm::vec4* texels = &m_texels[index * TEXELS_PER_MATERIAL];
+
+	texels[0] = glm::vec4(material.diffuseColor, material.shininess);
+	texels[1] = glm::vec4(material.specularColor, glm::clamp(material.roughness, 0.0f, 1.0f));
+	texels[2] = glm::vec4(material.emissiveColor, (float)material.alphaMode);
+}
+
+/***********************************************************
+ *  Upload()
+ *
+ *  This method is used for copying the dirty range of the
+ *  table into the buffer.  When the table has outgrown the
+ *  buffer, the buffer is reallocated at twice the size and
+ *  the whole table is uploaded instead.
+ ***********************************************************/
+void MaterialTable::Upload()
+{
+	m_uploadedBytes = 0;
+	if (m_materials.empty())
+	{
+		return;
+	}
+
+	if (m_buffer == 0)
+	{
+		glGenBuffers(1, &m_buffer);
+		glGenTextures(1, &m_texture);
+	}
+
+	if (m_capacity < (int)m_materials.size())
+	{
+		m_capacity = std::max(m_capacity * 2, INITIAL_CAPACITY);
+		while (m_capacity < (int)m_materials.size())
+		{
+			m_capacity *= 2;
+		}
+
+		glBindBuffer(GL_TEXTURE_BUFFER, m_buffer);
+		glBufferData(GL_TEXTURE_BUFFER, m_capacity * TEXELS_PER_MATERIAL * sizeof(glm::vec4), NULL, GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+		glBindTexture(GL_TEXTURE_BUFFER, m_texture);
+		glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, m_buffer);
+		glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+		m_dirtyFirst = 0;
+		m_dirtyEnd = (int)m_materials.size();
+	}
+
+	if (m_dirtyFirst >= m_dirtyEnd)
+	{
+		return;
+	}
+
+	GLintptr offset = m_dirtyFirst * TEXELS_PER_MATERIAL * sizeof(glm::vec4);
+	GLsizeiptr size = (m_dirtyEnd - m_dirtyFirst) * TEXELS_PER_MATERIAL * sizeof(glm::vec4);
+	glBindBuffer(GL_TEXTURE_BUFFER, m_buffer);
+	glBufferSubData(GL_TEXTURE_BUFFER, offset, size, &m_texels[m_dirtyFirst * TEXELS_PER_MATERIAL]);
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+	m_uploadedBytes = size;
+	m_dirtyFirst = 0;
+	m_dirtyEnd = 0;
+}
+
+/***********************************************************
+ *  ApplyToShader()
+ *
+ *  This method is used for binding the table to the passed
+ *  in texture unit and pointing the material sampler of the
+ *  passed in shader at it.
+ ***********************************************************/
+void MaterialTable::ApplyToShader(ShaderManager* pShaderManager, int textureUnit) const
+{
+	if (NULL == pShaderManager)
+	{
+		return;
+	}
+
+	glActiveTexture(GL_TEXTURE0 + textureUnit);
+	glBindTexture(GL_TEXTURE_BUFFER, m_texture);
+	pShaderManager->setIntValue("materials", textureUnit);
+}
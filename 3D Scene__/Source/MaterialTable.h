@@ -0,0 +1,100 @@
+///////////////////////////////////////////////////////////////////////////////
+// materialtable.h
+// ============
+// keep the object materials in a GPU buffer indexed by the draws
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderManager.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  MaterialTable
+ *
+ *  This class holds every object material and a copy of
+ *  them in a texture buffer, so that the shaders can fetch
+ *  the material of a draw from its index instead of having
+ *  its values set as uniforms before every draw.  Changed
+ *  materials only mark a range of the table as dirty, and
+ *  that range is uploaded once before the next frame.
+ ***********************************************************/
+class MaterialTable
+{
+public:
+	// constructor
+	MaterialTable();
+	// destructor
+	~MaterialTable();
+
+	// how the alpha of the surface color is used
+	enum ALPHA_MODE
+	{
+		// the surface covers whatever is behind it
+		ALPHA_OPAQUE,
+		// the surface is blended with the alpha of its color
+		ALPHA_BLEND
+	};
+
+	// properties of one material
+	struct MATERIAL
+	{
+		glm::vec3 diffuseColor = glm::vec3(1.0f);
+		glm::vec3 specularColor = glm::vec3(0.0f);
+		float shininess = 1.0f;
+		// 0 keeps the highlight as sharp as the shininess makes
+		// it, 1 spreads it over most of the surface
+		float roughness = 0.0f;
+		// light given off by the surface itself
+		glm::vec3 emissiveColor = glm::vec3(0.0f);
+		ALPHA_MODE alphaMode = ALPHA_OPAQUE;
+		std::string tag;
+	};
+
+	// texels of the table per material: diffuse and shininess,
+	// specular and roughness, emissive and alpha mode
+	static const int TEXELS_PER_MATERIAL = 3;
+
+	// add a material, returning its index in the table
+	int AddMaterial(const MATERIAL& material);
+	// replace the values of a material, marking it for upload
+	void UpdateMaterial(int index, const MATERIAL& material);
+	// get the index of the material with the passed in tag
+	// (-1 = not found)
+	int FindMaterial(const std::string& tag) const;
+	// get the material at an index of the table
+	const MATERIAL& GetMaterial(int index) const { return m_materials[index]; }
+	int GetMaterialCount() const { return (int)m_materials.size(); }
+
+	// upload the dirty range of the table, growing the buffer
+	// when materials were added beyond its capacity
+	void Upload();
+	// bind the table to a texture unit of the passed in shader
+	void ApplyToShader(ShaderManager* pShaderManager, int textureUnit) const;
+
+	// bytes written to the buffer by the last upload
+	size_t GetUploadedBytes() const { return m_uploadedBytes; }
+
+private:
+	// write the texels of one material into the staging copy
+	void WriteTexels(int index);
+
+	// materials in table order
+	std::vector<MATERIAL> m_materials;
+	// texels of every material, as the shaders read them
+	std::vector<glm::vec4> m_texels;
+	// materials changed since the last upload [first, end)
+	int m_dirtyFirst;
+	int m_dirtyEnd;
+	// buffer and the texture reading it, created on first upload
+	GLuint m_buffer;
+	GLuint m_texture;
+	// materials the buffer has room for
+	int m_capacity;
+	size_t m_uploadedBytes;
+};
@@ -0,0 +1,1812 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshimporter.cpp
+// ============
+// load indexed triangle meshes from OBJ and glTF files and optimize them
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MeshImporter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <unordered_map>
+
+// declare the global variables
+namespace
+{
+	// a cluster is split once its own cache miss ratio is this
+	// close to the ratio of the whole cluster, which keeps the
+	// sorted clusters from undoing the vertex cache order
+	const float OVERDRAW_THRESHOLD = 1.05f;
+	// deepest glTF node hierarchy that is followed
+	const int MAX_NODE_DEPTH = 64;
+	// deepest nesting of glTF JSON values that is parsed
+	const int MAX_JSON_DEPTH = 128;
+
+	// glTF binary container identifiers
+	const unsigned int GLB_MAGIC = 0x46546C67;
+	const unsigned int GLB_CHUNK_JSON = 0x4E4F534A;
+	const unsigned int GLB_CHUNK_BIN = 0x004E4942;
+
+	// glTF accessor component types
+	const int GLTF_BYTE = 5120;
+	const int GLTF_UNSIGNED_BYTE = 5121;
+	const int GLTF_SHORT = 5122;
+	const int GLTF_UNSIGNED_SHORT = 5123;
+	const int GLTF_UNSIGNED_INT = 5125;
+	const int GLTF_FLOAT = 5126;
+	// glTF primitive mode of triangle lists
+	const int GLTF_TRIANGLES = 4;
+	// largest value of the 16-bit integers of the packed format
+	const float PACKED_MAX = 32767.0f;
+
+	// convert a steady clock duration into milliseconds
+	double ElapsedMs(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	/***********************************************************
+	 *  ReadFile()
+	 *
+	 *  This function is used to read a whole file into memory.
+	 ***********************************************************/
+	bool ReadFile(const std::string& filename, std::vector<char>& data)
+	{
+		std::ifstream file(filename, std::ios::binary | std::ios::ate);
+		if (!file.is_open())
+		{
+			return(false);
+		}
+		std::streamsize size = file.tellg();
+		file.seekg(0, std::ios::beg);
+		data.resize((size_t)size);
+		return((size == 0) || (bool)file.read(data.data(), size));
+	}
+
+	// one parsed JSON value - objects keep their keys next to
+	// the member values
+	struct JSON_VALUE
+	{
+		enum JSON_TYPE { JSON_NULL, JSON_BOOL, JSON_NUMBER, JSON_STRING, JSON_ARRAY, JSON_OBJECT };
+
+		JSON_TYPE type = JSON_NULL;
+		double number = 0.0;
+		std::string text;
+		std::vector<JSON_VALUE> items;
+		std::vector<std::string> keys;
+
+		// get the member of an object, or NULL if missing
+		const JSON_VALUE* Find(const char* key) const
+		{
+			for (int i = 0; i < (int)keys.size(); i++)
+			{
+				if (keys[i].compare(key) == 0)
+				{
+					return(&items[i]);
+				}
+			}
+			return(NULL);
+		}
+
+		// get a numeric member of an object, or the fallback
+		double GetNumber(const char* key, double fallback) const
+		{
+			const JSON_VALUE* pValue = Find(key);
+			return ((NULL != pValue) && (pValue->type == JSON_NUMBER)) ? pValue->number : fallback;
+		}
+
+		// get an element of an array member, or NULL if missing
+		const JSON_VALUE* FindItem(const char* key, int index) const
+		{
+			const JSON_VALUE* pArray = Find(key);
+			if ((NULL == pArray) || (pArray->type != JSON_ARRAY) || (index < 0) || (index >= (int)pArray->items.size()))
+			{
+				return(NULL);
+			}
+			return(&pArray->items[index]);
+		}
+	};
+
+	void SkipWhitespace(const char*& p, const char* end)
+	{
+		while ((p < end) && ((*p == ' ') || (*p == '\t') || (*p == '\n') || (*p == '\r')))
+		{
+			p++;
+		}
+	}
+
+	/***********************************************************
+	 *  ParseJsonString()
+	 *
+	 *  This function is used to parse a quoted JSON string,
+	 *  encoding escaped code points as UTF-8.
+	 ***********************************************************/
+	bool ParseJsonString(const char*& p, const char* end, std::string& text)
+	{
+		if ((p >= end) || (*p != '"'))
+		{
+			return(false);
+		}
+		p++;
+		text.clear();
+		while ((p < end) && (*p != '"'))
+		{
+			if (*p != '\\')
+			{
+				text.push_back(*p++);
+				continue;
+			}
+			if (++p >= end)
+			{
+				return(false);
+			}
+			char escape = *p++;
+			switch (escape)
+			{
+			case 'b': text.push_back('\b'); break;
+			case 'f': text.push_back('\f'); break;
+			case 'n': text.push_back('\n'); break;
+			case 'r': text.push_back('\r'); break;
+			case 't': text.push_back('\t'); break;
+			case 'u':
+			{
+				if (end - p < 4)
+				{
+					return(false);
+				}
+				unsigned int code = (unsigned int)std::strtoul(std::string(p, 4).c_str(), NULL, 16);
+				p += 4;
+				if (code < 0x80)
+				{
+					text.push_back((char)code);
+				}
+				else if (code < 0x800)
+				{
+					text.push_back((char)(0xC0 | (code >> 6)));
+					text.push_back((char)(0x80 | (code & 0x3F)));
+				}
+				else
+				{
+					text.push_back((char)(0xE0 | (code >> 12)));
+					text.push_back((char)(0x80 | ((code >> 6) & 0x3F)));
+					text.push_back((char)(0x80 | (code & 0x3F)));
+				}
+				break;
+			}
+			default: text.push_back(escape); break;
+			}
+		}
+		if (p >= end)
+		{
+			return(false);
+		}
+		p++;
+		return(true);
+	}
+
+	/***********************************************************
+	 *  ParseJsonValue()
+	 *
+	 *  This function is used to parse one JSON value and all
+	 *  the values nested in it.
+	 ***********************************************************/
+	bool ParseJsonValue(const char*& p, const char* end, JSON_VALUE& value, int depth)
+	{
+		SkipWhitespace(p, end);
+		if ((p >= end) || (depth > MAX_JSON_DEPTH))
+		{
+			return(false);
+		}
+
+		if (*p == '{')
+		{
+			value.type = JSON_VALUE::JSON_OBJECT;
+			p++;
+			SkipWhitespace(p, end);
+			if ((p < end) && (*p == '}'))
+			{
+				p++;
+				return(true);
+			}
+			while (p < end)
+			{
+				std::string key;
+				SkipWhitespace(p, end);
+				if (!ParseJsonString(p, end, key))
+				{
+					return(false);
+				}
+				SkipWhitespace(p, end);
+				if ((p >= end) || (*p != ':'))
+				{
+					return(false);
+				}
+				p++;
+				value.keys.push_back(key);
+				value.items.push_back(JSON_VALUE());
+				if (!ParseJsonValue(p, end, value.items.back(), depth + 1))
+				{
+					return(false);
+				}
+				SkipWhitespace(p, end);
+				if ((p < end) && (*p == ','))
+				{
+					p++;
+				}
+				else if ((p < end) && (*p == '}'))
+				{
+					p++;
+					return(true);
+				}
+				else
+				{
+					return(false);
+				}
+			}
+			return(false);
+		}
+		if (*p == '[')
+		{
+			value.type = JSON_VALUE::JSON_ARRAY;
+			p++;
+			SkipWhitespace(p, end);
+			if ((p < end) && (*p == ']'))
+			{
+				p++;
+				return(true);
+			}
+			while (p < end)
+			{
+				value.items.push_back(JSON_VALUE());
+				if (!ParseJsonValue(p, end, value.items.back(), depth + 1))
+				{
+					return(false);
+				}
+				SkipWhitespace(p, end);
+				if ((p < end) && (*p == ','))
+				{
+					p++;
+				}
+				else if ((p < end) && (*p == ']'))
+				{
+					p++;
+					return(true);
+				}
+				else
+				{
+					return(false);
+				}
+			}
+			return(false);
+		}
+		if (*p == '"')
+		{
+			value.type = JSON_VALUE::JSON_STRING;
+			return(ParseJsonString(p, end, value.text));
+		}
+		if ((end - p >= 4) && (strncmp(p, "true", 4) == 0))
+		{
+			value.type = JSON_VALUE::JSON_BOOL;
+			value.number = 1.0;
+			p += 4;
+			return(true);
+		}
+		if ((end - p >= 5) && (strncmp(p, "false", 5) == 0))
+		{
+			value.type = JSON_VALUE::JSON_BOOL;
+			p += 5;
+			return(true);
+		}
+		if ((end - p >= 4) && (strncmp(p, "null", 4) == 0))
+		{
+			p += 4;
+			return(true);
+		}
+
+		// the number ends at the first character strtod rejects,
+		// which is always followed by a delimiter in valid JSON
+		char* pNumberEnd = NULL;
+		value.type = JSON_VALUE::JSON_NUMBER;
+		value.number = std::strtod(p, &pNumberEnd);
+		if ((pNumberEnd == p) || (pNumberEnd > end))
+		{
+			return(false);
+		}
+		p = pNumberEnd;
+		return(true);
+	}
+
+	/***********************************************************
+	 *  DecodeBase64()
+	 *
+	 *  This function is used to decode the base64 payload of a
+	 *  data URI embedded in a glTF file.
+	 ***********************************************************/
+	void DecodeBase64(const std::string& text, std::vector<unsigned char>& data)
+	{
+		data.clear();
+		unsigned int bits = 0;
+		int bitCount = 0;
+		for (char c : text)
+		{
+			int value = -1;
+			if ((c >= 'A') && (c <= 'Z')) value = c - 'A';
+			else if ((c >= 'a') && (c <= 'z')) value = c - 'a' + 26;
+			else if ((c >= '0') && (c <= '9')) value = c - '0' + 52;
+			else if (c == '+') value = 62;
+			else if (c == '/') value = 63;
+			else continue;
+
+			bits = (bits << 6) | (unsigned int)value;
+			bitCount += 6;
+			if (bitCount >= 8)
+			{
+				bitCount -= 8;
+				data.push_back((unsigned char)((bits >> bitCount) & 0xFF));
+			}
+		}
+	}
+
+	// hash of the raw bytes of a vertex, used to merge the
+	// identical vertices of the glTF primitives
+	struct VertexHash
+	{
+		size_t operator()(const MeshImporter::MESH_VERTEX& vertex) const
+		{
+			const unsigned char* pBytes = (const unsigned char*)&vertex;
+			size_t hash = 2166136261u;
+			for (int i = 0; i < (int)sizeof(MeshImporter::MESH_VERTEX); i++)
+			{
+				hash = (hash ^ pBytes[i]) * 16777619u;
+			}
+			return(hash);
+		}
+	};
+	struct VertexEqual
+	{
+		bool operator()(const MeshImporter::MESH_VERTEX& a, const MeshImporter::MESH_VERTEX& b) const
+		{
+			return(memcmp(&a, &b, sizeof(MeshImporter::MESH_VERTEX)) == 0);
+		}
+	};
+
+	// position, texture coordinate and normal indices of one
+	// corner of an OBJ face (-1 = not given)
+	struct OBJ_CORNER
+	{
+		int position;
+		int texture;
+		int normal;
+
+		bool operator==(const OBJ_CORNER& other) const
+		{
+			return((position == other.position) && (texture == other.texture) && (normal == other.normal));
+		}
+	};
+	struct CornerHash
+	{
+		size_t operator()(const OBJ_CORNER& corner) const
+		{
+			return((size_t)corner.position * 73856093u ^ (size_t)corner.texture * 19349663u ^ (size_t)corner.normal * 83492791u);
+		}
+	};
+
+	/***********************************************************
+	 *  ParseOBJIndex()
+	 *
+	 *  This function is used to convert a one based or negative
+	 *  relative OBJ index into a zero based one, or -1 if it is
+	 *  out of range.
+	 ***********************************************************/
+	int ParseOBJIndex(const char*& p, int count)
+	{
+		char* pEnd = NULL;
+		long index = std::strtol(p, &pEnd, 10);
+		if (pEnd == p)
+		{
+			return(-1);
+		}
+		p = pEnd;
+		long resolved = (index < 0) ? (count + index) : (index - 1);
+		return(((resolved >= 0) && (resolved < count)) ? (int)resolved : -1);
+	}
+
+	/***********************************************************
+	 *  QuaternionToMatrix()
+	 *
+	 *  This function is used to convert a glTF node rotation
+	 *  (x, y, z, w) into a rotation matrix.
+	 ***********************************************************/
+	glm::mat4 QuaternionToMatrix(float x, float y, float z, float w)
+	{
+		glm::mat4 rotation(1.0f);
+		rotation[0] = glm::vec4(1.0f - 2.0f * (y * y + z * z), 2.0f * (x * y + z * w), 2.0f * (x * z - y * w), 0.0f);
+		rotation[1] = glm::vec4(2.0f * (x * y - z * w), 1.0f - 2.0f * (x * x + z * z), 2.0f * (y * z + x * w), 0.0f);
+		rotation[2] = glm::vec4(2.0f * (x * z + y * w), 2.0f * (y * z - x * w), 1.0f - 2.0f * (x * x + y * y), 0.0f);
+		return(rotation);
+	}
+
+	/***********************************************************
+	 *  FloatToHalf()
+	 *
+	 *  This function is used to convert a float into the bits
+	 *  of a half float, rounding to the nearest even value.
+	 *  Values out of range become infinity and the smallest
+	 *  ones become denormals or zero.
+	 ***********************************************************/
+	unsigned short FloatToHalf(float value)
+	{
+		unsigned int bits;
+		memcpy(&bits, &value, 4);
+		unsigned int sign = (bits >> 16) & 0x8000;
+		int exponent = (int)((bits >> 23) & 0xFF) - 127 + 15;
+		unsigned int mantissa = bits & 0x7FFFFF;
+
+		if (((bits >> 23) & 0xFF) == 0xFF)
+		{
+			// infinity and NaN keep a mantissa bit for NaN
+			return((unsigned short)(sign | 0x7C00 | (mantissa ? 0x200 : 0)));
+		}
+		if (exponent >= 31)
+		{
+			return((unsigned short)(sign | 0x7C00));
+		}
+		if (exponent <= 0)
+		{
+			if (exponent < -10)
+			{
+				return((unsigned short)sign);
+			}
+			mantissa |= 0x800000;
+			int shift = 14 - exponent;
+			unsigned int half = mantissa >> shift;
+			unsigned int remainder = mantissa & ((1u << shift) - 1);
+			unsigned int halfway = 1u << (shift - 1);
+			if ((remainder > halfway) || ((remainder == halfway) && (half & 1)))
+			{
+				half++;
+			}
+			return((unsigned short)(sign | half));
+		}
+
+		unsigned int half = ((unsigned int)exponent << 10) | (mantissa >> 13);
+		unsigned int remainder = mantissa & 0x1FFF;
+		if ((remainder > 0x1000) || ((remainder == 0x1000) && (half & 1)))
+		{
+			// a carry into the exponent rounds up correctly
+			half++;
+		}
+		return((unsigned short)(sign | half));
+	}
+
+	/***********************************************************
+	 *  HalfToFloat()
+	 *
+	 *  This function is used to convert the bits of a half
+	 *  float back into a float.
+	 ***********************************************************/
+	float HalfToFloat(unsigned short half)
+	{
+		unsigned int sign = (unsigned int)(half & 0x8000) << 16;
+		unsigned int exponent = (half >> 10) & 0x1F;
+		unsigned int mantissa = half & 0x3FF;
+		unsigned int bits;
+		if (exponent == 0x1F)
+		{
+			bits = sign | 0x7F800000 | (mantissa << 13);
+		}
+		else if (exponent != 0)
+		{
+			bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+		}
+		else if (mantissa == 0)
+		{
+			bits = sign;
+		}
+		else
+		{
+			// renormalize a denormal
+			exponent = 127 - 15 + 1;
+			while ((mantissa & 0x400) == 0)
+			{
+				mantissa <<= 1;
+				exponent--;
+			}
+			bits = sign | (exponent << 23) | ((mantissa & 0x3FF) << 13);
+		}
+		float value;
+		memcpy(&value, &bits, 4);
+		return(value);
+	}
+
+	/***********************************************************
+	 *  DecodeOctahedral()
+	 *
+	 *  This function is used to turn a point of the octahedral
+	 *  map in [-1, 1] back into a unit vector, matching the
+	 *  decoding in the vertex shader.
+	 ***********************************************************/
+	glm::vec3 DecodeOctahedral(glm::vec2 encoded)
+	{
+		glm::vec3 normal = glm::vec3(encoded.x, encoded.y, 1.0f - std::fabs(encoded.x) - std::fabs(encoded.y));
+		float fold = glm::max(-normal.z, 0.0f);
+		normal.x += (normal.x >= 0.0f) ? -fold : fold;
+		normal.y += (normal.y >= 0.0f) ? -fold : fold;
+		return(glm::normalize(normal));
+	}
+
+	/***********************************************************
+	 *  EncodeOctahedral()
+	 *
+	 *  This function is used to map a unit vector onto the
+	 *  octahedron and unfold the lower half over the corners
+	 *  of the square.  Of the four integer points around the
+	 *  exact position, the one decoding closest to the vector
+	 *  is kept, which halves the worst error of rounding.
+	 ***********************************************************/
+	void EncodeOctahedral(glm::vec3 normal, short encoded[2])
+	{
+		float length = std::fabs(normal.x) + std::fabs(normal.y) + std::fabs(normal.z);
+		if (length <= 0.0f)
+		{
+			encoded[0] = 0;
+			encoded[1] = (short)PACKED_MAX;
+			return;
+		}
+		normal /= length;
+		glm::vec2 point = glm::vec2(normal.x, normal.y);
+		if (normal.z < 0.0f)
+		{
+			point = glm::vec2(
+				(1.0f - std::fabs(normal.y)) * ((normal.x >= 0.0f) ? 1.0f : -1.0f),
+				(1.0f - std::fabs(normal.x)) * ((normal.y >= 0.0f) ? 1.0f : -1.0f));
+		}
+
+		glm::vec3 target = glm::normalize(normal);
+		glm::vec2 scaled = glm::clamp(point, glm::vec2(-1.0f), glm::vec2(1.0f)) * PACKED_MAX;
+		float bestDot = -2.0f;
+		for (int i = 0; i < 4; i++)
+		{
+			float x = (i & 1) ? std::ceil(scaled.x) : std::floor(scaled.x);
+			float y = (i & 2) ? std::ceil(scaled.y) : std::floor(scaled.y);
+			float dot = glm::dot(DecodeOctahedral(glm::vec2(x, y) / PACKED_MAX), target);
+			if (dot > bestDot)
+			{
+				bestDot = dot;
+				encoded[0] = (short)x;
+				encoded[1] = (short)y;
+			}
+		}
+	}
+
+	// parsed glTF document and the contents of its buffers
+	struct GLTF_DOCUMENT
+	{
+		JSON_VALUE json;
+		std::vector<std::vector<unsigned char>> buffers;
+	};
+
+	/***********************************************************
+	 *  ReadAccessor()
+	 *
+	 *  This function is used to read the elements of a glTF
+	 *  accessor as floats, converting normalized integers.
+	 *  Index accessors are read through the same path, since
+	 *  a float holds every index a mesh can address exactly
+	 *  up to 2^24.
+	 ***********************************************************/
+	bool ReadAccessor(const GLTF_DOCUMENT& document, int accessorIndex, int components, std::vector<float>& values)
+	{
+		const JSON_VALUE* pAccessor = document.json.FindItem("accessors", accessorIndex);
+		if ((NULL == pAccessor) || (NULL != pAccessor->Find("sparse")))
+		{
+			return(false);
+		}
+
+		const JSON_VALUE* pType = pAccessor->Find("type");
+		int typeComponents = 0;
+		if (NULL != pType)
+		{
+			if (pType->text.compare("SCALAR") == 0) typeComponents = 1;
+			else if (pType->text.compare("VEC2") == 0) typeComponents = 2;
+			else if (pType->text.compare("VEC3") == 0) typeComponents = 3;
+			else if (pType->text.compare("VEC4") == 0) typeComponents = 4;
+		}
+		if (typeComponents != components)
+		{
+			return(false);
+		}
+
+		int count = (int)pAccessor->GetNumber("count", 0.0);
+		int componentType = (int)pAccessor->GetNumber("componentType", 0.0);
+		const JSON_VALUE* pNormalized = pAccessor->Find("normalized");
+		bool bNormalized = (NULL != pNormalized) && (pNormalized->number != 0.0);
+		values.assign((size_t)count * components, 0.0f);
+
+		// accessors without a buffer view are all zeros
+		if (NULL == pAccessor->Find("bufferView"))
+		{
+			return(true);
+		}
+
+		const JSON_VALUE* pView = document.json.FindItem("bufferViews", (int)pAccessor->GetNumber("bufferView", -1.0));
+		if (NULL == pView)
+		{
+			return(false);
+		}
+		int bufferIndex = (int)pView->GetNumber("buffer", -1.0);
+		if ((bufferIndex < 0) || (bufferIndex >= (int)document.buffers.size()))
+		{
+			return(false);
+		}
+		const std::vector<unsigned char>& buffer = document.buffers[bufferIndex];
+
+		int componentSize = 0;
+		switch (componentType)
+		{
+		case GLTF_BYTE: case GLTF_UNSIGNED_BYTE: componentSize = 1; break;
+		case GLTF_SHORT: case GLTF_UNSIGNED_SHORT: componentSize = 2; break;
+		case GLTF_UNSIGNED_INT: case GLTF_FLOAT: componentSize = 4; break;
+		default: return(false);
+		}
+		size_t elementSize = (size_t)componentSize * components;
+		size_t stride = (size_t)pView->GetNumber("byteStride", (double)elementSize);
+		size_t start = (size_t)pView->GetNumber("byteOffset", 0.0) + (size_t)pAccessor->GetNumber("byteOffset", 0.0);
+		if ((count > 0) && (start + stride * (count - 1) + elementSize > buffer.size()))
+		{
+			return(false);
+		}
+
+		for (int i = 0; i < count; i++)
+		{
+			const unsigned char* pElement = buffer.data() + start + stride * i;
+			for (int c = 0; c < components; c++)
+			{
+				const unsigned char* pComponent = pElement + c * componentSize;
+				float value = 0.0f;
+				switch (componentType)
+				{
+				case GLTF_BYTE:
+				{
+					signed char v; memcpy(&v, pComponent, 1);
+					value = bNormalized ? glm::max(v / 127.0f, -1.0f) : (float)v;
+					break;
+				}
+				case GLTF_UNSIGNED_BYTE:
+					value = bNormalized ? (*pComponent / 255.0f) : (float)*pComponent;
+					break;
+				case GLTF_SHORT:
+				{
+					short v; memcpy(&v, pComponent, 2);
+					value = bNormalized ? glm::max(v / 32767.0f, -1.0f) : (float)v;
+					break;
+				}
+				case GLTF_UNSIGNED_SHORT:
+				{
+					unsigned short v; memcpy(&v, pComponent, 2);
+					value = bNormalized ? (v / 65535.0f) : (float)v;
+					break;
+				}
+				case GLTF_UNSIGNED_INT:
+				{
+					unsigned int v; memcpy(&v, pComponent, 4);
+					value = (float)v;
+					break;
+				}
+				case GLTF_FLOAT:
+					memcpy(&value, pComponent, 4);
+					break;
+				}
+				values[(size_t)i * components + c] = value;
+			}
+		}
+		return(true);
+	}
+
+	/***********************************************************
+	 *  ReadIndices()
+	 *
+	 *  This function is used to read a glTF index accessor,
+	 *  which unlike the vertex attributes may hold values that
+	 *  do not fit a float exactly.
+	 ***********************************************************/
+	bool ReadIndices(const GLTF_DOCUMENT& document, int accessorIndex, std::vector<unsigned int>& indices)
+	{
+		const JSON_VALUE* pAccessor = document.json.FindItem("accessors", accessorIndex);
+		if ((NULL == pAccessor) || (NULL != pAccessor->Find("sparse")))
+		{
+			return(false);
+		}
+		const JSON_VALUE* pView = document.json.FindItem("bufferViews", (int)pAccessor->GetNumber("bufferView", -1.0));
+		if (NULL == pView)
+		{
+			return(false);
+		}
+		int bufferIndex = (int)pView->GetNumber("buffer", -1.0);
+		if ((bufferIndex < 0) || (bufferIndex >= (int)document.buffers.size()))
+		{
+			return(false);
+		}
+		const std::vector<unsigned char>& buffer = document.buffers[bufferIndex];
+
+		int count = (int)pAccessor->GetNumber("count", 0.0);
+		int componentType = (int)pAccessor->GetNumber("componentType", 0.0);
+		size_t size = (componentType == GLTF_UNSIGNED_BYTE) ? 1 : ((componentType == GLTF_UNSIGNED_SHORT) ? 2 : 4);
+		if ((componentType != GLTF_UNSIGNED_BYTE) && (componentType != GLTF_UNSIGNED_SHORT) && (componentType != GLTF_UNSIGNED_INT))
+		{
+			return(false);
+		}
+		size_t stride = (size_t)pView->GetNumber("byteStride", (double)size);
+		size_t start = (size_t)pView->GetNumber("byteOffset", 0.0) + (size_t)pAccessor->GetNumber("byteOffset", 0.0);
+		if ((count > 0) && (start + stride * (count - 1) + size > buffer.size()))
+		{
+			return(false);
+		}
+
+		indices.resize(count);
+		for (int i = 0; i < count; i++)
+		{
+			const unsigned char* pIndex = buffer.data() + start + stride * i;
+			if (size == 1)
+			{
+				indices[i] = *pIndex;
+			}
+			else if (size == 2)
+			{
+				unsigned short v; memcpy(&v, pIndex, 2);
+				indices[i] = v;
+			}
+			else
+			{
+				memcpy(&indices[i], pIndex, 4);
+			}
+		}
+		return(true);
+	}
+}
+
+/***********************************************************
+ *  LoadMesh()
+ *
+ *  This method is used for loading the mesh of a file by
+ *  its extension, then optimizing it.  The cache miss ratio
+ *  is measured before and after the optimization.
+ ***********************************************************/
+bool MeshImporter::LoadMesh(const std::string& filename, IMPORTED_MESH& mesh, IMPORT_STATS& stats)
+{
+	stats = IMPORT_STATS();
+	mesh.vertices.clear();
+	mesh.indices.clear();
+
+	std::string extension = filename.substr(filename.find_last_of('.') + 1);
+	std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+
+	auto start = std::chrono::steady_clock::now();
+	bool bLoaded = false;
+	if (extension.compare("obj") == 0)
+	{
+		bLoaded = LoadOBJ(filename, mesh, stats);
+	}
+	else if ((extension.compare("gltf") == 0) || (extension.compare("glb") == 0))
+	{
+		bLoaded = LoadGLTF(filename, mesh, stats);
+	}
+	else
+	{
+		std::cout << "Unsupported mesh file:" << filename << std::endl;
+		return(false);
+	}
+	if (!bLoaded || mesh.indices.empty())
+	{
+		return(false);
+	}
+	stats.loadMs = ElapsedMs(start);
+
+	stats.acmrBefore = CalculateACMR(mesh.indices, (int)mesh.vertices.size());
+	start = std::chrono::steady_clock::now();
+	OptimizeMesh(mesh);
+	stats.optimizeMs = ElapsedMs(start);
+	stats.acmrAfter = CalculateACMR(mesh.indices, (int)mesh.vertices.size());
+
+	CalculateBounds(mesh);
+	stats.vertexCount = (int)mesh.vertices.size();
+	stats.triangleCount = (int)mesh.indices.size() / 3;
+	return(true);
+}
+
+/***********************************************************
+ *  LoadOBJ()
+ *
+ *  This method is used for parsing the positions, texture
+ *  coordinates, normals and faces of an OBJ file.  Faces
+ *  with more than three corners are split into fans, and
+ *  every distinct combination of corner indices becomes
+ *  one vertex.  Materials and groups are ignored.
+ ***********************************************************/
+bool MeshImporter::LoadOBJ(const std::string& filename, IMPORTED_MESH& mesh, IMPORT_STATS& stats)
+{
+	std::vector<char> data;
+	if (!ReadFile(filename, data))
+	{
+		std::cout << "Could not read mesh file:" << filename << std::endl;
+		return(false);
+	}
+	stats.fileBytes = data.size();
+	data.push_back('\0');
+
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec2> textureCoordinates;
+	std::vector<glm::vec3> normals;
+	std::unordered_map<OBJ_CORNER, unsigned int, CornerHash> cornerVertices;
+	std::vector<OBJ_CORNER> corners;
+	bool bMissingNormals = false;
+
+	const char* p = data.data();
+	const char* end = data.data() + data.size() - 1;
+	while (p < end)
+	{
+		while ((p < end) && ((*p == ' ') || (*p == '\t')))
+		{
+			p++;
+		}
+
+		if ((p[0] == 'v') && ((p[1] == ' ') || (p[1] == '\t')))
+		{
+			char* pNext = NULL;
+			glm::vec3 position;
+			position.x = std::strtof(p + 2, &pNext);
+			position.y = std::strtof(pNext, &pNext);
+			position.z = std::strtof(pNext, &pNext);
+			positions.push_back(position);
+			p = pNext;
+		}
+		else if ((p[0] == 'v') && (p[1] == 't'))
+		{
+			char* pNext = NULL;
+			glm::vec2 textureCoordinate;
+			textureCoordinate.x = std::strtof(p + 2, &pNext);
+			textureCoordinate.y = std::strtof(pNext, &pNext);
+			textureCoordinates.push_back(textureCoordinate);
+			p = pNext;
+		}
+		else if ((p[0] == 'v') && (p[1] == 'n'))
+		{
+			char* pNext = NULL;
+			glm::vec3 normal;
+			normal.x = std::strtof(p + 2, &pNext);
+			normal.y = std::strtof(pNext, &pNext);
+			normal.z = std::strtof(pNext, &pNext);
+			normals.push_back(normal);
+			p = pNext;
+		}
+		else if ((p[0] == 'f') && ((p[1] == ' ') || (p[1] == '\t')))
+		{
+			p++;
+			corners.clear();
+			while (p < end)
+			{
+				while ((p < end) && ((*p == ' ') || (*p == '\t')))
+				{
+					p++;
+				}
+				if ((p >= end) || (*p == '\r') || (*p == '\n') || (*p == '#'))
+				{
+					break;
+				}
+
+				OBJ_CORNER corner = { ParseOBJIndex(p, (int)positions.size()), -1, -1 };
+				if (*p == '/')
+				{
+					p++;
+					if (*p != '/')
+					{
+						corner.texture = ParseOBJIndex(p, (int)textureCoordinates.size());
+					}
+					if (*p == '/')
+					{
+						p++;
+						corner.normal = ParseOBJIndex(p, (int)normals.size());
+					}
+				}
+				if (corner.position < 0)
+				{
+					// skip the rest of a corner that could not be read
+					while ((p < end) && (*p != ' ') && (*p != '\t') && (*p != '\r') && (*p != '\n'))
+					{
+						p++;
+					}
+					continue;
+				}
+				bMissingNormals = bMissingNormals || (corner.normal < 0);
+				corners.push_back(corner);
+			}
+
+			for (int i = 2; i < (int)corners.size(); i++)
+			{
+				const OBJ_CORNER* pTriangle[3] = { &corners[0], &corners[i - 1], &corners[i] };
+				for (int c = 0; c < 3; c++)
+				{
+					auto found = cornerVertices.find(*pTriangle[c]);
+					if (found == cornerVertices.end())
+					{
+						MESH_VERTEX vertex;
+						vertex.position = positions[pTriangle[c]->position];
+						vertex.normal = (pTriangle[c]->normal >= 0) ? normals[pTriangle[c]->normal] : glm::vec3(0.0f);
+						vertex.textureCoordinate = (pTriangle[c]->texture >= 0) ?
+							textureCoordinates[pTriangle[c]->texture] : glm::vec2(0.0f);
+						found = cornerVertices.emplace(*pTriangle[c], (unsigned int)mesh.vertices.size()).first;
+						mesh.vertices.push_back(vertex);
+					}
+					mesh.indices.push_back(found->second);
+				}
+				stats.sourceVertexCount += 3;
+			}
+		}
+
+		// skip to the next line
+		while ((p < end) && (*p != '\n'))
+		{
+			p++;
+		}
+		p++;
+	}
+
+	if (bMissingNormals)
+	{
+		GenerateNormals(mesh);
+	}
+	return(true);
+}
+
+/***********************************************************
+ *  LoadGLTF()
+ *
+ *  This method is used for reading the triangle primitives
+ *  of the default scene of a glTF 2.0 file, transformed by
+ *  their node hierarchy.  Buffers are read from the binary
+ *  chunk of a .glb, from embedded base64 data or from files
+ *  next to the .gltf - remote URIs are not followed.  The
+ *  identical vertices of all the primitives are merged.
+ ***********************************************************/
+bool MeshImporter::LoadGLTF(const std::string& filename, IMPORTED_MESH& mesh, IMPORT_STATS& stats)
+{
+	std::vector<char> data;
+	if (!ReadFile(filename, data))
+	{
+		std::cout << "Could not read mesh file:" << filename << std::endl;
+		return(false);
+	}
+	stats.fileBytes = data.size();
+	// terminate the text so that number parsing stops at the end
+	size_t dataSize = data.size();
+	data.push_back('\0');
+
+	GLTF_DOCUMENT document;
+	const char* pJson = data.data();
+	const char* pJsonEnd = data.data() + dataSize;
+
+	// a binary container holds the JSON chunk and the first buffer
+	unsigned int magic = 0;
+	if (dataSize >= 12)
+	{
+		memcpy(&magic, data.data(), 4);
+	}
+	if (magic == GLB_MAGIC)
+	{
+		pJson = NULL;
+		size_t offset = 12;
+		while (offset + 8 <= dataSize)
+		{
+			unsigned int chunkLength = 0;
+			unsigned int chunkType = 0;
+			memcpy(&chunkLength, data.data() + offset, 4);
+			memcpy(&chunkType, data.data() + offset + 4, 4);
+			offset += 8;
+			if (offset + chunkLength > dataSize)
+			{
+				break;
+			}
+			if ((chunkType == GLB_CHUNK_JSON) && (NULL == pJson))
+			{
+				pJson = data.data() + offset;
+				pJsonEnd = pJson + chunkLength;
+			}
+			else if ((chunkType == GLB_CHUNK_BIN) && document.buffers.empty())
+			{
+				document.buffers.push_back(std::vector<unsigned char>(data.begin() + offset, data.begin() + offset + chunkLength));
+			}
+			offset += (chunkLength + 3) & ~3u;
+		}
+	}
+	if ((NULL == pJson) || !ParseJsonValue(pJson, pJsonEnd, document.json, 0) ||
+		(document.json.type != JSON_VALUE::JSON_OBJECT))
+	{
+		std::cout << "Could not parse glTF file:" << filename << std::endl;
+		return(false);
+	}
+
+	// load the buffers that are not in the binary chunk
+	std::string directory = filename.substr(0, filename.find_last_of("/\\") + 1);
+	const JSON_VALUE* pBuffers = document.json.Find("buffers");
+	int bufferCount = (NULL != pBuffers) ? (int)pBuffers->items.size() : 0;
+	for (int i = 0; i < bufferCount; i++)
+	{
+		const JSON_VALUE* pUri = pBuffers->items[i].Find("uri");
+		if (NULL == pUri)
+		{
+			// only the first buffer of a .glb may omit its URI
+			if ((i == 0) && (magic == GLB_MAGIC) && !document.buffers.empty())
+			{
+				continue;
+			}
+			document.buffers.push_back(std::vector<unsigned char>());
+			continue;
+		}
+
+		std::vector<unsigned char> buffer;
+		if (pUri->text.rfind("data:", 0) == 0)
+		{
+			DecodeBase64(pUri->text.substr(pUri->text.find(',') + 1), buffer);
+		}
+		else if (pUri->text.find("://") != std::string::npos)
+		{
+			std::cout << "Only local glTF buffers are supported:" << pUri->text << std::endl;
+			return(false);
+		}
+		else
+		{
+			std::vector<char> bufferData;
+			if (!ReadFile(directory + pUri->text, bufferData))
+			{
+				std::cout << "Could not read glTF buffer:" << directory + pUri->text << std::endl;
+				return(false);
+			}
+			stats.fileBytes += bufferData.size();
+			buffer.assign(bufferData.begin(), bufferData.end());
+		}
+		if ((int)document.buffers.size() <= i)
+		{
+			document.buffers.resize(i + 1);
+		}
+		document.buffers[i].swap(buffer);
+	}
+
+	// collect the meshes of the default scene with their node
+	// transforms, or every mesh once when there is no scene
+	std::vector<std::pair<int, glm::mat4>> meshInstances;
+	const JSON_VALUE* pScene = document.json.FindItem("scenes", (int)document.json.GetNumber("scene", 0.0));
+	const JSON_VALUE* pSceneNodes = (NULL != pScene) ? pScene->Find("nodes") : NULL;
+	if (NULL != pSceneNodes)
+	{
+		std::vector<std::pair<int, glm::mat4>> nodeStack;
+		std::vector<int> depths;
+		for (int i = 0; i < (int)pSceneNodes->items.size(); i++)
+		{
+			nodeStack.push_back(std::make_pair((int)pSceneNodes->items[i].number, glm::mat4(1.0f)));
+			depths.push_back(0);
+		}
+		while (!nodeStack.empty())
+		{
+			int nodeIndex = nodeStack.back().first;
+			glm::mat4 parentTransform = nodeStack.back().second;
+			int depth = depths.back();
+			nodeStack.pop_back();
+			depths.pop_back();
+
+			const JSON_VALUE* pNode = document.json.FindItem("nodes", nodeIndex);
+			if ((NULL == pNode) || (depth > MAX_NODE_DEPTH))
+			{
+				continue;
+			}
+
+			glm::mat4 local(1.0f);
+			const JSON_VALUE* pMatrix = pNode->Find("matrix");
+			if ((NULL != pMatrix) && (pMatrix->items.size() == 16))
+			{
+				for (int c = 0; c < 4; c++)
+				{
+					local[c] = glm::vec4(
+						(float)pMatrix->items[c * 4].number, (float)pMatrix->items[c * 4 + 1].number,
+						(float)pMatrix->items[c * 4 + 2].number, (float)pMatrix->items[c * 4 + 3].number);
+				}
+			}
+			else
+			{
+				const JSON_VALUE* pTranslation = pNode->Find("translation");
+				const JSON_VALUE* pRotation = pNode->Find("rotation");
+				const JSON_VALUE* pScale = pNode->Find("scale");
+				if ((NULL != pRotation) && (pRotation->items.size() == 4))
+				{
+					local = QuaternionToMatrix(
+						(float)pRotation->items[0].number, (float)pRotation->items[1].number,
+						(float)pRotation->items[2].number, (float)pRotation->items[3].number);
+				}
+				if ((NULL != pScale) && (pScale->items.size() == 3))
+				{
+					for (int c = 0; c < 3; c++)
+					{
+						local[c] *= (float)pScale->items[c].number;
+					}
+				}
+				if ((NULL != pTranslation) && (pTranslation->items.size() == 3))
+				{
+					local[3] = glm::vec4(
+						(float)pTranslation->items[0].number, (float)pTranslation->items[1].number,
+						(float)pTranslation->items[2].number, 1.0f);
+				}
+			}
+			glm::mat4 world = parentTransform * local;
+
+			const JSON_VALUE* pMesh = pNode->Find("mesh");
+			if (NULL != pMesh)
+			{
+				meshInstances.push_back(std::make_pair((int)pMesh->number, world));
+			}
+			const JSON_VALUE* pChildren = pNode->Find("children");
+			if (NULL != pChildren)
+			{
+				for (int i = 0; i < (int)pChildren->items.size(); i++)
+				{
+					nodeStack.push_back(std::make_pair((int)pChildren->items[i].number, world));
+					depths.push_back(depth + 1);
+				}
+			}
+		}
+	}
+	else
+	{
+		const JSON_VALUE* pMeshes = document.json.Find("meshes");
+		int meshCount = (NULL != pMeshes) ? (int)pMeshes->items.size() : 0;
+		for (int i = 0; i < meshCount; i++)
+		{
+			meshInstances.push_back(std::make_pair(i, glm::mat4(1.0f)));
+		}
+	}
+
+	std::unordered_map<MESH_VERTEX, unsigned int, VertexHash, VertexEqual> uniqueVertices;
+	std::vector<float> positions;
+	std::vector<float> normals;
+	std::vector<float> textureCoordinates;
+	std::vector<unsigned int> primitiveIndices;
+	bool bMissingNormals = false;
+	for (const std::pair<int, glm::mat4>& instance : meshInstances)
+	{
+		const JSON_VALUE* pMesh = document.json.FindItem("meshes", instance.first);
+		const JSON_VALUE* pPrimitives = (NULL != pMesh) ? pMesh->Find("primitives") : NULL;
+		if (NULL == pPrimitives)
+		{
+			continue;
+		}
+
+		glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(instance.second)));
+		// mirrored transforms turn the triangles inside out
+		bool bMirrored = glm::determinant(glm::mat3(instance.second)) < 0.0f;
+
+		for (const JSON_VALUE& primitive : pPrimitives->items)
+		{
+			const JSON_VALUE* pAttributes = primitive.Find("attributes");
+			if ((NULL == pAttributes) || ((int)primitive.GetNumber("mode", GLTF_TRIANGLES) != GLTF_TRIANGLES))
+			{
+				continue;
+			}
+			int positionAccessor = (int)pAttributes->GetNumber("POSITION", -1.0);
+			int normalAccessor = (int)pAttributes->GetNumber("NORMAL", -1.0);
+			int textureAccessor = (int)pAttributes->GetNumber("TEXCOORD_0", -1.0);
+			if (!ReadAccessor(document, positionAccessor, 3, positions))
+			{
+				std::cout << "Could not read the positions of a glTF primitive in:" << filename << std::endl;
+				continue;
+			}
+			int vertexCount = (int)positions.size() / 3;
+			if ((normalAccessor < 0) || !ReadAccessor(document, normalAccessor, 3, normals) || (normals.size() != positions.size()))
+			{
+				normals.assign(positions.size(), 0.0f);
+				bMissingNormals = true;
+			}
+			if ((textureAccessor < 0) || !ReadAccessor(document, textureAccessor, 2, textureCoordinates) ||
+				(textureCoordinates.size() != (size_t)vertexCount * 2))
+			{
+				textureCoordinates.assign((size_t)vertexCount * 2, 0.0f);
+			}
+
+			int indexAccessor = (int)primitive.GetNumber("indices", -1.0);
+			if (indexAccessor >= 0)
+			{
+				if (!ReadIndices(document, indexAccessor, primitiveIndices))
+				{
+					std::cout << "Could not read the indices of a glTF primitive in:" << filename << std::endl;
+					continue;
+				}
+			}
+			else
+			{
+				primitiveIndices.resize(vertexCount);
+				for (int i = 0; i < vertexCount; i++)
+				{
+					primitiveIndices[i] = i;
+				}
+			}
+
+			unsigned int primitiveVertexCount = (unsigned int)vertexCount;
+			for (int t = 0; t + 2 < (int)primitiveIndices.size(); t += 3)
+			{
+				if ((primitiveIndices[t] >= primitiveVertexCount) || (primitiveIndices[t + 1] >= primitiveVertexCount) ||
+					(primitiveIndices[t + 2] >= primitiveVertexCount))
+				{
+					continue;
+				}
+				for (int c = 0; c < 3; c++)
+				{
+					unsigned int source = primitiveIndices[t + (bMirrored ? 2 - c : c)];
+					MESH_VERTEX vertex;
+					vertex.position = glm::vec3(instance.second * glm::vec4(
+						positions[source * 3], positions[source * 3 + 1], positions[source * 3 + 2], 1.0f));
+					vertex.normal = normalMatrix * glm::vec3(normals[source * 3], normals[source * 3 + 1], normals[source * 3 + 2]);
+					if (glm::dot(vertex.normal, vertex.normal) > 0.0f)
+					{
+						vertex.normal = glm::normalize(vertex.normal);
+					}
+					// glTF puts the texture origin at the top left
+					vertex.textureCoordinate = glm::vec2(textureCoordinates[source * 2], 1.0f - textureCoordinates[source * 2 + 1]);
+
+					auto found = uniqueVertices.find(vertex);
+					if (found == uniqueVertices.end())
+					{
+						found = uniqueVertices.emplace(vertex, (unsigned int)mesh.vertices.size()).first;
+						mesh.vertices.push_back(vertex);
+					}
+					mesh.indices.push_back(found->second);
+				}
+				stats.sourceVertexCount += 3;
+			}
+		}
+	}
+
+	if (bMissingNormals)
+	{
+		GenerateNormals(mesh);
+	}
+	return(true);
+}
+
+/***********************************************************
+ *  OptimizeMesh()
+ *
+ *  This method is used for reordering the triangles and the
+ *  vertices of a mesh for rendering.  Degenerate triangles
+ *  are dropped first, since they cost a vertex cache slot
+ *  without covering any pixels.
+ ***********************************************************/
+void MeshImporter::OptimizeMesh(IMPORTED_MESH& mesh)
+{
+	size_t kept = 0;
+	for (size_t t = 0; t + 2 < mesh.indices.size(); t += 3)
+	{
+		unsigned int a = mesh.indices[t];
+		unsigned int b = mesh.indices[t + 1];
+		unsigned int c = mesh.indices[t + 2];
+		if ((a != b) && (b != c) && (c != a))
+		{
+			mesh.indices[kept++] = a;
+			mesh.indices[kept++] = b;
+			mesh.indices[kept++] = c;
+		}
+	}
+	mesh.indices.resize(kept);
+
+	std::vector<int> clusterStarts;
+	OrderTriangles(mesh.indices, (int)mesh.vertices.size(), clusterStarts);
+	SortClusters(mesh, clusterStarts);
+	ReorderVertices(mesh);
+}
+
+/***********************************************************
+ *  CalculateACMR()
+ *
+ *  This method is used for simulating a FIFO post-transform
+ *  cache over an index buffer.  A vertex stays cached until
+ *  cacheSize other vertices have been transformed after it.
+ ***********************************************************/
+float MeshImporter::CalculateACMR(const std::vector<unsigned int>& indices, int vertexCount, int cacheSize)
+{
+	if (indices.size() < 3)
+	{
+		return(0.0f);
+	}
+
+	std::vector<int> insertTimes(vertexCount, 0);
+	int time = cacheSize + 1;
+	int misses = 0;
+	for (unsigned int index : indices)
+	{
+		if (time - insertTimes[index] > cacheSize)
+		{
+			insertTimes[index] = time++;
+			misses++;
+		}
+	}
+	return((float)misses / (indices.size() / 3));
+}
+
+/***********************************************************
+ *  OrderTriangles()
+ *
+ *  This method is used for reordering the triangles with
+ *  the Tipsify algorithm of Sander, Nehab and Barczak.  The
+ *  triangles around one vertex are emitted as a fan, then
+ *  the next fan is chosen among the vertices just used,
+ *  preferring ones that are still cached and have few
+ *  triangles left.  When no such vertex exists, the order
+ *  jumps to a recently used or the next unfinished vertex,
+ *  and a new cluster starts there.
+ ***********************************************************/
+void MeshImporter::OrderTriangles(std::vector<unsigned int>& indices, int vertexCount, std::vector<int>& clusterStarts)
+{
+	int triangleCount = (int)indices.size() / 3;
+	clusterStarts.clear();
+
+	// triangles still to be emitted around each vertex, and
+	// the triangles of each vertex as ranges of one array
+	std::vector<int> liveCounts(vertexCount, 0);
+	for (unsigned int index : indices)
+	{
+		liveCounts[index]++;
+	}
+	std::vector<int> adjacencyOffsets(vertexCount + 1, 0);
+	for (int v = 0; v < vertexCount; v++)
+	{
+		adjacencyOffsets[v + 1] = adjacencyOffsets[v] + liveCounts[v];
+	}
+	std::vector<int> adjacency(indices.size());
+	std::vector<int> fillOffsets(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+	for (int t = 0; t < triangleCount; t++)
+	{
+		for (int c = 0; c < 3; c++)
+		{
+			adjacency[fillOffsets[indices[t * 3 + c]]++] = t;
+		}
+	}
+
+	std::vector<int> cacheTimes(vertexCount, 0);
+	std::vector<char> emitted(triangleCount, 0);
+	std::vector<unsigned int> deadEndStack;
+	std::vector<unsigned int> candidates;
+	std::vector<unsigned int> ordered;
+	deadEndStack.reserve(indices.size());
+	ordered.reserve(indices.size());
+
+	int time = VERTEX_CACHE_SIZE + 1;
+	int cursor = 0;
+	int fanVertex = -1;
+	bool bNewCluster = true;
+	while (true)
+	{
+		// jump to a used vertex with triangles left, or else to
+		// the next unfinished one in index order
+		if (fanVertex < 0)
+		{
+			while (!deadEndStack.empty() && (fanVertex < 0))
+			{
+				unsigned int vertex = deadEndStack.back();
+				deadEndStack.pop_back();
+				if (liveCounts[vertex] > 0)
+				{
+					fanVertex = (int)vertex;
+				}
+			}
+			while ((fanVertex < 0) && (cursor < vertexCount))
+			{
+				if (liveCounts[cursor] > 0)
+				{
+					fanVertex = cursor;
+				}
+				cursor++;
+			}
+			if (fanVertex < 0)
+			{
+				break;
+			}
+			bNewCluster = true;
+		}
+		if (bNewCluster)
+		{
+			clusterStarts.push_back((int)ordered.size() / 3);
+			bNewCluster = false;
+		}
+
+		// emit the fan of the remaining triangles of the vertex
+		candidates.clear();
+		for (int a = adjacencyOffsets[fanVertex]; a < adjacencyOffsets[fanVertex + 1]; a++)
+		{
+			int triangle = adjacency[a];
+			if (emitted[triangle])
+			{
+				continue;
+			}
+			for (int c = 0; c < 3; c++)
+			{
+				unsigned int vertex = indices[triangle * 3 + c];
+				ordered.push_back(vertex);
+				deadEndStack.push_back(vertex);
+				candidates.push_back(vertex);
+				liveCounts[vertex]--;
+				if (time - cacheTimes[vertex] > VERTEX_CACHE_SIZE)
+				{
+					cacheTimes[vertex] = time++;
+				}
+			}
+			emitted[triangle] = 1;
+		}
+
+		// the next fan is the candidate that will still be in
+		// the cache after its remaining triangles are emitted,
+		// and that entered the cache earliest
+		int bestVertex = -1;
+		int bestPriority = -1;
+		for (unsigned int vertex : candidates)
+		{
+			if (liveCounts[vertex] <= 0)
+			{
+				continue;
+			}
+			int priority = 0;
+			if (time - cacheTimes[vertex] + 2 * liveCounts[vertex] <= VERTEX_CACHE_SIZE)
+			{
+				priority = time - cacheTimes[vertex];
+			}
+			if (priority > bestPriority)
+			{
+				bestPriority = priority;
+				bestVertex = (int)vertex;
+			}
+		}
+		fanVertex = bestVertex;
+	}
+
+	indices.swap(ordered);
+}
+
+/***********************************************************
+ *  SortClusters()
+ *
+ *  This method is used for reordering the clusters of the
+ *  Tipsify output so that the ones facing away from the
+ *  center of the mesh are drawn first, where they hide the
+ *  triangles behind them from most directions.  The clusters
+ *  are first split further wherever the cache miss ratio of
+ *  the triangles so far is already close to that of the
+ *  whole cluster, since each split restarts the cache.
+ ***********************************************************/
+void MeshImporter::SortClusters(IMPORTED_MESH& mesh, const std::vector<int>& clusterStarts)
+{
+	int triangleCount = (int)mesh.indices.size() / 3;
+	if (triangleCount == 0)
+	{
+		return;
+	}
+
+	std::vector<int> insertTimes(mesh.vertices.size(), 0);
+	int time = VERTEX_CACHE_SIZE + 1;
+	auto countMisses = [&](int triangle) {
+		int misses = 0;
+		for (int c = 0; c < 3; c++)
+		{
+			unsigned int vertex = mesh.indices[triangle * 3 + c];
+			if (time - insertTimes[vertex] > VERTEX_CACHE_SIZE)
+			{
+				insertTimes[vertex] = time++;
+				misses++;
+			}
+		}
+		return(misses);
+	};
+
+	std::vector<int> clusters;
+	for (int i = 0; i < (int)clusterStarts.size(); i++)
+	{
+		int first = clusterStarts[i];
+		int end = (i + 1 < (int)clusterStarts.size()) ? clusterStarts[i + 1] : triangleCount;
+
+		time += VERTEX_CACHE_SIZE + 1;
+		int clusterMisses = 0;
+		for (int t = first; t < end; t++)
+		{
+			clusterMisses += countMisses(t);
+		}
+		float threshold = OVERDRAW_THRESHOLD * clusterMisses / (end - first);
+
+		time += VERTEX_CACHE_SIZE + 1;
+		clusters.push_back(first);
+		int start = first;
+		int misses = 0;
+		for (int t = first; t < end - 1; t++)
+		{
+			misses += countMisses(t);
+			if (misses <= threshold * (t - start + 1))
+			{
+				start = t + 1;
+				clusters.push_back(start);
+				misses = 0;
+				time += VERTEX_CACHE_SIZE + 1;
+			}
+		}
+	}
+
+	// area weighted centroid and normal of each cluster
+	int clusterCount = (int)clusters.size();
+	std::vector<glm::vec3> clusterCentroids(clusterCount, glm::vec3(0.0f));
+	std::vector<glm::vec3> clusterNormals(clusterCount, glm::vec3(0.0f));
+	std::vector<float> clusterAreas(clusterCount, 0.0f);
+	glm::vec3 meshCentroid = glm::vec3(0.0f);
+	float meshArea = 0.0f;
+	for (int i = 0; i < clusterCount; i++)
+	{
+		int end = (i + 1 < clusterCount) ? clusters[i + 1] : triangleCount;
+		for (int t = clusters[i]; t < end; t++)
+		{
+			glm::vec3 a = mesh.vertices[mesh.indices[t * 3]].position;
+			glm::vec3 b = mesh.vertices[mesh.indices[t * 3 + 1]].position;
+			glm::vec3 c = mesh.vertices[mesh.indices[t * 3 + 2]].position;
+			glm::vec3 normal = glm::cross(b - a, c - a);
+			float area = glm::length(normal);
+			clusterCentroids[i] += (a + b + c) * (area / 3.0f);
+			clusterNormals[i] += normal;
+			clusterAreas[i] += area;
+		}
+		meshCentroid += clusterCentroids[i];
+		meshArea += clusterAreas[i];
+	}
+	if (meshArea > 0.0f)
+	{
+		meshCentroid /= meshArea;
+	}
+
+	std::vector<float> sortKeys(clusterCount, 0.0f);
+	for (int i = 0; i < clusterCount; i++)
+	{
+		if ((clusterAreas[i] > 0.0f) && (glm::dot(clusterNormals[i], clusterNormals[i]) > 0.0f))
+		{
+			glm::vec3 centroid = clusterCentroids[i] / clusterAreas[i];
+			sortKeys[i] = glm::dot(centroid - meshCentroid, glm::normalize(clusterNormals[i]));
+		}
+	}
+
+	std::vector<int> order(clusterCount);
+	for (int i = 0; i < clusterCount; i++)
+	{
+		order[i] = i;
+	}
+	std::stable_sort(order.begin(), order.end(), [&sortKeys](int a, int b) {
+		return(sortKeys[a] > sortKeys[b]);
+	});
+
+	std::vector<unsigned int> sorted;
+	sorted.reserve(mesh.indices.size());
+	for (int i : order)
+	{
+		int end = (i + 1 < clusterCount) ? clusters[i + 1] : triangleCount;
+		sorted.insert(sorted.end(), mesh.indices.begin() + clusters[i] * 3, mesh.indices.begin() + end * 3);
+	}
+	mesh.indices.swap(sorted);
+}
+
+/***********************************************************
+ *  ReorderVertices()
+ *
+ *  This method is used for renumbering the vertices in the
+ *  order the index buffer first references them, so that
+ *  the vertex fetches walk through memory sequentially.
+ *  Vertices no triangle uses are dropped.
+ ***********************************************************/
+void MeshImporter::ReorderVertices(IMPORTED_MESH& mesh)
+{
+	std::vector<int> remap(mesh.vertices.size(), -1);
+	std::vector<MESH_VERTEX> reordered;
+	reordered.reserve(mesh.vertices.size());
+	for (unsigned int& index : mesh.indices)
+	{
+		if (remap[index] < 0)
+		{
+			remap[index] = (int)reordered.size();
+			reordered.push_back(mesh.vertices[index]);
+		}
+		index = (unsigned int)remap[index];
+	}
+	mesh.vertices.swap(reordered);
+}
+
+/***********************************************************
+ *  GenerateNormals()
+ *
+ *  This method is used for calculating vertex normals from
+ *  the area weighted normals of the triangles around each
+ *  vertex, for the vertices that were read without one.
+ ***********************************************************/
+void MeshImporter::GenerateNormals(IMPORTED_MESH& mesh)
+{
+	std::vector<glm::vec3> accumulated(mesh.vertices.size(), glm::vec3(0.0f));
+	for (size_t t = 0; t + 2 < mesh.indices.size(); t += 3)
+	{
+		glm::vec3 a = mesh.vertices[mesh.indices[t]].position;
+		glm::vec3 b = mesh.vertices[mesh.indices[t + 1]].position;
+		glm::vec3 c = mesh.vertices[mesh.indices[t + 2]].position;
+		glm::vec3 normal = glm::cross(b - a, c - a);
+		for (int i = 0; i < 3; i++)
+		{
+			accumulated[mesh.indices[t + i]] += normal;
+		}
+	}
+	for (int v = 0; v < (int)mesh.vertices.size(); v++)
+	{
+		if (glm::dot(mesh.vertices[v].normal, mesh.vertices[v].normal) > 0.0f)
+		{
+			continue;
+		}
+		mesh.vertices[v].normal = (glm::dot(accumulated[v], accumulated[v]) > 0.0f) ?
+			glm::normalize(accumulated[v]) : glm::vec3(0.0f, 1.0f, 0.0f);
+	}
+}
+
+/***********************************************************
+ *  PackVertices()
+ *
+ *  This method is used for converting the vertices of a mesh
+ *  into the packed format.  The positions are stored as the
+ *  offset from the center of the bounds in steps of 1/32767
+ *  of the half extent on each axis.  The integers are passed
+ *  to the shader unnormalized and scaled there, which avoids
+ *  the difference between the old and new OpenGL rules for
+ *  converting signed normalized integers.
+ ***********************************************************/
+void MeshImporter::PackVertices(const IMPORTED_MESH& mesh, PACKED_MESH& packed)
+{
+	glm::vec3 halfExtent = (mesh.boundsMax - mesh.boundsMin) * 0.5f;
+	packed.positionOffset = (mesh.boundsMin + mesh.boundsMax) * 0.5f;
+	packed.positionScale = glm::max(halfExtent, glm::vec3(1.0e-20f)) / PACKED_MAX;
+
+	packed.vertices.resize(mesh.vertices.size());
+	for (int i = 0; i < (int)mesh.vertices.size(); i++)
+	{
+		const MESH_VERTEX& vertex = mesh.vertices[i];
+		PACKED_VERTEX& packedVertex = packed.vertices[i];
+
+		glm::vec3 quantized = glm::clamp(
+			glm::floor((vertex.position - packed.positionOffset) / packed.positionScale + 0.5f),
+			glm::vec3(-PACKED_MAX), glm::vec3(PACKED_MAX));
+		packedVertex.position[0] = (short)quantized.x;
+		packedVertex.position[1] = (short)quantized.y;
+		packedVertex.position[2] = (short)quantized.z;
+		packedVertex.position[3] = 0;
+
+		EncodeOctahedral(vertex.normal, packedVertex.normal);
+		packedVertex.textureCoordinate[0] = FloatToHalf(vertex.textureCoordinate.x);
+		packedVertex.textureCoordinate[1] = FloatToHalf(vertex.textureCoordinate.y);
+	}
+}
+
+/***********************************************************
+ *  UnpackVertex()
+ *
+ *  This method is used for decoding a packed vertex on the
+ *  CPU with the same math as the vertex shaders.
+ ***********************************************************/
+MeshImporter::MESH_VERTEX MeshImporter::UnpackVertex(const PACKED_VERTEX& vertex, glm::vec3 positionScale, glm::vec3 positionOffset)
+{
+	MESH_VERTEX unpacked;
+	unpacked.position = glm::vec3(vertex.position[0], vertex.position[1], vertex.position[2]) * positionScale + positionOffset;
+	unpacked.normal = DecodeOctahedral(glm::vec2(vertex.normal[0], vertex.normal[1]) / PACKED_MAX);
+	unpacked.textureCoordinate = glm::vec2(HalfToFloat(vertex.textureCoordinate[0]), HalfToFloat(vertex.textureCoordinate[1]));
+	return(unpacked);
+}
+
+/***********************************************************
+ *  MeasurePackingError()
+ *
+ *  This method is used for comparing every vertex of a mesh
+ *  with its decoded packed version.
+ ***********************************************************/
+void MeshImporter::MeasurePackingError(const IMPORTED_MESH& mesh, const PACKED_MESH& packed, PACKING_ERROR& error)
+{
+	error.position = 0.0f;
+	error.normalDegrees = 0.0f;
+	error.textureCoordinate = 0.0f;
+
+	glm::vec3 extent = mesh.boundsMax - mesh.boundsMin;
+	float largestExtent = glm::max(glm::max(extent.x, extent.y), glm::max(extent.z, 1.0e-20f));
+	float largestAngle = 0.0f;
+	for (int i = 0; i < (int)mesh.vertices.size(); i++)
+	{
+		const MESH_VERTEX& vertex = mesh.vertices[i];
+		MESH_VERTEX unpacked = UnpackVertex(packed.vertices[i], packed.positionScale, packed.positionOffset);
+
+		glm::vec3 positionError = glm::abs(unpacked.position - vertex.position);
+		error.position = glm::max(error.position,
+			glm::max(glm::max(positionError.x, positionError.y), positionError.z) / largestExtent);
+		glm::vec2 textureError = glm::abs(unpacked.textureCoordinate - vertex.textureCoordinate);
+		error.textureCoordinate = glm::max(error.textureCoordinate, glm::max(textureError.x, textureError.y));
+		if (glm::dot(vertex.normal, vertex.normal) > 0.0f)
+		{
+			// the angle from its sine and cosine stays accurate
+			// for the tiny angles acos cannot resolve in floats
+			glm::vec3 normal = glm::normalize(vertex.normal);
+			float angle = std::atan2(glm::length(glm::cross(unpacked.normal, normal)), glm::dot(unpacked.normal, normal));
+			largestAngle = glm::max(largestAngle, angle);
+		}
+	}
+	error.normalDegrees = glm::degrees(largestAngle);
+}
+
+/***********************************************************
+ *  GenerateSphere()
+ *
+ *  This method is used for generating a sphere of latitude
+ *  and longitude rings with the passed in number of
+ *  segments around, in the vertex layout of the basic
+ *  meshes.  The triangles are already in strip order, so
+ *  the sphere is left unoptimized.
+ ***********************************************************/
+void MeshImporter::GenerateSphere(int segments, IMPORTED_MESH& mesh)
+{
+	const float PI = 3.14159265358979f;
+	int rings = glm::max(segments / 2, 2);
+	segments = glm::max(segments, 3);
+
+	mesh.vertices.clear();
+	mesh.indices.clear();
+	for (int ring = 0; ring <= rings; ring++)
+	{
+		float theta = PI * ring / rings;
+		for (int segment = 0; segment <= segments; segment++)
+		{
+			float phi = 2.0f * PI * segment / segments;
+			MESH_VERTEX vertex;
+			vertex.normal = glm::vec3(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+			vertex.position = vertex.normal;
+			vertex.textureCoordinate = glm::vec2((float)segment / segments, 1.0f - (float)ring / rings);
+			mesh.vertices.push_back(vertex);
+		}
+	}
+	for (int ring = 0; ring < rings; ring++)
+	{
+		for (int segment = 0; segment < segments; segment++)
+		{
+			unsigned int a = ring * (segments + 1) + segment;
+			unsigned int b = a + segments + 1;
+			mesh.indices.push_back(a);
+			mesh.indices.push_back(a + 1);
+			mesh.indices.push_back(b);
+			mesh.indices.push_back(a + 1);
+			mesh.indices.push_back(b + 1);
+			mesh.indices.push_back(b);
+		}
+	}
+	CalculateBounds(mesh);
+}
+
+/***********************************************************
+ *  CalculateBounds()
+ *
+ *  This method is used for calculating the bounds of the
+ *  vertex positions of a mesh.
+ ***********************************************************/
+void MeshImporter::CalculateBounds(IMPORTED_MESH& mesh)
+{
+	mesh.boundsMin = glm::vec3(0.0f);
+	mesh.boundsMax = glm::vec3(0.0f);
+	if (mesh.vertices.empty())
+	{
+		return;
+	}
+	mesh.boundsMin = mesh.vertices[0].position;
+	mesh.boundsMax = mesh.vertices[0].position;
+	for (const MESH_VERTEX& vertex : mesh.vertices)
+	{
+		mesh.boundsMin = glm::min(mesh.boundsMin, vertex.position);
+		mesh.boundsMax = glm::max(mesh.boundsMax, vertex.position);
+	}
+}
@@ -0,0 +1,152 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshimporter.h
+// ============
+// load indexed triangle meshes from OBJ and glTF files and optimize them
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  MeshImporter
+ *
+ *  This class reads triangle meshes from local Wavefront
+ *  OBJ files and glTF 2.0 files (.gltf with external or
+ *  embedded buffers, or binary .glb).  The vertices are
+ *  deduplicated into an index buffer and written in the
+ *  interleaved position, normal and texture coordinate
+ *  layout of the basic shape meshes.  The triangles are
+ *  then reordered for the post-transform vertex cache with
+ *  Tipsify, the resulting clusters are sorted to reduce
+ *  overdraw, and the vertices are reordered to the order
+ *  they are first fetched in.  The vertices can also be
+ *  packed into a 16 byte layout for meshes where vertex
+ *  fetch bandwidth matters more than precision.
+ ***********************************************************/
+class MeshImporter
+{
+public:
+	// one vertex, in the layout of the basic shape meshes
+	struct MESH_VERTEX
+	{
+		glm::vec3 position;
+		glm::vec3 normal;
+		glm::vec2 textureCoordinate;
+	};
+
+	// indexed triangle list of one imported file
+	struct IMPORTED_MESH
+	{
+		std::vector<MESH_VERTEX> vertices;
+		std::vector<unsigned int> indices;
+		glm::vec3 boundsMin;
+		glm::vec3 boundsMax;
+	};
+
+	// vertex layouts a mesh can be uploaded in
+	enum VERTEX_FORMAT
+	{
+		// 32 bytes of floats, the layout of the basic meshes
+		VERTEX_FORMAT_FLOAT,
+		// 16 bytes - positions as 16-bit integers within the
+		// mesh bounds, normals octahedral encoded into two 16-bit
+		// integers and texture coordinates as half floats
+		VERTEX_FORMAT_PACKED
+	};
+
+	// one vertex of the packed format - the fourth position
+	// component only pads the vertex to 16 bytes
+	struct PACKED_VERTEX
+	{
+		short position[4];
+		short normal[2];
+		unsigned short textureCoordinate[2];
+	};
+
+	// vertices of a mesh in the packed format, with the scale
+	// and offset that turn the integer positions back into
+	// object space
+	struct PACKED_MESH
+	{
+		std::vector<PACKED_VERTEX> vertices;
+		glm::vec3 positionScale;
+		glm::vec3 positionOffset;
+	};
+
+	// largest differences between the vertices of a mesh and
+	// their packed versions
+	struct PACKING_ERROR
+	{
+		// relative to the largest extent of the mesh bounds
+		float position;
+		float normalDegrees;
+		float textureCoordinate;
+	};
+
+	// measurements of one import
+	struct IMPORT_STATS
+	{
+		// size of the file and its external buffers
+		size_t fileBytes;
+		// vertices referenced by the triangles before and after
+		// they were deduplicated
+		int sourceVertexCount;
+		int vertexCount;
+		int triangleCount;
+		// average cache miss ratio of the triangle order as it
+		// was read and after the optimization
+		float acmrBefore;
+		float acmrAfter;
+		// time spent reading and optimizing the mesh
+		double loadMs;
+		double optimizeMs;
+	};
+
+	// entries of the simulated post-transform vertex cache
+	static const int VERTEX_CACHE_SIZE = 16;
+
+	// load and optimize the mesh of an .obj, .gltf or .glb file
+	static bool LoadMesh(const std::string& filename, IMPORTED_MESH& mesh, IMPORT_STATS& stats);
+
+	// reorder the triangles for the vertex cache and overdraw,
+	// then the vertices for the fetch order
+	static void OptimizeMesh(IMPORTED_MESH& mesh);
+
+	// pack the vertices of a mesh into the packed format
+	static void PackVertices(const IMPORTED_MESH& mesh, PACKED_MESH& packed);
+	// decode a packed vertex the same way the vertex shaders do
+	static MESH_VERTEX UnpackVertex(const PACKED_VERTEX& vertex, glm::vec3 positionScale, glm::vec3 positionOffset);
+	// measure the precision lost by packing a mesh
+	static void MeasurePackingError(const IMPORTED_MESH& mesh, const PACKED_MESH& packed, PACKING_ERROR& error);
+
+	// generate a finely tessellated sphere of radius 1, used to
+	// measure the vertex formats
+	static void GenerateSphere(int segments, IMPORTED_MESH& mesh);
+
+	// get the average number of cache misses per triangle of
+	// an index buffer with a FIFO cache of the passed in size
+	static float CalculateACMR(const std::vector<unsigned int>& indices, int vertexCount, int cacheSize = VERTEX_CACHE_SIZE);
+
+private:
+	// parse the vertices and triangles of an OBJ file
+	static bool LoadOBJ(const std::string& filename, IMPORTED_MESH& mesh, IMPORT_STATS& stats);
+	// parse the triangle primitives of the default scene of a
+	// glTF file
+	static bool LoadGLTF(const std::string& filename, IMPORTED_MESH& mesh, IMPORT_STATS& stats);
+
+	// order the triangles with Tipsify, returning the first
+	// triangle of every cluster found along the way
+	static void OrderTriangles(std::vector<unsigned int>& indices, int vertexCount, std::vector<int>& clusterStarts);
+	// sort the clusters so that outward facing ones come first
+	static void SortClusters(IMPORTED_MESH& mesh, const std::vector<int>& clusterStarts);
+	// renumber the vertices in the order they are first used
+	static void ReorderVertices(IMPORTED_MESH& mesh);
+	// calculate smooth normals for meshes that have none
+	static void GenerateNormals(IMPORTED_MESH& mesh);
+	// calculate the bounds of the vertex positions
+	static void CalculateBounds(IMPORTED_MESH& mesh);
+};
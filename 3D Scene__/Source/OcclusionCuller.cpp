@@ -0,0 +1,437 @@
+///////////////////////////////////////////////////////////////////////////////
+// occlusionculler.cpp
+// ============
+// test object bounds against a hierarchical depth buffer of the previous frame
+///////////////////////////////////////////////////////////////////////////////
+
+#include "OcclusionCuller.h"
+
+#include <iostream>
+
+// declare the global variables
+namespace
+{
+	// the largest texel rectangle read from the pyramid per test
+	const int MAX_TEST_TEXELS = 4;
+	// depth difference below which a draw is never occluded, so
+	// the draw's own surface in the depth buffer cannot hide it
+	const float OCCLUSION_DEPTH_BIAS = 1.0e-5f;
+}
+
+/***********************************************************
+ *  OcclusionCuller()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+OcclusionCuller::OcclusionCuller()
+{
+	m_pReduceShaderManager = NULL;
+	m_emptyVertexArray = 0;
+	m_depthFramebuffer = 0;
+	m_depthTexture = 0;
+	m_tileFramebuffer = 0;
+	m_tileTexture = 0;
+	m_sourceWidth = 0;
+	m_sourceHeight = 0;
+	m_tileWidth = 0;
+	m_tileHeight = 0;
+	for (int i = 0; i < READBACK_SLOTS; i++)
+	{
+		m_readbacks[i].pixelBuffer = 0;
+		m_readbacks[i].fence = 0;
+		m_readbacks[i].viewProjection = glm::mat4(1.0f);
+		m_readbacks[i].sourceWidth = 0;
+		m_readbacks[i].sourceHeight = 0;
+		m_readbacks[i].width = 0;
+		m_readbacks[i].height = 0;
+	}
+	m_nextReadback = 0;
+	m_pyramidViewProjection = glm::mat4(1.0f);
+	m_pyramidWidth = 0;
+	m_pyramidHeight = 0;
+	m_bPyramidReady = false;
+}
+
+/***********************************************************
+ *  ~OcclusionCuller()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+OcclusionCuller::~OcclusionCuller()
+{
+	DestroyTargets();
+	for (int i = 0; i < READBACK_SLOTS; i++)
+	{
+		if (m_readbacks[i].fence != 0)
+		{
+			glDeleteSync(m_readbacks[i].fence);
+			m_readbacks[i].fence = 0;
+		}
+		if (m_readbacks[i].pixelBuffer != 0)
+		{
+			glDeleteBuffers(1, &m_readbacks[i].pixelBuffer);
+			m_readbacks[i].pixelBuffer = 0;
+		}
+	}
+	if (m_emptyVertexArray != 0)
+	{
+		glDeleteVertexArrays(1, &m_emptyVertexArray);
+		m_emptyVertexArray = 0;
+	}
+	if (NULL != m_pReduceShaderManager)
+	{
+		delete m_pReduceShaderManager;
+		m_pReduceShaderManager = NULL;
+	}
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for loading the tile reduction shader
+ *  and creating the pixel buffers for the readbacks.
+ ***********************************************************/
+void OcclusionCuller::Initialize()
+{
+	// the reduction shares the full screen triangle of the
+	// deferred lighting pass
+	m_pReduceShaderManager = new ShaderManager();
+	m_pReduceShaderManager->LoadShaders(
+		"../shaders/deferredVertexShader.glsl",
+		"../shaders/hiZReduceFragmentShader.glsl");
+	m_pReduceShaderManager->use();
+	m_pReduceShaderManager->setIntValue("sceneDepth", DEPTH_TEXTURE_UNIT);
+	m_pReduceShaderManager->setIntValue("tileSize", TILE_SIZE);
+
+	// core profile draws need a vertex array even without attributes
+	glGenVertexArrays(1, &m_emptyVertexArray);
+
+	for (int i = 0; i < READBACK_SLOTS; i++)
+	{
+		glGenBuffers(1, &m_readbacks[i].pixelBuffer);
+	}
+}
+
+/***********************************************************
+ *  CreateTargets()
+ *
+ *  This method is used for creating the single sampled depth
+ *  copy and the tile level for the passed in scene size.  The
+ *  depth uses the packed format of the scene targets so that
+ *  it can be blitted across, resolving any MSAA samples.
+ ***********************************************************/
+void OcclusionCuller::CreateTargets(int width, int height)
+{
+	m_sourceWidth = width;
+	m_sourceHeight = height;
+	m_tileWidth = (width + TILE_SIZE - 1) / TILE_SIZE;
+	m_tileHeight = (height + TILE_SIZE - 1) / TILE_SIZE;
+
+	glGenTextures(1, &m_depthTexture);
+	glBindTexture(GL_TEXTURE_2D, m_depthTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, width, height, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+	glGenFramebuffers(1, &m_depthFramebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_depthFramebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, m_depthTexture, 0);
+	glDrawBuffer(GL_NONE);
+	glReadBuffer(GL_NONE);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "Hi-Z depth framebuffer is not complete" << std::endl;
+	}
+
+	glGenTextures(1, &m_tileTexture);
+	glBindTexture(GL_TEXTURE_2D, m_tileTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, m_tileWidth, m_tileHeight, 0, GL_RED, GL_FLOAT, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+	glGenFramebuffers(1, &m_tileFramebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_tileFramebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_tileTexture, 0);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "Hi-Z tile framebuffer is not complete" << std::endl;
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+/***********************************************************
+ *  DestroyTargets()
+ *
+ *  This method is used for freeing the depth copy and the
+ *  tile level.
+ ***********************************************************/
+void OcclusionCuller::DestroyTargets()
+{
+	GLuint textures[] = { m_depthTexture, m_tileTexture };
+	glDeleteTextures(2, textures);
+	m_depthTexture = 0;
+	m_tileTexture = 0;
+
+	GLuint framebuffers[] = { m_depthFramebuffer, m_tileFramebuffer };
+	glDeleteFramebuffers(2, framebuffers);
+	m_depthFramebuffer = 0;
+	m_tileFramebuffer = 0;
+
+	m_sourceWidth = 0;
+	m_sourceHeight = 0;
+	m_tileWidth = 0;
+	m_tileHeight = 0;
+}
+
+/***********************************************************
+ *  CaptureDepth()
+ *
+ *  This method is used for copying the depth of the bound
+ *  framebuffer, reducing it to the farthest depth of each
+ *  tile and starting the readback of the tiles into a pixel
+ *  buffer.  If both readbacks are still in flight the frame
+ *  is skipped rather than waiting for the GPU.
+ ***********************************************************/
+void OcclusionCuller::CaptureDepth(const glm::mat4& viewProjection)
+{
+	DEPTH_READBACK& readback = m_readbacks[m_nextReadback];
+	if ((NULL == m_pReduceShaderManager) || (readback.fence != 0))
+	{
+		return;
+	}
+
+	GLint sceneFramebuffer = 0;
+	GLint viewport[4];
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &sceneFramebuffer);
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	if ((viewport[2] != m_sourceWidth) || (viewport[3] != m_sourceHeight))
+	{
+		DestroyTargets();
+		CreateTargets(viewport[2], viewport[3]);
+	}
+
+	// copy the depth into the single sampled texture
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, sceneFramebuffer);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_depthFramebuffer);
+	glBlitFramebuffer(0, 0, m_sourceWidth, m_sourceHeight, 0, 0, m_sourceWidth, m_sourceHeight, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+
+	// reduce every tile to its farthest depth
+	glBindFramebuffer(GL_FRAMEBUFFER, m_tileFramebuffer);
+	glViewport(0, 0, m_tileWidth, m_tileHeight);
+	m_pReduceShaderManager->use();
+	glActiveTexture(GL_TEXTURE0 + DEPTH_TEXTURE_UNIT);
+	glBindTexture(GL_TEXTURE_2D, m_depthTexture);
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_BLEND);
+	glBindVertexArray(m_emptyVertexArray);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	glBindVertexArray(0);
+	glEnable(GL_BLEND);
+	glEnable(GL_DEPTH_TEST);
+
+	// start the readback - the fence tells when it has landed
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.pixelBuffer);
+	glBufferData(GL_PIXEL_PACK_BUFFER, m_tileWidth * m_tileHeight * sizeof(float), NULL, GL_STREAM_READ);
+	glReadBuffer(GL_COLOR_ATTACHMENT0);
+	glReadPixels(0, 0, m_tileWidth, m_tileHeight, GL_RED, GL_FLOAT, 0);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	readback.viewProjection = viewProjection;
+	readback.sourceWidth = m_sourceWidth;
+	readback.sourceHeight = m_sourceHeight;
+	readback.width = m_tileWidth;
+	readback.height = m_tileHeight;
+	m_nextReadback = (m_nextReadback + 1) % READBACK_SLOTS;
+
+	glBindFramebuffer(GL_FRAMEBUFFER, sceneFramebuffer);
+	glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is used for checking the readbacks in flight,
+ *  oldest first, without waiting.  Each one that has landed
+ *  replaces the pyramid, so the newest completed depth wins.
+ ***********************************************************/
+void OcclusionCuller::Update()
+{
+	for (int i = 0; i < READBACK_SLOTS; i++)
+	{
+		DEPTH_READBACK& readback = m_readbacks[(m_nextReadback + i) % READBACK_SLOTS];
+		if (readback.fence == 0)
+		{
+			continue;
+		}
+
+		GLenum status = glClientWaitSync(readback.fence, 0, 0);
+		if ((status != GL_ALREADY_SIGNALED) && (status != GL_CONDITION_SATISFIED))
+		{
+			// later readbacks cannot have landed before this one
+			break;
+		}
+		glDeleteSync(readback.fence);
+		readback.fence = 0;
+
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.pixelBuffer);
+		const float* pTiles = (const float*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0,
+			readback.width * readback.height * sizeof(float), GL_MAP_READ_BIT);
+		if (NULL != pTiles)
+		{
+			BuildPyramid(readback, pTiles);
+			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		}
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	}
+}
+
+/***********************************************************
+ *  Invalidate()
+ *
+ *  This method is used for dropping the pyramid and the
+ *  readbacks in flight, so nothing is culled until the depth
+ *  of a new frame has been captured.
+ ***********************************************************/
+void OcclusionCuller::Invalidate()
+{
+	for (int i = 0; i < READBACK_SLOTS; i++)
+	{
+		if (m_readbacks[i].fence != 0)
+		{
+			glDeleteSync(m_readbacks[i].fence);
+			m_readbacks[i].fence = 0;
+		}
+	}
+	m_bPyramidReady = false;
+}
+
+/***********************************************************
+ *  BuildPyramid()
+ *
+ *  This method is used for building the CPU pyramid from the
+ *  tile depths of a completed readback.  Every level halves
+ *  the size of the one below and keeps the farthest depth of
+ *  the 2x2 texels it covers, down to a single texel.
+ ***********************************************************/
+void OcclusionCuller::BuildPyramid(const DEPTH_READBACK& readback, const float* pTiles)
+{
+	m_levels.resize(1);
+	m_levelSizes.resize(1);
+	m_levels[0].assign(pTiles, pTiles + readback.width * readback.height);
+	m_levelSizes[0] = glm::ivec2(readback.width, readback.height);
+
+	while ((m_levelSizes.back().x > 1) || (m_levelSizes.back().y > 1))
+	{
+		const std::vector<float>& below = m_levels.back();
+		glm::ivec2 belowSize = m_levelSizes.back();
+		glm::ivec2 size = glm::ivec2((belowSize.x + 1) / 2, (belowSize.y + 1) / 2);
+
+		std::vector<float> level(size.x * size.y);
+		for (int y = 0; y < size.y; y++)
+		{
+			int y0 = y * 2;
+			int y1 = glm::min(y0 + 1, belowSize.y - 1);
+			for (int x = 0; x < size.x; x++)
+			{
+				int x0 = x * 2;
+				int x1 = glm::min(x0 + 1, belowSize.x - 1);
+				level[y * size.x + x] = glm::max(
+					glm::max(below[y0 * belowSize.x + x0], below[y0 * belowSize.x + x1]),
+					glm::max(below[y1 * belowSize.x + x0], below[y1 * belowSize.x + x1]));
+			}
+		}
+		m_levels.push_back(level);
+		m_levelSizes.push_back(size);
+	}
+
+	m_pyramidViewProjection = readback.viewProjection;
+	m_pyramidWidth = readback.sourceWidth;
+	m_pyramidHeight = readback.sourceHeight;
+	m_bPyramidReady = true;
+}
+
+/***********************************************************
+ *  IsOccluded()
+ *
+ *  This method is used for testing the passed in world bounds
+ *  against the pyramid.  The bounds are projected with the
+ *  camera of the captured frame, and the nearest depth of
+ *  the box is compared with the farthest depth over its
+ *  screen rectangle, read from the level where the rectangle
+ *  covers at most 4x4 texels.  Bounds crossing the near plane
+ *  or leaving the captured view are always visible.
+ ***********************************************************/
+bool OcclusionCuller::IsOccluded(glm::vec3 boundsMin, glm::vec3 boundsMax) const
+{
+	if (!m_bPyramidReady)
+	{
+		return(false);
+	}
+
+	glm::vec3 ndcMin = glm::vec3(1.0f);
+	glm::vec3 ndcMax = glm::vec3(-1.0f);
+	for (int corner = 0; corner < 8; corner++)
+	{
+		glm::vec4 position = glm::vec4(
+			(corner & 1) ? boundsMax.x : boundsMin.x,
+			(corner & 2) ? boundsMax.y : boundsMin.y,
+			(corner & 4) ? boundsMax.z : boundsMin.z,
+			1.0f);
+		glm::vec4 clip = m_pyramidViewProjection * position;
+		if (clip.w <= 1.0e-5f)
+		{
+			return(false);
+		}
+		glm::vec3 ndc = glm::vec3(clip) / clip.w;
+		if (corner == 0)
+		{
+			ndcMin = ndc;
+			ndcMax = ndc;
+		}
+		else
+		{
+			ndcMin = glm::min(ndcMin, ndc);
+			ndcMax = glm::max(ndcMax, ndc);
+		}
+	}
+
+	if ((ndcMin.x < -1.0f) || (ndcMin.y < -1.0f) || (ndcMax.x > 1.0f) || (ndcMax.y > 1.0f) ||
+		(ndcMin.z < -1.0f))
+	{
+		return(false);
+	}
+
+	// nearest window depth of the box
+	float nearestDepth = ndcMin.z * 0.5f + 0.5f;
+
+	// covered tiles of the base level
+	int x0 = (int)((ndcMin.x * 0.5f + 0.5f) * m_pyramidWidth) / TILE_SIZE;
+	int y0 = (int)((ndcMin.y * 0.5f + 0.5f) * m_pyramidHeight) / TILE_SIZE;
+	int x1 = glm::min((int)((ndcMax.x * 0.5f + 0.5f) * m_pyramidWidth) / TILE_SIZE, m_levelSizes[0].x - 1);
+	int y1 = glm::min((int)((ndcMax.y * 0.5f + 0.5f) * m_pyramidHeight) / TILE_SIZE, m_levelSizes[0].y - 1);
+
+	// climb until the rectangle is small enough to read
+	int level = 0;
+	while (((x1 - x0 >= MAX_TEST_TEXELS) || (y1 - y0 >= MAX_TEST_TEXELS)) &&
+		(level + 1 < (int)m_levels.size()))
+	{
+		x0 /= 2;
+		y0 /= 2;
+		x1 /= 2;
+		y1 /= 2;
+		level++;
+	}
+
+	const std::vector<float>& depths = m_levels[level];
+	int width = m_levelSizes[level].x;
+	float farthestDepth = 0.0f;
+	for (int y = y0; y <= y1; y++)
+	{
+		for (int x = x0; x <= x1; x++)
+		{
+			farthestDepth = glm::max(farthestDepth, depths[y * width + x]);
+		}
+	}
+
+	return(nearestDepth > farthestDepth + OCCLUSION_DEPTH_BIAS);
+}
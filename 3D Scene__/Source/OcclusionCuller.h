@@ -0,0 +1,109 @@
+///////////////////////////////////////////////////////////////////////////////
+// occlusionculler.h
+// ============
+// test object bounds against a hierarchical depth buffer of the previous frame
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderManager.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  OcclusionCuller
+ *
+ *  This class keeps a hierarchical depth buffer (Hi-Z) of a
+ *  previously rendered frame.  After the scene is drawn the
+ *  depth is reduced on the GPU to the farthest depth of each
+ *  8x8 pixel tile and read back without stalling, through a
+ *  pixel buffer and a fence.  The remaining levels are built
+ *  on the CPU, where the bounds of each draw are tested, so
+ *  the same path runs on software OpenGL.  Draws that are
+ *  hidden in that frame are skipped, which can show a newly
+ *  uncovered object one or two frames late.
+ ***********************************************************/
+class OcclusionCuller
+{
+public:
+	// constructor
+	OcclusionCuller();
+	// destructor
+	~OcclusionCuller();
+
+	// texture unit used for sampling the scene depth
+	static const int DEPTH_TEXTURE_UNIT = 22;
+	// pixels of a depth tile reduced into one Hi-Z texel
+	static const int TILE_SIZE = 8;
+
+	// load the reduction shader - needs a current GL context
+	void Initialize();
+
+	// copy and reduce the depth of the bound framebuffer, rendered
+	// with the passed in camera, and start reading it back
+	void CaptureDepth(const glm::mat4& viewProjection);
+	// take over the newest depth readback that has completed
+	void Update();
+	// forget the captured depth, e.g. when the view jumps
+	void Invalidate();
+
+	// check whether a Hi-Z pyramid is available for testing
+	bool IsReady() const { return m_bPyramidReady; }
+	// check whether the passed in world bounds are hidden
+	// behind the captured depth
+	bool IsOccluded(glm::vec3 boundsMin, glm::vec3 boundsMax) const;
+
+private:
+	// number of readbacks that can be in flight
+	static const int READBACK_SLOTS = 2;
+
+	// one depth readback in flight
+	struct DEPTH_READBACK
+	{
+		GLuint pixelBuffer;
+		GLsync fence;
+		glm::mat4 viewProjection;
+		int sourceWidth;
+		int sourceHeight;
+		int width;
+		int height;
+	};
+
+	// create the depth copy and reduction targets for the passed in size
+	void CreateTargets(int width, int height);
+	// free the depth copy and reduction targets
+	void DestroyTargets();
+	// build the CPU pyramid from a completed readback
+	void BuildPyramid(const DEPTH_READBACK& readback, const float* pTiles);
+
+	// shader reducing the depth tiles
+	ShaderManager* m_pReduceShaderManager;
+	// empty vertex array bound for the full screen triangle
+	GLuint m_emptyVertexArray;
+	// single sampled copy of the scene depth
+	GLuint m_depthFramebuffer;
+	GLuint m_depthTexture;
+	// farthest depth of each tile, the base level of the pyramid
+	GLuint m_tileFramebuffer;
+	GLuint m_tileTexture;
+	// size of the scene depth and of the tile level
+	int m_sourceWidth;
+	int m_sourceHeight;
+	int m_tileWidth;
+	int m_tileHeight;
+	// readbacks in flight, and the slot written next
+	DEPTH_READBACK m_readbacks[READBACK_SLOTS];
+	int m_nextReadback;
+	// CPU pyramid - each level holds the farthest depth of 2x2
+	// texels of the level below
+	std::vector<std::vector<float>> m_levels;
+	std::vector<glm::ivec2> m_levelSizes;
+	// camera and size of the frame the pyramid was built from
+	glm::mat4 m_pyramidViewProjection;
+	int m_pyramidWidth;
+	int m_pyramidHeight;
+	bool m_bPyramidReady;
+};
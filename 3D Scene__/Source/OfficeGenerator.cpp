@@ -0,0 +1,120 @@
+///////////////////////////////////////////////////////////////////////////////
+// officegenerator.cpp
+// ============
+// lay out a seeded office of desks for stress testing the renderer
+///////////////////////////////////////////////////////////////////////////////
+
+#include "OfficeGenerator.h"
+
+#include <glm/gtx/transform.hpp>
+
+#include <cmath>
+
+// declare the global variables
+namespace
+{
+	// width of the aisles between the desks
+	const float AISLE_WIDTH = 4.0f;
+	// largest shift of a desk within its aisle
+	const float DESK_JITTER = 1.0f;
+	// chance of a draw getting another material or texture
+	const float SWAP_CHANCE = 0.5f;
+	// height range of the desk lamps above the desk top
+	const float LAMP_HEIGHT_MIN = 3.0f;
+	const float LAMP_HEIGHT_MAX = 5.0f;
+
+	/***********************************************************
+	 *  NextRandom()
+	 *
+	 *  This function is used to step the linear congruential
+	 *  generator and get a value between 0 and 1.  Unlike the
+	 *  standard library distributions it gives the same values
+	 *  on every platform.
+	 ***********************************************************/
+	float NextRandom(unsigned int& seed)
+	{
+		seed = seed * 1664525u + 1013904223u;
+		return (float)(seed >> 8) / 16777216.0f;
+	}
+}
+
+/***********************************************************
+ *  Generate()
+ *
+ *  This method is used for generating the office for the
+ *  passed in parameters.  The desks fill the rows of a
+ *  square grid going away from the first desk, each one
+ *  turned around at random and shifted within its aisle.
+ ***********************************************************/
+void OfficeGenerator::Generate(const OFFICE_PARAMETERS& parameters, OFFICE_LAYOUT& layout)
+{
+	layout.deskTransforms.clear();
+	layout.materialIndices.clear();
+	layout.textureIndices.clear();
+	layout.lights.clear();
+
+	int deskCount = glm::clamp(parameters.deskCount, 0, (int)MAX_DESKS);
+	if (deskCount == 0)
+	{
+		return;
+	}
+
+	unsigned int seed = parameters.seed;
+	glm::vec3 deskCenter = (parameters.deskMin + parameters.deskMax) * 0.5f;
+	glm::vec3 deskSize = parameters.deskMax - parameters.deskMin;
+	glm::vec2 spacing = glm::vec2(deskSize.x, deskSize.z) + glm::vec2(AISLE_WIDTH + DESK_JITTER * 2.0f);
+	int columns = (int)std::ceil(std::sqrt((double)deskCount));
+
+	layout.deskTransforms.resize(deskCount);
+	layout.materialIndices.assign(deskCount * parameters.drawsPerDesk, -1);
+	layout.textureIndices.assign(deskCount * parameters.drawsPerDesk, -1);
+	layout.lights.resize(deskCount);
+
+	for (int desk = 0; desk < deskCount; desk++)
+	{
+		// the rows run along x and away from the camera along -z,
+		// centered on the first desk's column
+		int row = desk / columns;
+		int column = desk % columns;
+		int centerColumn = (columns - 1) / 2;
+		int columnOffset = ((column + centerColumn) % columns) - centerColumn;
+		glm::vec3 offset = glm::vec3(columnOffset * spacing.x, 0.0f, -row * spacing.y);
+
+		glm::mat4 transform = glm::mat4(1.0f);
+		if (desk > 0)
+		{
+			// turn the desk about its center, which keeps its footprint
+			offset.x += (NextRandom(seed) * 2.0f - 1.0f) * DESK_JITTER;
+			offset.z += (NextRandom(seed) * 2.0f - 1.0f) * DESK_JITTER;
+			float turn = (NextRandom(seed) < 0.5f) ? 180.0f : 0.0f;
+			transform = glm::translate(deskCenter + offset) *
+				glm::rotate(glm::radians(turn), glm::vec3(0.0f, 1.0f, 0.0f)) *
+				glm::translate(-deskCenter);
+
+			for (int draw = 0; draw < parameters.drawsPerDesk; draw++)
+			{
+				int index = desk * parameters.drawsPerDesk + draw;
+				if ((parameters.materialCount > 0) && (NextRandom(seed) < SWAP_CHANCE))
+				{
+					layout.materialIndices[index] = (int)(NextRandom(seed) * parameters.materialCount) % parameters.materialCount;
+				}
+				if ((parameters.textureCount > 0) && (NextRandom(seed) < SWAP_CHANCE))
+				{
+					layout.textureIndices[index] = (int)(NextRandom(seed) * parameters.textureCount) % parameters.textureCount;
+				}
+			}
+		}
+		layout.deskTransforms[desk] = transform;
+
+		// a warm lamp somewhere above the desk top
+		OFFICE_LIGHT& light = layout.lights[desk];
+		light.position = glm::vec3(
+			deskCenter.x + offset.x + (NextRandom(seed) - 0.5f) * deskSize.x * 0.5f,
+			parameters.deskMax.y + glm::mix(LAMP_HEIGHT_MIN, LAMP_HEIGHT_MAX, NextRandom(seed)),
+			deskCenter.z + offset.z + (NextRandom(seed) - 0.5f) * deskSize.z * 0.5f);
+		light.color = glm::vec3(
+			0.8f + 0.2f * NextRandom(seed),
+			0.7f + 0.2f * NextRandom(seed),
+			0.5f + 0.3f * NextRandom(seed));
+	}
+}
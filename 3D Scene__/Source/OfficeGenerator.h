@@ -0,0 +1,69 @@
+///////////////////////////////////////////////////////////////////////////////
+// officegenerator.h
+// ============
+// lay out a seeded office of desks for stress testing the renderer
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  OfficeGenerator
+ *
+ *  This class lays out an office of desks on a grid with
+ *  aisles between them.  Every desk replicates the recorded
+ *  desk composition, turned and shifted a little, with some
+ *  of its materials and textures swapped and a desk lamp
+ *  placed above it.  All choices come from one seeded
+ *  generator, so the same seed always builds the same office
+ *  on every platform.  The first desk stays exactly where
+ *  the recorded one is.
+ ***********************************************************/
+class OfficeGenerator
+{
+public:
+	// largest number of desks in one office, over a million
+	// draws of the recorded desk
+	static const int MAX_DESKS = 20000;
+
+	// inputs of the office layout
+	struct OFFICE_PARAMETERS
+	{
+		int deskCount;
+		unsigned int seed;
+		// world bounds of the recorded desk
+		glm::vec3 deskMin;
+		glm::vec3 deskMax;
+		// number of recorded draws per desk
+		int drawsPerDesk;
+		// number of materials and textures to choose from
+		int materialCount;
+		int textureCount;
+	};
+
+	// one desk lamp
+	struct OFFICE_LIGHT
+	{
+		glm::vec3 position;
+		glm::vec3 color;
+	};
+
+	// generated office
+	struct OFFICE_LAYOUT
+	{
+		// transform applied to the recorded draws of each desk
+		std::vector<glm::mat4> deskTransforms;
+		// material and texture chosen for each draw of each desk,
+		// or -1 to keep the recorded one
+		std::vector<int> materialIndices;
+		std::vector<int> textureIndices;
+		// one lamp per desk
+		std::vector<OFFICE_LIGHT> lights;
+	};
+
+	// generate the office for the passed in parameters
+	static void Generate(const OFFICE_PARAMETERS& parameters, OFFICE_LAYOUT& layout);
+};
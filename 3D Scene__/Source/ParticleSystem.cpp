@@ -0,0 +1,663 @@
+///////////////////////////////////////////////////////////////////////////////
+// particlesystem.cpp
+// ============
+// simulate a large number of particles and draw them as camera facing sprites
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ParticleSystem.h"
+
+#include <cmath>
+#include <future>
+#include <iostream>
+#include <string>
+#include <thread>
+
+// the CPU simulation advances four particles per instruction where
+// the compiler targets SSE, and one at a time elsewhere
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#include <xmmintrin.h>
+#define PARTICLE_SIMD 1
+#endif
+
+// declare the global variables
+namespace
+{
+	const char* g_SimulationModeNames[] = { "auto", "gpu", "cpu" };
+	// renderer names of the drivers that rasterize on the CPU
+	const char* g_SoftwareRenderers[] = { "llvmpipe", "softpipe", "SwiftShader", "Basic Render" };
+	// outputs of the update shader captured into the state buffer
+	const char* g_StateVaryings[] = { "outPositionAge", "outVelocitySeed" };
+	// floats of the state of one particle in the GPU buffers
+	const int STATE_FLOATS = 8;
+	// fewest particles worth a thread of the CPU simulation
+	const int PARALLEL_MIN_PARTICLES = 16384;
+	// age of the padding particles, which are never emitted
+	const float UNUSED_PARTICLE_AGE = -1.0e30f;
+
+	/***********************************************************
+	 *  Hash()
+	 *
+	 *  This function is used to mix every bit of a value into
+	 *  every bit of the result.  It matches the Hash() of the
+	 *  update shader, so both simulations emit the particles
+	 *  in the same directions.
+	 ***********************************************************/
+	unsigned int Hash(unsigned int value)
+	{
+		value ^= value >> 16;
+		value *= 0x7feb352du;
+		value ^= value >> 15;
+		value *= 0x846ca68bu;
+		value ^= value >> 16;
+		return(value);
+	}
+
+	/***********************************************************
+	 *  Random()
+	 *
+	 *  This function is used to get the next uniform random
+	 *  number in [0, 1) of a hash sequence.
+	 ***********************************************************/
+	float Random(unsigned int& state)
+	{
+		state = Hash(state);
+		return((float)(state >> 8) / 16777216.0f);
+	}
+}
+
+/***********************************************************
+ *  ParticleSystem()
+ *
+ *  The constructor for the class.  The default emitter is
+ *  a fountain of sparks on the desk beside the monitor.
+ ***********************************************************/
+ParticleSystem::ParticleSystem()
+{
+	m_pUpdateShaderManager = NULL;
+	m_pRenderShaderManager = NULL;
+	m_bTransformFeedback = false;
+	m_bSoftwareRenderer = false;
+	m_particleCount = 0;
+	m_stateBuffers[0] = 0;
+	m_stateBuffers[1] = 0;
+	m_updateVertexArrays[0] = 0;
+	m_updateVertexArrays[1] = 0;
+	m_renderVertexArrays[0] = 0;
+	m_renderVertexArrays[1] = 0;
+	m_currentBuffer = 0;
+	m_cpuBuffer = 0;
+	m_cpuVertexArray = 0;
+	m_stateMode = SIMULATE_AUTO;
+
+	m_emitter.position = glm::vec3(-6.5f, 0.0f, 1.5f);
+	m_emitter.radius = 0.15f;
+	m_emitter.speed = 5.0f;
+	m_emitter.spread = 1.2f;
+	m_emitter.lifetime = 2.5f;
+	m_emitter.gravity = glm::vec3(0.0f, -6.0f, 0.0f);
+	m_emitter.drag = 0.6f;
+	m_emitter.floorHeight = 0.0f;
+	m_emitter.restitution = 0.4f;
+	m_emitter.size = 0.03f;
+	m_emitter.startColor = glm::vec4(1.0f, 0.7f, 0.3f, 0.6f);
+	m_emitter.endColor = glm::vec4(0.6f, 0.1f, 0.02f, 0.0f);
+}
+
+/***********************************************************
+ *  ~ParticleSystem()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ParticleSystem::~ParticleSystem()
+{
+	DestroyBuffers();
+	if (NULL != m_pUpdateShaderManager)
+	{
+		delete m_pUpdateShaderManager;
+		m_pUpdateShaderManager = NULL;
+	}
+	if (NULL != m_pRenderShaderManager)
+	{
+		delete m_pRenderShaderManager;
+		m_pRenderShaderManager = NULL;
+	}
+}
+
+/***********************************************************
+ *  GetModeName()
+ *
+ *  This method is used for getting the display name of the
+ *  passed in simulation mode.
+ ***********************************************************/
+const char* ParticleSystem::GetModeName(int mode)
+{
+	if ((mode < 0) || (mode >= SIMULATION_MODE_COUNT))
+	{
+		return("unknown");
+	}
+	return(g_SimulationModeNames[mode]);
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for loading the update and sprite
+ *  shaders.  The loaded update shaders stay attached to
+ *  their program, so it is linked again with the outputs
+ *  captured by transform feedback.  When that link fails,
+ *  the particles are simulated on the CPU.
+ ***********************************************************/
+void ParticleSystem::Initialize()
+{
+	m_pUpdateShaderManager = new ShaderManager();
+	m_pUpdateShaderManager->LoadShaders(
+		"../shaders/particleUpdateVertexShader.glsl",
+		"../shaders/particleUpdateFragmentShader.glsl");
+
+	GLuint program = m_pUpdateShaderManager->m_programID;
+	glTransformFeedbackVaryings(program, 2, g_StateVaryings, GL_INTERLEAVED_ATTRIBS);
+	glLinkProgram(program);
+	GLint linkStatus = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &linkStatus);
+	m_bTransformFeedback = (linkStatus == GL_TRUE);
+	if (!m_bTransformFeedback)
+	{
+		std::cout << "INFO: Particle transform feedback is not available, simulating on the CPU" << std::endl;
+	}
+
+	m_pRenderShaderManager = new ShaderManager();
+	m_pRenderShaderManager->LoadShaders(
+		"../shaders/particleVertexShader.glsl",
+		"../shaders/particleFragmentShader.glsl");
+
+	const char* renderer = (const char*)glGetString(GL_RENDERER);
+	std::string rendererName = (NULL != renderer) ? renderer : "";
+	for (int i = 0; i < (int)(sizeof(g_SoftwareRenderers) / sizeof(g_SoftwareRenderers[0])); i++)
+	{
+		if (rendererName.find(g_SoftwareRenderers[i]) != std::string::npos)
+		{
+			m_bSoftwareRenderer = true;
+		}
+	}
+}
+
+/***********************************************************
+ *  SetEmitter()
+ *
+ *  This method is used for setting the emitter of the
+ *  particles.  The particles already in flight keep going,
+ *  and leave from the new emitter when emitted again.
+ ***********************************************************/
+void ParticleSystem::SetEmitter(const EMITTER& emitter)
+{
+	m_emitter = emitter;
+}
+
+/***********************************************************
+ *  ResolveMode()
+ *
+ *  This method is used for getting the simulation mode the
+ *  passed in one runs as.  The automatic mode keeps the
+ *  simulation on the GPU, unless the driver rasterizes in
+ *  software - its shaders then run on the CPU anyway, but
+ *  without the SIMD lanes and threads of the CPU path.
+ ***********************************************************/
+int ParticleSystem::ResolveMode(int mode) const
+{
+	if (!m_bTransformFeedback)
+	{
+		return(SIMULATE_CPU);
+	}
+	if (mode == SIMULATE_AUTO)
+	{
+		return(m_bSoftwareRenderer ? SIMULATE_CPU : SIMULATE_GPU);
+	}
+	return((mode == SIMULATE_CPU) ? SIMULATE_CPU : SIMULATE_GPU);
+}
+
+/***********************************************************
+ *  SetParticleCount()
+ *
+ *  This method is used for allocating the passed in number
+ *  of particles and restarting them.  Every particle waits
+ *  at the emitter for a random part of its lifetime before
+ *  it is first emitted, so the emission is spread evenly
+ *  over time from the start.
+ ***********************************************************/
+void ParticleSystem::SetParticleCount(int count)
+{
+	DestroyBuffers();
+	m_particleCount = glm::clamp(count, 0, MAX_PARTICLES);
+	m_currentBuffer = 0;
+	m_stateMode = SIMULATE_AUTO;
+
+	int paddedCount = (m_particleCount + 3) & ~3;
+	m_positionX.assign(paddedCount, m_emitter.position.x);
+	m_positionY.assign(paddedCount, m_emitter.position.y);
+	m_positionZ.assign(paddedCount, m_emitter.position.z);
+	m_age.assign(paddedCount, UNUSED_PARTICLE_AGE);
+	m_velocityX.assign(paddedCount, 0.0f);
+	m_velocityY.assign(paddedCount, 0.0f);
+	m_velocityZ.assign(paddedCount, 0.0f);
+	m_generation.assign(paddedCount, 0.0f);
+	m_uploadData.assign((size_t)paddedCount * 4, 0.0f);
+	if (m_particleCount == 0)
+	{
+		return;
+	}
+
+	for (int i = 0; i < m_particleCount; i++)
+	{
+		unsigned int state = Hash((unsigned int)i ^ 0x5bd1e995u);
+		m_age[i] = -Random(state) * m_emitter.lifetime;
+
+		m_uploadData[i * 4] = m_positionX[i];
+		m_uploadData[i * 4 + 1] = m_positionY[i];
+		m_uploadData[i * 4 + 2] = m_positionZ[i];
+		m_uploadData[i * 4 + 3] = m_age[i];
+	}
+
+	// positions and ages streamed by the CPU simulation
+	glGenBuffers(1, &m_cpuBuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, m_cpuBuffer);
+	glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)m_particleCount * 4 * sizeof(float), m_uploadData.data(), GL_STREAM_DRAW);
+	glGenVertexArrays(1, &m_cpuVertexArray);
+	glBindVertexArray(m_cpuVertexArray);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+	glVertexAttribDivisor(0, 1);
+
+	if (m_bTransformFeedback)
+	{
+		glGenBuffers(2, m_stateBuffers);
+		glGenVertexArrays(2, m_updateVertexArrays);
+		glGenVertexArrays(2, m_renderVertexArrays);
+		GLsizei stride = STATE_FLOATS * sizeof(float);
+		for (int i = 0; i < 2; i++)
+		{
+			glBindBuffer(GL_ARRAY_BUFFER, m_stateBuffers[i]);
+			glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)m_particleCount * stride, NULL, GL_DYNAMIC_COPY);
+
+			// the update reads the whole state once per particle
+			glBindVertexArray(m_updateVertexArrays[i]);
+			glEnableVertexAttribArray(0);
+			glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, stride, (void*)0);
+			glEnableVertexAttribArray(1);
+			glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, stride, (void*)(4 * sizeof(float)));
+
+			// the sprites read the position and age once per quad
+			glBindVertexArray(m_renderVertexArrays[i]);
+			glEnableVertexAttribArray(0);
+			glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, stride, (void*)0);
+			glVertexAttribDivisor(0, 1);
+		}
+		UploadState();
+	}
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+/***********************************************************
+ *  Simulate()
+ *
+ *  This method is used for advancing the particles by the
+ *  passed in seconds.  When the mode changes, the state is
+ *  first copied to the side that simulates it, so the
+ *  particles continue where they were.
+ ***********************************************************/
+void ParticleSystem::Simulate(float deltaTime, int mode)
+{
+	if ((m_particleCount == 0) || (deltaTime <= 0.0f))
+	{
+		return;
+	}
+
+	int simulationMode = ResolveMode(mode);
+	if (simulationMode == SIMULATE_GPU)
+	{
+		if (m_stateMode == SIMULATE_CPU)
+		{
+			UploadState();
+		}
+		SimulateGPU(deltaTime);
+	}
+	else
+	{
+		if (m_stateMode == SIMULATE_GPU)
+		{
+			DownloadState();
+		}
+		SimulateCPU(deltaTime);
+	}
+	m_stateMode = simulationMode;
+}
+
+/***********************************************************
+ *  SimulateGPU()
+ *
+ *  This method is used for advancing the particles with the
+ *  update shader.  Every particle is one point read from
+ *  the current state buffer, and its outputs are captured
+ *  into the other buffer with the rasterizer switched off,
+ *  so no fragment is shaded.  The buffers then swap.
+ ***********************************************************/
+void ParticleSystem::SimulateGPU(float deltaTime)
+{
+	m_pUpdateShaderManager->use();
+	m_pUpdateShaderManager->setFloatValue("deltaTime", deltaTime);
+	m_pUpdateShaderManager->setVec3Value("gravity", m_emitter.gravity);
+	m_pUpdateShaderManager->setFloatValue("velocityKeep", std::pow(m_emitter.drag, deltaTime));
+	m_pUpdateShaderManager->setFloatValue("lifetime", m_emitter.lifetime);
+	m_pUpdateShaderManager->setVec3Value("emitterPosition", m_emitter.position);
+	m_pUpdateShaderManager->setFloatValue("emitterRadius", m_emitter.radius);
+	m_pUpdateShaderManager->setFloatValue("emitterSpeed", m_emitter.speed);
+	m_pUpdateShaderManager->setFloatValue("emitterSpread", m_emitter.spread);
+	m_pUpdateShaderManager->setFloatValue("floorHeight", m_emitter.floorHeight);
+	m_pUpdateShaderManager->setFloatValue("restitution", m_emitter.restitution);
+
+	glEnable(GL_RASTERIZER_DISCARD);
+	glBindVertexArray(m_updateVertexArrays[m_currentBuffer]);
+	glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, m_stateBuffers[1 - m_currentBuffer]);
+	glBeginTransformFeedback(GL_POINTS);
+	glDrawArrays(GL_POINTS, 0, m_particleCount);
+	glEndTransformFeedback();
+	glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+	glBindVertexArray(0);
+	glDisable(GL_RASTERIZER_DISCARD);
+
+	m_currentBuffer = 1 - m_currentBuffer;
+}
+
+/***********************************************************
+ *  SimulateCPU()
+ *
+ *  This method is used for advancing the particles on all
+ *  the CPU cores, each thread taking one range of them, and
+ *  then uploading their positions and ages.  The buffer is
+ *  orphaned first, so the upload does not wait for the
+ *  sprites of the previous frame to be drawn from it.
+ ***********************************************************/
+void ParticleSystem::SimulateCPU(float deltaTime)
+{
+	float velocityKeep = std::pow(m_emitter.drag, deltaTime);
+	int paddedCount = (int)m_age.size();
+	int threads = (int)std::thread::hardware_concurrency();
+	threads = glm::clamp(glm::min(threads, paddedCount / PARALLEL_MIN_PARTICLES), 1, 64);
+
+	// the ranges start on a multiple of four for the SIMD lanes
+	int rangeSize = (((paddedCount + threads - 1) / threads) + 3) & ~3;
+	std::vector<std::future<void>> tasks;
+	for (int first = rangeSize; first < paddedCount; first += rangeSize)
+	{
+		int last = glm::min(first + rangeSize, paddedCount);
+		tasks.push_back(std::async(std::launch::async,
+			[this, deltaTime, velocityKeep, first, last]() { SimulateRange(deltaTime, velocityKeep, first, last); }));
+	}
+	SimulateRange(deltaTime, velocityKeep, 0, glm::min(rangeSize, paddedCount));
+	for (int i = 0; i < (int)tasks.size(); i++)
+	{
+		tasks[i].wait();
+	}
+
+	GLsizeiptr uploadSize = (GLsizeiptr)m_particleCount * 4 * sizeof(float);
+	glBindBuffer(GL_ARRAY_BUFFER, m_cpuBuffer);
+	glBufferData(GL_ARRAY_BUFFER, uploadSize, NULL, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, uploadSize, m_uploadData.data());
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+/***********************************************************
+ *  SimulateRange()
+ *
+ *  This method is used for advancing a range of the CPU
+ *  particles the same way the update shader does, and
+ *  packing their positions and ages for the upload.  With
+ *  SSE four particles move per instruction, and the few
+ *  that expire in a step are emitted again one at a time.
+ ***********************************************************/
+void ParticleSystem::SimulateRange(float deltaTime, float velocityKeep, int first, int last)
+{
+#ifdef PARTICLE_SIMD
+	const __m128 step = _mm_set1_ps(deltaTime);
+	const __m128 keep = _mm_set1_ps(velocityKeep);
+	const __m128 gravityX = _mm_set1_ps(m_emitter.gravity.x * deltaTime);
+	const __m128 gravityY = _mm_set1_ps(m_emitter.gravity.y * deltaTime);
+	const __m128 gravityZ = _mm_set1_ps(m_emitter.gravity.z * deltaTime);
+	const __m128 floorHeight = _mm_set1_ps(m_emitter.floorHeight);
+	const __m128 bounce = _mm_set1_ps(-m_emitter.restitution);
+	const __m128 lifetime = _mm_set1_ps(m_emitter.lifetime);
+	const __m128 zero = _mm_setzero_ps();
+
+	for (int i = first; i < last; i += 4)
+	{
+		__m128 velocityX = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(&m_velocityX[i]), gravityX), keep);
+		__m128 velocityY = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(&m_velocityY[i]), gravityY), keep);
+		__m128 velocityZ = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(&m_velocityZ[i]), gravityZ), keep);
+		__m128 positionX = _mm_add_ps(_mm_loadu_ps(&m_positionX[i]), _mm_mul_ps(velocityX, step));
+		__m128 positionY = _mm_add_ps(_mm_loadu_ps(&m_positionY[i]), _mm_mul_ps(velocityY, step));
+		__m128 positionZ = _mm_add_ps(_mm_loadu_ps(&m_positionZ[i]), _mm_mul_ps(velocityZ, step));
+
+		// lanes below the floor are put back on it and bounced
+		__m128 below = _mm_cmplt_ps(positionY, floorHeight);
+		positionY = _mm_or_ps(_mm_and_ps(below, floorHeight), _mm_andnot_ps(below, positionY));
+		velocityY = _mm_or_ps(_mm_and_ps(below, _mm_mul_ps(velocityY, bounce)), _mm_andnot_ps(below, velocityY));
+
+		__m128 previousAge = _mm_loadu_ps(&m_age[i]);
+		__m128 age = _mm_add_ps(previousAge, step);
+
+		_mm_storeu_ps(&m_velocityX[i], velocityX);
+		_mm_storeu_ps(&m_velocityY[i], velocityY);
+		_mm_storeu_ps(&m_velocityZ[i], velocityZ);
+		_mm_storeu_ps(&m_positionX[i], positionX);
+		_mm_storeu_ps(&m_positionY[i], positionY);
+		_mm_storeu_ps(&m_positionZ[i], positionZ);
+		_mm_storeu_ps(&m_age[i], age);
+
+		// expired lanes and lanes reaching their first emission
+		__m128 emitted = _mm_or_ps(_mm_cmpge_ps(age, lifetime),
+			_mm_and_ps(_mm_cmpge_ps(age, zero), _mm_cmplt_ps(previousAge, zero)));
+		int emittedMask = _mm_movemask_ps(emitted);
+		if (emittedMask != 0)
+		{
+			for (int lane = 0; lane < 4; lane++)
+			{
+				if (emittedMask & (1 << lane))
+				{
+					EmitParticle(i + lane);
+				}
+			}
+			positionX = _mm_loadu_ps(&m_positionX[i]);
+			positionY = _mm_loadu_ps(&m_positionY[i]);
+			positionZ = _mm_loadu_ps(&m_positionZ[i]);
+			age = _mm_loadu_ps(&m_age[i]);
+		}
+
+		// four rows of position and age, one per particle
+		_MM_TRANSPOSE4_PS(positionX, positionY, positionZ, age);
+		_mm_storeu_ps(&m_uploadData[(size_t)i * 4], positionX);
+		_mm_storeu_ps(&m_uploadData[(size_t)i * 4 + 4], positionY);
+		_mm_storeu_ps(&m_uploadData[(size_t)i * 4 + 8], positionZ);
+		_mm_storeu_ps(&m_uploadData[(size_t)i * 4 + 12], age);
+	}
+#else
+	glm::vec3 gravityStep = m_emitter.gravity * deltaTime;
+	for (int i = first; i < last; i++)
+	{
+		m_velocityX[i] = (m_velocityX[i] + gravityStep.x) * velocityKeep;
+		m_velocityY[i] = (m_velocityY[i] + gravityStep.y) * velocityKeep;
+		m_velocityZ[i] = (m_velocityZ[i] + gravityStep.z) * velocityKeep;
+		m_positionX[i] += m_velocityX[i] * deltaTime;
+		m_positionY[i] += m_velocityY[i] * deltaTime;
+		m_positionZ[i] += m_velocityZ[i] * deltaTime;
+		if (m_positionY[i] < m_emitter.floorHeight)
+		{
+			m_positionY[i] = m_emitter.floorHeight;
+			m_velocityY[i] *= -m_emitter.restitution;
+		}
+
+		float previousAge = m_age[i];
+		m_age[i] += deltaTime;
+		if ((m_age[i] >= m_emitter.lifetime) || ((m_age[i] >= 0.0f) && (previousAge < 0.0f)))
+		{
+			EmitParticle(i);
+		}
+
+		m_uploadData[(size_t)i * 4] = m_positionX[i];
+		m_uploadData[(size_t)i * 4 + 1] = m_positionY[i];
+		m_uploadData[(size_t)i * 4 + 2] = m_positionZ[i];
+		m_uploadData[(size_t)i * 4 + 3] = m_age[i];
+	}
+#endif
+}
+
+/***********************************************************
+ *  EmitParticle()
+ *
+ *  This method is used for emitting a CPU particle from the
+ *  emitter.  An expired particle starts its next generation
+ *  with the time it overran its lifetime by.  The particle
+ *  index and generation seed the direction, as they do in
+ *  the update shader.
+ ***********************************************************/
+void ParticleSystem::EmitParticle(int particle)
+{
+	if (m_age[particle] >= m_emitter.lifetime)
+	{
+		m_age[particle] -= m_emitter.lifetime;
+		m_generation[particle] += 1.0f;
+	}
+
+	unsigned int state = Hash((unsigned int)particle * 0x9e3779b9u + (unsigned int)m_generation[particle]);
+	float angle = 6.2831853f * Random(state);
+	float distance = m_emitter.radius * std::sqrt(Random(state));
+	float spread = m_emitter.spread * Random(state);
+	float lift = 0.75f + 0.5f * Random(state);
+
+	m_positionX[particle] = m_emitter.position.x + std::cos(angle) * distance;
+	m_positionY[particle] = m_emitter.position.y;
+	m_positionZ[particle] = m_emitter.position.z + std::sin(angle) * distance;
+	m_velocityX[particle] = std::cos(angle) * spread;
+	m_velocityY[particle] = m_emitter.speed * lift;
+	m_velocityZ[particle] = std::sin(angle) * spread;
+}
+
+/***********************************************************
+ *  DownloadState()
+ *
+ *  This method is used for reading the current GPU state
+ *  back into the CPU arrays, when the simulation moves from
+ *  the GPU to the CPU.
+ ***********************************************************/
+void ParticleSystem::DownloadState()
+{
+	std::vector<float> state((size_t)m_particleCount * STATE_FLOATS);
+	glBindBuffer(GL_ARRAY_BUFFER, m_stateBuffers[m_currentBuffer]);
+	glGetBufferSubData(GL_ARRAY_BUFFER, 0, (GLsizeiptr)state.size() * sizeof(float), state.data());
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	for (int i = 0; i < m_particleCount; i++)
+	{
+		const float* pState = &state[(size_t)i * STATE_FLOATS];
+		m_positionX[i] = pState[0];
+		m_positionY[i] = pState[1];
+		m_positionZ[i] = pState[2];
+		m_age[i] = pState[3];
+		m_velocityX[i] = pState[4];
+		m_velocityY[i] = pState[5];
+		m_velocityZ[i] = pState[6];
+		m_generation[i] = pState[7];
+	}
+}
+
+/***********************************************************
+ *  UploadState()
+ *
+ *  This method is used for writing the CPU arrays into the
+ *  current GPU state buffer, when the simulation moves from
+ *  the CPU to the GPU or the particles are restarted.
+ ***********************************************************/
+void ParticleSystem::UploadState()
+{
+	std::vector<float> state((size_t)m_particleCount * STATE_FLOATS);
+	for (int i = 0; i < m_particleCount; i++)
+	{
+		float* pState = &state[(size_t)i * STATE_FLOATS];
+		pState[0] = m_positionX[i];
+		pState[1] = m_positionY[i];
+		pState[2] = m_positionZ[i];
+		pState[3] = m_age[i];
+		pState[4] = m_velocityX[i];
+		pState[5] = m_velocityY[i];
+		pState[6] = m_velocityZ[i];
+		pState[7] = m_generation[i];
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_stateBuffers[m_currentBuffer]);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, (GLsizeiptr)state.size() * sizeof(float), state.data());
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+/***********************************************************
+ *  Render()
+ *
+ *  This method is used for drawing every particle as a quad
+ *  facing the camera, with four vertices per instance and
+ *  one instance per particle in a single draw.  Outside of
+ *  the weighted blended transparency the sprites are added
+ *  onto the scene, which is the same in any order, so they
+ *  need no sorting.  The caller restores the blending.
+ ***********************************************************/
+void ParticleSystem::Render(bool bWeighted)
+{
+	if (m_particleCount == 0)
+	{
+		return;
+	}
+
+	m_pRenderShaderManager->use();
+	m_pRenderShaderManager->setFloatValue("particleSize", m_emitter.size);
+	m_pRenderShaderManager->setFloatValue("lifetime", m_emitter.lifetime);
+	m_pRenderShaderManager->setVec4Value("startColor", m_emitter.startColor);
+	m_pRenderShaderManager->setVec4Value("endColor", m_emitter.endColor);
+	m_pRenderShaderManager->setBoolValue("bWeightedTransparency", bWeighted);
+	if (!bWeighted)
+	{
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+	}
+
+	bool bCpuState = (m_stateMode == SIMULATE_CPU) || !m_bTransformFeedback;
+	glBindVertexArray(bCpuState ? m_cpuVertexArray : m_renderVertexArrays[m_currentBuffer]);
+	glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, m_particleCount);
+	glBindVertexArray(0);
+}
+
+/***********************************************************
+ *  DestroyBuffers()
+ *
+ *  This method is used for freeing the particle buffers and
+ *  vertex arrays.
+ ***********************************************************/
+void ParticleSystem::DestroyBuffers()
+{
+	if (m_stateBuffers[0] != 0)
+	{
+		glDeleteBuffers(2, m_stateBuffers);
+		glDeleteVertexArrays(2, m_updateVertexArrays);
+		glDeleteVertexArrays(2, m_renderVertexArrays);
+		m_stateBuffers[0] = 0;
+		m_stateBuffers[1] = 0;
+		m_updateVertexArrays[0] = 0;
+		m_updateVertexArrays[1] = 0;
+		m_renderVertexArrays[0] = 0;
+		m_renderVertexArrays[1] = 0;
+	}
+	if (m_cpuBuffer != 0)
+	{
+		glDeleteBuffers(1, &m_cpuBuffer);
+		glDeleteVertexArrays(1, &m_cpuVertexArray);
+		m_cpuBuffer = 0;
+		m_cpuVertexArray = 0;
+	}
+	m_particleCount = 0;
+}
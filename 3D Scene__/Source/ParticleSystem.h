@@ -0,0 +1,163 @@
+///////////////////////////////////////////////////////////////////////////////
+// particlesystem.h
+// ============
+// simulate a large number of particles and draw them as camera facing sprites
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderManager.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  ParticleSystem
+ *
+ *  This class simulates up to millions of particles thrown
+ *  from one emitter, falling under gravity and bouncing off
+ *  a floor, and re-emitted when their lifetime ends.  The
+ *  state of every particle stays in GPU buffers and is
+ *  advanced by a vertex shader whose outputs are captured
+ *  with transform feedback into a second buffer, the two
+ *  buffers swapping each step.  When the driver renders in
+ *  software, the same step runs on the CPU instead, four
+ *  particles per SIMD instruction on every core, and only
+ *  the positions are uploaded.  Either way the particles are
+ *  drawn as camera facing quads with one instanced draw.
+ ***********************************************************/
+class ParticleSystem
+{
+public:
+	// constructor
+	ParticleSystem();
+	// destructor
+	~ParticleSystem();
+
+	// where the particles are simulated
+	enum SIMULATION_MODE
+	{
+		// on the GPU, unless the driver renders in software
+		SIMULATE_AUTO,
+		// in a transform feedback pass on the GPU
+		SIMULATE_GPU,
+		// in SIMD lanes on all the CPU cores
+		SIMULATE_CPU,
+		SIMULATION_MODE_COUNT
+	};
+
+	// properties of the emitter and of the particle motion
+	struct EMITTER
+	{
+		glm::vec3 position;
+		// radius of the disc the particles leave from
+		float radius;
+		// upward and sideways speed of an emitted particle
+		float speed;
+		float spread;
+		// seconds from emitting a particle to emitting it again
+		float lifetime;
+		glm::vec3 gravity;
+		// fraction of the velocity kept per second
+		float drag;
+		// height of the surface the particles bounce off and the
+		// fraction of the vertical velocity they keep
+		float floorHeight;
+		float restitution;
+		// half the width of a sprite
+		float size;
+		// colors when emitted and when expiring, alpha included
+		glm::vec4 startColor;
+		glm::vec4 endColor;
+	};
+
+	// most particles a system can hold
+	static const int MAX_PARTICLES = 4 * 1024 * 1024;
+
+	// get the display name of a simulation mode
+	static const char* GetModeName(int mode);
+
+	// load the shaders and check for transform feedback - needs
+	// a current GL context
+	void Initialize();
+
+	// set the emitter the particles are thrown from
+	void SetEmitter(const EMITTER& emitter);
+	// allocate and restart the passed in number of particles
+	void SetParticleCount(int count);
+	// get the number of simulated particles
+	int GetParticleCount() const { return m_particleCount; }
+
+	// advance the particles by the passed in seconds in the
+	// passed in mode, resolved when it is not available
+	void Simulate(float deltaTime, int mode);
+	// draw the particles into the bound framebuffer with the
+	// bound camera block, additively blended or into the
+	// weighted blended transparency targets
+	void Render(bool bWeighted);
+
+	// get the shader the particles are drawn with
+	ShaderManager* GetRenderShader() const { return m_pRenderShaderManager; }
+	// get the mode the passed in mode resolves to
+	int ResolveMode(int mode) const;
+	// get whether the driver renders in software
+	bool IsSoftwareRenderer() const { return m_bSoftwareRenderer; }
+
+private:
+	// advance the particles on the GPU or on the CPU
+	void SimulateGPU(float deltaTime);
+	void SimulateCPU(float deltaTime);
+	// advance and pack a range of the CPU particles, starting
+	// and ending on a multiple of four
+	void SimulateRange(float deltaTime, float velocityKeep, int first, int last);
+	// emit a CPU particle whose age has reached its first
+	// emission or its lifetime
+	void EmitParticle(int particle);
+	// move the state to the side about to simulate it
+	void DownloadState();
+	void UploadState();
+	// free the particle buffers
+	void DestroyBuffers();
+
+	// shaders of the transform feedback step and of the sprites
+	ShaderManager* m_pUpdateShaderManager;
+	ShaderManager* m_pRenderShaderManager;
+	// the update program linked with its captured outputs
+	bool m_bTransformFeedback;
+	// the driver renders in software
+	bool m_bSoftwareRenderer;
+	EMITTER m_emitter;
+	int m_particleCount;
+
+	// particle state ping-ponged by the transform feedback step -
+	// the position and age, then the velocity and generation
+	GLuint m_stateBuffers[2];
+	// vertex arrays reading each state buffer for the update and
+	// for the sprites
+	GLuint m_updateVertexArrays[2];
+	GLuint m_renderVertexArrays[2];
+	// state buffer holding the current step
+	int m_currentBuffer;
+	// positions and ages uploaded by the CPU simulation, and the
+	// vertex array drawing them
+	GLuint m_cpuBuffer;
+	GLuint m_cpuVertexArray;
+	// mode the current state was last simulated in, or
+	// SIMULATE_AUTO while both copies are the same
+	int m_stateMode;
+
+	// state of the CPU simulation, one array per component and
+	// padded to a multiple of four particles
+	std::vector<float> m_positionX;
+	std::vector<float> m_positionY;
+	std::vector<float> m_positionZ;
+	std::vector<float> m_age;
+	std::vector<float> m_velocityX;
+	std::vector<float> m_velocityY;
+	std::vector<float> m_velocityZ;
+	std::vector<float> m_generation;
+	// positions and ages packed for the upload
+	std::vector<float> m_uploadData;
+};
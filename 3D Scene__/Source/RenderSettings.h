@@ -0,0 +1,97 @@
+///////////////////////////////////////////////////////////////////////////////
+// rendersettings.h
+// ============
+// runtime selectable rendering options shared by the view and scene managers
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+/***********************************************************
+ *  RENDER_SETTINGS
+ *
+ *  This structure holds the rendering options that can be
+ *  changed at startup from the command line or at runtime
+ *  from the keyboard.  One instance is owned by the main
+ *  code and shared with the view and scene managers.
+ ***********************************************************/
+struct RENDER_SETTINGS
+{
+	// selected shadow map quality tier (0 = shadows off)
+	int shadowQuality = 2;
+	// render a depth-only prepass and shade with GL_EQUAL depth testing
+	bool bDepthPrepass = false;
+	// sort the opaque draws front-to-back from the camera
+	bool bSortFrontToBack = true;
+	// skip the draws outside of the camera frustum
+	bool bFrustumCulling = true;
+	// skip the draws hidden behind the depth of an earlier frame
+	bool bOcclusionCulling = false;
+	// show the number of shaded fragments per pixel instead of lighting
+	bool bShowOverdraw = false;
+	// light the scene through the deferred G-buffer path
+	bool bDeferredShading = false;
+	// total number of point lights, padded with generated lights
+	// when above the scene's own (0 = the scene lights only)
+	int pointLightCount = 0;
+	// pass each draw only the additional point lights reaching its
+	// bounds, found in the light grid
+	bool bLightCulling = true;
+	// render into a floating point target resolved with tone mapping
+	bool bHDR = true;
+	// MSAA samples of the floating point target (1 = no MSAA)
+	int msaaSamples = 4;
+	// exposure scale applied before tone mapping
+	float exposure = 1.0f;
+	// tone mapping operator (see HDRRenderTarget::TONE_MAP_OPERATOR)
+	int toneMapOperator = 2;
+	// texture memory budget for the streamed mip levels in MB
+	// (0 = no limit)
+	int textureBudgetMB = 0;
+	// encode the scene images into compressed textures on load
+	bool bBakeTextures = false;
+	// render the front, side and top views next to the camera view
+	bool bMultiView = false;
+	// desks of the generated office (0 = the recorded desk only)
+	int officeDeskCount = 0;
+	// seed the office is generated from
+	unsigned int officeSeed = 330;
+	// play the keyframe animations of the monitor and pencils
+	bool bAnimate = false;
+	// upload the imported meshes in the packed 16 byte vertex format
+	bool bPackedVertices = false;
+	// how the blended draws are rendered over the opaque scene
+	// (see TransparencyRenderer::TRANSPARENCY_MODE)
+	int transparencyMode = 0;
+	// size of the floating point target relative to the window,
+	// upscaled into the window when below 1
+	float resolutionScale = 1.0f;
+	// adapt the resolution scale to the measured frame time
+	bool bAdaptiveResolution = false;
+	// frame time in ms the adaptive resolution keeps the frame within
+	float frameBudgetMs = 16.7f;
+	// smallest resolution scale the adaptive resolution may choose
+	float minResolutionScale = 0.5f;
+	// strength of the sharpening applied by the upscale (0 - 1)
+	float upscaleSharpness = 0.5f;
+	// how the frames of the main loop are paced
+	// (see FramePacer::PRESENT_MODE)
+	int presentMode = 0;
+	// frames per second of the frame limiter
+	int frameRateLimit = 60;
+	// take the diffuse lighting of the static draws from the
+	// baked lightmaps instead of lighting them per pixel
+	bool bLightmaps = false;
+	// trace shadow rays when baking the lightmaps
+	bool bLightmapOcclusion = true;
+	// quality of the screen space ambient occlusion
+	// (see AmbientOcclusion::QUALITY, 0 = off)
+	int ambientOcclusionQuality = 0;
+	// particles thrown over the desk (0 = no particles)
+	int particleCount = 0;
+	// where the particles are simulated
+	// (see ParticleSystem::SIMULATION_MODE)
+	int particleSimulation = 0;
+	// how the lit pass transforms the vertex normals, only changed
+	// to measure it (see SceneManager::NORMAL_TRANSFORM)
+	int normalTransform = 0;
+};
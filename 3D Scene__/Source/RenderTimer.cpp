@@ -0,0 +1,381 @@
+///////////////////////////////////////////////////////////////////////////////
+// rendertimer.cpp
+// ============
+// measure the CPU and GPU cost of the rendering passes in each frame
+///////////////////////////////////////////////////////////////////////////////
+
+#include "RenderTimer.h"
+
+#include <iostream>
+#include <iomanip>
+
+// declare the global variables
+namespace
+{
+	// default number of frames averaged between reports
+	const int DEFAULT_REPORT_INTERVAL = 300;
+
+	// convert a steady clock duration into milliseconds
+	double ElapsedMs(
+		std::chrono::steady_clock::time_point start,
+		std::chrono::steady_clock::time_point end)
+	{
+		return std::chrono::duration<double, std::milli>(end - start).count();
+	}
+}
+
+/***********************************************************
+ *  RenderTimer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+RenderTimer::RenderTimer()
+{
+	m_activePass = -1;
+	m_frameTotalMs = 0.0;
+	m_frameCount = 0;
+	m_averageCpuTotalMs = 0.0;
+	m_averageGpuTotalMs = 0.0;
+	m_averageFrameCount = 0;
+	m_lastCpuMs = 0.0;
+	m_lastGpuMs = 0.0;
+	m_reportInterval = DEFAULT_REPORT_INTERVAL;
+	m_queryFrame = 0;
+	m_bInitialized = false;
+}
+
+/***********************************************************
+ *  ~RenderTimer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+RenderTimer::~RenderTimer()
+{
+	if (m_bInitialized)
+	{
+		for (int i = 0; i < (int)m_passes.size(); i++)
+		{
+			glDeleteQueries(2, m_passes[i].queries);
+		}
+	}
+	m_passes.clear();
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for enabling the GPU queries once
+ *  the OpenGL context has been created.
+ ***********************************************************/
+void RenderTimer::Initialize()
+{
+	m_bInitialized = true;
+}
+
+/***********************************************************
+ *  SetReportInterval()
+ *
+ *  This method is used for setting how many frames are
+ *  averaged between the console reports.
+ ***********************************************************/
+void RenderTimer::SetReportInterval(int frames)
+{
+	if (frames > 0)
+	{
+		m_reportInterval = frames;
+	}
+}
+
+/***********************************************************
+ *  SetCounter()
+ *
+ *  This method is used for setting the value of the counter
+ *  associated with the passed in tag, creating it if needed.
+ *  The latest value is printed with each report.
+ ***********************************************************/
+void RenderTimer::SetCounter(const std::string& tag, double value)
+{
+	for (int i = 0; i < (int)m_counters.size(); i++)
+	{
+		if (m_counters[i].tag.compare(tag) == 0)
+		{
+			m_counters[i].value = value;
+			return;
+		}
+	}
+
+	COUNTER counter;
+	counter.tag = tag;
+	counter.value = value;
+	m_counters.push_back(counter);
+}
+
+/***********************************************************
+ *  GetCounter()
+ *
+ *  This method is used for getting the value of the counter
+ *  associated with the passed in tag.
+ ***********************************************************/
+double RenderTimer::GetCounter(const std::string& tag) const
+{
+	for (int i = 0; i < (int)m_counters.size(); i++)
+	{
+		if (m_counters[i].tag.compare(tag) == 0)
+		{
+			return(m_counters[i].value);
+		}
+	}
+	return(0.0);
+}
+
+/***********************************************************
+ *  ResetAverages()
+ *
+ *  This method is used for restarting the running averages
+ *  of the frame times, independent of the console reports.
+ ***********************************************************/
+void RenderTimer::ResetAverages()
+{
+	m_averageCpuTotalMs = 0.0;
+	m_averageGpuTotalMs = 0.0;
+	m_averageFrameCount = 0;
+	for (int i = 0; i < (int)m_passes.size(); i++)
+	{
+		m_passes[i].averageCpuTotalMs = 0.0;
+		m_passes[i].averageGpuTotalMs = 0.0;
+	}
+}
+
+/***********************************************************
+ *  GetAverageCpuMs()
+ *
+ *  This method is used for getting the average CPU time of
+ *  the frames since the averages were reset.
+ ***********************************************************/
+double RenderTimer::GetAverageCpuMs() const
+{
+	return (m_averageFrameCount > 0) ? (m_averageCpuTotalMs / m_averageFrameCount) : 0.0;
+}
+
+/***********************************************************
+ *  GetAverageGpuMs()
+ *
+ *  This method is used for getting the average GPU time of
+ *  all the passes of the frames since the averages were
+ *  reset.  The results are read back one frame late, which
+ *  evens out over a run of frames.
+ ***********************************************************/
+double RenderTimer::GetAverageGpuMs() const
+{
+	return (m_averageFrameCount > 0) ? (m_averageGpuTotalMs / m_averageFrameCount) : 0.0;
+}
+
+/***********************************************************
+ *  GetAveragePassCpuMs()
+ *
+ *  This method is used for getting the average CPU time per
+ *  frame of the pass associated with the passed in tag since
+ *  the averages were reset.
+ ***********************************************************/
+double RenderTimer::GetAveragePassCpuMs(const std::string& tag) const
+{
+	for (int i = 0; i < (int)m_passes.size(); i++)
+	{
+		if ((m_passes[i].tag.compare(tag) == 0) && (m_averageFrameCount > 0))
+		{
+			return(m_passes[i].averageCpuTotalMs / m_averageFrameCount);
+		}
+	}
+	return(0.0);
+}
+
+/***********************************************************
+ *  GetAveragePassGpuMs()
+ *
+ *  This method is used for getting the average GPU time per
+ *  frame of the pass associated with the passed in tag since
+ *  the averages were reset.
+ ***********************************************************/
+double RenderTimer::GetAveragePassGpuMs(const std::string& tag) const
+{
+	for (int i = 0; i < (int)m_passes.size(); i++)
+	{
+		if ((m_passes[i].tag.compare(tag) == 0) && (m_averageFrameCount > 0))
+		{
+			return(m_passes[i].averageGpuTotalMs / m_averageFrameCount);
+		}
+	}
+	return(0.0);
+}
+
+/***********************************************************
+ *  FindPass()
+ *
+ *  This method is used for getting the index of the timing
+ *  record for the passed in tag, creating it if needed.
+ ***********************************************************/
+int RenderTimer::FindPass(const std::string& tag)
+{
+	for (int i = 0; i < (int)m_passes.size(); i++)
+	{
+		if (m_passes[i].tag.compare(tag) == 0)
+		{
+			return(i);
+		}
+	}
+
+	PASS_TIMING pass;
+	pass.tag = tag;
+	pass.queries[0] = 0;
+	pass.queries[1] = 0;
+	pass.bQueryIssued[0] = false;
+	pass.bQueryIssued[1] = false;
+	pass.cpuTotalMs = 0.0;
+	pass.gpuTotalMs = 0.0;
+	pass.samples = 0;
+	pass.averageCpuTotalMs = 0.0;
+	pass.averageGpuTotalMs = 0.0;
+	if (m_bInitialized)
+	{
+		glGenQueries(2, pass.queries);
+	}
+	m_passes.push_back(pass);
+
+	return(m_passes.size() - 1);
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for marking the start of a frame.
+ ***********************************************************/
+void RenderTimer::BeginFrame()
+{
+	m_frameStart = std::chrono::steady_clock::now();
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used for marking the end of a frame.  The
+ *  GPU results written during the previous frame are read
+ *  back here, so they are normally already available.
+ ***********************************************************/
+void RenderTimer::EndFrame()
+{
+	double frameMs = ElapsedMs(m_frameStart, std::chrono::steady_clock::now());
+	m_frameTotalMs += frameMs;
+	m_frameCount++;
+	m_averageCpuTotalMs += frameMs;
+	m_averageFrameCount++;
+	m_lastCpuMs = frameMs;
+	m_lastGpuMs = 0.0;
+
+	// swap to the other half of the double buffered queries
+	m_queryFrame = 1 - m_queryFrame;
+
+	if (m_bInitialized)
+	{
+		for (int i = 0; i < (int)m_passes.size(); i++)
+		{
+			PASS_TIMING& pass = m_passes[i];
+			if (pass.bQueryIssued[m_queryFrame])
+			{
+				GLuint64 elapsedNs = 0;
+				glGetQueryObjectui64v(pass.queries[m_queryFrame], GL_QUERY_RESULT, &elapsedNs);
+				pass.gpuTotalMs += elapsedNs / 1000000.0;
+				pass.averageGpuTotalMs += elapsedNs / 1000000.0;
+				m_averageGpuTotalMs += elapsedNs / 1000000.0;
+				m_lastGpuMs += elapsedNs / 1000000.0;
+				pass.bQueryIssued[m_queryFrame] = false;
+			}
+		}
+	}
+
+	if (m_frameCount >= m_reportInterval)
+	{
+		Report();
+	}
+}
+
+/***********************************************************
+ *  BeginPass()
+ *
+ *  This method is used for starting the measurement of the
+ *  rendering pass associated with the passed in tag.
+ ***********************************************************/
+void RenderTimer::BeginPass(const std::string& tag)
+{
+	if (m_activePass >= 0)
+	{
+		EndPass();
+	}
+
+	m_activePass = FindPass(tag);
+	if (m_bInitialized)
+	{
+		glBeginQuery(GL_TIME_ELAPSED, m_passes[m_activePass].queries[m_queryFrame]);
+	}
+	m_passStart = std::chrono::steady_clock::now();
+}
+
+/***********************************************************
+ *  EndPass()
+ *
+ *  This method is used for stopping the measurement of the
+ *  currently active rendering pass.
+ ***********************************************************/
+void RenderTimer::EndPass()
+{
+	if (m_activePass < 0)
+	{
+		return;
+	}
+
+	PASS_TIMING& pass = m_passes[m_activePass];
+	double passMs = ElapsedMs(m_passStart, std::chrono::steady_clock::now());
+	pass.cpuTotalMs += passMs;
+	pass.averageCpuTotalMs += passMs;
+	pass.samples++;
+	if (m_bInitialized)
+	{
+		glEndQuery(GL_TIME_ELAPSED);
+		pass.bQueryIssued[m_queryFrame] = true;
+	}
+	m_activePass = -1;
+}
+
+/***********************************************************
+ *  Report()
+ *
+ *  This method is used for printing the averaged frame and
+ *  pass timings to the console.
+ ***********************************************************/
+void RenderTimer::Report()
+{
+	std::cout << std::fixed << std::setprecision(3);
+	std::cout << "TIMING: frame cpu " << (m_frameTotalMs / m_frameCount) << " ms over " << m_frameCount << " frames" << std::endl;
+
+	for (int i = 0; i < (int)m_passes.size(); i++)
+	{
+		PASS_TIMING& pass = m_passes[i];
+		if (pass.samples > 0)
+		{
+			std::cout << "TIMING:   " << std::left << std::setw(12) << pass.tag << std::right
+				<< " cpu " << (pass.cpuTotalMs / pass.samples) << " ms"
+				<< "  gpu " << (pass.gpuTotalMs / pass.samples) << " ms" << std::endl;
+		}
+		pass.cpuTotalMs = 0.0;
+		pass.gpuTotalMs = 0.0;
+		pass.samples = 0;
+	}
+	for (int i = 0; i < (int)m_counters.size(); i++)
+	{
+		std::cout << "COUNTER:  " << std::left << std::setw(24) << m_counters[i].tag << std::right
+			<< " " << m_counters[i].value << std::endl;
+	}
+	std::cout << std::defaultfloat << std::setprecision(6);
+
+	m_frameTotalMs = 0.0;
+	m_frameCount = 0;
+}
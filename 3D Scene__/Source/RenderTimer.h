@@ -0,0 +1,123 @@
+///////////////////////////////////////////////////////////////////////////////
+// rendertimer.h
+// ============
+// measure the CPU and GPU cost of the rendering passes in each frame
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  RenderTimer
+ *
+ *  This class collects per-pass frame timings.  Each named
+ *  pass is measured on the CPU with a steady clock and on
+ *  the GPU with a GL_TIME_ELAPSED query.  The GPU queries
+ *  are double buffered so that reading back a result never
+ *  stalls the pipeline, and the averaged timings are printed
+ *  to the console at a fixed frame interval.
+ ***********************************************************/
+class RenderTimer
+{
+public:
+	// constructor
+	RenderTimer();
+	// destructor
+	~RenderTimer();
+
+	// properties for one measured rendering pass
+	struct PASS_TIMING
+	{
+		std::string tag;
+		GLuint queries[2];
+		bool bQueryIssued[2];
+		double cpuTotalMs;
+		double gpuTotalMs;
+		int samples;
+		// CPU and GPU time accumulated since the averages were reset
+		double averageCpuTotalMs;
+		double averageGpuTotalMs;
+	};
+
+	// latest value of a named counter reported with the timings
+	struct COUNTER
+	{
+		std::string tag;
+		double value;
+	};
+
+	// create the GPU query objects - needs a current GL context
+	void Initialize();
+
+	// mark the beginning and the end of a rendered frame
+	void BeginFrame();
+	void EndFrame();
+
+	// mark the beginning and the end of a named pass - passes
+	// must not be nested since GL_TIME_ELAPSED queries cannot be
+	void BeginPass(const std::string& tag);
+	void EndPass();
+
+	// set how many frames are averaged between console reports
+	void SetReportInterval(int frames);
+
+	// set the current value of a named counter
+	void SetCounter(const std::string& tag, double value);
+	// get the current value of a named counter, or 0
+	double GetCounter(const std::string& tag) const;
+
+	// restart the running averages used by the benchmarks
+	void ResetAverages();
+	// get the average CPU frame time and the average summed GPU
+	// time of all passes since the last reset
+	double GetAverageCpuMs() const;
+	double GetAverageGpuMs() const;
+	// get the average CPU and GPU time of a named pass per frame
+	// since the last reset, or 0 when it was not measured
+	double GetAveragePassCpuMs(const std::string& tag) const;
+	double GetAveragePassGpuMs(const std::string& tag) const;
+	// get the CPU time of the last finished frame and the summed
+	// GPU time of the passes read back at its end, which were
+	// issued one frame earlier
+	double GetLastCpuMs() const { return m_lastCpuMs; }
+	double GetLastGpuMs() const { return m_lastGpuMs; }
+
+private:
+	// find or create the timing record for a named pass
+	int FindPass(const std::string& tag);
+	// print the averaged timings and reset the accumulators
+	void Report();
+
+	// measured rendering passes
+	std::vector<PASS_TIMING> m_passes;
+	// counters printed with the timings
+	std::vector<COUNTER> m_counters;
+	// index of the pass currently being measured, or -1
+	int m_activePass;
+	// CPU start time of the active pass
+	std::chrono::steady_clock::time_point m_passStart;
+	// CPU start time of the current frame
+	std::chrono::steady_clock::time_point m_frameStart;
+	// accumulated CPU time of whole frames
+	double m_frameTotalMs;
+	// frames accumulated since the last report
+	int m_frameCount;
+	// CPU and GPU time accumulated since the averages were reset
+	double m_averageCpuTotalMs;
+	double m_averageGpuTotalMs;
+	int m_averageFrameCount;
+	// CPU and GPU time of the last finished frame
+	double m_lastCpuMs;
+	double m_lastGpuMs;
+	// frames between console reports
+	int m_reportInterval;
+	// which half of the double buffered queries is written this frame
+	int m_queryFrame;
+	// whether the GPU queries are available
+	bool m_bInitialized;
+};
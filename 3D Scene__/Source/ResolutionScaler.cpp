@@ -0,0 +1,173 @@
+///////////////////////////////////////////////////////////////////////////////
+// resolutionscaler.cpp
+// ============
+// adapt the rendering resolution to the measured frame time
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ResolutionScaler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <iomanip>
+
+// declare the global variables
+namespace
+{
+	// frames averaged before the scale is adapted
+	const int HISTORY_FRAMES = 16;
+	// the scale moves in steps of this size
+	const float SCALE_STEP = 0.05f;
+	// the largest change of the scale in one adaptation - it
+	// falls faster than it rises so that a slow frame is fixed
+	// quickly without oscillating back over the budget
+	const float MAX_SCALE_DECREASE = 0.2f;
+	const float MAX_SCALE_INCREASE = 0.05f;
+	// fraction of the budget a lowered scale aims for, leaving
+	// room for the frame to frame variation
+	const float BUDGET_TARGET = 0.9f;
+	// fraction of the budget below which the scale is raised
+	const float BUDGET_RAISE = 0.75f;
+}
+
+/***********************************************************
+ *  ResolutionScaler()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ResolutionScaler::ResolutionScaler()
+{
+	m_cpuHistory.resize(HISTORY_FRAMES, 0.0);
+	m_gpuHistory.resize(HISTORY_FRAMES, 0.0);
+	m_historyNext = 0;
+	m_historyCount = 0;
+	m_bSkipFrame = false;
+	m_scale = 1.0f;
+	m_minScale = 0.5f;
+	m_maxScale = 1.0f;
+	m_budgetMs = 16.7f;
+}
+
+/***********************************************************
+ *  SetFrameBudget()
+ *
+ *  This method is used for setting the frame time in
+ *  milliseconds that the scale is adapted to.
+ ***********************************************************/
+void ResolutionScaler::SetFrameBudget(float budgetMs)
+{
+	m_budgetMs = std::max(budgetMs, 0.1f);
+}
+
+/***********************************************************
+ *  SetScaleRange()
+ *
+ *  This method is used for setting the smallest and largest
+ *  scale that may be chosen, moving the current scale into
+ *  the range.
+ ***********************************************************/
+void ResolutionScaler::SetScaleRange(float minScale, float maxScale)
+{
+	m_minScale = std::max(minScale, SCALE_STEP);
+	m_maxScale = std::max(maxScale, m_minScale);
+	SetScale(m_scale);
+}
+
+/***********************************************************
+ *  SetScale()
+ *
+ *  This method is used for setting the current scale.  The
+ *  history measured at another scale no longer tells the cost
+ *  of a frame, so it is cleared when the scale changes.
+ ***********************************************************/
+void ResolutionScaler::SetScale(float scale)
+{
+	scale = std::min(std::max(scale, m_minScale), m_maxScale);
+	if (scale != m_scale)
+	{
+		m_scale = scale;
+		ClearHistory();
+	}
+}
+
+/***********************************************************
+ *  ClearHistory()
+ *
+ *  This method is used for forgetting the timings measured
+ *  at the previous scale.
+ ***********************************************************/
+void ResolutionScaler::ClearHistory()
+{
+	m_historyNext = 0;
+	m_historyCount = 0;
+	m_bSkipFrame = true;
+}
+
+/***********************************************************
+ *  AddFrameTiming()
+ *
+ *  This method is used for adding the CPU and GPU time of a
+ *  finished frame to the history.  Once the history is full,
+ *  its average is compared with the budget: a slower frame
+ *  lowers the scale towards the size that would fit, and a
+ *  frame well under the budget raises it by one small step.
+ ***********************************************************/
+void ResolutionScaler::AddFrameTiming(double cpuMs, double gpuMs)
+{
+	if (m_bSkipFrame)
+	{
+		m_bSkipFrame = false;
+		return;
+	}
+
+	m_cpuHistory[m_historyNext] = cpuMs;
+	m_gpuHistory[m_historyNext] = gpuMs;
+	m_historyNext = (m_historyNext + 1) % HISTORY_FRAMES;
+	m_historyCount = std::min(m_historyCount + 1, HISTORY_FRAMES);
+	if (m_historyCount < HISTORY_FRAMES)
+	{
+		return;
+	}
+
+	double averageCpuMs = 0.0;
+	double averageGpuMs = 0.0;
+	for (int i = 0; i < HISTORY_FRAMES; i++)
+	{
+		averageCpuMs += m_cpuHistory[i];
+		averageGpuMs += m_gpuHistory[i];
+	}
+	averageCpuMs /= HISTORY_FRAMES;
+	averageGpuMs /= HISTORY_FRAMES;
+
+	// without timer queries the whole frame is all there is
+	double frameMs = (averageGpuMs > 0.0) ? averageGpuMs : averageCpuMs;
+
+	float scale = m_scale;
+	if (frameMs > m_budgetMs)
+	{
+		float fittedScale = m_scale * (float)std::sqrt(m_budgetMs * BUDGET_TARGET / frameMs);
+		scale = std::max(fittedScale, m_scale - MAX_SCALE_DECREASE);
+		scale = std::floor(scale / SCALE_STEP + 0.001f) * SCALE_STEP;
+	}
+	else if (frameMs < m_budgetMs * BUDGET_RAISE)
+	{
+		scale = m_scale + MAX_SCALE_INCREASE;
+	}
+	scale = std::min(std::max(scale, m_minScale), m_maxScale);
+
+	// keep measuring at the same scale while the frame fits
+	if (std::fabs(scale - m_scale) < SCALE_STEP * 0.5f)
+	{
+		ClearHistory();
+		m_bSkipFrame = false;
+		return;
+	}
+
+	std::cout << std::fixed << std::setprecision(2);
+	std::cout << "INFO: Resolution scale " << m_scale << " -> " << scale << " - cpu "
+		<< averageCpuMs << " ms, gpu " << averageGpuMs << " ms against a "
+		<< m_budgetMs << " ms budget" << std::endl;
+	std::cout << std::defaultfloat << std::setprecision(6);
+
+	SetScale(scale);
+}
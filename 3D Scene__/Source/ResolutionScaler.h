@@ -0,0 +1,65 @@
+///////////////////////////////////////////////////////////////////////////////
+// resolutionscaler.h
+// ============
+// adapt the rendering resolution to the measured frame time
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <vector>
+
+/***********************************************************
+ *  ResolutionScaler
+ *
+ *  This class chooses the scale of the offscreen target
+ *  relative to the window from a short history of frame
+ *  timings.  The cost that changes with the resolution is
+ *  the GPU time, so it drives the scale whenever the timer
+ *  queries are available, with the CPU frame time used
+ *  otherwise.  The shading cost grows with the number of
+ *  pixels, so a frame over the budget is corrected with the
+ *  square root of the ratio.  The scale moves in fixed steps,
+ *  falls faster than it rises, and is held until the history
+ *  has been refilled at the new scale, so the targets are not
+ *  recreated every frame.
+ ***********************************************************/
+class ResolutionScaler
+{
+public:
+	// constructor
+	ResolutionScaler();
+
+	// set the frame time the scale is adapted to
+	void SetFrameBudget(float budgetMs);
+	// set the smallest and largest scale that may be chosen
+	void SetScaleRange(float minScale, float maxScale);
+	// set the current scale, clearing the history when it changes
+	void SetScale(float scale);
+
+	// add the timings of a finished frame, adapting the scale
+	// once the history is full
+	void AddFrameTiming(double cpuMs, double gpuMs);
+
+	// get the chosen scale
+	float GetScale() const { return m_scale; }
+
+private:
+	// forget the timings measured at an earlier scale
+	void ClearHistory();
+
+	// CPU and GPU times of the latest frames at the current scale
+	std::vector<double> m_cpuHistory;
+	std::vector<double> m_gpuHistory;
+	// slot written by the next frame and frames in the history
+	int m_historyNext;
+	int m_historyCount;
+	// the GPU time read back after a change is still the time
+	// of the previous scale, so that frame is left out
+	bool m_bSkipFrame;
+	// chosen scale and the range it is kept within
+	float m_scale;
+	float m_minScale;
+	float m_maxScale;
+	// frame time the scale is adapted to
+	float m_budgetMs;
+};
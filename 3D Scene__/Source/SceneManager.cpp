@@ -2,6 +2,7 @@
 #include <sstream>  // Include this for stringstream
 
 #include "SceneManager.h"
+#include "TextureBaker.h"
 
 #ifndef STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_IMPLEMENTATION
@@ -10,14 +11,74 @@
 
 #include <glm/gtx/transform.hpp>
 
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <sys/types.h>
+#include <sys/stat.h>
+
 // declare the global variables
 namespace
 {
 	const char* g_ModelName = "model";
+	const char* g_NormalMatrixName = "normalMatrix";
 	const char* g_ColorValueName = "objectColor";
 	const char* g_TextureValueName = "objectTexture";
 	const char* g_UseTextureName = "bUseTexture";
 	const char* g_UseLightingName = "bUseLighting";
+	// decoding of the packed vertex format in the vertex shaders
+	const char* g_PositionScaleName = "positionScale";
+	const char* g_PositionOffsetName = "positionOffset";
+	const char* g_OctahedralNormalsName = "octahedralNormals";
+
+	// texture unit reserved for the shadow map, after the
+	// slots used by the scene textures
+	const int SHADOW_MAP_TEXTURE_UNIT = 15;
+	// texture unit reserved for the additional point light buffer
+	const int POINT_LIGHT_BUFFER_TEXTURE_UNIT = 14;
+	// texture unit reserved for the material table
+	const int MATERIAL_TABLE_TEXTURE_UNIT = 13;
+	// texture slots left for the scene textures, below the
+	// reserved units
+	const int MAX_SCENE_TEXTURES = MATERIAL_TABLE_TEXTURE_UNIT;
+	// texture unit reserved for the lightmap atlas, after the
+	// units of the HDR resolve and the upscale
+	const int LIGHTMAP_TEXTURE_UNIT = 28;
+	// file the baked lightmaps are saved to and loaded from
+	const char* g_LightmapFilename = "../textures/scene.lightmap";
+	// uniform calls the material of a draw took before the table
+	const int MATERIAL_UNIFORMS_PER_DRAW = 3;
+	// size of the point light array of the lighting shaders
+	// (TOTAL_POINT_LIGHTS)
+	const int MAX_SCENE_POINT_LIGHTS = 5;
+	// most additional point lights passed to one draw (MAX_DRAW_LIGHTS
+	// of fragmentShader.glsl)
+	const int MAX_DRAW_LIGHTS = 32;
+	// attenuation of the additional point lights, which reach about
+	// one desk of a generated office
+	const float EXTRA_LIGHT_CONSTANT = 1.0f;
+	const float EXTRA_LIGHT_LINEAR = 0.35f;
+	const float EXTRA_LIGHT_QUADRATIC = 0.44f;
+	// frames from rendering the depth to testing against it - a
+	// draw moved within them is never culled as occluded, since
+	// the depth may still show it at its old place
+	const int OCCLUSION_LATENCY_FRAMES = 3;
+	// longest step the particles are advanced by, so a stalled
+	// frame does not throw them through the floor
+	const float MAX_PARTICLE_STEP = 0.1f;
+	// version of the code that builds the office draws - raised
+	// when the built scene changes, so older snapshots are rebuilt
+	const unsigned int SCENE_BUILD_VERSION = 1;
+	// files an imported mesh is looked for in, in this order
+	const char* g_MeshExtensions[] = { ".gltf", ".glb", ".obj" };
+	const int MESH_EXTENSION_COUNT = sizeof(g_MeshExtensions) / sizeof(g_MeshExtensions[0]);
+
+	// camera uniform block shared by the camera pass shaders, laid
+	// out with std140 as view, projection and the padded position
+	const char* g_CameraBlockName = "Camera";
+	const GLuint CAMERA_BLOCK_BINDING = 0;
+	const int CAMERA_BLOCK_SIZE = 2 * sizeof(glm::mat4) + sizeof(glm::vec4);
 }
 
 /***********************************************************
@@ -37,6 +98,85 @@ SceneManager::SceneManager(ShaderManager* pShaderManager)
 		m_textureIDs[i].ID = -1;
 	}
 	m_loadedTextures = 0;
+
+	// initialize the draw state with the shader defaults
+	m_currentDraw.mesh = MESH_BOX;
+	m_currentDraw.importedMesh = -1;
+	m_currentDraw.modelMatrix = glm::mat4(1.0f);
+	m_currentDraw.normalMatrix = glm::mat3(1.0f);
+	m_currentDraw.materialTag = "";
+	m_currentDraw.materialIndex = -1;
+	m_currentDraw.textureTag = "";
+	m_currentDraw.bUseTexture = false;
+	m_currentDraw.color = glm::vec4(1.0f);
+	m_currentDraw.UVscale = glm::vec2(1.0f, 1.0f);
+	m_currentDraw.boundsMin = glm::vec3(0.0f);
+	m_currentDraw.boundsMax = glm::vec3(0.0f);
+	m_currentDraw.movedFrame = -OCCLUSION_LATENCY_FRAMES - 1;
+	m_sceneBoundsMin = glm::vec3(0.0f);
+	m_sceneBoundsMax = glm::vec3(0.0f);
+	m_officeDeskCount = 0;
+	m_officeSeed = 0;
+	m_drawsPerDesk = 0;
+	m_monitorFirst = 0;
+	m_monitorEnd = 0;
+	m_pencilFirst = 0;
+	m_pencilEnd = 0;
+	m_animationTime = 0.0f;
+	m_pParticleSystem = NULL;
+	m_particleTime = 0.0f;
+	m_mouseMesh = -1;
+	m_keyboardMesh = -1;
+	m_vertexFormatProgram = 0;
+	m_vertexFormatMesh = -1;
+	m_materialProgram = 0;
+	m_appliedMaterialIndex = -1;
+	m_materialUniformCalls = 0;
+	m_materialDraws = 0;
+
+	m_pRenderSettings = NULL;
+	m_pRenderTimer = NULL;
+	m_cameraBuffer = 0;
+	m_cameraBlockStride = 0;
+	m_pDepthShaderManager = NULL;
+	m_pShadowManager = NULL;
+	m_pPrepassShaderManager = NULL;
+	m_normalShaderManagers[NORMAL_PRECOMPUTED] = pShaderManager;
+	for (int i = NORMAL_PRECOMPUTED + 1; i < NORMAL_TRANSFORM_COUNT; i++)
+	{
+		m_normalShaderManagers[i] = NULL;
+	}
+	m_fragmentQuery = 0;
+	m_bFragmentQueryIssued = false;
+	m_shadedFragments = 0;
+	m_triangleQuery = 0;
+	m_litTriangles = 0;
+	m_bNormalTestObjects = false;
+	m_pDeferredRenderer = NULL;
+	m_pTransparencyRenderer = NULL;
+	m_bDrawBoundsChanged = false;
+	m_pOcclusionCuller = NULL;
+	m_occludedDrawCount = 0;
+	m_pAmbientOcclusion = NULL;
+	m_frameIndex = 0;
+	m_extraLightBuffer = 0;
+	m_extraLightTexture = 0;
+	m_extraPointLightCount = -1;
+	m_appliedDrawLightCount = -1;
+	m_drawLightsProgram = 0;
+	m_drawLightsLocation = -1;
+	m_drawLightSum = 0;
+	m_litDraws = 0;
+	m_directionalLightDirection = glm::vec3(0.0f, -1.0f, 0.0f);
+	m_spotLightPosition = glm::vec3(0.0f);
+	m_spotLightDirection = glm::vec3(0.0f, -1.0f, 0.0f);
+	m_spotLightOuterCutOff = 0.0f;
+	m_bakeLights.bDirectional = false;
+	m_bakeLights.bSpot = false;
+	m_lightmapTexture = 0;
+	m_bLightmapsStale = true;
+	m_bLightmapOcclusion = false;
+	m_lightmapFrame = 0;
 }
 
 /***********************************************************
@@ -50,6 +190,87 @@ SceneManager::~SceneManager()
 	m_pShaderManager = NULL;
 	delete m_basicMeshes;
 	m_basicMeshes = NULL;
+	if (NULL != m_pShadowManager)
+	{
+		delete m_pShadowManager;
+		m_pShadowManager = NULL;
+	}
+	if (NULL != m_pDepthShaderManager)
+	{
+		delete m_pDepthShaderManager;
+		m_pDepthShaderManager = NULL;
+	}
+	if (NULL != m_pPrepassShaderManager)
+	{
+		delete m_pPrepassShaderManager;
+		m_pPrepassShaderManager = NULL;
+	}
+	for (int i = NORMAL_PRECOMPUTED + 1; i < NORMAL_TRANSFORM_COUNT; i++)
+	{
+		if (NULL != m_normalShaderManagers[i])
+		{
+			delete m_normalShaderManagers[i];
+			m_normalShaderManagers[i] = NULL;
+		}
+	}
+	if (m_fragmentQuery != 0)
+	{
+		glDeleteQueries(1, &m_fragmentQuery);
+		m_fragmentQuery = 0;
+	}
+	if (m_triangleQuery != 0)
+	{
+		glDeleteQueries(1, &m_triangleQuery);
+		m_triangleQuery = 0;
+	}
+	if (NULL != m_pDeferredRenderer)
+	{
+		delete m_pDeferredRenderer;
+		m_pDeferredRenderer = NULL;
+	}
+	if (NULL != m_pTransparencyRenderer)
+	{
+		delete m_pTransparencyRenderer;
+		m_pTransparencyRenderer = NULL;
+	}
+	if (NULL != m_pOcclusionCuller)
+	{
+		delete m_pOcclusionCuller;
+		m_pOcclusionCuller = NULL;
+	}
+	if (NULL != m_pAmbientOcclusion)
+	{
+		delete m_pAmbientOcclusion;
+		m_pAmbientOcclusion = NULL;
+	}
+	if (NULL != m_pParticleSystem)
+	{
+		delete m_pParticleSystem;
+		m_pParticleSystem = NULL;
+	}
+	if (m_extraLightTexture != 0)
+	{
+		glDeleteTextures(1, &m_extraLightTexture);
+		m_extraLightTexture = 0;
+	}
+	if (m_extraLightBuffer != 0)
+	{
+		glDeleteBuffers(1, &m_extraLightBuffer);
+		m_extraLightBuffer = 0;
+	}
+	if (m_cameraBuffer != 0)
+	{
+		glDeleteBuffers(1, &m_cameraBuffer);
+		m_cameraBuffer = 0;
+	}
+	if (m_lightmapTexture != 0)
+	{
+		glDeleteTextures(1, &m_lightmapTexture);
+		m_lightmapTexture = 0;
+	}
+	DestroyImportedMeshes();
+	m_pRenderSettings = NULL;
+	m_pRenderTimer = NULL;
 	// destroy the created OpenGL textures
 	DestroyGLTextures();
 }
@@ -58,80 +279,47 @@ SceneManager::~SceneManager()
  *  CreateGLTexture()
  *
  *  This method is used for loading textures from image files,
- *  configuring the texture mapping parameters in OpenGL,
- *  generating the mipmaps, and loading the read texture into
- *  the next available texture slot in memory.
+ *  or from their baked compressed files when there are any,
+ *  into the next available texture slot.  The mip levels
+ *  are kept by the texture streamer, which uploads only the
+ *  mip tail here and the finer levels once they are needed.
  ***********************************************************/
 bool SceneManager::CreateGLTexture(const char* filename, std::string tag)
 {
-	int width = 0;
-	int height = 0;
-	int colorChannels = 0;
-	GLuint textureID = 0;
-
-	// indicate to always flip images vertically when loaded
-	stbi_set_flip_vertically_on_load(true);
-
-	// try to parse the image data from the specified image file
-	unsigned char* image = stbi_load(
-		filename,
-		&width,
-		&height,
-		&colorChannels,
-		0);
-
-	// if the image was successfully read from the image file
-	if (image)
+	// encode the compressed texture next to the image first
+	if ((NULL != m_pRenderSettings) && m_pRenderSettings->bBakeTextures)
 	{
-		std::cout << "Successfully loaded image:" << filename << ", width:" << width << ", height:" << height << ", channels:" << colorChannels << std::endl;
-
-		glGenTextures(1, &textureID);
-		glBindTexture(GL_TEXTURE_2D, textureID);
-
-		// set the texture wrapping parameters
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		// set texture filtering parameters
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-		// if the loaded image is in RGB format
-		if (colorChannels == 3)
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, image);
-		// if the loaded image is in RGBA format - it supports transparency
-		else if (colorChannels == 4)
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image);
-		else
-		{
-			std::cout << "Not implemented to handle image with " << colorChannels << " channels" << std::endl;
-			return false;
-		}
-
-		// generate the texture mipmaps for mapping textures to lower resolutions
-		glGenerateMipmap(GL_TEXTURE_2D);
-
-		// free the image data from local memory
-		stbi_image_free(image);
-		glBindTexture(GL_TEXTURE_2D, 0); // Unbind the texture
+		TextureBaker::BakeTexture(filename);
+	}
 
-		// register the loaded texture and associate it with the special tag string
-		m_textureIDs[m_loadedTextures].ID = textureID;
-		m_textureIDs[m_loadedTextures].tag = tag;
-		m_loadedTextures++;
+	// the slots above the scene textures are reserved
+	if (m_loadedTextures >= MAX_SCENE_TEXTURES)
+	{
+		std::cout << "No free texture slot for image:" << filename << std::endl;
+		return false;
+	}
 
-		return true;
+	int index = m_textureStreamer.AddTexture(filename);
+	if (index < 0)
+	{
+		// Error loading the image
+		return false;
 	}
 
-	std::cout << "Could not load image:" << filename << std::endl;
+	// register the loaded texture and associate it with the special tag string
+	m_textureIDs[m_loadedTextures].ID = m_textureStreamer.GetTextureID(index);
+	m_textureIDs[m_loadedTextures].tag = tag;
+	m_loadedTextures++;
 
-	// Error loading the image
-	return false;
+	return true;
 }
 
 /***********************************************************
  *  BindGLTextures
  *  This method is used for binding the loaded textures to
- *  OpenGL texture memory slots.  There are up to 16 slots.
+ *  OpenGL texture memory slots.  There are up to 13 slots,
+ *  below the units reserved for the material table, the
+ *  point light buffer and the shadow map.
  ***********************************************************/
 void SceneManager::BindGLTextures()
 {
@@ -151,10 +339,8 @@ void SceneManager::BindGLTextures()
  ***********************************************************/
 void SceneManager::DestroyGLTextures()
 {
-	for (int i = 0; i < m_loadedTextures; i++)
-	{
-		glGenTextures(1, &m_textureIDs[i].ID);
-	}
+	m_textureStreamer.Clear();
+	m_loadedTextures = 0;
 }
 
 /***********************************************************
@@ -217,35 +403,56 @@ int SceneManager::FindTextureSlot(std::string tag)
  ***********************************************************/
 bool SceneManager::FindMaterial(std::string tag, OBJECT_MATERIAL& material)
 {
-	if (m_objectMaterials.size() == 0)
+	int index = m_materialTable.FindMaterial(tag);
+	if (index < 0)
 	{
 		return(false);
 	}
 
-	int index = 0;
-	bool bFound = false;
-	while ((index < m_objectMaterials.size()) && (bFound == false))
+	material = m_materialTable.GetMaterial(index);
+	return(true);
+}
+
+/***********************************************************
+ *  UpdateMaterial()
+ *
+ *  This method is used for replacing the values of the
+ *  material associated with the passed in tag.  The draws
+ *  keep referring to it by index, and only the changed
+ *  entry of the material table is uploaded.
+ ***********************************************************/
+bool SceneManager::UpdateMaterial(std::string tag, const OBJECT_MATERIAL& material)
+{
+	int index = m_materialTable.FindMaterial(tag);
+	if (index < 0)
 	{
-		if (m_objectMaterials[index].tag.compare(tag) == 0)
-		{
-			bFound = true;
-			material.diffuseColor = m_objectMaterials[index].diffuseColor;
-			material.specularColor = m_objectMaterials[index].specularColor;
-			material.shininess = m_objectMaterials[index].shininess;
-		}
-		else
-		{
-			index++;
-		}
+		return(false);
 	}
 
+	OBJECT_MATERIAL updated = material;
+	updated.tag = tag;
+	m_materialTable.UpdateMaterial(index, updated);
+	// a blended material neither receives nor casts baked light
+	m_bLightmapsStale = true;
 	return(true);
 }
+
+/***********************************************************
+ *  ApplyMaterialTable()
+ *
+ *  This method is used for binding the material table to
+ *  the passed in shader, once per pass.
+ ***********************************************************/
+void SceneManager::ApplyMaterialTable(ShaderManager* pShaderManager)
+{
+	m_materialTable.ApplyToShader(pShaderManager, MATERIAL_TABLE_TEXTURE_UNIT);
+}
 /***********************************************************
  *  SetTransformations()
  *
- *  This method is used for setting the transform buffer
- *  using the passed in transformation values.
+ *  This method is used for setting the model matrix of the
+ *  current draw state using the passed in transformation
+ *  values.
  ***********************************************************/
 void SceneManager::SetTransformations(
 	glm::vec3 scaleXYZ,
@@ -274,17 +481,16 @@ void SceneManager::SetTransformations(
 
 	modelView = translation * rotationZ * rotationY * rotationX * scale;
 
-	if (NULL != m_pShaderManager)
-	{
-		m_pShaderManager->setMat4Value(g_ModelName, modelView);
-	}
+	m_currentDraw.modelMatrix = modelView;
+	// non-uniform scale would skew the normals with the model matrix
+	m_currentDraw.normalMatrix = glm::transpose(glm::inverse(glm::mat3(modelView)));
 }
 
 /***********************************************************
  *  SetShaderColor()
  *
  *  This method is used for setting the passed in color
- *  into the shader for the next draw command
+ *  into the draw state for the next draw command
  ***********************************************************/
 void SceneManager::SetShaderColor(
 	float redColorValue,
@@ -300,67 +506,493 @@ void SceneManager::SetShaderColor(
 	currentColor.b = blueColorValue;
 	currentColor.a = alphaValue;
 
-	if (NULL != m_pShaderManager)
-	{
-		m_pShaderManager->setIntValue(g_UseTextureName, false);
-		m_pShaderManager->setVec4Value(g_ColorValueName, currentColor);
-	}
+	m_currentDraw.bUseTexture = false;
+	m_currentDraw.color = currentColor;
 }
 
 /***********************************************************
  *  SetShaderTexture()
  *
- *  This method is used for setting the texture data
- *  associated with the passed in ID into the shader.
+ *  This method is used for setting the texture associated
+ *  with the passed in tag into the draw state.
  ***********************************************************/
 void SceneManager::SetShaderTexture(
 	std::string textureTag)
 {
-	if (NULL != m_pShaderManager)
-	{
-		m_pShaderManager->setIntValue(g_UseTextureName, true);
-
-		int textureID = -1;
-		textureID = FindTextureSlot(textureTag);
-		m_pShaderManager->setSampler2DValue(g_TextureValueName, textureID);
-	}
+	m_currentDraw.bUseTexture = true;
+	m_currentDraw.textureTag = textureTag;
 }
 
 /***********************************************************
  *  SetTextureUVScale()
  *
  *  This method is used for setting the texture UV scale
- *  values into the shader.
+ *  values into the draw state.
  ***********************************************************/
 void SceneManager::SetTextureUVScale(float u, float v)
 {
-	if (NULL != m_pShaderManager)
-	{
-		m_pShaderManager->setVec2Value("UVscale", glm::vec2(u, v));
-	}
+	m_currentDraw.UVscale = glm::vec2(u, v);
 }
 
 /***********************************************************
  *  SetShaderMaterial()
  *
- *  This method is used for passing the material values
- *  into the shader.
+ *  This method is used for setting the material associated
+ *  with the passed in tag into the draw state.
  ***********************************************************/
 void SceneManager::SetShaderMaterial(
 	std::string materialTag)
 {
-	if (m_objectMaterials.size() > 0)
+	m_currentDraw.materialTag = materialTag;
+	m_currentDraw.materialIndex = m_materialTable.FindMaterial(materialTag);
+}
+
+/***********************************************************
+ *  GetMeshBounds()
+ *
+ *  This method is used for getting the object space bounds
+ *  of the passed in basic mesh, matching the vertex data
+ *  generated by the ShapeMeshes class.
+ ***********************************************************/
+void SceneManager::GetMeshBounds(
+	MESH_SHAPE mesh,
+	glm::vec3& boundsMin,
+	glm::vec3& boundsMax)
+{
+	switch (mesh)
 	{
-		OBJECT_MATERIAL material;
-		bool bReturn = false;
+	case MESH_PLANE:
+		boundsMin = glm::vec3(-1.0f, 0.0f, -1.0f);
+		boundsMax = glm::vec3(1.0f, 0.0f, 1.0f);
+		break;
+	case MESH_BOX:
+		boundsMin = glm::vec3(-0.5f, -0.5f, -0.5f);
+		boundsMax = glm::vec3(0.5f, 0.5f, 0.5f);
+		break;
+	case MESH_CYLINDER:
+		boundsMin = glm::vec3(-1.0f, 0.0f, -1.0f);
+		boundsMax = glm::vec3(1.0f, 1.0f, 1.0f);
+		break;
+	case MESH_TORUS:
+		boundsMin = glm::vec3(-1.2f, -1.2f, -0.2f);
+		boundsMax = glm::vec3(1.2f, 1.2f, 0.2f);
+		break;
+	case MESH_SPHERE:
+	default:
+		boundsMin = glm::vec3(-1.0f, -1.0f, -1.0f);
+		boundsMax = glm::vec3(1.0f, 1.0f, 1.0f);
+		break;
+	}
+}
 
-		bReturn = FindMaterial(materialTag, material);
-		if (bReturn == true)
-		{
-			m_pShaderManager->setVec3Value("material.diffuseColor", material.diffuseColor);
-			m_pShaderManager->setVec3Value("material.specularColor", material.specularColor);
-			m_pShaderManager->setFloatValue("material.shininess", material.shininess);
-		}
+/***********************************************************
+ *  DrawMesh()
+ *
+ *  This method is used for recording a draw of the passed in
+ *  basic mesh into the draw list, using the draw state set
+ *  by the transformation and shader setters.  The world
+ *  space bounds of the draw are calculated here as well.
+ ***********************************************************/
+void SceneManager::DrawMesh(MESH_SHAPE mesh)
+{
+	m_currentDraw.mesh = mesh;
+	m_currentDraw.importedMesh = -1;
+	UpdateDrawBounds(m_currentDraw);
+	m_drawList.push_back(m_currentDraw);
+}
+
+/***********************************************************
+ *  DrawImportedMesh()
+ *
+ *  This method is used for recording a draw of the passed in
+ *  imported mesh into the draw list, the same way DrawMesh()
+ *  records the basic meshes.
+ ***********************************************************/
+void SceneManager::DrawImportedMesh(int importedMesh)
+{
+	m_currentDraw.importedMesh = importedMesh;
+	UpdateDrawBounds(m_currentDraw);
+	m_drawList.push_back(m_currentDraw);
+	m_currentDraw.importedMesh = -1;
+}
+
+/***********************************************************
+ *  LoadImportedMesh()
+ *
+ *  This method is used for loading the mesh of the passed
+ *  in name from the meshes folder, trying the glTF and then
+ *  the OBJ files.  The mesh is scaled into the bounds of the
+ *  basic mesh it replaces, so the transformations set up for
+ *  the basic mesh place it the same way, and is uploaded in
+ *  the interleaved vertex layout of the basic meshes.
+ ***********************************************************/
+int SceneManager::LoadImportedMesh(const std::string& name, MESH_SHAPE fittedMesh, MeshImporter::VERTEX_FORMAT format)
+{
+	MeshImporter::IMPORTED_MESH mesh;
+	MeshImporter::IMPORT_STATS stats;
+	std::string filename;
+	bool bLoaded = false;
+	for (int i = 0; (i < MESH_EXTENSION_COUNT) && !bLoaded; i++)
+	{
+		filename = "../meshes/" + name + g_MeshExtensions[i];
+		std::ifstream file(filename);
+		bLoaded = file.good() && MeshImporter::LoadMesh(filename, mesh, stats);
+	}
+	if (!bLoaded)
+	{
+		return(-1);
+	}
+
+	int importedMesh = AddImportedMesh(mesh, fittedMesh, format);
+
+	double totalMs = stats.loadMs + stats.optimizeMs;
+	std::cout << "INFO: Imported mesh " << filename << " - " << stats.vertexCount << " vertices (from "
+		<< stats.sourceVertexCount << "), " << stats.triangleCount << " triangles, ACMR "
+		<< stats.acmrBefore << " -> " << stats.acmrAfter << ", "
+		<< ((totalMs > 0.0) ? (stats.fileBytes / 1048576.0) / (totalMs / 1000.0) : 0.0) << " MB/s, "
+		<< ((format == MeshImporter::VERTEX_FORMAT_PACKED) ? "packed" : "float") << " vertices" << std::endl;
+
+	return(importedMesh);
+}
+
+/***********************************************************
+ *  AddImportedMesh()
+ *
+ *  This method is used for uploading a mesh as an imported
+ *  mesh.  It is first scaled into the bounds of the basic
+ *  mesh it replaces, so the transformations set up for the
+ *  basic mesh place it the same way.  The float format uses
+ *  the interleaved layout of the basic meshes; the packed
+ *  format feeds the same attribute locations with integers
+ *  and half floats, which the vertex shaders decode.
+ ***********************************************************/
+int SceneManager::AddImportedMesh(MeshImporter::IMPORTED_MESH& mesh, MESH_SHAPE fittedMesh, MeshImporter::VERTEX_FORMAT format)
+{
+	glm::vec3 fittedMin;
+	glm::vec3 fittedMax;
+	GetMeshBounds(fittedMesh, fittedMin, fittedMax);
+	glm::vec3 extent = mesh.boundsMax - mesh.boundsMin;
+	glm::vec3 scale;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		scale[axis] = (extent[axis] > 0.0f) ? (fittedMax[axis] - fittedMin[axis]) / extent[axis] : 1.0f;
+	}
+	glm::vec3 offset = (fittedMin + fittedMax) * 0.5f - (mesh.boundsMin + mesh.boundsMax) * 0.5f * scale;
+	for (int i = 0; i < (int)mesh.vertices.size(); i++)
+	{
+		MeshImporter::MESH_VERTEX& vertex = mesh.vertices[i];
+		vertex.position = vertex.position * scale + offset;
+		// a flattened axis keeps its normals unscaled
+		glm::vec3 normal = vertex.normal / glm::max(scale, glm::vec3(1.0e-6f));
+		vertex.normal = (glm::dot(normal, normal) > 0.0f) ? glm::normalize(normal) : vertex.normal;
+	}
+	mesh.boundsMin = mesh.boundsMin * scale + offset;
+	mesh.boundsMax = mesh.boundsMax * scale + offset;
+
+	IMPORTED_MESH_BUFFERS buffers;
+	buffers.indexCount = (GLsizei)mesh.indices.size();
+	buffers.boundsMin = mesh.boundsMin;
+	buffers.boundsMax = mesh.boundsMax;
+	buffers.format = format;
+	buffers.positionScale = glm::vec3(1.0f);
+	buffers.positionOffset = glm::vec3(0.0f);
+
+	if (format == MeshImporter::VERTEX_FORMAT_PACKED)
+	{
+		MeshImporter::PACKED_MESH packed;
+		MeshImporter::PackVertices(mesh, packed);
+		buffers.positionScale = packed.positionScale;
+		buffers.positionOffset = packed.positionOffset;
+		UploadImportedMesh(buffers, packed.vertices.data(),
+			packed.vertices.size() * sizeof(MeshImporter::PACKED_VERTEX), mesh.indices.data());
+	}
+	else
+	{
+		UploadImportedMesh(buffers, mesh.vertices.data(),
+			mesh.vertices.size() * sizeof(MeshImporter::MESH_VERTEX), mesh.indices.data());
+	}
+
+	m_importedMeshes.push_back(buffers);
+	return((int)m_importedMeshes.size() - 1);
+}
+
+/***********************************************************
+ *  UploadImportedMesh()
+ *
+ *  This method is used for creating the vertex array and
+ *  the buffers of an imported mesh.  The vertices are in
+ *  the format of the buffers, and its index count sets how
+ *  many indices are read.
+ ***********************************************************/
+void SceneManager::UploadImportedMesh(IMPORTED_MESH_BUFFERS& buffers, const void* pVertices, size_t vertexBytes, const unsigned int* pIndices)
+{
+	glGenVertexArrays(1, &buffers.vertexArray);
+	glGenBuffers(1, &buffers.vertexBuffer);
+	glGenBuffers(1, &buffers.indexBuffer);
+	glBindVertexArray(buffers.vertexArray);
+	glBindBuffer(GL_ARRAY_BUFFER, buffers.vertexBuffer);
+	glBufferData(GL_ARRAY_BUFFER, vertexBytes, pVertices, GL_STATIC_DRAW);
+
+	if (buffers.format == MeshImporter::VERTEX_FORMAT_PACKED)
+	{
+		// the integers reach the shader unnormalized
+		GLsizei stride = sizeof(MeshImporter::PACKED_VERTEX);
+		glVertexAttribPointer(0, 3, GL_SHORT, GL_FALSE, stride, (void*)offsetof(MeshImporter::PACKED_VERTEX, position));
+		glVertexAttribPointer(1, 2, GL_SHORT, GL_FALSE, stride, (void*)offsetof(MeshImporter::PACKED_VERTEX, normal));
+		glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, stride, (void*)offsetof(MeshImporter::PACKED_VERTEX, textureCoordinate));
+	}
+	else
+	{
+		GLsizei stride = sizeof(MeshImporter::MESH_VERTEX);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(MeshImporter::MESH_VERTEX, position));
+		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(MeshImporter::MESH_VERTEX, normal));
+		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(MeshImporter::MESH_VERTEX, textureCoordinate));
+	}
+	glEnableVertexAttribArray(0);
+	glEnableVertexAttribArray(1);
+	glEnableVertexAttribArray(2);
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers.indexBuffer);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, buffers.indexCount * sizeof(unsigned int), pIndices, GL_STATIC_DRAW);
+	glBindVertexArray(0);
+}
+
+/***********************************************************
+ *  DestroyImportedMeshes()
+ *
+ *  This method is used for freeing the vertex arrays and
+ *  buffers of every imported mesh.
+ ***********************************************************/
+void SceneManager::DestroyImportedMeshes()
+{
+	for (int i = 0; i < (int)m_importedMeshes.size(); i++)
+	{
+		glDeleteVertexArrays(1, &m_importedMeshes[i].vertexArray);
+		glDeleteBuffers(1, &m_importedMeshes[i].vertexBuffer);
+		glDeleteBuffers(1, &m_importedMeshes[i].indexBuffer);
+	}
+	m_importedMeshes.clear();
+	// the vertex decoding set up for a freed mesh is unknown now
+	m_vertexFormatProgram = 0;
+	m_vertexFormatMesh = -1;
+}
+
+/***********************************************************
+ *  SetMouseMesh()
+ *
+ *  This method is used for replacing the mesh the mouse is
+ *  drawn with and recording the draw list again.
+ ***********************************************************/
+void SceneManager::SetMouseMesh(int importedMesh)
+{
+	m_mouseMesh = ((importedMesh >= 0) && (importedMesh < (int)m_importedMeshes.size())) ? importedMesh : -1;
+	BuildDrawList();
+}
+
+/***********************************************************
+ *  UpdateDrawBounds()
+ *
+ *  This method is used for calculating the world space
+ *  bounds of a recorded draw from the bounds of its mesh
+ *  and its model matrix.
+ ***********************************************************/
+void SceneManager::UpdateDrawBounds(OBJECT_DRAW& draw)
+{
+	glm::vec3 localMin;
+	glm::vec3 localMax;
+	if (draw.importedMesh >= 0)
+	{
+		localMin = m_importedMeshes[draw.importedMesh].boundsMin;
+		localMax = m_importedMeshes[draw.importedMesh].boundsMax;
+	}
+	else
+	{
+		GetMeshBounds(draw.mesh, localMin, localMax);
+	}
+
+	// transform the 8 corners of the object space bounds
+	glm::vec3 worldMin = glm::vec3(1.0e30f);
+	glm::vec3 worldMax = glm::vec3(-1.0e30f);
+	for (int i = 0; i < 8; i++)
+	{
+		glm::vec3 corner = glm::vec3(
+			(i & 1) ? localMax.x : localMin.x,
+			(i & 2) ? localMax.y : localMin.y,
+			(i & 4) ? localMax.z : localMin.z);
+		glm::vec3 worldCorner = glm::vec3(draw.modelMatrix * glm::vec4(corner, 1.0f));
+		worldMin = glm::min(worldMin, worldCorner);
+		worldMax = glm::max(worldMax, worldCorner);
+	}
+
+	draw.boundsMin = worldMin;
+	draw.boundsMax = worldMax;
+}
+
+/***********************************************************
+ *  UpdateDrawBVH()
+ *
+ *  This method is used for building the hierarchy over the
+ *  draw bounds, or for refitting it to the moved bounds
+ *  while keeping the tree.
+ ***********************************************************/
+void SceneManager::UpdateDrawBVH(bool bRebuild)
+{
+	std::vector<BoundingVolumeHierarchy::BVH_BOUNDS> bounds(m_drawList.size());
+	for (int i = 0; i < (int)m_drawList.size(); i++)
+	{
+		bounds[i].boundsMin = m_drawList[i].boundsMin;
+		bounds[i].boundsMax = m_drawList[i].boundsMax;
+	}
+
+	if (bRebuild)
+	{
+		m_drawBVH.Build(bounds);
+	}
+	else
+	{
+		m_drawBVH.Refit(bounds);
+	}
+	m_bDrawBoundsChanged = false;
+}
+
+/***********************************************************
+ *  SetDrawTransform()
+ *
+ *  This method is used for moving a recorded draw.  Its
+ *  bounds are updated right away and the hierarchy is refit
+ *  once before the next frame, however many draws moved.
+ ***********************************************************/
+void SceneManager::SetDrawTransform(int index, const glm::mat4& modelMatrix)
+{
+	OBJECT_DRAW& draw = m_drawList[index];
+	draw.modelMatrix = modelMatrix;
+	draw.normalMatrix = glm::transpose(glm::inverse(glm::mat3(modelMatrix)));
+	UpdateDrawBounds(draw);
+	draw.movedFrame = m_frameIndex;
+	m_bDrawBoundsChanged = true;
+}
+
+/***********************************************************
+ *  PickDraw()
+ *
+ *  This method is used for finding the recorded draw whose
+ *  world bounds the passed in ray enters first.  Returns
+ *  the index of the draw and the distance along the ray, or
+ *  -1 when the ray misses every draw.
+ ***********************************************************/
+int SceneManager::PickDraw(glm::vec3 origin, glm::vec3 direction, float& distance) const
+{
+	return(m_drawBVH.QueryRay(origin, direction, distance));
+}
+
+/***********************************************************
+ *  DrawBasicMesh()
+ *
+ *  This method is used for issuing the draw call of the
+ *  passed in basic mesh.
+ ***********************************************************/
+void SceneManager::DrawBasicMesh(MESH_SHAPE mesh)
+{
+	switch (mesh)
+	{
+	case MESH_PLANE:
+		m_basicMeshes->DrawPlaneMesh();
+		break;
+	case MESH_BOX:
+		m_basicMeshes->DrawBoxMesh();
+		break;
+	case MESH_CYLINDER:
+		m_basicMeshes->DrawCylinderMesh();
+		break;
+	case MESH_TORUS:
+		m_basicMeshes->DrawTorusMesh();
+		break;
+	case MESH_SPHERE:
+		m_basicMeshes->DrawSphereMesh();
+		break;
+	}
+}
+
+/***********************************************************
+ *  DrawObjectMesh()
+ *
+ *  This method is used for issuing the draw call of the mesh
+ *  of a recorded draw, whether imported or basic.  The
+ *  decoding uniforms of the passed in shader are only set
+ *  when the vertex format changes between draws, which is
+ *  rare within a sorted pass.
+ ***********************************************************/
+void SceneManager::DrawObjectMesh(const OBJECT_DRAW& draw, ShaderManager* pShaderManager)
+{
+	int formatMesh = -1;
+	if ((draw.importedMesh >= 0) && (m_importedMeshes[draw.importedMesh].format == MeshImporter::VERTEX_FORMAT_PACKED))
+	{
+		formatMesh = draw.importedMesh;
+	}
+	if ((pShaderManager->m_programID != m_vertexFormatProgram) || (formatMesh != m_vertexFormatMesh))
+	{
+		bool bPacked = (formatMesh >= 0);
+		pShaderManager->setVec3Value(g_PositionScaleName, bPacked ? m_importedMeshes[formatMesh].positionScale : glm::vec3(1.0f));
+		pShaderManager->setVec3Value(g_PositionOffsetName, bPacked ? m_importedMeshes[formatMesh].positionOffset : glm::vec3(0.0f));
+		pShaderManager->setBoolValue(g_OctahedralNormalsName, bPacked);
+		m_vertexFormatProgram = pShaderManager->m_programID;
+		m_vertexFormatMesh = formatMesh;
+	}
+
+	if (draw.importedMesh < 0)
+	{
+		DrawBasicMesh(draw.mesh);
+		return;
+	}
+
+	const IMPORTED_MESH_BUFFERS& buffers = m_importedMeshes[draw.importedMesh];
+	glBindVertexArray(buffers.vertexArray);
+	glDrawElements(GL_TRIANGLES, buffers.indexCount, GL_UNSIGNED_INT, (void*)0);
+	glBindVertexArray(0);
+}
+
+/***********************************************************
+ *  ApplyDrawState()
+ *
+ *  This method is used for passing the transformation, color,
+ *  texture and material values of a recorded draw into the
+ *  passed in shader before its draw call is issued.
+ ***********************************************************/
+void SceneManager::ApplyDrawState(ShaderManager* pShaderManager, const OBJECT_DRAW& draw)
+{
+	if (NULL == pShaderManager)
+	{
+		return;
+	}
+
+	pShaderManager->setMat4Value(g_ModelName, draw.modelMatrix);
+	pShaderManager->setMat3Value(g_NormalMatrixName, draw.normalMatrix);
+
+	if (draw.bUseTexture == true)
+	{
+		pShaderManager->setIntValue(g_UseTextureName, true);
+
+		int textureID = -1;
+		textureID = FindTextureSlot(draw.textureTag);
+		pShaderManager->setSampler2DValue(g_TextureValueName, textureID);
+	}
+	else
+	{
+		pShaderManager->setIntValue(g_UseTextureName, false);
+		pShaderManager->setVec4Value(g_ColorValueName, draw.color);
+	}
+
+	pShaderManager->setVec2Value("UVscale", draw.UVscale);
+
+	// the shaders fetch the material from the table, so only its
+	// index is set, and only when it differs from the last draw
+	m_materialDraws++;
+	if ((pShaderManager->m_programID != m_materialProgram) || (draw.materialIndex != m_appliedMaterialIndex))
+	{
+		pShaderManager->setIntValue("materialIndex", draw.materialIndex);
+		m_materialProgram = pShaderManager->m_programID;
+		m_appliedMaterialIndex = draw.materialIndex;
+		m_materialUniformCalls++;
 	}
 }
 
@@ -401,7 +1033,7 @@ void SceneManager::LoadSceneTextures()
  *  This method defines the materials used in the 3D scene.
  *  The materials are created with specific diffuse, specular
  *  colors, and shininess values. These materials are then
- *  added to the `m_objectMaterials` list for later use in rendering
+ *  added to the material table for later use in rendering
  *  the objects. This includes materials like gold, wood, glass,
  *  plate, and fabric.
  ***********************************************************/
@@ -412,35 +1044,35 @@ void SceneManager::DefineObjectMaterials()
 	goldMaterial.specularColor = glm::vec3(0.7f, 0.7f, 0.6f);
 	goldMaterial.shininess = 52.0;
 	goldMaterial.tag = "metal";
-	m_objectMaterials.push_back(goldMaterial);
+	m_materialTable.AddMaterial(goldMaterial);
 
 	OBJECT_MATERIAL woodMaterial;
 	woodMaterial.diffuseColor = glm::vec3(0.2f, 0.2f, 0.3f);
 	woodMaterial.specularColor = glm::vec3(0.0f, 0.0f, 0.0f);
 	woodMaterial.shininess = 0.1;
 	woodMaterial.tag = "wood";
-	m_objectMaterials.push_back(woodMaterial);
+	m_materialTable.AddMaterial(woodMaterial);
 
 	OBJECT_MATERIAL glassMaterial;
 	glassMaterial.diffuseColor = glm::vec3(0.2f, 0.2f, 0.2f);
 	glassMaterial.specularColor = glm::vec3(1.0f, 1.0f, 1.0f);
 	glassMaterial.shininess = 95.0;
 	glassMaterial.tag = "glass";
-	m_objectMaterials.push_back(glassMaterial);
+	m_materialTable.AddMaterial(glassMaterial);
 
 	OBJECT_MATERIAL plateMaterial;
 	plateMaterial.diffuseColor = glm::vec3(0.4f, 0.4f, 0.4f);
 	plateMaterial.specularColor = glm::vec3(0.2f, 0.2f, 0.2f);
 	plateMaterial.shininess = 30.0;
 	plateMaterial.tag = "plate";
-	m_objectMaterials.push_back(plateMaterial);
+	m_materialTable.AddMaterial(plateMaterial);
 
 	OBJECT_MATERIAL fabricMaterial;
 	fabricMaterial.diffuseColor = glm::vec3(0.6f, 0.3f, 0.2f);
 	fabricMaterial.specularColor = glm::vec3(0.1f, 0.1f, 0.1f);
 	fabricMaterial.shininess = 10.0;
 	fabricMaterial.tag = "fabric";
-	m_objectMaterials.push_back(fabricMaterial);
+	m_materialTable.AddMaterial(fabricMaterial);
 }
 
 /***********************************************************
@@ -456,10 +1088,52 @@ void SceneManager::DefineObjectMaterials()
  ***********************************************************/
 void SceneManager::SetupSceneLights()
 {
-	if (m_pShaderManager)
+	// only the active point lights are kept, so the shaders loop
+	// over them without checking each one
+	m_scenePointLights.clear();
+
+	// the scene lights are not attenuated, and reach everywhere
+	POINT_LIGHT pointLight;
+	pointLight.position = glm::vec3(0.0f, 5.0f, 0.0f);
+	pointLight.ambient = glm::vec3(0.3f, 0.3f, 0.3f);
+	pointLight.diffuse = glm::vec3(1.0f, 1.0f, 1.0f);
+	pointLight.specular = glm::vec3(1.0f, 1.0f, 1.0f);
+	pointLight.constant = 1.0f;
+	pointLight.linear = 0.0f;
+	pointLight.quadratic = 0.0f;
+	m_scenePointLights.push_back(pointLight);
+
+	// Add a secondary Point Light 
+	pointLight.position = glm::vec3(5.0f, 3.0f, 5.0f);
+	m_scenePointLights.push_back(pointLight);
+
+	for (int i = 0; i < (int)m_scenePointLights.size(); i++)
+	{
+		POINT_LIGHT& light = m_scenePointLights[i];
+		light.radius = LightGrid::ComputeInfluenceRadius(
+			glm::max(light.ambient, light.diffuse), light.constant, light.linear, light.quadratic);
+	}
+	if (m_scenePointLights.size() > MAX_SCENE_POINT_LIGHTS)
+	{
+		m_scenePointLights.resize(MAX_SCENE_POINT_LIGHTS);
+	}
+
+	ApplySceneLights(m_pShaderManager);
+}
+
+/***********************************************************
+ *  ApplySceneLights()
+ *
+ *  This method is used for passing the scene light values
+ *  into the passed in shader, so that every shader that
+ *  evaluates the lighting uses the same light setup.
+ ***********************************************************/
+void SceneManager::ApplySceneLights(ShaderManager* pShaderManager)
+{
+	if (pShaderManager)
 	{
 		// Enable lighting in shader
-		m_pShaderManager->setBoolValue("bUseLighting", true);  // Enable lighting
+		pShaderManager->setBoolValue("bUseLighting", true);  // Enable lighting
 
 		// Setup Directional Light
 		glm::vec3 directionalLightDirection = glm::vec3(-0.2f, -1.0f, -0.3f);
@@ -467,109 +1141,2023 @@ void SceneManager::SetupSceneLights()
 		glm::vec3 directionalLightDiffuse = glm::vec3(1.0f, 1.0f, 1.0f); 
 		glm::vec3 directionalLightSpecular = glm::vec3(1.0f, 1.0f, 1.0f);
 
-		m_pShaderManager->setVec3Value("directionalLight.direction", directionalLightDirection);
-		m_pShaderManager->setVec3Value("directionalLight.ambient", directionalLightAmbient);
-		m_pShaderManager->setVec3Value("directionalLight.diffuse", directionalLightDiffuse);
-		m_pShaderManager->setVec3Value("directionalLight.specular", directionalLightSpecular);
-		m_pShaderManager->setBoolValue("directionalLight.bActive", true);
-
-		// Setup Point Lights 
-		glm::vec3 pointLightPosition = glm::vec3(0.0f, 5.0f, 0.0f);
-		glm::vec3 pointLightAmbient = glm::vec3(0.3f, 0.3f, 0.3f);  
-		glm::vec3 pointLightDiffuse = glm::vec3(1.0f, 1.0f, 1.0f);
-		glm::vec3 pointLightSpecular = glm::vec3(1.0f, 1.0f, 1.0f);
-
-		m_pShaderManager->setVec3Value("pointLights[0].position", pointLightPosition);
-		m_pShaderManager->setVec3Value("pointLights[0].ambient", pointLightAmbient);
-		m_pShaderManager->setVec3Value("pointLights[0].diffuse", pointLightDiffuse);
-		m_pShaderManager->setVec3Value("pointLights[0].specular", pointLightSpecular);
-		m_pShaderManager->setBoolValue("pointLights[0].bActive", true); 
-
-		// Disable remaining point lights if any
-		for (int i = 1; i < 5; i++) {
-			m_pShaderManager->setBoolValue("pointLights[" + std::to_string(i) + "].bActive", false);
-			std::cout << "Point Light [" << i << "] disabled." << std::endl;
-		}
-
-		// Add a secondary Point Light 
-		glm::vec3 pointLightPosition2 = glm::vec3(5.0f, 3.0f, 5.0f); 
-		glm::vec3 pointLightAmbient2 = glm::vec3(0.3f, 0.3f, 0.3f);
-		glm::vec3 pointLightDiffuse2 = glm::vec3(1.0f, 1.0f, 1.0f);
-		glm::vec3 pointLightSpecular2 = glm::vec3(1.0f, 1.0f, 1.0f);
-
-		m_pShaderManager->setVec3Value("pointLights[1].position", pointLightPosition2);
-		m_pShaderManager->setVec3Value("pointLights[1].ambient", pointLightAmbient2);
-		m_pShaderManager->setVec3Value("pointLights[1].diffuse", pointLightDiffuse2);
-		m_pShaderManager->setVec3Value("pointLights[1].specular", pointLightSpecular2);
-		m_pShaderManager->setBoolValue("pointLights[1].bActive", true);  // Enable second point light
+		m_directionalLightDirection = directionalLightDirection;
+		m_bakeLights.bDirectional = true;
+		m_bakeLights.directionalDirection = directionalLightDirection;
+		m_bakeLights.directionalDiffuse = directionalLightDiffuse;
+		m_bakeLights.pointPositions.clear();
+		m_bakeLights.pointDiffuse.clear();
+
+		pShaderManager->setVec3Value("directionalLight.direction", directionalLightDirection);
+		pShaderManager->setVec3Value("directionalLight.ambient", directionalLightAmbient);
+		pShaderManager->setVec3Value("directionalLight.diffuse", directionalLightDiffuse);
+		pShaderManager->setVec3Value("directionalLight.specular", directionalLightSpecular);
+		pShaderManager->setBoolValue("directionalLight.bActive", true);
+
+		// Setup Point Lights - the shaders loop over the first
+		// pointLightCount entries, so the unused ones are never set
+		for (int i = 0; i < (int)m_scenePointLights.size(); i++)
+		{
+			const POINT_LIGHT& light = m_scenePointLights[i];
+			std::string name = "pointLights[" + std::to_string(i) + "].";
+			pShaderManager->setVec3Value(name + "position", light.position);
+			pShaderManager->setVec3Value(name + "ambient", light.ambient);
+			pShaderManager->setVec3Value(name + "diffuse", light.diffuse);
+			pShaderManager->setVec3Value(name + "specular", light.specular);
+			pShaderManager->setFloatValue(name + "constant", light.constant);
+			pShaderManager->setFloatValue(name + "linear", light.linear);
+			pShaderManager->setFloatValue(name + "quadratic", light.quadratic);
+			pShaderManager->setFloatValue(name + "radius", light.radius);
+			m_bakeLights.pointPositions.push_back(light.position);
+			m_bakeLights.pointDiffuse.push_back(light.diffuse);
+		}
+		pShaderManager->setIntValue("pointLightCount", (int)m_scenePointLights.size());
+
+		// Setup Spot Light with increased cut-off angles to cover more area
+		glm::vec3 spotLightPosition = glm::vec3(0.0f, 4.0f, 5.0f);
+		glm::vec3 spotLightDirection = glm::vec3(0.0f, -1.0f, -1.0f);
+		float spotLightCutOff = glm::cos(glm::radians(20.0f)); // Wider angle
+		float spotLightOuterCutOff = glm::cos(glm::radians(25.0f)); // Outer angle for broader coverage
+		glm::vec3 spotLightAmbient = glm::vec3(0.2f, 0.2f, 0.2f);
+		glm::vec3 spotLightDiffuse = glm::vec3(1.0f, 1.0f, 1.0f);
+		glm::vec3 spotLightSpecular = glm::vec3(1.0f, 1.0f, 1.0f);
+
+		m_spotLightPosition = spotLightPosition;
+		m_spotLightDirection = spotLightDirection;
+		m_spotLightOuterCutOff = spotLightOuterCutOff;
+		m_bakeLights.bSpot = true;
+		m_bakeLights.spotPosition = spotLightPosition;
+		m_bakeLights.spotDirection = spotLightDirection;
+		m_bakeLights.spotCutOff = spotLightCutOff;
+		m_bakeLights.spotOuterCutOff = spotLightOuterCutOff;
+		m_bakeLights.spotDiffuse = spotLightDiffuse;
+
+		pShaderManager->setVec3Value("spotLight.position", spotLightPosition);
+		pShaderManager->setVec3Value("spotLight.direction", spotLightDirection);
+		pShaderManager->setFloatValue("spotLight.cutOff", spotLightCutOff);
+		pShaderManager->setFloatValue("spotLight.outerCutOff", spotLightOuterCutOff);
+		pShaderManager->setVec3Value("spotLight.ambient", spotLightAmbient);
+		pShaderManager->setVec3Value("spotLight.diffuse", spotLightDiffuse);
+		pShaderManager->setVec3Value("spotLight.specular", spotLightSpecular);
+		pShaderManager->setBoolValue("spotLight.bActive", true);
+	}
+}
+
+
+/***********************************************************
+ *  PrepareScene()
+ *
+ *  This method is used for preparing the 3D scene by loading
+ *  the shapes, textures in memory to support the 3D scene
+ *  rendering
+ ***********************************************************/
+void SceneManager::PrepareScene()
+{
+	// load the textures for the 3D scene
+	LoadSceneTextures();
+
+	// only one instance of a particular mesh needs to be
+	// loaded in memory no matter how many times it is drawn
+	// in the rendered 3D scene
+
+	  // Define materials
+	DefineObjectMaterials();
+
+	// Setup lights
+	SetupSceneLights();
+
+	m_basicMeshes->LoadPlaneMesh();     // For the table
+	m_basicMeshes->LoadBoxMesh();       // For monitor, keyboard, books
+	m_basicMeshes->LoadCylinderMesh();  // For the mug and pencil holder
+	m_basicMeshes->LoadTorusMesh();     // For the mug handle
+	m_basicMeshes->LoadSphereMesh();    // For the mouse
+
+	if (NULL != m_pRenderSettings)
+	{
+		m_officeDeskCount = m_pRenderSettings->officeDeskCount;
+		m_officeSeed = m_pRenderSettings->officeSeed;
+	}
+
+	// a snapshot of the same scene replaces the imported meshes
+	// and the recorded draws
+	bool bSnapshotLoaded = !m_snapshotFile.empty() &&
+		LoadSnapshot(m_snapshotFile, m_officeDeskCount, m_officeSeed);
+
+	// imported meshes replace the basic shapes when present
+	if (!bSnapshotLoaded)
+	{
+		MeshImporter::VERTEX_FORMAT vertexFormat = ((NULL != m_pRenderSettings) && m_pRenderSettings->bPackedVertices) ?
+			MeshImporter::VERTEX_FORMAT_PACKED : MeshImporter::VERTEX_FORMAT_FLOAT;
+		m_mouseMesh = LoadImportedMesh("mouse", MESH_SPHERE, vertexFormat);
+		m_keyboardMesh = LoadImportedMesh("keyboard", MESH_BOX, vertexFormat);
+	}
+
+	// load the depth-only shader and create the shadow maps
+	m_pDepthShaderManager = new ShaderManager();
+	m_pDepthShaderManager->LoadShaders(
+		"../shaders/shadowVertexShader.glsl",
+		"../shaders/shadowFragmentShader.glsl");
+	m_pShadowManager = new ShadowManager(m_pDepthShaderManager);
+	if (NULL != m_pRenderSettings)
+	{
+		m_pShadowManager->SetQuality(m_pRenderSettings->shadowQuality);
+	}
+	else
+	{
+		m_pShadowManager->SetQuality(2);
+	}
+
+	// load the trivial shader used for the depth prepass
+	m_pPrepassShaderManager = new ShaderManager();
+	m_pPrepassShaderManager->LoadShaders(
+		"../shaders/prepassVertexShader.glsl",
+		"../shaders/shadowFragmentShader.glsl");
+
+	// one camera block per view, each starting at an offset that
+	// can be bound as a uniform buffer range
+	GLint offsetAlignment = 256;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &offsetAlignment);
+	m_cameraBlockStride = ((CAMERA_BLOCK_SIZE + offsetAlignment - 1) / offsetAlignment) * offsetAlignment;
+	glGenBuffers(1, &m_cameraBuffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, m_cameraBuffer);
+	glBufferData(GL_UNIFORM_BUFFER, m_cameraBlockStride * MAX_VIEWS, NULL, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	BindCameraBlock(m_pShaderManager);
+	BindCameraBlock(m_pPrepassShaderManager);
+
+	// the loaded shaders leave the lighting shader inactive
+	m_pShaderManager->use();
+
+	glGenQueries(1, &m_fragmentQuery);
+	glGenQueries(1, &m_triangleQuery);
+
+	// the buffer of additional point lights starts out empty
+	glGenBuffers(1, &m_extraLightBuffer);
+	glGenTextures(1, &m_extraLightTexture);
+	GenerateExtraPointLights(0);
+
+	// the scene is static, so the draws are recorded only once,
+	// and kept in the snapshot for the next start
+	if (!bSnapshotLoaded)
+	{
+		BuildDrawList();
+		if (!m_snapshotFile.empty())
+		{
+			SaveSnapshot(m_snapshotFile);
+		}
+	}
+}
+
+/***********************************************************
+ *  SetRenderSettings()
+ *
+ *  This method is used for setting the shared rendering
+ *  options that are changed from the keyboard.
+ ***********************************************************/
+void SceneManager::SetRenderSettings(RENDER_SETTINGS* pRenderSettings)
+{
+	m_pRenderSettings = pRenderSettings;
+}
+
+/***********************************************************
+ *  SetRenderTimer()
+ *
+ *  This method is used for setting the collector that the
+ *  rendering pass timings are reported to.
+ ***********************************************************/
+void SceneManager::SetRenderTimer(RenderTimer* pRenderTimer)
+{
+	m_pRenderTimer = pRenderTimer;
+}
+
+/***********************************************************
+ *  SetViews()
+ *
+ *  This method is used for setting the views of the frame
+ *  about to be rendered, up to MAX_VIEWS.  The first view
+ *  is the camera the shadow cascades are fitted to.
+ ***********************************************************/
+void SceneManager::SetViews(const std::vector<SCENE_VIEW>& views)
+{
+	int viewCount = glm::min((int)views.size(), (int)MAX_VIEWS);
+	m_views.assign(views.begin(), views.begin() + viewCount);
+}
+
+/***********************************************************
+ *  GetVisibleDrawCount()
+ *
+ *  This method is used for getting the number of draws
+ *  rendered by the last frame, summed over its views.
+ ***********************************************************/
+int SceneManager::GetVisibleDrawCount() const
+{
+	int visibleCount = 0;
+	for (int i = 0; i < (int)m_viewDrawOrders.size(); i++)
+	{
+		visibleCount += (int)m_viewDrawOrders[i].size();
+	}
+	return(visibleCount + GetTransparentDrawCount());
+}
+
+/***********************************************************
+ *  GetTransparentDrawCount()
+ *
+ *  This method is used for getting the number of transparent
+ *  draws rendered by the last frame over all of its views.
+ ***********************************************************/
+int SceneManager::GetTransparentDrawCount() const
+{
+	int transparentCount = 0;
+	for (int i = 0; i < (int)m_viewTransparentOrders.size(); i++)
+	{
+		transparentCount += (int)m_viewTransparentOrders[i].size();
+	}
+	return(transparentCount);
+}
+
+/***********************************************************
+ *  BindCameraBlock()
+ *
+ *  This method is used for linking the camera uniform block
+ *  of a shader to the binding point of the camera buffer.
+ *  Shaders without the block are left unchanged.
+ ***********************************************************/
+void SceneManager::BindCameraBlock(ShaderManager* pShaderManager)
+{
+	if (NULL == pShaderManager)
+	{
+		return;
+	}
+
+	GLuint blockIndex = glGetUniformBlockIndex(pShaderManager->m_programID, g_CameraBlockName);
+	if (blockIndex != GL_INVALID_INDEX)
+	{
+		glUniformBlockBinding(pShaderManager->m_programID, blockIndex, CAMERA_BLOCK_BINDING);
+	}
+}
+
+/***********************************************************
+ *  UploadCameraViews()
+ *
+ *  This method is used for writing the camera blocks of all
+ *  the views into the camera buffer with a single upload.
+ ***********************************************************/
+void SceneManager::UploadCameraViews()
+{
+	std::vector<unsigned char> blocks(m_cameraBlockStride * m_views.size(), 0);
+	for (int i = 0; i < (int)m_views.size(); i++)
+	{
+		unsigned char* pBlock = &blocks[i * m_cameraBlockStride];
+		memcpy(pBlock, &m_views[i].view[0][0], sizeof(glm::mat4));
+		memcpy(pBlock + sizeof(glm::mat4), &m_views[i].projection[0][0], sizeof(glm::mat4));
+		memcpy(pBlock + 2 * sizeof(glm::mat4), &m_views[i].position[0], sizeof(glm::vec3));
+	}
+
+	glBindBuffer(GL_UNIFORM_BUFFER, m_cameraBuffer);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, blocks.size(), blocks.data());
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+/***********************************************************
+ *  BindCameraView()
+ *
+ *  This method is used for binding the camera block of a
+ *  view for the camera pass shaders and restricting the
+ *  rendering to its viewport rectangle.
+ ***********************************************************/
+void SceneManager::BindCameraView(int view)
+{
+	glBindBufferRange(GL_UNIFORM_BUFFER, CAMERA_BLOCK_BINDING, m_cameraBuffer,
+		view * m_cameraBlockStride, CAMERA_BLOCK_SIZE);
+	glViewport(m_views[view].x, m_views[view].y, m_views[view].width, m_views[view].height);
+}
+
+/***********************************************************
+ *  BuildDrawList()
+ *
+ *  This method is used for recording the draws of all the
+ *  objects in the 3D scene into the draw list, which is then
+ *  reused by every rendering pass of every frame.
+ ***********************************************************/
+void SceneManager::BuildDrawList()
+{
+	m_drawList.clear();
+
+	RenderTable();
+	m_monitorFirst = (int)m_drawList.size();
+	RenderMonitor();
+	m_monitorEnd = (int)m_drawList.size();
+	RenderKeyboard();
+	RenderMouse();
+	RenderBooks();
+	RenderPencilHolder();
+	m_pencilFirst = (int)m_drawList.size();
+	RenderPencils();
+	m_pencilEnd = (int)m_drawList.size();
+	m_drawsPerDesk = (int)m_drawList.size();
+
+	// replicate the desk when an office was requested
+	m_officeLights.clear();
+	if (m_officeDeskCount > 0)
+	{
+		GenerateOfficeDraws();
+	}
+
+	// every desk gets its own copy of the animations
+	DefineObjectAnimations(m_monitorFirst, m_monitorEnd, m_pencilFirst, m_pencilEnd, m_drawsPerDesk);
+
+	if (m_bNormalTestObjects)
+	{
+		RenderNormalTestObjects();
+	}
+
+	// the scene bounds are used for fitting the shadow maps
+	m_sceneBoundsMin = glm::vec3(0.0f);
+	m_sceneBoundsMax = glm::vec3(0.0f);
+	for (int i = 0; i < (int)m_drawList.size(); i++)
+	{
+		if (i == 0)
+		{
+			m_sceneBoundsMin = m_drawList[i].boundsMin;
+			m_sceneBoundsMax = m_drawList[i].boundsMax;
+		}
+		else
+		{
+			m_sceneBoundsMin = glm::min(m_sceneBoundsMin, m_drawList[i].boundsMin);
+			m_sceneBoundsMax = glm::max(m_sceneBoundsMax, m_drawList[i].boundsMax);
+		}
+	}
+
+	// the hierarchy is used for culling and picking
+	UpdateDrawBVH(true);
+
+	// the additional point lights follow the scene bounds and lamps
+	m_extraPointLightCount = -1;
+	m_bLightmapsStale = true;
+}
+
+/***********************************************************
+ *  GenerateOfficeDraws()
+ *
+ *  This method is used for replicating the recorded desk
+ *  into the desks of the generated office.  The transform
+ *  of each desk is applied to the recorded draws, and the
+ *  materials and textures are swapped where the generator
+ *  chose another one.
+ ***********************************************************/
+void SceneManager::GenerateOfficeDraws()
+{
+	std::vector<OBJECT_DRAW> deskDraws;
+	deskDraws.swap(m_drawList);
+
+	OfficeGenerator::OFFICE_PARAMETERS parameters;
+	parameters.deskCount = m_officeDeskCount;
+	parameters.seed = m_officeSeed;
+	parameters.deskMin = glm::vec3(0.0f);
+	parameters.deskMax = glm::vec3(0.0f);
+	for (int i = 0; i < (int)deskDraws.size(); i++)
+	{
+		parameters.deskMin = (i == 0) ? deskDraws[i].boundsMin : glm::min(parameters.deskMin, deskDraws[i].boundsMin);
+		parameters.deskMax = (i == 0) ? deskDraws[i].boundsMax : glm::max(parameters.deskMax, deskDraws[i].boundsMax);
+	}
+	parameters.drawsPerDesk = (int)deskDraws.size();
+	parameters.materialCount = m_materialTable.GetMaterialCount();
+	parameters.textureCount = m_loadedTextures;
+
+	OfficeGenerator::OFFICE_LAYOUT layout;
+	OfficeGenerator::Generate(parameters, layout);
+
+	int deskCount = (int)layout.deskTransforms.size();
+	m_drawList.reserve(deskCount * deskDraws.size());
+	for (int desk = 0; desk < deskCount; desk++)
+	{
+		const glm::mat4& deskTransform = layout.deskTransforms[desk];
+		glm::mat3 deskNormalMatrix = glm::transpose(glm::inverse(glm::mat3(deskTransform)));
+		for (int i = 0; i < (int)deskDraws.size(); i++)
+		{
+			OBJECT_DRAW draw = deskDraws[i];
+			draw.modelMatrix = deskTransform * draw.modelMatrix;
+			draw.normalMatrix = deskNormalMatrix * draw.normalMatrix;
+
+			int index = desk * (int)deskDraws.size() + i;
+			if (layout.materialIndices[index] >= 0)
+			{
+				draw.materialIndex = layout.materialIndices[index];
+				draw.materialTag = m_materialTable.GetMaterial(draw.materialIndex).tag;
+			}
+			if (draw.bUseTexture && (layout.textureIndices[index] >= 0))
+			{
+				draw.textureTag = m_textureIDs[layout.textureIndices[index]].tag;
+			}
+			UpdateDrawBounds(draw);
+			m_drawList.push_back(draw);
+		}
+	}
+	m_officeLights = layout.lights;
+
+	std::cout << "INFO: Office of " << deskCount << " desks generated from seed "
+		<< m_officeSeed << ", " << m_drawList.size() << " draws" << std::endl;
+}
+
+/***********************************************************
+ *  DefineObjectAnimations()
+ *
+ *  This method is used for adding the animation tracks of
+ *  every desk.  The monitor swivels on its base and each
+ *  pencil rocks in the holder at its own pace.  The tracks
+ *  start from the recorded transforms, so the animations
+ *  follow the desks of a generated office.
+ ***********************************************************/
+void SceneManager::DefineObjectAnimations(int monitorFirst, int monitorEnd, int pencilFirst, int pencilEnd, int drawsPerDesk)
+{
+	m_animationSystem.Clear();
+
+	std::vector<AnimationSystem::ANIMATION_KEY> monitorKeys;
+	monitorKeys.push_back(AnimationSystem::MakeKey(0.0f, glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 0.0f)));
+	monitorKeys.push_back(AnimationSystem::MakeKey(2.0f, glm::vec3(0.0f), glm::vec3(0.0f, 25.0f, 0.0f)));
+	monitorKeys.push_back(AnimationSystem::MakeKey(4.0f, glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 0.0f)));
+	monitorKeys.push_back(AnimationSystem::MakeKey(6.0f, glm::vec3(0.0f), glm::vec3(0.0f, -25.0f, 0.0f)));
+	monitorKeys.push_back(AnimationSystem::MakeKey(8.0f, glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 0.0f)));
+
+	// the pencil keys are rewritten for every pencil in place
+	std::vector<AnimationSystem::ANIMATION_KEY> pencilKeys(5);
+
+	int deskCount = (drawsPerDesk > 0) ? (int)m_drawList.size() / drawsPerDesk : 0;
+	for (int desk = 0; desk < deskCount; desk++)
+	{
+		int deskFirst = desk * drawsPerDesk;
+
+		// the whole monitor turns about the center of its base,
+		// when the desks have one
+		if (monitorFirst < monitorEnd)
+		{
+			const OBJECT_DRAW& monitorBase = m_drawList[deskFirst + monitorFirst];
+			glm::vec3 monitorPivot = (monitorBase.boundsMin + monitorBase.boundsMax) * 0.5f;
+			for (int i = deskFirst + monitorFirst; i < deskFirst + monitorEnd; i++)
+			{
+				m_animationSystem.AddTrack(i, m_drawList[i].modelMatrix, m_drawList[i].normalMatrix,
+					monitorPivot, monitorKeys);
+			}
+		}
+
+		// each pencil rocks about the bottom of its bounds
+		for (int i = deskFirst + pencilFirst; i < deskFirst + pencilEnd; i++)
+		{
+			const OBJECT_DRAW& pencil = m_drawList[i];
+			glm::vec3 pencilPivot = glm::vec3(
+				(pencil.boundsMin.x + pencil.boundsMax.x) * 0.5f,
+				pencil.boundsMin.y,
+				(pencil.boundsMin.z + pencil.boundsMax.z) * 0.5f);
+			int pencilIndex = i - deskFirst - pencilFirst;
+			float period = 2.0f + 0.4f * pencilIndex;
+			float angle = 4.0f + pencilIndex;
+
+			pencilKeys[0] = AnimationSystem::MakeKey(0.0f, glm::vec3(0.0f), glm::vec3(0.0f));
+			pencilKeys[1] = AnimationSystem::MakeKey(period * 0.25f, glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, angle));
+			pencilKeys[2] = AnimationSystem::MakeKey(period * 0.5f, glm::vec3(0.0f), glm::vec3(0.0f));
+			pencilKeys[3] = AnimationSystem::MakeKey(period * 0.75f, glm::vec3(0.0f), glm::vec3(angle * 0.5f, 0.0f, -angle));
+			pencilKeys[4] = AnimationSystem::MakeKey(period, glm::vec3(0.0f), glm::vec3(0.0f));
+			m_animationSystem.AddTrack(i, pencil.modelMatrix, pencil.normalMatrix, pencilPivot, pencilKeys);
+		}
+	}
+}
+
+/***********************************************************
+ *  UpdateAnimations()
+ *
+ *  This method is used for evaluating all the animation
+ *  tracks in one pass and copying the cached transforms
+ *  into their draws.  The hierarchy is refit for the moved
+ *  draws before they are culled.
+ ***********************************************************/
+void SceneManager::UpdateAnimations()
+{
+	m_animationSystem.Evaluate(m_animationTime);
+
+	for (int track = 0; track < m_animationSystem.GetTrackCount(); track++)
+	{
+		OBJECT_DRAW& draw = m_drawList[m_animationSystem.GetTarget(track)];
+		draw.modelMatrix = m_animationSystem.GetModelMatrix(track);
+		draw.normalMatrix = m_animationSystem.GetNormalMatrix(track);
+		UpdateDrawBounds(draw);
+		draw.movedFrame = m_frameIndex;
+	}
+	if (m_animationSystem.GetTrackCount() > 0)
+	{
+		m_bDrawBoundsChanged = true;
+	}
+}
+
+/***********************************************************
+ *  UpdateParticles()
+ *
+ *  This method is used for advancing the particles by the
+ *  time since the last frame.  The particles are created
+ *  when they are first enabled and restarted whenever
+ *  their count changes.  The step is measured as its own
+ *  pass, apart from drawing them.
+ ***********************************************************/
+void SceneManager::UpdateParticles()
+{
+	int particleCount = (NULL != m_pRenderSettings) ?
+		glm::clamp(m_pRenderSettings->particleCount, 0, (int)ParticleSystem::MAX_PARTICLES) : 0;
+	if ((particleCount == 0) && (NULL == m_pParticleSystem))
+	{
+		return;
+	}
+
+	if (NULL == m_pParticleSystem)
+	{
+		m_pParticleSystem = new ParticleSystem();
+		m_pParticleSystem->Initialize();
+		BindCameraBlock(m_pParticleSystem->GetRenderShader());
+	}
+	if (particleCount != m_pParticleSystem->GetParticleCount())
+	{
+		m_pParticleSystem->SetParticleCount(particleCount);
+		m_particleTime = m_animationTime;
+	}
+	if (NULL != m_pRenderTimer)
+	{
+		m_pRenderTimer->SetCounter("particle count", (double)particleCount);
+	}
+
+	float deltaTime = glm::clamp(m_animationTime - m_particleTime, 0.0f, MAX_PARTICLE_STEP);
+	m_particleTime = m_animationTime;
+	if ((particleCount == 0) || (deltaTime <= 0.0f))
+	{
+		return;
+	}
+
+	if (NULL != m_pRenderTimer) m_pRenderTimer->BeginPass("particle simulate");
+	m_pParticleSystem->Simulate(deltaTime, m_pRenderSettings->particleSimulation);
+	if (NULL != m_pRenderTimer) m_pRenderTimer->EndPass();
+}
+
+/***********************************************************
+ *  GenerateOffice()
+ *
+ *  This method is used for rebuilding the draw list as an
+ *  office of the passed in number of desks.  The same seed
+ *  always builds the same office.
+ ***********************************************************/
+void SceneManager::GenerateOffice(int deskCount, unsigned int seed)
+{
+	m_officeDeskCount = glm::clamp(deskCount, 0, (int)OfficeGenerator::MAX_DESKS);
+	m_officeSeed = seed;
+	BuildDrawList();
+}
+
+/***********************************************************
+ *  SetNormalTestObjects()
+ *
+ *  This method is used for rebuilding the draw list with or
+ *  without the objects checking the lighting of rotated and
+ *  non-uniformly scaled draws.
+ ***********************************************************/
+void SceneManager::SetNormalTestObjects(bool bShow)
+{
+	if (bShow != m_bNormalTestObjects)
+	{
+		m_bNormalTestObjects = bShow;
+		BuildDrawList();
+	}
+}
+
+/***********************************************************
+ *  GetNormalTestCenter()
+ *
+ *  This method is used for getting the point the normal test
+ *  objects are placed around, for aiming a camera at them.
+ ***********************************************************/
+glm::vec3 SceneManager::GetNormalTestCenter()
+{
+	return(glm::vec3(-6.0f, 0.4f, 3.6f));
+}
+
+/***********************************************************
+ *  ComputeSnapshotSignature()
+ *
+ *  This method is used for hashing the options a snapshot
+ *  of the scene depends on - the version of the code that
+ *  builds it, the office, the vertex format, size and time
+ *  of change of the imported mesh files, and the tags of
+ *  the materials and textures the draw packets index.
+ ***********************************************************/
+unsigned int SceneManager::ComputeSnapshotSignature(int deskCount, unsigned int seed) const
+{
+	int vertexFormat = ((NULL != m_pRenderSettings) && m_pRenderSettings->bPackedVertices) ?
+		MeshImporter::VERTEX_FORMAT_PACKED : MeshImporter::VERTEX_FORMAT_FLOAT;
+
+	unsigned int hash = SceneSnapshot::HashBytes(0, &SCENE_BUILD_VERSION, sizeof(SCENE_BUILD_VERSION));
+	hash = SceneSnapshot::HashBytes(hash, &deskCount, sizeof(deskCount));
+	hash = SceneSnapshot::HashBytes(hash, &seed, sizeof(seed));
+	hash = SceneSnapshot::HashBytes(hash, &vertexFormat, sizeof(vertexFormat));
+
+	// the meshes loaded by PrepareScene, from the first file found
+	// the same way as LoadImportedMesh - a missing one hashes as -1
+	const char* meshNames[] = { "mouse", "keyboard" };
+	for (int i = 0; i < (int)(sizeof(meshNames) / sizeof(meshNames[0])); i++)
+	{
+		long long fileBytes = -1;
+		long long modifiedTime = 0;
+		struct stat fileStatus;
+		for (int j = 0; (j < MESH_EXTENSION_COUNT) && (fileBytes < 0); j++)
+		{
+			std::string filename = std::string("../meshes/") + meshNames[i] + g_MeshExtensions[j];
+			if (stat(filename.c_str(), &fileStatus) == 0)
+			{
+				fileBytes = (long long)fileStatus.st_size;
+				modifiedTime = (long long)fileStatus.st_mtime;
+			}
+		}
+		hash = SceneSnapshot::HashBytes(hash, &fileBytes, sizeof(fileBytes));
+		hash = SceneSnapshot::HashBytes(hash, &modifiedTime, sizeof(modifiedTime));
+	}
+	for (int i = 0; i < m_materialTable.GetMaterialCount(); i++)
+	{
+		const std::string& tag = m_materialTable.GetMaterial(i).tag;
+		hash = SceneSnapshot::HashBytes(hash, tag.c_str(), tag.size() + 1);
+	}
+	for (int i = 0; i < m_loadedTextures; i++)
+	{
+		hash = SceneSnapshot::HashBytes(hash, m_textureIDs[i].tag.c_str(), m_textureIDs[i].tag.size() + 1);
+	}
+	return(hash);
+}
+
+/***********************************************************
+ *  SaveSnapshot()
+ *
+ *  This method is used for writing the prepared scene into
+ *  a snapshot file.  The draws are stored with their tags
+ *  replaced by table indices, and the animated ones at the
+ *  transforms their tracks start from.  The imported mesh
+ *  buffers are read back from the GPU as they were packed.
+ ***********************************************************/
+bool SceneManager::SaveSnapshot(const std::string& filename)
+{
+	if (m_bDrawBoundsChanged)
+	{
+		UpdateDrawBVH(false);
+	}
+
+	SceneSnapshot::SNAPSHOT_SCENE scene;
+	memset((void*)&scene, 0, sizeof(scene));
+	scene.signature = ComputeSnapshotSignature(m_officeDeskCount, m_officeSeed);
+	scene.officeDeskCount = m_officeDeskCount;
+	scene.officeSeed = m_officeSeed;
+	scene.drawsPerDesk = m_drawsPerDesk;
+	scene.monitorFirst = m_monitorFirst;
+	scene.monitorEnd = m_monitorEnd;
+	scene.pencilFirst = m_pencilFirst;
+	scene.pencilEnd = m_pencilEnd;
+	scene.mouseMesh = m_mouseMesh;
+	scene.keyboardMesh = m_keyboardMesh;
+	scene.sceneBoundsMin = m_sceneBoundsMin;
+	scene.sceneBoundsMax = m_sceneBoundsMax;
+
+	// undo the animations, so the tracks defined when loading
+	// start from the same transforms
+	std::vector<OBJECT_DRAW> baseDraws;
+	for (int track = 0; track < m_animationSystem.GetTrackCount(); track++)
+	{
+		OBJECT_DRAW draw = m_drawList[m_animationSystem.GetTarget(track)];
+		draw.modelMatrix = m_animationSystem.GetBaseModelMatrix(track);
+		draw.normalMatrix = m_animationSystem.GetBaseNormalMatrix(track);
+		UpdateDrawBounds(draw);
+		baseDraws.push_back(draw);
+	}
+
+	std::vector<SceneSnapshot::SNAPSHOT_DRAW> draws(m_drawList.size());
+	int totalDraws = (int)(m_drawList.size() + baseDraws.size());
+	for (int i = 0; i < totalDraws; i++)
+	{
+		int index = (i < (int)m_drawList.size()) ? i : m_animationSystem.GetTarget(i - (int)m_drawList.size());
+		const OBJECT_DRAW& draw = (i < (int)m_drawList.size()) ? m_drawList[i] : baseDraws[i - m_drawList.size()];
+		SceneSnapshot::SNAPSHOT_DRAW& packet = draws[index];
+		packet.modelMatrix = draw.modelMatrix;
+		packet.normalMatrix = draw.normalMatrix;
+		packet.color = draw.color;
+		packet.UVscale = draw.UVscale;
+		packet.boundsMin = draw.boundsMin;
+		packet.boundsMax = draw.boundsMax;
+		packet.mesh = draw.mesh;
+		packet.importedMesh = draw.importedMesh;
+		packet.materialIndex = draw.materialIndex;
+		packet.textureSlot = draw.textureTag.empty() ? -1 : FindTextureSlot(draw.textureTag);
+		packet.bUseTexture = draw.bUseTexture ? 1 : 0;
+	}
+
+	std::vector<SceneSnapshot::SNAPSHOT_MATERIAL> materials(m_materialTable.GetMaterialCount());
+	for (int i = 0; i < (int)materials.size(); i++)
+	{
+		const OBJECT_MATERIAL& material = m_materialTable.GetMaterial(i);
+		materials[i].diffuseColor = material.diffuseColor;
+		materials[i].specularColor = material.specularColor;
+		materials[i].shininess = material.shininess;
+		materials[i].roughness = material.roughness;
+		materials[i].emissiveColor = material.emissiveColor;
+		materials[i].alphaMode = material.alphaMode;
+	}
+
+	// the copy read target leaves the element buffers of the
+	// vertex arrays untouched
+	std::vector<SceneSnapshot::SNAPSHOT_MESH> meshes(m_importedMeshes.size());
+	std::vector<unsigned char> meshData;
+	for (int i = 0; i < (int)m_importedMeshes.size(); i++)
+	{
+		const IMPORTED_MESH_BUFFERS& buffers = m_importedMeshes[i];
+		GLint vertexBytes = 0;
+		glBindBuffer(GL_COPY_READ_BUFFER, buffers.vertexBuffer);
+		glGetBufferParameteriv(GL_COPY_READ_BUFFER, GL_BUFFER_SIZE, &vertexBytes);
+		meshes[i].vertexOffset = meshData.size();
+		meshes[i].vertexBytes = vertexBytes;
+		meshData.resize(meshData.size() + vertexBytes);
+		glGetBufferSubData(GL_COPY_READ_BUFFER, 0, vertexBytes, &meshData[meshes[i].vertexOffset]);
+
+		size_t indexBytes = buffers.indexCount * sizeof(unsigned int);
+		meshes[i].indexOffset = (meshData.size() + 3) / 4 * 4;
+		meshes[i].indexCount = buffers.indexCount;
+		meshData.resize(meshes[i].indexOffset + indexBytes);
+		glBindBuffer(GL_COPY_READ_BUFFER, buffers.indexBuffer);
+		glGetBufferSubData(GL_COPY_READ_BUFFER, 0, indexBytes, &meshData[meshes[i].indexOffset]);
+
+		meshes[i].format = buffers.format;
+		meshes[i].boundsMin = buffers.boundsMin;
+		meshes[i].boundsMax = buffers.boundsMax;
+		meshes[i].positionScale = buffers.positionScale;
+		meshes[i].positionOffset = buffers.positionOffset;
+	}
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+	SceneSnapshot::SECTION_DATA sections[SceneSnapshot::SECTION_COUNT];
+	sections[SceneSnapshot::SECTION_DRAWS] = { draws.data(), draws.size(), sizeof(SceneSnapshot::SNAPSHOT_DRAW) };
+	sections[SceneSnapshot::SECTION_MATERIALS] = { materials.data(), materials.size(), sizeof(SceneSnapshot::SNAPSHOT_MATERIAL) };
+	sections[SceneSnapshot::SECTION_LIGHTS] = { m_officeLights.data(), m_officeLights.size(), sizeof(OfficeGenerator::OFFICE_LIGHT) };
+	sections[SceneSnapshot::SECTION_MESHES] = { meshes.data(), meshes.size(), sizeof(SceneSnapshot::SNAPSHOT_MESH) };
+	sections[SceneSnapshot::SECTION_MESH_DATA] = { meshData.data(), meshData.size(), 1 };
+	sections[SceneSnapshot::SECTION_BVH_NODES] = { m_drawBVH.GetNodes().data(), m_drawBVH.GetNodes().size(),
+		sizeof(BoundingVolumeHierarchy::BVH_NODE) };
+	sections[SceneSnapshot::SECTION_BVH_OBJECTS] = { m_drawBVH.GetObjectIndices().data(), m_drawBVH.GetObjectIndices().size(),
+		sizeof(int) };
+	sections[SceneSnapshot::SECTION_BVH_BOUNDS] = { m_drawBVH.GetLeafBounds().data(), m_drawBVH.GetLeafBounds().size(),
+		sizeof(BoundingVolumeHierarchy::BVH_BOUNDS) };
+
+	if (!SceneSnapshot::Write(filename, scene, sections))
+	{
+		return(false);
+	}
+
+	size_t totalBytes = 0;
+	for (int i = 0; i < SceneSnapshot::SECTION_COUNT; i++)
+	{
+		totalBytes += sections[i].count * sections[i].elementSize;
+	}
+	std::cout << "INFO: Saved scene snapshot to " << filename << ", " << draws.size() << " draws, "
+		<< totalBytes / 1024 << " KB" << std::endl;
+	return(true);
+}
+
+/***********************************************************
+ *  LoadSnapshot()
+ *
+ *  This method is used for replacing the scene with one
+ *  mapped from a snapshot file.  Everything is checked
+ *  against the tables and the mapped size before any of
+ *  the scene changes, so a damaged file leaves the scene as
+ *  it was.  The draw packets are then copied into the draw
+ *  list in one pass, the mesh buffers are uploaded straight
+ *  from the mapping and the hierarchy is taken as stored.
+ *  Only the animation tracks are defined again.
+ ***********************************************************/
+bool SceneManager::LoadSnapshot(const std::string& filename, int deskCount, unsigned int seed)
+{
+	SceneSnapshot snapshot;
+	if (!snapshot.Map(filename))
+	{
+		return(false);
+	}
+	const SceneSnapshot::SNAPSHOT_SCENE& scene = snapshot.GetScene();
+
+	size_t drawCount = 0;
+	size_t materialCount = 0;
+	size_t lightCount = 0;
+	size_t meshCount = 0;
+	size_t meshDataBytes = 0;
+	size_t nodeCount = 0;
+	size_t objectCount = 0;
+	size_t leafCount = 0;
+	const SceneSnapshot::SNAPSHOT_DRAW* pDraws =
+		snapshot.GetSection<SceneSnapshot::SNAPSHOT_DRAW>(SceneSnapshot::SECTION_DRAWS, drawCount);
+	const SceneSnapshot::SNAPSHOT_MATERIAL* pMaterials =
+		snapshot.GetSection<SceneSnapshot::SNAPSHOT_MATERIAL>(SceneSnapshot::SECTION_MATERIALS, materialCount);
+	const OfficeGenerator::OFFICE_LIGHT* pLights =
+		snapshot.GetSection<OfficeGenerator::OFFICE_LIGHT>(SceneSnapshot::SECTION_LIGHTS, lightCount);
+	const SceneSnapshot::SNAPSHOT_MESH* pMeshes =
+		snapshot.GetSection<SceneSnapshot::SNAPSHOT_MESH>(SceneSnapshot::SECTION_MESHES, meshCount);
+	const unsigned char* pMeshData =
+		snapshot.GetSection<unsigned char>(SceneSnapshot::SECTION_MESH_DATA, meshDataBytes);
+	const BoundingVolumeHierarchy::BVH_NODE* pNodes =
+		snapshot.GetSection<BoundingVolumeHierarchy::BVH_NODE>(SceneSnapshot::SECTION_BVH_NODES, nodeCount);
+	const int* pObjectIndices =
+		snapshot.GetSection<int>(SceneSnapshot::SECTION_BVH_OBJECTS, objectCount);
+	const BoundingVolumeHierarchy::BVH_BOUNDS* pLeafBounds =
+		snapshot.GetSection<BoundingVolumeHierarchy::BVH_BOUNDS>(SceneSnapshot::SECTION_BVH_BOUNDS, leafCount);
+
+	bool bValid = (scene.signature == ComputeSnapshotSignature(deskCount, seed)) &&
+		(NULL != pDraws) && (NULL != pMaterials) && (NULL != pLights) && (NULL != pMeshes) && (NULL != pMeshData) &&
+		(NULL != pNodes) && (NULL != pObjectIndices) && (NULL != pLeafBounds) &&
+		(materialCount == (size_t)m_materialTable.GetMaterialCount()) && (objectCount == drawCount) && (leafCount == drawCount) &&
+		(scene.drawsPerDesk >= 0) && (scene.drawsPerDesk <= (int)drawCount) &&
+		(scene.monitorFirst >= 0) && (scene.monitorFirst <= scene.monitorEnd) && (scene.monitorEnd <= scene.drawsPerDesk) &&
+		(scene.pencilFirst >= 0) && (scene.pencilFirst <= scene.pencilEnd) && (scene.pencilEnd <= scene.drawsPerDesk) &&
+		(scene.mouseMesh >= -1) && (scene.mouseMesh < (int)meshCount) &&
+		(scene.keyboardMesh >= -1) && (scene.keyboardMesh < (int)meshCount);
+	for (int i = 0; bValid && (i < (int)meshCount); i++)
+	{
+		const SceneSnapshot::SNAPSHOT_MESH& mesh = pMeshes[i];
+		bValid = ((mesh.format == MeshImporter::VERTEX_FORMAT_FLOAT) || (mesh.format == MeshImporter::VERTEX_FORMAT_PACKED)) &&
+			(mesh.indexCount >= 0) && (mesh.indexOffset % sizeof(unsigned int) == 0) &&
+			(mesh.vertexOffset <= meshDataBytes) && (mesh.vertexBytes <= meshDataBytes - mesh.vertexOffset) &&
+			(mesh.indexOffset <= meshDataBytes) && ((size_t)mesh.indexCount <= (meshDataBytes - mesh.indexOffset) / sizeof(unsigned int));
+	}
+
+	// the packets become draws in place, their tags taken from
+	// the tables they index
+	std::vector<OBJECT_DRAW> draws(bValid ? drawCount : 0);
+	for (int i = 0; bValid && (i < (int)draws.size()); i++)
+	{
+		const SceneSnapshot::SNAPSHOT_DRAW& packet = pDraws[i];
+		bValid = (packet.mesh >= MESH_PLANE) && (packet.mesh <= MESH_SPHERE) &&
+			(packet.importedMesh >= -1) && (packet.importedMesh < (int)meshCount) &&
+			(packet.materialIndex >= -1) && (packet.materialIndex < (int)materialCount) &&
+			(packet.textureSlot >= -1) && (packet.textureSlot < m_loadedTextures);
+		if (!bValid)
+		{
+			break;
+		}
+
+		OBJECT_DRAW& draw = draws[i];
+		draw.mesh = (MESH_SHAPE)packet.mesh;
+		draw.importedMesh = packet.importedMesh;
+		draw.modelMatrix = packet.modelMatrix;
+		draw.normalMatrix = packet.normalMatrix;
+		draw.materialIndex = packet.materialIndex;
+		if (packet.materialIndex >= 0)
+		{
+			draw.materialTag = m_materialTable.GetMaterial(packet.materialIndex).tag;
+		}
+		if (packet.textureSlot >= 0)
+		{
+			draw.textureTag = m_textureIDs[packet.textureSlot].tag;
+		}
+		draw.bUseTexture = (packet.bUseTexture != 0);
+		draw.color = packet.color;
+		draw.UVscale = packet.UVscale;
+		draw.boundsMin = packet.boundsMin;
+		draw.boundsMax = packet.boundsMax;
+		draw.movedFrame = -OCCLUSION_LATENCY_FRAMES - 1;
+	}
+
+	// the hierarchy is replaced last, once nothing else can fail
+	if (!bValid || !m_drawBVH.Assign(pNodes, (int)nodeCount, pObjectIndices, pLeafBounds, (int)objectCount))
+	{
+		std::cout << "INFO: Scene snapshot " << filename << " does not match the scene, rebuilding it" << std::endl;
+		return(false);
+	}
+	m_bDrawBoundsChanged = false;
+
+	DestroyImportedMeshes();
+	m_importedMeshes.resize(meshCount);
+	for (int i = 0; i < (int)meshCount; i++)
+	{
+		const SceneSnapshot::SNAPSHOT_MESH& mesh = pMeshes[i];
+		IMPORTED_MESH_BUFFERS& buffers = m_importedMeshes[i];
+		buffers.indexCount = mesh.indexCount;
+		buffers.boundsMin = mesh.boundsMin;
+		buffers.boundsMax = mesh.boundsMax;
+		buffers.format = (MeshImporter::VERTEX_FORMAT)mesh.format;
+		buffers.positionScale = mesh.positionScale;
+		buffers.positionOffset = mesh.positionOffset;
+		UploadImportedMesh(buffers, pMeshData + mesh.vertexOffset, (size_t)mesh.vertexBytes,
+			(const unsigned int*)(pMeshData + mesh.indexOffset));
+	}
+	m_mouseMesh = scene.mouseMesh;
+	m_keyboardMesh = scene.keyboardMesh;
+
+	for (int i = 0; i < (int)materialCount; i++)
+	{
+		OBJECT_MATERIAL material = m_materialTable.GetMaterial(i);
+		material.diffuseColor = pMaterials[i].diffuseColor;
+		material.specularColor = pMaterials[i].specularColor;
+		material.shininess = pMaterials[i].shininess;
+		material.roughness = pMaterials[i].roughness;
+		material.emissiveColor = pMaterials[i].emissiveColor;
+		material.alphaMode = (MaterialTable::ALPHA_MODE)pMaterials[i].alphaMode;
+		m_materialTable.UpdateMaterial(i, material);
+	}
+	m_officeLights.assign(pLights, pLights + lightCount);
+
+	m_drawList.swap(draws);
+	m_officeDeskCount = deskCount;
+	m_officeSeed = seed;
+	m_drawsPerDesk = scene.drawsPerDesk;
+	m_monitorFirst = scene.monitorFirst;
+	m_monitorEnd = scene.monitorEnd;
+	m_pencilFirst = scene.pencilFirst;
+	m_pencilEnd = scene.pencilEnd;
+	m_sceneBoundsMin = scene.sceneBoundsMin;
+	m_sceneBoundsMax = scene.sceneBoundsMax;
+	DefineObjectAnimations(m_monitorFirst, m_monitorEnd, m_pencilFirst, m_pencilEnd, m_drawsPerDesk);
+
+	// the additional point lights follow the scene bounds and lamps
+	m_extraPointLightCount = -1;
+	m_bLightmapsStale = true;
+
+	std::cout << "INFO: Mapped scene snapshot " << filename << " - " << m_drawList.size() << " draws, "
+		<< m_importedMeshes.size() << " imported meshes, " << snapshot.GetMappedBytes() / 1024 << " KB" << std::endl;
+	return(true);
+}
+
+/***********************************************************
+ *  RenderShadowMaps()
+ *
+ *  This method is used for rendering the depth-only passes
+ *  from the shadow casting lights.  Every cascade of the
+ *  directional light and the spot light layer draw the
+ *  recorded draws the hierarchy finds in their light space
+ *  frustum.
+ ***********************************************************/
+void SceneManager::RenderShadowMaps()
+{
+	if ((NULL == m_pShadowManager) || (m_pShadowManager->IsEnabled() == false))
+	{
+		return;
+	}
+
+	// the spot light range reaches the furthest corner of the scene
+	float spotLightRange = 0.0f;
+	for (int i = 0; i < 8; i++)
+	{
+		glm::vec3 corner = glm::vec3(
+			(i & 1) ? m_sceneBoundsMax.x : m_sceneBoundsMin.x,
+			(i & 2) ? m_sceneBoundsMax.y : m_sceneBoundsMin.y,
+			(i & 4) ? m_sceneBoundsMax.z : m_sceneBoundsMin.z);
+		spotLightRange = glm::max(spotLightRange, glm::length(corner - m_spotLightPosition));
+	}
+
+	// the cascades are fitted to the first view and shared by all
+	m_pShadowManager->UpdateDirectionalCascades(
+		m_views[0].view, m_views[0].projection,
+		m_directionalLightDirection,
+		m_sceneBoundsMin, m_sceneBoundsMax);
+	m_pShadowManager->UpdateSpotLight(
+		m_spotLightPosition, m_spotLightDirection,
+		m_spotLightOuterCutOff, spotLightRange);
+
+	// each layer only draws the casters inside its light frustum,
+	// whose depth range already reaches every caster of the scene
+	bool bFrustumCulling = (NULL == m_pRenderSettings) || m_pRenderSettings->bFrustumCulling;
+	std::vector<int> casters;
+	int casterSum = 0;
+	m_pShadowManager->BeginDepthPass();
+	for (int layer = 0; layer < m_pShadowManager->GetLayerCount(); layer++)
+	{
+		m_pShadowManager->BeginLayer(layer);
+		if (bFrustumCulling)
+		{
+			m_drawBVH.QueryFrustum(m_pShadowManager->GetLayerMatrix(layer), casters);
+		}
+		else
+		{
+			casters.resize(m_drawList.size());
+			for (int i = 0; i < (int)casters.size(); i++)
+			{
+				casters[i] = i;
+			}
+		}
+		for (int i = 0; i < (int)casters.size(); i++)
+		{
+			const OBJECT_DRAW& draw = m_drawList[casters[i]];
+			m_pDepthShaderManager->setMat4Value(g_ModelName, draw.modelMatrix);
+			DrawObjectMesh(draw, m_pDepthShaderManager);
+		}
+		casterSum += (int)casters.size();
+	}
+	m_pShadowManager->EndDepthPass();
+	if (NULL != m_pRenderTimer) m_pRenderTimer->SetCounter("shadow caster draws", (double)casterSum);
+}
+
+/***********************************************************
+ *  SortDrawList()
+ *
+ *  This method is used for collecting the recorded draws in
+ *  the frustum of a view and ordering them by their view
+ *  depth from its camera, nearest first, so that the early
+ *  depth test rejects the hidden fragments of the objects
+ *  drawn later.  The draw list itself keeps its recorded
+ *  order.  The Hi-Z depth only covers a single view, so
+ *  occlusion culling is skipped when there are more.
+ ***********************************************************/
+void SceneManager::SortDrawList(const SCENE_VIEW& view, std::vector<int>& drawOrder)
+{
+	if ((NULL != m_pRenderSettings) && (m_pRenderSettings->bFrustumCulling == false))
+	{
+		drawOrder.resize(m_drawList.size());
+		for (int i = 0; i < (int)drawOrder.size(); i++)
+		{
+			drawOrder[i] = i;
+		}
+	}
+	else
+	{
+		m_drawBVH.QueryFrustum(view.projection * view.view, drawOrder);
+		// keep the recorded order for draws at equal depth
+		std::sort(drawOrder.begin(), drawOrder.end());
+	}
+
+	if ((NULL != m_pRenderSettings) && m_pRenderSettings->bOcclusionCulling && (m_views.size() == 1))
+	{
+		CullOccludedDraws(drawOrder);
+	}
+
+	if ((NULL != m_pRenderSettings) && (m_pRenderSettings->bSortFrontToBack == false))
+	{
+		return;
+	}
+
+	// view depth of the center of each draw's bounds
+	std::vector<float> viewDepths(m_drawList.size());
+	for (int i = 0; i < (int)drawOrder.size(); i++)
+	{
+		const OBJECT_DRAW& draw = m_drawList[drawOrder[i]];
+		glm::vec3 center = (draw.boundsMin + draw.boundsMax) * 0.5f;
+		viewDepths[drawOrder[i]] = -(view.view * glm::vec4(center, 1.0f)).z;
+	}
+
+	std::stable_sort(drawOrder.begin(), drawOrder.end(),
+		[&viewDepths](int a, int b) { return viewDepths[a] < viewDepths[b]; });
+}
+
+/***********************************************************
+ *  RenderDepthPrepass()
+ *
+ *  This method is used for rendering the depth of all the
+ *  draws of every view with the trivial prepass shader, so
+ *  the lit pass only shades the visible fragments.
+ ***********************************************************/
+void SceneManager::RenderDepthPrepass()
+{
+	if (NULL == m_pPrepassShaderManager)
+	{
+		return;
+	}
+
+	m_pPrepassShaderManager->use();
+
+	// depth only - no color is written in this pass
+	glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+	for (int view = 0; view < (int)m_views.size(); view++)
+	{
+		BindCameraView(view);
+		const std::vector<int>& drawOrder = m_viewDrawOrders[view];
+		for (int i = 0; i < (int)drawOrder.size(); i++)
+		{
+			const OBJECT_DRAW& draw = m_drawList[drawOrder[i]];
+			m_pPrepassShaderManager->setMat4Value(g_ModelName, draw.modelMatrix);
+			DrawObjectMesh(draw, m_pPrepassShaderManager);
+		}
+	}
+	glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+}
+
+/***********************************************************
+ *  RenderScene()
+ *
+ *  This method is used for rendering all objects in the 3D scene.
+ *  The shadow maps are rendered first with the depth-only
+ *  shader, then the recorded draws of the table, monitor,
+ *  keyboard, mouse, books, pencil holder, and pencils are
+ *  rendered with either the forward lighting shader or the
+ *  deferred G-buffer path.  Each pass is reported separately
+ *  in the frame timings.  With several views the draws are
+ *  culled, sorted and drawn for each view into its viewport,
+ *  while the shadow maps, lights and textures are prepared
+ *  once; the deferred path only renders a single view.
+ ***********************************************************/
+void SceneManager::RenderScene() {
+	if (m_views.empty())
+	{
+		return;
+	}
+
+	// apply a shadow quality tier selected from the keyboard
+	if ((NULL != m_pRenderSettings) && (NULL != m_pShadowManager) &&
+		(m_pRenderSettings->shadowQuality != m_pShadowManager->GetQuality()))
+	{
+		m_pShadowManager->SetQuality(m_pRenderSettings->shadowQuality);
+		m_pRenderSettings->shadowQuality = m_pShadowManager->GetQuality();
+	}
+
+	SelectNormalShader();
+
+	bool bDepthPrepass = (NULL != m_pRenderSettings) && m_pRenderSettings->bDepthPrepass;
+	bool bShowOverdraw = (NULL != m_pRenderSettings) && m_pRenderSettings->bShowOverdraw;
+
+	// the previous frame's fragment and triangle counts are ready by now
+	if (m_bFragmentQueryIssued)
+	{
+		glGetQueryObjectui64v(m_fragmentQuery, GL_QUERY_RESULT, &m_shadedFragments);
+		glGetQueryObjectui64v(m_triangleQuery, GL_QUERY_RESULT, &m_litTriangles);
+		m_bFragmentQueryIssued = false;
+	}
+
+	// regenerate the additional point lights when their count changes
+	int pointLightCount = (NULL != m_pRenderSettings) ? m_pRenderSettings->pointLightCount : 0;
+	int extraPointLightCount = glm::max(pointLightCount - (int)m_scenePointLights.size(), 0);
+	if (extraPointLightCount != m_extraPointLightCount)
+	{
+		GenerateExtraPointLights(extraPointLightCount);
+	}
+
+	if ((NULL != m_pRenderSettings) && m_pRenderSettings->bAnimate)
+	{
+		UpdateAnimations();
+	}
+	UpdateParticles();
+
+	// upload the materials changed since the last frame
+	m_materialTable.Upload();
+	m_materialUniformCalls = 0;
+	m_materialDraws = 0;
+	m_drawLightSum = 0;
+	m_litDraws = 0;
+
+	// refit the hierarchy once for all the draws moved since the last frame
+	if (m_bDrawBoundsChanged)
+	{
+		UpdateDrawBVH(false);
+	}
+
+	if (NULL != m_pRenderTimer) m_pRenderTimer->BeginPass("shadow depth");
+	RenderShadowMaps();
+	if (NULL != m_pRenderTimer) m_pRenderTimer->EndPass();
+
+	// the views render into rectangles of the bound framebuffer,
+	// which is restored to its whole viewport afterwards
+	GLint savedViewport[4];
+	glGetIntegerv(GL_VIEWPORT, savedViewport);
+	UploadCameraViews();
+
+	bool bMultiView = (m_views.size() > 1);
+	m_viewDrawOrders.resize(m_views.size());
+	m_occludedDrawCount = 0;
+	for (int view = 0; view < (int)m_views.size(); view++)
+	{
+		if (bMultiView && (NULL != m_pRenderTimer)) m_pRenderTimer->BeginPass("cull " + m_views[view].name);
+		SortDrawList(m_views[view], m_viewDrawOrders[view]);
+		if (bMultiView && (NULL != m_pRenderTimer))
+		{
+			m_pRenderTimer->EndPass();
+			m_pRenderTimer->SetCounter("draws " + m_views[view].name, (double)m_viewDrawOrders[view].size());
+		}
+	}
+	StreamTextureLevels();
+
+	// the overdraw visualization counts every draw in one pass
+	m_viewTransparentOrders.resize(m_views.size());
+	for (int view = 0; view < (int)m_views.size(); view++)
+	{
+		m_viewTransparentOrders[view].clear();
+		if (!bShowOverdraw)
+		{
+			SplitTransparentDraws(m_viewDrawOrders[view], m_viewTransparentOrders[view]);
+		}
+	}
+
+	if ((NULL != m_pRenderSettings) && m_pRenderSettings->bDeferredShading && !bMultiView)
+	{
+		RenderDeferredPass();
+	}
+	else
+	{
+		RenderForwardPass(bDepthPrepass, bShowOverdraw);
+	}
+	RenderTransparentPass(savedViewport[2], savedViewport[3]);
+	glViewport(savedViewport[0], savedViewport[1], savedViewport[2], savedViewport[3]);
+
+	// keep the depth of this frame for culling the next ones
+	if (NULL != m_pOcclusionCuller)
+	{
+		if ((NULL != m_pRenderSettings) && m_pRenderSettings->bOcclusionCulling && !bMultiView)
+		{
+			if (NULL != m_pRenderTimer) m_pRenderTimer->BeginPass("hi-z");
+			m_pOcclusionCuller->CaptureDepth(m_views[0].projection * m_views[0].view);
+			if (NULL != m_pRenderTimer) m_pRenderTimer->EndPass();
+			m_pShaderManager->use();
+		}
+		else
+		{
+			// a depth kept from before would be stale once enabled again
+			m_pOcclusionCuller->Invalidate();
+		}
+	}
+
+	if (NULL != m_pRenderTimer)
+	{
+		m_pRenderTimer->SetCounter("material uniform calls", (double)m_materialUniformCalls);
+		m_pRenderTimer->SetCounter("material uniform calls saved",
+			(double)(m_materialDraws * MATERIAL_UNIFORMS_PER_DRAW - m_materialUniformCalls));
+		m_pRenderTimer->SetCounter("material bytes uploaded", (double)m_materialTable.GetUploadedBytes());
+		m_pRenderTimer->SetCounter("lights per draw", (m_litDraws > 0) ? (double)m_drawLightSum / m_litDraws : 0.0);
+	}
+	m_frameIndex++;
+}
+
+/***********************************************************
+ *  SelectNormalShader()
+ *
+ *  This method is used for switching the lit shader to the
+ *  program of the normal transform in the render settings.
+ *  The shipping shader only uses the normal matrix, so the
+ *  alternatives measured against it are compiled from their
+ *  own vertex shaders the first time they are selected, and
+ *  set up with the same camera block and scene lights.
+ ***********************************************************/
+void SceneManager::SelectNormalShader()
+{
+	int transform = NORMAL_PRECOMPUTED;
+	if ((NULL != m_pRenderSettings) &&
+		(m_pRenderSettings->normalTransform > NORMAL_PRECOMPUTED) &&
+		(m_pRenderSettings->normalTransform < NORMAL_TRANSFORM_COUNT))
+	{
+		transform = m_pRenderSettings->normalTransform;
+	}
+
+	if (NULL == m_normalShaderManagers[transform])
+	{
+		const char* vertexShader = (transform == NORMAL_UNTRANSFORMED) ?
+			"../shaders/normalUntransformedVertexShader.glsl" :
+			"../shaders/normalPerVertexVertexShader.glsl";
+		ShaderManager* pShaderManager = new ShaderManager();
+		pShaderManager->LoadShaders(vertexShader, "../shaders/fragmentShader.glsl");
+		BindCameraBlock(pShaderManager);
+		pShaderManager->use();
+		ApplySceneLights(pShaderManager);
+		m_normalShaderManagers[transform] = pShaderManager;
+	}
+	m_pShaderManager = m_normalShaderManagers[transform];
+}
+
+/***********************************************************
+ *  RenderForwardPass()
+ *
+ *  This method is used for rendering the sorted draws with
+ *  the forward lighting shader, optionally after a depth
+ *  prepass and optionally as an overdraw visualization.
+ *  The ambient occlusion is computed between the two, so
+ *  it turns the prepass on when enabled.
+ *  The lights and shadow maps are applied once, and only
+ *  the camera block and the viewport change between views.
+ ***********************************************************/
+void SceneManager::RenderForwardPass(bool bDepthPrepass, bool bShowOverdraw)
+{
+	// the ambient occlusion is computed from the prepass depth
+	int ambientOcclusionQuality = GetAmbientOcclusionQuality();
+	if (bDepthPrepass || (ambientOcclusionQuality > 0))
+	{
+		if (NULL != m_pRenderTimer) m_pRenderTimer->BeginPass("depth prepass");
+		RenderDepthPrepass();
+		if (NULL != m_pRenderTimer) m_pRenderTimer->EndPass();
+
+		RenderAmbientOcclusion(ambientOcclusionQuality, 0, 0);
+
+		// shade only the fragments that won the prepass
+		glDepthFunc(GL_EQUAL);
+		glDepthMask(GL_FALSE);
+	}
+
+	m_pShaderManager->use();
+	m_pShaderManager->setBoolValue("bUseAmbientOcclusion", ambientOcclusionQuality > 0);
+	m_pShaderManager->setIntValue("ambientOcclusion", AmbientOcclusion::OCCLUSION_TEXTURE_UNIT);
+	if (NULL != m_pShadowManager)
+	{
+		m_pShadowManager->ApplyToShader(m_pShaderManager, SHADOW_MAP_TEXTURE_UNIT);
+	}
+	ApplyExtraPointLights(m_pShaderManager);
+	ApplyMaterialTable(m_pShaderManager);
+	m_pShaderManager->setBoolValue("bShowOverdraw", bShowOverdraw);
+
+	// the static draws can take their diffuse lighting from the
+	// lightmaps, which are baked when the draw list changes
+	bool bLightmaps = (NULL != m_pRenderSettings) && m_pRenderSettings->bLightmaps && !bShowOverdraw;
+	if (bLightmaps)
+	{
+		UpdateLightmaps(false);
+		glActiveTexture(GL_TEXTURE0 + LIGHTMAP_TEXTURE_UNIT);
+		glBindTexture(GL_TEXTURE_2D, m_lightmapTexture);
+		m_pShaderManager->setIntValue("lightmap", LIGHTMAP_TEXTURE_UNIT);
+	}
+	int lightmapShape = -1;
+	int lightmappedDraws = 0;
+	if (bShowOverdraw)
+	{
+		// every shaded fragment adds to the pixel
+		glBlendFunc(GL_ONE, GL_ONE);
+	}
+	else
+	{
+		// the opaque draws cover what is behind them
+		glDisable(GL_BLEND);
+	}
 
-		// Setup Spot Light with increased cut-off angles to cover more area
-		glm::vec3 spotLightPosition = glm::vec3(0.0f, 4.0f, 5.0f);
-		glm::vec3 spotLightDirection = glm::vec3(0.0f, -1.0f, -1.0f);
-		float spotLightCutOff = glm::cos(glm::radians(20.0f)); // Wider angle
-		float spotLightOuterCutOff = glm::cos(glm::radians(25.0f)); // Outer angle for broader coverage
-		glm::vec3 spotLightAmbient = glm::vec3(0.2f, 0.2f, 0.2f);
-		glm::vec3 spotLightDiffuse = glm::vec3(1.0f, 1.0f, 1.0f);
-		glm::vec3 spotLightSpecular = glm::vec3(1.0f, 1.0f, 1.0f);
+	glBeginQuery(GL_SAMPLES_PASSED, m_fragmentQuery);
+	glBeginQuery(GL_PRIMITIVES_GENERATED, m_triangleQuery);
+	for (int view = 0; view < (int)m_views.size(); view++)
+	{
+		// each view is timed on its own when there are several
+		std::string passName = "lit";
+		if (m_views.size() > 1)
+		{
+			passName += " " + m_views[view].name;
+		}
+		if (NULL != m_pRenderTimer) m_pRenderTimer->BeginPass(passName);
+		BindCameraView(view);
+		const std::vector<int>& drawOrder = m_viewDrawOrders[view];
+		for (int i = 0; i < (int)drawOrder.size(); i++)
+		{
+			const OBJECT_DRAW& draw = m_drawList[drawOrder[i]];
+			ApplyDrawState(m_pShaderManager, draw);
+			ApplyDrawLights(m_pShaderManager, draw);
+			if (bLightmaps && ApplyLightmapState(drawOrder[i], lightmapShape))
+			{
+				lightmappedDraws++;
+			}
+			DrawObjectMesh(draw, m_pShaderManager);
+		}
+		if (NULL != m_pRenderTimer) m_pRenderTimer->EndPass();
+	}
+	glEndQuery(GL_PRIMITIVES_GENERATED);
+	glEndQuery(GL_SAMPLES_PASSED);
+	m_bFragmentQueryIssued = true;
 
-		m_pShaderManager->setVec3Value("spotLight.position", spotLightPosition);
-		m_pShaderManager->setVec3Value("spotLight.direction", spotLightDirection);
-		m_pShaderManager->setFloatValue("spotLight.cutOff", spotLightCutOff);
-		m_pShaderManager->setFloatValue("spotLight.outerCutOff", spotLightOuterCutOff);
-		m_pShaderManager->setVec3Value("spotLight.ambient", spotLightAmbient);
-		m_pShaderManager->setVec3Value("spotLight.diffuse", spotLightDiffuse);
-		m_pShaderManager->setVec3Value("spotLight.specular", spotLightSpecular);
-		m_pShaderManager->setBoolValue("spotLight.bActive", true);
+	// the transparent pass shares the shader and is lit per pixel,
+	// and is not part of the depth the occlusion was computed from
+	if (lightmapShape != -1)
+	{
+		m_pShaderManager->setIntValue("lightmapShape", -1);
 	}
+	m_pShaderManager->setBoolValue("bUseAmbientOcclusion", false);
+	if (NULL != m_pRenderTimer) m_pRenderTimer->SetCounter("lightmapped draws", (double)lightmappedDraws);
+
+	// restore the default depth and blending state
+	glDepthFunc(GL_LESS);
+	glDepthMask(GL_TRUE);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 }
 
+/***********************************************************
+ *  IsTransparentDraw()
+ *
+ *  This method is used for checking whether a draw has to be
+ *  blended with what is behind it - either its material is
+ *  marked as blended, or its solid color is not opaque.
+ ***********************************************************/
+bool SceneManager::IsTransparentDraw(const OBJECT_DRAW& draw) const
+{
+	if ((draw.materialIndex >= 0) &&
+		(m_materialTable.GetMaterial(draw.materialIndex).alphaMode == MaterialTable::ALPHA_BLEND))
+	{
+		return(true);
+	}
+	return(!draw.bUseTexture && (draw.color.a < 1.0f));
+}
 
 /***********************************************************
- *  PrepareScene()
+ *  SplitTransparentDraws()
  *
- *  This method is used for preparing the 3D scene by loading
- *  the shapes, textures in memory to support the 3D scene
- *  rendering
+ *  This method is used for moving the transparent draws out
+ *  of a draw order, keeping the order of the rest.
  ***********************************************************/
-void SceneManager::PrepareScene()
+void SceneManager::SplitTransparentDraws(std::vector<int>& drawOrder, std::vector<int>& transparentOrder)
 {
-	// load the textures for the 3D scene
-	LoadSceneTextures();
+	int opaqueCount = 0;
+	for (int i = 0; i < (int)drawOrder.size(); i++)
+	{
+		if (IsTransparentDraw(m_drawList[drawOrder[i]]))
+		{
+			transparentOrder.push_back(drawOrder[i]);
+		}
+		else
+		{
+			drawOrder[opaqueCount++] = drawOrder[i];
+		}
+	}
+	drawOrder.resize(opaqueCount);
+}
 
-	// only one instance of a particular mesh needs to be
-	// loaded in memory no matter how many times it is drawn
-	// in the rendered 3D scene
+/***********************************************************
+ *  RenderTransparentPass()
+ *
+ *  This method is used for rendering the transparent draws
+ *  over the opaque scene with the forward lighting shader.
+ *  The sorted mode blends them back to front after sorting
+ *  them for every view each frame.  The weighted blended
+ *  mode renders them in any order into the accumulation
+ *  targets, which are then composited once for all views.
+ *  The particles are drawn after the transparent draws of
+ *  each view, added onto the scene in the sorted mode and
+ *  into the same targets in the weighted blended mode, and
+ *  are measured as their own pass.  Neither mode writes
+ *  depth.
+ ***********************************************************/
+void SceneManager::RenderTransparentPass(int width, int height)
+{
+	int transparentCount = GetTransparentDrawCount();
+	if (NULL != m_pRenderTimer)
+	{
+		m_pRenderTimer->SetCounter("transparent draws", (double)transparentCount);
+	}
+	bool bParticles = (NULL != m_pParticleSystem) && (m_pParticleSystem->GetParticleCount() > 0);
+	if ((transparentCount == 0) && !bParticles)
+	{
+		return;
+	}
 
-	  // Define materials
-	DefineObjectMaterials();
+	bool bWeighted = (NULL != m_pRenderSettings) &&
+		(m_pRenderSettings->transparencyMode == TransparencyRenderer::TRANSPARENCY_WEIGHTED);
+	if (bWeighted && (NULL == m_pTransparencyRenderer))
+	{
+		m_pTransparencyRenderer = new TransparencyRenderer();
+		m_pTransparencyRenderer->Initialize();
+	}
 
-	// Setup lights
-	SetupSceneLights();
+	if (NULL != m_pRenderTimer) m_pRenderTimer->BeginPass("transparent");
+	m_pShaderManager->use();
+	if (NULL != m_pShadowManager)
+	{
+		m_pShadowManager->ApplyToShader(m_pShaderManager, SHADOW_MAP_TEXTURE_UNIT);
+	}
+	ApplyExtraPointLights(m_pShaderManager);
+	ApplyMaterialTable(m_pShaderManager);
+	m_pShaderManager->setBoolValue("bShowOverdraw", false);
+	m_pShaderManager->setBoolValue("bWeightedTransparency", bWeighted);
 
-	m_basicMeshes->LoadPlaneMesh();     // For the table
-	m_basicMeshes->LoadBoxMesh();       // For monitor, keyboard, books
-	m_basicMeshes->LoadCylinderMesh();  // For the mug and pencil holder
-	m_basicMeshes->LoadTorusMesh();     // For the mug handle
-	m_basicMeshes->LoadSphereMesh();    // For the mouse
+	if (bWeighted)
+	{
+		m_pTransparencyRenderer->BeginAccumulation(width, height);
+	}
+	else
+	{
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		glDepthMask(GL_FALSE);
+	}
+
+	for (int view = 0; view < (int)m_views.size(); view++)
+	{
+		std::vector<int>& transparentOrder = m_viewTransparentOrders[view];
+		if (!bWeighted)
+		{
+			// farthest first, by the view depth of the bounds centers
+			const glm::mat4& viewMatrix = m_views[view].view;
+			std::vector<std::pair<float, int>> sortKeys(transparentOrder.size());
+			for (int i = 0; i < (int)transparentOrder.size(); i++)
+			{
+				const OBJECT_DRAW& draw = m_drawList[transparentOrder[i]];
+				glm::vec3 center = (draw.boundsMin + draw.boundsMax) * 0.5f;
+				sortKeys[i] = std::make_pair((viewMatrix * glm::vec4(center, 1.0f)).z, transparentOrder[i]);
+			}
+			std::stable_sort(sortKeys.begin(), sortKeys.end(),
+				[](const std::pair<float, int>& a, const std::pair<float, int>& b) { return a.first < b.first; });
+			for (int i = 0; i < (int)sortKeys.size(); i++)
+			{
+				transparentOrder[i] = sortKeys[i].second;
+			}
+		}
+
+		BindCameraView(view);
+		for (int i = 0; i < (int)transparentOrder.size(); i++)
+		{
+			const OBJECT_DRAW& draw = m_drawList[transparentOrder[i]];
+			ApplyDrawState(m_pShaderManager, draw);
+			ApplyDrawLights(m_pShaderManager, draw);
+			DrawObjectMesh(draw, m_pShaderManager);
+		}
+	}
+
+	m_pShaderManager->setBoolValue("bWeightedTransparency", false);
+
+	if (bParticles)
+	{
+		if (NULL != m_pRenderTimer) m_pRenderTimer->BeginPass("particles");
+		for (int view = 0; view < (int)m_views.size(); view++)
+		{
+			BindCameraView(view);
+			m_pParticleSystem->Render(bWeighted);
+		}
+		m_pShaderManager->use();
+		if (NULL != m_pRenderTimer) m_pRenderTimer->EndPass();
+	}
+
+	if (bWeighted)
+	{
+		if (NULL != m_pRenderTimer) m_pRenderTimer->BeginPass("oit composite");
+		m_pTransparencyRenderer->Composite();
+		m_pShaderManager->use();
+	}
+	glDepthMask(GL_TRUE);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	if (NULL != m_pRenderTimer) m_pRenderTimer->EndPass();
 }
 
 /***********************************************************
- *  RenderScene()
+ *  RenderDeferredPass()
  *
- *  This method is used for rendering all objects in the 3D scene.
- *  It invokes the render functions for the table, monitor,
- *  keyboard, mouse, books, pencil holder, and pencils.
- *  It acts as the central function to initiate the rendering
- *  process for the entire scene.
+ *  This method is used for rendering the sorted draws into
+ *  the G-buffer and then lighting every pixel once with the
+ *  full screen lighting pass.  The deferred resources are
+ *  created the first time this path is selected.
  ***********************************************************/
-void SceneManager::RenderScene() {
-	RenderTable();
-	RenderMonitor();
-	RenderKeyboard();
-	RenderMouse();
-	RenderBooks();
-	RenderPencilHolder();
-	RenderPencils();
+void SceneManager::RenderDeferredPass()
+{
+	if (NULL == m_pDeferredRenderer)
+	{
+		m_pDeferredRenderer = new DeferredRenderer();
+		m_pDeferredRenderer->Initialize();
+		ApplySceneLights(m_pDeferredRenderer->GetLightingShader());
+		BindCameraBlock(m_pDeferredRenderer->GetGeometryShader());
+	}
+
+	ShaderManager* pGeometryShader = m_pDeferredRenderer->GetGeometryShader();
+	ShaderManager* pLightingShader = m_pDeferredRenderer->GetLightingShader();
+
+	if (NULL != m_pRenderTimer) m_pRenderTimer->BeginPass("gbuffer");
+	BindCameraView(0);
+	m_pDeferredRenderer->BeginGeometryPass();
+	ApplyMaterialTable(pGeometryShader);
+	glBeginQuery(GL_SAMPLES_PASSED, m_fragmentQuery);
+	glBeginQuery(GL_PRIMITIVES_GENERATED, m_triangleQuery);
+	const std::vector<int>& drawOrder = m_viewDrawOrders[0];
+	for (int i = 0; i < (int)drawOrder.size(); i++)
+	{
+		const OBJECT_DRAW& draw = m_drawList[drawOrder[i]];
+		ApplyDrawState(pGeometryShader, draw);
+		DrawObjectMesh(draw, pGeometryShader);
+	}
+	glEndQuery(GL_PRIMITIVES_GENERATED);
+	glEndQuery(GL_SAMPLES_PASSED);
+	m_bFragmentQueryIssued = true;
+	m_pDeferredRenderer->EndGeometryPass();
+	if (NULL != m_pRenderTimer) m_pRenderTimer->EndPass();
+
+	int ambientOcclusionQuality = GetAmbientOcclusionQuality();
+	RenderAmbientOcclusion(ambientOcclusionQuality,
+		m_pDeferredRenderer->GetDepthTexture(), m_pDeferredRenderer->GetNormalTexture());
+
+	if (NULL != m_pRenderTimer) m_pRenderTimer->BeginPass("lighting");
+	pLightingShader->use();
+	pLightingShader->setBoolValue("bUseAmbientOcclusion", ambientOcclusionQuality > 0);
+	pLightingShader->setIntValue("ambientOcclusion", AmbientOcclusion::OCCLUSION_TEXTURE_UNIT);
+	if (NULL != m_pShadowManager)
+	{
+		m_pShadowManager->ApplyToShader(pLightingShader, SHADOW_MAP_TEXTURE_UNIT);
+	}
+	ApplyExtraPointLights(pLightingShader);
+	ApplyMaterialTable(pLightingShader);
+	m_pDeferredRenderer->RenderLightingPass(m_views[0].view, m_views[0].projection, m_views[0].position);
+	if (NULL != m_pRenderTimer) m_pRenderTimer->EndPass();
+
+	// the forward shader is expected to be active between frames
+	m_pShaderManager->use();
+}
+
+/***********************************************************
+ *  GetAmbientOcclusionQuality()
+ *
+ *  This method is used for getting the ambient occlusion
+ *  quality of this frame.  The occlusion is only computed
+ *  for a single view, and not for the overdraw display.
+ ***********************************************************/
+int SceneManager::GetAmbientOcclusionQuality() const
+{
+	if ((NULL == m_pRenderSettings) || m_pRenderSettings->bShowOverdraw || (m_views.size() != 1))
+	{
+		return(AmbientOcclusion::QUALITY_OFF);
+	}
+	return(m_pRenderSettings->ambientOcclusionQuality);
+}
+
+/***********************************************************
+ *  RenderAmbientOcclusion()
+ *
+ *  This method is used for computing the ambient visibility
+ *  of the single view, which the lighting shaders then read
+ *  from its texture unit.  The resources are created the
+ *  first time the occlusion is enabled.
+ ***********************************************************/
+void SceneManager::RenderAmbientOcclusion(int quality, GLuint depthTexture, GLuint normalTexture)
+{
+	if (quality <= AmbientOcclusion::QUALITY_OFF)
+	{
+		return;
+	}
+	if (NULL == m_pAmbientOcclusion)
+	{
+		m_pAmbientOcclusion = new AmbientOcclusion();
+		m_pAmbientOcclusion->Initialize();
+	}
+
+	if (NULL != m_pRenderTimer) m_pRenderTimer->BeginPass("ssao");
+	m_pAmbientOcclusion->Render(m_views[0].view, m_views[0].projection, quality, depthTexture, normalTexture);
+	if (NULL != m_pRenderTimer) m_pRenderTimer->EndPass();
+}
+
+/***********************************************************
+ *  CullOccludedDraws()
+ *
+ *  This method is used for removing the draws hidden behind
+ *  the depth of an earlier frame from a draw order.  The
+ *  Hi-Z resources are created the first time culling is
+ *  enabled, so nothing is culled until the depth of that
+ *  frame has been read back.
+ ***********************************************************/
+void SceneManager::CullOccludedDraws(std::vector<int>& drawOrder)
+{
+	if (NULL == m_pOcclusionCuller)
+	{
+		m_pOcclusionCuller = new OcclusionCuller();
+		m_pOcclusionCuller->Initialize();
+	}
+
+	m_pOcclusionCuller->Update();
+	if (!m_pOcclusionCuller->IsReady())
+	{
+		return;
+	}
+
+	int visibleCount = 0;
+	for (int i = 0; i < (int)drawOrder.size(); i++)
+	{
+		const OBJECT_DRAW& draw = m_drawList[drawOrder[i]];
+		bool bRecentlyMoved = (m_frameIndex - draw.movedFrame) <= OCCLUSION_LATENCY_FRAMES;
+		if (bRecentlyMoved || !m_pOcclusionCuller->IsOccluded(draw.boundsMin, draw.boundsMax))
+		{
+			drawOrder[visibleCount++] = drawOrder[i];
+		}
+	}
+	m_occludedDrawCount += (int)drawOrder.size() - visibleCount;
+	drawOrder.resize(visibleCount);
+}
+
+/***********************************************************
+ *  StreamTextureLevels()
+ *
+ *  This method is used for requesting the finest texture
+ *  level each visible draw needs, from how many texels of
+ *  its texture cross how many pixels of its screen bounds,
+ *  and letting the streamer upload or evict levels within
+ *  the budget.  Draws reaching behind the camera request
+ *  the finest level.  A texture seen in several views gets
+ *  the finest level any of them needs.
+ ***********************************************************/
+void SceneManager::StreamTextureLevels()
+{
+	int budgetMB = (NULL != m_pRenderSettings) ? m_pRenderSettings->textureBudgetMB : 0;
+	m_textureStreamer.SetBudget((size_t)glm::max(budgetMB, 0) * 1024 * 1024);
+
+	for (int view = 0; view < (int)m_views.size(); view++)
+	{
+		glm::mat4 viewProjection = m_views[view].projection * m_views[view].view;
+		const std::vector<int>& drawOrder = m_viewDrawOrders[view];
+		for (int i = 0; i < (int)drawOrder.size(); i++)
+		{
+			const OBJECT_DRAW& draw = m_drawList[drawOrder[i]];
+			if (draw.bUseTexture == false)
+			{
+				continue;
+			}
+			int slot = FindTextureSlot(draw.textureTag);
+			if (slot < 0)
+			{
+				continue;
+			}
+
+			glm::vec2 ndcMin = glm::vec2(1.0f);
+			glm::vec2 ndcMax = glm::vec2(-1.0f);
+			bool bBehindCamera = false;
+			for (int corner = 0; (corner < 8) && !bBehindCamera; corner++)
+			{
+				glm::vec4 clip = viewProjection * glm::vec4(
+					(corner & 1) ? draw.boundsMax.x : draw.boundsMin.x,
+					(corner & 2) ? draw.boundsMax.y : draw.boundsMin.y,
+					(corner & 4) ? draw.boundsMax.z : draw.boundsMin.z,
+					1.0f);
+				if (clip.w <= 1.0e-5f)
+				{
+					bBehindCamera = true;
+					break;
+				}
+				glm::vec2 ndc = glm::vec2(clip.x, clip.y) / clip.w;
+				ndcMin = (corner == 0) ? ndc : glm::min(ndcMin, ndc);
+				ndcMax = (corner == 0) ? ndc : glm::max(ndcMax, ndc);
+			}
+
+			int level = 0;
+			if (!bBehindCamera)
+			{
+				float pixels = glm::max(
+					(ndcMax.x - ndcMin.x) * 0.5f * m_views[view].width,
+					(ndcMax.y - ndcMin.y) * 0.5f * m_views[view].height);
+				float texels = glm::max(
+					m_textureStreamer.GetWidth(slot) * glm::abs(draw.UVscale.x),
+					m_textureStreamer.GetHeight(slot) * glm::abs(draw.UVscale.y));
+				level = (int)glm::floor(glm::log2(glm::max(texels / glm::max(pixels, 1.0f), 1.0f)));
+			}
+			m_textureStreamer.RequestLevel(slot, level);
+		}
+	}
+
+	m_textureStreamer.Update();
+
+	if (NULL != m_pRenderTimer)
+	{
+		m_pRenderTimer->SetCounter("texture resident bytes", (double)m_textureStreamer.GetResidentBytes());
+		m_pRenderTimer->SetCounter("texture requested bytes", (double)m_textureStreamer.GetRequestedBytes());
+	}
+}
+
+/***********************************************************
+ *  GenerateExtraPointLights()
+ *
+ *  This method is used for filling the light buffer with the
+ *  passed in number of additional point lights, scattered
+ *  over the scene from a fixed seed so that every run lights
+ *  the scene the same way.  The lamps of a generated office
+ *  are used before any scattered lights.  Each light falls
+ *  off with distance and reaches about one desk, so the
+ *  lights are hashed into the light grid by the sphere
+ *  they reach and every draw is lit by the few around it.
+ ***********************************************************/
+void SceneManager::GenerateExtraPointLights(int count)
+{
+	m_extraPointLightCount = count;
+
+	// 4 texels per light: position and radius, ambient and constant,
+	// diffuse and linear, specular and quadratic attenuation
+	std::vector<glm::vec4> lightData(glm::max(count, 1) * 4, glm::vec4(0.0f));
+	std::vector<LightGrid::GRID_LIGHT> gridLights(count);
+	m_extraPointLights.resize(count);
+
+	unsigned int seed = 330;
+	auto random = [&seed]() {
+		seed = seed * 1664525u + 1013904223u;
+		return (float)(seed >> 8) / 16777216.0f;
+	};
+
+	for (int i = 0; i < count; i++)
+	{
+		glm::vec3 position = glm::vec3(
+			glm::mix(m_sceneBoundsMin.x, m_sceneBoundsMax.x, random()),
+			glm::mix(0.5f, 5.0f, random()),
+			glm::mix(m_sceneBoundsMin.z, m_sceneBoundsMax.z, random()));
+		glm::vec3 color = glm::vec3(
+			0.5f + 0.5f * random(),
+			0.5f + 0.5f * random(),
+			0.5f + 0.5f * random());
+		if (i < (int)m_officeLights.size())
+		{
+			position = m_officeLights[i].position;
+			color = m_officeLights[i].color;
+		}
+
+		POINT_LIGHT& light = m_extraPointLights[i];
+		light.position = position;
+		light.ambient = color * 0.05f;
+		light.diffuse = color;
+		light.specular = color;
+		light.constant = EXTRA_LIGHT_CONSTANT;
+		light.linear = EXTRA_LIGHT_LINEAR;
+		light.quadratic = EXTRA_LIGHT_QUADRATIC;
+		light.radius = LightGrid::ComputeInfluenceRadius(color, light.constant, light.linear, light.quadratic);
+		gridLights[i].position = light.position;
+		gridLights[i].radius = light.radius;
+
+		lightData[i * 4] = glm::vec4(light.position, light.radius);
+		lightData[i * 4 + 1] = glm::vec4(light.ambient, light.constant);
+		lightData[i * 4 + 2] = glm::vec4(light.diffuse, light.linear);
+		lightData[i * 4 + 3] = glm::vec4(light.specular, light.quadratic);
+	}
+	m_lightGrid.Build(gridLights);
+	// the light lists applied before index the replaced lights
+	m_drawLightsProgram = 0;
+
+	glBindBuffer(GL_TEXTURE_BUFFER, m_extraLightBuffer);
+	glBufferData(GL_TEXTURE_BUFFER, lightData.size() * sizeof(glm::vec4), &lightData[0], GL_STATIC_DRAW);
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+	glActiveTexture(GL_TEXTURE0 + POINT_LIGHT_BUFFER_TEXTURE_UNIT);
+	glBindTexture(GL_TEXTURE_BUFFER, m_extraLightTexture);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, m_extraLightBuffer);
+
+	if (count > 0)
+	{
+		std::cout << "INFO: " << count << " additional point lights generated, " << m_lightGrid.GetEntryCount()
+			<< " grid entries in cells of " << m_lightGrid.GetCellSize() << std::endl;
+	}
+}
+
+/***********************************************************
+ *  ApplyExtraPointLights()
+ *
+ *  This method is used for binding the additional point
+ *  light buffer and passing its light count into the passed
+ *  in shader.
+ ***********************************************************/
+void SceneManager::ApplyExtraPointLights(ShaderManager* pShaderManager)
+{
+	glActiveTexture(GL_TEXTURE0 + POINT_LIGHT_BUFFER_TEXTURE_UNIT);
+	glBindTexture(GL_TEXTURE_BUFFER, m_extraLightTexture);
+	pShaderManager->setIntValue("extraPointLights", POINT_LIGHT_BUFFER_TEXTURE_UNIT);
+	pShaderManager->setIntValue("extraPointLightCount", m_extraPointLightCount);
+}
+
+/***********************************************************
+ *  ApplyDrawLights()
+ *
+ *  This method is used for passing the indices of the
+ *  additional point lights whose sphere reaches the bounds
+ *  of a draw, so the shader only loops over those.  A draw
+ *  reached by more lights than the shader takes keeps the
+ *  ones reaching deepest into its bounds.  The list is only
+ *  set when it differs from the last one, which neighbouring
+ *  draws often share.  With the light culling off the count
+ *  is -1, and the shader loops over every light.
+ ***********************************************************/
+void SceneManager::ApplyDrawLights(ShaderManager* pShaderManager, const OBJECT_DRAW& draw)
+{
+	bool bLightCulling = (NULL == m_pRenderSettings) || m_pRenderSettings->bLightCulling;
+	int lightCount = -1;
+	m_drawLights.clear();
+	if (bLightCulling)
+	{
+		m_lightGrid.Query(draw.boundsMin, draw.boundsMax, m_drawLights);
+		if (m_drawLights.size() > MAX_DRAW_LIGHTS)
+		{
+			// the distance from each light to the bounds as a
+			// fraction of its radius - nearer lights add more
+			std::vector<std::pair<float, int>> reach(m_drawLights.size());
+			for (int i = 0; i < (int)m_drawLights.size(); i++)
+			{
+				const POINT_LIGHT& light = m_extraPointLights[m_drawLights[i]];
+				glm::vec3 closest = glm::clamp(light.position, draw.boundsMin, draw.boundsMax);
+				float distance = glm::length(light.position - closest);
+				reach[i] = std::make_pair((light.radius > 0.0f) ? distance / light.radius : 0.0f, m_drawLights[i]);
+			}
+			std::nth_element(reach.begin(), reach.begin() + MAX_DRAW_LIGHTS, reach.end());
+			m_drawLights.resize(MAX_DRAW_LIGHTS);
+			for (int i = 0; i < MAX_DRAW_LIGHTS; i++)
+			{
+				m_drawLights[i] = reach[i].second;
+			}
+			std::sort(m_drawLights.begin(), m_drawLights.end());
+		}
+		lightCount = (int)m_drawLights.size();
+		m_drawLightSum += lightCount;
+	}
+	else
+	{
+		m_drawLightSum += glm::max(m_extraPointLightCount, 0);
+	}
+	m_litDraws++;
+
+	bool bApply = (lightCount != m_appliedDrawLightCount) || (m_drawLights != m_appliedDrawLights);
+	if (pShaderManager->m_programID != m_drawLightsProgram)
+	{
+		m_drawLightsProgram = pShaderManager->m_programID;
+		m_drawLightsLocation = glGetUniformLocation(m_drawLightsProgram, "drawLights");
+		bApply = true;
+	}
+	if (bApply)
+	{
+		pShaderManager->setIntValue("drawLightCount", lightCount);
+		if ((lightCount > 0) && (m_drawLightsLocation >= 0))
+		{
+			glUniform1iv(m_drawLightsLocation, lightCount, &m_drawLights[0]);
+		}
+		m_appliedDrawLights = m_drawLights;
+		m_appliedDrawLightCount = lightCount;
+	}
+}
+
+/***********************************************************
+ *  UpdateLightmaps()
+ *
+ *  This method is used for making the lightmaps match the
+ *  draw list and the shadow ray option.  The basic mesh
+ *  draws are baked and cast the shadows, while the imported
+ *  meshes and the blended draws are left to the per pixel
+ *  lighting.  A saved atlas of the same signature is loaded
+ *  instead of baking again, and a new bake is saved for the
+ *  next run.  The check only runs after the draw list or
+ *  the option changed, so moving draws never bakes again.
+ ***********************************************************/
+void SceneManager::UpdateLightmaps(bool bForceBake)
+{
+	bool bOcclusion = (NULL == m_pRenderSettings) || m_pRenderSettings->bLightmapOcclusion;
+	if (!bForceBake && !m_bLightmapsStale && (bOcclusion == m_bLightmapOcclusion))
+	{
+		return;
+	}
+
+	std::vector<LightmapBaker::BAKE_SURFACE> surfaces(m_drawList.size());
+	for (int i = 0; i < (int)m_drawList.size(); i++)
+	{
+		const OBJECT_DRAW& draw = m_drawList[i];
+		bool bStatic = (draw.importedMesh < 0) && !IsTransparentDraw(draw);
+		surfaces[i].shape = bStatic ? (int)draw.mesh : -1;
+		surfaces[i].modelMatrix = draw.modelMatrix;
+		surfaces[i].normalMatrix = draw.normalMatrix;
+		surfaces[i].boundsMin = draw.boundsMin;
+		surfaces[i].boundsMax = draw.boundsMax;
+		surfaces[i].bOccluder = bStatic;
+	}
+
+	unsigned int signature = LightmapBaker::ComputeSignature(surfaces, m_bakeLights, bOcclusion);
+	if (bForceBake || (signature != m_lightmapBaker.GetSignature()))
+	{
+		if (bForceBake || !m_lightmapBaker.Load(g_LightmapFilename, signature))
+		{
+			m_lightmapBaker.Bake(surfaces, m_bakeLights, bOcclusion);
+			m_lightmapBaker.Save(g_LightmapFilename);
+		}
+
+		if (m_lightmapTexture == 0)
+		{
+			glGenTextures(1, &m_lightmapTexture);
+		}
+		glActiveTexture(GL_TEXTURE0 + LIGHTMAP_TEXTURE_UNIT);
+		glBindTexture(GL_TEXTURE_2D, m_lightmapTexture);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, m_lightmapBaker.GetWidth(), m_lightmapBaker.GetHeight(), 0,
+			GL_RGBA, GL_HALF_FLOAT, m_lightmapBaker.GetTexels().data());
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	}
+
+	m_bLightmapsStale = false;
+	m_bLightmapOcclusion = bOcclusion;
+	m_lightmapFrame = m_frameIndex;
+}
+
+/***********************************************************
+ *  ApplyLightmapState()
+ *
+ *  This method is used for passing the unwrapped shape and
+ *  the atlas tile of a draw into the lighting shader.  A
+ *  draw without a tile, or moved since the lightmaps were
+ *  baked, is lit per pixel.  The shape is only set when it
+ *  differs from the passed in one applied before.
+ ***********************************************************/
+bool SceneManager::ApplyLightmapState(int drawIndex, int& appliedShape)
+{
+	const OBJECT_DRAW& draw = m_drawList[drawIndex];
+	int shape = -1;
+	glm::vec4 tile = glm::vec4(0.0f);
+	if ((drawIndex < m_lightmapBaker.GetSurfaceCount()) && (draw.movedFrame < m_lightmapFrame))
+	{
+		tile = m_lightmapBaker.GetTile(drawIndex);
+		if (tile.z > 0.0f)
+		{
+			shape = (int)draw.mesh;
+		}
+	}
+
+	if (shape != appliedShape)
+	{
+		m_pShaderManager->setIntValue("lightmapShape", shape);
+		appliedShape = shape;
+	}
+	if (shape >= 0)
+	{
+		m_pShaderManager->setVec4Value("lightmapTile", tile);
+	}
+	return(shape >= 0);
+}
+
+/***********************************************************
+ *  BakeLightmaps()
+ *
+ *  This method is used for baking the lightmaps of the
+ *  current draw list and saving them, replacing the atlas
+ *  saved before.
+ ***********************************************************/
+void SceneManager::BakeLightmaps()
+{
+	UpdateLightmaps(true);
 }
 
 /***********************************************************
@@ -589,7 +3177,7 @@ void SceneManager::RenderTable() {
 	SetShaderMaterial("wood");  // Apply wood material to table
 	SetShaderTexture("T");      // Apply the texture for the table
 	SetTextureUVScale(5.0f, 5.0f);  // Texture tiling
-	m_basicMeshes->DrawPlaneMesh();
+	DrawMesh(MESH_PLANE);
 }
 
 /***********************************************************
@@ -608,7 +3196,7 @@ void SceneManager::RenderMonitor() {
 	// Set material and texture for the monitor base
 	SetShaderMaterial("metal");  // Apply metal material to monitor base
 	SetShaderTexture("H");       // Apply the texture for the base
-	m_basicMeshes->DrawBoxMesh();
+	DrawMesh(MESH_BOX);
 
 	// Monitor frame
 	scaleXYZ = glm::vec3(8.0f, 5.0f, 0.5f);
@@ -618,7 +3206,7 @@ void SceneManager::RenderMonitor() {
 	// Apply the same material and texture to the frame
 	SetShaderMaterial("metal");
 	SetShaderTexture("N");
-	m_basicMeshes->DrawBoxMesh();
+	DrawMesh(MESH_BOX);
 
 	// Monitor screen
 	scaleXYZ = glm::vec3(7.5f, 4.5f, 0.1f);
@@ -628,7 +3216,7 @@ void SceneManager::RenderMonitor() {
 	// Apply glass material for the screen
 	SetShaderMaterial("glass");
 	SetShaderColor(1.0f, 1.0f, 1.0f, 1.0f);  // Set the screen color to white
-	m_basicMeshes->DrawBoxMesh();
+	DrawMesh(MESH_BOX);
 }
 
 /***********************************************************
@@ -652,7 +3240,14 @@ void SceneManager::RenderKeyboard() {
 	// Set texture for the keyboard base
 	SetShaderMaterial("metal");  // Apply metal material to base
 	SetShaderTexture("N");       // Apply texture for the keyboard base
-	m_basicMeshes->DrawBoxMesh();
+
+	// an imported keyboard has its own keys
+	if (m_keyboardMesh >= 0)
+	{
+		DrawImportedMesh(m_keyboardMesh);
+		return;
+	}
+	DrawMesh(MESH_BOX);
 
 	// Render the keyboard keys (grid of keys)
 	glm::vec3 keyScaleXYZ = glm::vec3(0.35f, 0.1f, 0.35f);
@@ -670,7 +3265,7 @@ void SceneManager::RenderKeyboard() {
 
 			// Apply texture for each key
 			SetShaderTexture("u");  // Apply texture for the key
-			m_basicMeshes->DrawBoxMesh();
+			DrawMesh(MESH_BOX);
 		}
 	}
 
@@ -693,7 +3288,14 @@ void SceneManager::RenderMouse() {
 	// Set material and texture for the mouse
 	SetShaderMaterial("metal");
 	SetShaderTexture("H");  // Apply texture to the mouse
-	m_basicMeshes->DrawSphereMesh();
+	if (m_mouseMesh >= 0)
+	{
+		DrawImportedMesh(m_mouseMesh);
+	}
+	else
+	{
+		DrawMesh(MESH_SPHERE);
+	}
 }
 
 /***********************************************************
@@ -715,7 +3317,7 @@ void SceneManager::RenderBooks() {
 		{"FLO", "plate" }
 	};
 
-	for (int i = 0; i < bookMaterials.size(); i++) {
+	for (int i = 0; i < (int)bookMaterials.size(); i++) {
 		glm::vec3 currentBookScale = bookBaseScale;
 		if (i == 1) currentBookScale.y *= 1.2f;  // Thicker middle book
 		if (i == 2) currentBookScale.y *= 1.1f;  // Thicker top book
@@ -731,7 +3333,7 @@ void SceneManager::RenderBooks() {
 		SetTransformations(currentBookScale, 0.0f, rotationAngle, 0.0f, misalignedPosition);
 		SetShaderMaterial(bookMaterials[i].second);
 		SetShaderTexture(bookMaterials[i].first);
-		m_basicMeshes->DrawBoxMesh();
+		DrawMesh(MESH_BOX);
 
 		bookPosition.y += currentBookScale.y + bookSpacingY;
 	}
@@ -750,7 +3352,7 @@ void SceneManager::RenderPencilHolder() {
 	SetTransformations(holderScale, 0.0f, 0.0f, 0.0f, holderPosition);
 	SetShaderMaterial("metal");
 	SetShaderTexture("B");
-	m_basicMeshes->DrawCylinderMesh();
+	DrawMesh(MESH_CYLINDER);
 }
 
 
@@ -787,6 +3389,46 @@ void SceneManager::RenderPencils() {
 
 		SetTransformations(pencilScale, rotationAngle, 0.0f, 0.0f, pencilPosition);
 		SetShaderColor(chosenColor.r, chosenColor.g, chosenColor.b, 1.0f);
-		m_basicMeshes->DrawCylinderMesh();
+		DrawMesh(MESH_CYLINDER);
+	}
+}
+
+/***********************************************************
+ *  RenderNormalTestObjects()
+ *
+ *  This method is used for rendering a row of boxes and a
+ *  sphere in front of the books, each rotated about two axes
+ *  and scaled by a different amount along each.  Their faces
+ *  are only lit from the right side when the normals are
+ *  transformed by the inverse transpose of the model matrix,
+ *  and the sphere also shows the model matrix itself being
+ *  used, so the regression check renders them as a preset.
+ ***********************************************************/
+void SceneManager::RenderNormalTestObjects() {
+	glm::vec3 center = GetNormalTestCenter();
+	glm::vec3 boxScales[] = {
+		glm::vec3(1.2f, 0.3f, 0.6f),
+		glm::vec3(0.4f, 1.0f, 0.5f),
+		glm::vec3(0.9f, 0.5f, 0.25f)
+	};
+	glm::vec3 boxRotations[] = {
+		glm::vec3(30.0f, 45.0f, 0.0f),
+		glm::vec3(0.0f, -30.0f, 60.0f),
+		glm::vec3(-40.0f, 0.0f, 25.0f)
+	};
+
+	for (int i = 0; i < 3; i++) {
+		glm::vec3 boxPosition = center + glm::vec3((i - 1) * 1.5f, 0.0f, 0.0f);
+		SetTransformations(boxScales[i], boxRotations[i].x, boxRotations[i].y, boxRotations[i].z, boxPosition);
+		SetShaderMaterial("plate");
+		SetShaderColor(0.8f, 0.8f, 0.8f, 1.0f);
+		DrawMesh(MESH_BOX);
 	}
+
+	// a squashed sphere keeps its normals perpendicular to the
+	// surface only with the inverse transpose
+	SetTransformations(glm::vec3(0.8f, 0.3f, 0.5f), 0.0f, 35.0f, 30.0f, center + glm::vec3(0.0f, 0.0f, 1.3f));
+	SetShaderMaterial("plate");
+	SetShaderColor(0.8f, 0.8f, 0.8f, 1.0f);
+	DrawMesh(MESH_SPHERE);
 }
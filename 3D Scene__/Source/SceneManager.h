@@ -11,6 +11,24 @@
 
 #include "ShaderManager.h"
 #include "ShapeMeshes.h"
+#include "ShadowManager.h"
+#include "DeferredRenderer.h"
+#include "TransparencyRenderer.h"
+#include "BoundingVolumeHierarchy.h"
+#include "OcclusionCuller.h"
+#include "AmbientOcclusion.h"
+#include "TextureStreamer.h"
+#include "OfficeGenerator.h"
+#include "AnimationSystem.h"
+#include "MeshImporter.h"
+#include "MaterialTable.h"
+#include "LightmapBaker.h"
+#include "LightGrid.h"
+#include "SceneSnapshot.h"
+#include "ParticleSystem.h"
+#include "RenderSettings.h"
+#include "RenderTimer.h"
+#include "SceneView.h"
 
 #include <string>
 #include <vector>
@@ -36,13 +54,70 @@ public:
 		uint32_t ID;
 	};
 
-	// properties for object materials
-	struct OBJECT_MATERIAL
+	// properties for object materials, kept in the material table
+	typedef MaterialTable::MATERIAL OBJECT_MATERIAL;
+
+	// basic mesh shapes that can be drawn
+	enum MESH_SHAPE
 	{
-		glm::vec3 diffuseColor;
-		glm::vec3 specularColor;
-		float shininess;
-		std::string tag;
+		MESH_PLANE,
+		MESH_BOX,
+		MESH_CYLINDER,
+		MESH_TORUS,
+		MESH_SPHERE
+	};
+
+	// how the lit pass transforms the vertex normals - only the
+	// normal matrix lights rotated and scaled objects correctly,
+	// the others are kept to measure it against
+	enum NORMAL_TRANSFORM
+	{
+		// by the normal matrix computed once per object
+		NORMAL_PRECOMPUTED,
+		// not at all, as before the normal matrix
+		NORMAL_UNTRANSFORMED,
+		// by the inverse transpose computed for every vertex
+		NORMAL_PER_VERTEX,
+		NORMAL_TRANSFORM_COUNT
+	};
+
+	// properties for one recorded draw of a basic or imported mesh
+	struct OBJECT_DRAW
+	{
+		MESH_SHAPE mesh;
+		// imported mesh drawn instead of the basic one (-1 = none)
+		int importedMesh;
+		glm::mat4 modelMatrix;
+		// inverse transpose of the model rotation and scale, so the
+		// vertex shader does not have to invert it per vertex
+		glm::mat3 normalMatrix;
+		std::string materialTag;
+		// index of the material in the material table (-1 = none)
+		int materialIndex;
+		std::string textureTag;
+		bool bUseTexture;
+		glm::vec4 color;
+		glm::vec2 UVscale;
+		glm::vec3 boundsMin;
+		glm::vec3 boundsMax;
+		// frame in which the draw was last moved
+		int movedFrame;
+	};
+
+	// properties for one point light, attenuated with distance as
+	// 1 / (constant + linear * d + quadratic * d^2)
+	struct POINT_LIGHT
+	{
+		glm::vec3 position;
+		glm::vec3 ambient;
+		glm::vec3 diffuse;
+		glm::vec3 specular;
+		float constant;
+		float linear;
+		float quadratic;
+		// distance beyond which the light adds nothing (negative =
+		// everywhere), from LightGrid::ComputeInfluenceRadius
+		float radius;
 	};
 
 private:
@@ -54,8 +129,167 @@ private:
 	int m_loadedTextures;
 	// loaded textures info
 	TEXTURE_INFO m_textureIDs[16];
-	// defined object materials
-	std::vector<OBJECT_MATERIAL> m_objectMaterials;
+	// streamed mip levels of the loaded textures, in slot order
+	TextureStreamer m_textureStreamer;
+	// defined object materials, read by the shaders from a buffer
+	MaterialTable m_materialTable;
+	// shader program and material index last set for a draw, and
+	// the material uniform calls issued and drawn over this frame
+	GLuint m_materialProgram;
+	int m_appliedMaterialIndex;
+	int m_materialUniformCalls;
+	int m_materialDraws;
+	// GPU buffers of one imported mesh, with its object space
+	// bounds after it was fitted to the basic mesh it replaces
+	struct IMPORTED_MESH_BUFFERS
+	{
+		GLuint vertexArray;
+		GLuint vertexBuffer;
+		GLuint indexBuffer;
+		GLsizei indexCount;
+		glm::vec3 boundsMin;
+		glm::vec3 boundsMax;
+		// vertex layout, and the decoding of packed positions
+		MeshImporter::VERTEX_FORMAT format;
+		glm::vec3 positionScale;
+		glm::vec3 positionOffset;
+	};
+	// loaded imported meshes
+	std::vector<IMPORTED_MESH_BUFFERS> m_importedMeshes;
+	// imported meshes replacing the mouse and the keyboard
+	// (-1 = drawn from the basic meshes)
+	int m_mouseMesh;
+	int m_keyboardMesh;
+	// shader program and imported mesh the vertex decoding was
+	// last set up for (-1 = the float layout)
+	GLuint m_vertexFormatProgram;
+	int m_vertexFormatMesh;
+	// draw state collected by the transformation and shader setters
+	OBJECT_DRAW m_currentDraw;
+	// recorded draws of the 3D scene, built once when preparing
+	std::vector<OBJECT_DRAW> m_drawList;
+	// world space bounds of all the recorded draws
+	glm::vec3 m_sceneBoundsMin;
+	glm::vec3 m_sceneBoundsMax;
+	// desks of the generated office (0 = the recorded desk only)
+	// and the seed it is generated from
+	int m_officeDeskCount;
+	unsigned int m_officeSeed;
+	// draws of the recorded desk, and the ranges of its monitor
+	// and pencil draws the animations are added for
+	int m_drawsPerDesk;
+	int m_monitorFirst;
+	int m_monitorEnd;
+	int m_pencilFirst;
+	int m_pencilEnd;
+	// snapshot the prepared scene is mapped from, if any
+	std::string m_snapshotFile;
+	// lamps of the generated office, used first by the
+	// additional point lights
+	std::vector<OfficeGenerator::OFFICE_LIGHT> m_officeLights;
+	// keyframe tracks moving the animated draws
+	AnimationSystem m_animationSystem;
+	// time in seconds the animations are evaluated at
+	float m_animationTime;
+	// particles thrown over the desk, created on first use
+	ParticleSystem* m_pParticleSystem;
+	// animation time the particles were last advanced to
+	float m_particleTime;
+	// shared rendering options
+	RENDER_SETTINGS* m_pRenderSettings;
+	// frame timing collector
+	RenderTimer* m_pRenderTimer;
+	// views rendered in the next frame - the first one is the
+	// camera the shadows and the Hi-Z depth are built for
+	std::vector<SCENE_VIEW> m_views;
+	// uniform buffer holding the camera block of every view, and
+	// the distance between two views in it
+	GLuint m_cameraBuffer;
+	GLint m_cameraBlockStride;
+	// shader used for the depth-only shadow passes
+	ShaderManager* m_pDepthShaderManager;
+	// shadow maps for the directional and spot lights
+	ShadowManager* m_pShadowManager;
+	// shader used for the depth-only camera prepass
+	ShaderManager* m_pPrepassShaderManager;
+	// lit shader for each normal transform - the first one is the
+	// shipping shader passed in, the others are separate programs
+	// only loaded when the normal benchmark selects them
+	ShaderManager* m_normalShaderManagers[NORMAL_TRANSFORM_COUNT];
+	// indices into the draw list in the order they are rendered,
+	// one list for each view
+	std::vector<std::vector<int>> m_viewDrawOrders;
+	// the blended draws taken out of the draw orders, rendered
+	// after all of the opaque ones
+	std::vector<std::vector<int>> m_viewTransparentOrders;
+	// hierarchy over the world bounds of the recorded draws
+	BoundingVolumeHierarchy m_drawBVH;
+	// draws moved since the hierarchy was last refit
+	bool m_bDrawBoundsChanged;
+	// Hi-Z test against an earlier frame's depth, created on first use
+	OcclusionCuller* m_pOcclusionCuller;
+	// draws in the frustum skipped as occluded by the last frame
+	int m_occludedDrawCount;
+	// screen space ambient occlusion, created on first use
+	AmbientOcclusion* m_pAmbientOcclusion;
+	// number of frames rendered
+	int m_frameIndex;
+	// occlusion query counting the fragments shaded by the lit pass
+	GLuint m_fragmentQuery;
+	bool m_bFragmentQueryIssued;
+	// fragments shaded by the lit pass of the last completed frame
+	GLuint64 m_shadedFragments;
+	// query counting the triangles drawn by the lit pass, issued
+	// together with the fragment query, and its last result
+	GLuint m_triangleQuery;
+	GLuint64 m_litTriangles;
+	// add the boxes checking the lighting of rotated and scaled
+	// objects to the draw list
+	bool m_bNormalTestObjects;
+	// G-buffer and shaders of the deferred path, created on first use
+	DeferredRenderer* m_pDeferredRenderer;
+	// accumulation targets of the weighted blended transparency,
+	// created on first use
+	TransparencyRenderer* m_pTransparencyRenderer;
+	// texture buffer holding the additional point lights
+	GLuint m_extraLightBuffer;
+	GLuint m_extraLightTexture;
+	int m_extraPointLightCount;
+	// active scene point lights, compacted into the first entries
+	// of the shaders' point light array
+	std::vector<POINT_LIGHT> m_scenePointLights;
+	// the additional point lights as uploaded, and the grid of their
+	// spheres of influence the draws find their lights in
+	std::vector<POINT_LIGHT> m_extraPointLights;
+	LightGrid m_lightGrid;
+	// lights found for the current draw, and the list, count and
+	// shader program last passed into a shader
+	std::vector<int> m_drawLights;
+	std::vector<int> m_appliedDrawLights;
+	int m_appliedDrawLightCount;
+	GLuint m_drawLightsProgram;
+	GLint m_drawLightsLocation;
+	// lights passed to the lit draws over this frame
+	int m_drawLightSum;
+	int m_litDraws;
+	// shadow casting light parameters set up with the scene lights
+	glm::vec3 m_directionalLightDirection;
+	glm::vec3 m_spotLightPosition;
+	glm::vec3 m_spotLightDirection;
+	float m_spotLightOuterCutOff;
+	// scene lights as the lightmaps are baked from them
+	LightmapBaker::BAKE_LIGHTS m_bakeLights;
+	// baked diffuse lighting of the static draws, and its atlas
+	// texture, created on first use
+	LightmapBaker m_lightmapBaker;
+	GLuint m_lightmapTexture;
+	// the draw list changed since the lightmaps were last checked,
+	// and whether they were baked with shadow rays
+	bool m_bLightmapsStale;
+	bool m_bLightmapOcclusion;
+	// frame the lightmaps were last checked in - draws moved
+	// since then are lit per pixel
+	int m_lightmapFrame;
 
 	// load texture images and convert to OpenGL texture data
 	bool CreateGLTexture(const char* filename, std::string tag);
@@ -66,8 +300,8 @@ private:
 	// find a loaded texture by tag
 	int FindTextureID(std::string tag);
 	int FindTextureSlot(std::string tag);
-	// find a defined material by tag
-	bool FindMaterial(std::string tag, OBJECT_MATERIAL& material);
+	// bind the material table to the passed in shader
+	void ApplyMaterialTable(ShaderManager* pShaderManager);
 
 	// set the transformation values 
 	// into the transform buffer
@@ -98,6 +332,98 @@ private:
 	void SetShaderMaterial(
 		std::string materialTag);
 
+	// record a draw of a basic mesh with the current draw state
+	void DrawMesh(MESH_SHAPE mesh);
+	// record a draw of an imported mesh with the current draw state
+	void DrawImportedMesh(int importedMesh);
+	// load a mesh file from the meshes folder, fitted into the
+	// bounds of the basic mesh it replaces - returns its index
+	// or -1 when there is no such file
+	int LoadImportedMesh(const std::string& name, MESH_SHAPE fittedMesh, MeshImporter::VERTEX_FORMAT format);
+	// create the buffers of an imported mesh from its vertices in
+	// the format of the buffers, and its indices
+	void UploadImportedMesh(IMPORTED_MESH_BUFFERS& buffers, const void* pVertices, size_t vertexBytes, const unsigned int* pIndices);
+	// free the buffers of all the imported meshes
+	void DestroyImportedMeshes();
+	// get a hash of the options a snapshot of an office of the
+	// passed in desks and seed depends on
+	unsigned int ComputeSnapshotSignature(int deskCount, unsigned int seed) const;
+	// calculate the world space bounds of a recorded draw
+	void UpdateDrawBounds(OBJECT_DRAW& draw);
+	// rebuild or refit the hierarchy over the draw bounds
+	void UpdateDrawBVH(bool bRebuild);
+	// get the object space bounds of a basic mesh
+	void GetMeshBounds(MESH_SHAPE mesh, glm::vec3& boundsMin, glm::vec3& boundsMax);
+	// issue the draw call for a basic mesh
+	void DrawBasicMesh(MESH_SHAPE mesh);
+	// issue the draw call for the mesh of a recorded draw,
+	// setting up the shader to decode its vertex format
+	void DrawObjectMesh(const OBJECT_DRAW& draw, ShaderManager* pShaderManager);
+	// pass the state of a recorded draw into a shader
+	void ApplyDrawState(ShaderManager* pShaderManager, const OBJECT_DRAW& draw);
+	// record all the scene objects into the draw list
+	void BuildDrawList();
+	// replicate the recorded desk into the generated office
+	void GenerateOfficeDraws();
+	// add the animation tracks of the monitor and pencil draws
+	// of every desk
+	void DefineObjectAnimations(int monitorFirst, int monitorEnd, int pencilFirst, int pencilEnd, int drawsPerDesk);
+	// evaluate the animations and move their draws
+	void UpdateAnimations();
+	// advance the particles to the animation time
+	void UpdateParticles();
+	// render the depth-only passes into the shadow maps
+	void RenderShadowMaps();
+	// link the camera block of a shader to the camera buffer
+	void BindCameraBlock(ShaderManager* pShaderManager);
+	// upload the camera blocks of all the views
+	void UploadCameraViews();
+	// bind the camera block and the viewport of a view
+	void BindCameraView(int view);
+	// collect the draws in the frustum of a view, ordered
+	// front-to-back from its camera
+	void SortDrawList(const SCENE_VIEW& view, std::vector<int>& drawOrder);
+	// render the depth-only camera prepass of all the views
+	void RenderDepthPrepass();
+	// make the lit shader the one of the selected normal transform
+	void SelectNormalShader();
+	// render the lit draws with the forward lighting shader
+	void RenderForwardPass(bool bDepthPrepass, bool bShowOverdraw);
+	// render the lit draws through the deferred G-buffer path
+	void RenderDeferredPass();
+	// get the ambient occlusion quality used this frame (0 = off)
+	int GetAmbientOcclusionQuality() const;
+	// compute the ambient occlusion of the single view from the
+	// passed in depth and normals, or the bound framebuffer depth
+	void RenderAmbientOcclusion(int quality, GLuint depthTexture, GLuint normalTexture);
+	// check whether a draw is blended with what is behind it
+	bool IsTransparentDraw(const OBJECT_DRAW& draw) const;
+	// move the transparent draws of a draw order into their own list
+	void SplitTransparentDraws(std::vector<int>& drawOrder, std::vector<int>& transparentOrder);
+	// render the transparent draws of every view over the opaque
+	// scene, in a framebuffer of the passed in size
+	void RenderTransparentPass(int width, int height);
+	// remove the draws hidden in the Hi-Z pyramid from a draw order
+	void CullOccludedDraws(std::vector<int>& drawOrder);
+	// request the texture levels for the screen size of the draws
+	// in every view
+	void StreamTextureLevels();
+	// pass the scene light values into a shader
+	void ApplySceneLights(ShaderManager* pShaderManager);
+	// fill the light buffer with generated point lights
+	void GenerateExtraPointLights(int count);
+	// bind the additional point lights for a shader
+	void ApplyExtraPointLights(ShaderManager* pShaderManager);
+	// pass the additional point lights reaching a draw's bounds
+	// into the passed in shader
+	void ApplyDrawLights(ShaderManager* pShaderManager, const OBJECT_DRAW& draw);
+	// load or bake the lightmaps of the draw list when it or the
+	// bake options changed, and upload the atlas
+	void UpdateLightmaps(bool bForceBake);
+	// pass the lightmap tile of a draw into the lighting shader,
+	// returning whether the draw is lit from it
+	bool ApplyLightmapState(int drawIndex, int& appliedShape);
+
 public:
 
 	// prepare the 3D scene for rendering
@@ -105,6 +431,78 @@ public:
 	// render the objects in the 3D scene
 	void RenderScene();
 
+	// set the shared rendering options
+	void SetRenderSettings(RENDER_SETTINGS* pRenderSettings);
+	// set the frame timing collector
+	void SetRenderTimer(RenderTimer* pRenderTimer);
+	// most views rendered in one frame
+	static const int MAX_VIEWS = 4;
+	// set the views rendered in the next frame - culling, sorting
+	// and drawing run for each, the shadow maps once for all
+	void SetViews(const std::vector<SCENE_VIEW>& views);
+	// get the number of fragments shaded by the last lit pass
+	GLuint64 GetShadedFragmentCount() const { return m_shadedFragments; }
+	// get the number of triangles drawn by the last lit pass
+	GLuint64 GetLitTriangleCount() const { return m_litTriangles; }
+	// get the number of draws rendered by the last frame, summed
+	// over its views
+	int GetVisibleDrawCount() const;
+	// get the number of transparent draws rendered by the last
+	// frame, summed over its views
+	int GetTransparentDrawCount() const;
+	// bake the lightmaps of the current draw list and save them,
+	// even when a matching atlas was saved before
+	void BakeLightmaps();
+	// get the number of draws skipped as occluded by the last frame
+	int GetOccludedDrawCount() const { return m_occludedDrawCount; }
+	// get the number of recorded draws
+	int GetDrawCount() const { return (int)m_drawList.size(); }
+	// get a recorded draw
+	const OBJECT_DRAW& GetDraw(int index) const { return m_drawList[index]; }
+
+	// find a defined material by tag
+	bool FindMaterial(std::string tag, OBJECT_MATERIAL& material);
+	// change the values of a defined material - only its part of
+	// the material table is uploaded before the next frame
+	bool UpdateMaterial(std::string tag, const OBJECT_MATERIAL& material);
+
+	// set the time in seconds the animations are shown at
+	void SetAnimationTime(float seconds) { m_animationTime = seconds; }
+	// get the number of animation tracks
+	int GetAnimationTrackCount() const { return m_animationSystem.GetTrackCount(); }
+
+	// rebuild the draw list as a generated office of the passed in
+	// number of desks (0 = the recorded desk only)
+	void GenerateOffice(int deskCount, unsigned int seed);
+	// rebuild the draw list with or without the rotated and
+	// non-uniformly scaled objects the regression check looks at
+	void SetNormalTestObjects(bool bShow);
+	// get the center of the normal test objects
+	static glm::vec3 GetNormalTestCenter();
+
+	// map the prepared scene from a snapshot file when preparing,
+	// rebuilding and saving it when it does not match the options
+	void SetSnapshotFile(const std::string& filename) { m_snapshotFile = filename; }
+	// write the prepared scene into a snapshot file
+	bool SaveSnapshot(const std::string& filename);
+	// replace the scene with a snapshot of an office of the passed
+	// in desks and seed - fails when the file is missing, damaged
+	// or was saved with other options
+	bool LoadSnapshot(const std::string& filename, int deskCount, unsigned int seed);
+
+	// upload a mesh in the passed in vertex format, fitted into
+	// the bounds of a basic mesh - returns its index
+	int AddImportedMesh(MeshImporter::IMPORTED_MESH& mesh, MESH_SHAPE fittedMesh, MeshImporter::VERTEX_FORMAT format);
+	// draw the mouse with an imported mesh (-1 = the basic sphere)
+	// and rebuild the draw list
+	void SetMouseMesh(int importedMesh);
+	int GetMouseMesh() const { return m_mouseMesh; }
+
+	// move a recorded draw - the hierarchy is refit before the next frame
+	void SetDrawTransform(int index, const glm::mat4& modelMatrix);
+	// find the draw whose bounds a ray hits first, or -1
+	int PickDraw(glm::vec3 origin, glm::vec3 direction, float& distance) const;
+
 	// load all of the needed textures before rendering
 	void LoadSceneTextures();
 
@@ -122,4 +520,5 @@ public:
 	void  RenderBooks();
 	void  RenderPencilHolder();
 	void  RenderPencils();
+	void  RenderNormalTestObjects();
 };
\ No newline at end of file
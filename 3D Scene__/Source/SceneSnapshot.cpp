@@ -0,0 +1,314 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenesnapshot.cpp
+// ============
+// write the prepared scene into a binary snapshot and map it back into memory
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SceneSnapshot.h"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+// declare the global variables
+namespace
+{
+	const unsigned int SNAPSHOT_MAGIC = 0x50534E53; // "SNSP"
+	// sections start on cache line boundaries, which keeps every
+	// record aligned for its members
+	const uint64_t SECTION_ALIGNMENT = 64;
+
+	// position and record layout of one section
+	struct SNAPSHOT_SECTION
+	{
+		uint64_t offset;
+		uint64_t count;
+		uint64_t elementSize;
+	};
+
+	// start of the file
+	struct SNAPSHOT_HEADER
+	{
+		unsigned int magic;
+		unsigned int version;
+		// size of this header, so a changed layout is rejected
+		unsigned int headerBytes;
+		unsigned int sectionCount;
+		SceneSnapshot::SNAPSHOT_SCENE scene;
+		SNAPSHOT_SECTION sections[SceneSnapshot::SECTION_COUNT];
+	};
+}
+
+/***********************************************************
+ *  SceneSnapshot()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+SceneSnapshot::SceneSnapshot()
+{
+	memset((void*)&m_scene, 0, sizeof(m_scene));
+	m_pMapped = NULL;
+	m_mappedBytes = 0;
+#ifdef _WIN32
+	m_fileHandle = (intptr_t)INVALID_HANDLE_VALUE;
+#else
+	m_fileHandle = -1;
+#endif
+	m_mappingHandle = 0;
+}
+
+/***********************************************************
+ *  ~SceneSnapshot()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+SceneSnapshot::~SceneSnapshot()
+{
+	Unmap();
+}
+
+/***********************************************************
+ *  HashBytes()
+ *
+ *  This method is used for continuing an FNV-1a hash over
+ *  the passed in bytes.  The hash is never 0, which starts
+ *  a new one.
+ ***********************************************************/
+unsigned int SceneSnapshot::HashBytes(unsigned int hash, const void* pData, size_t size)
+{
+	if (hash == 0)
+	{
+		hash = 2166136261u;
+	}
+
+	const unsigned char* pBytes = (const unsigned char*)pData;
+	for (size_t i = 0; i < size; i++)
+	{
+		hash = (hash ^ pBytes[i]) * 16777619u;
+	}
+	return((hash != 0) ? hash : 1);
+}
+
+/***********************************************************
+ *  Write()
+ *
+ *  This method is used for writing the header and then the
+ *  records of every section, each section starting on the
+ *  next aligned offset.  The offsets are known before any
+ *  record is written, so the file is written front to back
+ *  in one pass.
+ ***********************************************************/
+bool SceneSnapshot::Write(const std::string& filename, const SNAPSHOT_SCENE& scene, const SECTION_DATA sections[SECTION_COUNT])
+{
+	std::ofstream file(filename, std::ios::binary);
+	if (!file.is_open())
+	{
+		std::cout << "Could not write scene snapshot file:" << filename << std::endl;
+		return(false);
+	}
+
+	SNAPSHOT_HEADER header;
+	memset((void*)&header, 0, sizeof(header));
+	header.magic = SNAPSHOT_MAGIC;
+	header.version = VERSION;
+	header.headerBytes = sizeof(SNAPSHOT_HEADER);
+	header.sectionCount = SECTION_COUNT;
+	header.scene = scene;
+
+	uint64_t offset = sizeof(SNAPSHOT_HEADER);
+	for (int i = 0; i < SECTION_COUNT; i++)
+	{
+		offset = (offset + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT;
+		header.sections[i].offset = offset;
+		header.sections[i].count = sections[i].count;
+		header.sections[i].elementSize = sections[i].elementSize;
+		offset += (uint64_t)sections[i].count * sections[i].elementSize;
+	}
+	file.write((const char*)&header, sizeof(header));
+
+	const char padding[SECTION_ALIGNMENT] = {};
+	uint64_t written = sizeof(SNAPSHOT_HEADER);
+	for (int i = 0; i < SECTION_COUNT; i++)
+	{
+		file.write(padding, header.sections[i].offset - written);
+		size_t bytes = sections[i].count * sections[i].elementSize;
+		if (bytes > 0)
+		{
+			file.write((const char*)sections[i].pData, bytes);
+		}
+		written = header.sections[i].offset + bytes;
+	}
+
+	if (!file.good())
+	{
+		std::cout << "Could not write scene snapshot file:" << filename << std::endl;
+		return(false);
+	}
+	return(true);
+}
+
+/***********************************************************
+ *  Map()
+ *
+ *  This method is used for mapping a snapshot file into
+ *  the address space, read only.  The header is checked
+ *  against this version and every section has to lie
+ *  inside the file, but the records themselves are only
+ *  paged in when they are first read.
+ ***********************************************************/
+bool SceneSnapshot::Map(const std::string& filename)
+{
+	Unmap();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return(false);
+	}
+	LARGE_INTEGER fileSize;
+	HANDLE mapping = NULL;
+	if (GetFileSizeEx(file, &fileSize) && (fileSize.QuadPart >= (LONGLONG)sizeof(SNAPSHOT_HEADER)))
+	{
+		mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	}
+	if (mapping == NULL)
+	{
+		CloseHandle(file);
+		return(false);
+	}
+	m_fileHandle = (intptr_t)file;
+	m_mappingHandle = (intptr_t)mapping;
+	m_pMapped = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	m_mappedBytes = (size_t)fileSize.QuadPart;
+#else
+	int file = open(filename.c_str(), O_RDONLY);
+	if (file < 0)
+	{
+		return(false);
+	}
+	struct stat fileStatus;
+	if ((fstat(file, &fileStatus) != 0) || (fileStatus.st_size < (off_t)sizeof(SNAPSHOT_HEADER)))
+	{
+		close(file);
+		return(false);
+	}
+	m_fileHandle = file;
+	void* pMapped = mmap(NULL, (size_t)fileStatus.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+	m_pMapped = (pMapped != MAP_FAILED) ? (const unsigned char*)pMapped : NULL;
+	m_mappedBytes = (size_t)fileStatus.st_size;
+	if (NULL != m_pMapped)
+	{
+		// the sections are read front to back
+		madvise(pMapped, m_mappedBytes, MADV_SEQUENTIAL);
+	}
+#endif
+	if (NULL == m_pMapped)
+	{
+		Unmap();
+		return(false);
+	}
+
+	SNAPSHOT_HEADER header;
+	memcpy(&header, m_pMapped, sizeof(header));
+	bool bValid = (header.magic == SNAPSHOT_MAGIC) && (header.version == VERSION) &&
+		(header.headerBytes == sizeof(SNAPSHOT_HEADER)) && (header.sectionCount == SECTION_COUNT);
+	for (int i = 0; bValid && (i < SECTION_COUNT); i++)
+	{
+		const SNAPSHOT_SECTION& section = header.sections[i];
+		bValid = (section.offset % SECTION_ALIGNMENT == 0) && (section.offset <= m_mappedBytes) &&
+			((section.elementSize == 0) || (section.count <= (m_mappedBytes - section.offset) / section.elementSize));
+	}
+	if (!bValid)
+	{
+		Unmap();
+		return(false);
+	}
+
+	m_scene = header.scene;
+	return(true);
+}
+
+/***********************************************************
+ *  Unmap()
+ *
+ *  This method is used for releasing the mapping and the
+ *  file handles.  Data read from the sections must have
+ *  been copied or uploaded before.
+ ***********************************************************/
+void SceneSnapshot::Unmap()
+{
+#ifdef _WIN32
+	if (NULL != m_pMapped)
+	{
+		UnmapViewOfFile(m_pMapped);
+	}
+	if (m_mappingHandle != 0)
+	{
+		CloseHandle((HANDLE)m_mappingHandle);
+	}
+	if ((HANDLE)m_fileHandle != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle((HANDLE)m_fileHandle);
+	}
+	m_fileHandle = (intptr_t)INVALID_HANDLE_VALUE;
+#else
+	if (NULL != m_pMapped)
+	{
+		munmap((void*)m_pMapped, m_mappedBytes);
+	}
+	if (m_fileHandle >= 0)
+	{
+		close((int)m_fileHandle);
+	}
+	m_fileHandle = -1;
+#endif
+	m_mappingHandle = 0;
+	m_pMapped = NULL;
+	m_mappedBytes = 0;
+	memset((void*)&m_scene, 0, sizeof(m_scene));
+}
+
+/***********************************************************
+ *  GetSection()
+ *
+ *  This method is used for getting a pointer to the records
+ *  of a section inside the mapping.  Records of another
+ *  size than the caller expects mean the file was written
+ *  with a different layout, and return NULL.
+ ***********************************************************/
+const void* SceneSnapshot::GetSection(int section, size_t elementSize, size_t& count) const
+{
+	count = 0;
+	if ((NULL == m_pMapped) || (section < 0) || (section >= SECTION_COUNT))
+	{
+		return(NULL);
+	}
+
+	SNAPSHOT_HEADER header;
+	memcpy(&header, m_pMapped, sizeof(header));
+	if (header.sections[section].elementSize != elementSize)
+	{
+		return(NULL);
+	}
+
+	count = (size_t)header.sections[section].count;
+	return(m_pMapped + header.sections[section].offset);
+}
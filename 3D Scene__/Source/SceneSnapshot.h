@@ -0,0 +1,165 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenesnapshot.h
+// ============
+// write the prepared scene into a binary snapshot and map it back into memory
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/***********************************************************
+ *  SceneSnapshot
+ *
+ *  This class stores a fully prepared scene as one binary
+ *  file that is used straight from memory when read back.
+ *  A versioned header is followed by sections of plain
+ *  records - the draw packets with their world transforms,
+ *  the materials, the office lights, the imported mesh
+ *  buffers and the hierarchy over the draws - which are
+ *  found by their offset from the start of the file, so
+ *  the file holds no pointers.  Reading maps the file into
+ *  the address space instead of parsing it, and the caller
+ *  copies or uploads the sections from the mapping.  The
+ *  records are stored in the byte order and layout of the
+ *  compiler that wrote them, so a snapshot is a cache of
+ *  the generated scene and not an exchange format.
+ ***********************************************************/
+class SceneSnapshot
+{
+public:
+	// constructor
+	SceneSnapshot();
+	// destructor
+	~SceneSnapshot();
+
+	// version of the file layout - snapshots of another version
+	// are rejected and rebuilt
+	static const unsigned int VERSION = 1;
+
+	// sections of the file, in the order they are stored
+	enum SECTION
+	{
+		SECTION_DRAWS,
+		SECTION_MATERIALS,
+		SECTION_LIGHTS,
+		SECTION_MESHES,
+		SECTION_MESH_DATA,
+		SECTION_BVH_NODES,
+		SECTION_BVH_OBJECTS,
+		SECTION_BVH_BOUNDS,
+		SECTION_COUNT
+	};
+
+	// values of the scene kept in the header
+	struct SNAPSHOT_SCENE
+	{
+		// hash of the options the scene was prepared with
+		unsigned int signature;
+		// office the draws were generated for
+		int officeDeskCount;
+		unsigned int officeSeed;
+		// draws of the recorded desk, and the animated ranges in it
+		int drawsPerDesk;
+		int monitorFirst;
+		int monitorEnd;
+		int pencilFirst;
+		int pencilEnd;
+		// imported meshes of the mouse and the keyboard (-1 = none)
+		int mouseMesh;
+		int keyboardMesh;
+		// world space bounds of all the draws
+		glm::vec3 sceneBoundsMin;
+		glm::vec3 sceneBoundsMax;
+	};
+
+	// one recorded draw, with its tags replaced by table indices
+	struct SNAPSHOT_DRAW
+	{
+		glm::mat4 modelMatrix;
+		glm::mat3 normalMatrix;
+		glm::vec4 color;
+		glm::vec2 UVscale;
+		glm::vec3 boundsMin;
+		glm::vec3 boundsMax;
+		int mesh;
+		// imported mesh, material and texture slot (-1 = none)
+		int importedMesh;
+		int materialIndex;
+		int textureSlot;
+		int bUseTexture;
+	};
+
+	// values of one material, in material table order
+	struct SNAPSHOT_MATERIAL
+	{
+		glm::vec3 diffuseColor;
+		glm::vec3 specularColor;
+		float shininess;
+		float roughness;
+		glm::vec3 emissiveColor;
+		int alphaMode;
+	};
+
+	// one imported mesh - its vertices and indices are stored in
+	// the mesh data section, at offsets from the section start
+	struct SNAPSHOT_MESH
+	{
+		uint64_t vertexOffset;
+		uint64_t vertexBytes;
+		uint64_t indexOffset;
+		int indexCount;
+		int format;
+		glm::vec3 boundsMin;
+		glm::vec3 boundsMax;
+		glm::vec3 positionScale;
+		glm::vec3 positionOffset;
+	};
+
+	// records of one section to write
+	struct SECTION_DATA
+	{
+		const void* pData;
+		size_t count;
+		size_t elementSize;
+	};
+
+	// continue a hash of the options a scene is prepared with over
+	// the passed in bytes (start from 0 for a new hash)
+	static unsigned int HashBytes(unsigned int hash, const void* pData, size_t size);
+
+	// write a scene and its sections into a file
+	static bool Write(const std::string& filename, const SNAPSHOT_SCENE& scene, const SECTION_DATA sections[SECTION_COUNT]);
+
+	// map a snapshot file into memory - fails when it is missing,
+	// damaged or of another version
+	bool Map(const std::string& filename);
+	// release the mapping, invalidating the sections
+	void Unmap();
+
+	// get the scene values of the mapped snapshot
+	const SNAPSHOT_SCENE& GetScene() const { return m_scene; }
+	// get the records of a mapped section and their number, or
+	// NULL when its records are not of the passed in size
+	const void* GetSection(int section, size_t elementSize, size_t& count) const;
+	template<class T> const T* GetSection(int section, size_t& count) const
+	{
+		return((const T*)GetSection(section, sizeof(T), count));
+	}
+	// get the size of the mapped file in bytes
+	size_t GetMappedBytes() const { return m_mappedBytes; }
+
+private:
+	// scene values copied out of the header
+	SNAPSHOT_SCENE m_scene;
+	// start and size of the mapped file
+	const unsigned char* m_pMapped;
+	size_t m_mappedBytes;
+	// platform handles keeping the mapping open
+	intptr_t m_fileHandle;
+	intptr_t m_mappingHandle;
+};
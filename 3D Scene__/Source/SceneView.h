@@ -0,0 +1,34 @@
+///////////////////////////////////////////////////////////////////////////////
+// sceneview.h
+// ============
+// camera and viewport rectangle of one view rendered into the frame
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <string>
+
+/***********************************************************
+ *  SCENE_VIEW
+ *
+ *  This structure holds the camera of one view and the
+ *  rectangle of the framebuffer it is rendered into.  The
+ *  view manager builds one per view each frame, and the
+ *  scene manager renders all of them within the same frame.
+ ***********************************************************/
+struct SCENE_VIEW
+{
+	// name used in the timing reports
+	std::string name;
+	// camera matrices and world position
+	glm::mat4 view;
+	glm::mat4 projection;
+	glm::vec3 position;
+	// viewport rectangle in framebuffer pixels
+	int x;
+	int y;
+	int width;
+	int height;
+};
@@ -0,0 +1,498 @@
+///////////////////////////////////////////////////////////////////////////////
+// shadowmanager.cpp
+// ============
+// manage the shadow maps rendered from the shadow casting scene lights
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ShadowManager.h"
+
+#include <glm/gtx/transform.hpp>
+
+#include <iostream>
+#include <string>
+
+// declare the global variables
+namespace
+{
+	const char* g_LightSpaceName = "lightSpaceMatrix";
+
+	// available shadow quality tiers - tier 0 turns shadows off
+	const ShadowManager::SHADOW_QUALITY g_QualityTiers[] =
+	{
+		{ "off",    0,    0, 0 },
+		{ "low",    1024, 1, 0 },
+		{ "medium", 2048, 2, 1 },
+		{ "high",   2048, 3, 1 },
+		{ "ultra",  4096, 4, 2 }
+	};
+	const int TOTAL_QUALITY_TIERS = sizeof(g_QualityTiers) / sizeof(g_QualityTiers[0]);
+
+	// blend between uniform and logarithmic cascade splits
+	const float CASCADE_SPLIT_LAMBDA = 0.75f;
+	// extra depth range kept around the scene in light space
+	const float LIGHT_DEPTH_PADDING = 1.0f;
+
+	// get the 8 corner points of an axis aligned box
+	void GetBoxCorners(glm::vec3 boxMin, glm::vec3 boxMax, glm::vec3 corners[8])
+	{
+		for (int i = 0; i < 8; i++)
+		{
+			corners[i] = glm::vec3(
+				(i & 1) ? boxMax.x : boxMin.x,
+				(i & 2) ? boxMax.y : boxMin.y,
+				(i & 4) ? boxMax.z : boxMin.z);
+		}
+	}
+}
+
+/***********************************************************
+ *  ShadowManager()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ShadowManager::ShadowManager(ShaderManager* pDepthShaderManager)
+{
+	m_pDepthShaderManager = pDepthShaderManager;
+	m_quality = 0;
+	m_framebuffer = 0;
+	m_depthTexture = 0;
+	m_savedFramebuffer = 0;
+	for (int i = 0; i < MAX_CASCADES; i++)
+	{
+		m_cascadeMatrices[i] = glm::mat4(1.0f);
+		m_cascadeSplits[i] = 0.0f;
+	}
+	m_spotLightMatrix = glm::mat4(1.0f);
+	m_cascadeView = glm::mat4(1.0f);
+	for (int i = 0; i < 4; i++)
+	{
+		m_savedViewport[i] = 0;
+	}
+}
+
+/***********************************************************
+ *  ~ShadowManager()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ShadowManager::~ShadowManager()
+{
+	DestroyShadowMap();
+	m_pDepthShaderManager = NULL;
+}
+
+/***********************************************************
+ *  GetQualityTierCount()
+ *
+ *  This method is used for getting the number of shadow
+ *  quality tiers that can be selected.
+ ***********************************************************/
+int ShadowManager::GetQualityTierCount()
+{
+	return(TOTAL_QUALITY_TIERS);
+}
+
+/***********************************************************
+ *  GetQualityTier()
+ *
+ *  This method is used for getting the properties of the
+ *  passed in shadow quality tier.
+ ***********************************************************/
+const ShadowManager::SHADOW_QUALITY& ShadowManager::GetQualityTier(int tier)
+{
+	tier = glm::clamp(tier, 0, TOTAL_QUALITY_TIERS - 1);
+	return(g_QualityTiers[tier]);
+}
+
+/***********************************************************
+ *  SetQuality()
+ *
+ *  This method is used for selecting a shadow quality tier.
+ *  The shadow map is recreated only when the resolution or
+ *  the number of layers changes.
+ ***********************************************************/
+void ShadowManager::SetQuality(int tier)
+{
+	tier = glm::clamp(tier, 0, TOTAL_QUALITY_TIERS - 1);
+
+	const SHADOW_QUALITY& previous = g_QualityTiers[m_quality];
+	const SHADOW_QUALITY& selected = g_QualityTiers[tier];
+	bool bRecreate = (m_depthTexture == 0) ||
+		(previous.resolution != selected.resolution) ||
+		(previous.cascadeCount != selected.cascadeCount);
+
+	m_quality = tier;
+	if (bRecreate)
+	{
+		DestroyShadowMap();
+		CreateShadowMap();
+	}
+
+	std::cout << "INFO: Shadow quality set to " << selected.name
+		<< " (" << selected.resolution << "x" << selected.resolution
+		<< ", " << selected.cascadeCount << " cascades, PCF radius "
+		<< selected.pcfRadius << ")" << std::endl;
+}
+
+/***********************************************************
+ *  GetLayerCount()
+ *
+ *  This method is used for getting the number of depth
+ *  layers - one per cascade plus one for the spot light.
+ ***********************************************************/
+int ShadowManager::GetLayerCount() const
+{
+	if (m_depthTexture == 0)
+	{
+		return(0);
+	}
+	return(g_QualityTiers[m_quality].cascadeCount + 1);
+}
+
+/***********************************************************
+ *  GetSpotLightLayer()
+ *
+ *  This method is used for getting the depth layer that
+ *  holds the spot light shadow map.
+ ***********************************************************/
+int ShadowManager::GetSpotLightLayer() const
+{
+	return(g_QualityTiers[m_quality].cascadeCount);
+}
+
+/***********************************************************
+ *  CreateShadowMap()
+ *
+ *  This method is used for creating the layered depth texture
+ *  and the framebuffer for the selected quality tier.  The
+ *  texture is configured for hardware depth comparison so
+ *  that every shadow lookup is already a 2x2 filtered test.
+ ***********************************************************/
+void ShadowManager::CreateShadowMap()
+{
+	const SHADOW_QUALITY& tier = g_QualityTiers[m_quality];
+	if (tier.resolution == 0)
+	{
+		return;
+	}
+
+	int layers = tier.cascadeCount + 1;
+
+	glGenTextures(1, &m_depthTexture);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, m_depthTexture);
+	glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT24,
+		tier.resolution, tier.resolution, layers,
+		0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+	// anything outside of the shadow map is treated as lit
+	float borderColor[] = { 1.0f, 1.0f, 1.0f, 1.0f };
+	glTexParameterfv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BORDER_COLOR, borderColor);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+	// the tier can change mid-frame, so keep the current target bound
+	GLint currentFramebuffer = 0;
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &currentFramebuffer);
+
+	glGenFramebuffers(1, &m_framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, m_depthTexture, 0, 0);
+	// depth only - there is no color attachment to write to
+	glDrawBuffer(GL_NONE);
+	glReadBuffer(GL_NONE);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "Shadow map framebuffer is not complete" << std::endl;
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, currentFramebuffer);
+}
+
+/***********************************************************
+ *  DestroyShadowMap()
+ *
+ *  This method is used for freeing the depth texture and the
+ *  framebuffer of the shadow map.
+ ***********************************************************/
+void ShadowManager::DestroyShadowMap()
+{
+	if (m_framebuffer != 0)
+	{
+		glDeleteFramebuffers(1, &m_framebuffer);
+		m_framebuffer = 0;
+	}
+	if (m_depthTexture != 0)
+	{
+		glDeleteTextures(1, &m_depthTexture);
+		m_depthTexture = 0;
+	}
+}
+
+/***********************************************************
+ *  UpdateDirectionalCascades()
+ *
+ *  This method is used for splitting the camera frustum into
+ *  cascades and fitting an orthographic light projection to
+ *  each one.  The frustum is cut off where the scene geometry
+ *  ends and every cascade is clipped to the scene bounds, so
+ *  the shadow map texels are only spent on the table extent.
+ ***********************************************************/
+void ShadowManager::UpdateDirectionalCascades(
+	const glm::mat4& view,
+	const glm::mat4& projection,
+	glm::vec3 lightDirection,
+	glm::vec3 sceneMin,
+	glm::vec3 sceneMax)
+{
+	// the split depths are measured in this camera's view space
+	m_cascadeView = view;
+
+	if (m_depthTexture == 0)
+	{
+		return;
+	}
+
+	const SHADOW_QUALITY& tier = g_QualityTiers[m_quality];
+
+	// get the world space corners of the near and far planes
+	glm::mat4 inverseViewProjection = glm::inverse(projection * view);
+	glm::vec3 nearCorners[4];
+	glm::vec3 farCorners[4];
+	for (int i = 0; i < 4; i++)
+	{
+		float x = (i & 1) ? 1.0f : -1.0f;
+		float y = (i & 2) ? 1.0f : -1.0f;
+		glm::vec4 nearPoint = inverseViewProjection * glm::vec4(x, y, -1.0f, 1.0f);
+		glm::vec4 farPoint = inverseViewProjection * glm::vec4(x, y, 1.0f, 1.0f);
+		nearCorners[i] = glm::vec3(nearPoint) / nearPoint.w;
+		farCorners[i] = glm::vec3(farPoint) / farPoint.w;
+	}
+	float nearDepth = -(view * glm::vec4(nearCorners[0], 1.0f)).z;
+	float farDepth = -(view * glm::vec4(farCorners[0], 1.0f)).z;
+
+	// stop the cascades at the furthest point of the scene
+	glm::vec3 sceneCorners[8];
+	GetBoxCorners(sceneMin, sceneMax, sceneCorners);
+	float sceneDepth = nearDepth;
+	for (int i = 0; i < 8; i++)
+	{
+		sceneDepth = glm::max(sceneDepth, -(view * glm::vec4(sceneCorners[i], 1.0f)).z);
+	}
+	float shadowFar = glm::clamp(sceneDepth, nearDepth + 0.01f, farDepth);
+
+	// one light view shared by all cascades, looking at the scene
+	glm::vec3 lightDir = glm::normalize(lightDirection);
+	glm::vec3 sceneCenter = (sceneMin + sceneMax) * 0.5f;
+	float sceneRadius = glm::length(sceneMax - sceneMin) * 0.5f;
+	glm::vec3 lightUp = glm::vec3(0.0f, 1.0f, 0.0f);
+	if (glm::abs(glm::dot(lightDir, lightUp)) > 0.99f)
+	{
+		lightUp = glm::vec3(0.0f, 0.0f, 1.0f);
+	}
+	glm::mat4 lightView = glm::lookAt(sceneCenter - lightDir * sceneRadius * 2.0f, sceneCenter, lightUp);
+
+	// bounds of the whole scene as seen from the light
+	glm::vec3 sceneLightMin = glm::vec3(1.0e30f);
+	glm::vec3 sceneLightMax = glm::vec3(-1.0e30f);
+	for (int i = 0; i < 8; i++)
+	{
+		glm::vec3 corner = glm::vec3(lightView * glm::vec4(sceneCorners[i], 1.0f));
+		sceneLightMin = glm::min(sceneLightMin, corner);
+		sceneLightMax = glm::max(sceneLightMax, corner);
+	}
+
+	float previousSplit = nearDepth;
+	for (int cascade = 0; cascade < tier.cascadeCount; cascade++)
+	{
+		// practical split scheme - a blend of uniform and log splits
+		float fraction = (float)(cascade + 1) / (float)tier.cascadeCount;
+		float uniformSplit = nearDepth + (shadowFar - nearDepth) * fraction;
+		float logSplit = nearDepth * glm::pow(shadowFar / nearDepth, fraction);
+		float split = glm::mix(uniformSplit, logSplit, CASCADE_SPLIT_LAMBDA);
+		if (cascade == tier.cascadeCount - 1)
+		{
+			split = shadowFar;
+		}
+
+		// corners of this slice of the camera frustum in light space
+		float t0 = (previousSplit - nearDepth) / (farDepth - nearDepth);
+		float t1 = (split - nearDepth) / (farDepth - nearDepth);
+		glm::vec3 sliceMin = glm::vec3(1.0e30f);
+		glm::vec3 sliceMax = glm::vec3(-1.0e30f);
+		for (int i = 0; i < 4; i++)
+		{
+			glm::vec3 sliceNear = glm::vec3(lightView * glm::vec4(glm::mix(nearCorners[i], farCorners[i], t0), 1.0f));
+			glm::vec3 sliceFar = glm::vec3(lightView * glm::vec4(glm::mix(nearCorners[i], farCorners[i], t1), 1.0f));
+			sliceMin = glm::min(sliceMin, glm::min(sliceNear, sliceFar));
+			sliceMax = glm::max(sliceMax, glm::max(sliceNear, sliceFar));
+		}
+
+		// clip the slice to the scene extent when they overlap
+		glm::vec3 fitMin = glm::max(sliceMin, sceneLightMin);
+		glm::vec3 fitMax = glm::min(sliceMax, sceneLightMax);
+		if ((fitMin.x >= fitMax.x) || (fitMin.y >= fitMax.y))
+		{
+			fitMin = sliceMin;
+			fitMax = sliceMax;
+		}
+
+		// snap the extent to whole texels to keep edges from shimmering
+		float texelSize = glm::max(fitMax.x - fitMin.x, fitMax.y - fitMin.y) / tier.resolution;
+		if (texelSize > 0.0f)
+		{
+			fitMin.x = glm::floor(fitMin.x / texelSize) * texelSize;
+			fitMin.y = glm::floor(fitMin.y / texelSize) * texelSize;
+			fitMax.x = glm::ceil(fitMax.x / texelSize) * texelSize;
+			fitMax.y = glm::ceil(fitMax.y / texelSize) * texelSize;
+		}
+
+		// every caster in the scene has to fit in the depth range
+		glm::mat4 lightProjection = glm::ortho(
+			fitMin.x, fitMax.x, fitMin.y, fitMax.y,
+			-sceneLightMax.z - LIGHT_DEPTH_PADDING,
+			-sceneLightMin.z + LIGHT_DEPTH_PADDING);
+
+		m_cascadeMatrices[cascade] = lightProjection * lightView;
+		m_cascadeSplits[cascade] = split;
+		previousSplit = split;
+	}
+}
+
+/***********************************************************
+ *  UpdateSpotLight()
+ *
+ *  This method is used for fitting a perspective projection
+ *  to the cone of the spot light.
+ ***********************************************************/
+void ShadowManager::UpdateSpotLight(
+	glm::vec3 position,
+	glm::vec3 direction,
+	float outerCutOff,
+	float range)
+{
+	glm::vec3 lightDir = glm::normalize(direction);
+	glm::vec3 lightUp = glm::vec3(0.0f, 1.0f, 0.0f);
+	if (glm::abs(glm::dot(lightDir, lightUp)) > 0.99f)
+	{
+		lightUp = glm::vec3(0.0f, 0.0f, 1.0f);
+	}
+
+	// the field of view covers the outer cone with a small margin
+	float fieldOfView = 2.0f * glm::acos(outerCutOff) + glm::radians(5.0f);
+	glm::mat4 lightProjection = glm::perspective(fieldOfView, 1.0f, 0.1f, glm::max(range, 1.0f));
+	glm::mat4 lightView = glm::lookAt(position, position + lightDir, lightUp);
+
+	m_spotLightMatrix = lightProjection * lightView;
+}
+
+/***********************************************************
+ *  BeginDepthPass()
+ *
+ *  This method is used for starting the depth-only pass into
+ *  the shadow map.  Polygon offset pushes the stored depths
+ *  back a little to avoid shadow acne on lit surfaces.
+ ***********************************************************/
+void ShadowManager::BeginDepthPass()
+{
+	glGetIntegerv(GL_VIEWPORT, m_savedViewport);
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &m_savedFramebuffer);
+
+	const SHADOW_QUALITY& tier = g_QualityTiers[m_quality];
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	glViewport(0, 0, tier.resolution, tier.resolution);
+	glEnable(GL_POLYGON_OFFSET_FILL);
+	glPolygonOffset(2.0f, 4.0f);
+
+	if (NULL != m_pDepthShaderManager)
+	{
+		m_pDepthShaderManager->use();
+	}
+}
+
+/***********************************************************
+ *  BeginLayer()
+ *
+ *  This method is used for binding one layer of the shadow
+ *  map as the depth target and loading its light matrix.
+ ***********************************************************/
+void ShadowManager::BeginLayer(int layer)
+{
+	glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, m_depthTexture, 0, layer);
+	glClear(GL_DEPTH_BUFFER_BIT);
+
+	if (NULL != m_pDepthShaderManager)
+	{
+		m_pDepthShaderManager->setMat4Value(g_LightSpaceName, GetLayerMatrix(layer));
+	}
+}
+
+/***********************************************************
+ *  GetLayerMatrix()
+ *
+ *  This method is used for getting the light view-projection
+ *  matrix a depth layer is rendered with - a cascade of the
+ *  directional light, or the spot light.
+ ***********************************************************/
+glm::mat4 ShadowManager::GetLayerMatrix(int layer) const
+{
+	if (layer < GetSpotLightLayer())
+	{
+		return(m_cascadeMatrices[layer]);
+	}
+	return(m_spotLightMatrix);
+}
+
+/***********************************************************
+ *  EndDepthPass()
+ *
+ *  This method is used for finishing the depth-only pass and
+ *  returning to the framebuffer bound before it.
+ ***********************************************************/
+void ShadowManager::EndDepthPass()
+{
+	glDisable(GL_POLYGON_OFFSET_FILL);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_savedFramebuffer);
+	glViewport(m_savedViewport[0], m_savedViewport[1], m_savedViewport[2], m_savedViewport[3]);
+}
+
+/***********************************************************
+ *  ApplyToShader()
+ *
+ *  This method is used for binding the shadow map to the
+ *  passed in texture unit and setting the shadow uniforms
+ *  of the lighting shader.  The sampler is always set so it
+ *  never aliases the texture unit of a scene texture.
+ ***********************************************************/
+void ShadowManager::ApplyToShader(ShaderManager* pShaderManager, int textureUnit)
+{
+	if (NULL == pShaderManager)
+	{
+		return;
+	}
+
+	const SHADOW_QUALITY& tier = g_QualityTiers[m_quality];
+
+	glActiveTexture(GL_TEXTURE0 + textureUnit);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, m_depthTexture);
+	pShaderManager->setIntValue("shadowMap", textureUnit);
+	pShaderManager->setBoolValue("bUseShadows", IsEnabled());
+	pShaderManager->setMat4Value("cascadeView", m_cascadeView);
+	if (!IsEnabled())
+	{
+		return;
+	}
+
+	pShaderManager->setIntValue("cascadeCount", tier.cascadeCount);
+	pShaderManager->setIntValue("pcfRadius", tier.pcfRadius);
+	pShaderManager->setIntValue("spotShadowLayer", GetSpotLightLayer());
+	pShaderManager->setMat4Value("spotLightSpace", m_spotLightMatrix);
+	for (int i = 0; i < tier.cascadeCount; i++)
+	{
+		std::string index = std::to_string(i);
+		pShaderManager->setMat4Value("cascadeLightSpace[" + index + "]", m_cascadeMatrices[i]);
+		pShaderManager->setFloatValue("cascadeSplits[" + index + "]", m_cascadeSplits[i]);
+	}
+}
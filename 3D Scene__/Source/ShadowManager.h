@@ -0,0 +1,117 @@
+///////////////////////////////////////////////////////////////////////////////
+// shadowmanager.h
+// ============
+// manage the shadow maps rendered from the shadow casting scene lights
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderManager.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+/***********************************************************
+ *  ShadowManager
+ *
+ *  This class owns the depth-only framebuffer and the layered
+ *  depth texture used for shadow mapping.  The directional
+ *  light is covered by cascaded splits of the camera frustum
+ *  and the spot light uses one perspective layer after the
+ *  cascades.  Resolution and cascade count come from a table
+ *  of quality tiers that can be changed at runtime.
+ ***********************************************************/
+class ShadowManager
+{
+public:
+	// constructor
+	ShadowManager(ShaderManager* pDepthShaderManager);
+	// destructor
+	~ShadowManager();
+
+	// maximum number of directional light cascades
+	static const int MAX_CASCADES = 4;
+
+	// properties for a shadow quality tier
+	struct SHADOW_QUALITY
+	{
+		const char* name;
+		int resolution;
+		int cascadeCount;
+		int pcfRadius;
+	};
+
+	// get the number of available quality tiers
+	static int GetQualityTierCount();
+	// get the properties of a quality tier
+	static const SHADOW_QUALITY& GetQualityTier(int tier);
+
+	// select a quality tier and recreate the shadow map for it
+	void SetQuality(int tier);
+	// get the selected quality tier
+	int GetQuality() const { return m_quality; }
+	// check whether shadows are rendered for the selected tier
+	bool IsEnabled() const { return m_depthTexture != 0; }
+
+	// get the number of depth layers rendered each frame
+	int GetLayerCount() const;
+	// get the depth layer used by the spot light
+	int GetSpotLightLayer() const;
+
+	// fit the cascade projections to the camera frustum, clipped
+	// to the bounds of the shadow casting scene geometry
+	void UpdateDirectionalCascades(
+		const glm::mat4& view,
+		const glm::mat4& projection,
+		glm::vec3 lightDirection,
+		glm::vec3 sceneMin,
+		glm::vec3 sceneMax);
+
+	// fit the spot light projection to its cone
+	void UpdateSpotLight(
+		glm::vec3 position,
+		glm::vec3 direction,
+		float outerCutOff,
+		float range);
+
+	// start the depth-only pass - saves the current viewport
+	// and framebuffer
+	void BeginDepthPass();
+	// bind a depth layer and load its light space matrix
+	void BeginLayer(int layer);
+	// get the light view-projection matrix of a depth layer
+	glm::mat4 GetLayerMatrix(int layer) const;
+	// finish the depth-only pass and restore the viewport
+	// and framebuffer
+	void EndDepthPass();
+
+	// pass the shadow map and light matrices into the lighting shader
+	void ApplyToShader(ShaderManager* pShaderManager, int textureUnit);
+
+private:
+	// create the depth texture and framebuffer for the selected tier
+	void CreateShadowMap();
+	// free the depth texture and framebuffer
+	void DestroyShadowMap();
+
+	// pointer to the depth-only shader
+	ShaderManager* m_pDepthShaderManager;
+	// selected quality tier
+	int m_quality;
+	// framebuffer used for rendering the depth layers
+	GLuint m_framebuffer;
+	// layered depth texture - cascades followed by the spot light
+	GLuint m_depthTexture;
+	// light space matrices for the cascades
+	glm::mat4 m_cascadeMatrices[MAX_CASCADES];
+	// view space depth where each cascade ends
+	float m_cascadeSplits[MAX_CASCADES];
+	// view of the camera the cascades were fitted to
+	glm::mat4 m_cascadeView;
+	// light space matrix for the spot light
+	glm::mat4 m_spotLightMatrix;
+	// viewport saved at the start of the depth pass
+	GLint m_savedViewport[4];
+	// framebuffer bound at the start of the depth pass
+	GLint m_savedFramebuffer;
+};
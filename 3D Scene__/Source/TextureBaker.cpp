@@ -0,0 +1,282 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturebaker.cpp
+// ============
+// encode the scene images into block compressed .dds textures
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TextureBaker.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdlib>
+#include <iostream>
+
+// declare the global variables
+namespace
+{
+	// pack a color into the 5:6:5 bits of a BC1 endpoint
+	unsigned short PackColor565(glm::vec3 color)
+	{
+		int r = (int)(glm::clamp(color.x, 0.0f, 255.0f) * 31.0f / 255.0f + 0.5f);
+		int g = (int)(glm::clamp(color.y, 0.0f, 255.0f) * 63.0f / 255.0f + 0.5f);
+		int b = (int)(glm::clamp(color.z, 0.0f, 255.0f) * 31.0f / 255.0f + 0.5f);
+		return (unsigned short)((r << 11) | (g << 5) | b);
+	}
+
+	// expand the 5:6:5 bits of a BC1 endpoint back to 8 bits
+	glm::vec3 UnpackColor565(unsigned short color)
+	{
+		int r = (color >> 11) & 31;
+		int g = (color >> 5) & 63;
+		int b = color & 31;
+		return glm::vec3((r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2));
+	}
+}
+
+/***********************************************************
+ *  BakeTexture()
+ *
+ *  This method is used for loading an image, encoding its
+ *  mip chain and writing the baked .dds file next to it.
+ ***********************************************************/
+bool TextureBaker::BakeTexture(const std::string& filename)
+{
+	TextureStreamer::TEXTURE_FORMAT sourceFormat;
+	std::vector<TextureStreamer::MIP_LEVEL> sourceLevels;
+	if (!TextureStreamer::LoadImageLevels(filename, sourceFormat, sourceLevels))
+	{
+		std::cout << "Could not load image:" << filename << std::endl;
+		return(false);
+	}
+
+	TextureStreamer::TEXTURE_FORMAT format;
+	std::vector<TextureStreamer::MIP_LEVEL> levels;
+	CompressLevels(sourceFormat, sourceLevels, format, levels);
+
+	std::string bakedFilename = TextureStreamer::GetBakedFilename(filename);
+	if (!TextureStreamer::SaveDDSLevels(bakedFilename, format, levels))
+	{
+		return(false);
+	}
+
+	size_t sourceBytes = 0;
+	size_t bakedBytes = 0;
+	for (int i = 0; i < (int)levels.size(); i++)
+	{
+		sourceBytes += sourceLevels[i].data.size();
+		bakedBytes += levels[i].data.size();
+	}
+	std::cout << "INFO: Baked " << bakedFilename << " as " << ((format == TextureStreamer::FORMAT_BC3) ? "BC3" : "BC1")
+		<< ", " << bakedBytes / 1024 << " KB from " << sourceBytes / 1024 << " KB" << std::endl;
+	return(true);
+}
+
+/***********************************************************
+ *  CompressLevels()
+ *
+ *  This method is used for encoding every uncompressed level
+ *  block by block.  The blocks at the right and top edges of
+ *  levels smaller than 4 pixels repeat the last pixels.
+ ***********************************************************/
+void TextureBaker::CompressLevels(
+	TextureStreamer::TEXTURE_FORMAT sourceFormat,
+	const std::vector<TextureStreamer::MIP_LEVEL>& sourceLevels,
+	TextureStreamer::TEXTURE_FORMAT& format,
+	std::vector<TextureStreamer::MIP_LEVEL>& levels)
+{
+	bool bAlpha = (sourceFormat == TextureStreamer::FORMAT_RGBA8);
+	int channels = bAlpha ? 4 : 3;
+	int blockBytes = bAlpha ? 16 : 8;
+	format = bAlpha ? TextureStreamer::FORMAT_BC3 : TextureStreamer::FORMAT_BC1;
+
+	levels.resize(sourceLevels.size());
+	for (int i = 0; i < (int)sourceLevels.size(); i++)
+	{
+		const TextureStreamer::MIP_LEVEL& source = sourceLevels[i];
+		TextureStreamer::MIP_LEVEL& level = levels[i];
+		level.width = source.width;
+		level.height = source.height;
+		level.data.resize(TextureStreamer::GetLevelBytes(format, source.width, source.height));
+
+		int blocksX = (source.width + 3) / 4;
+		int blocksY = (source.height + 3) / 4;
+		for (int by = 0; by < blocksY; by++)
+		{
+			for (int bx = 0; bx < blocksX; bx++)
+			{
+				unsigned char pixels[16][4];
+				for (int p = 0; p < 16; p++)
+				{
+					int x = glm::min(bx * 4 + (p & 3), source.width - 1);
+					int y = glm::min(by * 4 + (p >> 2), source.height - 1);
+					const unsigned char* pSource = &source.data[((size_t)y * source.width + x) * channels];
+					pixels[p][0] = pSource[0];
+					pixels[p][1] = pSource[1];
+					pixels[p][2] = pSource[2];
+					pixels[p][3] = bAlpha ? pSource[3] : 255;
+				}
+
+				unsigned char* pBlock = &level.data[((size_t)by * blocksX + bx) * blockBytes];
+				if (bAlpha)
+				{
+					EncodeAlphaBlock(pixels, pBlock);
+					pBlock += 8;
+				}
+				EncodeColorBlock(pixels, pBlock);
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  EncodeColorBlock()
+ *
+ *  This method is used for encoding the colors of a block.
+ *  The endpoints are the extremes of the pixels along their
+ *  principal axis, found with a few power iterations, and
+ *  every pixel picks the nearest of the four palette colors.
+ ***********************************************************/
+void TextureBaker::EncodeColorBlock(const unsigned char pixels[16][4], unsigned char* pBlock)
+{
+	glm::vec3 colors[16];
+	glm::vec3 mean = glm::vec3(0.0f);
+	for (int p = 0; p < 16; p++)
+	{
+		colors[p] = glm::vec3(pixels[p][0], pixels[p][1], pixels[p][2]);
+		mean += colors[p];
+	}
+	mean /= 16.0f;
+
+	float covariance[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+	for (int p = 0; p < 16; p++)
+	{
+		glm::vec3 d = colors[p] - mean;
+		covariance[0] += d.x * d.x;
+		covariance[1] += d.x * d.y;
+		covariance[2] += d.x * d.z;
+		covariance[3] += d.y * d.y;
+		covariance[4] += d.y * d.z;
+		covariance[5] += d.z * d.z;
+	}
+
+	glm::vec3 axis = glm::vec3(1.0f, 1.0f, 1.0f);
+	for (int i = 0; i < 4; i++)
+	{
+		axis = glm::vec3(
+			covariance[0] * axis.x + covariance[1] * axis.y + covariance[2] * axis.z,
+			covariance[1] * axis.x + covariance[3] * axis.y + covariance[4] * axis.z,
+			covariance[2] * axis.x + covariance[4] * axis.y + covariance[5] * axis.z);
+		float length = glm::length(axis);
+		if (length < 1.0e-6f)
+		{
+			axis = glm::vec3(0.0f);
+			break;
+		}
+		axis /= length;
+	}
+
+	float minT = 0.0f;
+	float maxT = 0.0f;
+	for (int p = 0; p < 16; p++)
+	{
+		float t = glm::dot(colors[p] - mean, axis);
+		minT = glm::min(minT, t);
+		maxT = glm::max(maxT, t);
+	}
+
+	unsigned short color0 = PackColor565(mean + axis * maxT);
+	unsigned short color1 = PackColor565(mean + axis * minT);
+	// the larger endpoint first selects the four color mode
+	if (color0 < color1)
+	{
+		unsigned short swap = color0;
+		color0 = color1;
+		color1 = swap;
+	}
+
+	unsigned int indices = 0;
+	if (color0 != color1)
+	{
+		glm::vec3 palette[4];
+		palette[0] = UnpackColor565(color0);
+		palette[1] = UnpackColor565(color1);
+		palette[2] = (palette[0] * 2.0f + palette[1]) / 3.0f;
+		palette[3] = (palette[0] + palette[1] * 2.0f) / 3.0f;
+
+		for (int p = 0; p < 16; p++)
+		{
+			int best = 0;
+			float bestDistance = 0.0f;
+			for (int c = 0; c < 4; c++)
+			{
+				glm::vec3 d = colors[p] - palette[c];
+				float distance = glm::dot(d, d);
+				if ((c == 0) || (distance < bestDistance))
+				{
+					best = c;
+					bestDistance = distance;
+				}
+			}
+			indices |= (unsigned int)best << (p * 2);
+		}
+	}
+
+	pBlock[0] = (unsigned char)(color0 & 0xFF);
+	pBlock[1] = (unsigned char)(color0 >> 8);
+	pBlock[2] = (unsigned char)(color1 & 0xFF);
+	pBlock[3] = (unsigned char)(color1 >> 8);
+	pBlock[4] = (unsigned char)(indices & 0xFF);
+	pBlock[5] = (unsigned char)((indices >> 8) & 0xFF);
+	pBlock[6] = (unsigned char)((indices >> 16) & 0xFF);
+	pBlock[7] = (unsigned char)(indices >> 24);
+}
+
+/***********************************************************
+ *  EncodeAlphaBlock()
+ *
+ *  This method is used for encoding the alpha of a block
+ *  with its extremes as endpoints and the six values in
+ *  between, each pixel picking the nearest of the eight.
+ ***********************************************************/
+void TextureBaker::EncodeAlphaBlock(const unsigned char pixels[16][4], unsigned char* pBlock)
+{
+	int alpha0 = 0;
+	int alpha1 = 255;
+	for (int p = 0; p < 16; p++)
+	{
+		alpha0 = glm::max(alpha0, (int)pixels[p][3]);
+		alpha1 = glm::min(alpha1, (int)pixels[p][3]);
+	}
+
+	unsigned long long indices = 0;
+	if (alpha0 != alpha1)
+	{
+		int palette[8];
+		palette[0] = alpha0;
+		palette[1] = alpha1;
+		for (int i = 1; i < 7; i++)
+		{
+			palette[i + 1] = ((7 - i) * alpha0 + i * alpha1 + 3) / 7;
+		}
+
+		for (int p = 0; p < 16; p++)
+		{
+			int best = 0;
+			for (int c = 1; c < 8; c++)
+			{
+				if (abs(pixels[p][3] - palette[c]) < abs(pixels[p][3] - palette[best]))
+				{
+					best = c;
+				}
+			}
+			indices |= (unsigned long long)best << (p * 3);
+		}
+	}
+
+	pBlock[0] = (unsigned char)alpha0;
+	pBlock[1] = (unsigned char)alpha1;
+	for (int i = 0; i < 6; i++)
+	{
+		pBlock[2 + i] = (unsigned char)((indices >> (i * 8)) & 0xFF);
+	}
+}
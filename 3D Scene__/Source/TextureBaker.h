@@ -0,0 +1,43 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturebaker.h
+// ============
+// encode the scene images into block compressed .dds textures
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "TextureStreamer.h"
+
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  TextureBaker
+ *
+ *  This class encodes images offline into block compressed
+ *  textures.  Images without alpha are encoded as BC1 at 8
+ *  bytes and images with alpha as BC3 at 16 bytes per 4x4
+ *  block, with the complete mip chain.  The baked file is
+ *  written next to the image, where the texture streamer
+ *  picks it up instead of the image.  BC7 files from other
+ *  tools load as well, but are not encoded here.
+ ***********************************************************/
+class TextureBaker
+{
+public:
+	// encode the passed in image into its baked .dds file
+	static bool BakeTexture(const std::string& filename);
+
+	// encode the uncompressed levels into BC1 or BC3 levels
+	static void CompressLevels(
+		TextureStreamer::TEXTURE_FORMAT sourceFormat,
+		const std::vector<TextureStreamer::MIP_LEVEL>& sourceLevels,
+		TextureStreamer::TEXTURE_FORMAT& format,
+		std::vector<TextureStreamer::MIP_LEVEL>& levels);
+
+private:
+	// encode the colors of a 4x4 block into 8 bytes
+	static void EncodeColorBlock(const unsigned char pixels[16][4], unsigned char* pBlock);
+	// encode the alpha of a 4x4 block into 8 bytes
+	static void EncodeAlphaBlock(const unsigned char pixels[16][4], unsigned char* pBlock);
+};
@@ -0,0 +1,691 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturestreamer.cpp
+// ============
+// load block compressed textures and stream their mip levels within a budget
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TextureStreamer.h"
+
+#include "stb_image.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+// declare the global variables
+namespace
+{
+	// DDS header flags and the DXGI formats of the DX10 extension
+	const uint32_t DDS_MAGIC = 0x20534444;
+	const uint32_t DDSD_CAPS = 0x1;
+	const uint32_t DDSD_HEIGHT = 0x2;
+	const uint32_t DDSD_WIDTH = 0x4;
+	const uint32_t DDSD_PIXELFORMAT = 0x1000;
+	const uint32_t DDSD_MIPMAPCOUNT = 0x20000;
+	const uint32_t DDSD_LINEARSIZE = 0x80000;
+	const uint32_t DDPF_FOURCC = 0x4;
+	const uint32_t DDSCAPS_COMPLEX = 0x8;
+	const uint32_t DDSCAPS_TEXTURE = 0x1000;
+	const uint32_t DDSCAPS_MIPMAP = 0x400000;
+	const uint32_t DXGI_FORMAT_BC1_UNORM = 71;
+	const uint32_t DXGI_FORMAT_BC1_UNORM_SRGB = 72;
+	const uint32_t DXGI_FORMAT_BC3_UNORM = 77;
+	const uint32_t DXGI_FORMAT_BC3_UNORM_SRGB = 78;
+	const uint32_t DXGI_FORMAT_BC7_UNORM = 98;
+	const uint32_t DXGI_FORMAT_BC7_UNORM_SRGB = 99;
+	const uint32_t D3D10_RESOURCE_DIMENSION_TEXTURE2D = 3;
+
+	// header of a .dds file, after the magic number
+	struct DDS_HEADER
+	{
+		uint32_t size;
+		uint32_t flags;
+		uint32_t height;
+		uint32_t width;
+		uint32_t pitchOrLinearSize;
+		uint32_t depth;
+		uint32_t mipMapCount;
+		uint32_t reserved1[11];
+		uint32_t pixelFormatSize;
+		uint32_t pixelFormatFlags;
+		uint32_t fourCC;
+		uint32_t rgbBitCount;
+		uint32_t bitMasks[4];
+		uint32_t caps[4];
+		uint32_t reserved2;
+	};
+
+	// extended header following the DDS header for the "DX10" code
+	struct DDS_HEADER_DX10
+	{
+		uint32_t dxgiFormat;
+		uint32_t resourceDimension;
+		uint32_t miscFlag;
+		uint32_t arraySize;
+		uint32_t miscFlags2;
+	};
+
+	// build a four character code from its characters
+	uint32_t MakeFourCC(char a, char b, char c, char d)
+	{
+		return (uint32_t)(unsigned char)a | ((uint32_t)(unsigned char)b << 8) |
+			((uint32_t)(unsigned char)c << 16) | ((uint32_t)(unsigned char)d << 24);
+	}
+
+	// get the OpenGL internal format of a texture format
+	GLenum GetInternalFormat(TextureStreamer::TEXTURE_FORMAT format)
+	{
+		switch (format)
+		{
+		case TextureStreamer::FORMAT_RGB8:
+			return GL_RGB8;
+		case TextureStreamer::FORMAT_BC1:
+			return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+		case TextureStreamer::FORMAT_BC3:
+			return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+		case TextureStreamer::FORMAT_BC7:
+			return GL_COMPRESSED_RGBA_BPTC_UNORM;
+		default:
+			return GL_RGBA8;
+		}
+	}
+}
+
+/***********************************************************
+ *  TextureStreamer()
+ *
+ *  The constructor for the class - the supported compressed
+ *  formats are checked here, so it needs a GL context.
+ ***********************************************************/
+TextureStreamer::TextureStreamer()
+{
+	m_budgetBytes = 0;
+	m_uploadLimitBytes = 4 * 1024 * 1024;
+	m_residentBytes = 0;
+	m_requestedBytes = 0;
+	m_frameIndex = 0;
+	m_bS3TCSupported = (GLEW_EXT_texture_compression_s3tc != GL_FALSE);
+	m_bBPTCSupported = (GLEW_ARB_texture_compression_bptc != GL_FALSE);
+}
+
+/***********************************************************
+ *  ~TextureStreamer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+TextureStreamer::~TextureStreamer()
+{
+	Clear();
+}
+
+/***********************************************************
+ *  GetBakedFilename()
+ *
+ *  This method is used for getting the name of the baked
+ *  .dds file for an image, which replaces its extension.
+ ***********************************************************/
+std::string TextureStreamer::GetBakedFilename(const std::string& filename)
+{
+	size_t extension = filename.find_last_of('.');
+	size_t directory = filename.find_last_of("/\\");
+	if ((extension == std::string::npos) ||
+		((directory != std::string::npos) && (extension < directory)))
+	{
+		return(filename + ".dds");
+	}
+	return(filename.substr(0, extension) + ".dds");
+}
+
+/***********************************************************
+ *  GetLevelBytes()
+ *
+ *  This method is used for getting the size of one level in
+ *  the passed in format.  The compressed formats store 4x4
+ *  pixel blocks of 8 (BC1) or 16 (BC3, BC7) bytes.
+ ***********************************************************/
+size_t TextureStreamer::GetLevelBytes(TEXTURE_FORMAT format, int width, int height)
+{
+	size_t blocks = (size_t)((width + 3) / 4) * (size_t)((height + 3) / 4);
+	switch (format)
+	{
+	case FORMAT_RGB8:
+		return (size_t)width * height * 3;
+	case FORMAT_RGBA8:
+		return (size_t)width * height * 4;
+	case FORMAT_BC1:
+		return blocks * 8;
+	default:
+		return blocks * 16;
+	}
+}
+
+/***********************************************************
+ *  LoadImageLevels()
+ *
+ *  This method is used for loading an image file and
+ *  building its mip chain with a 2x2 box filter.  Gray
+ *  images are expanded to RGB, and gray images with alpha
+ *  to RGBA, so every image loads in one of the two formats.
+ ***********************************************************/
+bool TextureStreamer::LoadImageLevels(
+	const std::string& filename,
+	TEXTURE_FORMAT& format,
+	std::vector<MIP_LEVEL>& levels)
+{
+	int width = 0;
+	int height = 0;
+	int colorChannels = 0;
+	if (!stbi_info(filename.c_str(), &width, &height, &colorChannels))
+	{
+		return(false);
+	}
+	int channels = ((colorChannels == 2) || (colorChannels == 4)) ? 4 : 3;
+
+	// indicate to always flip images vertically when loaded
+	stbi_set_flip_vertically_on_load(true);
+	unsigned char* image = stbi_load(filename.c_str(), &width, &height, &colorChannels, channels);
+	if (NULL == image)
+	{
+		return(false);
+	}
+
+	std::cout << "Successfully loaded image:" << filename << ", width:" << width << ", height:" << height << ", channels:" << colorChannels << std::endl;
+
+	format = (channels == 4) ? FORMAT_RGBA8 : FORMAT_RGB8;
+	levels.clear();
+	levels.resize(1);
+	levels[0].width = width;
+	levels[0].height = height;
+	levels[0].data.assign(image, image + (size_t)width * height * channels);
+	stbi_image_free(image);
+
+	while ((levels.back().width > 1) || (levels.back().height > 1))
+	{
+		const MIP_LEVEL& below = levels.back();
+		MIP_LEVEL level;
+		level.width = glm::max(below.width / 2, 1);
+		level.height = glm::max(below.height / 2, 1);
+		level.data.resize((size_t)level.width * level.height * channels);
+		for (int y = 0; y < level.height; y++)
+		{
+			int y0 = glm::min(y * 2, below.height - 1);
+			int y1 = glm::min(y * 2 + 1, below.height - 1);
+			for (int x = 0; x < level.width; x++)
+			{
+				int x0 = glm::min(x * 2, below.width - 1);
+				int x1 = glm::min(x * 2 + 1, below.width - 1);
+				for (int c = 0; c < channels; c++)
+				{
+					int sum = below.data[((size_t)y0 * below.width + x0) * channels + c] +
+						below.data[((size_t)y0 * below.width + x1) * channels + c] +
+						below.data[((size_t)y1 * below.width + x0) * channels + c] +
+						below.data[((size_t)y1 * below.width + x1) * channels + c];
+					level.data[((size_t)y * level.width + x) * channels + c] = (unsigned char)((sum + 2) / 4);
+				}
+			}
+		}
+		levels.push_back(level);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  LoadDDSLevels()
+ *
+ *  This method is used for loading the BC1, BC3 or BC7 mip
+ *  levels of a .dds file, with either the legacy DXT1/DXT5
+ *  codes or the DX10 extended header.
+ ***********************************************************/
+bool TextureStreamer::LoadDDSLevels(
+	const std::string& filename,
+	TEXTURE_FORMAT& format,
+	std::vector<MIP_LEVEL>& levels)
+{
+	std::ifstream file(filename, std::ios::binary);
+	if (!file.is_open())
+	{
+		return(false);
+	}
+
+	uint32_t magic = 0;
+	DDS_HEADER header;
+	file.read((char*)&magic, sizeof(magic));
+	file.read((char*)&header, sizeof(header));
+	if (!file || (magic != DDS_MAGIC) || (header.size != sizeof(DDS_HEADER)) ||
+		((header.pixelFormatFlags & DDPF_FOURCC) == 0))
+	{
+		std::cout << "Unsupported texture file:" << filename << std::endl;
+		return(false);
+	}
+
+	if (header.fourCC == MakeFourCC('D', 'X', 'T', '1'))
+	{
+		format = FORMAT_BC1;
+	}
+	else if (header.fourCC == MakeFourCC('D', 'X', 'T', '5'))
+	{
+		format = FORMAT_BC3;
+	}
+	else if (header.fourCC == MakeFourCC('D', 'X', '1', '0'))
+	{
+		DDS_HEADER_DX10 extension;
+		file.read((char*)&extension, sizeof(extension));
+		if ((extension.dxgiFormat == DXGI_FORMAT_BC1_UNORM) || (extension.dxgiFormat == DXGI_FORMAT_BC1_UNORM_SRGB))
+			format = FORMAT_BC1;
+		else if ((extension.dxgiFormat == DXGI_FORMAT_BC3_UNORM) || (extension.dxgiFormat == DXGI_FORMAT_BC3_UNORM_SRGB))
+			format = FORMAT_BC3;
+		else if ((extension.dxgiFormat == DXGI_FORMAT_BC7_UNORM) || (extension.dxgiFormat == DXGI_FORMAT_BC7_UNORM_SRGB))
+			format = FORMAT_BC7;
+		else
+		{
+			std::cout << "Unsupported texture format " << extension.dxgiFormat << " in:" << filename << std::endl;
+			return(false);
+		}
+	}
+	else
+	{
+		std::cout << "Unsupported texture format in:" << filename << std::endl;
+		return(false);
+	}
+
+	int levelCount = ((header.flags & DDSD_MIPMAPCOUNT) != 0) ? glm::max((int)header.mipMapCount, 1) : 1;
+	int width = (int)header.width;
+	int height = (int)header.height;
+	levels.clear();
+	for (int i = 0; i < levelCount; i++)
+	{
+		MIP_LEVEL level;
+		level.width = width;
+		level.height = height;
+		level.data.resize(GetLevelBytes(format, width, height));
+		file.read((char*)level.data.data(), level.data.size());
+		if (!file)
+		{
+			std::cout << "Truncated texture file:" << filename << std::endl;
+			return(false);
+		}
+		levels.push_back(level);
+		width = glm::max(width / 2, 1);
+		height = glm::max(height / 2, 1);
+	}
+
+	std::cout << "Successfully loaded texture:" << filename << ", width:" << header.width << ", height:" << header.height << ", levels:" << levelCount << std::endl;
+	return(true);
+}
+
+/***********************************************************
+ *  SaveDDSLevels()
+ *
+ *  This method is used for writing block compressed levels
+ *  into a .dds file.  BC1 and BC3 use the legacy codes and
+ *  BC7 needs the DX10 extended header.
+ ***********************************************************/
+bool TextureStreamer::SaveDDSLevels(
+	const std::string& filename,
+	TEXTURE_FORMAT format,
+	const std::vector<MIP_LEVEL>& levels)
+{
+	if ((levels.size() == 0) || (format == FORMAT_RGB8) || (format == FORMAT_RGBA8))
+	{
+		return(false);
+	}
+
+	std::ofstream file(filename, std::ios::binary);
+	if (!file.is_open())
+	{
+		std::cout << "Could not write texture file:" << filename << std::endl;
+		return(false);
+	}
+
+	DDS_HEADER header;
+	memset(&header, 0, sizeof(header));
+	header.size = sizeof(DDS_HEADER);
+	header.flags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT | DDSD_LINEARSIZE;
+	header.height = levels[0].height;
+	header.width = levels[0].width;
+	header.pitchOrLinearSize = (uint32_t)levels[0].data.size();
+	header.mipMapCount = (uint32_t)levels.size();
+	header.pixelFormatSize = 32;
+	header.pixelFormatFlags = DDPF_FOURCC;
+	header.caps[0] = DDSCAPS_TEXTURE | DDSCAPS_MIPMAP | DDSCAPS_COMPLEX;
+	if (format == FORMAT_BC1)
+		header.fourCC = MakeFourCC('D', 'X', 'T', '1');
+	else if (format == FORMAT_BC3)
+		header.fourCC = MakeFourCC('D', 'X', 'T', '5');
+	else
+		header.fourCC = MakeFourCC('D', 'X', '1', '0');
+
+	uint32_t magic = DDS_MAGIC;
+	file.write((const char*)&magic, sizeof(magic));
+	file.write((const char*)&header, sizeof(header));
+	if (format == FORMAT_BC7)
+	{
+		DDS_HEADER_DX10 extension;
+		memset(&extension, 0, sizeof(extension));
+		extension.dxgiFormat = DXGI_FORMAT_BC7_UNORM;
+		extension.resourceDimension = D3D10_RESOURCE_DIMENSION_TEXTURE2D;
+		extension.arraySize = 1;
+		file.write((const char*)&extension, sizeof(extension));
+	}
+	for (int i = 0; i < (int)levels.size(); i++)
+	{
+		file.write((const char*)levels[i].data.data(), levels[i].data.size());
+	}
+
+	return(file.good());
+}
+
+/***********************************************************
+ *  AddTexture()
+ *
+ *  This method is used for loading a texture, preferring its
+ *  baked .dds file when the driver supports the format, and
+ *  uploading only the levels of its mip tail.  Every texture
+ *  is bound on the texture unit of its index, as the scene
+ *  manager binds its texture slots, so streaming its levels
+ *  later never disturbs the bindings of other units.
+ ***********************************************************/
+int TextureStreamer::AddTexture(const std::string& filename)
+{
+	STREAMED_TEXTURE texture;
+	bool bLoaded = LoadDDSLevels(GetBakedFilename(filename), texture.format, texture.levels);
+	if (bLoaded)
+	{
+		bool bSupported = (texture.format == FORMAT_BC7) ? m_bBPTCSupported : m_bS3TCSupported;
+		if (!bSupported)
+		{
+			std::cout << "Compressed texture format is not supported, loading:" << filename << std::endl;
+			bLoaded = false;
+		}
+	}
+	if (!bLoaded)
+	{
+		bLoaded = LoadImageLevels(filename, texture.format, texture.levels);
+	}
+	if (!bLoaded)
+	{
+		std::cout << "Could not load image:" << filename << std::endl;
+		return(-1);
+	}
+
+	// the tail starts at the first level small enough, or at the
+	// coarsest level of an incomplete chain
+	texture.tailLevel = (int)texture.levels.size() - 1;
+	for (int i = 0; i < (int)texture.levels.size(); i++)
+	{
+		if (glm::max(texture.levels[i].width, texture.levels[i].height) <= MIP_TAIL_SIZE)
+		{
+			texture.tailLevel = i;
+			break;
+		}
+	}
+	texture.residentLevel = (int)texture.levels.size();
+	texture.requestedLevel = -1;
+	texture.lastUsedFrame = m_frameIndex;
+
+	int index = (int)m_textures.size();
+	GLint activeTexture = 0;
+	glGetIntegerv(GL_ACTIVE_TEXTURE, &activeTexture);
+	glActiveTexture(GL_TEXTURE0 + index);
+
+	glGenTextures(1, &texture.textureID);
+	glBindTexture(GL_TEXTURE_2D, texture.textureID);
+
+	// set the texture wrapping parameters
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	// set texture filtering parameters - sampling between the
+	// resident levels, so the streamed levels are really used
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)texture.levels.size() - 1);
+
+	for (int level = (int)texture.levels.size() - 1; level >= texture.tailLevel; level--)
+	{
+		UploadLevel(texture, level);
+	}
+
+	glActiveTexture(activeTexture);
+	m_textures.push_back(texture);
+
+	return(index);
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for freeing all of the textures.
+ ***********************************************************/
+void TextureStreamer::Clear()
+{
+	for (int i = 0; i < (int)m_textures.size(); i++)
+	{
+		glDeleteTextures(1, &m_textures[i].textureID);
+	}
+	m_textures.clear();
+	m_residentBytes = 0;
+	m_requestedBytes = 0;
+}
+
+/***********************************************************
+ *  GetChainBytes()
+ *
+ *  This method is used for getting the bytes of the levels
+ *  of a texture from the passed in level down to 1x1.
+ ***********************************************************/
+size_t TextureStreamer::GetChainBytes(const STREAMED_TEXTURE& texture, int firstLevel) const
+{
+	size_t bytes = 0;
+	for (int i = firstLevel; i < (int)texture.levels.size(); i++)
+	{
+		bytes += texture.levels[i].data.size();
+	}
+	return(bytes);
+}
+
+/***********************************************************
+ *  UploadLevel()
+ *
+ *  This method is used for uploading the next finer level
+ *  of the texture bound on the active unit and making it
+ *  the base level for sampling.
+ ***********************************************************/
+void TextureStreamer::UploadLevel(STREAMED_TEXTURE& texture, int level)
+{
+	const MIP_LEVEL& mip = texture.levels[level];
+	if ((texture.format == FORMAT_RGB8) || (texture.format == FORMAT_RGBA8))
+	{
+		GLenum pixelFormat = (texture.format == FORMAT_RGBA8) ? GL_RGBA : GL_RGB;
+		// the rows of RGB levels are not padded to 4 bytes
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glTexImage2D(GL_TEXTURE_2D, level, GetInternalFormat(texture.format), mip.width, mip.height, 0,
+			pixelFormat, GL_UNSIGNED_BYTE, mip.data.data());
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	}
+	else
+	{
+		glCompressedTexImage2D(GL_TEXTURE_2D, level, GetInternalFormat(texture.format), mip.width, mip.height, 0,
+			(GLsizei)mip.data.size(), mip.data.data());
+	}
+
+	texture.residentLevel = level;
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level);
+	m_residentBytes += mip.data.size();
+}
+
+/***********************************************************
+ *  EvictLevel()
+ *
+ *  This method is used for freeing the finest uploaded level
+ *  of a texture.  The level is redefined with no pixels, and
+ *  the base level moves to the next coarser one.
+ ***********************************************************/
+void TextureStreamer::EvictLevel(STREAMED_TEXTURE& texture)
+{
+	int level = texture.residentLevel;
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level + 1);
+	if ((texture.format == FORMAT_RGB8) || (texture.format == FORMAT_RGBA8))
+	{
+		glTexImage2D(GL_TEXTURE_2D, level, GetInternalFormat(texture.format), 0, 0, 0,
+			GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	}
+	else
+	{
+		glCompressedTexImage2D(GL_TEXTURE_2D, level, GetInternalFormat(texture.format), 0, 0, 0, 0, NULL);
+	}
+
+	texture.residentLevel = level + 1;
+	m_residentBytes -= texture.levels[level].data.size();
+}
+
+/***********************************************************
+ *  FindEvictionCandidate()
+ *
+ *  This method is used for finding the least recently used
+ *  texture that holds levels finer than its target.  The
+ *  textures not used this frame are older, so they give up
+ *  their levels before any texture currently on screen.
+ ***********************************************************/
+int TextureStreamer::FindEvictionCandidate(const std::vector<int>& targetLevels) const
+{
+	int candidate = -1;
+	for (int i = 0; i < (int)m_textures.size(); i++)
+	{
+		if ((m_textures[i].residentLevel < targetLevels[i]) &&
+			((candidate < 0) || (m_textures[i].lastUsedFrame < m_textures[candidate].lastUsedFrame)))
+		{
+			candidate = i;
+		}
+	}
+	return(candidate);
+}
+
+/***********************************************************
+ *  RequestLevel()
+ *
+ *  This method is used for requesting the finest level of a
+ *  texture sampled by one of the draws of this frame.
+ ***********************************************************/
+void TextureStreamer::RequestLevel(int index, int level)
+{
+	if ((index < 0) || (index >= (int)m_textures.size()))
+	{
+		return;
+	}
+
+	STREAMED_TEXTURE& texture = m_textures[index];
+	level = glm::clamp(level, 0, texture.tailLevel);
+	if ((texture.requestedLevel < 0) || (level < texture.requestedLevel))
+	{
+		texture.requestedLevel = level;
+	}
+	texture.lastUsedFrame = m_frameIndex;
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is used for bringing the resident levels in
+ *  line with the requests of this frame.  While the levels
+ *  to upload do not fit into the budget, the least recently
+ *  used texture with levels above its target gives up its
+ *  finest one, and when none is left, the finest request is
+ *  coarsened instead.  The uploads are limited per frame and
+ *  continue in the next frames, coarse levels first.
+ ***********************************************************/
+void TextureStreamer::Update()
+{
+	// unused textures only need their mip tail
+	std::vector<int> targetLevels(m_textures.size());
+	m_requestedBytes = 0;
+	for (int i = 0; i < (int)m_textures.size(); i++)
+	{
+		const STREAMED_TEXTURE& texture = m_textures[i];
+		targetLevels[i] = (texture.requestedLevel >= 0) ? texture.requestedLevel : texture.tailLevel;
+		m_requestedBytes += GetChainBytes(texture, targetLevels[i]);
+	}
+
+	GLint activeTexture = 0;
+	glGetIntegerv(GL_ACTIVE_TEXTURE, &activeTexture);
+
+	if (m_budgetBytes > 0)
+	{
+		while (true)
+		{
+			size_t incomingBytes = 0;
+			int finestRequest = -1;
+			for (int i = 0; i < (int)m_textures.size(); i++)
+			{
+				if (targetLevels[i] < m_textures[i].residentLevel)
+				{
+					incomingBytes += GetChainBytes(m_textures[i], targetLevels[i]) -
+						GetChainBytes(m_textures[i], m_textures[i].residentLevel);
+					if ((finestRequest < 0) ||
+						(m_textures[i].levels[targetLevels[i]].data.size() > m_textures[finestRequest].levels[targetLevels[finestRequest]].data.size()))
+					{
+						finestRequest = i;
+					}
+				}
+			}
+			if (m_residentBytes + incomingBytes <= m_budgetBytes)
+			{
+				break;
+			}
+
+			int candidate = FindEvictionCandidate(targetLevels);
+			if (candidate >= 0)
+			{
+				glActiveTexture(GL_TEXTURE0 + candidate);
+				EvictLevel(m_textures[candidate]);
+			}
+			else if (finestRequest >= 0)
+			{
+				targetLevels[finestRequest]++;
+			}
+			else
+			{
+				// the mip tails alone are over the budget
+				break;
+			}
+		}
+	}
+
+	// upload coarse levels across all textures before fine ones
+	size_t uploadedBytes = 0;
+	bool bUploaded = true;
+	while (bUploaded && (uploadedBytes < m_uploadLimitBytes))
+	{
+		bUploaded = false;
+		int coarsest = -1;
+		for (int i = 0; i < (int)m_textures.size(); i++)
+		{
+			if ((targetLevels[i] < m_textures[i].residentLevel) &&
+				((coarsest < 0) ||
+				(m_textures[i].levels[m_textures[i].residentLevel - 1].data.size() <
+				m_textures[coarsest].levels[m_textures[coarsest].residentLevel - 1].data.size())))
+			{
+				coarsest = i;
+			}
+		}
+		if (coarsest >= 0)
+		{
+			STREAMED_TEXTURE& texture = m_textures[coarsest];
+			glActiveTexture(GL_TEXTURE0 + coarsest);
+			UploadLevel(texture, texture.residentLevel - 1);
+			uploadedBytes += texture.levels[texture.residentLevel].data.size();
+			bUploaded = true;
+		}
+	}
+
+	glActiveTexture(activeTexture);
+
+	for (int i = 0; i < (int)m_textures.size(); i++)
+	{
+		m_textures[i].requestedLevel = -1;
+	}
+	m_frameIndex++;
+}
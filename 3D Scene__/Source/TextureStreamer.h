@@ -0,0 +1,148 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturestreamer.h
+// ============
+// load block compressed textures and stream their mip levels within a budget
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  TextureStreamer
+ *
+ *  This class owns the scene textures.  The complete mip
+ *  chain of every texture stays in system memory, either
+ *  block compressed from a baked .dds file next to the image
+ *  or uncompressed from the image itself.  Only the levels
+ *  requested for the screen size of the objects using a
+ *  texture are uploaded, finest last, while the small levels
+ *  of the mip tail are always resident.  When the requested
+ *  levels do not fit into the memory budget, the least
+ *  recently used textures give up their finest levels first.
+ ***********************************************************/
+class TextureStreamer
+{
+public:
+	// constructor
+	TextureStreamer();
+	// destructor
+	~TextureStreamer();
+
+	// pixel formats of the loaded textures
+	enum TEXTURE_FORMAT
+	{
+		FORMAT_RGB8,
+		FORMAT_RGBA8,
+		FORMAT_BC1,
+		FORMAT_BC3,
+		FORMAT_BC7
+	};
+
+	// largest width or height of the always resident mip tail
+	static const int MIP_TAIL_SIZE = 64;
+
+	// properties for one mip level held in system memory
+	struct MIP_LEVEL
+	{
+		int width;
+		int height;
+		std::vector<unsigned char> data;
+	};
+
+	// load an image file and build its mip levels on the CPU -
+	// the rows start at the bottom, as OpenGL expects them
+	static bool LoadImageLevels(
+		const std::string& filename,
+		TEXTURE_FORMAT& format,
+		std::vector<MIP_LEVEL>& levels);
+	// load the block compressed mip levels of a .dds file, which
+	// is expected to store the rows bottom first as well
+	static bool LoadDDSLevels(
+		const std::string& filename,
+		TEXTURE_FORMAT& format,
+		std::vector<MIP_LEVEL>& levels);
+	// write the passed in block compressed levels as a .dds file
+	static bool SaveDDSLevels(
+		const std::string& filename,
+		TEXTURE_FORMAT format,
+		const std::vector<MIP_LEVEL>& levels);
+	// get the file name of the baked texture for an image file
+	static std::string GetBakedFilename(const std::string& filename);
+	// get the size in bytes of a level in the passed in format
+	static size_t GetLevelBytes(TEXTURE_FORMAT format, int width, int height);
+
+	// set the texture memory budget in bytes (0 = no limit)
+	void SetBudget(size_t budgetBytes) { m_budgetBytes = budgetBytes; }
+	// set the most bytes uploaded in one frame
+	void SetUploadLimit(size_t uploadBytes) { m_uploadLimitBytes = uploadBytes; }
+
+	// load a texture and upload its mip tail - returns the index
+	// of the texture, or -1 when it could not be loaded
+	int AddTexture(const std::string& filename);
+	// free all of the textures
+	void Clear();
+
+	// get the number of loaded textures
+	int GetTextureCount() const { return (int)m_textures.size(); }
+	// get the OpenGL texture of a loaded texture
+	GLuint GetTextureID(int index) const { return m_textures[index].textureID; }
+	// get the number of mip levels of a loaded texture
+	int GetLevelCount(int index) const { return (int)m_textures[index].levels.size(); }
+	// get the size of the finest level of a loaded texture
+	int GetWidth(int index) const { return m_textures[index].levels[0].width; }
+	int GetHeight(int index) const { return m_textures[index].levels[0].height; }
+
+	// request the finest level a texture is sampled at this frame
+	void RequestLevel(int index, int level);
+	// evict and upload levels for the requests of this frame
+	void Update();
+
+	// get the bytes of the uploaded levels
+	size_t GetResidentBytes() const { return m_residentBytes; }
+	// get the bytes of the levels requested in the last frame
+	size_t GetRequestedBytes() const { return m_requestedBytes; }
+
+private:
+	// properties for one streamed texture
+	struct STREAMED_TEXTURE
+	{
+		GLuint textureID;
+		TEXTURE_FORMAT format;
+		std::vector<MIP_LEVEL> levels;
+		// finest level uploaded, and the first level of the mip tail
+		int residentLevel;
+		int tailLevel;
+		// finest level requested this frame, or -1 when unused
+		int requestedLevel;
+		// frame in which the texture was last requested
+		int lastUsedFrame;
+	};
+
+	// get the bytes of the levels from the passed in one down
+	size_t GetChainBytes(const STREAMED_TEXTURE& texture, int firstLevel) const;
+	// upload one level of a texture
+	void UploadLevel(STREAMED_TEXTURE& texture, int level);
+	// free the finest uploaded level of a texture
+	void EvictLevel(STREAMED_TEXTURE& texture);
+	// find the least recently used texture holding levels finer
+	// than the passed in target levels, or -1
+	int FindEvictionCandidate(const std::vector<int>& targetLevels) const;
+
+	// loaded textures
+	std::vector<STREAMED_TEXTURE> m_textures;
+	// memory budget and per frame upload limit in bytes
+	size_t m_budgetBytes;
+	size_t m_uploadLimitBytes;
+	// counters of the last frame
+	size_t m_residentBytes;
+	size_t m_requestedBytes;
+	// number of updates, used as the LRU clock
+	int m_frameIndex;
+	// whether the driver decodes the block compressed formats
+	bool m_bS3TCSupported;
+	bool m_bBPTCSupported;
+};
@@ -0,0 +1,257 @@
+///////////////////////////////////////////////////////////////////////////////
+// transparencyrenderer.cpp
+// ============
+// accumulate and composite the transparent draws without sorting them
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TransparencyRenderer.h"
+
+#include <iostream>
+
+// declare the global variables
+namespace
+{
+	const char* g_TransparencyModeNames[] = { "sorted", "weighted blended" };
+}
+
+/***********************************************************
+ *  TransparencyRenderer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TransparencyRenderer::TransparencyRenderer()
+{
+	m_pCompositeShaderManager = NULL;
+	m_framebuffer = 0;
+	m_accumulationTexture = 0;
+	m_weightTexture = 0;
+	m_depthRenderbuffer = 0;
+	m_width = 0;
+	m_height = 0;
+	m_samples = 0;
+	m_emptyVertexArray = 0;
+	m_targetFramebuffer = 0;
+}
+
+/***********************************************************
+ *  ~TransparencyRenderer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+TransparencyRenderer::~TransparencyRenderer()
+{
+	DestroyTargets();
+	if (m_emptyVertexArray != 0)
+	{
+		glDeleteVertexArrays(1, &m_emptyVertexArray);
+		m_emptyVertexArray = 0;
+	}
+	if (NULL != m_pCompositeShaderManager)
+	{
+		delete m_pCompositeShaderManager;
+		m_pCompositeShaderManager = NULL;
+	}
+}
+
+/***********************************************************
+ *  GetModeName()
+ *
+ *  This method is used for getting the display name of the
+ *  passed in transparency mode.
+ ***********************************************************/
+const char* TransparencyRenderer::GetModeName(int mode)
+{
+	if ((mode < 0) || (mode >= TRANSPARENCY_MODE_COUNT))
+	{
+		return("unknown");
+	}
+	return(g_TransparencyModeNames[mode]);
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for loading the composite shader and
+ *  setting its fixed sampler units.  Multisampled and single
+ *  sampled targets are read through different samplers, so
+ *  each kind gets its own pair of units.
+ ***********************************************************/
+void TransparencyRenderer::Initialize()
+{
+	// the composite shares the full screen triangle of the
+	// deferred lighting pass
+	m_pCompositeShaderManager = new ShaderManager();
+	m_pCompositeShaderManager->LoadShaders(
+		"../shaders/deferredVertexShader.glsl",
+		"../shaders/transparencyFragmentShader.glsl");
+	m_pCompositeShaderManager->use();
+	m_pCompositeShaderManager->setIntValue("accumulationSamples", ACCUMULATION_TEXTURE_UNIT);
+	m_pCompositeShaderManager->setIntValue("weightSamples", ACCUMULATION_TEXTURE_UNIT + 1);
+	m_pCompositeShaderManager->setIntValue("accumulation", ACCUMULATION_TEXTURE_UNIT + 2);
+	m_pCompositeShaderManager->setIntValue("weight", ACCUMULATION_TEXTURE_UNIT + 3);
+
+	// core profile draws need a vertex array even without attributes
+	glGenVertexArrays(1, &m_emptyVertexArray);
+}
+
+/***********************************************************
+ *  CreateTargets()
+ *
+ *  This method is used for creating the accumulation targets
+ *  with the passed in sample count, so that the depth of the
+ *  scene framebuffer can be blitted across.  The summed
+ *  colors need the range of half floats, while the weights
+ *  only need one channel.
+ ***********************************************************/
+void TransparencyRenderer::CreateTargets(int width, int height, int samples)
+{
+	m_width = width;
+	m_height = height;
+	m_samples = samples;
+
+	GLenum textureTarget = (samples > 0) ? GL_TEXTURE_2D_MULTISAMPLE : GL_TEXTURE_2D;
+	GLuint* textures[] = { &m_accumulationTexture, &m_weightTexture };
+	GLenum formats[] = { GL_RGBA16F, GL_R16F };
+
+	glGenFramebuffers(1, &m_framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+
+	GLenum drawBuffers[2];
+	for (int i = 0; i < 2; i++)
+	{
+		glGenTextures(1, textures[i]);
+		glBindTexture(textureTarget, *textures[i]);
+		if (samples > 0)
+		{
+			glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, samples, formats[i], width, height, GL_TRUE);
+		}
+		else
+		{
+			glTexImage2D(GL_TEXTURE_2D, 0, formats[i], width, height, 0, GL_RGBA, GL_FLOAT, NULL);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		}
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, textureTarget, *textures[i], 0);
+		drawBuffers[i] = GL_COLOR_ATTACHMENT0 + i;
+	}
+	glDrawBuffers(2, drawBuffers);
+	glBindTexture(textureTarget, 0);
+
+	// the packed format of the scene depth, so it can be blitted
+	glGenRenderbuffers(1, &m_depthRenderbuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_depthRenderbuffer);
+	if (samples > 0)
+	{
+		glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_DEPTH24_STENCIL8, width, height);
+	}
+	else
+	{
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+	}
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_depthRenderbuffer);
+
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "Transparency framebuffer is not complete" << std::endl;
+	}
+}
+
+/***********************************************************
+ *  DestroyTargets()
+ *
+ *  This method is used for freeing the accumulation targets
+ *  and framebuffer.
+ ***********************************************************/
+void TransparencyRenderer::DestroyTargets()
+{
+	GLuint textures[] = { m_accumulationTexture, m_weightTexture };
+	glDeleteTextures(2, textures);
+	m_accumulationTexture = 0;
+	m_weightTexture = 0;
+
+	if (m_depthRenderbuffer != 0)
+	{
+		glDeleteRenderbuffers(1, &m_depthRenderbuffer);
+		m_depthRenderbuffer = 0;
+	}
+	if (m_framebuffer != 0)
+	{
+		glDeleteFramebuffers(1, &m_framebuffer);
+		m_framebuffer = 0;
+	}
+	m_width = 0;
+	m_height = 0;
+	m_samples = 0;
+}
+
+/***********************************************************
+ *  BeginAccumulation()
+ *
+ *  This method is used for binding the accumulation targets
+ *  for the transparent draws.  The colors are cleared to
+ *  zero and the revealage to one, and one blend function
+ *  serves both targets: the colors and weights are summed,
+ *  while the revealage in the alpha of the first target is
+ *  multiplied by one minus the alpha of every draw.  The
+ *  draws test against the opaque depth without writing it.
+ ***********************************************************/
+void TransparencyRenderer::BeginAccumulation(int width, int height)
+{
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &m_targetFramebuffer);
+
+	GLint samples = 0;
+	glGetIntegerv(GL_SAMPLES, &samples);
+	if ((width != m_width) || (height != m_height) || (samples != m_samples))
+	{
+		DestroyTargets();
+		CreateTargets(width, height, samples);
+	}
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, m_targetFramebuffer);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_framebuffer);
+	glBlitFramebuffer(0, 0, m_width, m_height, 0, 0, m_width, m_height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+
+	const GLfloat accumulationClear[] = { 0.0f, 0.0f, 0.0f, 1.0f };
+	const GLfloat weightClear[] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	glClearBufferfv(GL_COLOR, 0, accumulationClear);
+	glClearBufferfv(GL_COLOR, 1, weightClear);
+
+	glEnable(GL_BLEND);
+	glBlendFuncSeparate(GL_ONE, GL_ONE, GL_ZERO, GL_ONE_MINUS_SRC_ALPHA);
+	glDepthMask(GL_FALSE);
+}
+
+/***********************************************************
+ *  Composite()
+ *
+ *  This method is used for blending the accumulated draws
+ *  over the framebuffer bound before the accumulation, with
+ *  a full screen triangle.  The default depth and blending
+ *  state is restored afterwards.
+ ***********************************************************/
+void TransparencyRenderer::Composite()
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, m_targetFramebuffer);
+	glViewport(0, 0, m_width, m_height);
+
+	m_pCompositeShaderManager->use();
+	m_pCompositeShaderManager->setIntValue("sampleCount", m_samples);
+	GLenum textureTarget = (m_samples > 0) ? GL_TEXTURE_2D_MULTISAMPLE : GL_TEXTURE_2D;
+	int firstUnit = (m_samples > 0) ? ACCUMULATION_TEXTURE_UNIT : ACCUMULATION_TEXTURE_UNIT + 2;
+	glActiveTexture(GL_TEXTURE0 + firstUnit);
+	glBindTexture(textureTarget, m_accumulationTexture);
+	glActiveTexture(GL_TEXTURE0 + firstUnit + 1);
+	glBindTexture(textureTarget, m_weightTexture);
+
+	// the composite writes the average color with one minus the
+	// revealage as its alpha
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glDisable(GL_DEPTH_TEST);
+	glBindVertexArray(m_emptyVertexArray);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	glBindVertexArray(0);
+	glEnable(GL_DEPTH_TEST);
+	glDepthMask(GL_TRUE);
+}
@@ -0,0 +1,85 @@
+///////////////////////////////////////////////////////////////////////////////
+// transparencyrenderer.h
+// ============
+// accumulate and composite the transparent draws without sorting them
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ShaderManager.h"
+
+#include <GL/glew.h>
+
+/***********************************************************
+ *  TransparencyRenderer
+ *
+ *  This class owns the targets of weighted blended order
+ *  independent transparency.  The transparent draws are
+ *  rendered in any order into an accumulation target that
+ *  sums their premultiplied colors scaled by a depth based
+ *  weight, and a revealage value that multiplies how much
+ *  of the background each one lets through.  A full screen
+ *  composite then divides out the weights and blends the
+ *  result over the opaque scene.  The targets match the size
+ *  and sample count of the scene framebuffer, whose depth is
+ *  copied in so that opaque surfaces still hide the draws.
+ ***********************************************************/
+class TransparencyRenderer
+{
+public:
+	// constructor
+	TransparencyRenderer();
+	// destructor
+	~TransparencyRenderer();
+
+	// ways the transparent draws can be rendered
+	enum TRANSPARENCY_MODE
+	{
+		// blended back to front after sorting them every frame
+		TRANSPARENCY_SORTED,
+		// accumulated in any order and composited once
+		TRANSPARENCY_WEIGHTED,
+		TRANSPARENCY_MODE_COUNT
+	};
+
+	// get the display name of a transparency mode
+	static const char* GetModeName(int mode);
+
+	// first texture unit used for binding the accumulation
+	// targets to the composite - above the Hi-Z depth
+	static const int ACCUMULATION_TEXTURE_UNIT = 23;
+
+	// load the composite shader - needs a current GL context
+	void Initialize();
+
+	// copy the depth of the bound framebuffer and bind the
+	// cleared accumulation targets, recreated when the size or
+	// sample count of the framebuffer changes
+	void BeginAccumulation(int width, int height);
+	// blend the accumulated draws over the framebuffer that was
+	// bound before the accumulation
+	void Composite();
+
+private:
+	// create the accumulation targets
+	void CreateTargets(int width, int height, int samples);
+	// free the accumulation targets and framebuffer
+	void DestroyTargets();
+
+	// shader dividing out the weights and blending the result
+	ShaderManager* m_pCompositeShaderManager;
+	// accumulation framebuffer - premultiplied colors with the
+	// revealage in alpha, the summed weights, and the depth
+	GLuint m_framebuffer;
+	GLuint m_accumulationTexture;
+	GLuint m_weightTexture;
+	GLuint m_depthRenderbuffer;
+	// size and sample count of the targets (0 = single sampled)
+	int m_width;
+	int m_height;
+	int m_samples;
+	// empty vertex array bound for the full screen triangle
+	GLuint m_emptyVertexArray;
+	// framebuffer the draws are composited into
+	GLint m_targetFramebuffer;
+};
@@ -8,20 +8,26 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #include "ViewManager.h"
+#include "ShadowManager.h"
+#include "HDRRenderTarget.h"
+#include "TransparencyRenderer.h"
+#include "FramePacer.h"
+#include "AmbientOcclusion.h"
+#include "InputQueue.h"
 
 // GLM Math Header inclusions
 #include <glm/glm.hpp>
 #include <glm/gtx/transform.hpp>
 #include <glm/gtc/type_ptr.hpp>    
 
+#include <iostream>
+
 // declaration of the global variables and defines
 namespace
 {
 	// Variables for window width and height
 	const int WINDOW_WIDTH = 1000;
 	const int WINDOW_HEIGHT = 800;
-	const char* g_ViewName = "view";
-	const char* g_ProjectionName = "projection";
 
 	// camera object used for viewing and interacting with
 	// the 3D scene
@@ -30,6 +36,10 @@ namespace
 	// these variables are used for mouse movement processing
 	float gLastX = WINDOW_WIDTH / 2.0f;
 	float gLastY = WINDOW_HEIGHT / 2.0f;
+
+	// framebuffer size of the window, updated when it is resized
+	int gFramebufferWidth = WINDOW_WIDTH;
+	int gFramebufferHeight = WINDOW_HEIGHT;
 	bool gFirstMouse = true;
 
 	// time between current frame and last frame
@@ -39,6 +49,268 @@ namespace
 	// if orthographic projection is on, this value will be
 	// true
 	bool bOrthographicProjection = false;
+
+	// half height of the orthographic projections
+	const float ORTHO_SIZE = 10.0f;
+
+	// fixed orthographic cameras shown next to the camera view in
+	// multi-view mode, matching the 1, 2 and 3 key presets
+	struct FIXED_VIEW
+	{
+		const char* name;
+		glm::vec3 position;
+		glm::vec3 front;
+		glm::vec3 up;
+	};
+	const FIXED_VIEW g_FixedViews[] =
+	{
+		{ "front", glm::vec3(0.0f, 4.0f, 10.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f) },
+		{ "side", glm::vec3(10.0f, 4.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f) },
+		{ "top", glm::vec3(0.0f, 10.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f) }
+	};
+	const int FIXED_VIEW_COUNT = sizeof(g_FixedViews) / sizeof(g_FixedViews[0]);
+
+	// fixed frame time of the virtual clock used while replaying
+	const float REPLAY_FRAME_TIME = 1.0f / 60.0f;
+	// camera input being recorded, or NULL
+	CameraPath* g_pRecordingPath = nullptr;
+	// camera input replayed instead of the live input, or NULL
+	const CameraPath* g_pReplayPath = nullptr;
+	// index of the next replayed event
+	int gReplayEvent = 0;
+	// frame within the recorded or replayed path
+	int gPathFrame = 0;
+	// time in seconds the scene is animated at - the virtual
+	// clock of the path while replaying
+	float gAnimationTime = 0.0f;
+	// input events pushed by the GLFW callbacks and consumed
+	// once per frame
+	InputQueue gInputQueue;
+	// keys held down in the consumed events - the camera keys
+	// come from the replayed events while a path is replaying
+	bool gKeyDown[GLFW_KEY_LAST + 1] = {};
+	// the left mouse button was pressed since the last pick,
+	// at this cursor position in window coordinates
+	bool gPickRequested = false;
+	double gPickX = 0.0;
+	double gPickY = 0.0;
+
+	/***********************************************************
+	 *  AdjustMovementSpeed()
+	 *
+	 *  This function is used to change the camera movement
+	 *  speed from a mouse wheel scroll.
+	 ***********************************************************/
+	void AdjustMovementSpeed(float yScrollDistance)
+	{
+		// Reduce effect of scroll adjustments
+		g_pCamera->MovementSpeed += yScrollDistance * 0.5f;  // Scale down speed adjustments
+
+		// Clamp movement speed to prevent extreme values
+		if (g_pCamera->MovementSpeed < 0.5f)  // Minimum speed is 0.5
+			g_pCamera->MovementSpeed = 0.5f;
+		if (g_pCamera->MovementSpeed > 20.0f) // Max speed is 20
+			g_pCamera->MovementSpeed = 20.0f;
+	}
+
+	/***********************************************************
+	 *  IsRecordedKey()
+	 *
+	 *  This function is used to check whether a key belongs
+	 *  to the camera input recorded into the camera paths.
+	 ***********************************************************/
+	bool IsRecordedKey(int key)
+	{
+		for (int i = 0; i < CameraPath::GetRecordedKeyCount(); i++)
+		{
+			if (CameraPath::GetRecordedKey(i) == key)
+			{
+				return(true);
+			}
+		}
+		return(false);
+	}
+
+	// Switch to Perspective mode when "P" is pressed
+	void ResetPerspectiveView(RENDER_SETTINGS* pRenderSettings)
+	{
+		bOrthographicProjection = false; // Enable Perspective mode
+		g_pCamera->Position = glm::vec3(0.0f, 5.0f, 8.0f); // Adjust position
+		g_pCamera->Front = glm::vec3(0.0f, -0.3f, -1.0f); // Tilt slightly downward
+		g_pCamera->Up = glm::vec3(0.0f, 1.0f, 0.0f);
+		g_pCamera->Zoom = 80; // Restore original zoom
+	}
+
+	// Switch to Orthographic mode when "O" is pressed
+	void ResetOrthographicView(RENDER_SETTINGS* pRenderSettings)
+	{
+		bOrthographicProjection = true; // Enable Orthographic mode
+		g_pCamera->Position = glm::vec3(0.0f, 10.0f, 0.0f); // Overhead view
+		g_pCamera->Front = glm::vec3(0.0f, -1.0f, 0.0f); // Look straight down
+		g_pCamera->Up = glm::vec3(0.0f, 0.0f, -1.0f); // Adjust orientation
+		g_pCamera->Zoom = 50; // Adjust zoom to fit the scene
+	}
+
+	// Front View (Ortho)
+	void MoveToFrontView(RENDER_SETTINGS* pRenderSettings)
+	{
+		bOrthographicProjection = true;
+		g_pCamera->Position = glm::mix(g_pCamera->Position, glm::vec3(0.0f, 4.0f, 10.0f), 0.5f);
+		g_pCamera->Front = glm::vec3(0.0f, 0.0f, -1.0f);
+		g_pCamera->Up = glm::vec3(0.0f, 1.0f, 0.0f);
+	}
+
+	// Side View (Ortho)
+	void MoveToSideView(RENDER_SETTINGS* pRenderSettings)
+	{
+		bOrthographicProjection = true;
+		g_pCamera->Position = glm::mix(g_pCamera->Position, glm::vec3(10.0f, 4.0f, 0.0f), 0.5f);
+		g_pCamera->Front = glm::vec3(-1.0f, 0.0f, 0.0f);
+		g_pCamera->Up = glm::vec3(0.0f, 1.0f, 0.0f);
+	}
+
+	// Top View (Ortho)
+	void MoveToTopView(RENDER_SETTINGS* pRenderSettings)
+	{
+		bOrthographicProjection = true;
+		g_pCamera->Position = glm::mix(g_pCamera->Position, glm::vec3(0.0f, 10.0f, 0.0f), 0.5f);
+		g_pCamera->Front = glm::vec3(0.0f, -1.0f, 0.0f);
+		g_pCamera->Up = glm::vec3(0.0f, 0.0f, -1.0f);
+	}
+
+	// Perspective View (Same as P)
+	void MoveToPerspectiveView(RENDER_SETTINGS* pRenderSettings)
+	{
+		bOrthographicProjection = false;
+		g_pCamera->Position = glm::mix(g_pCamera->Position, glm::vec3(0.0f, 5.0f, 8.0f), 0.5f);
+		g_pCamera->Front = glm::vec3(0.0f, -0.3f, -1.0f);
+		g_pCamera->Up = glm::vec3(0.0f, 1.0f, 0.0f);
+		g_pCamera->Zoom = 80;
+	}
+
+	// Cycle through the shadow quality tiers
+	void CycleShadowQuality(RENDER_SETTINGS* pRenderSettings)
+	{
+		pRenderSettings->shadowQuality = (pRenderSettings->shadowQuality + 1) % ShadowManager::GetQualityTierCount();
+	}
+
+	// Toggle the depth prepass
+	void ToggleDepthPrepass(RENDER_SETTINGS* pRenderSettings)
+	{
+		pRenderSettings->bDepthPrepass = !pRenderSettings->bDepthPrepass;
+		std::cout << "INFO: Depth prepass " << (pRenderSettings->bDepthPrepass ? "on" : "off") << std::endl;
+	}
+
+	// Toggle the overdraw visualization
+	void ToggleOverdraw(RENDER_SETTINGS* pRenderSettings)
+	{
+		pRenderSettings->bShowOverdraw = !pRenderSettings->bShowOverdraw;
+	}
+
+	// Cycle through the tone mapping operators
+	void CycleToneMapOperator(RENDER_SETTINGS* pRenderSettings)
+	{
+		pRenderSettings->toneMapOperator = (pRenderSettings->toneMapOperator + 1) % HDRRenderTarget::TONE_MAP_OPERATOR_COUNT;
+		std::cout << "INFO: Tone mapping " << HDRRenderTarget::GetToneMapOperatorName(pRenderSettings->toneMapOperator) << std::endl;
+	}
+
+	// Toggle the Hi-Z occlusion culling
+	void ToggleOcclusionCulling(RENDER_SETTINGS* pRenderSettings)
+	{
+		pRenderSettings->bOcclusionCulling = !pRenderSettings->bOcclusionCulling;
+		std::cout << "INFO: Occlusion culling " << (pRenderSettings->bOcclusionCulling ? "on" : "off") << std::endl;
+	}
+
+	// Toggle the multi-view layout
+	void ToggleMultiView(RENDER_SETTINGS* pRenderSettings)
+	{
+		pRenderSettings->bMultiView = !pRenderSettings->bMultiView;
+		std::cout << "INFO: Multi-view " << (pRenderSettings->bMultiView ? "on" : "off") << std::endl;
+	}
+
+	// Toggle the keyframe animations
+	void ToggleAnimation(RENDER_SETTINGS* pRenderSettings)
+	{
+		pRenderSettings->bAnimate = !pRenderSettings->bAnimate;
+		std::cout << "INFO: Animation " << (pRenderSettings->bAnimate ? "on" : "off") << std::endl;
+	}
+
+	// Cycle through the transparency modes
+	void CycleTransparencyMode(RENDER_SETTINGS* pRenderSettings)
+	{
+		pRenderSettings->transparencyMode = (pRenderSettings->transparencyMode + 1) % TransparencyRenderer::TRANSPARENCY_MODE_COUNT;
+		std::cout << "INFO: Transparency " << TransparencyRenderer::GetModeName(pRenderSettings->transparencyMode) << std::endl;
+	}
+
+	// Toggle the adaptive resolution - turning it off returns to
+	// the full window resolution
+	void ToggleAdaptiveResolution(RENDER_SETTINGS* pRenderSettings)
+	{
+		pRenderSettings->bAdaptiveResolution = !pRenderSettings->bAdaptiveResolution;
+		if (!pRenderSettings->bAdaptiveResolution)
+		{
+			pRenderSettings->resolutionScale = 1.0f;
+		}
+		std::cout << "INFO: Adaptive resolution " << (pRenderSettings->bAdaptiveResolution ? "on" : "off") << std::endl;
+	}
+
+	// Cycle through the present modes
+	void CyclePresentMode(RENDER_SETTINGS* pRenderSettings)
+	{
+		pRenderSettings->presentMode = (pRenderSettings->presentMode + 1) % FramePacer::PRESENT_MODE_COUNT;
+	}
+
+	// Toggle the baked lightmaps
+	void ToggleLightmaps(RENDER_SETTINGS* pRenderSettings)
+	{
+		pRenderSettings->bLightmaps = !pRenderSettings->bLightmaps;
+		std::cout << "INFO: Lightmaps " << (pRenderSettings->bLightmaps ? "on" : "off") << std::endl;
+	}
+
+	// Cycle through the ambient occlusion quality levels
+	void CycleAmbientOcclusion(RENDER_SETTINGS* pRenderSettings)
+	{
+		pRenderSettings->ambientOcclusionQuality = (pRenderSettings->ambientOcclusionQuality + 1) % AmbientOcclusion::QUALITY_COUNT;
+		std::cout << "INFO: Ambient occlusion " << AmbientOcclusion::GetQualityName(pRenderSettings->ambientOcclusionQuality) << std::endl;
+	}
+
+	// action run when a bound key is pressed
+	typedef void (*KEY_ACTION)(RENDER_SETTINGS* pRenderSettings);
+
+	// key bound to an action
+	struct KEY_BINDING
+	{
+		int key;
+		KEY_ACTION action;
+		// the action changes the shared rendering options, so it
+		// is skipped while they have not been set
+		bool bChangesSettings;
+	};
+
+	// actions run by the keys - the camera presets are recorded
+	// into the camera paths, the rendering options are not
+	const KEY_BINDING g_KeyBindings[] =
+	{
+		{ GLFW_KEY_P, &ResetPerspectiveView, false },
+		{ GLFW_KEY_O, &ResetOrthographicView, false },
+		{ GLFW_KEY_1, &MoveToFrontView, false },
+		{ GLFW_KEY_2, &MoveToSideView, false },
+		{ GLFW_KEY_3, &MoveToTopView, false },
+		{ GLFW_KEY_4, &MoveToPerspectiveView, false },
+		{ GLFW_KEY_F1, &CycleShadowQuality, true },
+		{ GLFW_KEY_F2, &ToggleDepthPrepass, true },
+		{ GLFW_KEY_F3, &ToggleOverdraw, true },
+		{ GLFW_KEY_F4, &CycleToneMapOperator, true },
+		{ GLFW_KEY_F5, &ToggleOcclusionCulling, true },
+		{ GLFW_KEY_F6, &ToggleMultiView, true },
+		{ GLFW_KEY_F7, &ToggleAnimation, true },
+		{ GLFW_KEY_F8, &CycleTransparencyMode, true },
+		{ GLFW_KEY_F9, &ToggleAdaptiveResolution, true },
+		{ GLFW_KEY_F10, &CyclePresentMode, true },
+		{ GLFW_KEY_F11, &ToggleLightmaps, true },
+		{ GLFW_KEY_F12, &CycleAmbientOcclusion, true }
+	};
+	const int KEY_BINDING_COUNT = sizeof(g_KeyBindings) / sizeof(g_KeyBindings[0]);
 }
 
 /***********************************************************
@@ -52,6 +324,10 @@ ViewManager::ViewManager(
 	// initialize the member variables
 	m_pShaderManager = pShaderManager;
 	m_pWindow = NULL;
+	m_pRenderSettings = NULL;
+	m_pRenderTimer = NULL;
+	m_viewMatrix = glm::mat4(1.0f);
+	m_projectionMatrix = glm::mat4(1.0f);
 	g_pCamera = new Camera();
 	// default camera view parameters
 	g_pCamera->Position = glm::vec3(0.5f, 5.5f, 10.0f);
@@ -71,6 +347,9 @@ ViewManager::~ViewManager()
 	// free up allocated memory
 	m_pShaderManager = NULL;
 	m_pWindow = NULL;
+	m_pRenderSettings = NULL;
+	StopRecording();
+	g_pReplayPath = nullptr;
 	if (NULL != g_pCamera)
 	{
 		delete g_pCamera;
@@ -101,12 +380,24 @@ GLFWwindow* ViewManager::CreateDisplayWindow(const char* windowTitle)
 	}
 	glfwMakeContextCurrent(window);
 
+	// this callback is used to receive keyboard events
+	glfwSetKeyCallback(window, &ViewManager::Key_Callback);
+
 	// this callback is used to receive mouse moving events
 	glfwSetCursorPosCallback(window, &ViewManager::Mouse_Position_Callback);
 
+	// this callback is used to receive mouse button events
+	glfwSetMouseButtonCallback(window, &ViewManager::Mouse_Button_Callback);
+
 	// this callback is used to receive mouse scroll wheel events
 	glfwSetScrollCallback(window, &ViewManager::Mouse_Scroll_Wheel_Callback);
 
+	// this callback is used to receive window resize events - the
+	// framebuffer can differ from the window size on high DPI
+	// displays, so its size is read back instead of assumed
+	glfwSetFramebufferSizeCallback(window, &ViewManager::Framebuffer_Size_Callback);
+	glfwGetFramebufferSize(window, &gFramebufferWidth, &gFramebufferHeight);
+
 	// tell GLFW to capture all mouse events
 	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 
@@ -114,6 +405,10 @@ GLFWwindow* ViewManager::CreateDisplayWindow(const char* windowTitle)
 	glEnable(GL_BLEND);
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
+	// enable z-depth and set the color the frames are cleared to
+	glEnable(GL_DEPTH_TEST);
+	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+
 	m_pWindow = window;
 
 	return(window);
@@ -124,185 +419,288 @@ GLFWwindow* ViewManager::CreateDisplayWindow(const char* windowTitle)
  *
  *  This method is automatically called from GLFW whenever
  *  the mouse is moved within the active GLFW display window.
+ *  The position is queued for the next frame.
  ***********************************************************/
 void ViewManager::Mouse_Position_Callback(GLFWwindow* window, double xMousePos, double yMousePos)
 {
-	if (gFirstMouse)
+	InputQueue::INPUT_EVENT event;
+	event.type = InputQueue::EVENT_MOUSE_MOVE;
+	event.key = 0;
+	event.x = xMousePos;
+	event.y = yMousePos;
+	gInputQueue.Push(event);
+}
+
+/***********************************************************
+ *  Key_Callback()
+ *
+ *  This method is automatically called from GLFW whenever a
+ *  key is pressed or released within the active GLFW display
+ *  window.  The repeats of a held key are not queued, so
+ *  every queued press is a real edge.
+ ***********************************************************/
+void ViewManager::Key_Callback(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+	if ((key < 0) || (key > GLFW_KEY_LAST) || (action == GLFW_REPEAT))
 	{
-		gLastX = xMousePos;
-		gLastY = yMousePos;
-		gFirstMouse = false;
+		return;
 	}
 
-	// Reduce sensitivity by applying a smaller scale factor
-	float sensitivity = 0.1f;  // Reduce to 10% of default movement
-	float xOffset = (xMousePos - gLastX) * sensitivity;
-	float yOffset = (gLastY - yMousePos) * sensitivity; // Reversed since y-coordinates go bottom to top
-
-	gLastX = xMousePos;
-	gLastY = yMousePos;
+	InputQueue::INPUT_EVENT event;
+	event.type = (action == GLFW_PRESS) ? InputQueue::EVENT_KEY_DOWN : InputQueue::EVENT_KEY_UP;
+	event.key = key;
+	event.x = 0.0;
+	event.y = 0.0;
+	gInputQueue.Push(event);
+}
 
-	// Move the camera with reduced mouse movement sensitivity
-	g_pCamera->ProcessMouseMovement(xOffset, yOffset);
+/***********************************************************
+ *  Mouse_Button_Callback()
+ *
+ *  This method is automatically called from GLFW whenever a
+ *  mouse button is pressed or released within the active
+ *  GLFW display window.  The cursor position is queued with
+ *  the button, so a pick uses where the click happened.
+ ***********************************************************/
+void ViewManager::Mouse_Button_Callback(GLFWwindow* window, int button, int action, int mods)
+{
+	InputQueue::INPUT_EVENT event;
+	event.type = (action == GLFW_PRESS) ? InputQueue::EVENT_MOUSE_BUTTON_DOWN : InputQueue::EVENT_MOUSE_BUTTON_UP;
+	event.key = button;
+	glfwGetCursorPos(window, &event.x, &event.y);
+	gInputQueue.Push(event);
 }
 
 
 
+/***********************************************************
+ *  Framebuffer_Size_Callback()
+ *
+ *  This method is automatically called from GLFW whenever
+ *  the window is resized, with the new size of its
+ *  framebuffer in pixels.
+ ***********************************************************/
+void ViewManager::Framebuffer_Size_Callback(GLFWwindow* window, int width, int height)
+{
+	gFramebufferWidth = width;
+	gFramebufferHeight = height;
+
+	// the offscreen targets follow the size read every frame,
+	// only the window itself is set here
+	glViewport(0, 0, width, height);
+}
+
 /***********************************************************
  *  Mouse_Scroll_Wheel_Callback()
  *
  *  This method is automatically called from GLFW whenever
  *  the mouse wheel is scrolled within the active GLFW display window.
+ *  The scroll offsets are queued for the next frame.
  ***********************************************************/
 void ViewManager::Mouse_Scroll_Wheel_Callback(GLFWwindow* window, double x, double yScrollDistance)
 {
-	if (g_pCamera)
-	{
-		// Reduce effect of scroll adjustments
-		g_pCamera->MovementSpeed += yScrollDistance * 0.5f;  // Scale down speed adjustments
-
-		// Clamp movement speed to prevent extreme values
-		if (g_pCamera->MovementSpeed < 0.5f)  // Minimum speed is 0.5
-			g_pCamera->MovementSpeed = 0.5f;
-		if (g_pCamera->MovementSpeed > 20.0f) // Max speed is 20
-			g_pCamera->MovementSpeed = 20.0f;
-	}
+	InputQueue::INPUT_EVENT event;
+	event.type = InputQueue::EVENT_SCROLL;
+	event.key = 0;
+	event.x = x;
+	event.y = yScrollDistance;
+	gInputQueue.Push(event);
 }
 
 
 /***********************************************************
- *  ProcessKeyboardEvents()
+ *  ProcessInputEvents()
  *
- *  This method is called to process any keyboard events
- *  that may be waiting in the event queue.
+ *  This method is called to process the input events queued
+ *  since the last frame, and then to move the camera with
+ *  the keys that are held down.  When nothing happened the
+ *  queue is empty and only the held keys are checked.
  ***********************************************************/
-void ViewManager::ProcessKeyboardEvents()
+void ViewManager::ProcessInputEvents()
 {
-	// Close the window if the escape key has been pressed
-	if (glfwGetKey(m_pWindow, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+	InputQueue::INPUT_EVENT event;
+	int eventCount = 0;
+	while (gInputQueue.Pop(event))
 	{
-		glfwSetWindowShouldClose(m_pWindow, true);
+		eventCount++;
+		switch (event.type)
+		{
+		case InputQueue::EVENT_KEY_DOWN:
+		case InputQueue::EVENT_KEY_UP:
+			ProcessLiveKey(event.key, event.type == InputQueue::EVENT_KEY_DOWN);
+			break;
+		case InputQueue::EVENT_MOUSE_MOVE:
+			ProcessMouseMove(event.x, event.y);
+			break;
+		case InputQueue::EVENT_MOUSE_BUTTON_DOWN:
+			if ((event.key == GLFW_MOUSE_BUTTON_LEFT) && (g_pReplayPath == nullptr))
+			{
+				gPickRequested = true;
+				gPickX = event.x;
+				gPickY = event.y;
+			}
+			break;
+		case InputQueue::EVENT_MOUSE_BUTTON_UP:
+			break;
+		case InputQueue::EVENT_SCROLL:
+			// the replayed path owns the camera
+			if (g_pReplayPath == nullptr)
+			{
+				if (g_pRecordingPath != nullptr)
+				{
+					g_pRecordingPath->AddScrollEvent(gPathFrame, (float)event.y);
+				}
+				AdjustMovementSpeed((float)event.y);
+			}
+			break;
+		}
 	}
 
-	// If the camera object is null, then exit this method
-	if (g_pCamera == nullptr)
+	if (NULL != m_pRenderTimer)
 	{
-		return;
+		m_pRenderTimer->SetCounter("input events", (double)eventCount);
+		m_pRenderTimer->SetCounter("input events dropped", (double)gInputQueue.GetDroppedCount());
 	}
 
 	// Reduce movement speed 
 	float movementSpeed = (g_pCamera->MovementSpeed * 0.3f) * gDeltaTime;
 
 	// Process camera movement (WASD for direction, QE for vertical movement)
-	if (glfwGetKey(m_pWindow, GLFW_KEY_W) == GLFW_PRESS)
+	if (gKeyDown[GLFW_KEY_W])
 		g_pCamera->ProcessKeyboard(FORWARD, movementSpeed);
-	if (glfwGetKey(m_pWindow, GLFW_KEY_S) == GLFW_PRESS)
+	if (gKeyDown[GLFW_KEY_S])
 		g_pCamera->ProcessKeyboard(BACKWARD, movementSpeed);
-	if (glfwGetKey(m_pWindow, GLFW_KEY_A) == GLFW_PRESS)
+	if (gKeyDown[GLFW_KEY_A])
 		g_pCamera->ProcessKeyboard(LEFT, movementSpeed);
-	if (glfwGetKey(m_pWindow, GLFW_KEY_D) == GLFW_PRESS)
+	if (gKeyDown[GLFW_KEY_D])
 		g_pCamera->ProcessKeyboard(RIGHT, movementSpeed);
-	if (glfwGetKey(m_pWindow, GLFW_KEY_Q) == GLFW_PRESS)
+	if (gKeyDown[GLFW_KEY_Q])
 		g_pCamera->ProcessKeyboard(UP, movementSpeed);
-	if (glfwGetKey(m_pWindow, GLFW_KEY_E) == GLFW_PRESS)
+	if (gKeyDown[GLFW_KEY_E])
 		g_pCamera->ProcessKeyboard(DOWN, movementSpeed);
+}
 
-	// Toggle between Perspective and Orthographic views
-	static bool pKeyPressed = false;
-	static bool oKeyPressed = false;
-
-	// Switch to Perspective mode when "P" is pressed
-	if (glfwGetKey(m_pWindow, GLFW_KEY_P) == GLFW_PRESS && !pKeyPressed)
-	{
-		bOrthographicProjection = false; // Enable Perspective mode
-		g_pCamera->Position = glm::vec3(0.0f, 5.0f, 8.0f); // Adjust position
-		g_pCamera->Front = glm::vec3(0.0f, -0.3f, -1.0f); // Tilt slightly downward
-		g_pCamera->Up = glm::vec3(0.0f, 1.0f, 0.0f);
-		g_pCamera->Zoom = 80; // Restore original zoom
-		pKeyPressed = true;
-	}
-	if (glfwGetKey(m_pWindow, GLFW_KEY_P) == GLFW_RELEASE)
+/***********************************************************
+ *  ProcessLiveKey()
+ *
+ *  This method is used for handling a key event from the
+ *  window.  While a path is replaying, its events drive the
+ *  camera keys and the live ones are ignored.  While the
+ *  input is recorded, the camera keys are added to the path
+ *  in the frame they are handled in.
+ ***********************************************************/
+void ViewManager::ProcessLiveKey(int key, bool bDown)
+{
+	// Close the window if the escape key has been pressed
+	if ((key == GLFW_KEY_ESCAPE) && bDown)
 	{
-		pKeyPressed = false;
+		glfwSetWindowShouldClose(m_pWindow, true);
+		return;
 	}
 
-	// Switch to Orthographic mode when "O" is pressed
-	if (glfwGetKey(m_pWindow, GLFW_KEY_O) == GLFW_PRESS && !oKeyPressed)
+	bool bRecordedKey = IsRecordedKey(key);
+	if (bRecordedKey && (g_pReplayPath != nullptr))
 	{
-		bOrthographicProjection = true; // Enable Orthographic mode
-		g_pCamera->Position = glm::vec3(0.0f, 10.0f, 0.0f); // Overhead view
-		g_pCamera->Front = glm::vec3(0.0f, -1.0f, 0.0f); // Look straight down
-		g_pCamera->Up = glm::vec3(0.0f, 0.0f, -1.0f); // Adjust orientation
-		g_pCamera->Zoom = 50; // Adjust zoom to fit the scene
-		oKeyPressed = true;
+		return;
 	}
-	if (glfwGetKey(m_pWindow, GLFW_KEY_O) == GLFW_RELEASE)
+	if (bRecordedKey && (g_pRecordingPath != nullptr) && (bDown != gKeyDown[key]))
 	{
-		oKeyPressed = false;
+		g_pRecordingPath->AddKeyEvent(gPathFrame, key, bDown);
 	}
 
-	
-	static bool key1Pressed = false;
-	static bool key2Pressed = false;
-	static bool key3Pressed = false;
-	static bool key4Pressed = false;
+	HandleKeyEvent(key, bDown);
+}
 
-	// Front View (Ortho)
-	if (glfwGetKey(m_pWindow, GLFW_KEY_1) == GLFW_PRESS && !key1Pressed)
-	{
-		bOrthographicProjection = true;
-		g_pCamera->Position = glm::mix(g_pCamera->Position, glm::vec3(0.0f, 4.0f, 10.0f), 0.5f);
-		g_pCamera->Front = glm::vec3(0.0f, 0.0f, -1.0f);
-		g_pCamera->Up = glm::vec3(0.0f, 1.0f, 0.0f);
-		key1Pressed = true;
-	}
-	if (glfwGetKey(m_pWindow, GLFW_KEY_1) == GLFW_RELEASE)
+/***********************************************************
+ *  HandleKeyEvent()
+ *
+ *  This method is used for updating the state of a key from
+ *  a live or replayed event, and running the action bound to
+ *  the key when it goes down.
+ ***********************************************************/
+void ViewManager::HandleKeyEvent(int key, bool bDown)
+{
+	bool bPressed = bDown && !gKeyDown[key];
+	gKeyDown[key] = bDown;
+	if (!bPressed)
 	{
-		key1Pressed = false;
+		return;
 	}
 
-	// Side View (Ortho)
-	if (glfwGetKey(m_pWindow, GLFW_KEY_2) == GLFW_PRESS && !key2Pressed)
+	for (int i = 0; i < KEY_BINDING_COUNT; i++)
 	{
-		bOrthographicProjection = true;
-		g_pCamera->Position = glm::mix(g_pCamera->Position, glm::vec3(10.0f, 4.0f, 0.0f), 0.5f);
-		g_pCamera->Front = glm::vec3(-1.0f, 0.0f, 0.0f);
-		g_pCamera->Up = glm::vec3(0.0f, 1.0f, 0.0f);
-		key2Pressed = true;
-	}
-	if (glfwGetKey(m_pWindow, GLFW_KEY_2) == GLFW_RELEASE)
-	{
-		key2Pressed = false;
+		const KEY_BINDING& binding = g_KeyBindings[i];
+		if (binding.key != key)
+		{
+			continue;
+		}
+		if (binding.bChangesSettings && (m_pRenderSettings == nullptr))
+		{
+			return;
+		}
+		binding.action(m_pRenderSettings);
+		return;
 	}
+}
 
-	// Top View (Ortho)
-	if (glfwGetKey(m_pWindow, GLFW_KEY_3) == GLFW_PRESS && !key3Pressed)
-	{
-		bOrthographicProjection = true;
-		g_pCamera->Position = glm::mix(g_pCamera->Position, glm::vec3(0.0f, 10.0f, 0.0f), 0.5f);
-		g_pCamera->Front = glm::vec3(0.0f, -1.0f, 0.0f);
-		g_pCamera->Up = glm::vec3(0.0f, 0.0f, -1.0f);
-		key3Pressed = true;
-	}
-	if (glfwGetKey(m_pWindow, GLFW_KEY_3) == GLFW_RELEASE)
+/***********************************************************
+ *  ProcessMouseMove()
+ *
+ *  This method is used for turning a queued cursor position
+ *  into a camera rotation.
+ ***********************************************************/
+void ViewManager::ProcessMouseMove(double xMousePos, double yMousePos)
+{
+	if (gFirstMouse)
 	{
-		key3Pressed = false;
+		gLastX = xMousePos;
+		gLastY = yMousePos;
+		gFirstMouse = false;
 	}
 
-	// Perspective View (Same as P)
-	if (glfwGetKey(m_pWindow, GLFW_KEY_4) == GLFW_PRESS && !key4Pressed)
+	// Reduce sensitivity by applying a smaller scale factor
+	float sensitivity = 0.1f;  // Reduce to 10% of default movement
+	float xOffset = (xMousePos - gLastX) * sensitivity;
+	float yOffset = (gLastY - yMousePos) * sensitivity; // Reversed since y-coordinates go bottom to top
+
+	gLastX = xMousePos;
+	gLastY = yMousePos;
+
+	// the replayed path owns the camera
+	if (g_pReplayPath != nullptr)
 	{
-		bOrthographicProjection = false;
-		g_pCamera->Position = glm::mix(g_pCamera->Position, glm::vec3(0.0f, 5.0f, 8.0f), 0.5f);
-		g_pCamera->Front = glm::vec3(0.0f, -0.3f, -1.0f);
-		g_pCamera->Up = glm::vec3(0.0f, 1.0f, 0.0f);
-		g_pCamera->Zoom = 80;
-		key4Pressed = true;
+		return;
 	}
-	if (glfwGetKey(m_pWindow, GLFW_KEY_4) == GLFW_RELEASE)
+
+	if (g_pRecordingPath != nullptr)
 	{
-		key4Pressed = false;
+		g_pRecordingPath->AddMouseEvent(gPathFrame, xOffset, yOffset);
 	}
+
+	// Move the camera with reduced mouse movement sensitivity
+	g_pCamera->ProcessMouseMovement(xOffset, yOffset);
+}
+
+/***********************************************************
+ *  SetRenderSettings()
+ *
+ *  This method is used for setting the shared rendering
+ *  options that are changed from the keyboard.
+ ***********************************************************/
+void ViewManager::SetRenderSettings(RENDER_SETTINGS* pRenderSettings)
+{
+	m_pRenderSettings = pRenderSettings;
+}
+
+/***********************************************************
+ *  SetRenderTimer()
+ *
+ *  This method is used for setting the frame timing collector
+ *  that the input processing is measured and counted with.
+ ***********************************************************/
+void ViewManager::SetRenderTimer(RenderTimer* pRenderTimer)
+{
+	m_pRenderTimer = pRenderTimer;
 }
 
 /***********************************************************
@@ -317,13 +715,27 @@ void ViewManager::PrepareSceneView()
 	glm::mat4 view;
 	glm::mat4 projection;
 
-	// per-frame timing
-	float currentFrame = glfwGetTime();
-	gDeltaTime = currentFrame - gLastFrame;
-	gLastFrame = currentFrame;
+	if (g_pReplayPath != nullptr)
+	{
+		// the virtual clock moves the camera and the animations
+		// the same on every replay
+		gDeltaTime = REPLAY_FRAME_TIME;
+		gAnimationTime = gPathFrame * REPLAY_FRAME_TIME;
+		ReplayFrameEvents();
+	}
+	else
+	{
+		// per-frame timing
+		float currentFrame = glfwGetTime();
+		gDeltaTime = currentFrame - gLastFrame;
+		gLastFrame = currentFrame;
+		gAnimationTime = currentFrame;
+	}
 
-	// process any keyboard events that may be waiting in the event queue
-	ProcessKeyboardEvents();
+	// process the input events that are waiting in the event queue
+	if (NULL != m_pRenderTimer) m_pRenderTimer->BeginPass("input");
+	ProcessInputEvents();
+	if (NULL != m_pRenderTimer) m_pRenderTimer->EndPass();
 
 	// get the current view matrix from the camera
 	view = g_pCamera->GetViewMatrix();
@@ -332,26 +744,334 @@ void ViewManager::PrepareSceneView()
 	if (bOrthographicProjection)
 	{
 		// Orthographic projection (2D-like view)
-		float orthoSize = 10.0f;
-		projection = glm::ortho(-orthoSize, orthoSize, -orthoSize, orthoSize, 0.1f, 100.0f);
+		projection = glm::ortho(-ORTHO_SIZE, ORTHO_SIZE, -ORTHO_SIZE, ORTHO_SIZE, 0.1f, 100.0f);
 	}
 	else
 	{
 		// Perspective projection (3D view)
+		// a minimized window has no height, so the last aspect
+		// ratio is kept for it
+		static GLfloat aspectRatio = (GLfloat)WINDOW_WIDTH / (GLfloat)WINDOW_HEIGHT;
+		if ((gFramebufferWidth > 0) && (gFramebufferHeight > 0))
+		{
+			aspectRatio = (GLfloat)gFramebufferWidth / (GLfloat)gFramebufferHeight;
+		}
 		projection = glm::perspective(glm::radians(g_pCamera->Zoom),
-			(GLfloat)WINDOW_WIDTH / (GLfloat)WINDOW_HEIGHT, 0.1f, 100.0f);
+			aspectRatio, 0.1f, 100.0f);
 	}
 
-	// If the shader manager object is valid
-	if (m_pShaderManager != NULL)
+	// keep the matrices for the passes that need the camera - the
+	// scene manager passes them to the shaders in the camera block
+	m_viewMatrix = view;
+	m_projectionMatrix = projection;
+
+	gPathFrame++;
+	if ((g_pReplayPath != nullptr) && (gPathFrame >= g_pReplayPath->GetFrameCount()))
 	{
-		// Set the view matrix into the shader for proper rendering
-		m_pShaderManager->setMat4Value(g_ViewName, view);
+		// hand the camera back to the live input, with the
+		// replayed keys released
+		g_pReplayPath = nullptr;
+		gLastFrame = glfwGetTime();
+		for (int i = 0; i < CameraPath::GetRecordedKeyCount(); i++)
+		{
+			gKeyDown[CameraPath::GetRecordedKey(i)] = false;
+		}
+	}
+}
 
-		// Set the projection matrix into the shader
-		m_pShaderManager->setMat4Value(g_ProjectionName, projection);
+/***********************************************************
+ *  GetSceneViews()
+ *
+ *  This method is used for getting the views rendered into
+ *  a framebuffer of the passed in size.  Normally the camera
+ *  view covers all of it.  In multi-view mode the framebuffer
+ *  is split 2x2 into the front, side and top orthographic
+ *  views and the camera view in the bottom right quarter.
+ ***********************************************************/
+void ViewManager::GetSceneViews(int width, int height, std::vector<SCENE_VIEW>& views) const
+{
+	views.clear();
+
+	SCENE_VIEW cameraView;
+	cameraView.name = "camera";
+	cameraView.view = m_viewMatrix;
+	cameraView.projection = m_projectionMatrix;
+	cameraView.position = g_pCamera->Position;
+	cameraView.x = 0;
+	cameraView.y = 0;
+	cameraView.width = width;
+	cameraView.height = height;
 
-		// Set the view position of the camera into the shader
-		m_pShaderManager->setVec3Value("viewPosition", g_pCamera->Position);
+	if ((m_pRenderSettings == nullptr) || !m_pRenderSettings->bMultiView)
+	{
+		views.push_back(cameraView);
+		return;
+	}
+
+	int halfWidth = width / 2;
+	int halfHeight = height / 2;
+
+	// the camera projection keeps the window aspect ratio, which
+	// every quarter of the window shares
+	cameraView.x = halfWidth;
+	cameraView.width = width - halfWidth;
+	cameraView.height = halfHeight;
+	views.push_back(cameraView);
+
+	float aspect = (halfHeight > 0) ? (float)halfWidth / (float)halfHeight : 1.0f;
+	for (int i = 0; i < FIXED_VIEW_COUNT; i++)
+	{
+		const FIXED_VIEW& fixedView = g_FixedViews[i];
+
+		// top left, top right, then bottom left
+		SCENE_VIEW sceneView;
+		sceneView.name = fixedView.name;
+		sceneView.view = glm::lookAt(fixedView.position, fixedView.position + fixedView.front, fixedView.up);
+		sceneView.projection = glm::ortho(-ORTHO_SIZE * aspect, ORTHO_SIZE * aspect,
+			-ORTHO_SIZE, ORTHO_SIZE, 0.1f, 100.0f);
+		sceneView.position = fixedView.position;
+		sceneView.x = (i == 1) ? halfWidth : 0;
+		sceneView.y = (i < 2) ? halfHeight : 0;
+		sceneView.width = (i == 1) ? width - halfWidth : halfWidth;
+		sceneView.height = (i < 2) ? height - halfHeight : halfHeight;
+		views.push_back(sceneView);
+	}
+}
+
+/***********************************************************
+ *  GetPickRay()
+ *
+ *  This method is used for getting the ray from the camera
+ *  through the cursor, when the left mouse button has been
+ *  pressed.  While the cursor is captured for looking
+ *  around, the ray goes through the center of the view.
+ *  In multi-view mode the ray starts from the view under
+ *  the cursor.
+ ***********************************************************/
+bool ViewManager::GetPickRay(glm::vec3& origin, glm::vec3& direction)
+{
+	bool bClicked = gPickRequested;
+	gPickRequested = false;
+	if (!bClicked || (g_pReplayPath != nullptr))
+	{
+		return(false);
+	}
+
+	glm::vec2 cursor = glm::vec2(0.0f);
+	glm::mat4 view = m_viewMatrix;
+	glm::mat4 projection = m_projectionMatrix;
+	if (glfwGetInputMode(m_pWindow, GLFW_CURSOR) != GLFW_CURSOR_DISABLED)
+	{
+		double xPosition = gPickX;
+		double yPosition = gPickY;
+		int width = 1;
+		int height = 1;
+		glfwGetWindowSize(m_pWindow, &width, &height);
+
+		// the views are laid out in window coordinates from the bottom
+		float windowX = (float)xPosition;
+		float windowY = (float)(height - yPosition);
+		std::vector<SCENE_VIEW> views;
+		GetSceneViews(width, height, views);
+		for (int i = 0; i < (int)views.size(); i++)
+		{
+			const SCENE_VIEW& sceneView = views[i];
+			if ((windowX >= sceneView.x) && (windowX < sceneView.x + sceneView.width) &&
+				(windowY >= sceneView.y) && (windowY < sceneView.y + sceneView.height))
+			{
+				view = sceneView.view;
+				projection = sceneView.projection;
+				cursor = glm::vec2(
+					2.0f * (windowX - sceneView.x) / sceneView.width - 1.0f,
+					2.0f * (windowY - sceneView.y) / sceneView.height - 1.0f);
+				break;
+			}
+		}
+	}
+
+	// unproject the cursor on the near and the far plane, which
+	// works for the perspective and the orthographic projection
+	glm::mat4 inverseViewProjection = glm::inverse(projection * view);
+	glm::vec4 nearPoint = inverseViewProjection * glm::vec4(cursor, -1.0f, 1.0f);
+	glm::vec4 farPoint = inverseViewProjection * glm::vec4(cursor, 1.0f, 1.0f);
+	origin = glm::vec3(nearPoint) / nearPoint.w;
+	direction = glm::normalize(glm::vec3(farPoint) / farPoint.w - origin);
+	return(true);
+}
+
+/***********************************************************
+ *  GetCameraPose()
+ *
+ *  This method is used for getting the complete state of
+ *  the camera and the projection mode.
+ ***********************************************************/
+CameraPath::CAMERA_POSE ViewManager::GetCameraPose() const
+{
+	CameraPath::CAMERA_POSE pose;
+	pose.position = g_pCamera->Position;
+	pose.front = g_pCamera->Front;
+	pose.up = g_pCamera->Up;
+	pose.yaw = g_pCamera->Yaw;
+	pose.pitch = g_pCamera->Pitch;
+	pose.zoom = g_pCamera->Zoom;
+	pose.movementSpeed = g_pCamera->MovementSpeed;
+	pose.bOrthographic = bOrthographicProjection;
+	return(pose);
+}
+
+/***********************************************************
+ *  SetCameraPose()
+ *
+ *  This method is used for setting the complete state of
+ *  the camera and the projection mode.
+ ***********************************************************/
+void ViewManager::SetCameraPose(const CameraPath::CAMERA_POSE& pose)
+{
+	g_pCamera->Position = pose.position;
+	g_pCamera->Front = pose.front;
+	g_pCamera->Up = pose.up;
+	g_pCamera->Yaw = pose.yaw;
+	g_pCamera->Pitch = pose.pitch;
+	g_pCamera->Zoom = pose.zoom;
+	g_pCamera->MovementSpeed = pose.movementSpeed;
+	bOrthographicProjection = pose.bOrthographic;
+}
+
+/***********************************************************
+ *  PressKey()
+ *
+ *  This method is used for pressing and releasing a key
+ *  without the window, which runs its bound action once.
+ ***********************************************************/
+void ViewManager::PressKey(int key)
+{
+	HandleKeyEvent(key, true);
+	HandleKeyEvent(key, false);
+}
+
+/***********************************************************
+ *  StartRecording()
+ *
+ *  This method is used for starting to record the camera
+ *  input.  The current pose is recorded first, so that the
+ *  replay starts from the same view.
+ ***********************************************************/
+void ViewManager::StartRecording(const std::string& filename)
+{
+	StopRecording();
+
+	m_recordingFilename = filename;
+	g_pRecordingPath = new CameraPath();
+	gPathFrame = 0;
+	g_pRecordingPath->AddPoseEvent(0, GetCameraPose());
+
+	// keys already held are recorded as pressed on the first frame
+	for (int i = 0; i < CameraPath::GetRecordedKeyCount(); i++)
+	{
+		int key = CameraPath::GetRecordedKey(i);
+		if (gKeyDown[key])
+		{
+			g_pRecordingPath->AddKeyEvent(0, key, true);
+		}
+	}
+
+	std::cout << "INFO: Recording camera path to " << filename << std::endl;
+}
+
+/***********************************************************
+ *  StopRecording()
+ *
+ *  This method is used for saving the recorded camera path
+ *  and ending the recording.
+ ***********************************************************/
+void ViewManager::StopRecording()
+{
+	if (g_pRecordingPath == nullptr)
+	{
+		return;
+	}
+
+	g_pRecordingPath->SetFrameCount(gPathFrame);
+	if (g_pRecordingPath->Save(m_recordingFilename))
+	{
+		std::cout << "INFO: Saved " << gPathFrame << " frames of camera path to " << m_recordingFilename << std::endl;
+	}
+	delete g_pRecordingPath;
+	g_pRecordingPath = nullptr;
+}
+
+/***********************************************************
+ *  StartReplay()
+ *
+ *  This method is used for starting to drive the camera
+ *  from the passed in path.  The live camera input is
+ *  ignored until every frame of the path has been rendered.
+ ***********************************************************/
+void ViewManager::StartReplay(const CameraPath* pPath)
+{
+	g_pReplayPath = pPath;
+	gReplayEvent = 0;
+	gPathFrame = 0;
+	for (int i = 0; i < CameraPath::GetRecordedKeyCount(); i++)
+	{
+		gKeyDown[CameraPath::GetRecordedKey(i)] = false;
+	}
+}
+
+/***********************************************************
+ *  IsReplaying()
+ *
+ *  This method is used for checking whether a path is still
+ *  driving the camera.
+ ***********************************************************/
+bool ViewManager::IsReplaying() const
+{
+	return(g_pReplayPath != nullptr);
+}
+
+/***********************************************************
+ *  GetAnimationTime()
+ *
+ *  This method is used for getting the time the scene of the
+ *  prepared frame is animated at, which follows the frames
+ *  of the path while one is replaying.
+ ***********************************************************/
+float ViewManager::GetAnimationTime() const
+{
+	return(gAnimationTime);
+}
+
+/***********************************************************
+ *  ReplayFrameEvents()
+ *
+ *  This method is used for applying the replayed events of
+ *  the current frame before the keyboard is processed.
+ ***********************************************************/
+void ViewManager::ReplayFrameEvents()
+{
+	const std::vector<CameraPath::CAMERA_EVENT>& events = g_pReplayPath->GetEvents();
+
+	while ((gReplayEvent < (int)events.size()) && (events[gReplayEvent].frame <= gPathFrame))
+	{
+		const CameraPath::CAMERA_EVENT& event = events[gReplayEvent];
+		switch (event.type)
+		{
+		case CameraPath::EVENT_KEY_DOWN:
+			HandleKeyEvent(event.key, true);
+			break;
+		case CameraPath::EVENT_KEY_UP:
+			HandleKeyEvent(event.key, false);
+			break;
+		case CameraPath::EVENT_MOUSE_MOVE:
+			g_pCamera->ProcessMouseMovement(event.x, event.y);
+			break;
+		case CameraPath::EVENT_SCROLL:
+			AdjustMovementSpeed(event.y);
+			break;
+		case CameraPath::EVENT_POSE:
+			SetCameraPose(event.pose);
+			break;
+		}
+		gReplayEvent++;
 	}
 }
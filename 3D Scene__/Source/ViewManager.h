@@ -10,8 +10,14 @@
 #pragma once
 
 #include "ShaderManager.h"
+#include "RenderSettings.h"
+#include "RenderTimer.h"
+#include "CameraPath.h"
+#include "SceneView.h"
 #include "camera.h"
 
+#include <vector>
+
 // GLFW library
 #include "GLFW/glfw3.h"
 
@@ -26,11 +32,21 @@ public:
 	// Mouse position callback for mouse interaction with the 3D scene
 	static void Mouse_Position_Callback(GLFWwindow* window, double xMousePos, double yMousePos);
 
+	// Mouse button callback for picking the objects of the 3D scene
+	static void Mouse_Button_Callback(GLFWwindow* window, int button, int action, int mods);
+
+	// Keyboard callback for the camera keys and the key bindings
+	static void Key_Callback(GLFWwindow* window, int key, int scancode, int action, int mods);
+
 	// Mouse scroll wheel callback for zooming and movement speed
 	static void Mouse_Scroll_Wheel_Callback(GLFWwindow* window, double x, double yScrollDistance);
 
-	// Process keyboard events for user input
-	void ProcessKeyboardEvents();
+	// Framebuffer size callback for keeping the projection aspect
+	// ratio and the viewport in step with the resized window
+	static void Framebuffer_Size_Callback(GLFWwindow* window, int width, int height);
+
+	// Process the queued input events and the held camera keys
+	void ProcessInputEvents();
 
 	// Create the initial OpenGL display window
 	GLFWwindow* CreateDisplayWindow(const char* windowTitle);
@@ -38,11 +54,70 @@ public:
 	// Prepare the conversion from 3D object display to 2D scene display
 	void PrepareSceneView();
 
+	// Set the shared rendering options changed from the keyboard
+	void SetRenderSettings(RENDER_SETTINGS* pRenderSettings);
+
+	// Set the frame timing collector the input is measured with
+	void SetRenderTimer(RenderTimer* pRenderTimer);
+
+	// Get the camera matrices calculated for the current frame
+	glm::mat4 GetViewMatrix() const { return m_viewMatrix; }
+	glm::mat4 GetProjectionMatrix() const { return m_projectionMatrix; }
+
+	// Get the views rendered into a framebuffer of the passed in
+	// size - the camera view first, then the fixed multi-view ones
+	void GetSceneViews(int width, int height, std::vector<SCENE_VIEW>& views) const;
+
+	// Get the ray from the camera through the cursor when the
+	// left mouse button was clicked since the last frame
+	bool GetPickRay(glm::vec3& origin, glm::vec3& direction);
+
+	// Get and set the complete camera state
+	CameraPath::CAMERA_POSE GetCameraPose() const;
+	void SetCameraPose(const CameraPath::CAMERA_POSE& pose);
+
+	// Run the action bound to a key as if it was pressed, such
+	// as one of the camera presets
+	void PressKey(int key);
+
+	// Record the camera input into a path file until stopped
+	void StartRecording(const std::string& filename);
+	void StopRecording();
+
+	// Drive the camera from a path with a fixed frame time
+	// instead of the live input - the path must stay valid
+	// until the replay has finished
+	void StartReplay(const CameraPath* pPath);
+	bool IsReplaying() const;
+	// Time the scene is animated at in the prepared frame,
+	// from the fixed frame time while a path is replaying
+	float GetAnimationTime() const;
+
 private:
+	// Handle a key event from the window, recording it or
+	// ignoring it while a path is replaying
+	void ProcessLiveKey(int key, bool bDown);
+	// Update the state of a live or replayed key and run the
+	// action bound to it when it is pressed
+	void HandleKeyEvent(int key, bool bDown);
+	// Rotate the camera from a queued cursor position
+	void ProcessMouseMove(double xMousePos, double yMousePos);
+	// Apply the replayed events of the current frame
+	void ReplayFrameEvents();
+
 	// Pointer to shader manager object
 	ShaderManager* m_pShaderManager;
 	// Active OpenGL display window
 	GLFWwindow* m_pWindow;
 	// Projection mode flag (true = orthographic, false = perspective)
 	bool bOrthographicProjection;
+	// Shared rendering options
+	RENDER_SETTINGS* m_pRenderSettings;
+	// Frame timing collector, or NULL
+	RenderTimer* m_pRenderTimer;
+	// Camera matrices calculated for the current frame
+	glm::mat4 m_viewMatrix;
+	glm::mat4 m_projectionMatrix;
+	// File the recorded camera path is saved to
+	std::string m_recordingFilename;
 };
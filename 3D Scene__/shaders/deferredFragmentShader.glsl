@@ -0,0 +1,289 @@
+#version 330 core
+out vec4 fragmentColor;
+
+in vec2 fragmentScreenCoordinate;
+
+struct Material {
+    vec3 diffuseColor;
+    vec3 specularColor;
+    float shininess;
+}; 
+
+struct DirectionalLight {
+    vec3 direction;
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+    bool bActive;
+};
+
+struct PointLight {
+    vec3 position;
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+    float constant;
+    float linear;
+    float quadratic;
+    // distance the light reaches (negative = everywhere)
+    float radius;
+};
+
+struct SpotLight {
+    vec3 position;
+    vec3 direction;
+    float cutOff;
+    float outerCutOff;
+    float constant;
+    float linear;
+    float quadratic;
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;       
+    bool bActive;
+};
+
+#define TOTAL_POINT_LIGHTS 5
+#define MAX_SHADOW_CASCADES 4
+
+uniform vec3 viewPosition;
+uniform mat4 view;
+uniform mat4 inverseViewProjection;
+uniform DirectionalLight directionalLight;
+uniform PointLight pointLights[TOTAL_POINT_LIGHTS];
+// active point lights, compacted into the first entries
+uniform int pointLightCount = 0;
+uniform SpotLight spotLight;
+
+// G-buffer written by the geometry pass
+uniform sampler2D gbufferAlbedo;
+uniform sampler2D gbufferNormal;
+uniform sampler2D gbufferDiffuse;
+uniform sampler2D gbufferSpecular;
+uniform sampler2D gbufferDepth;
+
+// shadow map layers - directional cascades followed by the spot light
+uniform sampler2DArrayShadow shadowMap;
+uniform bool bUseShadows = false;
+uniform int cascadeCount = 0;
+uniform float cascadeSplits[MAX_SHADOW_CASCADES];
+uniform mat4 cascadeLightSpace[MAX_SHADOW_CASCADES];
+uniform mat4 spotLightSpace;
+uniform int spotShadowLayer = 0;
+uniform int pcfRadius = 1;
+
+// additional point lights packed 4 texels each: position and radius,
+// ambient and constant, diffuse and linear, specular and quadratic
+// attenuation - used for the many-light comparisons
+uniform samplerBuffer extraPointLights;
+uniform int extraPointLightCount = 0;
+
+// material table, for the values the G-buffer has no room for
+uniform samplerBuffer materials;
+
+// ambient visibility of the scene, one texel per pixel
+uniform sampler2D ambientOcclusion;
+uniform bool bUseAmbientOcclusion = false;
+
+// surface properties read back from the G-buffer for this pixel,
+// used by the lighting functions in place of the forward uniforms
+Material material;
+vec3 albedo;
+vec3 fragmentPosition;
+float fragmentViewDepth;
+float ambientVisibility = 1.0;
+
+// function prototypes
+vec3 CalcDirectionalLight(DirectionalLight light, vec3 normal, vec3 viewDir);
+vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
+vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
+float CalcShadow(mat4 lightSpace, int layer, vec3 normal, vec3 lightDir);
+float CalcDirectionalShadow(vec3 normal, vec3 lightDir);
+PointLight FetchExtraPointLight(int index);
+
+void main()
+{
+    float depth = texture(gbufferDepth, fragmentScreenCoordinate).r;
+    if (depth >= 1.0) discard; // nothing was drawn at this pixel
+
+    // rebuild the world position from the depth buffer
+    vec4 clipPosition = vec4(vec3(fragmentScreenCoordinate, depth) * 2.0 - 1.0, 1.0);
+    vec4 worldPosition = inverseViewProjection * clipPosition;
+    fragmentPosition = worldPosition.xyz / worldPosition.w;
+    fragmentViewDepth = -(view * vec4(fragmentPosition, 1.0)).z;
+
+    vec4 albedoAlpha = texture(gbufferAlbedo, fragmentScreenCoordinate);
+    vec4 specularShininess = texture(gbufferSpecular, fragmentScreenCoordinate);
+    albedo = albedoAlpha.rgb;
+    material.diffuseColor = texture(gbufferDiffuse, fragmentScreenCoordinate).rgb;
+    material.specularColor = specularShininess.rgb;
+    material.shininess = specularShininess.a;
+
+    vec4 normalMaterial = texture(gbufferNormal, fragmentScreenCoordinate);
+    int materialIndex = int(normalMaterial.w + 0.5) - 1;
+
+    vec3 phongResult = vec3(0.0f);
+    if (materialIndex >= 0)
+    {
+        phongResult = texelFetch(materials, materialIndex * 3 + 2).rgb;
+    }
+    vec3 norm = normalize(normalMaterial.xyz);
+    vec3 viewDir = normalize(viewPosition - fragmentPosition);
+    if (bUseAmbientOcclusion)
+    {
+        ambientVisibility = texture(ambientOcclusion, fragmentScreenCoordinate).r;
+    }
+
+    // the same 3 lighting phases as the forward shader
+    if(directionalLight.bActive == true)
+    {
+        phongResult += CalcDirectionalLight(directionalLight, norm, viewDir);
+    }
+    for(int i = 0; i < pointLightCount; i++)
+    {
+        phongResult += CalcPointLight(pointLights[i], norm, fragmentPosition, viewDir);   
+    } 
+    for(int i = 0; i < extraPointLightCount; i++)
+    {
+        // skip the lights out of reach before fetching the rest
+        vec4 positionRadius = texelFetch(extraPointLights, i * 4);
+        vec3 toLight = positionRadius.xyz - fragmentPosition;
+        if ((positionRadius.w > 0.0) && (dot(toLight, toLight) > positionRadius.w * positionRadius.w)) continue;
+        phongResult += CalcPointLight(FetchExtraPointLight(i), norm, fragmentPosition, viewDir);
+    }
+    if(spotLight.bActive == true)
+    {
+        phongResult += CalcSpotLight(spotLight, norm, fragmentPosition, viewDir);    
+    }
+
+    fragmentColor = vec4(phongResult, albedoAlpha.a);
+}
+
+// the lighting functions below match fragmentShader.glsl, with the
+// texture and object color lookups replaced by the G-buffer albedo
+
+// calculates the color when using a directional light.
+vec3 CalcDirectionalLight(DirectionalLight light, vec3 normal, vec3 viewDir)
+{
+    if (!light.bActive) return vec3(0.0f); // Skip if inactive
+
+    vec3 lightDirection = normalize(-light.direction);
+    float diff = max(dot(normal, lightDirection), 0.0);
+    vec3 reflectDir = reflect(-lightDirection, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+    float shadow = CalcDirectionalShadow(normal, lightDirection);
+
+    vec3 ambient = ambientVisibility * light.ambient * albedo;
+    vec3 diffuse = light.diffuse * diff * material.diffuseColor * albedo;
+    vec3 specular = light.specular * spec * material.specularColor;
+
+    return (ambient + shadow * (diffuse + specular));
+}
+
+// calculates the color when using a point light.
+vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
+{
+    vec3 lightDir = normalize(light.position - fragPos);
+    float diff = max(dot(normal, lightDir), 0.0);
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+
+    vec3 ambient = ambientVisibility * light.ambient * albedo;
+    vec3 diffuse = light.diffuse * diff * material.diffuseColor * albedo;
+    vec3 specular = light.specular * spec * material.specularColor;
+
+    // attenuation windowed to reach 0 at the radius, so the light
+    // ends where the light grid stops passing it to the draws
+    float distance = length(light.position - fragPos);
+    float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * distance * distance);
+    if (light.radius > 0.0)
+    {
+        float window = clamp(1.0 - pow(distance / light.radius, 4.0), 0.0, 1.0);
+        attenuation *= window * window;
+    }
+
+    return attenuation * (ambient + diffuse + specular);
+}
+
+// calculates the color when using a spot light.
+vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
+{
+    if (!light.bActive) return vec3(0.0f); // Skip if inactive
+
+    vec3 lightDir = normalize(light.position - fragPos);
+    float theta = dot(lightDir, normalize(-light.direction));
+    if (theta < light.outerCutOff) return vec3(0.0f); // Skip if outside cone
+
+    float epsilon = light.cutOff - light.outerCutOff;
+    float intensity = clamp((theta - light.outerCutOff) / epsilon, 0.0, 1.0);
+    float diff = max(dot(normal, lightDir), 0.0);
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+    float shadow = bUseShadows ? CalcShadow(spotLightSpace, spotShadowLayer, normal, lightDir) : 1.0;
+
+    vec3 ambient = ambientVisibility * light.ambient * albedo;
+    vec3 diffuse = light.diffuse * diff * material.diffuseColor * albedo;
+    vec3 specular = light.specular * spec * material.specularColor;
+
+    return intensity * (ambient + shadow * (diffuse + specular));
+}
+
+// calculates the lit fraction of a fragment from one shadow map layer
+// using percentage closer filtering over a (2r+1)x(2r+1) texel kernel
+float CalcShadow(mat4 lightSpace, int layer, vec3 normal, vec3 lightDir)
+{
+    vec4 lightPosition = lightSpace * vec4(fragmentPosition, 1.0);
+    vec3 projected = (lightPosition.xyz / lightPosition.w) * 0.5 + 0.5;
+    if (projected.z > 1.0) return 1.0; // beyond the light far plane
+
+    // slope scaled bias against shadow acne
+    float bias = max(0.002 * (1.0 - dot(normal, lightDir)), 0.0005);
+    vec2 texelSize = 1.0 / vec2(textureSize(shadowMap, 0).xy);
+
+    float lit = 0.0;
+    for (int x = -pcfRadius; x <= pcfRadius; x++)
+    {
+        for (int y = -pcfRadius; y <= pcfRadius; y++)
+        {
+            vec2 offset = vec2(x, y) * texelSize;
+            lit += texture(shadowMap, vec4(projected.xy + offset, float(layer), projected.z - bias));
+        }
+    }
+    float kernelWidth = float(2 * pcfRadius + 1);
+    return lit / (kernelWidth * kernelWidth);
+}
+
+// calculates the lit fraction of a fragment for the directional light
+// by picking the cascade that covers its view space depth
+float CalcDirectionalShadow(vec3 normal, vec3 lightDir)
+{
+    if (!bUseShadows) return 1.0;
+
+    for (int i = 0; i < cascadeCount; i++)
+    {
+        if (fragmentViewDepth <= cascadeSplits[i])
+        {
+            return CalcShadow(cascadeLightSpace[i], i, normal, lightDir);
+        }
+    }
+    return 1.0; // beyond the last cascade
+}
+
+// reads one of the additional point lights from the light buffer
+PointLight FetchExtraPointLight(int index)
+{
+    PointLight light;
+    vec4 positionRadius = texelFetch(extraPointLights, index * 4);
+    vec4 ambientConstant = texelFetch(extraPointLights, index * 4 + 1);
+    vec4 diffuseLinear = texelFetch(extraPointLights, index * 4 + 2);
+    vec4 specularQuadratic = texelFetch(extraPointLights, index * 4 + 3);
+    light.position = positionRadius.xyz;
+    light.radius = positionRadius.w;
+    light.ambient = ambientConstant.rgb;
+    light.constant = ambientConstant.a;
+    light.diffuse = diffuseLinear.rgb;
+    light.linear = diffuseLinear.a;
+    light.specular = specularQuadratic.rgb;
+    light.quadratic = specularQuadratic.a;
+    return light;
+}
\ No newline at end of file
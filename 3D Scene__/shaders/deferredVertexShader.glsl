@@ -0,0 +1,12 @@
+#version 330 core
+
+out vec2 fragmentScreenCoordinate;
+
+// a single triangle covering the whole screen, generated from the
+// vertex index so no vertex buffer is needed
+void main()
+{
+   vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+   fragmentScreenCoordinate = position;
+   gl_Position = vec4(position * 2.0f - 1.0f, 0.0f, 1.0f);
+}
\ No newline at end of file
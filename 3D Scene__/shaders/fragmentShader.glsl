@@ -1,14 +1,22 @@
 #version 330 core
-out vec4 fragmentColor;
+layout (location = 0) out vec4 fragmentColor;
+// summed weights of the weighted blended transparency, ignored
+// when no second target is bound
+layout (location = 1) out vec4 transparencyWeight;
 
 in vec3 fragmentPosition;
 in vec3 fragmentVertexNormal;
 in vec2 fragmentTextureCoordinate;
+in float fragmentViewDepth;
+in vec3 fragmentObjectPosition;
+in vec3 fragmentObjectNormal;
 
 struct Material {
     vec3 diffuseColor;
     vec3 specularColor;
     float shininess;
+    vec3 emissiveColor;
+    int alphaMode;
 }; 
 
 struct DirectionalLight {
@@ -24,7 +32,11 @@ struct PointLight {
     vec3 ambient;
     vec3 diffuse;
     vec3 specular;
-    bool bActive;
+    float constant;
+    float linear;
+    float quadratic;
+    // distance the light reaches (negative = everywhere)
+    float radius;
 };
 
 struct SpotLight {
@@ -41,18 +53,75 @@ struct SpotLight {
     bool bActive;
 };
 
+// declared as in the vertex stage, for the camera position
+layout (std140) uniform Camera
+{
+   mat4 view;
+   mat4 projection;
+   vec3 viewPosition;
+};
+
 #define TOTAL_POINT_LIGHTS 5
+#define MAX_SHADOW_CASCADES 4
 
 uniform bool bUseTexture=false;
 uniform bool bUseLighting=false;
 uniform vec4 objectColor = vec4(1.0f);
-uniform vec3 viewPosition;
 uniform DirectionalLight directionalLight;
 uniform PointLight pointLights[TOTAL_POINT_LIGHTS];
+// active point lights, compacted into the first entries
+uniform int pointLightCount = 0;
 uniform SpotLight spotLight;
-uniform Material material;
 uniform sampler2D objectTexture;
 uniform vec2 UVscale = vec2(1.0f, 1.0f);
+// overdraw visualization - every shaded fragment adds a fixed amount
+uniform bool bShowOverdraw = false;
+// write the weighted color and weight of a transparent draw into
+// the accumulation targets instead of the shaded color
+uniform bool bWeightedTransparency = false;
+
+// shadow map layers - directional cascades followed by the spot light
+uniform sampler2DArrayShadow shadowMap;
+uniform bool bUseShadows = false;
+uniform int cascadeCount = 0;
+uniform float cascadeSplits[MAX_SHADOW_CASCADES];
+uniform mat4 cascadeLightSpace[MAX_SHADOW_CASCADES];
+uniform mat4 spotLightSpace;
+uniform int spotShadowLayer = 0;
+uniform int pcfRadius = 1;
+
+// additional point lights packed 4 texels each: position and radius,
+// ambient and constant, diffuse and linear, specular and quadratic
+// attenuation - used for the many-light comparisons
+uniform samplerBuffer extraPointLights;
+uniform int extraPointLightCount = 0;
+// additional point lights reaching this draw, as indices into the
+// light buffer, found by the light grid (-1 = every light)
+#define MAX_DRAW_LIGHTS 32
+uniform int drawLights[MAX_DRAW_LIGHTS];
+uniform int drawLightCount = -1;
+
+// material table, 3 texels per material: diffuse and shininess,
+// specular and roughness, emissive and alpha mode
+#define ALPHA_OPAQUE 0
+uniform samplerBuffer materials;
+uniform int materialIndex = -1;
+
+// baked diffuse lighting of the scene lights - the shape the draw's
+// surface is unwrapped as (-1 = lit per pixel) and its tile in the
+// atlas as offset and size
+uniform sampler2D lightmap;
+uniform int lightmapShape = -1;
+uniform vec4 lightmapTile;
+
+// ambient visibility of the opaque scene, one texel per pixel
+uniform sampler2D ambientOcclusion;
+uniform bool bUseAmbientOcclusion = false;
+
+// material of this draw, fetched from the table in main
+Material material;
+// ambient visibility of this fragment, scaling the ambient terms
+float ambientVisibility = 1.0;
 
 // the scaled texture coordinate to use in calculations
 vec2 fragmentTextureCoordinateScaled = fragmentTextureCoordinate * UVscale;
@@ -61,9 +130,37 @@ vec2 fragmentTextureCoordinateScaled = fragmentTextureCoordinate * UVscale;
 vec3 CalcDirectionalLight(DirectionalLight light, vec3 normal, vec3 viewDir);
 vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
 vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
+float CalcShadow(mat4 lightSpace, int layer, vec3 normal, vec3 lightDir);
+float CalcDirectionalShadow(vec3 normal, vec3 lightDir);
+vec3 CalcLightmappedLight(vec3 normal, vec3 viewDir);
+vec2 LightmapCoordinate();
+PointLight FetchExtraPointLight(int index);
+Material FetchMaterial(int index);
+void ShadeFragment();
 
 void main()
+{
+    ShadeFragment();
+    if (bWeightedTransparency)
+    {
+        // weight falling off with the view depth, so nearer surfaces
+        // dominate the average where several overlap
+        float alpha = fragmentColor.a;
+        float depthScale = 10.0 / (1.0e-5 + pow(fragmentViewDepth / 5.0, 2.0) + pow(fragmentViewDepth / 200.0, 6.0));
+        float weight = alpha * clamp(depthScale, 1.0e-2, 3.0e3);
+        fragmentColor = vec4(fragmentColor.rgb * weight, alpha);
+        transparencyWeight = vec4(weight);
+    }
+}
+
+// calculates the color of the fragment into fragmentColor
+void ShadeFragment()
 {   
+    if (bShowOverdraw) {
+        fragmentColor = vec4(0.1f, 0.05f, 0.02f, 1.0f);
+        return;
+    }
+
     if (!bUseLighting) {
         if (bUseTexture)
             fragmentColor = texture(objectTexture, fragmentTextureCoordinateScaled);
@@ -74,41 +171,53 @@ void main()
 
     if(bUseLighting == true)
     {
-        vec3 phongResult = vec3(0.0f);
+        material = FetchMaterial(materialIndex);
+        vec3 phongResult = material.emissiveColor;
         // properties
         vec3 norm = normalize(fragmentVertexNormal);
         vec3 viewDir = normalize(viewPosition - fragmentPosition);
+        if (bUseAmbientOcclusion)
+        {
+            ambientVisibility = texelFetch(ambientOcclusion, ivec2(gl_FragCoord.xy), 0).r;
+        }
     
-        // == =====================================================
-        // Lighting is set up in 3 phases: directional, point lights, and optional spotlight
-        // == =====================================================
-        // phase 1: directional lighting
-        if(directionalLight.bActive == true)
+        if (lightmapShape >= 0)
         {
-            phongResult += CalcDirectionalLight(directionalLight, norm, viewDir);
+            // the diffuse lighting of the scene lights is baked
+            phongResult += CalcLightmappedLight(norm, viewDir);
         }
-        // phase 2: point lights
-        for(int i = 0; i < TOTAL_POINT_LIGHTS; i++)
+        else
         {
-            if(pointLights[i].bActive == true)
+            // == =====================================================
+            // Lighting is set up in 3 phases: directional, point lights, and optional spotlight
+            // == =====================================================
+            // phase 1: directional lighting
+            if(directionalLight.bActive == true)
+            {
+                phongResult += CalcDirectionalLight(directionalLight, norm, viewDir);
+            }
+            // phase 2: point lights
+            for(int i = 0; i < pointLightCount; i++)
             {
                 phongResult += CalcPointLight(pointLights[i], norm, fragmentPosition, viewDir);   
+            } 
+            // phase 3: spot light
+            if(spotLight.bActive == true)
+            {
+                phongResult += CalcSpotLight(spotLight, norm, fragmentPosition, viewDir);    
             }
-        } 
-        // phase 3: spot light
-        if(spotLight.bActive == true)
-        {
-            phongResult += CalcSpotLight(spotLight, norm, fragmentPosition, viewDir);    
-        }
-    
-        if(bUseTexture == true)
-        {
-            fragmentColor = vec4(phongResult, (texture(objectTexture, fragmentTextureCoordinateScaled)).a);
         }
-        else
+        // the additional point lights are never baked, and only the
+        // ones reaching the draw are looped over when it has a list
+        int lightCount = (drawLightCount < 0) ? extraPointLightCount : drawLightCount;
+        for(int i = 0; i < lightCount; i++)
         {
-            fragmentColor = vec4(phongResult, objectColor.a);
+            int light = (drawLightCount < 0) ? i : drawLights[i];
+            phongResult += CalcPointLight(FetchExtraPointLight(light), norm, fragmentPosition, viewDir);
         }
+    
+        float alpha = bUseTexture ? texture(objectTexture, fragmentTextureCoordinateScaled).a : objectColor.a;
+        fragmentColor = vec4(phongResult, (material.alphaMode == ALPHA_OPAQUE) ? 1.0 : alpha);
     }
     else
     {
@@ -133,29 +242,38 @@ vec3 CalcDirectionalLight(DirectionalLight light, vec3 normal, vec3 viewDir)
     float diff = max(dot(normal, lightDirection), 0.0);
     vec3 reflectDir = reflect(-lightDirection, normal);
     float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+    float shadow = CalcDirectionalShadow(normal, lightDirection);
 
-    vec3 ambient = light.ambient * (bUseTexture ? vec3(texture(objectTexture, fragmentTextureCoordinateScaled)) : vec3(objectColor));
+    vec3 ambient = ambientVisibility * light.ambient * (bUseTexture ? vec3(texture(objectTexture, fragmentTextureCoordinateScaled)) : vec3(objectColor));
     vec3 diffuse = light.diffuse * diff * material.diffuseColor * (bUseTexture ? vec3(texture(objectTexture, fragmentTextureCoordinateScaled)) : vec3(objectColor));
     vec3 specular = light.specular * spec * material.specularColor;
 
-    return (ambient + diffuse + specular);
+    return (ambient + shadow * (diffuse + specular));
 }
 
 // calculates the color when using a point light.
 vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
 {
-    if (!light.bActive) return vec3(0.0f); // Skip if inactive
-
     vec3 lightDir = normalize(light.position - fragPos);
     float diff = max(dot(normal, lightDir), 0.0);
     vec3 reflectDir = reflect(-lightDir, normal);
     float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
 
-    vec3 ambient = light.ambient * (bUseTexture ? vec3(texture(objectTexture, fragmentTextureCoordinateScaled)) : vec3(objectColor));
+    vec3 ambient = ambientVisibility * light.ambient * (bUseTexture ? vec3(texture(objectTexture, fragmentTextureCoordinateScaled)) : vec3(objectColor));
     vec3 diffuse = light.diffuse * diff * material.diffuseColor * (bUseTexture ? vec3(texture(objectTexture, fragmentTextureCoordinateScaled)) : vec3(objectColor));
     vec3 specular = light.specular * spec * material.specularColor;
 
-    return (ambient + diffuse + specular);
+    // attenuation windowed to reach 0 at the radius, so the light
+    // ends where the light grid stops passing it to the draws
+    float distance = length(light.position - fragPos);
+    float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * distance * distance);
+    if (light.radius > 0.0)
+    {
+        float window = clamp(1.0 - pow(distance / light.radius, 4.0), 0.0, 1.0);
+        attenuation *= window * window;
+    }
+
+    return attenuation * (ambient + diffuse + specular);
 }
 
 // calculates the color when using a spot light.
@@ -172,10 +290,198 @@ vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
     float diff = max(dot(normal, lightDir), 0.0);
     vec3 reflectDir = reflect(-lightDir, normal);
     float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+    float shadow = bUseShadows ? CalcShadow(spotLightSpace, spotShadowLayer, normal, lightDir) : 1.0;
 
-    vec3 ambient = light.ambient * (bUseTexture ? vec3(texture(objectTexture, fragmentTextureCoordinateScaled)) : vec3(objectColor));
+    vec3 ambient = ambientVisibility * light.ambient * (bUseTexture ? vec3(texture(objectTexture, fragmentTextureCoordinateScaled)) : vec3(objectColor));
     vec3 diffuse = light.diffuse * diff * material.diffuseColor * (bUseTexture ? vec3(texture(objectTexture, fragmentTextureCoordinateScaled)) : vec3(objectColor));
     vec3 specular = light.specular * spec * material.specularColor;
 
-    return intensity * (ambient + diffuse + specular);
+    return intensity * (ambient + shadow * (diffuse + specular));
+}
+
+// calculates the lit fraction of a fragment from one shadow map layer
+// using percentage closer filtering over a (2r+1)x(2r+1) texel kernel
+float CalcShadow(mat4 lightSpace, int layer, vec3 normal, vec3 lightDir)
+{
+    vec4 lightPosition = lightSpace * vec4(fragmentPosition, 1.0);
+    vec3 projected = (lightPosition.xyz / lightPosition.w) * 0.5 + 0.5;
+    if (projected.z > 1.0) return 1.0; // beyond the light far plane
+
+    // slope scaled bias against shadow acne
+    float bias = max(0.002 * (1.0 - dot(normal, lightDir)), 0.0005);
+    vec2 texelSize = 1.0 / vec2(textureSize(shadowMap, 0).xy);
+
+    float lit = 0.0;
+    for (int x = -pcfRadius; x <= pcfRadius; x++)
+    {
+        for (int y = -pcfRadius; y <= pcfRadius; y++)
+        {
+            vec2 offset = vec2(x, y) * texelSize;
+            lit += texture(shadowMap, vec4(projected.xy + offset, float(layer), projected.z - bias));
+        }
+    }
+    float kernelWidth = float(2 * pcfRadius + 1);
+    return lit / (kernelWidth * kernelWidth);
+}
+
+// calculates the lit fraction of a fragment for the directional light
+// by picking the cascade that covers its view space depth
+float CalcDirectionalShadow(vec3 normal, vec3 lightDir)
+{
+    if (!bUseShadows) return 1.0;
+
+    for (int i = 0; i < cascadeCount; i++)
+    {
+        if (fragmentViewDepth <= cascadeSplits[i])
+        {
+            return CalcShadow(cascadeLightSpace[i], i, normal, lightDir);
+        }
+    }
+    return 1.0; // beyond the last cascade
 }
+
+// calculates the color of the scene lights from the baked lightmap, which
+// holds their shadowed diffuse lighting in rgb and the visibility of the
+// directional light in alpha - only the ambient and specular terms and
+// the spot light cone are evaluated per pixel, without any shadow lookup
+vec3 CalcLightmappedLight(vec3 normal, vec3 viewDir)
+{
+    vec4 baked = texture(lightmap, LightmapCoordinate());
+    vec3 albedo = bUseTexture ? vec3(texture(objectTexture, fragmentTextureCoordinateScaled)) : vec3(objectColor);
+    vec3 ambient = vec3(0.0f);
+    vec3 specular = vec3(0.0f);
+
+    if (directionalLight.bActive)
+    {
+        vec3 reflectDir = reflect(normalize(directionalLight.direction), normal);
+        ambient += directionalLight.ambient;
+        specular += baked.a * directionalLight.specular * pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+    }
+    for (int i = 0; i < pointLightCount; i++)
+    {
+        vec3 reflectDir = reflect(-normalize(pointLights[i].position - fragmentPosition), normal);
+        ambient += pointLights[i].ambient;
+        specular += pointLights[i].specular * pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+    }
+    if (spotLight.bActive)
+    {
+        vec3 lightDir = normalize(spotLight.position - fragmentPosition);
+        float theta = dot(lightDir, normalize(-spotLight.direction));
+        if (theta >= spotLight.outerCutOff)
+        {
+            float intensity = clamp((theta - spotLight.outerCutOff) / (spotLight.cutOff - spotLight.outerCutOff), 0.0, 1.0);
+            vec3 reflectDir = reflect(-lightDir, normal);
+            ambient += intensity * spotLight.ambient;
+            specular += intensity * spotLight.specular * pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+        }
+    }
+
+    return albedo * (ambientVisibility * ambient + material.diffuseColor * baked.rgb) + specular * material.specularColor;
+}
+
+// finds the lightmap texel of the fragment from its object space position
+// and normal - the inverse of the unwrap in LightmapBaker.cpp, so the two
+// have to be changed together.  The tile of the box holds one cell per
+// face in a 3x2 grid and the tile of the cylinder its side and caps in a
+// 2x2 grid, while the plane, torus and sphere fill their tile
+vec2 LightmapCoordinate()
+{
+    const float PI = 3.14159265;
+    vec3 position = fragmentObjectPosition;
+    vec3 normal = fragmentObjectNormal;
+    vec2 grid = vec2(1.0);
+    float cell = 0.0;
+    vec2 local;
+
+    if (lightmapShape == 0)
+    {
+        local = position.xz * 0.5 + 0.5;
+    }
+    else if (lightmapShape == 1)
+    {
+        // two cells per axis, the positive face first
+        vec3 extent = abs(normal);
+        int axis = (extent.x >= extent.y && extent.x >= extent.z) ? 0 : ((extent.y >= extent.z) ? 1 : 2);
+        grid = vec2(3.0, 2.0);
+        cell = float(axis * 2 + ((normal[axis] < 0.0) ? 1 : 0));
+        local = vec2(position[(axis + 1) % 3], position[(axis + 2) % 3]) + 0.5;
+    }
+    else if (lightmapShape == 2)
+    {
+        grid = vec2(2.0);
+        if (abs(normal.y) > 0.5)
+        {
+            // the top cap, then the bottom one
+            cell = (normal.y > 0.0) ? 1.0 : 2.0;
+            local = position.xz * 0.5 + 0.5;
+        }
+        else
+        {
+            local = vec2(atan(position.z, position.x) / (2.0 * PI) + 0.5, position.y);
+        }
+    }
+    else if (lightmapShape == 3)
+    {
+        vec3 radial = vec3(normalize(position.xy), 0.0);
+        vec3 tube = position - radial;
+        local = vec2(atan(position.y, position.x), atan(tube.z, dot(tube, radial))) / (2.0 * PI) + 0.5;
+    }
+    else
+    {
+        vec3 direction = normalize(position);
+        local = vec2(atan(direction.z, direction.x) / (2.0 * PI) + 0.5, acos(clamp(direction.y, -1.0, 1.0)) / PI);
+    }
+
+    // keep between the texel centers of the cell, so the filtering
+    // never blends in the next cell
+    vec2 cellSize = lightmapTile.zw / grid;
+    vec2 cellTexels = cellSize * vec2(textureSize(lightmap, 0));
+    vec2 texel = (clamp(local, 0.0, 1.0) * (cellTexels - 1.0) + 0.5) / cellTexels;
+    vec2 cellOrigin = vec2(mod(cell, grid.x), floor(cell / grid.x));
+    return lightmapTile.xy + (cellOrigin + texel) * cellSize;
+}
+
+// reads one of the additional point lights from the light buffer
+PointLight FetchExtraPointLight(int index)
+{
+    PointLight light;
+    vec4 positionRadius = texelFetch(extraPointLights, index * 4);
+    vec4 ambientConstant = texelFetch(extraPointLights, index * 4 + 1);
+    vec4 diffuseLinear = texelFetch(extraPointLights, index * 4 + 2);
+    vec4 specularQuadratic = texelFetch(extraPointLights, index * 4 + 3);
+    light.position = positionRadius.xyz;
+    light.radius = positionRadius.w;
+    light.ambient = ambientConstant.rgb;
+    light.constant = ambientConstant.a;
+    light.diffuse = diffuseLinear.rgb;
+    light.linear = diffuseLinear.a;
+    light.specular = specularQuadratic.rgb;
+    light.quadratic = specularQuadratic.a;
+    return light;
+}
+
+// reads the material at an index of the material table - the roughness
+// spreads the highlight by lowering the shininess
+Material FetchMaterial(int index)
+{
+    Material fetched;
+    if (index < 0)
+    {
+        fetched.diffuseColor = vec3(0.0f);
+        fetched.specularColor = vec3(0.0f);
+        fetched.shininess = 1.0f;
+        fetched.emissiveColor = vec3(0.0f);
+        fetched.alphaMode = ALPHA_OPAQUE;
+        return fetched;
+    }
+
+    vec4 diffuseShininess = texelFetch(materials, index * 3);
+    vec4 specularRoughness = texelFetch(materials, index * 3 + 1);
+    vec4 emissiveAlphaMode = texelFetch(materials, index * 3 + 2);
+    fetched.diffuseColor = diffuseShininess.rgb;
+    fetched.specularColor = specularRoughness.rgb;
+    fetched.shininess = diffuseShininess.a * (1.0 - 0.95 * specularRoughness.a);
+    fetched.emissiveColor = emissiveAlphaMode.rgb;
+    fetched.alphaMode = int(emissiveAlphaMode.a + 0.5);
+    return fetched;
+}
\ No newline at end of file
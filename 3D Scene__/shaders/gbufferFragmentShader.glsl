@@ -0,0 +1,42 @@
+#version 330 core
+layout (location = 0) out vec4 gbufferAlbedo;
+layout (location = 1) out vec4 gbufferNormal;
+layout (location = 2) out vec4 gbufferDiffuse;
+layout (location = 3) out vec4 gbufferSpecular;
+
+in vec3 fragmentPosition;
+in vec3 fragmentVertexNormal;
+in vec2 fragmentTextureCoordinate;
+in float fragmentViewDepth;
+
+uniform bool bUseTexture=false;
+uniform vec4 objectColor = vec4(1.0f);
+uniform sampler2D objectTexture;
+uniform vec2 UVscale = vec2(1.0f, 1.0f);
+
+// material table, 3 texels per material: diffuse and shininess,
+// specular and roughness, emissive and alpha mode
+uniform samplerBuffer materials;
+uniform int materialIndex = -1;
+
+void main()
+{
+    // albedo is the texture color or the solid object color
+    vec4 albedo = bUseTexture ? texture(objectTexture, fragmentTextureCoordinate * UVscale) : objectColor;
+
+    // the same material values as FetchMaterial in the forward shader
+    vec4 diffuseShininess = vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    vec4 specularRoughness = vec4(0.0f);
+    if (materialIndex >= 0)
+    {
+        diffuseShininess = texelFetch(materials, materialIndex * 3);
+        specularRoughness = texelFetch(materials, materialIndex * 3 + 1);
+    }
+
+    gbufferAlbedo = albedo;
+    // the material index is kept for the lighting pass to look up
+    // the rest of the material, offset so that 0 means none
+    gbufferNormal = vec4(normalize(fragmentVertexNormal), float(materialIndex + 1));
+    gbufferDiffuse = vec4(diffuseShininess.rgb, 1.0f);
+    gbufferSpecular = vec4(specularRoughness.rgb, diffuseShininess.a * (1.0 - 0.95 * specularRoughness.a));
+}
\ No newline at end of file
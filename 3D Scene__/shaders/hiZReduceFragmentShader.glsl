@@ -0,0 +1,26 @@
+#version 330 core
+out float outFarthestDepth;
+
+uniform sampler2D sceneDepth;
+// pixels of a depth tile reduced into one texel
+uniform int tileSize = 8;
+
+void main()
+{
+    ivec2 size = textureSize(sceneDepth, 0);
+    ivec2 first = ivec2(gl_FragCoord.xy) * tileSize;
+    ivec2 last = min(first + ivec2(tileSize), size);
+
+    // keep the farthest depth, so a box in front of it is in
+    // front of every pixel of the tile
+    float farthestDepth = 0.0;
+    for (int y = first.y; y < last.y; y++)
+    {
+        for (int x = first.x; x < last.x; x++)
+        {
+            farthestDepth = max(farthestDepth, texelFetch(sceneDepth, ivec2(x, y), 0).r);
+        }
+    }
+
+    outFarthestDepth = farthestDepth;
+}
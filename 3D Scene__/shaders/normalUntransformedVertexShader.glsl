@@ -0,0 +1,62 @@
+#version 330 core
+// lit vertex shader of the normal benchmark, which leaves the
+// normals untransformed as before the normal matrix - it only
+// differs from vertexShader.glsl in the normal transform
+layout (location = 0) in vec3 inVertexPosition;
+layout (location = 1) in vec3 inVertexNormal;
+layout (location = 2) in vec2 inTextureCoordinate;
+
+out vec3 fragmentPosition;
+out vec3 fragmentVertexNormal;
+out vec2 fragmentTextureCoordinate;
+out float fragmentViewDepth;
+// object space surface point, which the lightmap is unwrapped over
+out vec3 fragmentObjectPosition;
+out vec3 fragmentObjectNormal;
+
+// must match the depth prepass for the GL_EQUAL depth test
+invariant gl_Position;
+
+// camera of the view being rendered - one slice of the per-view
+// array in the camera uniform buffer is bound for each view
+layout (std140) uniform Camera
+{
+   mat4 view;
+   mat4 projection;
+   vec3 viewPosition;
+};
+
+uniform mat4 model;
+// view of the camera the shadow cascades were fitted to, which
+// is not the rendered one for the extra views of multi-view mode
+uniform mat4 cascadeView;
+
+// decoding of the packed vertex format - the defaults leave the
+// float vertices of the basic meshes unchanged
+uniform vec3 positionScale = vec3(1.0);
+uniform vec3 positionOffset = vec3(0.0);
+uniform bool octahedralNormals = false;
+
+// turn an octahedral encoded normal back into a unit vector
+vec3 DecodeOctahedral(vec2 encoded)
+{
+   vec3 normal = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+   float fold = max(-normal.z, 0.0);
+   normal.xy += mix(vec2(fold), vec2(-fold), greaterThanEqual(normal.xy, vec2(0.0)));
+   return normalize(normal);
+}
+
+void main()
+{
+   vec3 position = inVertexPosition * positionScale + positionOffset;
+   vec3 normal = octahedralNormals ? DecodeOctahedral(inVertexNormal.xy / 32767.0) : inVertexNormal;
+
+   fragmentPosition = vec3(model * vec4(position, 1.0));
+   gl_Position = projection * view * model * vec4(position, 1.0f);
+   fragmentVertexNormal = normal;
+   fragmentTextureCoordinate = inTextureCoordinate;
+   fragmentObjectPosition = position;
+   fragmentObjectNormal = normal;
+   // view space depth selects the shadow cascade
+   fragmentViewDepth = -(cascadeView * vec4(fragmentPosition, 1.0)).z;
+}
\ No newline at end of file
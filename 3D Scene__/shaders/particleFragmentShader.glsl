@@ -0,0 +1,40 @@
+#version 330 core
+layout (location = 0) out vec4 fragmentColor;
+// summed weights of the weighted blended transparency, ignored
+// by the single target of the sorted mode
+layout (location = 1) out vec4 transparencyWeight;
+
+in vec2 fragmentCorner;
+in float fragmentLife;
+in float fragmentViewDepth;
+
+uniform vec4 startColor;
+uniform vec4 endColor;
+// write the weighted color and weight into the accumulation
+// targets instead of the blended color
+uniform bool bWeightedTransparency = false;
+
+void main()
+{
+    // round soft edged sprite
+    float radiusSquared = dot(fragmentCorner, fragmentCorner);
+    if (radiusSquared >= 1.0)
+    {
+        discard;
+    }
+
+    vec4 color = mix(startColor, endColor, clamp(fragmentLife, 0.0, 1.0));
+    float alpha = color.a * (1.0 - radiusSquared);
+    fragmentColor = vec4(color.rgb, alpha);
+    transparencyWeight = vec4(0.0);
+
+    if (bWeightedTransparency)
+    {
+        // the same weight as the transparent draws, so both blend
+        // into one average
+        float depthScale = 10.0 / (1.0e-5 + pow(fragmentViewDepth / 5.0, 2.0) + pow(fragmentViewDepth / 200.0, 6.0));
+        float weight = alpha * clamp(depthScale, 1.0e-2, 3.0e3);
+        fragmentColor = vec4(color.rgb * weight, alpha);
+        transparencyWeight = vec4(weight);
+    }
+}
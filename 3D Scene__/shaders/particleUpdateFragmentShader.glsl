@@ -0,0 +1,9 @@
+#version 330 core
+out vec4 fragmentColor;
+
+// the update pass runs with the rasterizer discarded, so this
+// only completes the program
+void main()
+{
+    fragmentColor = vec4(0.0);
+}
@@ -0,0 +1,82 @@
+#version 330 core
+// state of one particle, read from one buffer and written into the
+// other by transform feedback
+layout (location = 0) in vec4 inPositionAge;
+layout (location = 1) in vec4 inVelocitySeed;
+
+// position and seconds since the particle was emitted - negative
+// while it waits to be emitted for the first time
+out vec4 outPositionAge;
+// velocity and how often the particle was emitted again
+out vec4 outVelocitySeed;
+
+uniform float deltaTime;
+uniform vec3 gravity;
+// fraction of the velocity kept over this step by the drag
+uniform float velocityKeep;
+uniform float lifetime;
+uniform vec3 emitterPosition;
+uniform float emitterRadius;
+uniform float emitterSpeed;
+uniform float emitterSpread;
+// height of the surface the particles bounce off and the
+// fraction of the vertical velocity they keep
+uniform float floorHeight;
+uniform float restitution;
+
+// integer hash mixing every input bit into every output bit
+uint Hash(uint value)
+{
+    value ^= value >> 16;
+    value *= 0x7feb352du;
+    value ^= value >> 15;
+    value *= 0x846ca68bu;
+    value ^= value >> 16;
+    return value;
+}
+
+// next uniform random number in [0, 1) of a hash sequence
+float Random(inout uint state)
+{
+    state = Hash(state);
+    return float(state >> 8) / 16777216.0;
+}
+
+void main()
+{
+    vec3 position = inPositionAge.xyz;
+    vec3 velocity = inVelocitySeed.xyz;
+    float generation = inVelocitySeed.w;
+    float age = inPositionAge.w + deltaTime;
+
+    // must match ParticleSystem::SimulateRange on the CPU
+    velocity = (velocity + gravity * deltaTime) * velocityKeep;
+    position += velocity * deltaTime;
+    if (position.y < floorHeight)
+    {
+        position.y = floorHeight;
+        velocity.y = -velocity.y * restitution;
+    }
+
+    bool bExpired = (age >= lifetime);
+    if (bExpired || ((age >= 0.0) && (inPositionAge.w < 0.0)))
+    {
+        if (bExpired)
+        {
+            age -= lifetime;
+            generation += 1.0;
+        }
+
+        // each particle and generation leaves in its own direction
+        uint state = Hash(uint(gl_VertexID) * 0x9e3779b9u + uint(generation));
+        float angle = 6.2831853 * Random(state);
+        float distance = emitterRadius * sqrt(Random(state));
+        float spread = emitterSpread * Random(state);
+        float lift = 0.75 + 0.5 * Random(state);
+        position = emitterPosition + vec3(cos(angle) * distance, 0.0, sin(angle) * distance);
+        velocity = vec3(cos(angle) * spread, emitterSpeed * lift, sin(angle) * spread);
+    }
+
+    outPositionAge = vec4(position, age);
+    outVelocitySeed = vec4(velocity, generation);
+}
@@ -0,0 +1,40 @@
+#version 330 core
+// position and age of the particle this billboard is drawn for,
+// advanced once per instance
+layout (location = 0) in vec4 inPositionAge;
+
+// corner of the billboard in -1 to 1
+out vec2 fragmentCorner;
+// 0 when emitted, 1 when expired
+out float fragmentLife;
+out float fragmentViewDepth;
+
+// camera of the view being rendered
+layout (std140) uniform Camera
+{
+   mat4 view;
+   mat4 projection;
+   vec3 viewPosition;
+};
+
+uniform float particleSize;
+uniform float lifetime;
+
+void main()
+{
+   // the four vertices of the strip span the quad
+   fragmentCorner = vec2(gl_VertexID & 1, gl_VertexID >> 1) * 2.0 - 1.0;
+   fragmentLife = inPositionAge.w / lifetime;
+
+   // facing the camera - the corner is offset in view space
+   vec4 viewPositionOfParticle = view * vec4(inPositionAge.xyz, 1.0);
+   viewPositionOfParticle.xy += fragmentCorner * particleSize;
+   fragmentViewDepth = -viewPositionOfParticle.z;
+   gl_Position = projection * viewPositionOfParticle;
+
+   // particles waiting to be emitted collapse to a point
+   if (inPositionAge.w < 0.0)
+   {
+      gl_Position = vec4(0.0, 0.0, 2.0, 1.0);
+   }
+}
@@ -0,0 +1,27 @@
+#version 330 core
+layout (location = 0) in vec3 inVertexPosition;
+
+// the depth written here has to match the lit pass exactly for
+// the GL_EQUAL depth test, so the position math is kept identical
+invariant gl_Position;
+
+// same camera block as the lit pass vertex shader
+layout (std140) uniform Camera
+{
+   mat4 view;
+   mat4 projection;
+   vec3 viewPosition;
+};
+
+uniform mat4 model;
+
+// decoding of the packed vertex format - the defaults leave the
+// float vertices of the basic meshes unchanged
+uniform vec3 positionScale = vec3(1.0);
+uniform vec3 positionOffset = vec3(0.0);
+
+void main()
+{
+   vec3 position = inVertexPosition * positionScale + positionOffset;
+   gl_Position = projection * view * model * vec4(position, 1.0f);
+}
\ No newline at end of file
@@ -0,0 +1,7 @@
+#version 330 core
+
+// depth-only pass - the depth buffer is written by the fixed
+// function pipeline, so there is no color output
+void main()
+{
+}
\ No newline at end of file
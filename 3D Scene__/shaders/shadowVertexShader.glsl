@@ -0,0 +1,16 @@
+#version 330 core
+layout (location = 0) in vec3 inVertexPosition;
+
+uniform mat4 model;
+uniform mat4 lightSpaceMatrix;
+
+// decoding of the packed vertex format - the defaults leave the
+// float vertices of the basic meshes unchanged
+uniform vec3 positionScale = vec3(1.0);
+uniform vec3 positionOffset = vec3(0.0);
+
+void main()
+{
+   vec3 position = inVertexPosition * positionScale + positionOffset;
+   gl_Position = lightSpaceMatrix * model * vec4(position, 1.0f);
+}
\ No newline at end of file
@@ -0,0 +1,32 @@
+#version 330 core
+out vec2 outOcclusion;
+
+// half resolution visibility and view depth
+uniform sampler2D halfOcclusion;
+// texel step of the blur - (1, 0) or (0, 1)
+uniform vec2 direction;
+uniform int blurRadius = 3;
+
+void main()
+{
+    ivec2 size = textureSize(halfOcclusion, 0);
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    vec2 center = texelFetch(halfOcclusion, pixel, 0).rg;
+
+    // gaussian weights, cut off where the depth differs by more
+    // than a few percent so the occlusion does not bleed across edges
+    float sigma = max(float(blurRadius) * 0.5, 0.5);
+    float totalWeight = 0.0;
+    float totalVisibility = 0.0;
+    for (int i = -blurRadius; i <= blurRadius; i++)
+    {
+        ivec2 samplePixel = clamp(pixel + ivec2(direction * float(i)), ivec2(0), size - 1);
+        vec2 value = texelFetch(halfOcclusion, samplePixel, 0).rg;
+        float depthDifference = abs(value.g - center.g) / max(center.g, 1.0e-3);
+        float weight = exp(-float(i * i) / (2.0 * sigma * sigma)) * max(1.0 - depthDifference * 20.0, 0.0);
+        totalWeight += weight;
+        totalVisibility += value.r * weight;
+    }
+
+    outOcclusion = vec2(totalVisibility / max(totalWeight, 1.0e-5), center.g);
+}
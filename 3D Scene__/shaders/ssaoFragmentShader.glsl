@@ -0,0 +1,98 @@
+#version 330 core
+out vec2 outOcclusion;
+
+in vec2 fragmentScreenCoordinate;
+
+#define MAX_KERNEL_SAMPLES 32
+
+// full resolution depth of the opaque scene, and the world space
+// normals of the G-buffer when there is one
+uniform sampler2D sceneDepth;
+uniform sampler2D sceneNormal;
+uniform bool bUseSceneNormal = false;
+
+uniform mat4 projection;
+uniform mat4 inverseProjection;
+uniform mat4 view;
+
+// hemisphere offsets around +z, and how many of them are used
+uniform vec3 kernel[MAX_KERNEL_SAMPLES];
+uniform int kernelSize = 16;
+// view space radius of the hemisphere
+uniform float radius = 0.5;
+
+// view space position of a depth buffer value
+vec3 ViewPosition(vec2 coordinate, float depth)
+{
+    vec4 position = inverseProjection * vec4(vec3(coordinate, depth) * 2.0 - 1.0, 1.0);
+    return position.xyz / position.w;
+}
+
+void main()
+{
+    ivec2 depthSize = textureSize(sceneDepth, 0);
+    // the full resolution pixel this half resolution texel stands for
+    ivec2 pixel = min(ivec2(gl_FragCoord.xy) * 2, depthSize - 1);
+    vec2 coordinate = (vec2(pixel) + 0.5) / vec2(depthSize);
+    float depth = texelFetch(sceneDepth, pixel, 0).r;
+    if (depth >= 1.0)
+    {
+        // nothing was drawn here, so nothing is occluded
+        outOcclusion = vec2(1.0, 1.0e6);
+        return;
+    }
+    vec3 origin = ViewPosition(coordinate, depth);
+
+    vec3 normal;
+    if (bUseSceneNormal)
+    {
+        normal = normalize(mat3(view) * texelFetch(sceneNormal, pixel, 0).xyz);
+    }
+    else
+    {
+        // rebuild the normal from the neighbours, taking the
+        // smaller step on each axis so depth edges do not bend it
+        vec2 texel = 1.0 / vec2(depthSize);
+        vec3 right = ViewPosition(coordinate + vec2(texel.x, 0.0), texelFetch(sceneDepth, min(pixel + ivec2(1, 0), depthSize - 1), 0).r) - origin;
+        vec3 left = origin - ViewPosition(coordinate - vec2(texel.x, 0.0), texelFetch(sceneDepth, max(pixel - ivec2(1, 0), ivec2(0)), 0).r);
+        vec3 up = ViewPosition(coordinate + vec2(0.0, texel.y), texelFetch(sceneDepth, min(pixel + ivec2(0, 1), depthSize - 1), 0).r) - origin;
+        vec3 down = origin - ViewPosition(coordinate - vec2(0.0, texel.y), texelFetch(sceneDepth, max(pixel - ivec2(0, 1), ivec2(0)), 0).r);
+        vec3 dx = (abs(right.z) < abs(left.z)) ? right : left;
+        vec3 dy = (abs(up.z) < abs(down.z)) ? up : down;
+        normal = normalize(cross(dx, dy));
+    }
+
+    // rotate the kernel around the normal by a per pixel angle, so
+    // the banding of the few samples turns into noise the blur removes
+    float noise = fract(52.9829189 * fract(dot(gl_FragCoord.xy, vec2(0.06711056, 0.00583715))));
+    float angle = noise * 6.28318531;
+    vec3 randomDirection = vec3(cos(angle), sin(angle), 0.0);
+    vec3 tangent = randomDirection - normal * dot(randomDirection, normal);
+    if (dot(tangent, tangent) < 1.0e-4)
+    {
+        tangent = vec3(1.0, 0.0, 0.0) - normal * normal.x;
+    }
+    tangent = normalize(tangent);
+    mat3 tbn = mat3(tangent, cross(normal, tangent), normal);
+
+    float occlusion = 0.0;
+    for (int i = 0; i < kernelSize; i++)
+    {
+        vec3 samplePosition = origin + tbn * kernel[i] * radius;
+        vec4 clip = projection * vec4(samplePosition, 1.0);
+        vec2 sampleCoordinate = clip.xy / clip.w * 0.5 + 0.5;
+        if (any(lessThan(sampleCoordinate, vec2(0.0))) || any(greaterThan(sampleCoordinate, vec2(1.0))))
+        {
+            continue;
+        }
+
+        float sceneZ = ViewPosition(sampleCoordinate, texture(sceneDepth, sampleCoordinate).r).z;
+        // geometry far in front of the sample does not occlude it
+        float rangeCheck = smoothstep(0.0, 1.0, radius / max(abs(origin.z - sceneZ), 1.0e-4));
+        occlusion += ((sceneZ >= samplePosition.z + 0.02) ? 1.0 : 0.0) * rangeCheck;
+    }
+
+    float visibility = 1.0 - occlusion / float(max(kernelSize, 1));
+    // the view depth is kept for the depth aware blur and upsample
+    outOcclusion = vec2(visibility, -origin.z);
+}
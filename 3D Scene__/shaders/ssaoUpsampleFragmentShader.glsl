@@ -0,0 +1,45 @@
+#version 330 core
+out float outVisibility;
+
+// blurred half resolution visibility and view depth
+uniform sampler2D halfOcclusion;
+// full resolution depth of the opaque scene
+uniform sampler2D sceneDepth;
+uniform mat4 inverseProjection;
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    vec2 coordinate = gl_FragCoord.xy / vec2(textureSize(sceneDepth, 0));
+    float depth = texelFetch(sceneDepth, pixel, 0).r;
+    if (depth >= 1.0)
+    {
+        outVisibility = 1.0;
+        return;
+    }
+    vec4 position = inverseProjection * vec4(vec3(coordinate, depth) * 2.0 - 1.0, 1.0);
+    float viewDepth = -position.z / position.w;
+
+    // the four half resolution texels around the pixel, weighted
+    // bilinearly and by how close their depth is to the pixel's,
+    // so an edge takes the occlusion of its own side only
+    ivec2 halfSize = textureSize(halfOcclusion, 0);
+    vec2 halfPosition = gl_FragCoord.xy * 0.5 - 0.5;
+    ivec2 first = ivec2(floor(halfPosition));
+    vec2 fraction = halfPosition - vec2(first);
+    float totalWeight = 0.0;
+    float totalVisibility = 0.0;
+    for (int y = 0; y < 2; y++)
+    {
+        for (int x = 0; x < 2; x++)
+        {
+            vec2 value = texelFetch(halfOcclusion, clamp(first + ivec2(x, y), ivec2(0), halfSize - 1), 0).rg;
+            float bilinear = (x == 0 ? 1.0 - fraction.x : fraction.x) * (y == 0 ? 1.0 - fraction.y : fraction.y);
+            float weight = (bilinear + 1.0e-3) / (1.0e-3 + abs(value.g - viewDepth) / viewDepth);
+            totalWeight += weight;
+            totalVisibility += value.r * weight;
+        }
+    }
+
+    outVisibility = totalVisibility / totalWeight;
+}
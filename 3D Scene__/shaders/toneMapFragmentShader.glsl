@@ -0,0 +1,51 @@
+#version 330 core
+out vec4 outFragmentColor;
+
+in vec2 fragmentScreenCoordinate;
+
+uniform sampler2DMS hdrColorSamples;
+uniform sampler2D hdrColor;
+// samples of the target (1 = single sampled, read from hdrColor)
+uniform int sampleCount = 1;
+uniform float exposure = 1.0;
+// 0 = none, 1 = Reinhard, 2 = ACES
+uniform int toneMapOperator = 2;
+
+vec3 ToneMap(vec3 color);
+
+void main()
+{
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+
+    // tone map every sample before averaging, so edges against
+    // bright lights are antialiased in display range
+    vec3 result = vec3(0.0);
+    if (sampleCount > 1)
+    {
+        for (int i = 0; i < sampleCount; i++)
+        {
+            result += ToneMap(texelFetch(hdrColorSamples, texel, i).rgb * exposure);
+        }
+    }
+    else
+    {
+        result = ToneMap(texelFetch(hdrColor, texel, 0).rgb * exposure);
+    }
+
+    outFragmentColor = vec4(result / float(sampleCount), 1.0);
+}
+
+// map the unbounded scene color into the display range
+vec3 ToneMap(vec3 color)
+{
+    if (toneMapOperator == 1)
+    {
+        return color / (color + vec3(1.0));
+    }
+    if (toneMapOperator == 2)
+    {
+        // fitted ACES filmic curve
+        return clamp((color * (2.51 * color + 0.03)) / (color * (2.43 * color + 0.59) + 0.14), 0.0, 1.0);
+    }
+    return clamp(color, 0.0, 1.0);
+}
@@ -0,0 +1,47 @@
+#version 330 core
+out vec4 fragmentColor;
+
+in vec2 fragmentScreenCoordinate;
+
+// accumulation targets of the transparent draws - multisampled
+// targets are read through the first pair, single sampled ones
+// through the second
+uniform sampler2DMS accumulationSamples;
+uniform sampler2DMS weightSamples;
+uniform sampler2D accumulation;
+uniform sampler2D weight;
+// samples of the targets (0 = single sampled)
+uniform int sampleCount = 0;
+
+void main()
+{
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+
+    // summed premultiplied colors with the revealage in alpha,
+    // and the summed weights, averaged over the samples
+    vec4 summedColor = vec4(0.0);
+    float summedWeight = 0.0;
+    if (sampleCount > 0)
+    {
+        for (int i = 0; i < sampleCount; i++)
+        {
+            summedColor += texelFetch(accumulationSamples, texel, i);
+            summedWeight += texelFetch(weightSamples, texel, i).r;
+        }
+        summedColor /= float(sampleCount);
+        summedWeight /= float(sampleCount);
+    }
+    else
+    {
+        summedColor = texelFetch(accumulation, texel, 0);
+        summedWeight = texelFetch(weight, texel, 0).r;
+    }
+
+    // nothing transparent covers this pixel
+    float revealage = summedColor.a;
+    if (revealage >= 1.0) discard;
+
+    // the weighted average color, covering one minus the revealage
+    vec3 averageColor = summedColor.rgb / max(summedWeight, 1.0e-5);
+    fragmentColor = vec4(averageColor, 1.0 - revealage);
+}
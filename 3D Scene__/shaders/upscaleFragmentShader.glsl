@@ -0,0 +1,33 @@
+#version 330 core
+out vec4 outFragmentColor;
+
+in vec2 fragmentScreenCoordinate;
+
+// tone mapped scene at the reduced rendering resolution
+uniform sampler2D sceneColor;
+// 0 = least, 1 = most sharpening
+uniform float sharpness = 0.5;
+
+void main()
+{
+    vec2 texelSize = 1.0 / vec2(textureSize(sceneColor, 0));
+    vec2 coordinate = fragmentScreenCoordinate;
+
+    // bilinear samples at the pixel and one source texel around it
+    vec3 center = texture(sceneColor, coordinate).rgb;
+    vec3 north = texture(sceneColor, coordinate + vec2(0.0, texelSize.y)).rgb;
+    vec3 south = texture(sceneColor, coordinate - vec2(0.0, texelSize.y)).rgb;
+    vec3 east = texture(sceneColor, coordinate + vec2(texelSize.x, 0.0)).rgb;
+    vec3 west = texture(sceneColor, coordinate - vec2(texelSize.x, 0.0)).rgb;
+
+    // contrast adaptive sharpening - the negative lobe of the
+    // cross filter shrinks where the neighbourhood already spans
+    // most of the display range, so edges do not ring or clip
+    vec3 minColor = min(center, min(min(north, south), min(east, west)));
+    vec3 maxColor = max(center, max(max(north, south), max(east, west)));
+    vec3 amplitude = sqrt(clamp(min(minColor, 1.0 - maxColor) / max(maxColor, vec3(1.0e-5)), 0.0, 1.0));
+    vec3 weight = amplitude * (-1.0 / mix(8.0, 5.0, clamp(sharpness, 0.0, 1.0)));
+
+    vec3 result = (center + (north + south + east + west) * weight) / (1.0 + 4.0 * weight);
+    outFragmentColor = vec4(clamp(result, 0.0, 1.0), 1.0);
+}